@@ -1,3 +1,3 @@
-gcc -c ./src/data.c ./src/sc_engine.c ./src/sc_threads.c ./src/linalg.c ./src/ccbase/logs/log.c -mavx -mveclibabi=svml -O3 -lm
+gcc -c ./src/data.c ./src/sc_engine.c ./src/sc_threads.c ./src/linalg.c ./src/normalization.c ./src/conv.c ./src/sc_gemm.c ./src/permute.c ./src/sparse.c ./src/quant.c ./src/regression.c ./src/nn.c ./src/autodiff.c ./src/optim.c ./src/random.c ./src/factor.c ./src/geometry.c ./src/distance.c ./src/ann.c ./src/kmeans.c ./src/selection.c ./src/sort.c ./src/scan.c ./src/segment.c ./src/rolling.c ./src/ccbase/logs/log.c -mavx -mveclibabi=svml -O3 -lm
 ar rsv build/scandium.a ./*.o 
 del /S .\*.o
\ No newline at end of file
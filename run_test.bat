@@ -1,4 +1,4 @@
 gcc ./src/generate_tests.c ./src/ccbase/logs/log.c -o ./build/gen_test.exe -lm
 .\build\gen_test.exe
-gcc ./src/test.c ./src/data.c ./src/linalg.c ./src/ccbase/logs/log.c ./src/sc_engine.c ./src/sc_threads.c -mavx -ggdb -o ./build/test  -lm
+gcc ./src/test.c ./src/data.c ./src/linalg.c ./src/normalization.c ./src/conv.c ./src/sc_gemm.c ./src/permute.c ./src/sparse.c ./src/quant.c ./src/regression.c ./src/nn.c ./src/autodiff.c ./src/optim.c ./src/random.c ./src/factor.c ./src/geometry.c ./src/distance.c ./src/ann.c ./src/kmeans.c ./src/selection.c ./src/sort.c ./src/scan.c ./src/segment.c ./src/rolling.c ./src/ccbase/logs/log.c ./src/sc_engine.c ./src/sc_threads.c -mavx -ggdb -o ./build/test  -lm
 .\build\test.exe
\ No newline at end of file
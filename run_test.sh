@@ -1,5 +1,5 @@
 set -ex
 gcc ./src/generate_tests.c ./src/ccbase/logs/log.c -o ./build/gen_test -lm -I ./ccbase -I ./src
 ./build/gen_test
-gcc ./src/test.c ./src/data.c ./src/linalg.c ./src/ccbase/logs/log.c ./src/sc_engine.c ./src/sc_threads.c  -o ./build/test -mavx -lm -I ./ccbase -I ./src
+gcc ./src/test.c ./src/data.c ./src/linalg.c ./src/normalization.c ./src/conv.c ./src/sc_gemm.c ./src/permute.c ./src/sparse.c ./src/quant.c ./src/regression.c ./src/nn.c ./src/autodiff.c ./src/optim.c ./src/random.c ./src/factor.c ./src/geometry.c ./src/distance.c ./src/ann.c ./src/kmeans.c ./src/selection.c ./src/sort.c ./src/scan.c ./src/segment.c ./src/rolling.c ./src/ccbase/logs/log.c ./src/sc_engine.c ./src/sc_threads.c  -o ./build/test -mavx -lm -I ./ccbase -I ./src
 ./build/test
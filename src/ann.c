@@ -0,0 +1,1237 @@
+#include "data.h"
+#include "ann.h"
+#include "distance.h"
+#include "kmeans.h"
+#include "random.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+
+// rows of a conversion work unit
+#define ANN_CONVERT_ROWS 1024
+// queries of a search work unit
+#define ANN_QUERY_CHUNK 16
+// k-means training points per list and Lloyd iterations of the IVF coarse quantiser
+#define ANN_TRAIN_PER_LIST 256
+#define ANN_KMEANS_ITERATIONS 10
+// HNSW levels are stored in a byte
+#define ANN_MAX_LEVEL 15
+// HNSW batches: inserted nodes / ANN_BATCH_DIVISOR, at most ANN_MAX_BATCH
+#define ANN_BATCH_DIVISOR 16
+#define ANN_MAX_BATCH 4096
+// file format
+#define ANN_MAGIC "SCANNIDX"
+#define ANN_VERSION 1
+#define ANN_ALIGN 64
+#define ANN_SECTIONS 5
+#define ANN_KIND_IVF 1
+#define ANN_KIND_HNSW 2
+
+
+// #######################
+// distance kernels
+// #######################
+
+static float l2_scalar(const float* a, const float* b, uint64_t dim) {
+    float sum = 0.0f;
+    for (uint64_t p = 0; p < dim; p++) {
+        float d = a[p] - b[p];
+        sum += d * d;
+    }
+    return sum;
+}
+
+
+static float dot_scalar(const float* a, const float* b, uint64_t dim) {
+    float sum = 0.0f;
+    for (uint64_t p = 0; p < dim; p++) {
+        sum += a[p] * b[p];
+    }
+    return sum;
+}
+
+
+static SC_TARGET_AVX2 float l2_avx2(const float* a, const float* b, uint64_t dim) {
+    __m256 s0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps();
+    uint64_t p = 0;
+    for (; p + 16 <= dim; p += 16) {
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + p), _mm256_loadu_ps(b + p));
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + p + 8), _mm256_loadu_ps(b + p + 8));
+        s0 = _mm256_fmadd_ps(d0, d0, s0);
+        s1 = _mm256_fmadd_ps(d1, d1, s1);
+    }
+    for (; p + 8 <= dim; p += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + p), _mm256_loadu_ps(b + p));
+        s0 = _mm256_fmadd_ps(d, d, s0);
+    }
+    float sum = sc_hsum_f32x8(_mm256_add_ps(s0, s1));
+    for (; p < dim; p++) {
+        float d = a[p] - b[p];
+        sum += d * d;
+    }
+    return sum;
+}
+
+
+static SC_TARGET_AVX2 float dot_avx2(const float* a, const float* b, uint64_t dim) {
+    __m256 s0 = _mm256_setzero_ps();
+    __m256 s1 = _mm256_setzero_ps();
+    uint64_t p = 0;
+    for (; p + 16 <= dim; p += 16) {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + p), _mm256_loadu_ps(b + p), s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + p + 8), _mm256_loadu_ps(b + p + 8), s1);
+    }
+    for (; p + 8 <= dim; p += 8) {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + p), _mm256_loadu_ps(b + p), s0);
+    }
+    float sum = sc_hsum_f32x8(_mm256_add_ps(s0, s1));
+    for (; p < dim; p++) {
+        sum += a[p] * b[p];
+    }
+    return sum;
+}
+
+
+// the key of a pair is smaller for closer points: squared L2, 1 - cos on normalised points or - the inner product
+struct ann_space {
+    sc_metric metric;
+    uint64_t dim;
+    float (*l2)(const float* a, const float* b, uint64_t dim);
+    float (*dot)(const float* a, const float* b, uint64_t dim);
+};
+
+
+static struct ann_space make_space(sc_metric metric, uint64_t dim) {
+    struct ann_space space;
+    space.metric = metric;
+    space.dim = dim;
+    int avx2 = sc_has_avx2_fma();
+    space.l2 = avx2 ? l2_avx2 : l2_scalar;
+    space.dot = avx2 ? dot_avx2 : dot_scalar;
+    return space;
+}
+
+
+static inline float space_key(const struct ann_space* space, const float* a, const float* b) {
+    switch (space->metric) {
+        case sc_metric_cosine: return 1.0f - space->dot(a, b, space->dim);
+        case sc_metric_inner_product: return -space->dot(a, b, space->dim);
+        default: return space->l2(a, b, space->dim);
+    }
+}
+
+
+static float key_to_distance(sc_metric metric, float key) {
+    switch (metric) {
+        case sc_metric_euclidean: return sqrtf(key > 0.0f ? key : 0.0f);
+        case sc_metric_inner_product: return -key;
+        default: return key;
+    }
+}
+
+
+// ######################
+// (key, id) binary heaps
+// ######################
+
+typedef struct {
+    float key;
+    uint64_t id;
+} ann_pair;
+
+
+static inline int worse(ann_pair a, ann_pair b) {
+    return a.key > b.key || (a.key == b.key && a.id > b.id);
+}
+
+
+// max heaps keep the worst pair at the root, min heaps the best
+static inline int before(ann_pair a, ann_pair b, int max) {
+    return max ? worse(a, b) : worse(b, a);
+}
+
+
+static void heap_push(ann_pair* heap, uint64_t* count, ann_pair item, int max) {
+    uint64_t i = (*count)++;
+    heap[i] = item;
+    while (i > 0) {
+        uint64_t parent = (i - 1) / 2;
+        if (!before(heap[i], heap[parent], max)) {
+            break;
+        }
+        ann_pair swap = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = swap;
+        i = parent;
+    }
+}
+
+
+static void heap_sift_down(ann_pair* heap, uint64_t count, uint64_t i, int max) {
+    for (;;) {
+        uint64_t top = i;
+        uint64_t l = 2 * i + 1;
+        uint64_t r = l + 1;
+        if (l < count && before(heap[l], heap[top], max)) top = l;
+        if (r < count && before(heap[r], heap[top], max)) top = r;
+        if (top == i) {
+            return;
+        }
+        ann_pair swap = heap[i];
+        heap[i] = heap[top];
+        heap[top] = swap;
+        i = top;
+    }
+}
+
+
+static ann_pair heap_pop(ann_pair* heap, uint64_t* count, int max) {
+    ann_pair top = heap[0];
+    heap[0] = heap[--(*count)];
+    heap_sift_down(heap, *count, 0, max);
+    return top;
+}
+
+
+// keeps the capacity best pairs in a max heap
+static inline void bounded_push(ann_pair* heap, uint64_t* count, uint64_t capacity, ann_pair item) {
+    if (*count < capacity) {
+        heap_push(heap, count, item, 1);
+    } else if (worse(heap[0], item)) {
+        heap[0] = item;
+        heap_sift_down(heap, capacity, 0, 1);
+    }
+}
+
+
+// max heap sorted in place, best first
+static void heap_sort(ann_pair* heap, uint64_t count) {
+    for (uint64_t n = count; n > 1; n--) {
+        ann_pair swap = heap[0];
+        heap[0] = heap[n - 1];
+        heap[n - 1] = swap;
+        heap_sift_down(heap, n - 1, 0, 1);
+    }
+}
+
+
+static void write_results(sc_metric metric, const ann_pair* sorted, uint64_t found, uint64_t k, uint64_t* indices,
+                          float* distances) {
+    for (uint64_t j = 0; j < k; j++) {
+        indices[j] = (j < found) ? sorted[j].id : UINT64_MAX;
+        distances[j] = (j < found) ? key_to_distance(metric, sorted[j].key) : INFINITY;
+    }
+}
+
+
+// #####################
+// points and queries
+// #####################
+
+struct convert_args {
+    sc_tensor* points;
+    float* out;
+    int normalize;
+};
+
+
+static int convert_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct convert_args* args = (struct convert_args*)raw;
+    uint64_t n = args->points->dims->dims[0];
+    uint64_t dim = args->points->dims->dims[1];
+    uint64_t size = sc_type_size(args->points->type);
+    uint64_t first = start * ANN_CONVERT_ROWS;
+    uint64_t last = (end * ANN_CONVERT_ROWS < n) ? end * ANN_CONVERT_ROWS : n;
+    for (uint64_t i = first; i < last; i++) {
+        float* row = args->out + i * dim;
+        sc_convert_buffer((const uint8_t*)args->points->data + i * dim * size, args->points->type, row, sc_float32, dim);
+        if (args->normalize) {
+            double norm2 = 0.0;
+            for (uint64_t p = 0; p < dim; p++) {
+                norm2 += (double)row[p] * row[p];
+            }
+            float scale = (norm2 > 0.0) ? (float)(1.0 / sqrt(norm2)) : 0.0f;
+            for (uint64_t p = 0; p < dim; p++) {
+                row[p] *= scale;
+            }
+        }
+    }
+    return 0;
+}
+
+
+static int check_points(sc_tensor* points, uint64_t dim, const char* name) {
+    CCB_NOTNULL(points, "%s is NULL", name);
+    if (points->type != sc_float16 && points->type != sc_float32 && points->type != sc_float64) {
+        CCB_ERROR("%s must be bfloat16, float32 or float64, got type %d", name, points->type);
+        return -1;
+    }
+    if (points->dims->dims_count != 2 || points->dims->dims[0] == 0 || (dim != 0 && points->dims->dims[1] != dim)) {
+        CCB_ERROR("%s must be a non empty [n, %" PRIu64 "] tensor", name, dim);
+        return -1;
+    }
+    return 0;
+}
+
+
+// float32 copy of the rows, normalised for the cosine metric
+static float* convert_points(sc_tensor* points, sc_metric metric, ccb_arena* arena) {
+    uint64_t n = points->dims->dims[0];
+    float* out = (float*)ccb_arena_malloc(arena, points->size * sizeof(float));
+    CCB_NOTNULL(out, "Failed to allocate float32 points");
+    struct convert_args args = {points, out, metric == sc_metric_cosine};
+    uint64_t chunks = (n + ANN_CONVERT_ROWS - 1) / ANN_CONVERT_ROWS;
+    if (sc_run_range_task(convert_kernel, &args, chunks, points->size, arena) != 0) {
+        CCB_ERROR("Failed to convert points");
+        return NULL;
+    }
+    return out;
+}
+
+
+static int check_metric(sc_metric metric) {
+    if (metric != sc_metric_sqeuclidean && metric != sc_metric_euclidean && metric != sc_metric_cosine &&
+        metric != sc_metric_inner_product) {
+        CCB_ERROR("Unknown metric %d", metric);
+        return -1;
+    }
+    return 0;
+}
+
+
+// output buffers of a search: the distances go to a scratch buffer when not requested
+static float* search_distances(sc_tensor* distances, uint64_t nq, uint64_t k, ccb_arena* arena) {
+    if (distances == NULL) {
+        float* out = (float*)ccb_arena_malloc(arena, nq * k * sizeof(float));
+        CCB_NOTNULL(out, "Failed to allocate distances");
+        return out;
+    }
+    if (distances->type != sc_float32 || distances->size != nq * k) {
+        CCB_ERROR("distances must have %" PRIu64 " x %" PRIu64 " float32 elements", nq, k);
+        return NULL;
+    }
+    return (float*)distances->data;
+}
+
+
+static uint32_t draw(uint64_t seed, uint64_t index, uint32_t stream) {
+    uint32_t counter[4] = {(uint32_t)index, (uint32_t)(index >> 32), stream, 0};
+    uint32_t key[2] = {(uint32_t)seed, (uint32_t)(seed >> 32)};
+    uint32_t words[4];
+    sc_philox4x32(counter, key, words);
+    return words[0];
+}
+
+
+// ###########
+// IVF flat
+// ###########
+
+static sc_point_set* point_set_view(float* data, uint64_t rows, uint64_t dim, ccb_arena* arena) {
+    uint64_t dims[] = {rows, dim};
+    sc_tensor* tensor = (sc_tensor*)ccb_arena_malloc(arena, sizeof(sc_tensor));
+    CCB_NOTNULL(tensor, "Failed to allocate tensor view");
+    tensor->data = data;
+    tensor->dims = sc_create_dimensions(2, arena, dims);
+    tensor->size = rows * dim;
+    tensor->type = sc_float32;
+    return sc_point_set_create(tensor, arena);
+}
+
+
+/*
+    k-means of the kmeans module on a jittered stride sample of the points (ANN_TRAIN_PER_LIST per list)
+*/
+static int coarse_kmeans(const float* vectors, uint64_t n, uint64_t dim, uint64_t nlist, uint64_t seed, float* centroids,
+                         ccb_arena* arena) {
+    uint64_t samples = (n / ANN_TRAIN_PER_LIST < nlist) ? n : nlist * ANN_TRAIN_PER_LIST;
+    uint64_t dims[] = {samples, dim};
+    sc_tensor* train = sc_create_tensor(sc_create_dimensions(2, arena, dims), sc_float32, arena);
+    CCB_NOTNULL(train, "Failed to allocate k-means sample");
+    for (uint64_t j = 0; j < samples; j++) {
+        uint64_t lo = j * n / samples;
+        uint64_t hi = (j + 1) * n / samples;
+        uint64_t row = lo + draw(seed, j, 0) % (hi - lo);
+        memcpy((float*)train->data + j * dim, vectors + row * dim, dim * sizeof(float));
+    }
+    sc_kmeans_options options = sc_kmeans_default_options(nlist);
+    options.max_iterations = ANN_KMEANS_ITERATIONS;
+    options.seed = seed;
+    sc_kmeans_model* model = sc_kmeans_fit(train, &options, NULL, arena);
+    if (model == NULL) {
+        return -1;
+    }
+    memcpy(centroids, model->centroids->data, nlist * dim * sizeof(float));
+    return 0;
+}
+
+
+sc_ivf_index* sc_ivf_build(sc_tensor* points, sc_metric metric, uint64_t nlist, uint64_t seed, ccb_arena* arena) {
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (check_points(points, 0, "points") != 0 || check_metric(metric) != 0) {
+        return NULL;
+    }
+    uint64_t n = points->dims->dims[0];
+    uint64_t dim = points->dims->dims[1];
+    if (nlist == 0 || nlist > n) {
+        CCB_ERROR("nlist must be in [1, %" PRIu64 "], got %" PRIu64, n, nlist);
+        return NULL;
+    }
+    float* vectors = convert_points(points, metric, arena);
+    if (vectors == NULL) {
+        return NULL;
+    }
+
+    sc_ivf_index* index = (sc_ivf_index*)ccb_arena_malloc(arena, sizeof(sc_ivf_index));
+    CCB_NOTNULL(index, "Failed to allocate IVF index");
+    index->metric = metric;
+    index->count = n;
+    index->dim = dim;
+    index->nlist = nlist;
+    index->centroids = (float*)ccb_arena_malloc(arena, nlist * dim * sizeof(float));
+    index->offsets = (uint64_t*)ccb_arena_malloc(arena, (nlist + 1) * sizeof(uint64_t));
+    index->vectors = (float*)ccb_arena_malloc(arena, n * dim * sizeof(float));
+    index->ids = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    index->mapping = NULL;
+    index->mapping_size = 0;
+    uint64_t* assign = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    if (index->centroids == NULL || index->offsets == NULL || index->vectors == NULL || index->ids == NULL || assign == NULL) {
+        CCB_ERROR("Failed to allocate IVF lists");
+        return NULL;
+    }
+    if (coarse_kmeans(vectors, n, dim, nlist, seed, index->centroids, arena) != 0) {
+        CCB_ERROR("Failed to train the IVF coarse quantiser");
+        return NULL;
+    }
+    if (metric == sc_metric_cosine) {
+        for (uint64_t c = 0; c < nlist; c++) {
+            float* centroid = index->centroids + c * dim;
+            float norm = sqrtf(dot_scalar(centroid, centroid, dim));
+            for (uint64_t p = 0; p < dim && norm > 0.0f; p++) {
+                centroid[p] /= norm;
+            }
+        }
+    }
+
+    // every point goes to the list the searches probe first for it
+    sc_point_set* point_set = point_set_view(vectors, n, dim, arena);
+    sc_point_set* centroid_set = point_set_view(index->centroids, nlist, dim, arena);
+    if (point_set == NULL || centroid_set == NULL || sc_pairwise_topk(point_set, centroid_set, metric, 1, assign, NULL, arena) != 0) {
+        CCB_ERROR("Failed to assign the points to the IVF lists");
+        return NULL;
+    }
+    memset(index->offsets, 0, (nlist + 1) * sizeof(uint64_t));
+    for (uint64_t i = 0; i < n; i++) {
+        index->offsets[assign[i] + 1]++;
+    }
+    for (uint64_t c = 0; c < nlist; c++) {
+        index->offsets[c + 1] += index->offsets[c];
+    }
+    uint64_t* cursor = (uint64_t*)ccb_arena_malloc(arena, nlist * sizeof(uint64_t));
+    CCB_NOTNULL(cursor, "Failed to allocate IVF cursors");
+    memcpy(cursor, index->offsets, nlist * sizeof(uint64_t));
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t slot = cursor[assign[i]]++;
+        memcpy(index->vectors + slot * dim, vectors + i * dim, dim * sizeof(float));
+        index->ids[slot] = i;
+    }
+    return index;
+}
+
+
+struct ivf_search_args {
+    const sc_ivf_index* index;
+    struct ann_space space;
+    const float* queries;
+    uint64_t count;
+    uint64_t k;
+    uint64_t nprobe;
+    uint64_t* indices;
+    float* distances;
+    ann_pair* probes;       // per thread [nprobe]
+    ann_pair* results;      // per thread [k]
+};
+
+
+static int ivf_search_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct ivf_search_args* args = (struct ivf_search_args*)raw;
+    const sc_ivf_index* index = args->index;
+    uint64_t dim = index->dim;
+    ann_pair* probes = args->probes + thread_id * args->nprobe;
+    ann_pair* results = args->results + thread_id * args->k;
+    uint64_t first = start * ANN_QUERY_CHUNK;
+    uint64_t last = (end * ANN_QUERY_CHUNK < args->count) ? end * ANN_QUERY_CHUNK : args->count;
+
+    for (uint64_t q = first; q < last; q++) {
+        const float* x = args->queries + q * dim;
+        uint64_t probe_count = 0;
+        for (uint64_t c = 0; c < index->nlist; c++) {
+            ann_pair pair = {space_key(&args->space, x, index->centroids + c * dim), c};
+            bounded_push(probes, &probe_count, args->nprobe, pair);
+        }
+        heap_sort(probes, probe_count);
+
+        uint64_t found = 0;
+        for (uint64_t p = 0; p < probe_count; p++) {
+            uint64_t list = probes[p].id;
+            for (uint64_t r = index->offsets[list]; r < index->offsets[list + 1]; r++) {
+                ann_pair pair = {space_key(&args->space, x, index->vectors + r * dim), index->ids[r]};
+                bounded_push(results, &found, args->k, pair);
+            }
+        }
+        heap_sort(results, found);
+        write_results(index->metric, results, found, args->k, args->indices + q * args->k, args->distances + q * args->k);
+    }
+    return 0;
+}
+
+
+int sc_ivf_search(sc_ivf_index* index, sc_tensor* queries, uint64_t k, uint64_t nprobe, uint64_t* indices,
+                  sc_tensor* distances, ccb_arena* arena) {
+    CCB_NOTNULL(index, "index is NULL");
+    CCB_NOTNULL(indices, "indices is NULL");
+    if (check_points(queries, index->dim, "queries") != 0) {
+        return -1;
+    }
+    if (k == 0 || nprobe == 0) {
+        CCB_ERROR("k and nprobe must be positive");
+        return -1;
+    }
+    uint64_t nq = queries->dims->dims[0];
+    float* out = search_distances(distances, nq, k, arena);
+    float* x = convert_points(queries, index->metric, arena);
+    if (out == NULL || x == NULL) {
+        return -1;
+    }
+
+    uint64_t threads = sc_get_engine_thread_count();
+    struct ivf_search_args args;
+    args.index = index;
+    args.space = make_space(index->metric, index->dim);
+    args.queries = x;
+    args.count = nq;
+    args.k = k;
+    args.nprobe = (nprobe < index->nlist) ? nprobe : index->nlist;
+    args.indices = indices;
+    args.distances = out;
+    args.probes = (ann_pair*)ccb_arena_malloc(arena, threads * args.nprobe * sizeof(ann_pair));
+    args.results = (ann_pair*)ccb_arena_malloc(arena, threads * k * sizeof(ann_pair));
+    if (args.probes == NULL || args.results == NULL) {
+        CCB_ERROR("Failed to allocate IVF search buffers");
+        return -1;
+    }
+    uint64_t chunks = (nq + ANN_QUERY_CHUNK - 1) / ANN_QUERY_CHUNK;
+    uint64_t work = nq * index->dim * (index->nlist + args.nprobe * index->count / index->nlist);
+    if (sc_run_range_task(ivf_search_kernel, &args, chunks, work, arena) != 0) {
+        CCB_ERROR("Failed to run IVF search");
+        return -1;
+    }
+    return 0;
+}
+
+
+// #####
+// HNSW
+// #####
+
+static inline uint32_t* node_links(const sc_hnsw_index* index, uint32_t node, uint32_t level) {
+    if (level == 0) {
+        return index->links + (uint64_t)node * (2 * index->m + 1);
+    }
+    return index->upper_links + index->upper_offsets[node] + (uint64_t)(level - 1) * (index->m + 1);
+}
+
+
+static inline uint32_t max_links(const sc_hnsw_index* index, uint32_t level) {
+    return (level == 0) ? 2 * index->m : index->m;
+}
+
+
+// per thread search state: visit stamps (reset when the epoch wraps) and the two heaps of the best first search
+struct hnsw_workspace {
+    uint32_t* stamps;
+    uint32_t epoch;
+    ann_pair* candidates;   // min heap, [2 ef + 2 m]
+    ann_pair* results;      // max heap, [ef]
+};
+
+
+static void next_epoch(struct hnsw_workspace* ws, uint64_t count) {
+    if (++ws->epoch == 0) {
+        memset(ws->stamps, 0, count * sizeof(uint32_t));
+        ws->epoch = 1;
+    }
+}
+
+
+// greedy walk to the closest node of a level
+static uint32_t greedy_closest(const sc_hnsw_index* index, const struct ann_space* space, const float* x, uint32_t node,
+                               float* key, uint32_t level) {
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        const uint32_t* links = node_links(index, node, level);
+        for (uint32_t j = 1; j <= links[0]; j++) {
+            float candidate = space_key(space, x, index->vectors + (uint64_t)links[j] * index->dim);
+            if (candidate < *key || (candidate == *key && links[j] < node)) {
+                *key = candidate;
+                node = links[j];
+                changed = 1;
+            }
+        }
+    }
+    return node;
+}
+
+
+/*
+    best first search of width ef on a level from one entry node, the results are left in ws->results (max heap)
+    the candidates only matter while they are better than the worst result, so when their heap fills up the
+    ones that are not are dropped (at most ef remain)
+*/
+static uint64_t search_level(const sc_hnsw_index* index, const struct ann_space* space, const float* x, ann_pair entry,
+                             uint64_t ef, uint32_t level, struct hnsw_workspace* ws) {
+    uint64_t capacity = 2 * ef + 2 * (uint64_t)index->m;
+    uint64_t candidate_count = 0;
+    uint64_t found = 0;
+    next_epoch(ws, index->count);
+    ws->stamps[entry.id] = ws->epoch;
+    heap_push(ws->candidates, &candidate_count, entry, 0);
+    heap_push(ws->results, &found, entry, 1);
+
+    while (candidate_count > 0) {
+        ann_pair current = heap_pop(ws->candidates, &candidate_count, 0);
+        if (found == ef && worse(current, ws->results[0])) {
+            break;
+        }
+        const uint32_t* links = node_links(index, (uint32_t)current.id, level);
+        for (uint32_t j = 1; j <= links[0]; j++) {
+            uint32_t node = links[j];
+            if (ws->stamps[node] == ws->epoch) {
+                continue;
+            }
+            ws->stamps[node] = ws->epoch;
+            ann_pair pair = {space_key(space, x, index->vectors + (uint64_t)node * index->dim), node};
+            if (found == ef && !worse(ws->results[0], pair)) {
+                continue;
+            }
+            bounded_push(ws->results, &found, ef, pair);
+            if (candidate_count == capacity) {
+                uint64_t kept = 0;
+                for (uint64_t c = 0; c < candidate_count; c++) {
+                    if (!worse(ws->candidates[c], ws->results[0])) {
+                        ws->candidates[kept++] = ws->candidates[c];
+                    }
+                }
+                candidate_count = kept;
+                for (uint64_t c = candidate_count / 2; c-- > 0;) {
+                    heap_sift_down(ws->candidates, candidate_count, c, 0);
+                }
+            }
+            heap_push(ws->candidates, &candidate_count, pair, 0);
+        }
+    }
+    return found;
+}
+
+
+/*
+    neighbour selection heuristic: a candidate (sorted best first, keys relative to the base node) is kept when
+    it is closer to the base than to every kept neighbour
+*/
+static uint32_t select_neighbours(const sc_hnsw_index* index, const struct ann_space* space, const ann_pair* sorted,
+                                  uint64_t count, uint32_t limit, uint32_t* out) {
+    uint32_t kept = 0;
+    for (uint64_t c = 0; c < count && kept < limit; c++) {
+        const float* candidate = index->vectors + sorted[c].id * index->dim;
+        int good = 1;
+        for (uint32_t s = 0; s < kept && good; s++) {
+            good = space_key(space, candidate, index->vectors + (uint64_t)out[s] * index->dim) >= sorted[c].key;
+        }
+        if (good) {
+            out[kept++] = (uint32_t)sorted[c].id;
+        }
+    }
+    return kept;
+}
+
+
+struct hnsw_build_args {
+    sc_hnsw_index* index;
+    struct ann_space space;
+    uint32_t first;                 // first node of the batch
+    uint32_t* pending;              // [batch, ANN_MAX_LEVEL + 1, m] selected neighbours
+    uint32_t* pending_counts;       // [batch, ANN_MAX_LEVEL + 1]
+    struct hnsw_workspace* workspaces;
+};
+
+
+static int hnsw_insert_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct hnsw_build_args* args = (struct hnsw_build_args*)raw;
+    sc_hnsw_index* index = args->index;
+    struct hnsw_workspace* ws = args->workspaces + thread_id;
+
+    for (uint64_t b = start; b < end; b++) {
+        uint32_t node = args->first + (uint32_t)b;
+        const float* x = index->vectors + (uint64_t)node * index->dim;
+        uint32_t level = index->levels[node];
+        uint32_t* counts = args->pending_counts + b * (ANN_MAX_LEVEL + 1);
+        memset(counts, 0, (ANN_MAX_LEVEL + 1) * sizeof(uint32_t));
+
+        uint32_t entry = index->entry;
+        float key = space_key(&args->space, x, index->vectors + (uint64_t)entry * index->dim);
+        for (uint32_t l = index->max_level; l > level; l--) {
+            entry = greedy_closest(index, &args->space, x, entry, &key, l);
+        }
+        for (uint32_t l = (level < index->max_level) ? level : index->max_level; ; l--) {
+            ann_pair start_pair = {key, entry};
+            uint64_t found = search_level(index, &args->space, x, start_pair, index->ef_construction, l, ws);
+            heap_sort(ws->results, found);
+            uint32_t* out = args->pending + (b * (ANN_MAX_LEVEL + 1) + l) * index->m;
+            counts[l] = select_neighbours(index, &args->space, ws->results, found, index->m, out);
+            entry = (uint32_t)ws->results[0].id;
+            key = ws->results[0].key;
+            if (l == 0) {
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+
+// adds the reverse link node -> target, a full list is reduced with the selection heuristic
+static void add_link(sc_hnsw_index* index, const struct ann_space* space, uint32_t node, uint32_t target, uint32_t level,
+                     ann_pair* scratch) {
+    uint32_t* links = node_links(index, node, level);
+    uint32_t limit = max_links(index, level);
+    if (links[0] < limit) {
+        links[++links[0]] = target;
+        return;
+    }
+    const float* base = index->vectors + (uint64_t)node * index->dim;
+    uint64_t count = 0;
+    for (uint32_t j = 1; j <= links[0]; j++) {
+        ann_pair pair = {space_key(space, base, index->vectors + (uint64_t)links[j] * index->dim), links[j]};
+        heap_push(scratch, &count, pair, 1);
+    }
+    ann_pair pair = {space_key(space, base, index->vectors + (uint64_t)target * index->dim), target};
+    heap_push(scratch, &count, pair, 1);
+    heap_sort(scratch, count);
+    links[0] = select_neighbours(index, space, scratch, count, limit, links + 1);
+}
+
+
+sc_hnsw_index* sc_hnsw_build(sc_tensor* points, sc_metric metric, uint32_t m, uint32_t ef_construction, uint64_t seed,
+                             ccb_arena* arena) {
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (check_points(points, 0, "points") != 0 || check_metric(metric) != 0) {
+        return NULL;
+    }
+    uint64_t n = points->dims->dims[0];
+    uint64_t dim = points->dims->dims[1];
+    if (n >= UINT32_MAX || m < 2 || m > 255 || ef_construction < m) {
+        CCB_ERROR("HNSW needs less than 2^32 - 1 points, m in [2, 255] and ef_construction >= m");
+        return NULL;
+    }
+
+    sc_hnsw_index* index = (sc_hnsw_index*)ccb_arena_malloc(arena, sizeof(sc_hnsw_index));
+    CCB_NOTNULL(index, "Failed to allocate HNSW index");
+    index->metric = metric;
+    index->count = n;
+    index->dim = dim;
+    index->m = m;
+    index->ef_construction = ef_construction;
+    index->mapping = NULL;
+    index->mapping_size = 0;
+    index->vectors = convert_points(points, metric, arena);
+    index->levels = (uint8_t*)ccb_arena_malloc(arena, n);
+    index->links = (uint32_t*)ccb_arena_malloc(arena, n * (2 * m + 1) * sizeof(uint32_t));
+    index->upper_offsets = (uint64_t*)ccb_arena_malloc(arena, (n + 1) * sizeof(uint64_t));
+    if (index->vectors == NULL || index->levels == NULL || index->links == NULL || index->upper_offsets == NULL) {
+        CCB_ERROR("Failed to allocate HNSW nodes");
+        return NULL;
+    }
+
+    // levels drawn from the geometric law of ratio 1 / m, the upper lists are packed after each other
+    double scale = 1.0 / log((double)m);
+    index->upper_offsets[0] = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        double u = ((double)(draw(seed, i, 0) >> 8) + 1.0) / 16777216.0;
+        double level = floor(-log(u) * scale);
+        index->levels[i] = (uint8_t)((level < ANN_MAX_LEVEL) ? level : ANN_MAX_LEVEL);
+        index->upper_offsets[i + 1] = index->upper_offsets[i] + (uint64_t)index->levels[i] * (m + 1);
+    }
+    index->upper_links = (uint32_t*)ccb_arena_malloc(arena, (index->upper_offsets[n] + 1) * sizeof(uint32_t));
+    CCB_NOTNULL(index->upper_links, "Failed to allocate HNSW upper links");
+    for (uint64_t i = 0; i < n; i++) {
+        for (uint32_t l = 0; l <= index->levels[i]; l++) {
+            node_links(index, (uint32_t)i, l)[0] = 0;
+        }
+    }
+    index->entry = 0;
+    index->max_level = index->levels[0];
+
+    uint64_t threads = sc_get_engine_thread_count();
+    struct hnsw_build_args args;
+    args.index = index;
+    args.space = make_space(metric, dim);
+    args.pending = (uint32_t*)ccb_arena_malloc(arena, (uint64_t)ANN_MAX_BATCH * (ANN_MAX_LEVEL + 1) * m * sizeof(uint32_t));
+    args.pending_counts = (uint32_t*)ccb_arena_malloc(arena, (uint64_t)ANN_MAX_BATCH * (ANN_MAX_LEVEL + 1) * sizeof(uint32_t));
+    args.workspaces = (struct hnsw_workspace*)ccb_arena_malloc(arena, threads * sizeof(struct hnsw_workspace));
+    ann_pair* scratch = (ann_pair*)ccb_arena_malloc(arena, (2 * m + 1) * sizeof(ann_pair));
+    if (args.pending == NULL || args.pending_counts == NULL || args.workspaces == NULL || scratch == NULL) {
+        CCB_ERROR("Failed to allocate HNSW build buffers");
+        return NULL;
+    }
+    for (uint64_t t = 0; t < threads; t++) {
+        args.workspaces[t].stamps = (uint32_t*)ccb_arena_malloc(arena, n * sizeof(uint32_t));
+        args.workspaces[t].candidates = (ann_pair*)ccb_arena_malloc(arena, (2 * ef_construction + 2 * m) * sizeof(ann_pair));
+        args.workspaces[t].results = (ann_pair*)ccb_arena_malloc(arena, ef_construction * sizeof(ann_pair));
+        CCB_NOTNULL(args.workspaces[t].results, "Failed to allocate HNSW workspaces");
+        memset(args.workspaces[t].stamps, 0, n * sizeof(uint32_t));
+        args.workspaces[t].epoch = 0;
+    }
+
+    // batches grow with the graph so that the nodes searched together see a graph close to the sequential one
+    uint64_t inserted = 1;
+    while (inserted < n) {
+        uint64_t batch = inserted / ANN_BATCH_DIVISOR;
+        batch = (batch < 1) ? 1 : ((batch > ANN_MAX_BATCH) ? ANN_MAX_BATCH : batch);
+        batch = (batch < n - inserted) ? batch : n - inserted;
+        args.first = (uint32_t)inserted;
+        if (sc_run_range_task(hnsw_insert_kernel, &args, batch, batch * ef_construction * m * dim, arena) != 0) {
+            CCB_ERROR("Failed to run HNSW insertions");
+            return NULL;
+        }
+        for (uint64_t b = 0; b < batch; b++) {
+            uint32_t node = (uint32_t)(inserted + b);
+            uint32_t top = (index->levels[node] < index->max_level) ? index->levels[node] : index->max_level;
+            for (uint32_t l = 0; l <= top; l++) {
+                uint32_t count = args.pending_counts[b * (ANN_MAX_LEVEL + 1) + l];
+                const uint32_t* selected = args.pending + (b * (ANN_MAX_LEVEL + 1) + l) * m;
+                uint32_t* links = node_links(index, node, l);
+                links[0] = count;
+                memcpy(links + 1, selected, count * sizeof(uint32_t));
+                for (uint32_t j = 0; j < count; j++) {
+                    add_link(index, &args.space, selected[j], node, l, scratch);
+                }
+            }
+            if (index->levels[node] > index->max_level) {
+                index->max_level = index->levels[node];
+                index->entry = node;
+            }
+        }
+        inserted += batch;
+    }
+    return index;
+}
+
+
+struct hnsw_search_args {
+    const sc_hnsw_index* index;
+    struct ann_space space;
+    const float* queries;
+    uint64_t count;
+    uint64_t k;
+    uint64_t ef;
+    uint64_t* indices;
+    float* distances;
+    struct hnsw_workspace* workspaces;
+};
+
+
+static int hnsw_search_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct hnsw_search_args* args = (struct hnsw_search_args*)raw;
+    const sc_hnsw_index* index = args->index;
+    struct hnsw_workspace* ws = args->workspaces + thread_id;
+    uint64_t first = start * ANN_QUERY_CHUNK;
+    uint64_t last = (end * ANN_QUERY_CHUNK < args->count) ? end * ANN_QUERY_CHUNK : args->count;
+
+    for (uint64_t q = first; q < last; q++) {
+        const float* x = args->queries + q * index->dim;
+        uint32_t entry = index->entry;
+        float key = space_key(&args->space, x, index->vectors + (uint64_t)entry * index->dim);
+        for (uint32_t l = index->max_level; l > 0; l--) {
+            entry = greedy_closest(index, &args->space, x, entry, &key, l);
+        }
+        ann_pair start_pair = {key, entry};
+        uint64_t found = search_level(index, &args->space, x, start_pair, args->ef, 0, ws);
+        heap_sort(ws->results, found);
+        write_results(index->metric, ws->results, (found < args->k) ? found : args->k, args->k, args->indices + q * args->k,
+                      args->distances + q * args->k);
+    }
+    return 0;
+}
+
+
+int sc_hnsw_search(sc_hnsw_index* index, sc_tensor* queries, uint64_t k, uint64_t ef, uint64_t* indices,
+                   sc_tensor* distances, ccb_arena* arena) {
+    CCB_NOTNULL(index, "index is NULL");
+    CCB_NOTNULL(indices, "indices is NULL");
+    if (check_points(queries, index->dim, "queries") != 0) {
+        return -1;
+    }
+    if (k == 0) {
+        CCB_ERROR("k must be positive");
+        return -1;
+    }
+    ef = (ef > k) ? ef : k;
+    uint64_t nq = queries->dims->dims[0];
+    float* out = search_distances(distances, nq, k, arena);
+    float* x = convert_points(queries, index->metric, arena);
+    if (out == NULL || x == NULL) {
+        return -1;
+    }
+
+    uint64_t threads = sc_get_engine_thread_count();
+    struct hnsw_search_args args;
+    args.index = index;
+    args.space = make_space(index->metric, index->dim);
+    args.queries = x;
+    args.count = nq;
+    args.k = k;
+    args.ef = ef;
+    args.indices = indices;
+    args.distances = out;
+    args.workspaces = (struct hnsw_workspace*)ccb_arena_malloc(arena, threads * sizeof(struct hnsw_workspace));
+    CCB_NOTNULL(args.workspaces, "Failed to allocate HNSW workspaces");
+    for (uint64_t t = 0; t < threads; t++) {
+        args.workspaces[t].stamps = (uint32_t*)ccb_arena_malloc(arena, index->count * sizeof(uint32_t));
+        args.workspaces[t].candidates = (ann_pair*)ccb_arena_malloc(arena, (2 * ef + 2 * index->m) * sizeof(ann_pair));
+        args.workspaces[t].results = (ann_pair*)ccb_arena_malloc(arena, ef * sizeof(ann_pair));
+        CCB_NOTNULL(args.workspaces[t].results, "Failed to allocate HNSW workspaces");
+        memset(args.workspaces[t].stamps, 0, index->count * sizeof(uint32_t));
+        args.workspaces[t].epoch = 0;
+    }
+    uint64_t chunks = (nq + ANN_QUERY_CHUNK - 1) / ANN_QUERY_CHUNK;
+    if (sc_run_range_task(hnsw_search_kernel, &args, chunks, nq * ef * index->m * index->dim, arena) != 0) {
+        CCB_ERROR("Failed to run HNSW search");
+        return -1;
+    }
+    return 0;
+}
+
+
+// ############
+// index files
+// ############
+
+/*
+    a 64 bytes aligned header followed by the arrays of the index, each one 64 bytes aligned, so that a mapped
+    file is used in place
+*/
+struct ann_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t metric;
+    uint32_t m;
+    uint32_t ef_construction;
+    uint32_t max_level;
+    uint32_t entry;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t dim;
+    uint64_t nlist;
+    uint64_t offsets[ANN_SECTIONS];
+    uint64_t sizes[ANN_SECTIONS];
+};
+
+
+static uint64_t align_up(uint64_t value) {
+    return (value + ANN_ALIGN - 1) / ANN_ALIGN * ANN_ALIGN;
+}
+
+
+static int write_index(const char* path, struct ann_header* header, const void* const* sections) {
+    CCB_NOTNULL(path, "path is NULL");
+    memcpy(header->magic, ANN_MAGIC, 8);
+    header->version = ANN_VERSION;
+    uint64_t offset = align_up(sizeof(struct ann_header));
+    for (int s = 0; s < ANN_SECTIONS; s++) {
+        header->offsets[s] = offset;
+        offset = align_up(offset + header->sizes[s]);
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        CCB_ERROR("Failed to open %s", path);
+        return -1;
+    }
+    static const char padding[ANN_ALIGN] = {0};
+    uint64_t written = sizeof(struct ann_header);
+    int ok = fwrite(header, sizeof(struct ann_header), 1, file) == 1;
+    for (int s = 0; s < ANN_SECTIONS && ok; s++) {
+        ok = fwrite(padding, 1, header->offsets[s] - written, file) == header->offsets[s] - written;
+        ok = ok && (header->sizes[s] == 0 || fwrite(sections[s], 1, header->sizes[s], file) == header->sizes[s]);
+        written = header->offsets[s] + header->sizes[s];
+    }
+    ok = (fclose(file) == 0) && ok;
+    if (!ok) {
+        CCB_ERROR("Failed to write %s", path);
+        return -1;
+    }
+    return 0;
+}
+
+
+// maps a whole file read only, NULL if it cannot be opened or is smaller than min_size
+static void* map_file(const char* path, uint64_t min_size, uint64_t* size) {
+    #ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            CCB_ERROR("Failed to open %s", path);
+            return NULL;
+        }
+        LARGE_INTEGER info;
+        if (!GetFileSizeEx(file, &info) || (uint64_t)info.QuadPart < min_size) {
+            CCB_ERROR("%s is not an index file", path);
+            CloseHandle(file);
+            return NULL;
+        }
+        // the view keeps the mapping object and the file alive once their handles are closed
+        HANDLE object = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        void* mapping = (object != NULL) ? MapViewOfFile(object, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (object != NULL) {
+            CloseHandle(object);
+        }
+        CloseHandle(file);
+        if (mapping == NULL) {
+            CCB_ERROR("Failed to map %s", path);
+            return NULL;
+        }
+        *size = (uint64_t)info.QuadPart;
+        return mapping;
+    #else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            CCB_ERROR("Failed to open %s", path);
+            return NULL;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (uint64_t)info.st_size < min_size) {
+            CCB_ERROR("%s is not an index file", path);
+            close(fd);
+            return NULL;
+        }
+        void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            CCB_ERROR("Failed to map %s", path);
+            return NULL;
+        }
+        *size = (uint64_t)info.st_size;
+        return mapping;
+    #endif
+}
+
+
+static void unmap_file(void* mapping, uint64_t size) {
+    #ifdef _WIN32
+        (void)size;
+        UnmapViewOfFile(mapping);
+    #else
+        munmap(mapping, (size_t)size);
+    #endif
+}
+
+
+// a * b in *product, 0 when it does not fit in 64 bits
+static int checked_mul(uint64_t a, uint64_t b, uint64_t* product) {
+    if (a != 0 && b > UINT64_MAX / a) {
+        return 0;
+    }
+    *product = a * b;
+    return 1;
+}
+
+
+// sizes of the sections of sc_ivf_save and sc_hnsw_save implied by the header, the last HNSW section depends
+// on the content of the offsets and is checked once the sections are known to be in the file
+static int header_sizes(const struct ann_header* header, uint32_t kind, uint64_t* sizes) {
+    int ok = header->dim != 0 && header->count < UINT64_MAX;
+    uint64_t row = 0;
+    uint64_t vectors = 0;
+    ok = ok && checked_mul(header->dim, sizeof(float), &row) && checked_mul(header->count, row, &vectors);
+    if (kind == ANN_KIND_IVF) {
+        ok = ok && header->nlist != 0 && header->nlist < UINT64_MAX;
+        ok = ok && checked_mul(header->nlist, row, &sizes[0]);
+        sizes[2] = vectors;
+        ok = ok && checked_mul(header->nlist + 1, sizeof(uint64_t), &sizes[1]);
+        ok = ok && checked_mul(header->count, sizeof(uint64_t), &sizes[3]);
+        sizes[4] = 0;
+    } else {
+        ok = ok && header->m != 0 && header->m < UINT32_MAX / 2 && header->max_level <= ANN_MAX_LEVEL;
+        ok = ok && (header->count == 0 || header->entry < header->count);
+        sizes[0] = vectors;
+        sizes[1] = header->count;
+        ok = ok && checked_mul(header->count, (2 * (uint64_t)header->m + 1) * sizeof(uint32_t), &sizes[2]);
+        ok = ok && checked_mul(header->count + 1, sizeof(uint64_t), &sizes[3]);
+        sizes[4] = header->sizes[4];
+    }
+    return ok;
+}
+
+
+// maps a file and checks its header, the section pointers are written in sections
+static struct ann_header* map_index(const char* path, uint32_t kind, void** sections, uint64_t* mapping_size) {
+    CCB_NOTNULL(path, "path is NULL");
+    uint64_t size = 0;
+    void* mapping = map_file(path, sizeof(struct ann_header), &size);
+    if (mapping == NULL) {
+        return NULL;
+    }
+    struct ann_header* header = (struct ann_header*)mapping;
+    uint64_t expected[ANN_SECTIONS];
+    int valid = memcmp(header->magic, ANN_MAGIC, 8) == 0 && header->version == ANN_VERSION && header->kind == kind;
+    valid = valid && header_sizes(header, kind, expected);
+    for (int s = 0; s < ANN_SECTIONS && valid; s++) {
+        // aligned, after the header and inside the file without wrapping around
+        valid = header->sizes[s] == expected[s] && header->offsets[s] % ANN_ALIGN == 0;
+        valid = valid && header->offsets[s] >= sizeof(struct ann_header);
+        valid = valid && header->sizes[s] <= size && header->offsets[s] <= size - header->sizes[s];
+        sections[s] = (uint8_t*)mapping + header->offsets[s];
+    }
+    // the last list ends at count, the upper links fill their section
+    if (valid && kind == ANN_KIND_IVF) {
+        valid = ((uint64_t*)sections[1])[header->nlist] == header->count;
+    } else if (valid) {
+        uint64_t upper = 0;
+        valid = checked_mul(((uint64_t*)sections[3])[header->count], sizeof(uint32_t), &upper) && upper == header->sizes[4];
+    }
+    if (!valid) {
+        CCB_ERROR("%s is not a valid %s index file", path, (kind == ANN_KIND_IVF) ? "IVF" : "HNSW");
+        unmap_file(mapping, size);
+        return NULL;
+    }
+    *mapping_size = size;
+    return header;
+}
+
+
+int sc_ivf_save(sc_ivf_index* index, const char* path) {
+    CCB_NOTNULL(index, "index is NULL");
+    struct ann_header header;
+    memset(&header, 0, sizeof(header));
+    header.kind = ANN_KIND_IVF;
+    header.metric = (uint32_t)index->metric;
+    header.count = index->count;
+    header.dim = index->dim;
+    header.nlist = index->nlist;
+    const void* sections[ANN_SECTIONS] = {index->centroids, index->offsets, index->vectors, index->ids, NULL};
+    header.sizes[0] = index->nlist * index->dim * sizeof(float);
+    header.sizes[1] = (index->nlist + 1) * sizeof(uint64_t);
+    header.sizes[2] = index->count * index->dim * sizeof(float);
+    header.sizes[3] = index->count * sizeof(uint64_t);
+    return write_index(path, &header, sections);
+}
+
+
+sc_ivf_index* sc_ivf_load(const char* path, ccb_arena* arena) {
+    CCB_NOTNULL(arena, "arena is NULL");
+    void* sections[ANN_SECTIONS];
+    uint64_t size;
+    struct ann_header* header = map_index(path, ANN_KIND_IVF, sections, &size);
+    if (header == NULL) {
+        return NULL;
+    }
+    sc_ivf_index* index = (sc_ivf_index*)ccb_arena_malloc(arena, sizeof(sc_ivf_index));
+    CCB_NOTNULL(index, "Failed to allocate IVF index");
+    index->metric = (sc_metric)header->metric;
+    index->count = header->count;
+    index->dim = header->dim;
+    index->nlist = header->nlist;
+    index->centroids = (float*)sections[0];
+    index->offsets = (uint64_t*)sections[1];
+    index->vectors = (float*)sections[2];
+    index->ids = (uint64_t*)sections[3];
+    index->mapping = header;
+    index->mapping_size = size;
+    return index;
+}
+
+
+void sc_ivf_close(sc_ivf_index* index) {
+    if (index != NULL && index->mapping != NULL) {
+        unmap_file(index->mapping, index->mapping_size);
+        index->mapping = NULL;
+    }
+}
+
+
+int sc_hnsw_save(sc_hnsw_index* index, const char* path) {
+    CCB_NOTNULL(index, "index is NULL");
+    struct ann_header header;
+    memset(&header, 0, sizeof(header));
+    header.kind = ANN_KIND_HNSW;
+    header.metric = (uint32_t)index->metric;
+    header.m = index->m;
+    header.ef_construction = index->ef_construction;
+    header.max_level = index->max_level;
+    header.entry = index->entry;
+    header.count = index->count;
+    header.dim = index->dim;
+    const void* sections[ANN_SECTIONS] = {index->vectors, index->levels, index->links, index->upper_offsets, index->upper_links};
+    header.sizes[0] = index->count * index->dim * sizeof(float);
+    header.sizes[1] = index->count;
+    header.sizes[2] = index->count * (2 * index->m + 1) * sizeof(uint32_t);
+    header.sizes[3] = (index->count + 1) * sizeof(uint64_t);
+    header.sizes[4] = index->upper_offsets[index->count] * sizeof(uint32_t);
+    return write_index(path, &header, sections);
+}
+
+
+sc_hnsw_index* sc_hnsw_load(const char* path, ccb_arena* arena) {
+    CCB_NOTNULL(arena, "arena is NULL");
+    void* sections[ANN_SECTIONS];
+    uint64_t size;
+    struct ann_header* header = map_index(path, ANN_KIND_HNSW, sections, &size);
+    if (header == NULL) {
+        return NULL;
+    }
+    sc_hnsw_index* index = (sc_hnsw_index*)ccb_arena_malloc(arena, sizeof(sc_hnsw_index));
+    CCB_NOTNULL(index, "Failed to allocate HNSW index");
+    index->metric = (sc_metric)header->metric;
+    index->count = header->count;
+    index->dim = header->dim;
+    index->m = header->m;
+    index->ef_construction = header->ef_construction;
+    index->max_level = header->max_level;
+    index->entry = header->entry;
+    index->vectors = (float*)sections[0];
+    index->levels = (uint8_t*)sections[1];
+    index->links = (uint32_t*)sections[2];
+    index->upper_offsets = (uint64_t*)sections[3];
+    index->upper_links = (uint32_t*)sections[4];
+    index->mapping = header;
+    index->mapping_size = size;
+    return index;
+}
+
+
+void sc_hnsw_close(sc_hnsw_index* index) {
+    if (index != NULL && index->mapping != NULL) {
+        unmap_file(index->mapping, index->mapping_size);
+        index->mapping = NULL;
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef __ANN_H__
+#define __ANN_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+#include "distance.h"
+
+/*
+    approximate nearest neighbour indexes over [n, dim] point tensors, the points are copied in float32
+    - IVF flat: the points are grouped in nlist inverted lists around k-means centroids, a query scans the
+      nprobe lists of its nearest centroids
+    - HNSW: hierarchical small world graph, a query descends the upper levels greedily and runs a best first
+      search of width ef on level 0
+    cosine indexes store normalised points, sc_metric_inner_product searches the largest inner products
+    build and search run on the engine thread pool, the results do not depend on the thread count
+    (HNSW inserts the points in batches: the searches of a batch run in parallel, the links are made in order)
+    the indexes live in the arena, sc_*_save writes them in a file that sc_*_load maps read only
+*/
+
+typedef struct {
+    sc_metric metric;
+    uint64_t count;
+    uint64_t dim;
+    uint64_t nlist;
+    float* centroids;           // [nlist, dim]
+    uint64_t* offsets;          // [nlist + 1], list l is [offsets[l], offsets[l + 1]) of vectors and ids
+    float* vectors;             // [count, dim] grouped by list
+    uint64_t* ids;              // [count] row of the points of every stored vector
+    void* mapping;              // file mapping of a loaded index, NULL for a built one
+    uint64_t mapping_size;
+} sc_ivf_index;
+
+typedef struct {
+    sc_metric metric;
+    uint64_t count;
+    uint64_t dim;
+    uint32_t m;                 // links per node on the upper levels, 2 m on level 0
+    uint32_t ef_construction;
+    uint32_t max_level;
+    uint32_t entry;             // node on max_level where the searches start
+    float* vectors;             // [count, dim]
+    uint8_t* levels;            // [count] top level of every node
+    uint32_t* links;            // [count, 2 m + 1] level 0: link count then the links
+    uint64_t* upper_offsets;    // [count + 1] level l >= 1 of node i is at upper_offsets[i] + (l - 1) (m + 1) in upper_links
+    uint32_t* upper_links;
+    void* mapping;
+    uint64_t mapping_size;
+} sc_hnsw_index;
+
+
+/* Builds an IVF flat index
+   - sc_tensor* points: [n, dim] bfloat16, float32 or float64 points
+   - uint64_t nlist: number of lists (k-means centroids), 1 to n
+   - uint64_t seed: seed of the k-means sampling
+   - ccb_arena* arena: arena where the index will be allocated
+   - return: a pointer to the index, NULL on error
+*/
+sc_ivf_index* sc_ivf_build(sc_tensor* points, sc_metric metric, uint64_t nlist, uint64_t seed, ccb_arena* arena);
+/* k approximate nearest neighbours of every query
+   - sc_tensor* queries: [q, dim] points of a type accepted by the build
+   - uint64_t nprobe: lists scanned per query, nlist gives the exact result
+   - uint64_t* indices: [q, k] rows of the indexed points, best first, UINT64_MAX when less than k points were scanned
+   - sc_tensor* distances: [q, k] float32 values of the metric (INFINITY for the missing ones), can be NULL
+   - return: 0 on success
+*/
+int sc_ivf_search(sc_ivf_index* index, sc_tensor* queries, uint64_t k, uint64_t nprobe, uint64_t* indices,
+                  sc_tensor* distances, ccb_arena* arena);
+/* Writes the index in a file, return: 0 on success */
+int sc_ivf_save(sc_ivf_index* index, const char* path);
+/* Maps an index written by sc_ivf_save, the index is read only, NULL on error */
+sc_ivf_index* sc_ivf_load(const char* path, ccb_arena* arena);
+/* Unmaps a loaded index (nothing for a built one) */
+void sc_ivf_close(sc_ivf_index* index);
+
+/* Builds an HNSW graph
+   - uint32_t m: links per node (16 is usual), 2 to 255
+   - uint32_t ef_construction: width of the build searches, at least m
+   - return: a pointer to the index, NULL on error (at most 2^32 - 1 points)
+*/
+sc_hnsw_index* sc_hnsw_build(sc_tensor* points, sc_metric metric, uint32_t m, uint32_t ef_construction, uint64_t seed,
+                             ccb_arena* arena);
+/* k approximate nearest neighbours of every query, uint64_t ef: width of the level 0 search (at least k), see sc_ivf_search */
+int sc_hnsw_search(sc_hnsw_index* index, sc_tensor* queries, uint64_t k, uint64_t ef, uint64_t* indices,
+                   sc_tensor* distances, ccb_arena* arena);
+int sc_hnsw_save(sc_hnsw_index* index, const char* path);
+sc_hnsw_index* sc_hnsw_load(const char* path, ccb_arena* arena);
+void sc_hnsw_close(sc_hnsw_index* index);
+
+
+#endif // __ANN_H__
@@ -0,0 +1,903 @@
+#include "data.h"
+#include "autodiff.h"
+#include "normalization.h"
+#include "sc_engine.h"
+#include "sc_gemm.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+// elements of an element wise work unit
+#define AD_CHUNK 4096
+// per thread scalar sums are padded to a cache line (in doubles)
+#define AD_LINE 8
+
+
+struct ad_args {
+    sc_TYPES type;
+    sc_ad_op op;
+    uint64_t size;          // elements
+    uint64_t cols;          // row length (bias, softmax, cross entropy)
+    double scalar;
+
+    const void* a;
+    const void* b;
+    const void* y;
+    const void* dy;
+    void* out;
+    void* da;
+    void* db;
+    int acc_a;              // add to da / db instead of overwriting them
+    int acc_b;
+
+    double* partials;       // per thread sums
+    const int64_t* labels;
+    void* cache;
+};
+
+
+#define AD_SET(dst, i, acc, value) ((dst)[i] = (acc) ? (dst)[i] + (value) : (value))
+
+// the kernels of the ops, instantiated for float and double
+#define AD_KERNELS(SUFFIX, T, EXP, LOG, TANH)                                                                   \
+static void forward_##SUFFIX(const struct ad_args* args, uint64_t start, uint64_t end, double* sum) {          \
+    const T* a = (const T*)args->a;                                                                            \
+    const T* b = (const T*)args->b;                                                                            \
+    T* y = (T*)args->out;                                                                                      \
+    T s = (T)args->scalar;                                                                                     \
+    switch (args->op) {                                                                                        \
+        case sc_ad_op_add: for (uint64_t i = start; i < end; i++) y[i] = a[i] + b[i]; break;                      \
+        case sc_ad_op_sub: for (uint64_t i = start; i < end; i++) y[i] = a[i] - b[i]; break;                      \
+        case sc_ad_op_mul: for (uint64_t i = start; i < end; i++) y[i] = a[i] * b[i]; break;                      \
+        case sc_ad_op_div: for (uint64_t i = start; i < end; i++) y[i] = a[i] / b[i]; break;                      \
+        case sc_ad_op_scale: for (uint64_t i = start; i < end; i++) y[i] = s * a[i]; break;                       \
+        case sc_ad_op_exp: for (uint64_t i = start; i < end; i++) y[i] = EXP(a[i]); break;                        \
+        case sc_ad_op_log: for (uint64_t i = start; i < end; i++) y[i] = LOG(a[i]); break;                        \
+        case sc_ad_op_tanh: for (uint64_t i = start; i < end; i++) y[i] = TANH(a[i]); break;                      \
+        case sc_ad_op_sigmoid: for (uint64_t i = start; i < end; i++) y[i] = (T)1 / ((T)1 + EXP(-a[i])); break;   \
+        case sc_ad_op_relu: for (uint64_t i = start; i < end; i++) y[i] = (a[i] > (T)0) ? a[i] : (T)0; break;     \
+        case sc_ad_op_add_bias: {                                                                                 \
+            uint64_t j = start % args->cols;                                                                   \
+            for (uint64_t i = start; i < end; i++) {                                                           \
+                y[i] = a[i] + b[j];                                                                            \
+                j = (j + 1 == args->cols) ? 0 : j + 1;                                                         \
+            }                                                                                                  \
+            break;                                                                                             \
+        }                                                                                                      \
+        case sc_ad_op_sum:                                                                                        \
+        case sc_ad_op_mean: {                                                                                     \
+            double acc = 0.0;                                                                                  \
+            for (uint64_t i = start; i < end; i++) acc += a[i];                                                \
+            *sum += acc;                                                                                       \
+            break;                                                                                             \
+        }                                                                                                      \
+        default:                                                                                               \
+            break;                                                                                             \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static void backward_##SUFFIX(const struct ad_args* args, uint64_t start, uint64_t end, double* sums) {        \
+    const T* a = (const T*)args->a;                                                                            \
+    const T* b = (const T*)args->b;                                                                            \
+    const T* y = (const T*)args->y;                                                                            \
+    const T* dy = (const T*)args->dy;                                                                          \
+    T* da = (T*)args->da;                                                                                      \
+    T* db = (T*)args->db;                                                                                      \
+    int acc_a = args->acc_a;                                                                                   \
+    int acc_b = args->acc_b;                                                                                   \
+    T s = (T)args->scalar;                                                                                     \
+    switch (args->op) {                                                                                        \
+        case sc_ad_op_add:                                                                                        \
+        case sc_ad_op_sub:                                                                                        \
+            for (uint64_t i = start; i < end; i++) {                                                           \
+                if (da != NULL) AD_SET(da, i, acc_a, dy[i]);                                                   \
+                if (db != NULL) AD_SET(db, i, acc_b, (args->op == sc_ad_op_sub) ? -dy[i] : dy[i]);                \
+            }                                                                                                  \
+            break;                                                                                             \
+        case sc_ad_op_mul:                                                                                        \
+            for (uint64_t i = start; i < end; i++) {                                                           \
+                T g = dy[i];                                                                                   \
+                if (da != NULL) AD_SET(da, i, acc_a, g * b[i]);                                                \
+                if (db != NULL) AD_SET(db, i, acc_b, g * a[i]);                                                \
+            }                                                                                                  \
+            break;                                                                                             \
+        case sc_ad_op_div:                                                                                        \
+            for (uint64_t i = start; i < end; i++) {                                                           \
+                T g = dy[i] / b[i];                                                                            \
+                if (da != NULL) AD_SET(da, i, acc_a, g);                                                       \
+                if (db != NULL) AD_SET(db, i, acc_b, -g * a[i] / b[i]);                                        \
+            }                                                                                                  \
+            break;                                                                                             \
+        case sc_ad_op_scale: for (uint64_t i = start; i < end; i++) AD_SET(da, i, acc_a, s * dy[i]); break;       \
+        case sc_ad_op_exp: for (uint64_t i = start; i < end; i++) AD_SET(da, i, acc_a, dy[i] * y[i]); break;      \
+        case sc_ad_op_log: for (uint64_t i = start; i < end; i++) AD_SET(da, i, acc_a, dy[i] / a[i]); break;      \
+        case sc_ad_op_tanh: for (uint64_t i = start; i < end; i++) AD_SET(da, i, acc_a, dy[i] * ((T)1 - y[i] * y[i])); break; \
+        case sc_ad_op_sigmoid: for (uint64_t i = start; i < end; i++) AD_SET(da, i, acc_a, dy[i] * y[i] * ((T)1 - y[i])); break; \
+        case sc_ad_op_relu: for (uint64_t i = start; i < end; i++) AD_SET(da, i, acc_a, (y[i] > (T)0) ? dy[i] : (T)0); break; \
+        case sc_ad_op_add_bias: {                                                                                 \
+            uint64_t j = start % args->cols;                                                                   \
+            for (uint64_t i = start; i < end; i++) {                                                           \
+                if (da != NULL) AD_SET(da, i, acc_a, dy[i]);                                                   \
+                sums[j] += dy[i];                                                                              \
+                j = (j + 1 == args->cols) ? 0 : j + 1;                                                         \
+            }                                                                                                  \
+            break;                                                                                             \
+        }                                                                                                      \
+        case sc_ad_op_sum:                                                                                        \
+        case sc_ad_op_mean:                                                                                       \
+            for (uint64_t i = start; i < end; i++) AD_SET(da, i, acc_a, s);                                    \
+            break;                                                                                             \
+        default:                                                                                               \
+            break;                                                                                             \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static void softmax_forward_##SUFFIX(const T* x, T* y, uint64_t cols) {                                        \
+    T largest = x[0];                                                                                          \
+    for (uint64_t j = 1; j < cols; j++) largest = (x[j] > largest) ? x[j] : largest;                           \
+    T total = (T)0;                                                                                            \
+    for (uint64_t j = 0; j < cols; j++) {                                                                      \
+        y[j] = EXP(x[j] - largest);                                                                            \
+        total += y[j];                                                                                         \
+    }                                                                                                          \
+    T inv = (T)1 / total;                                                                                      \
+    for (uint64_t j = 0; j < cols; j++) y[j] *= inv;                                                           \
+}                                                                                                              \
+                                                                                                               \
+static void softmax_backward_##SUFFIX(const T* y, const T* dy, T* dx, int acc, uint64_t cols) {                \
+    T dot = (T)0;                                                                                              \
+    for (uint64_t j = 0; j < cols; j++) dot += dy[j] * y[j];                                                   \
+    for (uint64_t j = 0; j < cols; j++) AD_SET(dx, j, acc, y[j] * (dy[j] - dot));                              \
+}                                                                                                              \
+                                                                                                               \
+static double cross_entropy_forward_##SUFFIX(const T* x, int64_t label, T* p, uint64_t cols) {                 \
+    T largest = x[0];                                                                                          \
+    for (uint64_t j = 1; j < cols; j++) largest = (x[j] > largest) ? x[j] : largest;                           \
+    T total = (T)0;                                                                                            \
+    for (uint64_t j = 0; j < cols; j++) {                                                                      \
+        p[j] = EXP(x[j] - largest);                                                                            \
+        total += p[j];                                                                                         \
+    }                                                                                                          \
+    T inv = (T)1 / total;                                                                                      \
+    for (uint64_t j = 0; j < cols; j++) p[j] *= inv;                                                           \
+    return (double)LOG(total) + (double)largest - (double)x[label];                                            \
+}                                                                                                              \
+                                                                                                               \
+static void cross_entropy_backward_##SUFFIX(const T* p, int64_t label, T scale, T* dx, int acc, uint64_t cols) { \
+    for (uint64_t j = 0; j < cols; j++) AD_SET(dx, j, acc, scale * (p[j] - (((int64_t)j == label) ? (T)1 : (T)0))); \
+}
+
+AD_KERNELS(f32, float, expf, logf, tanhf)
+AD_KERNELS(f64, double, exp, log, tanh)
+
+
+static int ew_forward_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct ad_args* args = (struct ad_args*)raw;
+    uint64_t first = start * AD_CHUNK;
+    uint64_t last = (end * AD_CHUNK < args->size) ? end * AD_CHUNK : args->size;
+    double* sum = (args->partials != NULL) ? args->partials + thread_id * AD_LINE : NULL;
+    if (args->type == sc_float64) {
+        forward_f64(args, first, last, sum);
+    } else {
+        forward_f32(args, first, last, sum);
+    }
+    return 0;
+}
+
+
+static int ew_backward_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct ad_args* args = (struct ad_args*)raw;
+    uint64_t first = start * AD_CHUNK;
+    uint64_t last = (end * AD_CHUNK < args->size) ? end * AD_CHUNK : args->size;
+    double* sums = (args->partials != NULL) ? args->partials + thread_id * args->cols : NULL;
+    if (args->type == sc_float64) {
+        backward_f64(args, first, last, sums);
+    } else {
+        backward_f32(args, first, last, sums);
+    }
+    return 0;
+}
+
+
+static int softmax_forward_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct ad_args* args = (struct ad_args*)raw;
+    uint64_t n = args->cols;
+    for (uint64_t r = start; r < end; r++) {
+        if (args->type == sc_float64) {
+            softmax_forward_f64((const double*)args->a + r * n, (double*)args->out + r * n, n);
+        } else {
+            softmax_forward_f32((const float*)args->a + r * n, (float*)args->out + r * n, n);
+        }
+    }
+    return 0;
+}
+
+
+static int softmax_backward_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct ad_args* args = (struct ad_args*)raw;
+    uint64_t n = args->cols;
+    for (uint64_t r = start; r < end; r++) {
+        if (args->type == sc_float64) {
+            softmax_backward_f64((const double*)args->y + r * n, (const double*)args->dy + r * n, (double*)args->da + r * n, args->acc_a, n);
+        } else {
+            softmax_backward_f32((const float*)args->y + r * n, (const float*)args->dy + r * n, (float*)args->da + r * n, args->acc_a, n);
+        }
+    }
+    return 0;
+}
+
+
+static int cross_entropy_forward_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct ad_args* args = (struct ad_args*)raw;
+    uint64_t n = args->cols;
+    double loss = 0.0;
+    for (uint64_t r = start; r < end; r++) {
+        if (args->type == sc_float64) {
+            loss += cross_entropy_forward_f64((const double*)args->a + r * n, args->labels[r], (double*)args->cache + r * n, n);
+        } else {
+            loss += cross_entropy_forward_f32((const float*)args->a + r * n, args->labels[r], (float*)args->cache + r * n, n);
+        }
+    }
+    args->partials[thread_id * AD_LINE] += loss;
+    return 0;
+}
+
+
+static int cross_entropy_backward_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct ad_args* args = (struct ad_args*)raw;
+    uint64_t n = args->cols;
+    for (uint64_t r = start; r < end; r++) {
+        if (args->type == sc_float64) {
+            cross_entropy_backward_f64((const double*)args->cache + r * n, args->labels[r], args->scalar, (double*)args->da + r * n, args->acc_a, n);
+        } else {
+            cross_entropy_backward_f32((const float*)args->cache + r * n, args->labels[r], (float)args->scalar, (float*)args->da + r * n, args->acc_a, n);
+        }
+    }
+    return 0;
+}
+
+
+// ####
+// tape
+// ####
+
+sc_tape* sc_tape_create(ccb_arena* arena) {
+    CCB_NOTNULL(arena, "arena is NULL");
+    sc_tape* tape = (sc_tape*)ccb_arena_malloc(arena, sizeof(sc_tape));
+    CCB_NOTNULL(tape, "Failed to allocate tape");
+    memset(tape, 0, sizeof(sc_tape));
+    tape->arena = arena;
+    return tape;
+}
+
+
+static uint64_t byte_size(const sc_tensor* tensor) {
+    return tensor->size * sc_type_size(tensor->type);
+}
+
+
+// a buffer of the pool with the same size, or a new one from the arena
+static void* acquire(sc_tape* tape, uint64_t bytes) {
+    for (uint64_t i = 0; i < tape->pool_count; i++) {
+        if (tape->pool_sizes[i] == bytes) {
+            void* buffer = tape->pool[i];
+            tape->pool_count--;
+            tape->pool[i] = tape->pool[tape->pool_count];
+            tape->pool_sizes[i] = tape->pool_sizes[tape->pool_count];
+            return buffer;
+        }
+    }
+    return ccb_arena_malloc(tape->arena, bytes);
+}
+
+
+static void release(sc_tape* tape, void* buffer, uint64_t bytes) {
+    if (tape->pool_count == tape->pool_capacity) {
+        uint64_t capacity = (tape->pool_capacity == 0) ? 32 : 2 * tape->pool_capacity;
+        void** pool = (void**)ccb_arena_malloc(tape->arena, capacity * sizeof(void*));
+        uint64_t* sizes = (uint64_t*)ccb_arena_malloc(tape->arena, capacity * sizeof(uint64_t));
+        if (pool == NULL || sizes == NULL) {
+            return;
+        }
+        if (tape->pool_count > 0) {
+            memcpy(pool, tape->pool, tape->pool_count * sizeof(void*));
+            memcpy(sizes, tape->pool_sizes, tape->pool_count * sizeof(uint64_t));
+        }
+        tape->pool = pool;
+        tape->pool_sizes = sizes;
+        tape->pool_capacity = capacity;
+    }
+    tape->pool[tape->pool_count] = buffer;
+    tape->pool_sizes[tape->pool_count] = bytes;
+    tape->pool_count++;
+}
+
+
+static int check_var(sc_tape* tape, sc_var* var) {
+    CCB_NOTNULL(tape, "tape is NULL");
+    if (var == NULL) {
+        CCB_ERROR("Variable is NULL");
+        return -1;
+    }
+    if (var->value->type != sc_float32 && var->value->type != sc_float64) {
+        CCB_ERROR("Automatic differentiation needs float32 or float64 values, got type %d", var->value->type);
+        return -1;
+    }
+    return 0;
+}
+
+
+static int check_same_shape(sc_var* a, sc_var* b) {
+    if (a->value->type != b->value->type || a->value->dims->dims_count != b->value->dims->dims_count) {
+        CCB_ERROR("Operands of different types or ranks");
+        return -1;
+    }
+    for (uint64_t d = 0; d < a->value->dims->dims_count; d++) {
+        if (a->value->dims->dims[d] != b->value->dims->dims[d]) {
+            CCB_ERROR("Operands of different shapes (dimension %" PRIu64 ": %" PRIu64 " and %" PRIu64 ")", d, a->value->dims->dims[d], b->value->dims->dims[d]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+static uint64_t last_dim(const sc_tensor* tensor) {
+    return tensor->dims->dims[tensor->dims->dims_count - 1];
+}
+
+
+// records a node whose value has the given dimensions (cloned)
+static sc_var* record(sc_tape* tape, sc_ad_op op, sc_var* a, sc_var* b, sc_var* c, sc_dimensions* dims, sc_TYPES type) {
+    if (tape->count == tape->capacity) {
+        uint64_t capacity = (tape->capacity == 0) ? 64 : 2 * tape->capacity;
+        sc_var** nodes = (sc_var**)ccb_arena_malloc(tape->arena, capacity * sizeof(sc_var*));
+        CCB_NOTNULL(nodes, "Failed to allocate tape nodes");
+        if (tape->count > 0) {
+            memcpy(nodes, tape->nodes, tape->count * sizeof(sc_var*));
+        }
+        tape->nodes = nodes;
+        tape->capacity = capacity;
+    }
+
+    sc_var* node = (sc_var*)ccb_arena_malloc(tape->arena, sizeof(sc_var));
+    CCB_NOTNULL(node, "Failed to allocate tape node");
+    memset(node, 0, sizeof(sc_var));
+    node->op = op;
+    node->inputs[0] = a;
+    node->inputs[1] = b;
+    node->inputs[2] = c;
+    node->requires_grad = (a != NULL && a->requires_grad) || (b != NULL && b->requires_grad) || (c != NULL && c->requires_grad);
+    node->index = tape->count;
+    if (dims != NULL) {
+        node->value = sc_create_tensor(sc_clone_dimensions(dims, tape->arena), type, tape->arena);
+        CCB_NOTNULL(node->value, "Failed to allocate node value");
+    }
+    tape->nodes[tape->count++] = node;
+    return node;
+}
+
+
+static void save(sc_var* node, sc_var* var) {
+    if (node->requires_grad && var != NULL) {
+        var->saved = 1;
+    }
+}
+
+
+static int run_chunks(int (*func)(void*, uint64_t, uint64_t, uint64_t), struct ad_args* args, sc_tape* tape) {
+    uint64_t chunks = (args->size + AD_CHUNK - 1) / AD_CHUNK;
+    if (chunks == 0) {
+        return 0;
+    }
+    if (sc_run_range_task(func, args, chunks, args->size, tape->arena) != 0) {
+        CCB_ERROR("Failed to run autodiff task");
+        return -1;
+    }
+    return 0;
+}
+
+
+static int run_rows(int (*func)(void*, uint64_t, uint64_t, uint64_t), struct ad_args* args, uint64_t rows, sc_tape* tape) {
+    if (rows == 0) {
+        return 0;
+    }
+    if (sc_run_range_task(func, args, rows, rows * args->cols, tape->arena) != 0) {
+        CCB_ERROR("Failed to run autodiff task");
+        return -1;
+    }
+    return 0;
+}
+
+
+static double* create_partials(sc_tape* tape, uint64_t stride) {
+    uint64_t bytes = sc_get_engine_thread_count() * stride * sizeof(double);
+    double* partials = (double*)acquire(tape, bytes);
+    CCB_NOTNULL(partials, "Failed to allocate partial sums");
+    memset(partials, 0, bytes);
+    return partials;
+}
+
+
+static double sum_partials(const double* partials, uint64_t stride, uint64_t offset) {
+    double total = 0.0;
+    for (uint64_t t = 0; t < sc_get_engine_thread_count(); t++) {
+        total += partials[t * stride + offset];
+    }
+    return total;
+}
+
+
+static void set_scalar(sc_tensor* tensor, double value) {
+    if (tensor->type == sc_float64) {
+        ((double*)tensor->data)[0] = value;
+    } else {
+        ((float*)tensor->data)[0] = (float)value;
+    }
+}
+
+
+static double get_scalar(const sc_tensor* tensor) {
+    return (tensor->type == sc_float64) ? ((double*)tensor->data)[0] : (double)((float*)tensor->data)[0];
+}
+
+
+// ###
+// ops
+// ###
+
+sc_var* sc_ad_leaf(sc_tape* tape, sc_tensor* value, int requires_grad) {
+    CCB_NOTNULL(tape, "tape is NULL");
+    CCB_NOTNULL(value, "value is NULL");
+    if (value->type != sc_float32 && value->type != sc_float64) {
+        CCB_ERROR("Automatic differentiation needs float32 or float64 values, got type %d", value->type);
+        return NULL;
+    }
+    sc_var* node = record(tape, sc_ad_op_leaf, NULL, NULL, NULL, NULL, value->type);
+    if (node == NULL) {
+        return NULL;
+    }
+    node->value = value;
+    node->requires_grad = requires_grad != 0;
+    return node;
+}
+
+
+static sc_var* element_wise(sc_tape* tape, sc_ad_op op, sc_var* a, sc_var* b, double scalar) {
+    if (check_var(tape, a) != 0 || (b != NULL && (check_var(tape, b) != 0 || check_same_shape(a, b) != 0))) {
+        return NULL;
+    }
+    sc_var* node = record(tape, op, a, b, NULL, a->value->dims, a->value->type);
+    if (node == NULL) {
+        return NULL;
+    }
+    node->scalar = scalar;
+
+    // inputs and output read by the backward step
+    if (op == sc_ad_op_mul || op == sc_ad_op_div) {
+        save(node, a);
+        save(node, b);
+    } else if (op == sc_ad_op_log) {
+        save(node, a);
+    } else if (op == sc_ad_op_exp || op == sc_ad_op_tanh || op == sc_ad_op_sigmoid || op == sc_ad_op_relu) {
+        save(node, node);
+    }
+
+    struct ad_args args = {0};
+    args.type = a->value->type;
+    args.op = op;
+    args.size = a->value->size;
+    args.scalar = scalar;
+    args.a = a->value->data;
+    args.b = (b != NULL) ? b->value->data : NULL;
+    args.out = node->value->data;
+    return (run_chunks(ew_forward_kernel, &args, tape) == 0) ? node : NULL;
+}
+
+
+sc_var* sc_ad_add(sc_tape* tape, sc_var* a, sc_var* b) { return element_wise(tape, sc_ad_op_add, a, b, 0.0); }
+sc_var* sc_ad_sub(sc_tape* tape, sc_var* a, sc_var* b) { return element_wise(tape, sc_ad_op_sub, a, b, 0.0); }
+sc_var* sc_ad_mul(sc_tape* tape, sc_var* a, sc_var* b) { return element_wise(tape, sc_ad_op_mul, a, b, 0.0); }
+sc_var* sc_ad_div(sc_tape* tape, sc_var* a, sc_var* b) { return element_wise(tape, sc_ad_op_div, a, b, 0.0); }
+sc_var* sc_ad_scale(sc_tape* tape, sc_var* a, double scale) { return element_wise(tape, sc_ad_op_scale, a, NULL, scale); }
+sc_var* sc_ad_exp(sc_tape* tape, sc_var* a) { return element_wise(tape, sc_ad_op_exp, a, NULL, 0.0); }
+sc_var* sc_ad_log(sc_tape* tape, sc_var* a) { return element_wise(tape, sc_ad_op_log, a, NULL, 0.0); }
+sc_var* sc_ad_tanh(sc_tape* tape, sc_var* a) { return element_wise(tape, sc_ad_op_tanh, a, NULL, 0.0); }
+sc_var* sc_ad_sigmoid(sc_tape* tape, sc_var* a) { return element_wise(tape, sc_ad_op_sigmoid, a, NULL, 0.0); }
+sc_var* sc_ad_relu(sc_tape* tape, sc_var* a) { return element_wise(tape, sc_ad_op_relu, a, NULL, 0.0); }
+
+
+sc_var* sc_ad_add_bias(sc_tape* tape, sc_var* x, sc_var* bias) {
+    if (check_var(tape, x) != 0 || check_var(tape, bias) != 0) {
+        return NULL;
+    }
+    uint64_t cols = last_dim(x->value);
+    if (bias->value->size != cols || bias->value->type != x->value->type) {
+        CCB_ERROR("The bias must have %" PRIu64 " elements of the type of x", cols);
+        return NULL;
+    }
+    sc_var* node = record(tape, sc_ad_op_add_bias, x, bias, NULL, x->value->dims, x->value->type);
+    if (node == NULL) {
+        return NULL;
+    }
+
+    struct ad_args args = {0};
+    args.type = x->value->type;
+    args.op = sc_ad_op_add_bias;
+    args.size = x->value->size;
+    args.cols = cols;
+    args.a = x->value->data;
+    args.b = bias->value->data;
+    args.out = node->value->data;
+    return (run_chunks(ew_forward_kernel, &args, tape) == 0) ? node : NULL;
+}
+
+
+static sc_var* reduce_all(sc_tape* tape, sc_ad_op op, sc_var* a) {
+    if (check_var(tape, a) != 0) {
+        return NULL;
+    }
+    uint64_t one = 1;
+    sc_dimensions dims = {1, &one};
+    sc_var* node = record(tape, op, a, NULL, NULL, &dims, a->value->type);
+    if (node == NULL) {
+        return NULL;
+    }
+
+    struct ad_args args = {0};
+    args.type = a->value->type;
+    args.op = op;
+    args.size = a->value->size;
+    args.a = a->value->data;
+    args.partials = create_partials(tape, AD_LINE);
+    if (args.partials == NULL || run_chunks(ew_forward_kernel, &args, tape) != 0) {
+        return NULL;
+    }
+    double total = sum_partials(args.partials, AD_LINE, 0);
+    release(tape, args.partials, sc_get_engine_thread_count() * AD_LINE * sizeof(double));
+    set_scalar(node->value, (op == sc_ad_op_mean && a->value->size > 0) ? total / (double)a->value->size : total);
+    return node;
+}
+
+
+sc_var* sc_ad_sum(sc_tape* tape, sc_var* a) { return reduce_all(tape, sc_ad_op_sum, a); }
+sc_var* sc_ad_mean(sc_tape* tape, sc_var* a) { return reduce_all(tape, sc_ad_op_mean, a); }
+
+
+sc_var* sc_ad_matmul(sc_tape* tape, sc_var* a, sc_var* b) {
+    if (check_var(tape, a) != 0 || check_var(tape, b) != 0) {
+        return NULL;
+    }
+    if (a->value->dims->dims_count != 2 || b->value->dims->dims_count != 2 || a->value->dims->dims[1] != b->value->dims->dims[0] ||
+        a->value->type != b->value->type) {
+        CCB_ERROR("matmul needs [m, k] and [k, n] operands of the same type");
+        return NULL;
+    }
+    uint64_t m = a->value->dims->dims[0];
+    uint64_t k = a->value->dims->dims[1];
+    uint64_t n = b->value->dims->dims[1];
+    uint64_t sizes[] = {m, n};
+    sc_dimensions dims = {2, sizes};
+    sc_var* node = record(tape, sc_ad_op_matmul, a, b, NULL, &dims, a->value->type);
+    if (node == NULL) {
+        return NULL;
+    }
+    save(node, a);
+    save(node, b);
+
+    sc_gemm_desc desc = sc_gemm_row_major(m, n, k, a->value->data, a->value->type, 0, b->value->data, b->value->type, 0,
+                                          node->value->data, node->value->type, 1.0, 0.0);
+    if (sc_gemm(&desc, tape->arena) != 0) {
+        CCB_ERROR("Failed to run matmul");
+        return NULL;
+    }
+    return node;
+}
+
+
+sc_var* sc_ad_softmax(sc_tape* tape, sc_var* x) {
+    if (check_var(tape, x) != 0) {
+        return NULL;
+    }
+    sc_var* node = record(tape, sc_ad_op_softmax, x, NULL, NULL, x->value->dims, x->value->type);
+    if (node == NULL) {
+        return NULL;
+    }
+    save(node, node);
+
+    struct ad_args args = {0};
+    args.type = x->value->type;
+    args.cols = last_dim(x->value);
+    args.a = x->value->data;
+    args.out = node->value->data;
+    return (run_rows(softmax_forward_kernel, &args, x->value->size / args.cols, tape) == 0) ? node : NULL;
+}
+
+
+sc_var* sc_ad_cross_entropy(sc_tape* tape, sc_var* logits, sc_vector* labels) {
+    if (check_var(tape, logits) != 0) {
+        return NULL;
+    }
+    CCB_NOTNULL(labels, "labels is NULL");
+    uint64_t cols = last_dim(logits->value);
+    uint64_t rows = logits->value->size / cols;
+    if (labels->size != rows) {
+        CCB_ERROR("%" PRIu64 " labels for %" PRIu64 " rows", labels->size, rows);
+        return NULL;
+    }
+
+    uint64_t one = 1;
+    sc_dimensions dims = {1, &one};
+    sc_var* node = record(tape, sc_ad_op_cross_entropy, logits, NULL, NULL, &dims, logits->value->type);
+    if (node == NULL) {
+        return NULL;
+    }
+    node->labels = (int64_t*)ccb_arena_malloc(tape->arena, (rows + 1) * sizeof(int64_t));
+    node->cache = ccb_arena_malloc(tape->arena, byte_size(logits->value));
+    CCB_NOTNULL(node->labels, "Failed to allocate labels");
+    CCB_NOTNULL(node->cache, "Failed to allocate probabilities");
+    if (sc_convert_buffer(labels->data, labels->type, node->labels, sc_int64, rows) != 0) {
+        CCB_ERROR("Failed to convert labels");
+        return NULL;
+    }
+    for (uint64_t r = 0; r < rows; r++) {
+        if (node->labels[r] < 0 || (uint64_t)node->labels[r] >= cols) {
+            CCB_ERROR("Label %" PRId64 " of row %" PRIu64 " is not a class of [0, %" PRIu64 ")", node->labels[r], r, cols);
+            return NULL;
+        }
+    }
+
+    struct ad_args args = {0};
+    args.type = logits->value->type;
+    args.cols = cols;
+    args.a = logits->value->data;
+    args.labels = node->labels;
+    args.cache = node->cache;
+    args.partials = create_partials(tape, AD_LINE);
+    if (args.partials == NULL || run_rows(cross_entropy_forward_kernel, &args, rows, tape) != 0) {
+        return NULL;
+    }
+    set_scalar(node->value, (rows > 0) ? sum_partials(args.partials, AD_LINE, 0) / (double)rows : 0.0);
+    release(tape, args.partials, sc_get_engine_thread_count() * AD_LINE * sizeof(double));
+    return node;
+}
+
+
+static sc_vector* vector_view(sc_tape* tape, sc_var* var) {
+    if (var == NULL) {
+        return NULL;
+    }
+    sc_vector* view = (sc_vector*)ccb_arena_malloc(tape->arena, sizeof(sc_vector));
+    CCB_NOTNULL(view, "Failed to allocate vector view");
+    view->data = var->value->data;
+    view->size = var->value->size;
+    view->type = var->value->type;
+    return view;
+}
+
+
+sc_var* sc_ad_layer_norm(sc_tape* tape, sc_var* x, sc_var* gamma, sc_var* beta, double eps) {
+    if (check_var(tape, x) != 0 || (gamma != NULL && check_var(tape, gamma) != 0) || (beta != NULL && check_var(tape, beta) != 0)) {
+        return NULL;
+    }
+    sc_var* node = record(tape, sc_ad_op_layer_norm, x, gamma, beta, NULL, x->value->type);
+    if (node == NULL) {
+        return NULL;
+    }
+    node->scalar = eps;
+    save(node, x);
+    save(node, gamma);
+
+    node->value = sc_layer_norm(x->value, vector_view(tape, gamma), vector_view(tape, beta), eps, &node->stats, tape->arena);
+    if (node->value == NULL) {
+        CCB_ERROR("Failed to run layer norm");
+        return NULL;
+    }
+    return node;
+}
+
+
+// ########
+// backward
+// ########
+
+// gradient buffer of an input, *acc tells if it already holds a contribution
+static void* grad_of(sc_tape* tape, sc_var* var, int* acc) {
+    if (var == NULL || !var->requires_grad) {
+        return NULL;
+    }
+    if (var->grad != NULL) {
+        *acc = 1;
+        return var->grad->data;
+    }
+
+    var->grad = (sc_tensor*)ccb_arena_malloc(tape->arena, sizeof(sc_tensor));
+    CCB_NOTNULL(var->grad, "Failed to allocate gradient");
+    var->grad->dims = var->value->dims;
+    var->grad->size = var->value->size;
+    var->grad->type = var->value->type;
+    var->grad->data = acquire(tape, byte_size(var->value));
+    CCB_NOTNULL(var->grad->data, "Failed to allocate gradient buffer");
+    *acc = 0;
+    return var->grad->data;
+}
+
+
+// grad(var) += values, values have the shape of var
+static int accumulate(sc_tape* tape, sc_var* var, const void* values) {
+    struct ad_args args = {0};
+    args.da = grad_of(tape, var, &args.acc_a);
+    if (args.da == NULL) {
+        return 0;
+    }
+    args.type = var->value->type;
+    args.op = sc_ad_op_add;
+    args.size = var->value->size;
+    args.dy = values;
+    return run_chunks(ew_backward_kernel, &args, tape);
+}
+
+
+static int backward_node(sc_tape* tape, sc_var* node) {
+    sc_var* a = node->inputs[0];
+    sc_var* b = node->inputs[1];
+    sc_TYPES type = node->value->type;
+
+    struct ad_args args = {0};
+    args.type = type;
+    args.op = node->op;
+    args.dy = node->grad->data;
+    args.y = node->value->data;
+
+    switch (node->op) {
+        case sc_ad_op_add_bias: {
+            args.size = node->value->size;
+            args.cols = last_dim(node->value);
+            args.a = a->value->data;
+            args.da = grad_of(tape, a, &args.acc_a);
+            args.partials = create_partials(tape, args.cols);
+            if (args.partials == NULL || run_chunks(ew_backward_kernel, &args, tape) != 0) {
+                return -1;
+            }
+            int acc_b = 0;
+            void* db = grad_of(tape, b, &acc_b);
+            for (uint64_t j = 0; db != NULL && j < args.cols; j++) {
+                double sum = sum_partials(args.partials, args.cols, j);
+                if (type == sc_float64) {
+                    AD_SET((double*)db, j, acc_b, sum);
+                } else {
+                    AD_SET((float*)db, j, acc_b, (float)sum);
+                }
+            }
+            release(tape, args.partials, sc_get_engine_thread_count() * args.cols * sizeof(double));
+            return 0;
+        }
+        case sc_ad_op_sum:
+        case sc_ad_op_mean:
+            args.size = a->value->size;
+            args.scalar = get_scalar(node->grad) / ((node->op == sc_ad_op_mean && a->value->size > 0) ? (double)a->value->size : 1.0);
+            args.da = grad_of(tape, a, &args.acc_a);
+            return run_chunks(ew_backward_kernel, &args, tape);
+        case sc_ad_op_matmul: {
+            uint64_t m = a->value->dims->dims[0];
+            uint64_t k = a->value->dims->dims[1];
+            uint64_t n = b->value->dims->dims[1];
+            int acc = 0;
+            void* da = grad_of(tape, a, &acc);
+            if (da != NULL) {
+                // da = dy . b^T
+                sc_gemm_desc desc = sc_gemm_row_major(m, k, n, args.dy, type, 0, b->value->data, type, 1, da, type, 1.0, acc ? 1.0 : 0.0);
+                if (sc_gemm(&desc, tape->arena) != 0) {
+                    return -1;
+                }
+            }
+            void* db = grad_of(tape, b, &acc);
+            if (db != NULL) {
+                // db = a^T . dy
+                sc_gemm_desc desc = sc_gemm_row_major(k, n, m, a->value->data, type, 1, args.dy, type, 0, db, type, 1.0, acc ? 1.0 : 0.0);
+                if (sc_gemm(&desc, tape->arena) != 0) {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+        case sc_ad_op_softmax:
+            args.cols = last_dim(node->value);
+            args.da = grad_of(tape, a, &args.acc_a);
+            return (args.da == NULL) ? 0 : run_rows(softmax_backward_kernel, &args, node->value->size / args.cols, tape);
+        case sc_ad_op_cross_entropy: {
+            uint64_t rows = a->value->size / last_dim(a->value);
+            args.cols = last_dim(a->value);
+            args.labels = node->labels;
+            args.cache = node->cache;
+            args.scalar = get_scalar(node->grad) / (double)rows;
+            args.da = grad_of(tape, a, &args.acc_a);
+            return (args.da == NULL) ? 0 : run_rows(cross_entropy_backward_kernel, &args, rows, tape);
+        }
+        case sc_ad_op_layer_norm: {
+            sc_var* gamma = node->inputs[1];
+            sc_var* beta = node->inputs[2];
+            sc_vector* dgamma = (gamma != NULL && gamma->requires_grad) ? sc_create_vector(gamma->value->size, type, tape->arena) : NULL;
+            sc_vector* dbeta = (beta != NULL && beta->requires_grad) ? sc_create_vector(beta->value->size, type, tape->arena) : NULL;
+            sc_tensor* dx = sc_layer_norm_backward(node->grad, a->value, vector_view(tape, gamma), &node->stats, dgamma, dbeta, tape->arena);
+            if (dx == NULL) {
+                CCB_ERROR("Failed to run layer norm backward");
+                return -1;
+            }
+            if (accumulate(tape, a, dx->data) != 0 || (dgamma != NULL && accumulate(tape, gamma, dgamma->data) != 0) ||
+                (dbeta != NULL && accumulate(tape, beta, dbeta->data) != 0)) {
+                return -1;
+            }
+            return 0;
+        }
+        default:
+            // element wise ops, both operands in one pass
+            args.size = node->value->size;
+            args.scalar = node->scalar;
+            args.a = a->value->data;
+            args.b = (b != NULL) ? b->value->data : NULL;
+            args.da = grad_of(tape, a, &args.acc_a);
+            args.db = grad_of(tape, b, &args.acc_b);
+            if (args.da == NULL && args.db == NULL) {
+                return 0;
+            }
+            return run_chunks(ew_backward_kernel, &args, tape);
+    }
+}
+
+
+int sc_tape_backward(sc_tape* tape, sc_var* loss) {
+    CCB_NOTNULL(tape, "tape is NULL");
+    CCB_NOTNULL(loss, "loss is NULL");
+    if (loss->index >= tape->count || tape->nodes[loss->index] != loss) {
+        CCB_ERROR("The loss was not recorded on this tape");
+        return -1;
+    }
+    if (loss->value->size != 1) {
+        CCB_ERROR("The loss must have one element, got %" PRIu64, loss->value->size);
+        return -1;
+    }
+    if (!loss->requires_grad) {
+        CCB_ERROR("The loss does not depend on a variable that requires a gradient");
+        return -1;
+    }
+
+    // the values no backward step reads become gradient buffers
+    for (uint64_t i = 0; i < tape->count; i++) {
+        sc_var* node = tape->nodes[i];
+        if (node->op != sc_ad_op_leaf && !node->saved && node != loss) {
+            release(tape, node->value->data, byte_size(node->value));
+        }
+    }
+
+    int acc = 0;
+    if (grad_of(tape, loss, &acc) == NULL) {
+        return -1;
+    }
+    set_scalar(loss->grad, 1.0);
+
+    for (uint64_t i = loss->index + 1; i-- > 0;) {
+        sc_var* node = tape->nodes[i];
+        if (node->op == sc_ad_op_leaf || node->grad == NULL) {
+            continue;
+        }
+        if (backward_node(tape, node) != 0) {
+            CCB_ERROR("Failed to run the backward step of node %" PRIu64 " (op %d)", i, node->op);
+            return -1;
+        }
+        // the gradient of an intermediate node is not needed anymore
+        if (node != loss) {
+            release(tape, node->grad->data, byte_size(node->grad));
+            node->grad = NULL;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+#ifndef __AUTODIFF_H__
+#define __AUTODIFF_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+#include "normalization.h"
+
+/*
+    reverse mode automatic differentiation: the operations on sc_var are computed right away and recorded on
+    a tape, sc_tape_backward replays the tape backwards from a scalar loss
+    every backward step is one fused pass (both operands of a binary op, the bias reduction of a broadcast,
+    the softmax / cross entropy row reductions) or gemms for the matmul, run on the engine thread pool
+    nodes, values and gradients come from the tape arena; the backward pass recycles the buffers it does not
+    need anymore (values no backward step reads, gradients already propagated) for the next gradients
+    float32 and float64 tensors, the operands of an op have the same type
+*/
+
+typedef enum {
+    sc_ad_op_leaf,
+    sc_ad_op_add,
+    sc_ad_op_sub,
+    sc_ad_op_mul,
+    sc_ad_op_div,
+    sc_ad_op_scale,
+    sc_ad_op_exp,
+    sc_ad_op_log,
+    sc_ad_op_tanh,
+    sc_ad_op_sigmoid,
+    sc_ad_op_relu,
+    sc_ad_op_add_bias,
+    sc_ad_op_sum,
+    sc_ad_op_mean,
+    sc_ad_op_matmul,
+    sc_ad_op_softmax,
+    sc_ad_op_cross_entropy,
+    sc_ad_op_layer_norm,
+} sc_ad_op;
+
+typedef struct sc_var_t {
+    sc_tensor* value;
+    sc_tensor* grad;            // set by the backward pass, only kept for the leaves and the loss
+    sc_ad_op op;
+    struct sc_var_t* inputs[3];
+    int requires_grad;
+    int saved;                  // the value is read by a backward step
+    uint64_t index;             // position on the tape
+    double scalar;              // scale factor, layer norm eps
+    void* cache;                // cross entropy probabilities
+    int64_t* labels;            // cross entropy classes
+    sc_norm_stats stats;        // layer norm statistics
+} sc_var;
+
+typedef struct {
+    ccb_arena* arena;
+    sc_var** nodes;
+    uint64_t count;
+    uint64_t capacity;
+
+    // buffers released by the backward pass, reused by size
+    void** pool;
+    uint64_t* pool_sizes;
+    uint64_t pool_count;
+    uint64_t pool_capacity;
+} sc_tape;
+
+
+/* Creates an empty tape
+   - ccb_arena* arena: arena where the tape, the nodes, the values and the gradients will be allocated,
+     reset it (and create a new tape) between training steps
+   - return: a pointer to the tape
+*/
+sc_tape* sc_tape_create(ccb_arena* arena);
+/* Wraps a tensor (not copied) as an input of the tape
+   - int requires_grad: 1 to compute its gradient (parameters), 0 for data
+*/
+sc_var* sc_ad_leaf(sc_tape* tape, sc_tensor* value, int requires_grad);
+
+// element wise ops, the operands have the same shape
+sc_var* sc_ad_add(sc_tape* tape, sc_var* a, sc_var* b);
+sc_var* sc_ad_sub(sc_tape* tape, sc_var* a, sc_var* b);
+sc_var* sc_ad_mul(sc_tape* tape, sc_var* a, sc_var* b);
+sc_var* sc_ad_div(sc_tape* tape, sc_var* a, sc_var* b);
+sc_var* sc_ad_scale(sc_tape* tape, sc_var* a, double scale);
+sc_var* sc_ad_exp(sc_tape* tape, sc_var* a);
+sc_var* sc_ad_log(sc_tape* tape, sc_var* a);
+sc_var* sc_ad_tanh(sc_tape* tape, sc_var* a);
+sc_var* sc_ad_sigmoid(sc_tape* tape, sc_var* a);
+sc_var* sc_ad_relu(sc_tape* tape, sc_var* a);
+
+// x [..., n] + bias [n], the gradient of the bias is reduced over the rows
+sc_var* sc_ad_add_bias(sc_tape* tape, sc_var* x, sc_var* bias);
+// sum and mean of all the elements, the result has one element
+sc_var* sc_ad_sum(sc_tape* tape, sc_var* a);
+sc_var* sc_ad_mean(sc_tape* tape, sc_var* a);
+// a [m, k] . b [k, n]
+sc_var* sc_ad_matmul(sc_tape* tape, sc_var* a, sc_var* b);
+// softmax of each row (last dimension)
+sc_var* sc_ad_softmax(sc_tape* tape, sc_var* x);
+/* Mean cross entropy of the softmax of each row of logits [rows, classes]
+   - sc_vector* labels: class index of each row, any type
+   - return: a one element loss
+*/
+sc_var* sc_ad_cross_entropy(sc_tape* tape, sc_var* logits, sc_vector* labels);
+// layer norm of each row, gamma and beta are [n] (NULL for 1 and 0)
+sc_var* sc_ad_layer_norm(sc_tape* tape, sc_var* x, sc_var* gamma, sc_var* beta, double eps);
+
+/* Computes the gradients of a one element loss with respect to every node that requires it
+   the leaves keep their gradient in grad, the values of the intermediate nodes that no backward step reads
+   and the gradients of the intermediate nodes are recycled during the pass
+   - return: 0 on success
+*/
+int sc_tape_backward(sc_tape* tape, sc_var* loss);
+
+
+#endif // __AUTODIFF_H__
@@ -0,0 +1,828 @@
+#include "data.h"
+#include "conv.h"
+#include "sc_engine.h"
+#include "sc_gemm.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+// the direct kernel beats im2col + gemm for tiny filters (in_channels * kernel multiply-adds per output)
+// or few output channels (the gemm has too few rows to amortise the packing)
+#define CONV_DIRECT_MAX_DEPTH 16
+#define CONV_DIRECT_MAX_CHANNELS 16
+// im2col columns are built in chunks of at most this many bytes per thread
+#define CONV_COL_CHUNK_BYTES (512 * 1024)
+// output channels computed together by the direct kernel
+#define CONV_OC_BLOCK 8
+#define CONV_ALIGN 64
+
+
+#define MADD_PS_AVX(acc, a, b) _mm256_add_ps(acc, _mm256_mul_ps(a, b))
+#define MADD_PS_FMA(acc, a, b) _mm256_fmadd_ps(a, b, acc)
+
+
+struct conv_args {
+    sc_TYPES type;
+    uint64_t batch;
+    uint64_t in_c;
+    uint64_t out_c;
+    uint64_t in_h;
+    uint64_t in_w;
+    uint64_t k_h;
+    uint64_t k_w;
+    uint64_t out_h;
+    uint64_t out_w;
+    uint64_t stride_h;
+    uint64_t stride_w;
+    int64_t padding_h;
+    int64_t padding_w;
+    uint64_t dilation_h;
+    uint64_t dilation_w;
+
+    const void* x;
+    const void* weight;
+    const void* bias;
+    void* y;
+
+    // valid output columns [w_lo[kw], w_hi[kw]) for each kernel column,
+    // [ow_lo, ow_hi) is valid for every kernel column
+    uint64_t* w_lo;
+    uint64_t* w_hi;
+    uint64_t ow_lo;
+    uint64_t ow_hi;
+
+    // float32 weights of the direct kernel, [out_c / CONV_OC_BLOCK][in_c * k_h * k_w][CONV_OC_BLOCK]
+    float* packed_weight;
+
+    // work units are batch x channel tiles
+    uint64_t c_tile;
+    uint64_t c_tiles;
+
+    // im2col chunk of output positions
+    uint64_t chunk;
+
+    uint8_t* scratch;
+    uint64_t scratch_stride;
+
+    int max_pool;
+};
+
+
+// #######
+// helpers
+// #######
+
+static uint64_t type_size(sc_TYPES type) {
+    return (type == sc_float64) ? sizeof(double) : (type == sc_float32) ? sizeof(float) : sizeof(uint16_t);
+}
+
+// float32 for float32 / bfloat16, float64 for float64
+static sc_TYPES compute_type(sc_TYPES type) {
+    return (type == sc_float64) ? sc_float64 : sc_float32;
+}
+
+static uint64_t align_up(uint64_t value) {
+    return (value + CONV_ALIGN - 1) / CONV_ALIGN * CONV_ALIGN;
+}
+
+static double load_value(const void* base, uint64_t index, sc_TYPES type) {
+    if (type == sc_float64) {
+        return ((const double*)base)[index];
+    }
+    return sc_load_f32(base, index, type);
+}
+
+
+// output positions o with 0 <= o * stride + offset < in_size
+static void valid_range(int64_t offset, uint64_t stride, uint64_t in_size, uint64_t out_size, uint64_t* lo, uint64_t* hi) {
+    int64_t s = (int64_t)stride;
+    int64_t low = (offset >= 0) ? 0 : (-offset + s - 1) / s;
+    int64_t high = ((int64_t)in_size - offset <= 0) ? 0 : ((int64_t)in_size - offset + s - 1) / s;
+
+    if (high > (int64_t)out_size) high = (int64_t)out_size;
+    if (low > high) low = high;
+
+    *lo = (uint64_t)low;
+    *hi = (uint64_t)high;
+}
+
+
+// ############
+// row kernels
+// ############
+
+// the accumulators are float32 (float64 for float64 inputs), x rows are read with a stride
+
+static void row_fill(void* acc, uint64_t offset, double value, uint64_t count, sc_TYPES type) {
+    if (type == sc_float64) {
+        double* out = (double*)acc + offset;
+        for (uint64_t i = 0; i < count; i++) out[i] = value;
+    } else {
+        float* out = (float*)acc + offset;
+        for (uint64_t i = 0; i < count; i++) out[i] = (float)value;
+    }
+}
+
+
+// acc[i] += w * x[index + i * stride]
+static void row_axpy(void* acc, uint64_t offset, const void* x, uint64_t index, uint64_t stride, sc_TYPES type, double w, uint64_t count) {
+    uint64_t i = 0;
+
+    if (type == sc_float64) {
+        double* out = (double*)acc + offset;
+        const double* in = (const double*)x + index;
+        if (stride == 1) {
+            __m256d wv = _mm256_set1_pd(w);
+            for (; i + 4 <= count; i += 4) {
+                _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(out + i), _mm256_mul_pd(wv, _mm256_loadu_pd(in + i))));
+            }
+        }
+        for (; i < count; i++) out[i] += w * in[i * stride];
+        return;
+    }
+
+    float* out = (float*)acc + offset;
+    float wf = (float)w;
+    if (stride == 1) {
+        __m256 wv = _mm256_set1_ps(wf);
+        for (; i + 8 <= count; i += 8) {
+            __m256 v = sc_load_f32x8(x, index + i, type);
+            _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(wv, v)));
+        }
+    }
+    for (; i < count; i++) out[i] += wf * sc_load_f32(x, index + i * stride, type);
+}
+
+
+// acc[i] = max(acc[i], x[index + i * stride])
+static void row_max(void* acc, uint64_t offset, const void* x, uint64_t index, uint64_t stride, sc_TYPES type, uint64_t count) {
+    uint64_t i = 0;
+
+    if (type == sc_float64) {
+        double* out = (double*)acc + offset;
+        const double* in = (const double*)x + index;
+        if (stride == 1) {
+            for (; i + 4 <= count; i += 4) {
+                _mm256_storeu_pd(out + i, _mm256_max_pd(_mm256_loadu_pd(out + i), _mm256_loadu_pd(in + i)));
+            }
+        }
+        for (; i < count; i++) out[i] = (in[i * stride] > out[i]) ? in[i * stride] : out[i];
+        return;
+    }
+
+    float* out = (float*)acc + offset;
+    if (stride == 1) {
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(out + i, _mm256_max_ps(_mm256_loadu_ps(out + i), sc_load_f32x8(x, index + i, type)));
+        }
+    }
+    for (; i < count; i++) {
+        float value = sc_load_f32(x, index + i * stride, type);
+        out[i] = (value > out[i]) ? value : out[i];
+    }
+}
+
+
+// dst[offset + i] = x[index + i * stride] converted to the compute type
+static void row_copy(void* dst, uint64_t offset, const void* x, uint64_t index, uint64_t stride, sc_TYPES type, uint64_t count) {
+    if (type == sc_float64) {
+        double* out = (double*)dst + offset;
+        const double* in = (const double*)x + index;
+        if (stride == 1) {
+            memcpy(out, in, count * sizeof(double));
+            return;
+        }
+        for (uint64_t i = 0; i < count; i++) out[i] = in[i * stride];
+        return;
+    }
+
+    float* out = (float*)dst + offset;
+    if (stride == 1 && type == sc_float32) {
+        memcpy(out, (const float*)x + index, count * sizeof(float));
+        return;
+    }
+    for (uint64_t i = 0; i < count; i++) out[i] = sc_load_f32(x, index + i * stride, type);
+}
+
+
+// y[index + i] = acc[i] converted to the output type
+static void row_store(void* y, uint64_t index, const void* acc, sc_TYPES type, uint64_t count) {
+    if (type == sc_float64) {
+        memcpy((double*)y + index, acc, count * sizeof(double));
+        return;
+    }
+    if (type == sc_float32) {
+        memcpy((float*)y + index, acc, count * sizeof(float));
+        return;
+    }
+
+    const float* in = (const float*)acc;
+    uint64_t i = 0;
+    for (; i + 8 <= count; i += 8) sc_store_f32x8(y, index + i, _mm256_loadu_ps(in + i), type);
+    for (; i < count; i++) sc_store_f32(y, index + i, in[i], type);
+}
+
+
+// #################
+// convolution units
+// #################
+
+static void conv_direct_unit(struct conv_args* a, uint64_t n, uint64_t oc0, uint64_t oc1, void* acc) {
+    uint64_t kernel_size = a->in_c * a->k_h * a->k_w;
+
+    for (uint64_t oc = oc0; oc < oc1; oc++) {
+        double bias = (a->bias != NULL) ? load_value(a->bias, oc, a->type) : 0.0;
+
+        for (uint64_t oh = 0; oh < a->out_h; oh++) {
+            row_fill(acc, 0, bias, a->out_w, a->type);
+
+            for (uint64_t ic = 0; ic < a->in_c; ic++) {
+                for (uint64_t kh = 0; kh < a->k_h; kh++) {
+                    int64_t ih = (int64_t)(oh * a->stride_h + kh * a->dilation_h) - a->padding_h;
+                    if (ih < 0 || ih >= (int64_t)a->in_h) {
+                        continue;
+                    }
+
+                    uint64_t x_row = ((n * a->in_c + ic) * a->in_h + (uint64_t)ih) * a->in_w;
+                    uint64_t w_row = oc * kernel_size + (ic * a->k_h + kh) * a->k_w;
+
+                    for (uint64_t kw = 0; kw < a->k_w; kw++) {
+                        uint64_t lo = a->w_lo[kw];
+                        uint64_t hi = a->w_hi[kw];
+                        if (lo >= hi) {
+                            continue;
+                        }
+
+                        int64_t offset = (int64_t)(kw * a->dilation_w) - a->padding_w;
+                        uint64_t index = x_row + (uint64_t)((int64_t)(lo * a->stride_w) + offset);
+                        row_axpy(acc, lo, a->x, index, a->stride_w, a->type, load_value(a->weight, w_row + kw, a->type), hi - lo);
+                    }
+                }
+            }
+
+            row_store(a->y, ((n * a->out_c + oc) * a->out_h + oh) * a->out_w, acc, a->type, a->out_w);
+        }
+    }
+}
+
+
+// CONV_OC_BLOCK output channels of one output row, float32 inputs with a stride of 1:
+// the interior columns keep 4 channels x 8 columns in registers, every x load feeds 4 multiply-adds,
+// the columns touching the padding are computed one by one
+#define DEFINE_CONV_DIRECT_BLOCK(name, madd) \
+static void name(struct conv_args* a, uint64_t n, uint64_t oh, const float* w_block, float* acc) { \
+    uint64_t ow_end = a->ow_lo + (a->ow_hi - a->ow_lo) / 8 * 8; \
+    uint64_t out_w = a->out_w; \
+    for (uint64_t ow = a->ow_lo; ow < ow_end; ow += 8) { \
+        __m256 s[CONV_OC_BLOCK]; \
+        _Pragma("GCC unroll 8") \
+        for (int o = 0; o < CONV_OC_BLOCK; o++) s[o] = _mm256_loadu_ps(acc + o * out_w + ow); \
+        const float* wp = w_block; \
+        for (uint64_t ic = 0; ic < a->in_c; ic++) { \
+            for (uint64_t kh = 0; kh < a->k_h; kh++, wp += a->k_w * CONV_OC_BLOCK) { \
+                int64_t ih = (int64_t)(oh * a->stride_h + kh * a->dilation_h) - a->padding_h; \
+                if (ih < 0 || ih >= (int64_t)a->in_h) { \
+                    continue; \
+                } \
+                uint64_t x_row = ((n * a->in_c + ic) * a->in_h + (uint64_t)ih) * a->in_w + ow - a->padding_w; \
+                for (uint64_t kw = 0; kw < a->k_w; kw++) { \
+                    __m256 xv = sc_load_f32x8(a->x, x_row + kw * a->dilation_w, a->type); \
+                    _Pragma("GCC unroll 8") \
+                    for (int o = 0; o < CONV_OC_BLOCK; o++) s[o] = madd(s[o], _mm256_broadcast_ss(wp + kw * CONV_OC_BLOCK + o), xv); \
+                } \
+            } \
+        } \
+        _Pragma("GCC unroll 8") \
+        for (int o = 0; o < CONV_OC_BLOCK; o++) _mm256_storeu_ps(acc + o * out_w + ow, s[o]); \
+    } \
+    for (uint64_t ow = 0; ow < out_w; ow++) { \
+        if (ow == a->ow_lo && ow_end > ow) { \
+            ow = ow_end - 1; \
+            continue; \
+        } \
+        float sum[CONV_OC_BLOCK] = {0}; \
+        const float* wp = w_block; \
+        for (uint64_t ic = 0; ic < a->in_c; ic++) { \
+            for (uint64_t kh = 0; kh < a->k_h; kh++, wp += a->k_w * CONV_OC_BLOCK) { \
+                int64_t ih = (int64_t)(oh * a->stride_h + kh * a->dilation_h) - a->padding_h; \
+                if (ih < 0 || ih >= (int64_t)a->in_h) { \
+                    continue; \
+                } \
+                uint64_t x_row = ((n * a->in_c + ic) * a->in_h + (uint64_t)ih) * a->in_w; \
+                for (uint64_t kw = 0; kw < a->k_w; kw++) { \
+                    if (ow < a->w_lo[kw] || ow >= a->w_hi[kw]) { \
+                        continue; \
+                    } \
+                    float xv = sc_load_f32(a->x, x_row + ow + kw * a->dilation_w - a->padding_w, a->type); \
+                    for (uint64_t o = 0; o < CONV_OC_BLOCK; o++) sum[o] += wp[kw * CONV_OC_BLOCK + o] * xv; \
+                } \
+            } \
+        } \
+        for (uint64_t o = 0; o < CONV_OC_BLOCK; o++) acc[o * out_w + ow] += sum[o]; \
+    } \
+}
+
+DEFINE_CONV_DIRECT_BLOCK(conv_direct_block_avx, MADD_PS_AVX)
+SC_TARGET_AVX2 DEFINE_CONV_DIRECT_BLOCK(conv_direct_block_fma, MADD_PS_FMA)
+
+
+static void conv_direct_blocked_unit(struct conv_args* a, uint64_t n, uint64_t oc0, uint64_t oc1, float* acc) {
+    uint64_t kernel_size = a->in_c * a->k_h * a->k_w;
+    void (*block)(struct conv_args*, uint64_t, uint64_t, const float*, float*) = sc_has_avx2_fma() ? conv_direct_block_fma : conv_direct_block_avx;
+
+    for (uint64_t ob = oc0; ob < oc1; ob += CONV_OC_BLOCK) {
+        uint64_t count = (oc1 - ob < CONV_OC_BLOCK) ? oc1 - ob : CONV_OC_BLOCK;
+        const float* w_block = a->packed_weight + (ob / CONV_OC_BLOCK) * kernel_size * CONV_OC_BLOCK;
+
+        for (uint64_t oh = 0; oh < a->out_h; oh++) {
+            for (uint64_t o = 0; o < CONV_OC_BLOCK; o++) {
+                double bias = (a->bias != NULL && o < count) ? load_value(a->bias, ob + o, a->type) : 0.0;
+                row_fill(acc, o * a->out_w, bias, a->out_w, sc_float32);
+            }
+
+            block(a, n, oh, w_block, acc);
+
+            for (uint64_t o = 0; o < count; o++) {
+                row_store(a->y, ((n * a->out_c + ob + o) * a->out_h + oh) * a->out_w, acc + o * a->out_w, a->type, a->out_w);
+            }
+        }
+    }
+}
+
+
+// columns [p0, p0 + count) of the im2col matrix of image n, one row per (ic, kh, kw)
+static void im2col_chunk(struct conv_args* a, uint64_t n, uint64_t p0, uint64_t count, void* col) {
+    sc_TYPES type = a->type;
+    uint64_t row = 0;
+
+    for (uint64_t ic = 0; ic < a->in_c; ic++) {
+        for (uint64_t kh = 0; kh < a->k_h; kh++) {
+            for (uint64_t kw = 0; kw < a->k_w; kw++, row++) {
+                int64_t offset = (int64_t)(kw * a->dilation_w) - a->padding_w;
+                uint64_t p = p0;
+
+                while (p < p0 + count) {
+                    uint64_t oh = p / a->out_w;
+                    uint64_t ow0 = p % a->out_w;
+                    uint64_t ow1 = (a->out_w - ow0 < p0 + count - p) ? a->out_w : ow0 + (p0 + count - p);
+                    uint64_t dst = row * a->chunk + (p - p0);
+
+                    int64_t ih = (int64_t)(oh * a->stride_h + kh * a->dilation_h) - a->padding_h;
+                    if (ih < 0 || ih >= (int64_t)a->in_h) {
+                        row_fill(col, dst, 0.0, ow1 - ow0, type);
+                        p += ow1 - ow0;
+                        continue;
+                    }
+
+                    uint64_t lo = (a->w_lo[kw] > ow0) ? a->w_lo[kw] : ow0;
+                    uint64_t hi = (a->w_hi[kw] < ow1) ? a->w_hi[kw] : ow1;
+                    if (lo >= hi) {
+                        row_fill(col, dst, 0.0, ow1 - ow0, type);
+                        p += ow1 - ow0;
+                        continue;
+                    }
+
+                    uint64_t x_row = ((n * a->in_c + ic) * a->in_h + (uint64_t)ih) * a->in_w;
+                    row_fill(col, dst, 0.0, lo - ow0, type);
+                    row_copy(col, dst + (lo - ow0), a->x, x_row + (uint64_t)((int64_t)(lo * a->stride_w) + offset), a->stride_w, type, hi - lo);
+                    row_fill(col, dst + (hi - ow0), 0.0, ow1 - hi, type);
+                    p += ow1 - ow0;
+                }
+            }
+        }
+    }
+}
+
+
+static int conv_im2col_unit(struct conv_args* a, uint64_t n, uint64_t oc0, uint64_t oc1, uint8_t* scratch) {
+    uint64_t kernel_size = a->in_c * a->k_h * a->k_w;
+    uint64_t positions = a->out_h * a->out_w;
+    sc_TYPES col_type = compute_type(a->type);
+    uint64_t x_size = type_size(a->type);
+
+    void* col = scratch;
+    void* gemm_scratch = scratch + align_up(kernel_size * a->chunk * type_size(col_type));
+
+    for (uint64_t p0 = 0; p0 < positions; p0 += a->chunk) {
+        uint64_t count = (positions - p0 < a->chunk) ? positions - p0 : a->chunk;
+        uint64_t out_index = (n * a->out_c + oc0) * positions + p0;
+
+        im2col_chunk(a, n, p0, count, col);
+
+        // the bias is written first and accumulated by the gemm (beta = 1) so bfloat16 outputs are rounded once
+        if (a->bias != NULL) {
+            for (uint64_t oc = oc0; oc < oc1; oc++) {
+                uint8_t* row = (uint8_t*)a->y + (out_index + (oc - oc0) * positions) * x_size;
+                for (uint64_t i = 0; i < count; i++) {
+                    memcpy(row + i * x_size, (const uint8_t*)a->bias + oc * x_size, x_size);
+                }
+            }
+        }
+
+        sc_gemm_desc desc;
+        desc.m = oc1 - oc0;
+        desc.n = count;
+        desc.k = kernel_size;
+        desc.a = (const uint8_t*)a->weight + oc0 * kernel_size * x_size;
+        desc.a_type = a->type;
+        desc.a_row_stride = (int64_t)kernel_size;
+        desc.a_col_stride = 1;
+        desc.b = col;
+        desc.b_type = col_type;
+        desc.b_row_stride = (int64_t)a->chunk;
+        desc.b_col_stride = 1;
+        desc.c = (uint8_t*)a->y + out_index * x_size;
+        desc.c_type = a->type;
+        desc.c_row_stride = (int64_t)positions;
+        desc.c_col_stride = 1;
+        desc.alpha = 1.0;
+        desc.beta = (a->bias != NULL) ? 1.0 : 0.0;
+
+        if (sc_gemm_serial(&desc, gemm_scratch) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+static int conv_direct_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct conv_args* a = (struct conv_args*)raw;
+    void* acc = a->scratch + thread_id * a->scratch_stride;
+
+    for (uint64_t u = start; u < end; u++) {
+        uint64_t n = u / a->c_tiles;
+        uint64_t oc0 = (u % a->c_tiles) * a->c_tile;
+        uint64_t oc1 = (oc0 + a->c_tile < a->out_c) ? oc0 + a->c_tile : a->out_c;
+        if (a->packed_weight != NULL) {
+            conv_direct_blocked_unit(a, n, oc0, oc1, (float*)acc);
+        } else {
+            conv_direct_unit(a, n, oc0, oc1, acc);
+        }
+    }
+    return 0;
+}
+
+
+static int conv_im2col_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct conv_args* a = (struct conv_args*)raw;
+    uint8_t* scratch = a->scratch + thread_id * a->scratch_stride;
+
+    for (uint64_t u = start; u < end; u++) {
+        uint64_t n = u / a->c_tiles;
+        uint64_t oc0 = (u % a->c_tiles) * a->c_tile;
+        uint64_t oc1 = (oc0 + a->c_tile < a->out_c) ? oc0 + a->c_tile : a->out_c;
+        if (conv_im2col_unit(a, n, oc0, oc1, scratch) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+// #############
+// pooling units
+// #############
+
+static int pool_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct conv_args* a = (struct conv_args*)raw;
+    void* acc = a->scratch + thread_id * a->scratch_stride;
+
+    for (uint64_t plane = start; plane < end; plane++) {
+        for (uint64_t oh = 0; oh < a->out_h; oh++) {
+            row_fill(acc, 0, a->max_pool ? -INFINITY : 0.0, a->out_w, a->type);
+            uint64_t rows = 0;
+
+            for (uint64_t kh = 0; kh < a->k_h; kh++) {
+                int64_t ih = (int64_t)(oh * a->stride_h + kh) - a->padding_h;
+                if (ih < 0 || ih >= (int64_t)a->in_h) {
+                    continue;
+                }
+                rows++;
+
+                uint64_t x_row = (plane * a->in_h + (uint64_t)ih) * a->in_w;
+                for (uint64_t kw = 0; kw < a->k_w; kw++) {
+                    uint64_t lo = a->w_lo[kw];
+                    uint64_t hi = a->w_hi[kw];
+                    if (lo >= hi) {
+                        continue;
+                    }
+
+                    uint64_t index = x_row + (uint64_t)((int64_t)(lo * a->stride_w + kw) - a->padding_w);
+                    if (a->max_pool) {
+                        row_max(acc, lo, a->x, index, a->stride_w, a->type, hi - lo);
+                    } else {
+                        row_axpy(acc, lo, a->x, index, a->stride_w, a->type, 1.0, hi - lo);
+                    }
+                }
+            }
+
+            // average over the valid elements of each window
+            if (!a->max_pool) {
+                for (uint64_t ow = 0; ow < a->out_w; ow++) {
+                    uint64_t cols = 0;
+                    for (uint64_t kw = 0; kw < a->k_w; kw++) {
+                        cols += (ow >= a->w_lo[kw] && ow < a->w_hi[kw]);
+                    }
+                    double count = (double)(rows * cols);
+                    if (a->type == sc_float64) {
+                        ((double*)acc)[ow] /= count;
+                    } else {
+                        ((float*)acc)[ow] /= (float)count;
+                    }
+                }
+            }
+
+            row_store(a->y, (plane * a->out_h + oh) * a->out_w, acc, a->type, a->out_w);
+        }
+    }
+    return 0;
+}
+
+
+// #####
+// setup
+// #####
+
+static int check_type(sc_tensor* x, uint64_t dims_count, const char* name) {
+    CCB_NOTNULL(x, "%s is NULL", name);
+
+    if (x->type != sc_float16 && x->type != sc_float32 && x->type != sc_float64) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", x->type);
+        return -1;
+    }
+
+    if (x->dims->dims_count != dims_count) {
+        CCB_ERROR("%s must have %" PRIu64 " dimensions, got %" PRIu64, name, dims_count, x->dims->dims_count);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int output_size(uint64_t in, uint64_t kernel, uint64_t stride, uint64_t padding, uint64_t dilation, uint64_t* out) {
+    uint64_t span = dilation * (kernel - 1) + 1;
+    if (kernel == 0 || in + 2 * padding < span) {
+        CCB_ERROR("Kernel (span %" PRIu64 ") larger than the padded input (%" PRIu64 ")", span, in + 2 * padding);
+        return -1;
+    }
+
+    *out = (in + 2 * padding - span) / stride + 1;
+    return 0;
+}
+
+
+static int setup_columns(struct conv_args* a, ccb_arena* arena) {
+    a->w_lo = (uint64_t*)ccb_arena_malloc(arena, a->k_w * sizeof(uint64_t));
+    CCB_NOTNULL(a->w_lo, "Failed to allocate column ranges");
+    a->w_hi = (uint64_t*)ccb_arena_malloc(arena, a->k_w * sizeof(uint64_t));
+    CCB_NOTNULL(a->w_hi, "Failed to allocate column ranges");
+
+    a->ow_lo = 0;
+    a->ow_hi = a->out_w;
+    for (uint64_t kw = 0; kw < a->k_w; kw++) {
+        int64_t offset = (int64_t)(kw * a->dilation_w) - a->padding_w;
+        valid_range(offset, a->stride_w, a->in_w, a->out_w, &a->w_lo[kw], &a->w_hi[kw]);
+        a->ow_lo = (a->w_lo[kw] > a->ow_lo) ? a->w_lo[kw] : a->ow_lo;
+        a->ow_hi = (a->w_hi[kw] < a->ow_hi) ? a->w_hi[kw] : a->ow_hi;
+    }
+    if (a->ow_lo > a->ow_hi) {
+        a->ow_lo = a->ow_hi;
+    }
+    return 0;
+}
+
+
+static sc_tensor* create_output(uint64_t dims_count, uint64_t batch, uint64_t channels, uint64_t out_h, uint64_t out_w, sc_TYPES type, ccb_arena* arena) {
+    uint64_t dims[4] = {batch, channels, out_h, out_w};
+    if (dims_count == 3) {
+        dims[2] = out_w;
+    }
+
+    sc_dimensions* out_dims = sc_create_dimensions(dims_count, arena, dims);
+    CCB_NOTNULL(out_dims, "Failed to create output dimensions");
+
+    sc_tensor* out = sc_create_tensor(out_dims, type, arena);
+    CCB_NOTNULL(out, "Failed to create output tensor");
+    return out;
+}
+
+
+// x and weight are read as 4d tensors, a 1d input has a height of 1
+static sc_tensor* conv_forward(sc_tensor* x, sc_tensor* weight, sc_vector* bias, sc_conv_params params, uint64_t dims_count, ccb_arena* scratch, ccb_arena* arena) {
+    if (check_type(x, dims_count, "x") != 0 || check_type(weight, dims_count, "weight") != 0) {
+        return NULL;
+    }
+    CCB_NOTNULL(scratch, "scratch is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+
+    if (weight->type != x->type) {
+        CCB_ERROR("Tensor type mismatch: %d vs %d", x->type, weight->type);
+        return NULL;
+    }
+
+    struct conv_args a;
+    memset(&a, 0, sizeof(a));
+    a.type = x->type;
+    a.batch = x->dims->dims[0];
+    a.in_c = x->dims->dims[1];
+    a.in_h = (dims_count == 4) ? x->dims->dims[2] : 1;
+    a.in_w = x->dims->dims[dims_count - 1];
+    a.out_c = weight->dims->dims[0];
+    a.k_h = (dims_count == 4) ? weight->dims->dims[2] : 1;
+    a.k_w = weight->dims->dims[dims_count - 1];
+
+    a.stride_h = (dims_count == 4 && params.stride_h != 0) ? params.stride_h : 1;
+    a.stride_w = (params.stride_w != 0) ? params.stride_w : 1;
+    a.padding_h = (dims_count == 4) ? (int64_t)params.padding_h : 0;
+    a.padding_w = (int64_t)params.padding_w;
+    a.dilation_h = (dims_count == 4 && params.dilation_h != 0) ? params.dilation_h : 1;
+    a.dilation_w = (params.dilation_w != 0) ? params.dilation_w : 1;
+
+    if (weight->dims->dims[1] != a.in_c) {
+        CCB_ERROR("weight expects %" PRIu64 " input channels, got %" PRIu64, weight->dims->dims[1], a.in_c);
+        return NULL;
+    }
+
+    if (bias != NULL && (bias->size != a.out_c || bias->type != x->type)) {
+        CCB_ERROR("bias mismatch: size %" PRIu64 " type %d, expected size %" PRIu64 " type %d", bias->size, bias->type, a.out_c, x->type);
+        return NULL;
+    }
+
+    if (output_size(a.in_h, a.k_h, a.stride_h, (uint64_t)a.padding_h, a.dilation_h, &a.out_h) != 0 ||
+        output_size(a.in_w, a.k_w, a.stride_w, (uint64_t)a.padding_w, a.dilation_w, &a.out_w) != 0) {
+        return NULL;
+    }
+
+    sc_tensor* out = create_output(dims_count, a.batch, a.out_c, a.out_h, a.out_w, x->type, arena);
+    if (out == NULL || out->size == 0) {
+        return out;
+    }
+
+    a.x = x->data;
+    a.weight = weight->data;
+    a.bias = (bias != NULL) ? bias->data : NULL;
+    a.y = out->data;
+
+    if (setup_columns(&a, scratch) != 0) {
+        return NULL;
+    }
+
+    // split the output channels until every thread has a unit, tiles stay multiples of the gemm rows
+    uint64_t threads = sc_get_engine_thread_count();
+    a.c_tiles = (threads + a.batch - 1) / a.batch;
+    if (a.c_tiles > (a.out_c + 5) / 6) a.c_tiles = (a.out_c + 5) / 6;
+    if (a.c_tiles == 0) a.c_tiles = 1;
+    a.c_tile = (a.out_c + a.c_tiles - 1) / a.c_tiles;
+    a.c_tiles = (a.out_c + a.c_tile - 1) / a.c_tile;
+
+    uint64_t kernel_size = a.in_c * a.k_h * a.k_w;
+    uint64_t el_size = type_size(compute_type(a.type));
+
+    sc_conv_algorithm algorithm = params.algorithm;
+    if (algorithm == sc_conv_auto) {
+        int small = (kernel_size <= CONV_DIRECT_MAX_DEPTH || a.out_c <= CONV_DIRECT_MAX_CHANNELS);
+        algorithm = (small && a.stride_w == 1 && a.type != sc_float64) ? sc_conv_direct : sc_conv_im2col;
+    }
+
+    int (*kernel)(void*, uint64_t, uint64_t, uint64_t);
+    if (algorithm == sc_conv_direct && a.stride_w == 1 && a.type != sc_float64) {
+        // tiles of whole channel blocks, the weights are packed once for all the threads
+        a.c_tile = (a.c_tile + CONV_OC_BLOCK - 1) / CONV_OC_BLOCK * CONV_OC_BLOCK;
+        a.c_tiles = (a.out_c + a.c_tile - 1) / a.c_tile;
+
+        uint64_t blocks = (a.out_c + CONV_OC_BLOCK - 1) / CONV_OC_BLOCK;
+        a.packed_weight = (float*)ccb_arena_malloc(scratch, blocks * kernel_size * CONV_OC_BLOCK * sizeof(float));
+        CCB_NOTNULL(a.packed_weight, "Failed to allocate packed weights");
+        for (uint64_t oc = 0; oc < blocks * CONV_OC_BLOCK; oc++) {
+            float* dst = a.packed_weight + (oc / CONV_OC_BLOCK) * kernel_size * CONV_OC_BLOCK + oc % CONV_OC_BLOCK;
+            for (uint64_t r = 0; r < kernel_size; r++) {
+                dst[r * CONV_OC_BLOCK] = (oc < a.out_c) ? sc_load_f32(a.weight, oc * kernel_size + r, a.type) : 0.0f;
+            }
+        }
+
+        a.scratch_stride = align_up(CONV_OC_BLOCK * a.out_w * sizeof(float));
+        kernel = conv_direct_kernel;
+    } else if (algorithm == sc_conv_direct) {
+        a.scratch_stride = align_up(a.out_w * el_size);
+        kernel = conv_direct_kernel;
+    } else {
+        uint64_t positions = a.out_h * a.out_w;
+        a.chunk = CONV_COL_CHUNK_BYTES / (kernel_size * el_size);
+        a.chunk = (a.chunk < 16) ? 16 : a.chunk / 16 * 16;
+        if (a.chunk > positions) a.chunk = positions;
+        a.scratch_stride = align_up(kernel_size * a.chunk * el_size) + align_up(sc_gemm_scratch_size());
+        kernel = conv_im2col_kernel;
+    }
+
+    a.scratch = (uint8_t*)ccb_arena_malloc(scratch, threads * a.scratch_stride + CONV_ALIGN);
+    CCB_NOTNULL(a.scratch, "Failed to allocate convolution scratch");
+    a.scratch = (uint8_t*)(((uintptr_t)a.scratch + CONV_ALIGN - 1) & ~(uintptr_t)(CONV_ALIGN - 1));
+
+    uint64_t work = out->size * kernel_size;
+    if (sc_run_range_task(kernel, &a, a.batch * a.c_tiles, work, scratch) != 0) {
+        CCB_ERROR("Failed to run convolution task");
+        return NULL;
+    }
+
+    return out;
+}
+
+
+static sc_tensor* pool_forward(sc_tensor* x, sc_pool_params params, uint64_t dims_count, int max_pool, ccb_arena* arena) {
+    if (check_type(x, dims_count, "x") != 0) {
+        return NULL;
+    }
+    CCB_NOTNULL(arena, "arena is NULL");
+
+    struct conv_args a;
+    memset(&a, 0, sizeof(a));
+    a.type = x->type;
+    a.batch = x->dims->dims[0];
+    a.in_c = x->dims->dims[1];
+    a.out_c = a.in_c;
+    a.in_h = (dims_count == 4) ? x->dims->dims[2] : 1;
+    a.in_w = x->dims->dims[dims_count - 1];
+    a.k_h = (dims_count == 4) ? params.kernel_h : 1;
+    a.k_w = params.kernel_w;
+
+    a.stride_h = (dims_count == 4 && params.stride_h != 0) ? params.stride_h : a.k_h;
+    a.stride_w = (params.stride_w != 0) ? params.stride_w : a.k_w;
+    a.padding_h = (dims_count == 4) ? (int64_t)params.padding_h : 0;
+    a.padding_w = (int64_t)params.padding_w;
+    a.dilation_h = 1;
+    a.dilation_w = 1;
+    a.max_pool = max_pool;
+
+    if (2 * (uint64_t)a.padding_h > a.k_h || 2 * (uint64_t)a.padding_w > a.k_w) {
+        CCB_ERROR("Pooling padding (%" PRIu64 ", %" PRIu64 ") must be at most half of the kernel (%" PRIu64 ", %" PRIu64 ")", a.padding_h, a.padding_w, a.k_h, a.k_w);
+        return NULL;
+    }
+
+    if (output_size(a.in_h, a.k_h, a.stride_h, (uint64_t)a.padding_h, 1, &a.out_h) != 0 ||
+        output_size(a.in_w, a.k_w, a.stride_w, (uint64_t)a.padding_w, 1, &a.out_w) != 0) {
+        return NULL;
+    }
+
+    sc_tensor* out = create_output(dims_count, a.batch, a.in_c, a.out_h, a.out_w, x->type, arena);
+    if (out == NULL || out->size == 0) {
+        return out;
+    }
+
+    a.x = x->data;
+    a.y = out->data;
+
+    if (setup_columns(&a, arena) != 0) {
+        return NULL;
+    }
+
+    uint64_t threads = sc_get_engine_thread_count();
+    a.scratch_stride = align_up(a.out_w * type_size(compute_type(a.type)));
+    a.scratch = (uint8_t*)ccb_arena_malloc(arena, threads * a.scratch_stride + CONV_ALIGN);
+    CCB_NOTNULL(a.scratch, "Failed to allocate pooling scratch");
+    a.scratch = (uint8_t*)(((uintptr_t)a.scratch + CONV_ALIGN - 1) & ~(uintptr_t)(CONV_ALIGN - 1));
+
+    if (sc_run_range_task(pool_kernel, &a, a.batch * a.in_c, out->size * a.k_h * a.k_w, arena) != 0) {
+        CCB_ERROR("Failed to run pooling task");
+        return NULL;
+    }
+
+    return out;
+}
+
+
+// #######
+// api
+// #######
+
+sc_tensor* sc_conv2d(sc_tensor* x, sc_tensor* weight, sc_vector* bias, sc_conv_params params, ccb_arena* scratch, ccb_arena* arena) {
+    return conv_forward(x, weight, bias, params, 4, scratch, arena);
+}
+
+sc_tensor* sc_conv1d(sc_tensor* x, sc_tensor* weight, sc_vector* bias, sc_conv_params params, ccb_arena* scratch, ccb_arena* arena) {
+    return conv_forward(x, weight, bias, params, 3, scratch, arena);
+}
+
+sc_tensor* sc_max_pool2d(sc_tensor* x, sc_pool_params params, ccb_arena* arena) {
+    return pool_forward(x, params, 4, 1, arena);
+}
+
+sc_tensor* sc_avg_pool2d(sc_tensor* x, sc_pool_params params, ccb_arena* arena) {
+    return pool_forward(x, params, 4, 0, arena);
+}
+
+sc_tensor* sc_max_pool1d(sc_tensor* x, sc_pool_params params, ccb_arena* arena) {
+    return pool_forward(x, params, 3, 1, arena);
+}
+
+sc_tensor* sc_avg_pool1d(sc_tensor* x, sc_pool_params params, ccb_arena* arena) {
+    return pool_forward(x, params, 3, 0, arena);
+}
@@ -0,0 +1,99 @@
+#ifndef __CONV_H__
+#define __CONV_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    convolution and pooling kernels for neural networks, tensors are channels first:
+    1d: x [batch, channels, length], weight [out_channels, in_channels, kernel]
+    2d: x [batch, channels, height, width], weight [out_channels, in_channels, kernel_h, kernel_w]
+    the work is split over batch x output channel tiles and run on the engine thread pool
+    float32 and bfloat16 inputs are accumulated in float32, float64 inputs in float64
+*/
+
+typedef enum {
+    sc_conv_auto,   // direct kernel for small filters or few output channels, im2col + gemm otherwise
+    sc_conv_direct,
+    sc_conv_im2col,
+} sc_conv_algorithm;
+
+/*
+    convolution parameters, a stride or a dilation of 0 is read as 1
+    1d convolutions only use the _w fields
+*/
+typedef struct {
+    uint64_t stride_h;
+    uint64_t stride_w;
+    uint64_t padding_h;
+    uint64_t padding_w;
+    uint64_t dilation_h;
+    uint64_t dilation_w;
+    sc_conv_algorithm algorithm;
+} sc_conv_params;
+
+/*
+    pooling parameters, a stride of 0 is read as the kernel size
+    the padding must be at most half of the kernel, padded values are ignored (avg divides by the valid count)
+    1d pooling only use the _w fields
+*/
+typedef struct {
+    uint64_t kernel_h;
+    uint64_t kernel_w;
+    uint64_t stride_h;
+    uint64_t stride_w;
+    uint64_t padding_h;
+    uint64_t padding_w;
+} sc_pool_params;
+
+#define sc_conv1d_params(stride, padding, dilation) ((sc_conv_params){1, (stride), 0, (padding), 1, (dilation), sc_conv_auto})
+#define sc_conv2d_params(stride, padding, dilation) ((sc_conv_params){(stride), (stride), (padding), (padding), (dilation), (dilation), sc_conv_auto})
+#define sc_pool1d_params(kernel, stride, padding) ((sc_pool_params){1, (kernel), 1, (stride), 0, (padding)})
+#define sc_pool2d_params(kernel, stride, padding) ((sc_pool_params){(kernel), (kernel), (stride), (stride), (padding), (padding)})
+
+
+/* 2D convolution (cross-correlation) of a batch of images
+   - sc_tensor* x: input tensor [batch, in_channels, height, width]
+   - sc_tensor* weight: filters [out_channels, in_channels, kernel_h, kernel_w], same type as x
+   - sc_vector* bias: bias per output channel (same type as x), NULL for 0
+   - sc_conv_params params: stride, padding, dilation and algorithm
+   - ccb_arena* scratch: arena where the task and the per thread buffers (im2col columns) will be allocated
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the result tensor [batch, out_channels, out_height, out_width]
+*/
+sc_tensor* sc_conv2d(sc_tensor* x, sc_tensor* weight, sc_vector* bias, sc_conv_params params, ccb_arena* scratch, ccb_arena* arena);
+/* 1D convolution (cross-correlation) of a batch of sequences
+   - sc_tensor* x: input tensor [batch, in_channels, length]
+   - sc_tensor* weight: filters [out_channels, in_channels, kernel], same type as x
+   - same other arguments as sc_conv2d
+   - return: a pointer to the result tensor [batch, out_channels, out_length]
+*/
+sc_tensor* sc_conv1d(sc_tensor* x, sc_tensor* weight, sc_vector* bias, sc_conv_params params, ccb_arena* scratch, ccb_arena* arena);
+
+/* 2D max pooling of each channel
+   - sc_tensor* x: input tensor [batch, channels, height, width]
+   - sc_pool_params params: kernel, stride and padding
+   - ccb_arena* arena: arena where the result and the scratch will be allocated
+   - return: a pointer to the result tensor [batch, channels, out_height, out_width]
+*/
+sc_tensor* sc_max_pool2d(sc_tensor* x, sc_pool_params params, ccb_arena* arena);
+/* 2D average pooling of each channel, padded values are not counted
+   - same arguments as sc_max_pool2d
+   - return: a pointer to the result tensor [batch, channels, out_height, out_width]
+*/
+sc_tensor* sc_avg_pool2d(sc_tensor* x, sc_pool_params params, ccb_arena* arena);
+/* 1D max pooling of each channel
+   - sc_tensor* x: input tensor [batch, channels, length]
+   - same other arguments as sc_max_pool2d
+   - return: a pointer to the result tensor [batch, channels, out_length]
+*/
+sc_tensor* sc_max_pool1d(sc_tensor* x, sc_pool_params params, ccb_arena* arena);
+/* 1D average pooling of each channel, padded values are not counted
+   - same arguments as sc_max_pool1d
+   - return: a pointer to the result tensor [batch, channels, out_length]
+*/
+sc_tensor* sc_avg_pool1d(sc_tensor* x, sc_pool_params params, ccb_arena* arena);
+
+
+#endif // __CONV_H__
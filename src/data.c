@@ -1,19 +1,90 @@
 #include "data.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
 #include "const.h"
 #include "ccbase/logs/log.h"
 
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <fenv.h>
 
 
 char** sc_TYPES_NAMES = (char*[]) {
     "float16",
     "float32",
-    "float64"
+    "float64",
+    "half",
+    "int32",
+    "int64",
+    "uint8"
 };
 
 
 
+// Types
+uint64_t sc_type_size(sc_TYPES type) {
+    switch (type) {
+        case sc_uint8:
+            return 1;
+        case sc_float16:
+        case sc_half:
+            return 2;
+        case sc_float32:
+        case sc_int32:
+            return 4;
+        case sc_float64:
+        case sc_int64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+
+int sc_type_is_integer(sc_TYPES type) {
+    return type == sc_int32 || type == sc_int64 || type == sc_uint8;
+}
+
+
+// floating point to integer: round to nearest even, saturate to the range of the type, NaN gives 0
+static int64_t round_to_int64(double value, double lo, double hi) {
+    if (value != value) {
+        return 0;
+    }
+    value = nearbyint(value);
+    if (value <= lo) {
+        return (lo <= -9223372036854775808.0) ? INT64_MIN : (int64_t)lo;
+    }
+    if (value >= hi) {
+        return (hi >= 9223372036854775807.0) ? INT64_MAX : (int64_t)hi;
+    }
+    return (int64_t)value;
+}
+
+static sc_value_t int_to_sc_value(int64_t value, sc_TYPES type) {
+    sc_value_t scalar;
+    scalar.type = type;
+    switch (type) {
+        case sc_int32:
+            scalar.value.i32 = (value < INT32_MIN) ? INT32_MIN : ((value > INT32_MAX) ? INT32_MAX : (int32_t)value);
+            break;
+        case sc_int64:
+            scalar.value.i64 = value;
+            break;
+        case sc_uint8:
+            scalar.value.u8 = (value < 0) ? 0 : ((value > UINT8_MAX) ? UINT8_MAX : (uint8_t)value);
+            break;
+        default:
+            CCB_ERROR("Unsupported sc_TYPES value %d", type);
+            scalar.type = -1; // Invalid type
+            break;
+    }
+    return scalar;
+}
+
+
+
 // Create data structures
 sc_dimensions* sc_create_empty_dimensions(uint64_t dims_count, ccb_arena* arena) {
     sc_dimensions* dimensions = (sc_dimensions*)ccb_arena_malloc(arena, sizeof(sc_dimensions));
@@ -59,20 +130,10 @@ sc_vector* sc_create_vector(uint64_t size, sc_TYPES type, ccb_arena* arena) {
     vector->size = size;
     vector->type = type;
 
-    size_t type_size;
-    switch (type) {
-        case sc_float16:
-            type_size = 2;
-            break;
-        case sc_float32:
-            type_size = 4;
-            break;
-        case sc_float64:
-            type_size = 8;
-            break;
-        default:
-            CCB_ERROR("Unsupported sc_TYPES value %d", type);
-            return NULL;
+    size_t type_size = sc_type_size(type);
+    if (type_size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", type);
+        return NULL;
     }
 
     vector->data = ccb_arena_malloc(arena, size * type_size);
@@ -146,20 +207,10 @@ sc_tensor* sc_create_tensor(sc_dimensions* dims, sc_TYPES type, ccb_arena* arena
 
     tensor->type = type;
 
-    size_t type_size;
-    switch (type) {
-        case sc_float16:
-            type_size = 2;
-            break;
-        case sc_float32:
-            type_size = 4;
-            break;
-        case sc_float64:
-            type_size = 8;
-            break;
-        default:
-            CCB_ERROR("Unsupported sc_TYPES value %d", type);
-            return NULL;
+    size_t type_size = sc_type_size(type);
+    if (type_size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", type);
+        return NULL;
     }
     tensor->dims = dims;
 
@@ -177,20 +228,10 @@ sc_vector* sc_clone_vector(sc_vector* vector, ccb_arena* arena) {
     clone->size = vector->size;
     clone->type = vector->type;
 
-    size_t type_size;
-    switch (vector->type) {
-        case sc_float16:
-            type_size = 2;
-            break;
-        case sc_float32:
-            type_size = 4;
-            break;
-        case sc_float64:
-            type_size = 8;
-            break;
-        default:
-            CCB_ERROR("Unsupported sc_TYPES value %d", vector->type);
-            return NULL;
+    size_t type_size = sc_type_size(vector->type);
+    if (type_size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", vector->type);
+        return NULL;
     }
 
     clone->data = ccb_arena_malloc(arena, vector->size * type_size);
@@ -211,20 +252,10 @@ sc_tensor* sc_clone_tensor(sc_tensor* tensor, ccb_arena* arena) {
     clone->dims = sc_clone_dimensions(tensor->dims, arena);
     CCB_NOTNULL(clone->dims, "Failed to clone dimensions");
 
-    size_t type_size;
-    switch (tensor->type) {
-        case sc_float16:
-            type_size = 2;
-            break;
-        case sc_float32:
-            type_size = 4;
-            break;
-        case sc_float64:
-            type_size = 8;
-            break;
-        default:
-            CCB_ERROR("Unsupported sc_TYPES value %d", tensor->type);
-            return NULL;
+    size_t type_size = sc_type_size(tensor->type);
+    if (type_size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", tensor->type);
+        return NULL;
     }
 
     clone->data = ccb_arena_malloc(arena, tensor->size * type_size);
@@ -280,20 +311,10 @@ sc_dimensions* sc_clone_dimensions(sc_dimensions* dimensions, ccb_arena* arena)
 
 // Load data
 void sc_data_to_vector(sc_vector* vector, void* data, uint64_t size) {
-    size_t type_size;
-    switch (vector->type) {
-        case sc_float16:
-            type_size = 2;
-            break;
-        case sc_float32:
-            type_size = 4;
-            break;
-        case sc_float64:
-            type_size = 8;
-            break;
-        default:
-            CCB_ERROR("Unsupported sc_TYPES value %d", vector->type);
-            return;
+    size_t type_size = sc_type_size(vector->type);
+    if (type_size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", vector->type);
+        return;
     }
 
     if (size > vector->size) {
@@ -311,20 +332,10 @@ void sc_data_to_vector(sc_vector* vector, void* data, uint64_t size) {
 
 
 void sc_data_to_tensor(sc_tensor* tensor, void* data, uint64_t size) {
-    size_t type_size;
-    switch (tensor->type) {
-        case sc_float16:
-            type_size = 2;
-            break;
-        case sc_float32:
-            type_size = 4;
-            break;
-        case sc_float64:
-            type_size = 8;
-            break;
-        default:
-            CCB_ERROR("Unsupported sc_TYPES value %d", tensor->type);
-            return;
+    size_t type_size = sc_type_size(tensor->type);
+    if (type_size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", tensor->type);
+        return;
     }
 
     if (size > tensor->size) {
@@ -344,20 +355,10 @@ void sc_data_to_tensor(sc_tensor* tensor, void* data, uint64_t size) {
 
 // Print functions
 void sc_print_vector(sc_vector* vector) {
-    size_t type_size;
-    switch (vector->type) {
-        case sc_float16:
-            type_size = 2;
-            break;
-        case sc_float32:
-            type_size = 4;
-            break;
-        case sc_float64:
-            type_size = 8;
-            break;
-        default:
-            CCB_ERROR("Unsupported sc_TYPES value %d", vector->type);
-            return;
+    size_t type_size = sc_type_size(vector->type);
+    if (type_size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", vector->type);
+        return;
     }
 
     printf("Vector (size: %u, type: %s):\n", vector->size, sc_TYPES_NAMES[vector->type]);
@@ -368,6 +369,15 @@ void sc_print_vector(sc_vector* vector) {
         } else if (vector->type == sc_float64) {
             double* data = (double*)vector->data;
             printf("  [%u]: %lf\n", i, data[i]);
+        } else if (vector->type == sc_int32) {
+            printf("  [%u]: %d\n", i, ((int32_t*)vector->data)[i]);
+        } else if (vector->type == sc_int64) {
+            printf("  [%u]: %lld\n", i, (long long)((int64_t*)vector->data)[i]);
+        } else if (vector->type == sc_uint8) {
+            printf("  [%u]: %u\n", i, ((uint8_t*)vector->data)[i]);
+        } else if (vector->type == sc_half) {
+            uint16_t* data = (uint16_t*)vector->data;
+            printf("  [%u]: %f\n", i, sc_half_bits_to_f32(data[i]));
         } else if (vector->type == sc_float16) {
             __bf16* data = (__bf16*)vector->data;
             printf("  [%u]: %f\n", i, (float)data[i]);
@@ -379,20 +389,10 @@ void sc_print_vector(sc_vector* vector) {
 
 
 void sc_print_tensor(sc_tensor* tensor, ccb_arena* tmp_arena) {
-    size_t type_size;
-    switch (tensor->type) {
-        case sc_float16:
-            type_size = 2;
-            break;
-        case sc_float32:
-            type_size = 4;
-            break;
-        case sc_float64:
-            type_size = 8;
-            break;
-        default:
-            CCB_ERROR("Unsupported sc_TYPES value %d", tensor->type);
-            return;
+    size_t type_size = sc_type_size(tensor->type);
+    if (type_size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", tensor->type);
+        return;
     }
 
     sc_index index;
@@ -431,6 +431,15 @@ void sc_print_tensor(sc_tensor* tensor, ccb_arena* tmp_arena) {
         } else if (tensor->type == sc_float64) {
             double* data = (double*)tensor->data;
             printf("%lf\n", data[i]);
+        } else if (tensor->type == sc_int32) {
+            printf("%d\n", ((int32_t*)tensor->data)[i]);
+        } else if (tensor->type == sc_int64) {
+            printf("%lld\n", (long long)((int64_t*)tensor->data)[i]);
+        } else if (tensor->type == sc_uint8) {
+            printf("%u\n", ((uint8_t*)tensor->data)[i]);
+        } else if (tensor->type == sc_half) {
+            uint16_t* data = (uint16_t*)tensor->data;
+            printf("%lf\n", sc_half_bits_to_f32(data[i]));
         } else if (tensor->type == sc_float16) {
             __bf16* data = (__bf16*)tensor->data;
             printf("%lf\n", (float)data[i]);
@@ -495,12 +504,24 @@ sc_value_t to_sc_value(double value, sc_TYPES type) {
         case sc_float16:
             scalar.value.f16 = (__bf16)value;
             break;
+        case sc_half:
+            scalar.value.half = sc_f32_to_half_bits((float)value);
+            break;
         case sc_float32:
             scalar.value.f32 = (float)value;
             break;
         case sc_float64:
             scalar.value.f64 = value;
             break;
+        case sc_int32:
+            scalar.value.i32 = (int32_t)round_to_int64(value, INT32_MIN, INT32_MAX);
+            break;
+        case sc_int64:
+            scalar.value.i64 = round_to_int64(value, -9223372036854775808.0, 9223372036854775807.0);
+            break;
+        case sc_uint8:
+            scalar.value.u8 = (uint8_t)round_to_int64(value, 0, UINT8_MAX);
+            break;
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", type);
             scalar.type = -1; // Invalid type
@@ -518,6 +539,14 @@ __bf16 sc_value_to_f16(sc_value_t value) {
             return (__bf16)value.value.f32;
         case sc_float64:
             return (__bf16)value.value.f64;
+        case sc_half:
+            return (__bf16)sc_half_bits_to_f32(value.value.half);
+        case sc_int32:
+            return (__bf16)(float)value.value.i32;
+        case sc_int64:
+            return (__bf16)(float)value.value.i64;
+        case sc_uint8:
+            return (__bf16)(float)value.value.u8;
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", value.type);
             return (__bf16)0.0; // Default return value
@@ -525,6 +554,29 @@ __bf16 sc_value_to_f16(sc_value_t value) {
 }
 
 
+uint16_t sc_value_to_half(sc_value_t value) {
+    switch (value.type) {
+        case sc_float16:
+            return sc_f32_to_half_bits((float)value.value.f16);
+        case sc_float32:
+            return sc_f32_to_half_bits(value.value.f32);
+        case sc_float64:
+            return sc_f32_to_half_bits((float)value.value.f64);
+        case sc_half:
+            return value.value.half;
+        case sc_int32:
+            return sc_f32_to_half_bits((float)value.value.i32);
+        case sc_int64:
+            return sc_f32_to_half_bits((float)value.value.i64);
+        case sc_uint8:
+            return sc_f32_to_half_bits((float)value.value.u8);
+        default:
+            CCB_ERROR("Unsupported sc_TYPES value %d", value.type);
+            return 0; // Default return value
+    }
+}
+
+
 float sc_value_to_f32(sc_value_t value) {
     switch (value.type) {
         case sc_float16:
@@ -533,6 +585,14 @@ float sc_value_to_f32(sc_value_t value) {
             return value.value.f32;
         case sc_float64:
             return (float)value.value.f64;
+        case sc_half:
+            return sc_half_bits_to_f32(value.value.half);
+        case sc_int32:
+            return (float)value.value.i32;
+        case sc_int64:
+            return (float)value.value.i64;
+        case sc_uint8:
+            return (float)value.value.u8;
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", value.type);
             return 0.0f; // Default return value
@@ -548,6 +608,14 @@ double sc_value_to_f64(sc_value_t value) {
             return (double)value.value.f32;
         case sc_float64:
             return value.value.f64;
+        case sc_half:
+            return (double)sc_half_bits_to_f32(value.value.half);
+        case sc_int32:
+            return (double)value.value.i32;
+        case sc_int64:
+            return (double)value.value.i64;
+        case sc_uint8:
+            return (double)value.value.u8;
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", value.type);
             return 0.0; // Default return value
@@ -555,12 +623,477 @@ double sc_value_to_f64(sc_value_t value) {
 }
 
 
+int64_t sc_value_to_i64(sc_value_t value) {
+    switch (value.type) {
+        case sc_int32:
+            return value.value.i32;
+        case sc_int64:
+            return value.value.i64;
+        case sc_uint8:
+            return value.value.u8;
+        default:
+            return round_to_int64(sc_value_to_f64(value), -9223372036854775808.0, 9223372036854775807.0);
+    }
+}
+
+
+int32_t sc_value_to_i32(sc_value_t value) {
+    return int_to_sc_value(sc_value_to_i64(value), sc_int32).value.i32;
+}
+
+
+uint8_t sc_value_to_u8(sc_value_t value) {
+    return int_to_sc_value(sc_value_to_i64(value), sc_uint8).value.u8;
+}
+
+
 sc_value_t sc_value_as(sc_value_t a, sc_TYPES target_type) {
+    if (sc_type_is_integer(a.type) && sc_type_is_integer(target_type)) {
+        // int64 values do not fit in a double
+        return int_to_sc_value(sc_value_to_i64(a), target_type);
+    }
     double value = sc_value_to_f64(a); // Convert to double first for precision
     return to_sc_value(value, target_type);
 }
 
 
+// half precision bulk conversions
+static SC_TARGET_F16C void convert_half_to_f32_f16c(const uint16_t* src, float* dst, uint64_t count) {
+    uint64_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm256_storeu_ps(dst + i, sc_load_half_f16c(src + i));
+        _mm256_storeu_ps(dst + i + 8, sc_load_half_f16c(src + i + 8));
+    }
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dst + i, sc_load_half_f16c(src + i));
+    }
+    for (; i < count; i++) {
+        dst[i] = sc_half_bits_to_f32(src[i]);
+    }
+}
+
+static SC_TARGET_F16C void convert_f32_to_half_f16c(const float* src, uint16_t* dst, uint64_t count) {
+    uint64_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        sc_store_half_f16c(dst + i, _mm256_loadu_ps(src + i));
+        sc_store_half_f16c(dst + i + 8, _mm256_loadu_ps(src + i + 8));
+    }
+    for (; i + 8 <= count; i += 8) {
+        sc_store_half_f16c(dst + i, _mm256_loadu_ps(src + i));
+    }
+    for (; i < count; i++) {
+        dst[i] = sc_f32_to_half_bits(src[i]);
+    }
+}
+
+void sc_convert_half_to_f32(const uint16_t* src, float* dst, uint64_t count) {
+    if (sc_has_f16c()) {
+        convert_half_to_f32_f16c(src, dst, count);
+        return;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        dst[i] = sc_half_bits_to_f32(src[i]);
+    }
+}
+
+void sc_convert_f32_to_half(const float* src, uint16_t* dst, uint64_t count) {
+    if (sc_has_f16c()) {
+        convert_f32_to_half_f16c(src, dst, count);
+        return;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        dst[i] = sc_f32_to_half_bits(src[i]);
+    }
+}
+
+
+// bulk casts between all the types
+// the hardware conversions (cvtps2dq, cvtpd2ps, vcvtps2ph...) follow the MXCSR rounding mode, which the
+// casts set for their duration, the bit level conversions to bfloat16 / half receive the mode explicitly
+
+static int fenv_rounding(sc_rounding_mode mode) {
+    switch (mode) {
+        case sc_round_toward_zero: return FE_TOWARDZERO;
+        case sc_round_down:        return FE_DOWNWARD;
+        case sc_round_up:          return FE_UPWARD;
+        default:                   return FE_TONEAREST;
+    }
+}
+
+static inline uint16_t f32_to_bf16_mode(float value, sc_rounding_mode mode) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    if (mode == sc_round_nearest_even || (bits & 0x7fffffff) > 0x7f800000) {
+        return sc_f32_to_bf16_bits(value);
+    }
+
+    // truncation, then one step away from zero when the discarded bits go in the direction of the mode
+    uint16_t out = (uint16_t)(bits >> 16);
+    int negative = (bits >> 31) != 0;
+    if ((bits & 0xffff) != 0 && ((mode == sc_round_up && !negative) || (mode == sc_round_down && negative))) {
+        out++;
+    }
+    return out;
+}
+
+static inline uint16_t f32_to_half_mode(float value, sc_rounding_mode mode) {
+    uint16_t out = sc_f32_to_half_bits(value);
+    if (mode == sc_round_nearest_even || value != value) {
+        return out;
+    }
+
+    // fix the nearest even result, the encoding is monotonic in magnitude for a given sign
+    // (this also turns an overflow to infinity into the largest finite value when the mode requires it)
+    float rounded = sc_half_bits_to_f32(out);
+    int negative = (out & 0x8000) != 0;
+    if (mode == sc_round_toward_zero && fabsf(rounded) > fabsf(value)) {
+        out--;
+    } else if (mode == sc_round_down && rounded > value) {
+        out = negative ? out + 1 : out - 1;
+    } else if (mode == sc_round_up && rounded < value) {
+        out = negative ? out - 1 : out + 1;
+    }
+    return out;
+}
+
+// float64 -> float32 rounded to odd: an inexact result is truncated and keeps its last bit set, so that rounding it
+// again to nearest bfloat16 or half (at least 2 bits narrower) gives the result of rounding the double directly
+static inline float f64_to_f32_odd(double value) {
+    float out = (float)value;
+    if ((double)out == value || value != value) {
+        return out;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &out, sizeof(float));
+    if (fabs((double)out) > fabs(value)) {
+        bits--;
+    }
+    bits |= 1;
+    memcpy(&out, &bits, sizeof(float));
+    return out;
+}
+
+static inline double load_f64(const void* src, sc_TYPES type, uint64_t i) {
+    switch (type) {
+        case sc_float16: return sc_bf16_bits_to_f32(((const uint16_t*)src)[i]);
+        case sc_half:    return sc_half_bits_to_f32(((const uint16_t*)src)[i]);
+        case sc_float32: return ((const float*)src)[i];
+        case sc_float64: return ((const double*)src)[i];
+        case sc_int32:   return ((const int32_t*)src)[i];
+        case sc_int64:   return (double)((const int64_t*)src)[i];
+        case sc_uint8:   return ((const uint8_t*)src)[i];
+        default:         return 0.0;
+    }
+}
+
+static inline int64_t load_i64(const void* src, sc_TYPES type, uint64_t i) {
+    switch (type) {
+        case sc_int32: return ((const int32_t*)src)[i];
+        case sc_int64: return ((const int64_t*)src)[i];
+        case sc_uint8: return ((const uint8_t*)src)[i];
+        default:       return 0;
+    }
+}
+
+// the directed modes compose, so the 16 bits types narrow to float32 under the current rounding mode first,
+// round to nearest goes through float32 rounded to odd to avoid rounding twice
+static inline void store_f64(void* dst, sc_TYPES type, uint64_t i, double value, sc_rounding_mode mode) {
+    float narrow = (mode == sc_round_nearest_even) ? f64_to_f32_odd(value) : (float)value;
+    switch (type) {
+        case sc_float16: ((uint16_t*)dst)[i] = f32_to_bf16_mode(narrow, mode); break;
+        case sc_half:    ((uint16_t*)dst)[i] = f32_to_half_mode(narrow, mode); break;
+        case sc_float32: ((float*)dst)[i] = (float)value; break;
+        case sc_float64: ((double*)dst)[i] = value; break;
+        case sc_int32:   ((int32_t*)dst)[i] = (int32_t)round_to_int64(value, INT32_MIN, INT32_MAX); break;
+        case sc_int64:   ((int64_t*)dst)[i] = round_to_int64(value, -9223372036854775808.0, 9223372036854775807.0); break;
+        case sc_uint8:   ((uint8_t*)dst)[i] = (uint8_t)round_to_int64(value, 0, UINT8_MAX); break;
+        default:         break;
+    }
+}
+
+static inline void store_i64(void* dst, sc_TYPES type, uint64_t i, int64_t value) {
+    switch (type) {
+        case sc_int32: ((int32_t*)dst)[i] = int_to_sc_value(value, sc_int32).value.i32; break;
+        case sc_int64: ((int64_t*)dst)[i] = value; break;
+        case sc_uint8: ((uint8_t*)dst)[i] = int_to_sc_value(value, sc_uint8).value.u8; break;
+        default:       break;
+    }
+}
+
+// float32 -> int32 / uint8 saturate like to_sc_value
+static inline __m256 f32x8_clear_nan(__m256 value) {
+    return _mm256_and_ps(value, _mm256_cmp_ps(value, value, _CMP_ORD_Q));
+}
+
+static inline __m256i f32x8_to_i32(__m256 value) {
+    value = f32x8_clear_nan(value);
+    __m256 overflow = _mm256_cmp_ps(value, _mm256_set1_ps(2147483648.0f), _CMP_GE_OQ);
+    __m256i out = _mm256_cvtps_epi32(value); // 0x80000000 when out of range
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(out), _mm256_castsi256_ps(_mm256_set1_epi32(INT32_MAX)), overflow));
+}
+
+static inline __m128i f32x8_to_u8(__m256 value) {
+    value = _mm256_min_ps(_mm256_max_ps(f32x8_clear_nan(value), _mm256_setzero_ps()), _mm256_set1_ps(255.0f));
+    __m256i wide = _mm256_cvtps_epi32(value);
+    __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(wide), _mm256_extractf128_si256(wide, 1));
+    return _mm_packus_epi16(words, words);
+}
+
+static inline __m256 u8x8_to_f32(const uint8_t* src) {
+    __m128i raw = _mm_loadl_epi64((const __m128i*)src);
+    __m128i lo = _mm_cvtepu8_epi32(raw);
+    __m128i hi = _mm_cvtepu8_epi32(_mm_srli_si128(raw, 4));
+    return _mm256_cvtepi32_ps(_mm256_set_m128i(hi, lo));
+}
+
+static inline __m128i f64x4_to_i32(__m256d value) {
+    value = _mm256_and_pd(value, _mm256_cmp_pd(value, value, _CMP_ORD_Q));
+    value = _mm256_min_pd(_mm256_max_pd(value, _mm256_set1_pd(-2147483648.0)), _mm256_set1_pd(2147483647.0));
+    return _mm256_cvtpd_epi32(value);
+}
+
+static inline __m128i mask64x4_to_32x4(__m256d mask) {
+    __m128 lo = _mm_castpd_ps(_mm256_castpd256_pd128(mask));
+    __m128 hi = _mm_castpd_ps(_mm256_extractf128_pd(mask, 1));
+    return _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+// same as f64_to_f32_odd on 4 lanes
+static inline __m128 f64x4_to_f32_odd(__m256d value) {
+    __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(INT64_MAX));
+    __m128 out = _mm256_cvtpd_ps(value);
+    __m256d back = _mm256_cvtps_pd(out);
+    __m128i above = mask64x4_to_32x4(_mm256_cmp_pd(_mm256_and_pd(back, abs_mask), _mm256_and_pd(value, abs_mask), _CMP_GT_OQ));
+    __m128i inexact = mask64x4_to_32x4(_mm256_cmp_pd(back, value, _CMP_NEQ_OQ));
+    __m128i bits = _mm_add_epi32(_mm_castps_si128(out), above);
+    return _mm_castsi128_ps(_mm_or_si128(bits, _mm_and_si128(inexact, _mm_set1_epi32(1))));
+}
+
+// same as f32_to_bf16_mode on 4 lanes
+static inline __m128i f32x4_to_bf16(__m128 value, sc_rounding_mode mode) {
+    __m128i bits = _mm_castps_si128(value);
+    __m128i truncated = _mm_srli_epi32(bits, 16);
+    __m128i out = truncated;
+
+    if (mode == sc_round_nearest_even) {
+        __m128i lsb = _mm_and_si128(truncated, _mm_set1_epi32(1));
+        out = _mm_srli_epi32(_mm_add_epi32(bits, _mm_add_epi32(lsb, _mm_set1_epi32(0x7fff))), 16);
+    } else if (mode != sc_round_toward_zero) {
+        __m128i inexact = _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(bits, _mm_set1_epi32(0xffff)), _mm_setzero_si128()), _mm_set1_epi32(-1));
+        __m128i negative = _mm_srai_epi32(bits, 31);
+        __m128i step = (mode == sc_round_up) ? _mm_andnot_si128(negative, inexact) : _mm_and_si128(negative, inexact);
+        out = _mm_sub_epi32(truncated, step);
+    }
+
+    __m128i nan = _mm_castps_si128(_mm_cmpunord_ps(value, value));
+    return _mm_blendv_epi8(out, _mm_or_si128(truncated, _mm_set1_epi32(0x0040)), nan);
+}
+
+static SC_TARGET_F16C uint64_t f32_to_half_f16c_current(const float* src, uint16_t* dst, uint64_t count) {
+    uint64_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i out = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_CUR_DIRECTION);
+        _mm_storeu_si128((__m128i*)(dst + i), out);
+    }
+    return i;
+}
+
+#define CAST_CHUNK 256
+
+// vectorised pairs, returns the number of elements converted (the caller finishes the tail)
+static uint64_t convert_simd(const void* src, sc_TYPES src_type, void* dst, sc_TYPES dst_type, uint64_t count, sc_rounding_mode mode) {
+    uint64_t i = 0;
+    if (src_type == sc_float32 && dst_type == sc_int32) {
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_si256((__m256i*)((int32_t*)dst + i), f32x8_to_i32(_mm256_loadu_ps((const float*)src + i)));
+        }
+    } else if (src_type == sc_int32 && dst_type == sc_float32) {
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps((float*)dst + i, _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)((const int32_t*)src + i))));
+        }
+    } else if (src_type == sc_float32 && dst_type == sc_uint8) {
+        for (; i + 8 <= count; i += 8) {
+            _mm_storel_epi64((__m128i*)((uint8_t*)dst + i), f32x8_to_u8(_mm256_loadu_ps((const float*)src + i)));
+        }
+    } else if (src_type == sc_uint8 && dst_type == sc_float32) {
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps((float*)dst + i, u8x8_to_f32((const uint8_t*)src + i));
+        }
+    } else if (src_type == sc_float64 && dst_type == sc_int32) {
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_si128((__m128i*)((int32_t*)dst + i), f64x4_to_i32(_mm256_loadu_pd((const double*)src + i)));
+        }
+    } else if (src_type == sc_int32 && dst_type == sc_float64) {
+        for (; i + 4 <= count; i += 4) {
+            _mm256_storeu_pd((double*)dst + i, _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)((const int32_t*)src + i))));
+        }
+    } else if (src_type == sc_float32 && dst_type == sc_float64) {
+        for (; i + 4 <= count; i += 4) {
+            _mm256_storeu_pd((double*)dst + i, _mm256_cvtps_pd(_mm_loadu_ps((const float*)src + i)));
+        }
+    } else if (src_type == sc_float64 && dst_type == sc_float32) {
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps((float*)dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd((const double*)src + i)));
+        }
+    } else if (src_type == sc_float16 && dst_type == sc_float32) {
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps((float*)dst + i, sc_load_bf16x8((const uint16_t*)src + i));
+        }
+    } else if (src_type == sc_float32 && dst_type == sc_float16) {
+        for (; i + 8 <= count; i += 8) {
+            __m128i lo = f32x4_to_bf16(_mm_loadu_ps((const float*)src + i), mode);
+            __m128i hi = f32x4_to_bf16(_mm_loadu_ps((const float*)src + i + 4), mode);
+            _mm_storeu_si128((__m128i*)((uint16_t*)dst + i), _mm_packus_epi32(lo, hi));
+        }
+    } else if (src_type == sc_half && dst_type == sc_float32) {
+        sc_convert_half_to_f32((const uint16_t*)src, (float*)dst, count);
+        i = count;
+    } else if (src_type == sc_float32 && dst_type == sc_half) {
+        if (sc_has_f16c()) {
+            i = f32_to_half_f16c_current((const float*)src, (uint16_t*)dst, count);
+        }
+    } else if (!sc_type_is_integer(src_type) && !sc_type_is_integer(dst_type)) {
+        // the other floating point pairs go through float32 (exact for the 16 bits types, rounded to odd from float64
+        // in nearest mode) in chunks
+        float chunk[CAST_CHUNK];
+        uint64_t src_size = sc_type_size(src_type);
+        uint64_t dst_size = sc_type_size(dst_type);
+        for (; i + CAST_CHUNK <= count; i += CAST_CHUNK) {
+            const uint8_t* src_at = (const uint8_t*)src + i * src_size;
+            uint8_t* dst_at = (uint8_t*)dst + i * dst_size;
+            uint64_t done = 0;
+            if (src_type == sc_float64 && mode == sc_round_nearest_even) {
+                for (; done < CAST_CHUNK; done += 4) {
+                    _mm_storeu_ps(chunk + done, f64x4_to_f32_odd(_mm256_loadu_pd((const double*)src_at + done)));
+                }
+            } else {
+                done = convert_simd(src_at, src_type, chunk, sc_float32, CAST_CHUNK, mode);
+            }
+            for (; done < CAST_CHUNK; done++) {
+                chunk[done] = (float)load_f64(src_at, src_type, done);
+            }
+            done = convert_simd(chunk, sc_float32, dst_at, dst_type, CAST_CHUNK, mode);
+            for (; done < CAST_CHUNK; done++) {
+                store_f64(dst_at, dst_type, done, chunk[done], mode);
+            }
+        }
+    }
+    return i;
+}
+
+static int convert_buffer(const void* src, sc_TYPES src_type, void* dst, sc_TYPES dst_type, uint64_t count, sc_rounding_mode mode) {
+    if (sc_type_size(src_type) == 0 || sc_type_size(dst_type) == 0) {
+        CCB_ERROR("Unsupported cast from %d to %d", src_type, dst_type);
+        return -1;
+    }
+    if (src_type == dst_type) {
+        memmove(dst, src, count * sc_type_size(src_type));
+        return 0;
+    }
+
+    uint64_t i = convert_simd(src, src_type, dst, dst_type, count, mode);
+    if (sc_type_is_integer(src_type) && sc_type_is_integer(dst_type)) {
+        for (; i < count; i++) {
+            store_i64(dst, dst_type, i, load_i64(src, src_type, i));
+        }
+    } else {
+        // int64 values above 2^53 lose precision through a double, as they would in any float type
+        for (; i < count; i++) {
+            store_f64(dst, dst_type, i, load_f64(src, src_type, i), mode);
+        }
+    }
+    return 0;
+}
+
+int sc_convert_buffer_rounding(const void* src, sc_TYPES src_type, void* dst, sc_TYPES dst_type, uint64_t count, sc_rounding_mode mode) {
+    if (mode == sc_round_nearest_even) {
+        return convert_buffer(src, src_type, dst, dst_type, count, mode);
+    }
+
+    int previous = fegetround();
+    fesetround(fenv_rounding(mode));
+    int out = convert_buffer(src, src_type, dst, dst_type, count, mode);
+    fesetround(previous);
+    return out;
+}
+
+int sc_convert_buffer(const void* src, sc_TYPES src_type, void* dst, sc_TYPES dst_type, uint64_t count) {
+    return sc_convert_buffer_rounding(src, src_type, dst, dst_type, count, sc_round_nearest_even);
+}
+
+
+typedef struct {
+    const void* src;
+    void* dst;
+    sc_TYPES src_type;
+    sc_TYPES dst_type;
+    sc_rounding_mode mode;
+} cast_args;
+
+static int cast_kernel(void* args, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    cast_args* a = (cast_args*)args;
+    const uint8_t* src = (const uint8_t*)a->src + start * sc_type_size(a->src_type);
+    uint8_t* dst = (uint8_t*)a->dst + start * sc_type_size(a->dst_type);
+    return sc_convert_buffer_rounding(src, a->src_type, dst, a->dst_type, end - start, a->mode);
+}
+
+static int cast_data(const void* src, sc_TYPES src_type, void* dst, sc_TYPES dst_type, uint64_t count, sc_rounding_mode mode, ccb_arena* arena) {
+    cast_args args = {src, dst, src_type, dst_type, mode};
+    return sc_run_range_task(cast_kernel, &args, count, count, arena);
+}
+
+sc_vector* sc_vector_cast_rounding(sc_vector* a, sc_TYPES type, sc_rounding_mode mode, ccb_arena* arena) {
+    sc_vector* out = sc_create_vector(a->size, type, arena);
+    CCB_NOTNULL(out, "Failed to create the cast vector");
+
+    if (cast_data(a->data, a->type, out->data, type, a->size, mode, arena) != 0) {
+        CCB_ERROR("Failed to cast the vector from %s to %s", sc_TYPES_NAMES[a->type], sc_TYPES_NAMES[type]);
+        return NULL;
+    }
+    return out;
+}
+
+sc_tensor* sc_tensor_cast_rounding(sc_tensor* a, sc_TYPES type, sc_rounding_mode mode, ccb_arena* arena) {
+    sc_tensor* out = sc_create_tensor(sc_clone_dimensions(a->dims, arena), type, arena);
+    CCB_NOTNULL(out, "Failed to create the cast tensor");
+
+    if (cast_data(a->data, a->type, out->data, type, a->size, mode, arena) != 0) {
+        CCB_ERROR("Failed to cast the tensor from %s to %s", sc_TYPES_NAMES[a->type], sc_TYPES_NAMES[type]);
+        return NULL;
+    }
+    return out;
+}
+
+sc_vector* sc_vector_cast(sc_vector* a, sc_TYPES type, ccb_arena* arena) {
+    return sc_vector_cast_rounding(a, type, sc_round_nearest_even, arena);
+}
+
+sc_tensor* sc_tensor_cast(sc_tensor* a, sc_TYPES type, ccb_arena* arena) {
+    return sc_tensor_cast_rounding(a, type, sc_round_nearest_even, arena);
+}
+
+
+// type promotion: a floating point type wins over the integers, then the widest type wins,
+// bfloat16 with half gives float32 (neither holds the other)
+sc_TYPES sc_promote_types(sc_TYPES a, sc_TYPES b) {
+    if (a == b) {
+        return a;
+    }
+
+    int a_float = !sc_type_is_integer(a);
+    int b_float = !sc_type_is_integer(b);
+    if (a_float != b_float) {
+        return a_float ? a : b;
+    }
+    if ((a == sc_float16 && b == sc_half) || (a == sc_half && b == sc_float16)) {
+        return sc_float32;
+    }
+    return (sc_type_size(a) >= sc_type_size(b)) ? a : b;
+}
+
+
 // geters and seters
 sc_value_t sc_get_vector_element(sc_vector* vector, uint64_t index) {
     if (index >= vector->size) {
@@ -577,12 +1110,24 @@ sc_value_t sc_get_vector_element(sc_vector* vector, uint64_t index) {
         case sc_float16:
             value.value.f16 = ((__bf16*)vector->data)[index];
             break;
+        case sc_half:
+            value.value.half = ((uint16_t*)vector->data)[index];
+            break;
         case sc_float32:
             value.value.f32 = ((float*)vector->data)[index];
             break;
         case sc_float64:
             value.value.f64 = ((double*)vector->data)[index];
             break;
+        case sc_int32:
+            value.value.i32 = ((int32_t*)vector->data)[index];
+            break;
+        case sc_int64:
+            value.value.i64 = ((int64_t*)vector->data)[index];
+            break;
+        case sc_uint8:
+            value.value.u8 = ((uint8_t*)vector->data)[index];
+            break;
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", vector->type);
             value.type = -1; // Invalid type
@@ -608,12 +1153,24 @@ void sc_set_vector_element(sc_vector* vector, uint64_t index, sc_value_t value)
         case sc_float16:
             ((__bf16*)vector->data)[index] = value.value.f16;
             break;
+        case sc_half:
+            ((uint16_t*)vector->data)[index] = value.value.half;
+            break;
         case sc_float32:
             ((float*)vector->data)[index] = value.value.f32;
             break;
         case sc_float64:
             ((double*)vector->data)[index] = value.value.f64;
             break;
+        case sc_int32:
+            ((int32_t*)vector->data)[index] = value.value.i32;
+            break;
+        case sc_int64:
+            ((int64_t*)vector->data)[index] = value.value.i64;
+            break;
+        case sc_uint8:
+            ((uint8_t*)vector->data)[index] = value.value.u8;
+            break;
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", vector->type);
             break;
@@ -638,20 +1195,10 @@ sc_vector* sc_get_vector_slice(sc_vector* vector, sc_slice* slice, ccb_arena* ar
     sc_vector* sub_vector = sc_create_vector(new_size, vector->type, arena);
     CCB_NOTNULL(sub_vector, "Failed to create sub vector");
 
-    size_t type_size;
-    switch (vector->type) {
-        case sc_float16:
-            type_size = 2;
-            break;
-        case sc_float32:
-            type_size = 4;
-            break;
-        case sc_float64:
-            type_size = 8;
-            break;
-        default:
-            CCB_ERROR("Unsupported sc_TYPES value %d", vector->type);
-            return NULL;
+    size_t type_size = sc_type_size(vector->type);
+    if (type_size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", vector->type);
+        return NULL;
     }
 
     memcpy(sub_vector->data, (unsigned char*)vector->data + start * type_size, new_size * type_size);
@@ -690,12 +1237,24 @@ sc_value_t sc_get_tensor_element(sc_tensor* tensor, sc_index* index) {
         case sc_float16:
             value.value.f16 = ((__bf16*)tensor->data)[flat_index];
             break;
+        case sc_half:
+            value.value.half = ((uint16_t*)tensor->data)[flat_index];
+            break;
         case sc_float32:
             value.value.f32 = ((float*)tensor->data)[flat_index];
             break;
         case sc_float64:
             value.value.f64 = ((double*)tensor->data)[flat_index];
             break;
+        case sc_int32:
+            value.value.i32 = ((int32_t*)tensor->data)[flat_index];
+            break;
+        case sc_int64:
+            value.value.i64 = ((int64_t*)tensor->data)[flat_index];
+            break;
+        case sc_uint8:
+            value.value.u8 = ((uint8_t*)tensor->data)[flat_index];
+            break;
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", tensor->type);
             value.type = -1; // Invalid type
@@ -791,12 +1350,24 @@ void sc_set_tensor_element(sc_tensor* tensor, sc_index* index, sc_value_t value)
         case sc_float16:
             ((__bf16*)tensor->data)[flat_index] = value.value.f16;
             break;
+        case sc_half:
+            ((uint16_t*)tensor->data)[flat_index] = value.value.half;
+            break;
         case sc_float32:
             ((float*)tensor->data)[flat_index] = value.value.f32;
             break;
         case sc_float64:
             ((double*)tensor->data)[flat_index] = value.value.f64;
             break;
+        case sc_int32:
+            ((int32_t*)tensor->data)[flat_index] = value.value.i32;
+            break;
+        case sc_int64:
+            ((int64_t*)tensor->data)[flat_index] = value.value.i64;
+            break;
+        case sc_uint8:
+            ((uint8_t*)tensor->data)[flat_index] = value.value.u8;
+            break;
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", tensor->type);
             break;
@@ -15,11 +15,22 @@
 
 // data structures
 typedef enum {
-    sc_float16,
+    sc_float16,     // bfloat16 (8 exponent bits, 7 mantissa bits)
     sc_float32,
     sc_float64,
+    sc_half,        // IEEE 754 half precision (5 exponent bits, 10 mantissa bits), stored as raw uint16_t bits
+    sc_int32,       // two's complement, arithmetic wraps around
+    sc_int64,
+    sc_uint8,       // arithmetic saturates to [0, 255]
 } sc_TYPES;
 
+typedef enum {
+    sc_round_nearest_even,
+    sc_round_toward_zero,
+    sc_round_down,          // toward -infinity
+    sc_round_up,            // toward +infinity
+} sc_rounding_mode;
+
 
 typedef struct sc_vector_t {
     void* data;
@@ -30,8 +41,12 @@ typedef struct sc_vector_t {
 
 typedef union {
     __bf16 f16;
+    uint16_t half;
     float f32;
     double f64;
+    int32_t i32;
+    int64_t i64;
+    uint8_t u8;
 } sc_number_t;
 
 typedef struct {
@@ -70,6 +85,10 @@ typedef struct sc_tensor_t {
 
 
 // data functions
+// size in bytes of one element, 0 for an unknown type
+uint64_t sc_type_size(sc_TYPES type);
+int sc_type_is_integer(sc_TYPES type);
+
 sc_dimensions* sc_create_empty_dimensions(uint64_t dims_count, ccb_arena* arena);
 sc_slice* sc_create_empty_slice(uint64_t count, ccb_arena* arena);
 sc_index* sc_create_empty_index(uint64_t count, ccb_arena* arena);
@@ -89,10 +108,42 @@ sc_dimensions* sc_clone_dimensions(sc_dimensions* dimensions, ccb_arena* arena);
 
 sc_value_t to_sc_value(double number, sc_TYPES);
 __bf16 sc_value_to_f16(sc_value_t value);
+uint16_t sc_value_to_half(sc_value_t value);
 float sc_value_to_f32(sc_value_t value);
 double sc_value_to_f64(sc_value_t value);
+// floating point values are rounded to nearest even and saturated, NaN gives 0
+int32_t sc_value_to_i32(sc_value_t value);
+int64_t sc_value_to_i64(sc_value_t value);
+uint8_t sc_value_to_u8(sc_value_t value);
 sc_value_t sc_value_as(sc_value_t a, sc_TYPES target_type);
 
+/* IEEE half precision conversions (round to nearest even), F16C is used when the CPU supports it
+   - src: source buffer of count elements
+   - dst: destination buffer of count elements (must not overlap src)
+*/
+void sc_convert_half_to_f32(const uint16_t* src, float* dst, uint64_t count);
+void sc_convert_f32_to_half(const float* src, uint16_t* dst, uint64_t count);
+
+/* Casts count elements between any two types (SIMD for the floating point pairs and the int32 / uint8 <-> float pairs)
+   float to integer casts round to nearest even and saturate, NaN gives 0
+   - return: 0 on success, -1 for an unsupported type
+*/
+int sc_convert_buffer(const void* src, sc_TYPES src_type, void* dst, sc_TYPES dst_type, uint64_t count);
+/* Same as sc_convert_buffer with the rounding mode of the narrowing conversions (float to integer included) */
+int sc_convert_buffer_rounding(const void* src, sc_TYPES src_type, void* dst, sc_TYPES dst_type, uint64_t count, sc_rounding_mode mode);
+/* Casts a vector / tensor to another type, large casts run on the engine threads
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the new vector / tensor
+*/
+sc_vector* sc_vector_cast(sc_vector* a, sc_TYPES type, ccb_arena* arena);
+sc_tensor* sc_tensor_cast(sc_tensor* a, sc_TYPES type, ccb_arena* arena);
+sc_vector* sc_vector_cast_rounding(sc_vector* a, sc_TYPES type, sc_rounding_mode mode, ccb_arena* arena);
+sc_tensor* sc_tensor_cast_rounding(sc_tensor* a, sc_TYPES type, sc_rounding_mode mode, ccb_arena* arena);
+/* Type of the result of an operation between two types:
+   floating point over integer, then the widest type, bfloat16 with half gives float32
+*/
+sc_TYPES sc_promote_types(sc_TYPES a, sc_TYPES b);
+
 
 void sc_data_to_vector(sc_vector* vector, void* data, uint64_t count);
 void sc_data_to_tensor(sc_tensor* tensor, void* data, uint64_t count);
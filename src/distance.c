@@ -0,0 +1,423 @@
+#include "data.h"
+#include "distance.h"
+#include "sc_engine.h"
+#include "sc_gemm.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+// rows of a norm work unit
+#define DISTANCE_NORM_ROWS 1024
+// queries of a top k work unit (rows of the gemm tile)
+#define DISTANCE_QUERY_BLOCK 64
+// corpus points of a gemm tile
+#define DISTANCE_CORPUS_TILE 256
+
+
+static sc_TYPES compute_type(sc_TYPES type) {
+    return (type == sc_float64) ? sc_float64 : sc_float32;
+}
+
+
+// ############
+// squared norms
+// ############
+
+struct norm_args {
+    sc_tensor* points;
+    sc_vector* norms;
+};
+
+
+static int norm_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct norm_args* args = (struct norm_args*)raw;
+    sc_TYPES type = args->points->type;
+    uint64_t n = args->points->dims->dims[0];
+    uint64_t dim = args->points->dims->dims[1];
+    uint64_t first = start * DISTANCE_NORM_ROWS;
+    uint64_t last = (end * DISTANCE_NORM_ROWS < n) ? end * DISTANCE_NORM_ROWS : n;
+    for (uint64_t i = first; i < last; i++) {
+        double sum = 0.0;
+        if (type == sc_float64) {
+            const double* row = (const double*)args->points->data + i * dim;
+            for (uint64_t p = 0; p < dim; p++) {
+                sum += row[p] * row[p];
+            }
+            ((double*)args->norms->data)[i] = sum;
+        } else {
+            for (uint64_t p = 0; p < dim; p++) {
+                double value = sc_load_f32(args->points->data, i * dim + p, type);
+                sum += value * value;
+            }
+            ((float*)args->norms->data)[i] = (float)sum;
+        }
+    }
+    return 0;
+}
+
+
+sc_point_set* sc_point_set_create(sc_tensor* points, ccb_arena* arena) {
+    CCB_NOTNULL(points, "points is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (points->type != sc_float16 && points->type != sc_float32 && points->type != sc_float64) {
+        CCB_ERROR("Point sets need bfloat16, float32 or float64 points, got type %d", points->type);
+        return NULL;
+    }
+    if (points->dims->dims_count != 2) {
+        CCB_ERROR("Point sets are [n, dim] tensors");
+        return NULL;
+    }
+    uint64_t n = points->dims->dims[0];
+    sc_point_set* set = (sc_point_set*)ccb_arena_malloc(arena, sizeof(sc_point_set));
+    CCB_NOTNULL(set, "Failed to allocate point set");
+    set->points = points;
+    set->sq_norms = sc_create_vector(n, compute_type(points->type), arena);
+    CCB_NOTNULL(set->sq_norms, "Failed to allocate point norms");
+
+    struct norm_args args = {points, set->sq_norms};
+    uint64_t chunks = (n + DISTANCE_NORM_ROWS - 1) / DISTANCE_NORM_ROWS;
+    if (chunks > 0 && sc_run_range_task(norm_kernel, &args, chunks, points->size, arena) != 0) {
+        CCB_ERROR("Failed to compute point norms");
+        return NULL;
+    }
+    return set;
+}
+
+
+static int check_sets(sc_point_set* queries, sc_point_set* corpus, sc_metric metric) {
+    CCB_NOTNULL(queries, "queries is NULL");
+    CCB_NOTNULL(corpus, "corpus is NULL");
+    if (queries->points->type != corpus->points->type || queries->points->dims->dims[1] != corpus->points->dims->dims[1]) {
+        CCB_ERROR("Queries and corpus must have the same type and dimension");
+        return -1;
+    }
+    if (metric != sc_metric_sqeuclidean && metric != sc_metric_euclidean && metric != sc_metric_cosine &&
+        metric != sc_metric_inner_product) {
+        CCB_ERROR("Unknown metric %d", metric);
+        return -1;
+    }
+    return 0;
+}
+
+
+// q.Ct for the queries [q0, q0 + rows) and the corpus points [c0, c0 + cols) into a row major tile
+static void dot_desc(sc_gemm_desc* desc, sc_point_set* queries, uint64_t q0, uint64_t rows, sc_point_set* corpus,
+                     uint64_t c0, uint64_t cols, void* c, uint64_t ldc) {
+    sc_TYPES type = queries->points->type;
+    uint64_t dim = queries->points->dims->dims[1];
+    uint64_t size = sc_type_size(type);
+    desc->m = rows;
+    desc->n = cols;
+    desc->k = dim;
+    desc->a = (const uint8_t*)queries->points->data + q0 * dim * size;
+    desc->a_type = type;
+    desc->a_row_stride = (int64_t)dim;
+    desc->a_col_stride = 1;
+    desc->b = (const uint8_t*)corpus->points->data + c0 * dim * size;
+    desc->b_type = type;
+    desc->b_row_stride = 1;
+    desc->b_col_stride = (int64_t)dim;
+    desc->c = c;
+    desc->c_type = compute_type(type);
+    desc->c_row_stride = (int64_t)ldc;
+    desc->c_col_stride = 1;
+    desc->alpha = 1.0;
+    desc->beta = 0.0;
+}
+
+
+/*
+    the epilogue turns a dot product into a key that is smaller for better matches (the inner product is negated)
+    the heaps keep the k best (key, index) pairs of a query with the worst at the root
+*/
+#define DISTANCE_KERNELS(SUFFIX, T, SQRT)                                                                      \
+static inline T key_##SUFFIX(sc_metric metric, T dot, T qn, T cn) {                                             \
+    T key;                                                                                                     \
+    switch (metric) {                                                                                          \
+        case sc_metric_inner_product:                                                                          \
+            key = -dot;                                                                                        \
+            break;                                                                                             \
+        case sc_metric_cosine: {                                                                               \
+            T denominator = SQRT(qn * cn);                                                                     \
+            key = (denominator > (T)0) ? (T)1 - dot / denominator : (T)1;                                      \
+            break;                                                                                             \
+        }                                                                                                      \
+        default: {                                                                                             \
+            T d2 = qn + cn - (T)2 * dot;                                                                       \
+            d2 = (d2 > (T)0) ? d2 : (T)0;                                                                      \
+            key = (metric == sc_metric_euclidean) ? SQRT(d2) : d2;                                             \
+            break;                                                                                             \
+        }                                                                                                      \
+    }                                                                                                          \
+    return (key == key) ? key : (T)INFINITY;                                                                   \
+}                                                                                                              \
+                                                                                                               \
+static inline int worse_##SUFFIX(T key_a, uint64_t index_a, T key_b, uint64_t index_b) {                        \
+    return key_a > key_b || (key_a == key_b && index_a > index_b);                                             \
+}                                                                                                              \
+                                                                                                               \
+static void sift_down_##SUFFIX(T* keys, uint64_t* ids, uint64_t count, uint64_t i) {                             \
+    for (;;) {                                                                                                 \
+        uint64_t worst = i;                                                                                    \
+        uint64_t l = 2 * i + 1;                                                                                \
+        uint64_t r = l + 1;                                                                                    \
+        if (l < count && worse_##SUFFIX(keys[l], ids[l], keys[worst], ids[worst])) worst = l;                  \
+        if (r < count && worse_##SUFFIX(keys[r], ids[r], keys[worst], ids[worst])) worst = r;                  \
+        if (worst == i) {                                                                                      \
+            return;                                                                                            \
+        }                                                                                                      \
+        T key = keys[i]; keys[i] = keys[worst]; keys[worst] = key;                                             \
+        uint64_t id = ids[i]; ids[i] = ids[worst]; ids[worst] = id;                                            \
+        i = worst;                                                                                             \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static inline void push_##SUFFIX(T* keys, uint64_t* ids, uint64_t* count, uint64_t k, T key, uint64_t id) {      \
+    if (*count < k) {                                                                                          \
+        uint64_t i = (*count)++;                                                                               \
+        keys[i] = key;                                                                                         \
+        ids[i] = id;                                                                                           \
+        while (i > 0) {                                                                                        \
+            uint64_t parent = (i - 1) / 2;                                                                     \
+            if (!worse_##SUFFIX(keys[i], ids[i], keys[parent], ids[parent])) {                                 \
+                break;                                                                                         \
+            }                                                                                                  \
+            T swap = keys[i]; keys[i] = keys[parent]; keys[parent] = swap;                                     \
+            uint64_t id_swap = ids[i]; ids[i] = ids[parent]; ids[parent] = id_swap;                            \
+            i = parent;                                                                                        \
+        }                                                                                                      \
+    } else if (worse_##SUFFIX(keys[0], ids[0], key, id)) {                                                     \
+        keys[0] = key;                                                                                         \
+        ids[0] = id;                                                                                           \
+        sift_down_##SUFFIX(keys, ids, k, 0);                                                                   \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+/* heap sort in place: the best pair ends first */                                                             \
+static void sort_heap_##SUFFIX(T* keys, uint64_t* ids, uint64_t count) {                                        \
+    for (uint64_t n = count; n > 1; n--) {                                                                     \
+        T key = keys[0]; keys[0] = keys[n - 1]; keys[n - 1] = key;                                             \
+        uint64_t id = ids[0]; ids[0] = ids[n - 1]; ids[n - 1] = id;                                            \
+        sift_down_##SUFFIX(keys, ids, n - 1, 0);                                                               \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+/* keys of a [rows, cols] tile of dot products pushed in the heaps of its queries */                           \
+static void tile_topk_##SUFFIX(sc_metric metric, const T* tile, uint64_t ldc, uint64_t rows, uint64_t cols,       \
+                               const T* q_norms, const T* c_norms, uint64_t c0, uint64_t k, T* keys,           \
+                               uint64_t* ids, uint64_t* counts) {                                              \
+    for (uint64_t r = 0; r < rows; r++) {                                                                      \
+        T* row_keys = keys + r * k;                                                                            \
+        uint64_t* row_ids = ids + r * k;                                                                       \
+        for (uint64_t j = 0; j < cols; j++) {                                                                  \
+            T key = key_##SUFFIX(metric, tile[r * ldc + j], q_norms[r], c_norms[c0 + j]);                      \
+            push_##SUFFIX(row_keys, row_ids, counts + r, k, key, c0 + j);                                      \
+        }                                                                                                      \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+/* full matrix rows: dot products replaced by the metric in place */                                           \
+static void rows_metric_##SUFFIX(sc_metric metric, T* out, uint64_t cols, uint64_t r0, uint64_t r1,              \
+                                 const T* q_norms, const T* c_norms) {                                         \
+    for (uint64_t r = r0; r < r1; r++) {                                                                       \
+        T* row = out + r * cols;                                                                               \
+        if (metric == sc_metric_inner_product) {                                                               \
+            continue;                                                                                          \
+        }                                                                                                      \
+        for (uint64_t j = 0; j < cols; j++) {                                                                  \
+            row[j] = key_##SUFFIX(metric, row[j], q_norms[r], c_norms[j]);                                     \
+        }                                                                                                      \
+    }                                                                                                          \
+}
+
+DISTANCE_KERNELS(f32, float, sqrtf)
+DISTANCE_KERNELS(f64, double, sqrt)
+
+
+// ###########
+// full matrix
+// ###########
+
+struct matrix_args {
+    sc_metric metric;
+    sc_tensor* out;
+    sc_point_set* queries;
+    sc_point_set* corpus;
+};
+
+
+static int matrix_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct matrix_args* args = (struct matrix_args*)raw;
+    uint64_t cols = args->out->dims->dims[1];
+    if (args->out->type == sc_float64) {
+        rows_metric_f64(args->metric, (double*)args->out->data, cols, start, end, (const double*)args->queries->sq_norms->data,
+                        (const double*)args->corpus->sq_norms->data);
+    } else {
+        rows_metric_f32(args->metric, (float*)args->out->data, cols, start, end, (const float*)args->queries->sq_norms->data,
+                        (const float*)args->corpus->sq_norms->data);
+    }
+    return 0;
+}
+
+
+sc_tensor* sc_pairwise_distances(sc_point_set* queries, sc_point_set* corpus, sc_metric metric, ccb_arena* arena) {
+    if (check_sets(queries, corpus, metric) != 0) {
+        return NULL;
+    }
+    uint64_t q = queries->points->dims->dims[0];
+    uint64_t n = corpus->points->dims->dims[0];
+    uint64_t dims[] = {q, n};
+    sc_tensor* out = sc_create_tensor(sc_create_dimensions(2, arena, dims), compute_type(queries->points->type), arena);
+    CCB_NOTNULL(out, "Failed to allocate distance matrix");
+
+    sc_gemm_desc desc;
+    dot_desc(&desc, queries, 0, q, corpus, 0, n, out->data, n);
+    if (sc_gemm(&desc, arena) != 0) {
+        CCB_ERROR("Failed to compute pairwise dot products");
+        return NULL;
+    }
+    struct matrix_args args = {metric, out, queries, corpus};
+    if (q > 0 && metric != sc_metric_inner_product && sc_run_range_task(matrix_kernel, &args, q, q * n, arena) != 0) {
+        CCB_ERROR("Failed to compute pairwise distances");
+        return NULL;
+    }
+    return out;
+}
+
+
+// #####
+// top k
+// #####
+
+struct topk_args {
+    sc_metric metric;
+    sc_point_set* queries;
+    sc_point_set* corpus;
+    uint64_t k;
+    uint64_t* indices;
+    sc_tensor* distances;
+    uint8_t* tiles;         // per thread [DISTANCE_QUERY_BLOCK, DISTANCE_CORPUS_TILE]
+    uint8_t* keys;          // per thread [DISTANCE_QUERY_BLOCK, k]
+    uint64_t* ids;          // per thread [DISTANCE_QUERY_BLOCK, k]
+    uint64_t* counts;       // per thread [DISTANCE_QUERY_BLOCK]
+    uint8_t* scratch;       // per thread gemm scratch
+};
+
+
+static int topk_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct topk_args* args = (struct topk_args*)raw;
+    sc_TYPES type = args->distances->type;
+    uint64_t size = sc_type_size(type);
+    uint64_t k = args->k;
+    uint64_t nq = args->queries->points->dims->dims[0];
+    uint64_t n = args->corpus->points->dims->dims[0];
+    void* tile = args->tiles + thread_id * DISTANCE_QUERY_BLOCK * DISTANCE_CORPUS_TILE * size;
+    void* keys = args->keys + thread_id * DISTANCE_QUERY_BLOCK * k * size;
+    uint64_t* ids = args->ids + thread_id * DISTANCE_QUERY_BLOCK * k;
+    uint64_t* counts = args->counts + thread_id * DISTANCE_QUERY_BLOCK;
+    void* scratch = args->scratch + thread_id * sc_gemm_scratch_size();
+
+    for (uint64_t block = start; block < end; block++) {
+        uint64_t q0 = block * DISTANCE_QUERY_BLOCK;
+        uint64_t rows = (nq - q0 < DISTANCE_QUERY_BLOCK) ? nq - q0 : DISTANCE_QUERY_BLOCK;
+        memset(counts, 0, rows * sizeof(uint64_t));
+
+        for (uint64_t c0 = 0; c0 < n; c0 += DISTANCE_CORPUS_TILE) {
+            uint64_t cols = (n - c0 < DISTANCE_CORPUS_TILE) ? n - c0 : DISTANCE_CORPUS_TILE;
+            sc_gemm_desc desc;
+            dot_desc(&desc, args->queries, q0, rows, args->corpus, c0, cols, tile, DISTANCE_CORPUS_TILE);
+            if (sc_gemm_serial(&desc, scratch) != 0) {
+                return -1;
+            }
+            if (type == sc_float64) {
+                tile_topk_f64(args->metric, (const double*)tile, DISTANCE_CORPUS_TILE, rows, cols,
+                              (const double*)args->queries->sq_norms->data + q0, (const double*)args->corpus->sq_norms->data,
+                              c0, k, (double*)keys, ids, counts);
+            } else {
+                tile_topk_f32(args->metric, (const float*)tile, DISTANCE_CORPUS_TILE, rows, cols,
+                              (const float*)args->queries->sq_norms->data + q0, (const float*)args->corpus->sq_norms->data,
+                              c0, k, (float*)keys, ids, counts);
+            }
+        }
+
+        // sorted heaps written out, the inner products are restored from their negated keys
+        double sign = (args->metric == sc_metric_inner_product) ? -1.0 : 1.0;
+        for (uint64_t r = 0; r < rows; r++) {
+            uint64_t* row_ids = ids + r * k;
+            if (type == sc_float64) {
+                double* row_keys = (double*)keys + r * k;
+                sort_heap_f64(row_keys, row_ids, k);
+                for (uint64_t j = 0; j < k; j++) {
+                    ((double*)args->distances->data)[(q0 + r) * k + j] = sign * row_keys[j];
+                }
+            } else {
+                float* row_keys = (float*)keys + r * k;
+                sort_heap_f32(row_keys, row_ids, k);
+                for (uint64_t j = 0; j < k; j++) {
+                    ((float*)args->distances->data)[(q0 + r) * k + j] = (float)sign * row_keys[j];
+                }
+            }
+            memcpy(args->indices + (q0 + r) * k, row_ids, k * sizeof(uint64_t));
+        }
+    }
+    return 0;
+}
+
+
+int sc_pairwise_topk(sc_point_set* queries, sc_point_set* corpus, sc_metric metric, uint64_t k, uint64_t* indices,
+                     sc_tensor* distances, ccb_arena* arena) {
+    if (check_sets(queries, corpus, metric) != 0) {
+        return -1;
+    }
+    CCB_NOTNULL(indices, "indices is NULL");
+    uint64_t nq = queries->points->dims->dims[0];
+    uint64_t n = corpus->points->dims->dims[0];
+    sc_TYPES type = compute_type(queries->points->type);
+    if (k == 0 || k > n) {
+        CCB_ERROR("k must be in [1, %" PRIu64 "], got %" PRIu64, n, k);
+        return -1;
+    }
+    if (distances == NULL) {
+        uint64_t dims[] = {nq, k};
+        distances = sc_create_tensor(sc_create_dimensions(2, arena, dims), type, arena);
+        CCB_NOTNULL(distances, "Failed to allocate distances");
+    } else if (distances->type != type || distances->size != nq * k) {
+        CCB_ERROR("distances must have %" PRIu64 " x %" PRIu64 " elements of type %d", nq, k, type);
+        return -1;
+    }
+
+    uint64_t threads = sc_get_engine_thread_count();
+    uint64_t size = sc_type_size(type);
+    struct topk_args args;
+    args.metric = metric;
+    args.queries = queries;
+    args.corpus = corpus;
+    args.k = k;
+    args.indices = indices;
+    args.distances = distances;
+    args.tiles = (uint8_t*)ccb_arena_malloc(arena, threads * DISTANCE_QUERY_BLOCK * DISTANCE_CORPUS_TILE * size);
+    args.keys = (uint8_t*)ccb_arena_malloc(arena, threads * DISTANCE_QUERY_BLOCK * k * size);
+    args.ids = (uint64_t*)ccb_arena_malloc(arena, threads * DISTANCE_QUERY_BLOCK * k * sizeof(uint64_t));
+    args.counts = (uint64_t*)ccb_arena_malloc(arena, threads * DISTANCE_QUERY_BLOCK * sizeof(uint64_t));
+    args.scratch = (uint8_t*)ccb_arena_malloc(arena, threads * sc_gemm_scratch_size());
+    if (args.tiles == NULL || args.keys == NULL || args.ids == NULL || args.counts == NULL || args.scratch == NULL) {
+        CCB_ERROR("Failed to allocate top k buffers");
+        return -1;
+    }
+
+    uint64_t blocks = (nq + DISTANCE_QUERY_BLOCK - 1) / DISTANCE_QUERY_BLOCK;
+    uint64_t dim = queries->points->dims->dims[1];
+    if (blocks > 0 && sc_run_range_task(topk_kernel, &args, blocks, nq * n * dim, arena) != 0) {
+        CCB_ERROR("Failed to run top k search");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef __DISTANCE_H__
+#define __DISTANCE_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    pairwise distances between the rows of two point sets through the gemm: the dot products of a block of
+    queries with a tile of the corpus are computed at once, then turned into distances with the cached squared
+    norms, |q - c|^2 = |q|^2 + |c|^2 - 2 q.c
+    the top k search keeps a bounded heap per query in the epilogue of each tile, so the [queries, corpus]
+    matrix is never stored
+    float32 and bfloat16 points are computed in float32, float64 points in float64
+*/
+
+typedef enum {
+    sc_metric_sqeuclidean,      // |q - c|^2
+    sc_metric_euclidean,        // |q - c|
+    sc_metric_cosine,           // 1 - q.c / (|q| |c|), 1 when a norm is 0
+    sc_metric_inner_product,    // q.c, the top k are the largest
+} sc_metric;
+
+typedef struct {
+    sc_tensor* points;          // [n, dim], not copied
+    sc_vector* sq_norms;        // [n] squared norms, float32 (float64 for float64 points)
+} sc_point_set;
+
+
+/* Wraps [n, dim] points and computes their squared norms once
+   - sc_tensor* points: bfloat16, float32 or float64 rows
+   - ccb_arena* arena: arena where the set and the norms will be allocated
+   - return: a pointer to the set, NULL on error
+*/
+sc_point_set* sc_point_set_create(sc_tensor* points, ccb_arena* arena);
+/* Full [queries, corpus] matrix of the metric
+   - sc_point_set* queries, sc_point_set* corpus: same type and dimension
+   - return: a pointer to the matrix (float32, or float64 for float64 points), NULL on error
+*/
+sc_tensor* sc_pairwise_distances(sc_point_set* queries, sc_point_set* corpus, sc_metric metric, ccb_arena* arena);
+/* k nearest corpus points of every query (largest inner products for sc_metric_inner_product)
+   - uint64_t k: 1 to the corpus size
+   - uint64_t* indices: [queries, k] corpus rows, best first, ties go to the lowest index
+   - sc_tensor* distances: [queries, k] values of the metric (float32, or float64 for float64 points), can be NULL
+   - return: 0 on success
+*/
+int sc_pairwise_topk(sc_point_set* queries, sc_point_set* corpus, sc_metric metric, uint64_t k, uint64_t* indices,
+                     sc_tensor* distances, ccb_arena* arena);
+
+
+#endif // __DISTANCE_H__
@@ -0,0 +1,849 @@
+#include "data.h"
+#include "factor.h"
+#include "sc_engine.h"
+#include "sc_gemm.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+// columns of the LU / Cholesky panels and rows of the trsm diagonal blocks
+#define FACTOR_BLOCK 64
+// reflectors applied at once by QR
+#define FACTOR_QR_BLOCK 32
+// right hand side columns of a trsm work unit
+#define FACTOR_TILE 64
+// per thread counters are padded to a cache line
+#define FACTOR_LINE 8
+
+
+// the scalar kernels, one instance per type
+struct factor_ops {
+    int (*lu_panel)(void* a, uint64_t lda, uint64_t m, uint64_t k0, uint64_t k1, uint64_t* pivots);
+    void (*trsm_block)(const void* t, uint64_t ldt, int trans, int forward, int unit, uint64_t r0, uint64_t r1,
+                       void* b, uint64_t ldb, uint64_t c0, uint64_t c1);
+    int (*cholesky_block)(void* a, uint64_t lda, uint64_t k0, uint64_t k1, double tolerance);
+    void (*cholesky_rows)(void* a, uint64_t lda, uint64_t k0, uint64_t k1, uint64_t i0, uint64_t i1);
+    void (*qr_panel)(void* a, uint64_t lda, uint64_t m, uint64_t k0, uint64_t k1, void* tau);
+    void (*qr_block)(const void* a, uint64_t lda, uint64_t m, uint64_t k0, uint64_t k1, const void* tau, void* t, void* v);
+    void (*qr_apply_t)(const void* t, uint64_t nb, void* w, uint64_t cols);
+};
+
+
+#define FACTOR_KERNELS(SUFFIX, T, SQRT, FABS)                                                                   \
+/* unblocked LU of the columns [k0, k1) of rows [k0, m), the row swaps cover the lda columns */               \
+static int lu_panel_##SUFFIX(void* raw, uint64_t lda, uint64_t m, uint64_t k0, uint64_t k1, uint64_t* pivots) { \
+    T* a = (T*)raw;                                                                                            \
+    int singular = 0;                                                                                          \
+    for (uint64_t j = k0; j < k1; j++) {                                                                       \
+        uint64_t p = j;                                                                                        \
+        T best = FABS(a[j * lda + j]);                                                                         \
+        for (uint64_t i = j + 1; i < m; i++) {                                                                 \
+            T value = FABS(a[i * lda + j]);                                                                    \
+            if (value > best) {                                                                                \
+                best = value;                                                                                  \
+                p = i;                                                                                         \
+            }                                                                                                  \
+        }                                                                                                      \
+        pivots[j] = p;                                                                                         \
+        if (p != j) {                                                                                          \
+            for (uint64_t c = 0; c < lda; c++) {                                                               \
+                T swap = a[j * lda + c];                                                                       \
+                a[j * lda + c] = a[p * lda + c];                                                               \
+                a[p * lda + c] = swap;                                                                         \
+            }                                                                                                  \
+        }                                                                                                      \
+        T pivot = a[j * lda + j];                                                                              \
+        if (pivot == (T)0) {                                                                                   \
+            singular = 1;                                                                                      \
+            continue;                                                                                          \
+        }                                                                                                      \
+        T inv = (T)1 / pivot;                                                                                  \
+        for (uint64_t i = j + 1; i < m; i++) {                                                                 \
+            T l = a[i * lda + j] * inv;                                                                        \
+            a[i * lda + j] = l;                                                                                \
+            for (uint64_t c = j + 1; c < k1; c++) {                                                            \
+                a[i * lda + c] -= l * a[j * lda + c];                                                          \
+            }                                                                                                  \
+        }                                                                                                      \
+    }                                                                                                          \
+    return singular;                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+/* substitution over the rows [r0, r1) of op(T) for the columns [c0, c1) of b */                               \
+static void trsm_block_##SUFFIX(const void* traw, uint64_t ldt, int trans, int forward, int unit, uint64_t r0,   \
+                                uint64_t r1, void* braw, uint64_t ldb, uint64_t c0, uint64_t c1) {             \
+    const T* t = (const T*)traw;                                                                               \
+    T* b = (T*)braw;                                                                                           \
+    for (uint64_t s = 0; s < r1 - r0; s++) {                                                                   \
+        uint64_t i = forward ? r0 + s : r1 - 1 - s;                                                            \
+        T* bi = b + i * ldb;                                                                                   \
+        uint64_t p0 = forward ? r0 : i + 1;                                                                    \
+        uint64_t p1 = forward ? i : r1;                                                                        \
+        for (uint64_t p = p0; p < p1; p++) {                                                                   \
+            T e = trans ? t[p * ldt + i] : t[i * ldt + p];                                                     \
+            if (e == (T)0) {                                                                                   \
+                continue;                                                                                      \
+            }                                                                                                  \
+            const T* bp = b + p * ldb;                                                                         \
+            for (uint64_t c = c0; c < c1; c++) {                                                               \
+                bi[c] -= e * bp[c];                                                                            \
+            }                                                                                                  \
+        }                                                                                                      \
+        if (!unit) {                                                                                           \
+            T inv = (T)1 / t[i * ldt + i];                                                                     \
+            for (uint64_t c = c0; c < c1; c++) {                                                               \
+                bi[c] *= inv;                                                                                  \
+            }                                                                                                  \
+        }                                                                                                      \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+/* Cholesky of the diagonal block [k0, k1), the columns before k0 were already applied */                      \
+static int cholesky_block_##SUFFIX(void* raw, uint64_t lda, uint64_t k0, uint64_t k1, double tolerance) {        \
+    T* a = (T*)raw;                                                                                            \
+    for (uint64_t j = k0; j < k1; j++) {                                                                       \
+        T pivot = a[j * lda + j];                                                                              \
+        for (uint64_t p = k0; p < j; p++) {                                                                    \
+            pivot -= a[j * lda + p] * a[j * lda + p];                                                          \
+        }                                                                                                      \
+        if (!((double)pivot > tolerance)) {                                                                    \
+            return 1;                                                                                          \
+        }                                                                                                      \
+        pivot = SQRT(pivot);                                                                                   \
+        a[j * lda + j] = pivot;                                                                                \
+        for (uint64_t i = j + 1; i < k1; i++) {                                                                \
+            T sum = a[i * lda + j];                                                                            \
+            for (uint64_t p = k0; p < j; p++) {                                                                \
+                sum -= a[i * lda + p] * a[j * lda + p];                                                        \
+            }                                                                                                  \
+            a[i * lda + j] = sum / pivot;                                                                      \
+        }                                                                                                      \
+    }                                                                                                          \
+    return 0;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+/* rows [i0, i1) of the panel below the diagonal block: L21 = A21.L11^-T */                                    \
+static void cholesky_rows_##SUFFIX(void* raw, uint64_t lda, uint64_t k0, uint64_t k1, uint64_t i0, uint64_t i1) { \
+    T* a = (T*)raw;                                                                                            \
+    for (uint64_t i = i0; i < i1; i++) {                                                                       \
+        for (uint64_t j = k0; j < k1; j++) {                                                                   \
+            T sum = a[i * lda + j];                                                                            \
+            for (uint64_t p = k0; p < j; p++) {                                                                \
+                sum -= a[i * lda + p] * a[j * lda + p];                                                        \
+            }                                                                                                  \
+            a[i * lda + j] = sum / a[j * lda + j];                                                             \
+        }                                                                                                      \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+/* unblocked Householder QR of the columns [k0, k1) of rows [k0, m), the reflectors only update the panel */   \
+static void qr_panel_##SUFFIX(void* raw, uint64_t lda, uint64_t m, uint64_t k0, uint64_t k1, void* tau_raw) {    \
+    T* a = (T*)raw;                                                                                            \
+    T* tau = (T*)tau_raw;                                                                                      \
+    T w[FACTOR_QR_BLOCK];                                                                                      \
+    for (uint64_t j = k0; j < k1; j++) {                                                                       \
+        T alpha = a[j * lda + j];                                                                              \
+        T norm2 = (T)0;                                                                                        \
+        for (uint64_t i = j + 1; i < m; i++) {                                                                 \
+            norm2 += a[i * lda + j] * a[i * lda + j];                                                          \
+        }                                                                                                      \
+        if (norm2 == (T)0) {                                                                                   \
+            tau[j] = (T)0;                                                                                     \
+            continue;                                                                                          \
+        }                                                                                                      \
+        T beta = SQRT(alpha * alpha + norm2);                                                                  \
+        beta = (alpha > (T)0) ? -beta : beta;                                                                  \
+        tau[j] = (beta - alpha) / beta;                                                                        \
+        T scale = (T)1 / (alpha - beta);                                                                       \
+        for (uint64_t i = j + 1; i < m; i++) {                                                                 \
+            a[i * lda + j] *= scale;                                                                           \
+        }                                                                                                      \
+        a[j * lda + j] = beta;                                                                                 \
+                                                                                                               \
+        /* w = tau . v^T.A for the columns right of j, then A -= v.w */                                        \
+        uint64_t width = k1 - j - 1;                                                                           \
+        for (uint64_t c = 0; c < width; c++) {                                                                 \
+            w[c] = a[j * lda + j + 1 + c];                                                                     \
+        }                                                                                                      \
+        for (uint64_t i = j + 1; i < m; i++) {                                                                 \
+            T v = a[i * lda + j];                                                                              \
+            for (uint64_t c = 0; c < width; c++) {                                                             \
+                w[c] += v * a[i * lda + j + 1 + c];                                                            \
+            }                                                                                                  \
+        }                                                                                                      \
+        for (uint64_t c = 0; c < width; c++) {                                                                 \
+            w[c] *= tau[j];                                                                                    \
+            a[j * lda + j + 1 + c] -= w[c];                                                                    \
+        }                                                                                                      \
+        for (uint64_t i = j + 1; i < m; i++) {                                                                 \
+            T v = a[i * lda + j];                                                                              \
+            for (uint64_t c = 0; c < width; c++) {                                                             \
+                a[i * lda + j + 1 + c] -= v * w[c];                                                            \
+            }                                                                                                  \
+        }                                                                                                      \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+/* explicit V [m - k0, nb] of the reflectors [k0, k1) and the upper triangular T [nb, nb] of H1..Hnb = I - V.T.V^T */ \
+static void qr_block_##SUFFIX(const void* raw, uint64_t lda, uint64_t m, uint64_t k0, uint64_t k1, const void* tau_raw, \
+                              void* t_raw, void* v_raw) {                                                      \
+    const T* a = (const T*)raw;                                                                                \
+    const T* tau = (const T*)tau_raw;                                                                          \
+    T* t = (T*)t_raw;                                                                                          \
+    T* v = (T*)v_raw;                                                                                          \
+    uint64_t nb = k1 - k0;                                                                                     \
+    uint64_t rows = m - k0;                                                                                    \
+    for (uint64_t r = 0; r < rows; r++) {                                                                      \
+        for (uint64_t c = 0; c < nb; c++) {                                                                    \
+            v[r * nb + c] = (r < c) ? (T)0 : ((r == c) ? (T)1 : a[(k0 + r) * lda + k0 + c]);                    \
+        }                                                                                                      \
+    }                                                                                                          \
+    T z[FACTOR_QR_BLOCK];                                                                                      \
+    for (uint64_t j = 0; j < nb; j++) {                                                                        \
+        /* T[0:j, j] = -tau_j . T[0:j, 0:j] . V[:, 0:j]^T.v_j */                                               \
+        for (uint64_t p = 0; p < j; p++) {                                                                     \
+            z[p] = (T)0;                                                                                       \
+        }                                                                                                      \
+        for (uint64_t r = j; r < rows; r++) {                                                                  \
+            T vj = v[r * nb + j];                                                                              \
+            for (uint64_t p = 0; p < j; p++) {                                                                 \
+                z[p] += v[r * nb + p] * vj;                                                                    \
+            }                                                                                                  \
+        }                                                                                                      \
+        for (uint64_t p = 0; p < j; p++) {                                                                     \
+            T sum = (T)0;                                                                                      \
+            for (uint64_t q = p; q < j; q++) {                                                                 \
+                sum += t[p * nb + q] * z[q];                                                                   \
+            }                                                                                                  \
+            t[p * nb + j] = -tau[k0 + j] * sum;                                                                \
+        }                                                                                                      \
+        t[j * nb + j] = tau[k0 + j];                                                                           \
+        for (uint64_t p = j + 1; p < nb; p++) {                                                                \
+            t[p * nb + j] = (T)0;                                                                              \
+        }                                                                                                      \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+/* w = T^T.w in place, w is [nb, cols] */                                                                      \
+static void qr_apply_t_##SUFFIX(const void* t_raw, uint64_t nb, void* w_raw, uint64_t cols) {                   \
+    const T* t = (const T*)t_raw;                                                                              \
+    T* w = (T*)w_raw;                                                                                          \
+    for (uint64_t i = nb; i-- > 0;) {                                                                          \
+        T* wi = w + i * cols;                                                                                  \
+        T d = t[i * nb + i];                                                                                   \
+        for (uint64_t c = 0; c < cols; c++) {                                                                  \
+            wi[c] *= d;                                                                                        \
+        }                                                                                                      \
+        for (uint64_t p = 0; p < i; p++) {                                                                     \
+            T e = t[p * nb + i];                                                                               \
+            if (e == (T)0) {                                                                                   \
+                continue;                                                                                      \
+            }                                                                                                  \
+            for (uint64_t c = 0; c < cols; c++) {                                                              \
+                wi[c] += e * w[p * cols + c];                                                                  \
+            }                                                                                                  \
+        }                                                                                                      \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static const struct factor_ops ops_##SUFFIX = {                                                                \
+    lu_panel_##SUFFIX, trsm_block_##SUFFIX, cholesky_block_##SUFFIX, cholesky_rows_##SUFFIX,                   \
+    qr_panel_##SUFFIX, qr_block_##SUFFIX, qr_apply_t_##SUFFIX,                                                 \
+};
+
+FACTOR_KERNELS(f32, float, sqrtf, fabsf)
+FACTOR_KERNELS(f64, double, sqrt, fabs)
+
+
+static const struct factor_ops* ops_of(sc_TYPES type) {
+    return (type == sc_float64) ? &ops_f64 : &ops_f32;
+}
+
+
+static void* at(const void* base, uint64_t index, sc_TYPES type) {
+    return (char*)base + index * sc_type_size(type);
+}
+
+
+static int check_matrix(sc_tensor* a, int square) {
+    CCB_NOTNULL(a, "matrix is NULL");
+    if (a->type != sc_float32 && a->type != sc_float64) {
+        CCB_ERROR("Factorisations need float32 or float64 matrices, got type %d", a->type);
+        return -1;
+    }
+    if (a->dims->dims_count != 2 || (square && a->dims->dims[0] != a->dims->dims[1])) {
+        CCB_ERROR("Expected a %s matrix", square ? "square" : "2D");
+        return -1;
+    }
+    return 0;
+}
+
+
+// rows and columns of a right hand side ([rows] or [rows, cols])
+static int check_rhs(sc_tensor* a, sc_tensor* b, uint64_t rows, uint64_t* cols) {
+    CCB_NOTNULL(b, "right hand side is NULL");
+    if (b->type != a->type) {
+        CCB_ERROR("The right hand side (type %d) must have the type of the matrix (type %d)", b->type, a->type);
+        return -1;
+    }
+    if ((b->dims->dims_count != 1 && b->dims->dims_count != 2) || b->dims->dims[0] != rows) {
+        CCB_ERROR("The right hand side must have %" PRIu64 " rows", rows);
+        return -1;
+    }
+    *cols = (b->dims->dims_count == 2) ? b->dims->dims[1] : 1;
+    return 0;
+}
+
+
+// C = alpha * A.B + beta * C on strided blocks
+static int update(sc_TYPES type, uint64_t m, uint64_t n, uint64_t k, const void* a, int64_t a_row, int64_t a_col,
+                  const void* b, int64_t b_row, int64_t b_col, void* c, int64_t ldc, double alpha, double beta, ccb_arena* arena) {
+    if (m == 0 || n == 0 || k == 0) {
+        return 0;
+    }
+    sc_gemm_desc desc;
+    desc.m = m;
+    desc.n = n;
+    desc.k = k;
+    desc.a = a;
+    desc.a_type = type;
+    desc.a_row_stride = a_row;
+    desc.a_col_stride = a_col;
+    desc.b = b;
+    desc.b_type = type;
+    desc.b_row_stride = b_row;
+    desc.b_col_stride = b_col;
+    desc.c = c;
+    desc.c_type = type;
+    desc.c_row_stride = ldc;
+    desc.c_col_stride = 1;
+    desc.alpha = alpha;
+    desc.beta = beta;
+    if (sc_gemm(&desc, arena) != 0) {
+        CCB_ERROR("Failed to run factorisation update");
+        return -1;
+    }
+    return 0;
+}
+
+
+// #####################
+// triangular substitution
+// #####################
+
+struct trsm_args {
+    const struct factor_ops* ops;
+    const void* t;
+    uint64_t ldt;
+    int trans;
+    int forward;
+    int unit;
+    uint64_t r0;
+    uint64_t r1;
+    void* b;
+    uint64_t ldb;
+    uint64_t cols;
+};
+
+
+static int trsm_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct trsm_args* args = (struct trsm_args*)raw;
+    uint64_t c1 = (end * FACTOR_TILE < args->cols) ? end * FACTOR_TILE : args->cols;
+    args->ops->trsm_block(args->t, args->ldt, args->trans, args->forward, args->unit, args->r0, args->r1, args->b,
+                          args->ldb, start * FACTOR_TILE, c1);
+    return 0;
+}
+
+
+// diagonal block substitution, the right hand side columns are split over the threads
+static int solve_block(struct trsm_args* args, ccb_arena* arena) {
+    uint64_t tiles = (args->cols + FACTOR_TILE - 1) / FACTOR_TILE;
+    uint64_t width = args->r1 - args->r0;
+    if (tiles > 0 && sc_run_range_task(trsm_kernel, args, tiles, width * width * args->cols / 2, arena) != 0) {
+        CCB_ERROR("Failed to run triangular solve");
+        return -1;
+    }
+    return 0;
+}
+
+
+// op(T).X = B for n rows of B (row stride ldb), T has a row stride ldt
+static int trsm(sc_TYPES type, const void* t, uint64_t ldt, uint64_t n, int lower, int trans, int unit, void* b,
+                uint64_t ldb, uint64_t cols, ccb_arena* arena) {
+    struct trsm_args args;
+    args.ops = ops_of(type);
+    args.t = t;
+    args.ldt = ldt;
+    args.trans = trans;
+    args.forward = lower != trans;
+    args.unit = unit;
+    args.b = b;
+    args.ldb = ldb;
+    args.cols = cols;
+
+    // E = op(T), its block [r0, r1) x [c0, c1) as a gemm operand
+    int64_t e_row = trans ? 1 : (int64_t)ldt;
+    int64_t e_col = trans ? (int64_t)ldt : 1;
+
+    for (uint64_t s = 0; s < n; s += FACTOR_BLOCK) {
+        uint64_t width = (n - s < FACTOR_BLOCK) ? n - s : FACTOR_BLOCK;
+        uint64_t r0 = args.forward ? s : n - s - width;
+        uint64_t r1 = r0 + width;
+        args.r0 = r0;
+        args.r1 = r1;
+        if (solve_block(&args, arena) != 0) {
+            return -1;
+        }
+
+        // the solved rows are removed from the rows left: B[rest] -= E[rest, r0:r1].X[r0:r1]
+        uint64_t rest0 = args.forward ? r1 : 0;
+        uint64_t rest1 = args.forward ? n : r0;
+        const void* e = at(t, rest0 * (uint64_t)e_row + r0 * (uint64_t)e_col, type);
+        if (update(type, rest1 - rest0, cols, width, e, e_row, e_col, at(b, r0 * ldb, type), (int64_t)ldb, 1,
+                   at(b, rest0 * ldb, type), (int64_t)ldb, -1.0, 1.0, arena) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+int sc_trsm(sc_tensor* t, sc_tensor* b, int lower, int trans, int unit_diag, ccb_arena* arena) {
+    uint64_t cols;
+    if (check_matrix(t, 1) != 0 || check_rhs(t, b, t->dims->dims[0], &cols) != 0) {
+        return -1;
+    }
+    uint64_t n = t->dims->dims[0];
+    return trsm(t->type, t->data, n, n, lower, trans, unit_diag, b->data, cols, cols, arena);
+}
+
+
+// ##
+// LU
+// ##
+
+struct lu_args {
+    const struct factor_ops* ops;
+    void* a;
+    uint64_t n;
+};
+
+
+int sc_lu_inplace(sc_tensor* a, uint64_t* pivots, ccb_arena* arena) {
+    if (check_matrix(a, 1) != 0) {
+        return -1;
+    }
+    CCB_NOTNULL(pivots, "pivots is NULL");
+    const struct factor_ops* ops = ops_of(a->type);
+    uint64_t n = a->dims->dims[0];
+    int singular = 0;
+
+    for (uint64_t k0 = 0; k0 < n; k0 += FACTOR_BLOCK) {
+        uint64_t k1 = (n - k0 < FACTOR_BLOCK) ? n : k0 + FACTOR_BLOCK;
+        singular |= ops->lu_panel(a->data, n, n, k0, k1, pivots);
+        if (k1 == n) {
+            break;
+        }
+
+        // U12 = L11^-1.A12, then A22 -= L21.U12
+        struct trsm_args args;
+        args.ops = ops;
+        args.t = a->data;
+        args.ldt = n;
+        args.trans = 0;
+        args.forward = 1;
+        args.unit = 1;
+        args.r0 = k0;
+        args.r1 = k1;
+        args.b = at(a->data, k1, a->type);
+        args.ldb = n;
+        args.cols = n - k1;
+        if (solve_block(&args, arena) != 0) {
+            return -1;
+        }
+        if (update(a->type, n - k1, n - k1, k1 - k0, at(a->data, k1 * n + k0, a->type), (int64_t)n, 1,
+                   at(a->data, k0 * n + k1, a->type), (int64_t)n, 1, at(a->data, k1 * n + k1, a->type), (int64_t)n,
+                   -1.0, 1.0, arena) != 0) {
+            return -1;
+        }
+    }
+    return singular;
+}
+
+
+static void swap_rows(void* b, uint64_t i, uint64_t p, uint64_t row_bytes) {
+    char* x = (char*)b + i * row_bytes;
+    char* y = (char*)b + p * row_bytes;
+    for (uint64_t c = 0; c < row_bytes; c++) {
+        char swap = x[c];
+        x[c] = y[c];
+        y[c] = swap;
+    }
+}
+
+
+int sc_lu_solve(sc_tensor* lu, const uint64_t* pivots, sc_tensor* b, ccb_arena* arena) {
+    uint64_t cols;
+    if (check_matrix(lu, 1) != 0 || check_rhs(lu, b, lu->dims->dims[0], &cols) != 0) {
+        return -1;
+    }
+    CCB_NOTNULL(pivots, "pivots is NULL");
+    uint64_t n = lu->dims->dims[0];
+    for (uint64_t i = 0; i < n; i++) {
+        if (pivots[i] != i) {
+            swap_rows(b->data, i, pivots[i], cols * sc_type_size(b->type));
+        }
+    }
+    if (trsm(lu->type, lu->data, n, n, 1, 0, 1, b->data, cols, cols, arena) != 0 ||
+        trsm(lu->type, lu->data, n, n, 0, 0, 0, b->data, cols, cols, arena) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+
+// ########
+// Cholesky
+// ########
+
+struct cholesky_args {
+    const struct factor_ops* ops;
+    void* a;
+    uint64_t lda;
+    uint64_t k0;
+    uint64_t k1;
+};
+
+
+static int cholesky_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct cholesky_args* args = (struct cholesky_args*)raw;
+    args->ops->cholesky_rows(args->a, args->lda, args->k0, args->k1, args->k1 + start, args->k1 + end);
+    return 0;
+}
+
+
+int sc_cholesky_inplace(sc_tensor* a, double tolerance, ccb_arena* arena) {
+    if (check_matrix(a, 1) != 0) {
+        return -1;
+    }
+    const struct factor_ops* ops = ops_of(a->type);
+    uint64_t n = a->dims->dims[0];
+    uint64_t size = sc_type_size(a->type);
+
+    for (uint64_t k0 = 0; k0 < n; k0 += FACTOR_BLOCK) {
+        uint64_t k1 = (n - k0 < FACTOR_BLOCK) ? n : k0 + FACTOR_BLOCK;
+        if (ops->cholesky_block(a->data, n, k0, k1, tolerance) != 0) {
+            return 1;
+        }
+        if (k1 == n) {
+            break;
+        }
+
+        // panel below the diagonal block (rows split over the threads), then A22 -= L21.L21^T
+        struct cholesky_args args = {ops, a->data, n, k0, k1};
+        uint64_t width = k1 - k0;
+        if (sc_run_range_task(cholesky_kernel, &args, n - k1, (n - k1) * width * width / 2, arena) != 0) {
+            CCB_ERROR("Failed to run Cholesky panel");
+            return -1;
+        }
+        const void* l21 = at(a->data, k1 * n + k0, a->type);
+        if (update(a->type, n - k1, n - k1, width, l21, (int64_t)n, 1, l21, 1, (int64_t)n, at(a->data, k1 * n + k1, a->type),
+                   (int64_t)n, -1.0, 1.0, arena) != 0) {
+            return -1;
+        }
+    }
+    for (uint64_t i = 0; i + 1 < n; i++) {
+        memset(at(a->data, i * n + i + 1, a->type), 0, (n - i - 1) * size);
+    }
+    return 0;
+}
+
+
+int sc_cholesky_solve(sc_tensor* l, sc_tensor* b, ccb_arena* arena) {
+    uint64_t cols;
+    if (check_matrix(l, 1) != 0 || check_rhs(l, b, l->dims->dims[0], &cols) != 0) {
+        return -1;
+    }
+    uint64_t n = l->dims->dims[0];
+    if (trsm(l->type, l->data, n, n, 1, 0, 0, b->data, cols, cols, arena) != 0 ||
+        trsm(l->type, l->data, n, n, 1, 1, 0, b->data, cols, cols, arena) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+
+// ##
+// QR
+// ##
+
+// b = (H1..Hk)^T.b for the reflectors of the rows [k0, m), the block (V, T) is rebuilt from the factorisation
+static int apply_block_qt(sc_tensor* qr, sc_vector* tau, uint64_t k0, uint64_t k1, void* b, uint64_t ldb, uint64_t cols,
+                          void* t, void* v, void* w, ccb_arena* arena) {
+    sc_TYPES type = qr->type;
+    uint64_t m = qr->dims->dims[0];
+    uint64_t lda = qr->dims->dims[1];
+    uint64_t nb = k1 - k0;
+    const struct factor_ops* ops = ops_of(type);
+
+    ops->qr_block(qr->data, lda, m, k0, k1, tau->data, t, v);
+    // W = V^T.B, W = T^T.W, B -= V.W
+    if (update(type, nb, cols, m - k0, v, 1, (int64_t)nb, at(b, k0 * ldb, type), (int64_t)ldb, 1, w, (int64_t)cols,
+               1.0, 0.0, arena) != 0) {
+        return -1;
+    }
+    ops->qr_apply_t(t, nb, w, cols);
+    return update(type, m - k0, cols, nb, v, (int64_t)nb, 1, w, (int64_t)cols, 1, at(b, k0 * ldb, type), (int64_t)ldb,
+                  -1.0, 1.0, arena);
+}
+
+
+static int check_tau(sc_tensor* qr, sc_vector* tau) {
+    CCB_NOTNULL(tau, "tau is NULL");
+    uint64_t k = (qr->dims->dims[0] < qr->dims->dims[1]) ? qr->dims->dims[0] : qr->dims->dims[1];
+    if (tau->type != qr->type || tau->size != k) {
+        CCB_ERROR("tau must have %" PRIu64 " elements of the type of the matrix", k);
+        return -1;
+    }
+    return 0;
+}
+
+
+int sc_qr_inplace(sc_tensor* a, sc_vector* tau, ccb_arena* arena) {
+    if (check_matrix(a, 0) != 0 || check_tau(a, tau) != 0) {
+        return -1;
+    }
+    sc_TYPES type = a->type;
+    uint64_t m = a->dims->dims[0];
+    uint64_t n = a->dims->dims[1];
+    uint64_t k = (m < n) ? m : n;
+    uint64_t size = sc_type_size(type);
+    void* t = ccb_arena_malloc(arena, FACTOR_QR_BLOCK * FACTOR_QR_BLOCK * size);
+    void* v = ccb_arena_malloc(arena, m * FACTOR_QR_BLOCK * size);
+    void* w = ccb_arena_malloc(arena, FACTOR_QR_BLOCK * n * size);
+    if (t == NULL || v == NULL || w == NULL) {
+        CCB_ERROR("Failed to allocate QR buffers");
+        return -1;
+    }
+
+    for (uint64_t k0 = 0; k0 < k; k0 += FACTOR_QR_BLOCK) {
+        uint64_t k1 = (k - k0 < FACTOR_QR_BLOCK) ? k : k0 + FACTOR_QR_BLOCK;
+        ops_of(type)->qr_panel(a->data, n, m, k0, k1, tau->data);
+        if (k1 < n && apply_block_qt(a, tau, k0, k1, at(a->data, k1, type), n, n - k1, t, v, w, arena) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+int sc_qr_apply_qt(sc_tensor* qr, sc_vector* tau, sc_tensor* b, ccb_arena* arena) {
+    uint64_t cols;
+    if (check_matrix(qr, 0) != 0 || check_tau(qr, tau) != 0 || check_rhs(qr, b, qr->dims->dims[0], &cols) != 0) {
+        return -1;
+    }
+    sc_TYPES type = qr->type;
+    uint64_t m = qr->dims->dims[0];
+    uint64_t size = sc_type_size(type);
+    void* t = ccb_arena_malloc(arena, FACTOR_QR_BLOCK * FACTOR_QR_BLOCK * size);
+    void* v = ccb_arena_malloc(arena, m * FACTOR_QR_BLOCK * size);
+    void* w = ccb_arena_malloc(arena, FACTOR_QR_BLOCK * cols * size);
+    if (t == NULL || v == NULL || w == NULL) {
+        CCB_ERROR("Failed to allocate QR buffers");
+        return -1;
+    }
+    for (uint64_t k0 = 0; k0 < tau->size; k0 += FACTOR_QR_BLOCK) {
+        uint64_t k1 = (tau->size - k0 < FACTOR_QR_BLOCK) ? tau->size : k0 + FACTOR_QR_BLOCK;
+        if (apply_block_qt(qr, tau, k0, k1, b->data, cols, cols, t, v, w, arena) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+int sc_qr_solve(sc_tensor* qr, sc_vector* tau, sc_tensor* b, ccb_arena* arena) {
+    if (check_matrix(qr, 0) != 0) {
+        return -1;
+    }
+    uint64_t m = qr->dims->dims[0];
+    uint64_t n = qr->dims->dims[1];
+    if (m < n) {
+        CCB_ERROR("Least squares need at least as many rows as columns (%" PRIu64 " x %" PRIu64 ")", m, n);
+        return -1;
+    }
+    if (sc_qr_apply_qt(qr, tau, b, arena) != 0) {
+        return -1;
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        double diagonal = (qr->type == sc_float64) ? ((double*)qr->data)[i * n + i] : (double)((float*)qr->data)[i * n + i];
+        if (diagonal == 0.0) {
+            return 1;
+        }
+    }
+    uint64_t cols = (b->dims->dims_count == 2) ? b->dims->dims[1] : 1;
+    return (trsm(qr->type, qr->data, n, n, 0, 0, 0, b->data, cols, cols, arena) == 0) ? 0 : -1;
+}
+
+
+// ################
+// solve and inverse
+// ################
+
+sc_tensor* sc_solve(sc_tensor* a, sc_tensor* b, ccb_arena* arena) {
+    uint64_t cols;
+    if (check_matrix(a, 1) != 0 || check_rhs(a, b, a->dims->dims[0], &cols) != 0) {
+        return NULL;
+    }
+    uint64_t n = a->dims->dims[0];
+    sc_tensor* lu = sc_create_tensor(sc_clone_dimensions(a->dims, arena), a->type, arena);
+    sc_tensor* x = sc_create_tensor(sc_clone_dimensions(b->dims, arena), b->type, arena);
+    uint64_t* pivots = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    CCB_NOTNULL(lu, "Failed to allocate LU factors");
+    CCB_NOTNULL(x, "Failed to allocate solution");
+    CCB_NOTNULL(pivots, "Failed to allocate pivots");
+    memcpy(lu->data, a->data, a->size * sc_type_size(a->type));
+    memcpy(x->data, b->data, b->size * sc_type_size(b->type));
+
+    int status = sc_lu_inplace(lu, pivots, arena);
+    if (status != 0) {
+        if (status > 0) {
+            CCB_ERROR("The matrix is singular");
+        }
+        return NULL;
+    }
+    return (sc_lu_solve(lu, pivots, x, arena) == 0) ? x : NULL;
+}
+
+
+sc_tensor* sc_inverse(sc_tensor* a, ccb_arena* arena) {
+    if (check_matrix(a, 1) != 0) {
+        return NULL;
+    }
+    uint64_t n = a->dims->dims[0];
+    sc_tensor* identity = sc_create_tensor(sc_clone_dimensions(a->dims, arena), a->type, arena);
+    CCB_NOTNULL(identity, "Failed to allocate identity");
+    memset(identity->data, 0, identity->size * sc_type_size(a->type));
+    for (uint64_t i = 0; i < n; i++) {
+        if (a->type == sc_float64) {
+            ((double*)identity->data)[i * n + i] = 1.0;
+        } else {
+            ((float*)identity->data)[i * n + i] = 1.0f;
+        }
+    }
+    return sc_solve(a, identity, arena);
+}
+
+
+// ##############
+// batched systems
+// ##############
+
+struct batch_args {
+    const struct factor_ops* ops;
+    sc_TYPES type;
+    void* a;
+    void* b;
+    uint64_t n;
+    uint64_t cols;
+    int cholesky;
+    uint64_t* pivots;       // n per thread
+    uint64_t* failures;     // per thread, padded
+};
+
+
+static int batch_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct batch_args* args = (struct batch_args*)raw;
+    uint64_t n = args->n;
+    uint64_t cols = args->cols;
+    uint64_t* pivots = args->pivots + thread_id * n;
+    uint64_t row_bytes = cols * sc_type_size(args->type);
+
+    for (uint64_t s = start; s < end; s++) {
+        void* a = at(args->a, s * n * n, args->type);
+        void* b = at(args->b, s * n * cols, args->type);
+        if (args->cholesky) {
+            if (args->ops->cholesky_block(a, n, 0, n, 0.0) != 0) {
+                args->failures[thread_id * FACTOR_LINE]++;
+                continue;
+            }
+            args->ops->trsm_block(a, n, 0, 1, 0, 0, n, b, cols, 0, cols);
+            args->ops->trsm_block(a, n, 1, 0, 0, 0, n, b, cols, 0, cols);
+        } else {
+            if (args->ops->lu_panel(a, n, n, 0, n, pivots) != 0) {
+                args->failures[thread_id * FACTOR_LINE]++;
+            }
+            for (uint64_t i = 0; i < n; i++) {
+                if (pivots[i] != i) {
+                    swap_rows(b, i, pivots[i], row_bytes);
+                }
+            }
+            args->ops->trsm_block(a, n, 0, 1, 1, 0, n, b, cols, 0, cols);
+            args->ops->trsm_block(a, n, 0, 0, 0, 0, n, b, cols, 0, cols);
+        }
+    }
+    return 0;
+}
+
+
+static int batched_solve(sc_tensor* a, sc_tensor* b, int cholesky, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(b, "b is NULL");
+    if (a->type != sc_float32 && a->type != sc_float64) {
+        CCB_ERROR("Batched solvers need float32 or float64 systems, got type %d", a->type);
+        return -1;
+    }
+    if (a->dims->dims_count != 3 || a->dims->dims[1] != a->dims->dims[2]) {
+        CCB_ERROR("Batched systems must be [batch, n, n]");
+        return -1;
+    }
+    uint64_t batch = a->dims->dims[0];
+    uint64_t n = a->dims->dims[1];
+    if (b->type != a->type || (b->dims->dims_count != 2 && b->dims->dims_count != 3) || b->dims->dims[0] != batch ||
+        b->dims->dims[1] != n) {
+        CCB_ERROR("Batched right hand sides must be [%" PRIu64 ", %" PRIu64 "] or [%" PRIu64 ", %" PRIu64 ", nrhs] of the type of the systems", batch, n, batch, n);
+        return -1;
+    }
+
+    uint64_t threads = sc_get_engine_thread_count();
+    struct batch_args args;
+    args.ops = ops_of(a->type);
+    args.type = a->type;
+    args.a = a->data;
+    args.b = b->data;
+    args.n = n;
+    args.cols = (b->dims->dims_count == 3) ? b->dims->dims[2] : 1;
+    args.cholesky = cholesky;
+    args.pivots = (uint64_t*)ccb_arena_malloc(arena, threads * (n + 1) * sizeof(uint64_t));
+    args.failures = (uint64_t*)ccb_arena_malloc(arena, threads * FACTOR_LINE * sizeof(uint64_t));
+    CCB_NOTNULL(args.pivots, "Failed to allocate pivots");
+    CCB_NOTNULL(args.failures, "Failed to allocate failure counters");
+    memset(args.failures, 0, threads * FACTOR_LINE * sizeof(uint64_t));
+
+    if (batch > 0 && sc_run_range_task(batch_kernel, &args, batch, batch * n * n * (n + args.cols), arena) != 0) {
+        CCB_ERROR("Failed to run batched solve");
+        return -1;
+    }
+    uint64_t failures = 0;
+    for (uint64_t t = 0; t < threads; t++) {
+        failures += args.failures[t * FACTOR_LINE];
+    }
+    return (int)failures;
+}
+
+
+int sc_batched_lu_solve(sc_tensor* a, sc_tensor* b, ccb_arena* arena) {
+    return batched_solve(a, b, 0, arena);
+}
+
+
+int sc_batched_cholesky_solve(sc_tensor* a, sc_tensor* b, ccb_arena* arena) {
+    return batched_solve(a, b, 1, arena);
+}
@@ -0,0 +1,76 @@
+#ifndef __FACTOR_H__
+#define __FACTOR_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    dense factorisations and solvers on row major [n, n] (or [m, n]) float32 / float64 tensors
+    LU (partial pivoting), Cholesky and Householder QR are blocked and right looking: a panel is factored
+    with scalar loops, then the trailing matrix is updated with one gemm (run on the engine thread pool)
+    QR applies a block of reflectors at once in compact WY form (I - V.T.V^T)
+    right hand sides are [n] vectors or [n, nrhs] tensors of the type of the matrix, solved in place
+    the batched solvers factor [batch, n, n] stacks of small systems (8 - 64), one system per work unit
+*/
+
+/* LU factorisation with partial pivoting, P.A = L.U
+   - sc_tensor* a: square matrix, overwritten by L (unit lower, below the diagonal) and U
+   - uint64_t* pivots: n entries, row i was swapped with row pivots[i] (in order)
+   - ccb_arena* arena: arena where the tasks and the gemm buffers will be allocated
+   - return: 0 on success, 1 when a pivot is exactly 0 (the factorisation is finished but U is singular), -1 on error
+*/
+int sc_lu_inplace(sc_tensor* a, uint64_t* pivots, ccb_arena* arena);
+/* Solves A.x = b from the LU factorisation, b is overwritten by x */
+int sc_lu_solve(sc_tensor* lu, const uint64_t* pivots, sc_tensor* b, ccb_arena* arena);
+
+/* Cholesky factorisation A = L.L^T of a symmetric positive definite matrix (only the lower triangle is read)
+   - sc_tensor* a: overwritten by L, its strict upper triangle is set to 0
+   - double tolerance: the pivots (squared diagonal of L) must be above it
+   - return: 0 on success, 1 when the matrix is not positive definite (a is left partially factored), -1 on error
+*/
+int sc_cholesky_inplace(sc_tensor* a, double tolerance, ccb_arena* arena);
+/* Solves A.x = b from the Cholesky factor L, b is overwritten by x */
+int sc_cholesky_solve(sc_tensor* l, sc_tensor* b, ccb_arena* arena);
+
+/* Householder QR factorisation A = Q.R of a [m, n] matrix
+   - sc_tensor* a: overwritten by R (upper triangle) and the reflectors below the diagonal (unit first entry implied)
+   - sc_vector* tau: min(m, n) scales of the reflectors H = I - tau.v.v^T, same type as a
+   - return: 0 on success
+*/
+int sc_qr_inplace(sc_tensor* a, sc_vector* tau, ccb_arena* arena);
+/* b = Q^T.b, b has m rows */
+int sc_qr_apply_qt(sc_tensor* qr, sc_vector* tau, sc_tensor* b, ccb_arena* arena);
+/* Least squares solution of A.x = b (m >= n), b ([m] or [m, nrhs]) is overwritten, x is in its first n rows
+   - return: 0 on success, 1 when R has a zero on its diagonal, -1 on error
+*/
+int sc_qr_solve(sc_tensor* qr, sc_vector* tau, sc_tensor* b, ccb_arena* arena);
+
+/* Triangular solve op(T).X = B in place in B
+   - sc_tensor* t: square triangular matrix, the other triangle is not read
+   - sc_tensor* b: [n] or [n, nrhs]
+   - int lower: T is lower triangular, int trans: op(T) = T^T, int unit_diag: the diagonal of T is taken as 1
+   - return: 0 on success
+*/
+int sc_trsm(sc_tensor* t, sc_tensor* b, int lower, int trans, int unit_diag, ccb_arena* arena);
+
+/* Solution of A.x = b with LU, a and b are not modified
+   - return: a pointer to x (shape of b), NULL when A is singular
+*/
+sc_tensor* sc_solve(sc_tensor* a, sc_tensor* b, ccb_arena* arena);
+/* Inverse of a square matrix with LU, NULL when it is singular */
+sc_tensor* sc_inverse(sc_tensor* a, ccb_arena* arena);
+
+/* Solves a stack of small systems with LU (partial pivoting), a and b are overwritten by the factors and the solutions
+   - sc_tensor* a: [batch, n, n]
+   - sc_tensor* b: [batch, n] or [batch, n, nrhs], same type as a
+   - return: the number of singular systems (0 when all were solved, their solutions are not finite otherwise), -1 on error
+*/
+int sc_batched_lu_solve(sc_tensor* a, sc_tensor* b, ccb_arena* arena);
+/* Same as sc_batched_lu_solve for symmetric positive definite systems with Cholesky
+   - return: the number of systems that are not positive definite, -1 on error
+*/
+int sc_batched_cholesky_solve(sc_tensor* a, sc_tensor* b, ccb_arena* arena);
+
+
+#endif // __FACTOR_H__
@@ -1162,6 +1162,3239 @@ void gen_test_get_slice_tensor(FILE* file, test_data test) {
 
 
 
+void gen_test_layer_norm(FILE* file, test_data test) {
+    fprintf(file, "int test_layer_norm_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    double tol = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){3, 21}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* dy = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){3, 21}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* gamma = sc_create_vector(21, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* beta = sc_create_vector(21, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* dgamma = sc_create_vector(21, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* dbeta = sc_create_vector(21, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector xv = {x->data, x->size, x->type};\n");
+    fprintf(file, "    sc_vector dyv = {dy->data, dy->size, dy->type};\n\n");
+    fprintf(file, "    for (uint64_t i = 0; i < 63; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&xv, i, to_sc_value((double)(i %% 7) - 3.0 + 0.25 * (double)(i / 21), %s));\n", test.sc_type);
+    fprintf(file, "        sc_set_vector_element(&dyv, i, to_sc_value((double)(i %% 5) * 0.5 - 1.0, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t j = 0; j < 21; j++) {\n");
+    fprintf(file, "        sc_set_vector_element(gamma, j, to_sc_value(1.0 + 0.125 * (double)(j %% 4), %s));\n", test.sc_type);
+    fprintf(file, "        sc_set_vector_element(beta, j, to_sc_value(0.5, %s));\n", test.sc_type);
+    fprintf(file, "    }\n\n");
+    fprintf(file, "    sc_norm_stats stats;\n");
+    fprintf(file, "    sc_tensor* y = sc_layer_norm(x, gamma, beta, 1e-5, &stats, arena);\n");
+    fprintf(file, "    sc_tensor* dx = sc_layer_norm_backward(dy, x, gamma, &stats, dgamma, dbeta, arena);\n");
+    fprintf(file, "    if (!y || !dx) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run the layer norm\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector yv = {y->data, y->size, y->type};\n");
+    fprintf(file, "    sc_vector dxv = {dx->data, dx->size, dx->type};\n\n");
+    fprintf(file, "    double dgamma_ref[21] = {0}, dbeta_ref[21] = {0};\n");
+    fprintf(file, "    for (uint64_t r = 0; r < 3; r++) {\n");
+    fprintf(file, "        double mean = 0.0, var = 0.0, sum_g = 0.0, sum_gx = 0.0;\n");
+    fprintf(file, "        for (uint64_t j = 0; j < 21; j++) mean += sc_value_to_f64(sc_get_vector_element(&xv, r*21 + j)) / 21.0;\n");
+    fprintf(file, "        for (uint64_t j = 0; j < 21; j++) {\n");
+    fprintf(file, "            double d = sc_value_to_f64(sc_get_vector_element(&xv, r*21 + j)) - mean;\n");
+    fprintf(file, "            var += d * d / 21.0;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        double rstd = 1.0 / sqrt(var + 1e-5);\n");
+    fprintf(file, "        for (uint64_t j = 0; j < 21; j++) {\n");
+    fprintf(file, "            double xhat = (sc_value_to_f64(sc_get_vector_element(&xv, r*21 + j)) - mean) * rstd;\n");
+    fprintf(file, "            double g = sc_value_to_f64(sc_get_vector_element(&dyv, r*21 + j)) * sc_value_to_f64(sc_get_vector_element(gamma, j));\n");
+    fprintf(file, "            sum_g += g;\n");
+    fprintf(file, "            sum_gx += g * xhat;\n");
+    fprintf(file, "            dgamma_ref[j] += sc_value_to_f64(sc_get_vector_element(&dyv, r*21 + j)) * xhat;\n");
+    fprintf(file, "            dbeta_ref[j] += sc_value_to_f64(sc_get_vector_element(&dyv, r*21 + j));\n");
+    fprintf(file, "            double expected = xhat * sc_value_to_f64(sc_get_vector_element(gamma, j)) + 0.5;\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(&yv, r*21 + j));\n");
+    fprintf(file, "            if (fabs(got - expected) > tol * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                CCB_WARNING(\"Layer norm mismatch at [%%u, %%u]: expected %%f, got %%f\", r, j, expected, got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t j = 0; j < 21; j++) {\n");
+    fprintf(file, "            double xhat = (sc_value_to_f64(sc_get_vector_element(&xv, r*21 + j)) - mean) * rstd;\n");
+    fprintf(file, "            double g = sc_value_to_f64(sc_get_vector_element(&dyv, r*21 + j)) * sc_value_to_f64(sc_get_vector_element(gamma, j));\n");
+    fprintf(file, "            double expected = rstd * (g - sum_g / 21.0 - xhat * sum_gx / 21.0);\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(&dxv, r*21 + j));\n");
+    fprintf(file, "            if (fabs(got - expected) > tol * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                CCB_WARNING(\"Layer norm gradient mismatch at [%%u, %%u]: expected %%f, got %%f\", r, j, expected, got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n\n");
+    fprintf(file, "    for (uint64_t j = 0; j < 21; j++) {\n");
+    fprintf(file, "        double got_gamma = sc_value_to_f64(sc_get_vector_element(dgamma, j));\n");
+    fprintf(file, "        double got_beta = sc_value_to_f64(sc_get_vector_element(dbeta, j));\n");
+    fprintf(file, "        if (fabs(got_gamma - dgamma_ref[j]) > tol * (1.0 + fabs(dgamma_ref[j])) || fabs(got_beta - dbeta_ref[j]) > tol * (1.0 + fabs(dbeta_ref[j]))) {\n");
+    fprintf(file, "            CCB_WARNING(\"Layer norm parameter gradient mismatch at %%u\", j);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n\n");
+}
+
+void gen_test_rms_norm(FILE* file, test_data test) {
+    fprintf(file, "int test_rms_norm_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    double tol = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(3, arena, (uint64_t[]){2, 2, 19}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector xv = {x->data, x->size, x->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < 76; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&xv, i, to_sc_value((double)(i %% 9) - 4.0, %s));\n", test.sc_type);
+    fprintf(file, "    }\n\n");
+    fprintf(file, "    sc_tensor* y = sc_rms_norm(x, NULL, 1e-6, NULL, arena);\n");
+    fprintf(file, "    if (!y) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run the rms norm\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector yv = {y->data, y->size, y->type};\n\n");
+    fprintf(file, "    for (uint64_t r = 0; r < 4; r++) {\n");
+    fprintf(file, "        double ms = 0.0;\n");
+    fprintf(file, "        for (uint64_t j = 0; j < 19; j++) {\n");
+    fprintf(file, "            double v = sc_value_to_f64(sc_get_vector_element(&xv, r*19 + j));\n");
+    fprintf(file, "            ms += v * v / 19.0;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t j = 0; j < 19; j++) {\n");
+    fprintf(file, "            double expected = sc_value_to_f64(sc_get_vector_element(&xv, r*19 + j)) / sqrt(ms + 1e-6);\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(&yv, r*19 + j));\n");
+    fprintf(file, "            if (fabs(got - expected) > tol * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                CCB_WARNING(\"RMS norm mismatch at [%%u, %%u]: expected %%f, got %%f\", r, j, expected, got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n\n");
+}
+
+void gen_test_batch_norm(FILE* file, test_data test) {
+    fprintf(file, "int test_batch_norm_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    double tol = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    sc_TYPES stats_type = (%s == sc_float64) ? sc_float64 : sc_float32;\n", test.sc_type);
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){40, 11}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* running_mean = sc_create_vector(11, stats_type, arena);\n");
+    fprintf(file, "    sc_vector* running_var = sc_create_vector(11, stats_type, arena);\n");
+    fprintf(file, "    sc_vector xv = {x->data, x->size, x->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < 440; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&xv, i, to_sc_value((double)((i * 7) %% 13) + (double)(i %% 11), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t c = 0; c < 11; c++) {\n");
+    fprintf(file, "        sc_set_vector_element(running_mean, c, to_sc_value(0.0, stats_type));\n");
+    fprintf(file, "        sc_set_vector_element(running_var, c, to_sc_value(1.0, stats_type));\n");
+    fprintf(file, "    }\n\n");
+    fprintf(file, "    sc_norm_stats stats;\n");
+    fprintf(file, "    sc_tensor* y = sc_batch_norm(x, NULL, NULL, running_mean, running_var, 1.0, 1e-5, &stats, arena);\n");
+    fprintf(file, "    if (!y) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run the batch norm\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector yv = {y->data, y->size, y->type};\n\n");
+    fprintf(file, "    for (uint64_t c = 0; c < 11; c++) {\n");
+    fprintf(file, "        double mean = 0.0, var = 0.0;\n");
+    fprintf(file, "        for (uint64_t r = 0; r < 40; r++) mean += sc_value_to_f64(sc_get_vector_element(&xv, r*11 + c)) / 40.0;\n");
+    fprintf(file, "        for (uint64_t r = 0; r < 40; r++) {\n");
+    fprintf(file, "            double d = sc_value_to_f64(sc_get_vector_element(&xv, r*11 + c)) - mean;\n");
+    fprintf(file, "            var += d * d / 40.0;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        double got_mean = sc_value_to_f64(sc_get_vector_element(running_mean, c));\n");
+    fprintf(file, "        double got_var = sc_value_to_f64(sc_get_vector_element(running_var, c));\n");
+    fprintf(file, "        if (fabs(got_mean - mean) > 1e-4 * (1.0 + mean) || fabs(got_var - var * 40.0 / 39.0) > 1e-4 * (1.0 + var)) {\n");
+    fprintf(file, "            CCB_WARNING(\"Batch norm running statistics mismatch at %%u: mean %%f vs %%f, var %%f vs %%f\", c, got_mean, mean, got_var, var * 40.0 / 39.0);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t r = 0; r < 40; r++) {\n");
+    fprintf(file, "            double expected = (sc_value_to_f64(sc_get_vector_element(&xv, r*11 + c)) - mean) / sqrt(var + 1e-5);\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(&yv, r*11 + c));\n");
+    fprintf(file, "            if (fabs(got - expected) > tol * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                CCB_WARNING(\"Batch norm mismatch at [%%u, %%u]: expected %%f, got %%f\", r, c, expected, got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n\n");
+}
+
+void gen_test_tensor_matmul(FILE* file, test_data test) {
+    fprintf(file, "int test_tensor_matmul_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    double tol = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    sc_tensor* a = sc_create_tensor(sc_create_dimensions(3, arena, (uint64_t[]){2, 7, 30}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* b = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){30, 19}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector av = {a->data, a->size, a->type};\n");
+    fprintf(file, "    sc_vector bv = {b->data, b->size, b->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < a->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&av, i, to_sc_value((double)(i %% 7) * 0.25 - 0.75, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < b->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&bv, i, to_sc_value((double)(i %% 5) * 0.5 - 1.0, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_tensor* out = sc_tensor_matmul(a, b, arena);\n");
+    fprintf(file, "    if (!out || out->dims->dims_count != 3 || out->dims->dims[0] != 2 || out->dims->dims[1] != 7 || out->dims->dims[2] != 19) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to compute the tensor matmul\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector ov = {out->data, out->size, out->type};\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t i = 0; i < 14; i++) {\n");
+    fprintf(file, "        for (uint64_t j = 0; j < 19; j++) {\n");
+    fprintf(file, "            double expected = 0.0;\n");
+    fprintf(file, "            for (uint64_t k = 0; k < 30; k++) {\n");
+    fprintf(file, "                expected += sc_value_to_f64(sc_get_vector_element(&av, i*30 + k)) * sc_value_to_f64(sc_get_vector_element(&bv, k*19 + j));\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(&ov, i*19 + j));\n");
+    fprintf(file, "            if (fabs(got - expected) > tol * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                CCB_WARNING(\"Matmul mismatch at [%%u, %%u]: expected %%f, got %%f\", i, j, expected, got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_conv2d(FILE* file, test_data test) {
+    fprintf(file, "int test_conv2d_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    double tol = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(4, arena, (uint64_t[]){2, 3, 9, 11}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* w = sc_create_tensor(sc_create_dimensions(4, arena, (uint64_t[]){5, 3, 3, 3}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* bias = sc_create_vector(5, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector xv = {x->data, x->size, x->type};\n");
+    fprintf(file, "    sc_vector wv = {w->data, w->size, w->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < x->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&xv, i, to_sc_value((double)((i * 5) %% 11) * 0.25 - 1.0, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < w->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&wv, i, to_sc_value((double)(i %% 7) * 0.125 - 0.375, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < 5; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(bias, i, to_sc_value((double)i * 0.5, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // (stride, padding, dilation) for each algorithm\n");
+    fprintf(file, "    uint64_t configs[3][3] = {{1, 1, 1}, {2, 1, 1}, {1, 2, 2}};\n");
+    fprintf(file, "    sc_conv_algorithm algorithms[2] = {sc_conv_direct, sc_conv_im2col};\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t c = 0; c < 3; c++) {\n");
+    fprintf(file, "        for (uint64_t a = 0; a < 2; a++) {\n");
+    fprintf(file, "            uint64_t s = configs[c][0], p = configs[c][1], d = configs[c][2];\n");
+    fprintf(file, "            sc_conv_params params = sc_conv2d_params(s, p, d);\n");
+    fprintf(file, "            params.algorithm = algorithms[a];\n");
+    fprintf(file, "\n");
+    fprintf(file, "            sc_tensor* y = sc_conv2d(x, w, bias, params, arena, arena);\n");
+    fprintf(file, "            uint64_t oh_count = (9 + 2*p - d*2 - 1) / s + 1;\n");
+    fprintf(file, "            uint64_t ow_count = (11 + 2*p - d*2 - 1) / s + 1;\n");
+    fprintf(file, "            if (!y || y->dims->dims[2] != oh_count || y->dims->dims[3] != ow_count) {\n");
+    fprintf(file, "                CCB_WARNING(\"Failed to run the conv2d (config %%u, algorithm %%u)\", c, a);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            sc_vector yv = {y->data, y->size, y->type};\n");
+    fprintf(file, "\n");
+    fprintf(file, "            for (uint64_t n = 0; n < 2; n++) {\n");
+    fprintf(file, "                for (uint64_t oc = 0; oc < 5; oc++) {\n");
+    fprintf(file, "                    for (uint64_t oh = 0; oh < oh_count; oh++) {\n");
+    fprintf(file, "                        for (uint64_t ow = 0; ow < ow_count; ow++) {\n");
+    fprintf(file, "                            double expected = (double)oc * 0.5;\n");
+    fprintf(file, "                            for (uint64_t ic = 0; ic < 3; ic++) {\n");
+    fprintf(file, "                                for (uint64_t kh = 0; kh < 3; kh++) {\n");
+    fprintf(file, "                                    for (uint64_t kw = 0; kw < 3; kw++) {\n");
+    fprintf(file, "                                        int64_t ih = (int64_t)(oh*s + kh*d) - (int64_t)p;\n");
+    fprintf(file, "                                        int64_t iw = (int64_t)(ow*s + kw*d) - (int64_t)p;\n");
+    fprintf(file, "                                        if (ih < 0 || ih >= 9 || iw < 0 || iw >= 11) continue;\n");
+    fprintf(file, "                                        expected += sc_value_to_f64(sc_get_vector_element(&xv, ((n*3 + ic)*9 + ih)*11 + iw))\n");
+    fprintf(file, "                                                  * sc_value_to_f64(sc_get_vector_element(&wv, ((oc*3 + ic)*3 + kh)*3 + kw));\n");
+    fprintf(file, "                                    }\n");
+    fprintf(file, "                                }\n");
+    fprintf(file, "                            }\n");
+    fprintf(file, "                            double got = sc_value_to_f64(sc_get_vector_element(&yv, ((n*5 + oc)*oh_count + oh)*ow_count + ow));\n");
+    fprintf(file, "                            if (fabs(got - expected) > tol * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                                CCB_WARNING(\"Conv2d mismatch (config %%u, algorithm %%u) at [%%u, %%u, %%u, %%u]: expected %%f, got %%f\", c, a, n, oc, oh, ow, expected, got);\n");
+    fprintf(file, "                                return -1;\n");
+    fprintf(file, "                            }\n");
+    fprintf(file, "                        }\n");
+    fprintf(file, "                    }\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_conv1d(FILE* file, test_data test) {
+    fprintf(file, "int test_conv1d_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    double tol = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(3, arena, (uint64_t[]){2, 12, 40}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* w = sc_create_tensor(sc_create_dimensions(3, arena, (uint64_t[]){7, 12, 5}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector xv = {x->data, x->size, x->type};\n");
+    fprintf(file, "    sc_vector wv = {w->data, w->size, w->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < x->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&xv, i, to_sc_value((double)((i * 3) %% 13) * 0.125 - 0.75, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < w->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&wv, i, to_sc_value((double)(i %% 9) * 0.125 - 0.5, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // the stride of 2 makes the auto mode use im2col\n");
+    fprintf(file, "    sc_tensor* y = sc_conv1d(x, w, NULL, sc_conv1d_params(2, 3, 2), arena, arena);\n");
+    fprintf(file, "    uint64_t ol_count = (40 + 6 - 8 - 1) / 2 + 1;\n");
+    fprintf(file, "    if (!y || y->dims->dims_count != 3 || y->dims->dims[1] != 7 || y->dims->dims[2] != ol_count) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run the conv1d\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector yv = {y->data, y->size, y->type};\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t n = 0; n < 2; n++) {\n");
+    fprintf(file, "        for (uint64_t oc = 0; oc < 7; oc++) {\n");
+    fprintf(file, "            for (uint64_t ol = 0; ol < ol_count; ol++) {\n");
+    fprintf(file, "                double expected = 0.0;\n");
+    fprintf(file, "                for (uint64_t ic = 0; ic < 12; ic++) {\n");
+    fprintf(file, "                    for (uint64_t k = 0; k < 5; k++) {\n");
+    fprintf(file, "                        int64_t il = (int64_t)(ol*2 + k*2) - 3;\n");
+    fprintf(file, "                        if (il < 0 || il >= 40) continue;\n");
+    fprintf(file, "                        expected += sc_value_to_f64(sc_get_vector_element(&xv, (n*12 + ic)*40 + il))\n");
+    fprintf(file, "                                  * sc_value_to_f64(sc_get_vector_element(&wv, (oc*12 + ic)*5 + k));\n");
+    fprintf(file, "                    }\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "                double got = sc_value_to_f64(sc_get_vector_element(&yv, (n*7 + oc)*ol_count + ol));\n");
+    fprintf(file, "                if (fabs(got - expected) > tol * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                    CCB_WARNING(\"Conv1d mismatch at [%%u, %%u, %%u]: expected %%f, got %%f\", n, oc, ol, expected, got);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_pool2d(FILE* file, test_data test) {
+    fprintf(file, "int test_pool2d_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    double tol = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(4, arena, (uint64_t[]){2, 3, 7, 10}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector xv = {x->data, x->size, x->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < x->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&xv, i, to_sc_value((double)((i * 7) %% 17) * 0.25 - 2.0, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_tensor* max_y = sc_max_pool2d(x, sc_pool2d_params(3, 2, 1), arena);\n");
+    fprintf(file, "    sc_tensor* avg_y = sc_avg_pool2d(x, sc_pool2d_params(3, 2, 1), arena);\n");
+    fprintf(file, "    if (!max_y || !avg_y || max_y->dims->dims[2] != 4 || max_y->dims->dims[3] != 5) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run the pooling\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector max_v = {max_y->data, max_y->size, max_y->type};\n");
+    fprintf(file, "    sc_vector avg_v = {avg_y->data, avg_y->size, avg_y->type};\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t plane = 0; plane < 6; plane++) {\n");
+    fprintf(file, "        for (uint64_t oh = 0; oh < 4; oh++) {\n");
+    fprintf(file, "            for (uint64_t ow = 0; ow < 5; ow++) {\n");
+    fprintf(file, "                double max = -INFINITY, sum = 0.0, count = 0.0;\n");
+    fprintf(file, "                for (uint64_t kh = 0; kh < 3; kh++) {\n");
+    fprintf(file, "                    for (uint64_t kw = 0; kw < 3; kw++) {\n");
+    fprintf(file, "                        int64_t ih = (int64_t)(oh*2 + kh) - 1;\n");
+    fprintf(file, "                        int64_t iw = (int64_t)(ow*2 + kw) - 1;\n");
+    fprintf(file, "                        if (ih < 0 || ih >= 7 || iw < 0 || iw >= 10) continue;\n");
+    fprintf(file, "                        double v = sc_value_to_f64(sc_get_vector_element(&xv, (plane*7 + ih)*10 + iw));\n");
+    fprintf(file, "                        max = (v > max) ? v : max;\n");
+    fprintf(file, "                        sum += v;\n");
+    fprintf(file, "                        count += 1.0;\n");
+    fprintf(file, "                    }\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "                double got_max = sc_value_to_f64(sc_get_vector_element(&max_v, (plane*4 + oh)*5 + ow));\n");
+    fprintf(file, "                double got_avg = sc_value_to_f64(sc_get_vector_element(&avg_v, (plane*4 + oh)*5 + ow));\n");
+    fprintf(file, "                if (fabs(got_max - max) > tol * (1.0 + fabs(max)) || fabs(got_avg - sum / count) > tol * (1.0 + fabs(sum / count))) {\n");
+    fprintf(file, "                    CCB_WARNING(\"Pooling mismatch at [%%u, %%u, %%u]: max %%f vs %%f, avg %%f vs %%f\", plane, oh, ow, got_max, max, got_avg, sum / count);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_transpose(FILE* file, test_data test) {
+    fprintf(file, "int test_transpose_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // 37 x 70 covers the full SIMD blocks, the borders and two tiles per row\n");
+    fprintf(file, "    sc_tensor* a = sc_create_tensor(sc_create_dimensions(3, arena, (uint64_t[]){3, 37, 70}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector av = {a->data, a->size, a->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < a->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&av, i, to_sc_value((double)(i %% 251), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_tensor* t = sc_tensor_transpose(a, arena);\n");
+    fprintf(file, "    if (!t || t->dims->dims_count != 3 || t->dims->dims[0] != 3 || t->dims->dims[1] != 70 || t->dims->dims[2] != 37) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to transpose the tensor\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector tv = {t->data, t->size, t->type};\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t b = 0; b < 3; b++) {\n");
+    fprintf(file, "        for (uint64_t i = 0; i < 37; i++) {\n");
+    fprintf(file, "            for (uint64_t j = 0; j < 70; j++) {\n");
+    fprintf(file, "                double expected = sc_value_to_f64(sc_get_vector_element(&av, (b*37 + i)*70 + j));\n");
+    fprintf(file, "                double got = sc_value_to_f64(sc_get_vector_element(&tv, (b*70 + j)*37 + i));\n");
+    fprintf(file, "                if (got != expected) {\n");
+    fprintf(file, "                    CCB_WARNING(\"Transpose mismatch at [%%u, %%u, %%u]: expected %%f, got %%f\", b, i, j, expected, got);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_transpose_int(FILE* file, test_data test) {
+    fprintf(file, "int test_transpose_int_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // the integer types have their own element size (4, 8 and 1 bytes), 3 x 5 is below a tile, 37 x 70 covers\n");
+    fprintf(file, "    // the full SIMD blocks and the borders\n");
+    fprintf(file, "    sc_TYPES types[] = {sc_int32, sc_int64, sc_uint8};\n");
+    fprintf(file, "    uint64_t shapes[2][2] = {{3, 5}, {37, 70}};\n");
+    fprintf(file, "    for (uint64_t t = 0; t < 3; t++) {\n");
+    fprintf(file, "        for (uint64_t s = 0; s < 2; s++) {\n");
+    fprintf(file, "            uint64_t rows = shapes[s][0];\n");
+    fprintf(file, "            uint64_t cols = shapes[s][1];\n");
+    fprintf(file, "            sc_tensor* a = sc_create_tensor(sc_create_dimensions(3, arena, (uint64_t[]){2, rows, cols}), types[t], arena);\n");
+    fprintf(file, "            sc_vector av = {a->data, a->size, a->type};\n");
+    fprintf(file, "            for (uint64_t i = 0; i < a->size; i++) {\n");
+    fprintf(file, "                sc_set_vector_element(&av, i, to_sc_value((double)(i %% 251), types[t]));\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "\n");
+    fprintf(file, "            sc_tensor* tr = sc_tensor_transpose(a, arena);\n");
+    fprintf(file, "            if (!tr || tr->type != types[t] || tr->dims->dims[1] != cols || tr->dims->dims[2] != rows) {\n");
+    fprintf(file, "                CCB_WARNING(\"Failed to transpose the integer tensor (type %%u)\", types[t]);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            sc_vector tv = {tr->data, tr->size, tr->type};\n");
+    fprintf(file, "\n");
+    fprintf(file, "            for (uint64_t b = 0; b < 2; b++) {\n");
+    fprintf(file, "                for (uint64_t i = 0; i < rows; i++) {\n");
+    fprintf(file, "                    for (uint64_t j = 0; j < cols; j++) {\n");
+    fprintf(file, "                        int64_t expected = sc_value_to_i64(sc_get_vector_element(&av, (b*rows + i)*cols + j));\n");
+    fprintf(file, "                        int64_t got = sc_value_to_i64(sc_get_vector_element(&tv, (b*cols + j)*rows + i));\n");
+    fprintf(file, "                        if (got != expected) {\n");
+    fprintf(file, "                            CCB_WARNING(\"Integer transpose mismatch (type %%u) at [%%u, %%u, %%u]: expected %%d, got %%d\", types[t], b, i, j, (int)expected, (int)got);\n");
+    fprintf(file, "                            return -1;\n");
+    fprintf(file, "                        }\n");
+    fprintf(file, "                    }\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_permute_nhwc(FILE* file, test_data test) {
+    fprintf(file, "int test_permute_nhwc_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(4, arena, (uint64_t[]){2, 5, 9, 11}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector xv = {x->data, x->size, x->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < x->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&xv, i, to_sc_value((double)(i %% 251), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // NCHW -> NHWC and back\n");
+    fprintf(file, "    sc_tensor* y = sc_tensor_permute(x, (uint64_t[]){0, 2, 3, 1}, arena);\n");
+    fprintf(file, "    if (!y || y->dims->dims[0] != 2 || y->dims->dims[1] != 9 || y->dims->dims[2] != 11 || y->dims->dims[3] != 5) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to permute NCHW to NHWC\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector yv = {y->data, y->size, y->type};\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t n = 0; n < 2; n++) {\n");
+    fprintf(file, "        for (uint64_t c = 0; c < 5; c++) {\n");
+    fprintf(file, "            for (uint64_t h = 0; h < 9; h++) {\n");
+    fprintf(file, "                for (uint64_t w = 0; w < 11; w++) {\n");
+    fprintf(file, "                    double expected = sc_value_to_f64(sc_get_vector_element(&xv, ((n*5 + c)*9 + h)*11 + w));\n");
+    fprintf(file, "                    double got = sc_value_to_f64(sc_get_vector_element(&yv, ((n*9 + h)*11 + w)*5 + c));\n");
+    fprintf(file, "                    if (got != expected) {\n");
+    fprintf(file, "                        CCB_WARNING(\"NHWC mismatch at [%%u, %%u, %%u, %%u]: expected %%f, got %%f\", n, c, h, w, expected, got);\n");
+    fprintf(file, "                        return -1;\n");
+    fprintf(file, "                    }\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_tensor* z = sc_tensor_permute(y, (uint64_t[]){0, 3, 1, 2}, arena);\n");
+    fprintf(file, "    if (!z || memcmp(z->data, x->data, x->size * sc_type_size(x->type)) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"NHWC -> NCHW is not the inverse permutation\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_permute_nd(FILE* file, test_data test) {
+    fprintf(file, "int test_permute_nd_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // the axis of size 1 is dropped and the axes 2, 3 stay adjacent and are merged\n");
+    fprintf(file, "    uint64_t dims[5] = {3, 1, 4, 5, 6};\n");
+    fprintf(file, "    uint64_t axes[5] = {2, 3, 0, 1, 4};\n");
+    fprintf(file, "    sc_tensor* a = sc_create_tensor(sc_create_dimensions(5, arena, dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector av = {a->data, a->size, a->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < a->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&av, i, to_sc_value((double)(i %% 251), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t r = 0; r < 2; r++) {\n");
+    fprintf(file, "        if (r == 1) {\n");
+    fprintf(file, "            // no merge left: the innermost axis moves\n");
+    fprintf(file, "            axes[0] = 4; axes[1] = 2; axes[2] = 0; axes[3] = 1; axes[4] = 3;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_tensor* p = sc_tensor_permute(a, axes, arena);\n");
+    fprintf(file, "        if (!p || p->dims->dims_count != 5) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to permute the tensor (case %%u)\", r);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_vector pv = {p->data, p->size, p->type};\n");
+    fprintf(file, "\n");
+    fprintf(file, "        uint64_t out_dims[5];\n");
+    fprintf(file, "        for (uint64_t k = 0; k < 5; k++) {\n");
+    fprintf(file, "            out_dims[k] = dims[axes[k]];\n");
+    fprintf(file, "            if (p->dims->dims[k] != out_dims[k]) {\n");
+    fprintf(file, "                CCB_WARNING(\"Wrong permuted dimension %%u (case %%u)\", k, r);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "\n");
+    fprintf(file, "        for (uint64_t o = 0; o < p->size; o++) {\n");
+    fprintf(file, "            uint64_t index[5];\n");
+    fprintf(file, "            uint64_t rest = o;\n");
+    fprintf(file, "            for (uint64_t k = 5; k > 0; k--) {\n");
+    fprintf(file, "                index[axes[k - 1]] = rest %% out_dims[k - 1];\n");
+    fprintf(file, "                rest /= out_dims[k - 1];\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            uint64_t src = 0;\n");
+    fprintf(file, "            for (uint64_t k = 0; k < 5; k++) {\n");
+    fprintf(file, "                src = src * dims[k] + index[k];\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            double expected = sc_value_to_f64(sc_get_vector_element(&av, src));\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(&pv, o));\n");
+    fprintf(file, "            if (got != expected) {\n");
+    fprintf(file, "                CCB_WARNING(\"Permute mismatch at %%u (case %%u): expected %%f, got %%f\", o, r, expected, got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_sparse_vector(FILE* file, test_data test) {
+    fprintf(file, "int test_sparse_vector_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    double tol = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    sc_vector* a = sc_create_vector(53, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* b = sc_create_vector(53, %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < 53; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(a, i, to_sc_value((i %% 5 == 2) ? (double)(i %% 7) * 0.25 - 0.5 : 0.0, %s));\n", test.sc_type);
+    fprintf(file, "        sc_set_vector_element(b, i, to_sc_value((double)(i %% 11) * 0.125 - 0.5, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_sparse_vector* s = sc_dense_to_sparse_vector(a, arena);\n");
+    fprintf(file, "    if (!s || s->size != 53) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to convert the vector to sparse\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t k = 0; k < s->nnz; k++) {\n");
+    fprintf(file, "        if (s->indices[k] %% 5 != 2 || (k > 0 && s->indices[k] <= s->indices[k - 1])) {\n");
+    fprintf(file, "            CCB_WARNING(\"Wrong sparse index %%u at %%u\", s->indices[k], k);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    double expected_dot = 0.0;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < 53; i++) {\n");
+    fprintf(file, "        expected_dot += sc_value_to_f64(sc_get_vector_element(a, i)) * sc_value_to_f64(sc_get_vector_element(b, i));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double dot = sc_value_to_f64(sc_sparse_vector_dot(s, b));\n");
+    fprintf(file, "    if (fabs(dot - expected_dot) > tol * (1.0 + fabs(expected_dot))) {\n");
+    fprintf(file, "        CCB_WARNING(\"Sparse dot mismatch: expected %%f, got %%f\", expected_dot, dot);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_vector* dense = sc_sparse_to_dense_vector(s, arena);\n");
+    fprintf(file, "    sc_vector* sum = sc_sparse_vector_add_dense(s, b, arena);\n");
+    fprintf(file, "    sc_vector* product = sc_sparse_to_dense_vector(sc_sparse_vector_mul_dense(s, b, arena), arena);\n");
+    fprintf(file, "    if (!dense || !sum || !product) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run the sparse vector operations\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < 53; i++) {\n");
+    fprintf(file, "        double x = sc_value_to_f64(sc_get_vector_element(a, i));\n");
+    fprintf(file, "        double y = sc_value_to_f64(sc_get_vector_element(b, i));\n");
+    fprintf(file, "        if (sc_value_to_f64(sc_get_vector_element(dense, i)) != x\n");
+    fprintf(file, "            || fabs(sc_value_to_f64(sc_get_vector_element(sum, i)) - (x + y)) > tol\n");
+    fprintf(file, "            || fabs(sc_value_to_f64(sc_get_vector_element(product, i)) - x * y) > tol) {\n");
+    fprintf(file, "            CCB_WARNING(\"Sparse vector operation mismatch at %%u\", i);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_spmv(FILE* file, test_data test) {
+    fprintf(file, "int test_spmv_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    double tol = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    // row 3 is empty and row 10 is dense, so the nonzero split is not the row split\n");
+    fprintf(file, "    sc_tensor* a = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){37, 45}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector av = {a->data, a->size, a->type};\n");
+    fprintf(file, "    sc_vector* x = sc_create_vector(45, %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (uint64_t r = 0; r < 37; r++) {\n");
+    fprintf(file, "        for (uint64_t c = 0; c < 45; c++) {\n");
+    fprintf(file, "            int nonzero = (r == 10) || (r != 3 && (r * 7 + c * 3) %% 5 == 0);\n");
+    fprintf(file, "            sc_set_vector_element(&av, r*45 + c, to_sc_value(nonzero ? (double)((r + c) %% 9) * 0.125 - 0.5 : 0.0, %s));\n", test.sc_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t c = 0; c < 45; c++) {\n");
+    fprintf(file, "        sc_set_vector_element(x, c, to_sc_value((double)(c %% 13) * 0.125 - 0.75, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t f = 0; f < 2; f++) {\n");
+    fprintf(file, "        sc_sparse_matrix* s = sc_dense_to_sparse_matrix(a, f == 0 ? sc_sparse_csr : sc_sparse_csc, arena);\n");
+    fprintf(file, "        sc_vector* y = s ? sc_spmv(s, x, arena) : NULL;\n");
+    fprintf(file, "        sc_tensor* back = s ? sc_sparse_to_dense_matrix(s, arena) : NULL;\n");
+    fprintf(file, "        if (!y || !back || y->size != 37) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to run the SpMV (format %%u)\", f);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        if (memcmp(back->data, a->data, a->size * ((a->type == sc_float64) ? 8 : (a->type == sc_float32) ? 4 : 2)) != 0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Sparse round trip mismatch (format %%u)\", f);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "\n");
+    fprintf(file, "        for (uint64_t r = 0; r < 37; r++) {\n");
+    fprintf(file, "            double expected = 0.0;\n");
+    fprintf(file, "            for (uint64_t c = 0; c < 45; c++) {\n");
+    fprintf(file, "                expected += sc_value_to_f64(sc_get_vector_element(&av, r*45 + c)) * sc_value_to_f64(sc_get_vector_element(x, c));\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(y, r));\n");
+    fprintf(file, "            if (fabs(got - expected) > tol * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                CCB_WARNING(\"SpMV mismatch (format %%u) at %%u: expected %%f, got %%f\", f, r, expected, got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_spmm(FILE* file, test_data test) {
+    fprintf(file, "int test_spmm_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    double tol = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    // coordinates in any order with duplicates: entry e goes to (e * 7 %% 19, e * 5 %% 23)\n");
+    fprintf(file, "    uint64_t count = 150;\n");
+    fprintf(file, "    uint32_t rows[150], cols[150];\n");
+    fprintf(file, "    sc_vector* values = sc_create_vector(count, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* dense = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){19, 23}), sc_float64, arena);\n");
+    fprintf(file, "    double* d = (double*)dense->data;\n");
+    fprintf(file, "    memset(d, 0, 19 * 23 * sizeof(double));\n");
+    fprintf(file, "    for (uint64_t e = 0; e < count; e++) {\n");
+    fprintf(file, "        rows[e] = (uint32_t)(e * 7 %% 19);\n");
+    fprintf(file, "        cols[e] = (uint32_t)(e * 5 %% 23);\n");
+    fprintf(file, "        sc_set_vector_element(values, e, to_sc_value((double)(e %% 7) * 0.125 - 0.25, %s));\n", test.sc_type);
+    fprintf(file, "        d[rows[e] * 23 + cols[e]] += sc_value_to_f64(sc_get_vector_element(values, e));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_tensor* b = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){23, 13}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector bv = {b->data, b->size, b->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < b->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&bv, i, to_sc_value((double)(i %% 10) * 0.125 - 0.5, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_tensor* c = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){19, 23}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector cv = {c->data, c->size, c->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < c->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&cv, i, to_sc_value((double)(i %% 6) * 0.25, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t f = 0; f < 2; f++) {\n");
+    fprintf(file, "        sc_sparse_matrix* s = sc_sparse_matrix_from_coo(19, 23, rows, cols, values, f == 0 ? sc_sparse_csr : sc_sparse_csc, arena);\n");
+    fprintf(file, "        sc_tensor* y = s ? sc_spmm(s, b, arena) : NULL;\n");
+    fprintf(file, "        sc_tensor* sum = s ? sc_sparse_matrix_add_dense(s, c, arena) : NULL;\n");
+    fprintf(file, "        sc_sparse_matrix* product = s ? sc_sparse_matrix_mul_dense(s, c, arena) : NULL;\n");
+    fprintf(file, "        sc_tensor* product_dense = product ? sc_sparse_to_dense_matrix(product, arena) : NULL;\n");
+    fprintf(file, "        if (!y || !sum || !product_dense || y->dims->dims[0] != 19 || y->dims->dims[1] != 13) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to run the SpMM (format %%u)\", f);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_vector yv = {y->data, y->size, y->type};\n");
+    fprintf(file, "        sc_vector sv = {sum->data, sum->size, sum->type};\n");
+    fprintf(file, "        sc_vector pv = {product_dense->data, product_dense->size, product_dense->type};\n");
+    fprintf(file, "\n");
+    fprintf(file, "        for (uint64_t i = 0; i < 19; i++) {\n");
+    fprintf(file, "            for (uint64_t j = 0; j < 13; j++) {\n");
+    fprintf(file, "                double expected = 0.0;\n");
+    fprintf(file, "                for (uint64_t k = 0; k < 23; k++) {\n");
+    fprintf(file, "                    expected += d[i * 23 + k] * sc_value_to_f64(sc_get_vector_element(&bv, k*13 + j));\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "                double got = sc_value_to_f64(sc_get_vector_element(&yv, i*13 + j));\n");
+    fprintf(file, "                if (fabs(got - expected) > tol * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                    CCB_WARNING(\"SpMM mismatch (format %%u) at [%%u, %%u]: expected %%f, got %%f\", f, i, j, expected, got);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            for (uint64_t j = 0; j < 23; j++) {\n");
+    fprintf(file, "                double cij = sc_value_to_f64(sc_get_vector_element(&cv, i*23 + j));\n");
+    fprintf(file, "                if (fabs(sc_value_to_f64(sc_get_vector_element(&sv, i*23 + j)) - (d[i*23 + j] + cij)) > tol\n");
+    fprintf(file, "                    || fabs(sc_value_to_f64(sc_get_vector_element(&pv, i*23 + j)) - d[i*23 + j] * cij) > tol) {\n");
+    fprintf(file, "                    CCB_WARNING(\"Sparse / dense element wise mismatch (format %%u) at [%%u, %%u]\", f, i, j);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_quantize(FILE* file, test_data test) {
+    fprintf(file, "int test_quantize_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){6, 45}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector xv = {x->data, x->size, x->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < x->size; i++) {\n");
+    fprintf(file, "        // each row has its own range so that the per channel scales differ\n");
+    fprintf(file, "        sc_set_vector_element(&xv, i, to_sc_value(((double)((i * 7) %% 23) * 0.125 - 1.0) * (double)(i / 45 + 1), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t c = 0; c < 6; c++) {\n");
+    fprintf(file, "        sc_qtype type = (c %% 2 == 0) ? sc_qint8 : sc_quint8;\n");
+    fprintf(file, "        int symmetric = (c / 2) %% 2;\n");
+    fprintf(file, "        int64_t axis = (c < 4) ? -1 : 0;\n");
+    fprintf(file, "\n");
+    fprintf(file, "        sc_qtensor* q = sc_quantize(x, type, symmetric, axis, arena);\n");
+    fprintf(file, "        sc_tensor* y = q ? sc_dequantize(q, %s, arena) : NULL;\n", test.sc_type);
+    fprintf(file, "        if (!y || q->channels != ((axis < 0) ? 1 : 6)) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to quantise the tensor (case %%u)\", c);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_vector yv = {y->data, y->size, y->type};\n");
+    fprintf(file, "\n");
+    fprintf(file, "        for (uint64_t i = 0; i < x->size; i++) {\n");
+    fprintf(file, "            uint64_t channel = (axis < 0) ? 0 : i / 45;\n");
+    fprintf(file, "            double expected = sc_value_to_f64(sc_get_vector_element(&xv, i));\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(&yv, i));\n");
+    fprintf(file, "            // half a step of rounding, plus the bfloat16 rounding of the output\n");
+    fprintf(file, "            if (fabs(got - expected) > q->scales[channel] * 0.5001 + 1e-2 * fabs(expected) * (%s == sc_float16)) {\n", test.sc_type);
+    fprintf(file, "                CCB_WARNING(\"Quantisation error too large (case %%u) at %%u: expected %%f, got %%f\", c, i, expected, got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_qgemm(FILE* file, test_data test) {
+    fprintf(file, "int test_qgemm_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // k = 70 covers the 32 bytes SIMD steps and the scalar tail, m = 5 and n = 11 the edge blocks\n");
+    fprintf(file, "    sc_tensor* a = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){5, 70}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* w = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){11, 70}), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* bias = sc_create_vector(11, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector av = {a->data, a->size, a->type};\n");
+    fprintf(file, "    sc_vector wv = {w->data, w->size, w->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < a->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&av, i, to_sc_value((double)((i * 5) %% 17) * 0.25 - 0.5, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < w->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&wv, i, to_sc_value(((double)((i * 3) %% 13) - 6.0) * 0.0625 * (double)(i / 70 %% 3 + 1), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t j = 0; j < 11; j++) {\n");
+    fprintf(file, "        sc_set_vector_element(bias, j, to_sc_value((double)j * 0.25 - 1.0, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_qtensor* qw = sc_quantize(w, sc_qint8, 1, 0, arena);\n");
+    fprintf(file, "    sc_tensor* dw = qw ? sc_dequantize(qw, sc_float64, arena) : NULL;\n");
+    fprintf(file, "    for (uint64_t t = 0; t < 2; t++) {\n");
+    fprintf(file, "        sc_qtensor* qa = sc_quantize(a, t == 0 ? sc_quint8 : sc_qint8, 0, -1, arena);\n");
+    fprintf(file, "        sc_tensor* da = qa ? sc_dequantize(qa, sc_float64, arena) : NULL;\n");
+    fprintf(file, "        sc_tensor* c = (da && dw) ? sc_qgemm(qa, qw, bias, sc_float64, arena) : NULL;\n");
+    fprintf(file, "        sc_qtensor* cq = c ? sc_qgemm_requantize(qa, qw, bias, sc_quint8, 0.125f, 40, arena) : NULL;\n");
+    fprintf(file, "        if (!cq || c->dims->dims[0] != 5 || c->dims->dims[1] != 11) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to run the quantised GEMM (case %%u)\", t);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "\n");
+    fprintf(file, "        double* a_data = (double*)da->data;\n");
+    fprintf(file, "        double* w_data = (double*)dw->data;\n");
+    fprintf(file, "        for (uint64_t i = 0; i < 5; i++) {\n");
+    fprintf(file, "            for (uint64_t j = 0; j < 11; j++) {\n");
+    fprintf(file, "                double expected = sc_value_to_f64(sc_get_vector_element(bias, j));\n");
+    fprintf(file, "                for (uint64_t k = 0; k < 70; k++) {\n");
+    fprintf(file, "                    expected += a_data[i*70 + k] * w_data[j*70 + k];\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "                double got = ((double*)c->data)[i*11 + j];\n");
+    fprintf(file, "                if (fabs(got - expected) > 1e-4 * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                    CCB_WARNING(\"Quantised GEMM mismatch (case %%u) at [%%u, %%u]: expected %%f, got %%f\", t, i, j, expected, got);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "\n");
+    fprintf(file, "                double level = round(expected / 0.125) + 40;\n");
+    fprintf(file, "                level = (level < 0) ? 0 : (level > 255) ? 255 : level;\n");
+    fprintf(file, "                if (fabs((double)((uint8_t*)cq->data)[i*11 + j] - level) > 1.0) {\n");
+    fprintf(file, "                    CCB_WARNING(\"Requantisation mismatch (case %%u) at [%%u, %%u]: expected %%f, got %%u\", t, i, j, level, ((uint8_t*)cq->data)[i*11 + j]);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_half_convert(FILE* file, test_data test) {
+    fprintf(file, "int test_half_convert_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // exact values, round to nearest even, overflow to infinity and subnormals\n");
+    fprintf(file, "    double values[] = {1.0, -2.5, 65504.0, 1e5, 5.9604644775390625e-08, 1.0 + 1.0 / 2048.0, 1.0 + 3.0 / 2048.0, 0.1};\n");
+    fprintf(file, "    uint16_t bits[] = {0x3c00, 0xc100, 0x7bff, 0x7c00, 0x0001, 0x3c00, 0x3c02, 0x2e66};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < 8; i++) {\n");
+    fprintf(file, "        sc_value_t value = to_sc_value(values[i], sc_half);\n");
+    fprintf(file, "        if (value.type != sc_half || value.value.half != bits[i]) {\n");
+    fprintf(file, "            CCB_WARNING(\"Wrong half precision bits for %%f: expected %%x, got %%x\", values[i], bits[i], value.value.half);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // bulk conversions (vector body and scalar tail) against the element access\n");
+    fprintf(file, "    uint64_t n = 1003;\n");
+    fprintf(file, "    sc_vector* x = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* h = sc_create_vector(n, sc_half, arena);\n");
+    fprintf(file, "    float* wide = (float*)ccb_arena_malloc(arena, n * sizeof(float));\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(x, i, to_sc_value(((double)((i * 37) %% 101) - 50.0) * 0.37, %s));\n", test.sc_type);
+    fprintf(file, "        wide[i] = sc_value_to_f32(sc_get_vector_element(x, i));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_convert_f32_to_half(wide, (uint16_t*)h->data, n);\n");
+    fprintf(file, "    sc_convert_half_to_f32((uint16_t*)h->data, wide, n);\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        sc_value_t expected = sc_value_as(sc_get_vector_element(x, i), sc_half);\n");
+    fprintf(file, "        sc_value_t got = sc_get_vector_element(h, i);\n");
+    fprintf(file, "        if (got.value.half != expected.value.half || wide[i] != sc_value_to_f32(got)) {\n");
+    fprintf(file, "            CCB_WARNING(\"Half precision conversion mismatch at %%u: expected %%x, got %%x\", i, expected.value.half, got.value.half);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_half_ops(FILE* file, test_data test) {
+    fprintf(file, "int test_half_ops_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // the engine runs sc_half through the float32 kernels, the results must match the reference type\n");
+    fprintf(file, "    uint64_t n = 2051;\n");
+    fprintf(file, "    sc_vector* a = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* b = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* ha = sc_create_vector(n, sc_half, arena);\n");
+    fprintf(file, "    sc_vector* hb = sc_create_vector(n, sc_half, arena);\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        double av = (double)((i * 13) %% 64) * 0.125 - 4.0;\n");
+    fprintf(file, "        double bv = (double)(i %% 9) * 0.5 + 1.0;\n");
+    fprintf(file, "        sc_set_vector_element(a, i, to_sc_value(av, %s));\n", test.sc_type);
+    fprintf(file, "        sc_set_vector_element(b, i, to_sc_value(bv, %s));\n", test.sc_type);
+    fprintf(file, "        sc_set_vector_element(ha, i, to_sc_value(av, sc_half));\n");
+    fprintf(file, "        sc_set_vector_element(hb, i, to_sc_value(bv, sc_half));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_vector* expected[4];\n");
+    fprintf(file, "    sc_vector* got[4];\n");
+    fprintf(file, "    expected[0] = sc_vector_add(a, b, arena);\n");
+    fprintf(file, "    got[0] = sc_vector_add(ha, hb, arena);\n");
+    fprintf(file, "    expected[1] = sc_vector_div_ellement_wise(a, b, arena);\n");
+    fprintf(file, "    got[1] = sc_vector_div_ellement_wise(ha, hb, arena);\n");
+    fprintf(file, "    expected[2] = sc_vector_mul_scalar(a, to_sc_value(1.5, %s), arena);\n", test.sc_type);
+    fprintf(file, "    got[2] = sc_vector_mul_scalar(ha, to_sc_value(1.5, sc_half), arena);\n");
+    fprintf(file, "    expected[3] = sc_vector_map(a, sc_scalar_abs, arena);\n");
+    fprintf(file, "    got[3] = sc_vector_map(ha, sc_scalar_abs, arena);\n");
+    fprintf(file, "\n");
+    fprintf(file, "    double tol = (%s == sc_float16) ? 1e-2 : 1e-3;\n", test.sc_type);
+    fprintf(file, "    for (uint64_t k = 0; k < 4; k++) {\n");
+    fprintf(file, "        if (!got[k] || got[k]->type != sc_half) {\n");
+    fprintf(file, "            CCB_WARNING(\"Half precision operation %%u failed\", k);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            double e = sc_value_to_f64(sc_get_vector_element(expected[k], i));\n");
+    fprintf(file, "            double g = sc_value_to_f64(sc_get_vector_element(got[k], i));\n");
+    fprintf(file, "            if (fabs(e - g) > tol * (fabs(e) + 1.0)) {\n");
+    fprintf(file, "                CCB_WARNING(\"Half precision operation %%u mismatch at %%u: expected %%f, got %%f\", k, i, e, g);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // the reduction accumulates in float32, a half accumulator would stop at 2048\n");
+    fprintf(file, "    sc_value_t sum = sc_vector_reduce(hb, sc_scalar_add, to_sc_value(0.0, sc_half));\n");
+    fprintf(file, "    double expected_sum = 0.0;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        expected_sum += (double)(i %% 9) * 0.5 + 1.0;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sum.type != sc_half || fabs(sc_value_to_f64(sum) - expected_sum) > 1e-3 * expected_sum) {\n");
+    fprintf(file, "        CCB_WARNING(\"Half precision sum mismatch: expected %%f, got %%f\", expected_sum, sc_value_to_f64(sum));\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_int_ops(FILE* file, test_data test) {
+    fprintf(file, "int test_int_ops_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // 1003 elements cover the 32 bytes SIMD blocks and the scalar tails of the three integer types\n");
+    fprintf(file, "    uint64_t n = 1003;\n");
+    fprintf(file, "    sc_TYPES types[] = {sc_int32, sc_int64, sc_uint8};\n");
+    fprintf(file, "    for (uint64_t t = 0; t < 3; t++) {\n");
+    fprintf(file, "        sc_TYPES type = types[t];\n");
+    fprintf(file, "        int64_t offset = (type == sc_uint8) ? 0 : 100;\n");
+    fprintf(file, "        sc_vector* a = sc_create_vector(n, type, arena);\n");
+    fprintf(file, "        sc_vector* b = sc_create_vector(n, type, arena);\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            sc_set_vector_element(a, i, to_sc_value((double)((int64_t)((i * 37) %% 251) - offset), type));\n");
+    fprintf(file, "            sc_set_vector_element(b, i, to_sc_value((double)((int64_t)((i * 11) %% 97) - offset / 2), type));\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "\n");
+    fprintf(file, "        sc_vector* results[7];\n");
+    fprintf(file, "        results[0] = sc_vector_add(a, b, arena);\n");
+    fprintf(file, "        results[1] = sc_vector_sub(a, b, arena);\n");
+    fprintf(file, "        results[2] = sc_vector_mul_ellement_wise(a, b, arena);\n");
+    fprintf(file, "        results[3] = sc_vector_div_ellement_wise(a, b, arena);\n");
+    fprintf(file, "        results[4] = sc_vector_and(a, b, arena);\n");
+    fprintf(file, "        results[5] = sc_vector_xor(a, b, arena);\n");
+    fprintf(file, "        results[6] = sc_vector_not(a, arena);\n");
+    fprintf(file, "\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            int64_t x = sc_value_to_i64(sc_get_vector_element(a, i));\n");
+    fprintf(file, "            int64_t y = sc_value_to_i64(sc_get_vector_element(b, i));\n");
+    fprintf(file, "            int64_t expected[7] = {x + y, x - y, x * y, (y != 0) ? x / y : 0, x & y, x ^ y, ~x};\n");
+    fprintf(file, "            if (type == sc_uint8) {\n");
+    fprintf(file, "                // uint8 arithmetic saturates\n");
+    fprintf(file, "                for (uint64_t k = 0; k < 4; k++) {\n");
+    fprintf(file, "                    expected[k] = (expected[k] < 0) ? 0 : ((expected[k] > 255) ? 255 : expected[k]);\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "                expected[6] &= 255;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            for (uint64_t k = 0; k < 7; k++) {\n");
+    fprintf(file, "                sc_value_t got = sc_get_vector_element(results[k], i);\n");
+    fprintf(file, "                if (got.type != type || sc_value_to_i64(got) != expected[k]) {\n");
+    fprintf(file, "                    CCB_WARNING(\"Integer operation %%u on type %%u mismatch at %%u: expected %%lld, got %%lld\", k, type, i, (long long)expected[k], (long long)sc_value_to_i64(got));\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "\n");
+    fprintf(file, "        int64_t expected_sum = 0;\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            expected_sum += sc_value_to_i64(sc_get_vector_element(a, i));\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        if (type == sc_uint8) {\n");
+    fprintf(file, "            expected_sum = (expected_sum > 255) ? 255 : expected_sum;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_value_t sum = sc_vector_reduce(a, sc_scalar_add, to_sc_value(0.0, type));\n");
+    fprintf(file, "        if (sc_value_to_i64(sum) != expected_sum) {\n");
+    fprintf(file, "            CCB_WARNING(\"Integer sum on type %%u mismatch: expected %%lld, got %%lld\", type, (long long)expected_sum, (long long)sc_value_to_i64(sum));\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_int_cast(FILE* file, test_data test) {
+    fprintf(file, "int test_int_cast_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // halves round to even, out of range values saturate\n");
+    fprintf(file, "    uint64_t n = 517;\n");
+    fprintf(file, "    sc_vector* x = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        double value = (double)(i %% 64) * 0.5 - 10.0;\n");
+    fprintf(file, "        if (i %% 50 == 7) value = 300.0;\n");
+    fprintf(file, "        if (i %% 50 == 8) value = -1e10;\n");
+    fprintf(file, "        sc_set_vector_element(x, i, to_sc_value(value, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_TYPES types[] = {sc_int32, sc_int64, sc_uint8};\n");
+    fprintf(file, "    double lo[] = {-2147483648.0, -9223372036854775808.0, 0.0};\n");
+    fprintf(file, "    double hi[] = {2147483647.0, 9223372036854775807.0, 255.0};\n");
+    fprintf(file, "    for (uint64_t t = 0; t < 3; t++) {\n");
+    fprintf(file, "        sc_vector* y = sc_vector_cast(x, types[t], arena);\n");
+    fprintf(file, "        sc_vector* back = y ? sc_vector_cast(y, %s, arena) : NULL;\n", test.sc_type);
+    fprintf(file, "        if (!back || y->type != types[t] || back->type != %s) {\n", test.sc_type);
+    fprintf(file, "            CCB_WARNING(\"Failed to cast to type %%u\", types[t]);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            double value = sc_value_to_f64(sc_get_vector_element(x, i));\n");
+    fprintf(file, "            double expected = nearbyint(value);\n");
+    fprintf(file, "            expected = (expected < lo[t]) ? lo[t] : ((expected > hi[t]) ? hi[t] : expected);\n");
+    fprintf(file, "            double got = (double)sc_value_to_i64(sc_get_vector_element(y, i));\n");
+    fprintf(file, "            double got_back = sc_value_to_f64(sc_get_vector_element(back, i));\n");
+    fprintf(file, "            if (got != expected || (fabs(expected) < 1e6 && got_back != expected)) {\n");
+    fprintf(file, "                CCB_WARNING(\"Cast to type %%u mismatch at %%u (%%f): expected %%f, got %%f and %%f back\", types[t], i, value, expected, got, got_back);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_cast_rounding(FILE* file, test_data test) {
+    fprintf(file, "int test_cast_rounding_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // every mode must round in its direction, and the SIMD body must match the scalar tail bit for bit\n");
+    fprintf(file, "    uint64_t n = 517;\n");
+    fprintf(file, "    sc_vector* x = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        double value = ((double)i * 0.37 - 95.3) * ((i %% 3 == 0) ? 1e-3 : 1.0);\n");
+    fprintf(file, "        if (i %% 97 == 5) value = 1e5;\n");
+    fprintf(file, "        if (i %% 97 == 6) value = -7e4;\n");
+    fprintf(file, "        sc_set_vector_element(x, i, to_sc_value(value, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_TYPES types[] = {sc_float16, sc_half, sc_float32, sc_float64, sc_int32};\n");
+    fprintf(file, "    sc_rounding_mode modes[] = {sc_round_nearest_even, sc_round_toward_zero, sc_round_down, sc_round_up};\n");
+    fprintf(file, "    for (uint64_t t = 0; t < 5; t++) {\n");
+    fprintf(file, "        for (uint64_t m = 0; m < 4; m++) {\n");
+    fprintf(file, "            sc_vector* y = sc_vector_cast_rounding(x, types[t], modes[m], arena);\n");
+    fprintf(file, "            if (!y || y->type != types[t]) {\n");
+    fprintf(file, "                CCB_WARNING(\"Failed to cast to type %%u with mode %%u\", types[t], modes[m]);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            double* widened = (double*)sc_vector_cast(y, sc_float64, arena)->data;\n");
+    fprintf(file, "            for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "                double value = sc_value_to_f64(sc_get_vector_element(x, i));\n");
+    fprintf(file, "                double got = widened[i];\n");
+    fprintf(file, "                int ok = (modes[m] == sc_round_nearest_even) ||\n");
+    fprintf(file, "                         (modes[m] == sc_round_toward_zero && fabs(got) <= fabs(value)) ||\n");
+    fprintf(file, "                         (modes[m] == sc_round_down && got <= value) ||\n");
+    fprintf(file, "                         (modes[m] == sc_round_up && got >= value);\n");
+    fprintf(file, "                if (fabs(value) < 1e3 && fabs(got - value) > fabs(value) * 1e-2 + 1.0) {\n");
+    fprintf(file, "                    ok = 0;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "\n");
+    fprintf(file, "                uint64_t single = 0;\n");
+    fprintf(file, "                uint64_t bulk = 0;\n");
+    fprintf(file, "                sc_convert_buffer_rounding((uint8_t*)x->data + i * sc_type_size(%s), %s, &single, types[t], 1, modes[m]);\n", test.sc_type, test.sc_type);
+    fprintf(file, "                memcpy(&bulk, (uint8_t*)y->data + i * sc_type_size(types[t]), sc_type_size(types[t]));\n");
+    fprintf(file, "                if (!ok || single != bulk) {\n");
+    fprintf(file, "                    CCB_WARNING(\"Cast to type %%u with mode %%u mismatch at %%u: %%f gave %%f (%%\" PRIx64 \" vs %%\" PRIx64 \" alone)\", types[t], modes[m], i, value, got, bulk, single);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // float64 values just above a tie of bfloat16 / half: through float32 they would become an exact tie and round\n");
+    fprintf(file, "    // to even, rounded directly they go up (300 values cover the chunked body and the tail)\n");
+    fprintf(file, "    sc_vector* near_ties = sc_create_vector(300, sc_float64, arena);\n");
+    fprintf(file, "    for (uint64_t t = 0; t < 2; t++) {\n");
+    fprintf(file, "        double above = 1.0 + ldexp(1.0, (t == 0) ? -8 : -11) + ldexp(1.0, -30);\n");
+    fprintf(file, "        uint16_t expected = (t == 0) ? 0x3f81 : 0x3c01;\n");
+    fprintf(file, "        for (uint64_t i = 0; i < near_ties->size; i++) {\n");
+    fprintf(file, "            ((double*)near_ties->data)[i] = (i %% 2) ? -above : above;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_vector* y = sc_vector_cast(near_ties, (t == 0) ? sc_float16 : sc_half, arena);\n");
+    fprintf(file, "        if (!y) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to cast the near ties\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t i = 0; i < y->size; i++) {\n");
+    fprintf(file, "            if (((uint16_t*)y->data)[i] != (uint16_t)(expected | ((i %% 2) ? 0x8000 : 0))) {\n");
+    fprintf(file, "                CCB_WARNING(\"float64 cast to type %%u rounded twice at %%u: %%x\", y->type, i, ((uint16_t*)y->data)[i]);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_mixed_ops(FILE* file, test_data test) {
+    fprintf(file, "int test_mixed_ops_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // mixed operands are promoted, the result matches the computation on the promoted values\n");
+    fprintf(file, "    uint64_t n = 1500;\n");
+    fprintf(file, "    double tolerance = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    sc_vector* a = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* b = sc_create_vector(n, sc_int32, arena);\n");
+    fprintf(file, "    sc_vector* c = sc_create_vector(n, sc_float64, arena);\n");
+    fprintf(file, "    sc_vector* h = sc_create_vector(n, sc_half, arena);\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(a, i, to_sc_value((double)(i %% 41) * 0.25 - 3.0, %s));\n", test.sc_type);
+    fprintf(file, "        sc_set_vector_element(b, i, to_sc_value((double)(i %% 13) - 6.0, sc_int32));\n");
+    fprintf(file, "        sc_set_vector_element(c, i, to_sc_value((double)(i %% 7) * 0.125 + 0.5, sc_float64));\n");
+    fprintf(file, "        sc_set_vector_element(h, i, to_sc_value((double)(i %% 5) * 0.5, sc_half));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_vector* sum = sc_vector_add(a, b, arena);\n");
+    fprintf(file, "    sc_vector* product = sc_vector_mul_ellement_wise(a, c, arena);\n");
+    fprintf(file, "    sc_vector* with_half = sc_vector_add(h, a, arena);\n");
+    fprintf(file, "    sc_vector* shifted = sc_vector_add_scalar(b, to_sc_value(0.5, %s), arena);\n", test.sc_type);
+    fprintf(file, "    if (!sum || !product || !with_half || !shifted) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run the mixed operations\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_TYPES half_type = (%s == sc_float16) ? sc_float32 : %s;\n", test.sc_type, test.sc_type);
+    fprintf(file, "    if (sum->type != %s || product->type != sc_float64 || with_half->type != half_type || shifted->type != %s) {\n", test.sc_type, test.sc_type);
+    fprintf(file, "        CCB_WARNING(\"Wrong promoted types: %%u %%u %%u %%u\", sum->type, product->type, with_half->type, shifted->type);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        double x = sc_value_to_f64(sc_get_vector_element(a, i));\n");
+    fprintf(file, "        double y = sc_value_to_f64(sc_get_vector_element(b, i));\n");
+    fprintf(file, "        double z = sc_value_to_f64(sc_get_vector_element(c, i));\n");
+    fprintf(file, "        double w = sc_value_to_f64(sc_get_vector_element(h, i));\n");
+    fprintf(file, "        double expected[] = {x + y, x * z, w + x, y + 0.5};\n");
+    fprintf(file, "        double got[] = {sc_value_to_f64(sc_get_vector_element(sum, i)), sc_value_to_f64(sc_get_vector_element(product, i)),\n");
+    fprintf(file, "                        sc_value_to_f64(sc_get_vector_element(with_half, i)), sc_value_to_f64(sc_get_vector_element(shifted, i))};\n");
+    fprintf(file, "        for (uint64_t k = 0; k < 4; k++) {\n");
+    fprintf(file, "            if (fabs(got[k] - expected[k]) > tolerance * (1.0 + fabs(expected[k]))) {\n");
+    fprintf(file, "                CCB_WARNING(\"Mixed operation %%u mismatch at %%u: expected %%f, got %%f\", k, i, expected[k], got[k]);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // in place works when the first vector holds the promoted type\n");
+    fprintf(file, "    if (sc_vector_add_inplace(a, b) != a) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to add in place\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        double expected = sc_value_to_f64(sc_get_vector_element(sum, i));\n");
+    fprintf(file, "        double got = sc_value_to_f64(sc_get_vector_element(a, i));\n");
+    fprintf(file, "        if (got != expected) {\n");
+    fprintf(file, "            CCB_WARNING(\"In place mixed add mismatch at %%u: expected %%f, got %%f\", i, expected, got);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_fused_ops(FILE* file, test_data test) {
+    fprintf(file, "int test_fused_ops_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // the fused ops against the same computation in double, the size covers the SIMD tail and the threads\n");
+    fprintf(file, "    uint64_t n = 2053;\n");
+    fprintf(file, "    double tolerance = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-4 : 1e-9);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    sc_vector* a = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* b = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* c = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(a, i, to_sc_value((double)(i %% 37) * 0.25 - 4.0, %s));\n", test.sc_type);
+    fprintf(file, "        sc_set_vector_element(b, i, to_sc_value((double)(i %% 11) * 0.5 - 2.0, %s));\n", test.sc_type);
+    fprintf(file, "        sc_set_vector_element(c, i, to_sc_value((double)(i %% 7) - 3.0, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_vector* results[6];\n");
+    fprintf(file, "    results[0] = sc_vector_fma(a, b, c, arena);\n");
+    fprintf(file, "    results[1] = sc_vector_axpy(to_sc_value(1.5, %s), a, b, arena);\n", test.sc_type);
+    fprintf(file, "    results[2] = sc_vector_axpby(to_sc_value(-0.5, %s), a, to_sc_value(2.0, %s), b, arena);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    results[3] = sc_vector_axpby(to_sc_value(2.0, %s), a, to_sc_value(0.0, %s), b, arena);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    results[4] = sc_vector_lerp(a, b, to_sc_value(0.25, %s), arena);\n", test.sc_type);
+    fprintf(file, "    results[5] = sc_vector_clamp(a, to_sc_value(-1.0, %s), to_sc_value(2.5, %s), arena);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    for (uint64_t k = 0; k < 6; k++) {\n");
+    fprintf(file, "        if (!results[k] || results[k]->type != %s || results[k]->size != n) {\n", test.sc_type);
+    fprintf(file, "            CCB_WARNING(\"Failed to run fused operation %%u\", k);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        double x = sc_value_to_f64(sc_get_vector_element(a, i));\n");
+    fprintf(file, "        double y = sc_value_to_f64(sc_get_vector_element(b, i));\n");
+    fprintf(file, "        double z = sc_value_to_f64(sc_get_vector_element(c, i));\n");
+    fprintf(file, "        double expected[] = {x * y + z, 1.5 * x + y, -0.5 * x + 2.0 * y, 2.0 * x, x + 0.25 * (y - x), (x < -1.0) ? -1.0 : ((x > 2.5) ? 2.5 : x)};\n");
+    fprintf(file, "        for (uint64_t k = 0; k < 6; k++) {\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(results[k], i));\n");
+    fprintf(file, "            if (fabs(got - expected[k]) > tolerance * (1.0 + fabs(expected[k]))) {\n");
+    fprintf(file, "                CCB_WARNING(\"Fused operation %%u mismatch at %%u: expected %%f, got %%f\", k, i, expected[k], got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // in place versions write into y / x\n");
+    fprintf(file, "    if (sc_vector_axpby_inplace(to_sc_value(-0.5, %s), a, to_sc_value(2.0, %s), b) != b || sc_vector_clamp_inplace(a, to_sc_value(-1.0, %s), to_sc_value(2.5, %s)) != a) {\n", test.sc_type, test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "        CCB_WARNING(\"Failed to run the in place fused operations\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        if (sc_value_to_f64(sc_get_vector_element(b, i)) != sc_value_to_f64(sc_get_vector_element(results[2], i)) ||\n");
+    fprintf(file, "            sc_value_to_f64(sc_get_vector_element(a, i)) != sc_value_to_f64(sc_get_vector_element(results[5], i))) {\n");
+    fprintf(file, "            CCB_WARNING(\"In place fused operation mismatch at %%u\", i);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_linreg(FILE* file, test_data test) {
+    fprintf(file, "int test_linreg_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // recovery of known weights, streaming in chunks, ridge shrinkage and the QR fallback on collinear features\n");
+    fprintf(file, "    uint64_t rows = 1000;\n");
+    fprintf(file, "    uint64_t features = 6;\n");
+    fprintf(file, "    double weights[] = {1.5, -2.0, 0.5, 3.0, 0.0, -1.0};\n");
+    fprintf(file, "    double intercept = 0.75;\n");
+    fprintf(file, "    double tolerance = (%s == sc_float16) ? 5e-2 : ((%s == sc_float32) ? 1e-3 : 1e-8);\n", test.sc_type, test.sc_type);
+    fprintf(file, "    uint64_t dims[] = {rows, features};\n");
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(2, arena, dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* y = sc_create_vector(rows, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector x_view = {x->data, x->size, x->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < rows; i++) {\n");
+    fprintf(file, "        double target = intercept;\n");
+    fprintf(file, "        for (uint64_t j = 0; j < features; j++) {\n");
+    fprintf(file, "            sc_set_vector_element(&x_view, i * features + j, to_sc_value((double)((i * (j + 3) + j * 7) %% 17) * 0.25 - 2.0, %s));\n", test.sc_type);
+    fprintf(file, "            target += weights[j] * sc_value_to_f64(sc_get_vector_element(&x_view, i * features + j));\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_set_vector_element(y, i, to_sc_value(target, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_linreg_model* model = sc_linreg_fit(x, y, 0.0, 1, arena);\n");
+    fprintf(file, "    if (!model || model->solver != sc_linreg_cholesky || model->rank != features + 1) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to fit the linear regression\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t j = 0; j < features; j++) {\n");
+    fprintf(file, "        double got = ((double*)model->weights->data)[j];\n");
+    fprintf(file, "        if (fabs(got - weights[j]) > tolerance * (1.0 + fabs(weights[j]))) {\n");
+    fprintf(file, "            CCB_WARNING(\"Weight %%u mismatch: expected %%f, got %%f\", j, weights[j], got);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (fabs(model->intercept - intercept) > tolerance * 2.0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Intercept mismatch: expected %%f, got %%f\", intercept, model->intercept);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // the same rows accumulated in two chunks\n");
+    fprintf(file, "    uint64_t half_dims[] = {rows / 2, features};\n");
+    fprintf(file, "    sc_linreg_state* state = sc_linreg_create(features, 1, arena);\n");
+    fprintf(file, "    for (uint64_t c = 0; c < 2; c++) {\n");
+    fprintf(file, "        sc_tensor chunk = {(uint8_t*)x->data + c * (rows / 2) * features * sc_type_size(%s), sc_create_dimensions(2, arena, half_dims), rows / 2 * features, %s};\n", test.sc_type, test.sc_type);
+    fprintf(file, "        sc_vector targets = {(uint8_t*)y->data + c * (rows / 2) * sc_type_size(%s), rows / 2, %s};\n", test.sc_type, test.sc_type);
+    fprintf(file, "        if (sc_linreg_accumulate(state, &chunk, &targets, arena) != 0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to accumulate chunk %%u\", c);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_linreg_model* streamed = sc_linreg_solve(state, 0.0, arena);\n");
+    fprintf(file, "    if (!streamed || streamed->rows != rows) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to solve the streamed linear regression\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t j = 0; j < features; j++) {\n");
+    fprintf(file, "        if (fabs(((double*)streamed->weights->data)[j] - ((double*)model->weights->data)[j]) > 1e-8) {\n");
+    fprintf(file, "            CCB_WARNING(\"Streamed weight %%u differs from the single chunk fit\", j);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // ridge shrinks the weights but not the intercept\n");
+    fprintf(file, "    sc_linreg_model* ridge = sc_linreg_solve(state, 1e4, arena);\n");
+    fprintf(file, "    double norm = 0.0;\n");
+    fprintf(file, "    double ridge_norm = 0.0;\n");
+    fprintf(file, "    for (uint64_t j = 0; j < features; j++) {\n");
+    fprintf(file, "        norm += weights[j] * weights[j];\n");
+    fprintf(file, "        ridge_norm += ((double*)ridge->weights->data)[j] * ((double*)ridge->weights->data)[j];\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (!(ridge_norm < 0.5 * norm) || !(ridge->residual > model->residual)) {\n");
+    fprintf(file, "        CCB_WARNING(\"Ridge did not shrink the weights: %%f against %%f\", ridge_norm, norm);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // a duplicated feature makes X^T.X singular, the QR fallback still fits y\n");
+    fprintf(file, "    for (uint64_t i = 0; i < rows; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&x_view, i * features + 4, sc_get_vector_element(&x_view, i * features + 1));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_linreg_model* collinear = sc_linreg_fit(x, y, 0.0, 1, arena);\n");
+    fprintf(file, "    if (!collinear || collinear->solver != sc_linreg_qr || collinear->rank != features) {\n");
+    fprintf(file, "        CCB_WARNING(\"Collinear features did not use the QR fallback\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector* predictions = sc_linreg_predict(collinear, x, sc_float64, arena);\n");
+    fprintf(file, "    if (!predictions) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to predict\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < rows; i++) {\n");
+    fprintf(file, "        double expected = sc_value_to_f64(sc_get_vector_element(y, i));\n");
+    fprintf(file, "        double got = ((double*)predictions->data)[i];\n");
+    fprintf(file, "        if (fabs(got - expected) > tolerance * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "            CCB_WARNING(\"Prediction mismatch at %%u: expected %%f, got %%f\", i, expected, got);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_logreg(FILE* file, test_data test) {
+    fprintf(file, "struct logreg_%s_chunks {\n", test.data_type);
+    fprintf(file, "    sc_tensor* x[2];\n");
+    fprintf(file, "    sc_vector* y[2];\n");
+    fprintf(file, "};\n");
+    fprintf(file, "\n");
+    fprintf(file, "static int logreg_%s_chunk(void* context, uint64_t index, sc_tensor** x, sc_vector** y) {\n", test.data_type);
+    fprintf(file, "    struct logreg_%s_chunks* chunks = (struct logreg_%s_chunks*)context;\n", test.data_type, test.data_type);
+    fprintf(file, "    if (index >= 2) {\n");
+    fprintf(file, "        return 0;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    *x = chunks->x[index];\n");
+    fprintf(file, "    *y = chunks->y[index];\n");
+    fprintf(file, "    return 1;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_logreg_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // labels from a known separating plane with 10%% flipped, trained in memory (L-BFGS, SGD) and streamed in two chunks\n");
+    fprintf(file, "    uint64_t rows = 2000;\n");
+    fprintf(file, "    uint64_t features = 4;\n");
+    fprintf(file, "    double weights[] = {2.0, -1.0, 0.5, 0.0};\n");
+    fprintf(file, "    uint64_t dims[] = {rows, features};\n");
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(2, arena, dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* y = sc_create_vector(rows, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector x_view = {x->data, x->size, x->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < rows; i++) {\n");
+    fprintf(file, "        double z = -0.5;\n");
+    fprintf(file, "        for (uint64_t j = 0; j < features; j++) {\n");
+    fprintf(file, "            double value = (double)((i * (2 * j + 3) + j * 5) %% 23) * 0.125 - 1.375;\n");
+    fprintf(file, "            sc_set_vector_element(&x_view, i * features + j, to_sc_value(value, %s));\n", test.sc_type);
+    fprintf(file, "            z += weights[j] * value;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        double label = (z > 0.0) ? 1.0 : 0.0;\n");
+    fprintf(file, "        sc_set_vector_element(y, i, to_sc_value((i %% 10 == 0) ? 1.0 - label : label, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_logreg_options options = sc_logreg_default_options();\n");
+    fprintf(file, "    options.l2 = 1e-3;\n");
+    fprintf(file, "    sc_logreg_model* models[2];\n");
+    fprintf(file, "    models[0] = sc_logreg_fit(x, y, &options, arena);\n");
+    fprintf(file, "    options.optimizer = sc_logreg_sgd;\n");
+    fprintf(file, "    options.iterations = 30;\n");
+    fprintf(file, "    options.batch_size = 64;\n");
+    fprintf(file, "    options.learning_rate = 0.5;\n");
+    fprintf(file, "    models[1] = sc_logreg_fit(x, y, &options, arena);\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t k = 0; k < 2; k++) {\n");
+    fprintf(file, "        if (!models[k] || !(models[k]->loss < 0.6931)) {\n");
+    fprintf(file, "            CCB_WARNING(\"Logistic regression %%u did not train\", k);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_vector* probabilities = sc_logreg_predict(models[k], x, sc_float64, arena);\n");
+    fprintf(file, "        if (!probabilities) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to predict with logistic regression %%u\", k);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        uint64_t correct = 0;\n");
+    fprintf(file, "        for (uint64_t i = 0; i < rows; i++) {\n");
+    fprintf(file, "            double p = ((double*)probabilities->data)[i];\n");
+    fprintf(file, "            if (!(p >= 0.0 && p <= 1.0)) {\n");
+    fprintf(file, "                CCB_WARNING(\"Probability out of range at %%u: %%f\", i, p);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            correct += ((p > 0.5) == (sc_value_to_f64(sc_get_vector_element(y, i)) > 0.5));\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        if (correct < rows * 85 / 100) {\n");
+    fprintf(file, "            CCB_WARNING(\"Logistic regression %%u accuracy too low: %%u / %%u\", k, correct, rows);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // the streamed chunks reach the same optimum as the in memory L-BFGS\n");
+    fprintf(file, "    struct logreg_%s_chunks chunks;\n", test.data_type);
+    fprintf(file, "    uint64_t half_dims[] = {rows / 2, features};\n");
+    fprintf(file, "    for (uint64_t c = 0; c < 2; c++) {\n");
+    fprintf(file, "        chunks.x[c] = sc_create_tensor(sc_create_dimensions(2, arena, half_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "        chunks.y[c] = sc_create_vector(rows / 2, %s, arena);\n", test.sc_type);
+    fprintf(file, "        memcpy(chunks.x[c]->data, (uint8_t*)x->data + c * (rows / 2) * features * sc_type_size(%s), (rows / 2) * features * sc_type_size(%s));\n", test.sc_type, test.sc_type);
+    fprintf(file, "        memcpy(chunks.y[c]->data, (uint8_t*)y->data + c * (rows / 2) * sc_type_size(%s), (rows / 2) * sc_type_size(%s));\n", test.sc_type, test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_logreg_source source = {logreg_%s_chunk, &chunks};\n", test.data_type);
+    fprintf(file, "    options = sc_logreg_default_options();\n");
+    fprintf(file, "    options.l2 = 1e-3;\n");
+    fprintf(file, "    sc_logreg_model* streamed = sc_logreg_fit_source(&source, features, &options, arena);\n");
+    fprintf(file, "    if (!streamed) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to train on the streamed chunks\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t j = 0; j < features; j++) {\n");
+    fprintf(file, "        double expected = ((double*)models[0]->weights->data)[j];\n");
+    fprintf(file, "        double got = ((double*)streamed->weights->data)[j];\n");
+    fprintf(file, "        if (fabs(got - expected) > 1e-3 * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "            CCB_WARNING(\"Streamed weight %%u mismatch: expected %%f, got %%f\", j, expected, got);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_nn(FILE* file, test_data test) {
+    fprintf(file, "static double nn_%s_loss(sc_nn_network* net, sc_tensor* x, sc_tensor* r, ccb_arena* scratch) {\n", test.data_type);
+    fprintf(file, "    ccb_arena_reset(scratch);\n");
+    fprintf(file, "    sc_tensor* y = sc_nn_forward(net, x, 0, scratch);\n");
+    fprintf(file, "    sc_vector y_view = {y->data, y->size, y->type};\n");
+    fprintf(file, "    sc_vector r_view = {r->data, r->size, r->type};\n");
+    fprintf(file, "    double loss = 0.0;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < y->size; i++) {\n");
+    fprintf(file, "        loss += sc_value_to_f64(sc_get_vector_element(&y_view, i)) * sc_value_to_f64(sc_get_vector_element(&r_view, i));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return loss;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "// central difference of the loss against one parameter\n");
+    fprintf(file, "static double nn_%s_numeric(sc_nn_network* net, void* data, uint64_t i, sc_tensor* x, sc_tensor* r, double h, ccb_arena* scratch) {\n", test.data_type);
+    fprintf(file, "    sc_vector view = {data, i + 1, %s};\n", test.sc_type);
+    fprintf(file, "    double value = sc_value_to_f64(sc_get_vector_element(&view, i));\n");
+    fprintf(file, "    sc_set_vector_element(&view, i, to_sc_value(value + h, %s));\n", test.sc_type);
+    fprintf(file, "    double plus = nn_%s_loss(net, x, r, scratch);\n", test.data_type);
+    fprintf(file, "    sc_set_vector_element(&view, i, to_sc_value(value - h, %s));\n", test.sc_type);
+    fprintf(file, "    double minus = nn_%s_loss(net, x, r, scratch);\n", test.data_type);
+    fprintf(file, "    sc_set_vector_element(&view, i, to_sc_value(value, %s));\n", test.sc_type);
+    fprintf(file, "    return (plus - minus) / (2.0 * h);\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_nn_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // backward pass against finite differences of loss = sum(y * r), dropout masks and a workspace that never grows\n");
+    fprintf(file, "    if (%s != sc_float32 && %s != sc_float64) {\n", test.sc_type, test.sc_type);
+    fprintf(file, "        return (sc_nn_create(4, %s, 1, arena) == NULL) ? 0 : -1;\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    double h = (%s == sc_float32) ? 1e-2 : 1e-6;\n", test.sc_type);
+    fprintf(file, "    double tolerance = (%s == sc_float32) ? 2e-2 : 1e-6;\n", test.sc_type);
+    fprintf(file, "    ccb_arena* workspace = ccb_init_arena();\n");
+    fprintf(file, "    ccb_arena* scratch = ccb_init_arena();\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_nn_network* net = sc_nn_create(5, %s, 7, arena);\n", test.sc_type);
+    fprintf(file, "    if (!net || sc_nn_add_dense(net, 8, sc_nn_gelu, arena) != 0 || sc_nn_add_layer_norm(net, 1e-5, arena) != 0 ||\n");
+    fprintf(file, "        sc_nn_add_dense(net, 6, sc_nn_tanh, arena) != 0 || sc_nn_add_activation(net, sc_nn_sigmoid, arena) != 0 ||\n");
+    fprintf(file, "        sc_nn_add_dropout(net, 0.25, arena) != 0 || sc_nn_add_dense(net, 3, sc_nn_relu, arena) != 0 ||\n");
+    fprintf(file, "        sc_nn_add_dense(net, 3, sc_nn_identity, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to build the network\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_nn_bind(net, 16, workspace) != 0 || sc_nn_add_dense(net, 2, sc_nn_identity, arena) == 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to bind the network\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    uint64_t capacity = workspace->capacity;\n");
+    fprintf(file, "\n");
+    fprintf(file, "    uint64_t x_dims[] = {11, 5};\n");
+    fprintf(file, "    uint64_t y_dims[] = {11, 3};\n");
+    fprintf(file, "    sc_tensor* x = sc_create_tensor(sc_create_dimensions(2, arena, x_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* r = sc_create_tensor(sc_create_dimensions(2, arena, y_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector x_view = {x->data, x->size, x->type};\n");
+    fprintf(file, "    sc_vector r_view = {r->data, r->size, r->type};\n");
+    fprintf(file, "    for (uint64_t i = 0; i < x->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&x_view, i, to_sc_value(sin((double)i * 0.7), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < r->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&r_view, i, to_sc_value(cos((double)i * 1.3), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    ccb_arena_reset(scratch);\n");
+    fprintf(file, "    if (!sc_nn_forward(net, x, 0, scratch)) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run the forward pass\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_tensor* dx = sc_nn_backward(net, r, scratch);\n");
+    fprintf(file, "    if (!dx || dx->dims->dims[0] != 11 || dx->dims->dims[1] != 5) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run the backward pass\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    // the finite differences run forward passes, keep the gradients of this step\n");
+    fprintf(file, "    sc_tensor* grad_x = sc_tensor_cast(dx, sc_float64, arena);\n");
+    fprintf(file, "    sc_tensor* grad_weights[4];\n");
+    fprintf(file, "    sc_vector* grad_biases[4];\n");
+    fprintf(file, "    uint64_t dense = 0;\n");
+    fprintf(file, "    for (uint64_t l = 0; l < net->count; l++) {\n");
+    fprintf(file, "        if (net->layers[l].kind == sc_nn_dense) {\n");
+    fprintf(file, "            grad_weights[dense] = sc_tensor_cast(net->layers[l].grad_weight, sc_float64, arena);\n");
+    fprintf(file, "            grad_biases[dense] = sc_vector_cast(net->layers[l].grad_bias, sc_float64, arena);\n");
+    fprintf(file, "            dense++;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    dense = 0;\n");
+    fprintf(file, "    for (uint64_t l = 0; l < net->count; l++) {\n");
+    fprintf(file, "        sc_nn_layer* layer = &net->layers[l];\n");
+    fprintf(file, "        if (layer->kind != sc_nn_dense) {\n");
+    fprintf(file, "            continue;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t i = 0; i < layer->weight->size; i += 2) {\n");
+    fprintf(file, "            double expected = nn_%s_numeric(net, layer->weight->data, i, x, r, h, scratch);\n", test.data_type);
+    fprintf(file, "            double got = ((double*)grad_weights[dense]->data)[i];\n");
+    fprintf(file, "            if (fabs(got - expected) > tolerance * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                CCB_WARNING(\"Layer %%u weight %%u gradient mismatch: expected %%f, got %%f\", l, i, expected, got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t i = 0; i < layer->bias->size; i++) {\n");
+    fprintf(file, "            double expected = nn_%s_numeric(net, layer->bias->data, i, x, r, h, scratch);\n", test.data_type);
+    fprintf(file, "            double got = ((double*)grad_biases[dense]->data)[i];\n");
+    fprintf(file, "            if (fabs(got - expected) > tolerance * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "                CCB_WARNING(\"Layer %%u bias %%u gradient mismatch: expected %%f, got %%f\", l, i, expected, got);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        dense++;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < x->size; i++) {\n");
+    fprintf(file, "        double expected = nn_%s_numeric(net, x->data, i, x, r, h, scratch);\n", test.data_type);
+    fprintf(file, "        double got = ((double*)grad_x->data)[i];\n");
+    fprintf(file, "        if (fabs(got - expected) > tolerance * (1.0 + fabs(expected))) {\n");
+    fprintf(file, "            CCB_WARNING(\"Input %%u gradient mismatch: expected %%f, got %%f\", i, expected, got);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // dropout in training: about a quarter of the values are dropped, the others scaled by 4 / 3\n");
+    fprintf(file, "    ccb_arena_reset(scratch);\n");
+    fprintf(file, "    sc_nn_forward(net, x, 1, scratch);\n");
+    fprintf(file, "    sc_nn_layer* dropout = &net->layers[4];\n");
+    fprintf(file, "    uint64_t kept = 0;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < 11 * 6; i++) {\n");
+    fprintf(file, "        double in = sc_value_to_f64(sc_get_vector_element(&(sc_vector){net->layers[3].output->data, 66, %s}, i));\n", test.sc_type);
+    fprintf(file, "        double out = sc_value_to_f64(sc_get_vector_element(&(sc_vector){dropout->output->data, 66, %s}, i));\n", test.sc_type);
+    fprintf(file, "        uint8_t keep = ((uint8_t*)dropout->cache)[i];\n");
+    fprintf(file, "        kept += keep;\n");
+    fprintf(file, "        if (fabs(out - (keep ? in * 4.0 / 3.0 : 0.0)) > 1e-5) {\n");
+    fprintf(file, "            CCB_WARNING(\"Dropout mismatch at %%u\", i);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (kept < 33 || kept > 62) {\n");
+    fprintf(file, "        CCB_WARNING(\"Dropout kept %%u values out of 66\", kept);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (!sc_nn_backward(net, r, scratch) || workspace->capacity != capacity) {\n");
+    fprintf(file, "        CCB_WARNING(\"The training step allocated from the workspace arena\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    ccb_arena_free(scratch);\n");
+    fprintf(file, "    ccb_arena_free(workspace);\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_autodiff(FILE* file, test_data test) {
+    fprintf(file, "// loss of a composite expression covering every op, params: x, W, b, gamma, beta\n");
+    fprintf(file, "static sc_var* autodiff_%s_loss(sc_tape* tape, sc_tensor** params, sc_tensor* c, sc_vector* labels, sc_var** leaves) {\n", test.data_type);
+    fprintf(file, "    for (uint64_t p = 0; p < 5; p++) {\n");
+    fprintf(file, "        leaves[p] = sc_ad_leaf(tape, params[p], 1);\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_var* weights = sc_ad_leaf(tape, c, 0);\n");
+    fprintf(file, "    sc_var* h1 = sc_ad_add_bias(tape, sc_ad_matmul(tape, leaves[0], leaves[1]), leaves[2]);\n");
+    fprintf(file, "    sc_var* h2 = sc_ad_layer_norm(tape, h1, leaves[3], leaves[4], 1e-5);\n");
+    fprintf(file, "    sc_var* a = sc_ad_tanh(tape, h2);\n");
+    fprintf(file, "    sc_var* s = sc_ad_sigmoid(tape, h1);\n");
+    fprintf(file, "    sc_var* r = sc_ad_relu(tape, h2);\n");
+    fprintf(file, "    sc_var* q = sc_ad_div(tape, sc_ad_mul(tape, a, s), sc_ad_add(tape, sc_ad_exp(tape, sc_ad_scale(tape, s, 0.5)), r));\n");
+    fprintf(file, "    sc_var* z = sc_ad_sub(tape, q, sc_ad_log(tape, sc_ad_add(tape, s, sc_ad_exp(tape, a))));\n");
+    fprintf(file, "    sc_var* sm = sc_ad_softmax(tape, z);\n");
+    fprintf(file, "    sc_var* extra = sc_ad_add(tape, sc_ad_sum(tape, sc_ad_mul(tape, sm, weights)), sc_ad_scale(tape, sc_ad_mean(tape, sc_ad_mul(tape, q, q)), 3.0));\n");
+    fprintf(file, "    return sc_ad_add(tape, sc_ad_cross_entropy(tape, z, labels), extra);\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_autodiff_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // gradients of the tape against finite differences, recycled intermediate gradients\n");
+    fprintf(file, "    if (%s != sc_float32 && %s != sc_float64) {\n", test.sc_type, test.sc_type);
+    fprintf(file, "        sc_tensor* value = sc_create_tensor(sc_create_dimensions(1, arena, (uint64_t[]){4}), %s, arena);\n", test.sc_type);
+    fprintf(file, "        return (sc_ad_leaf(sc_tape_create(arena), value, 1) == NULL) ? 0 : -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double h = (%s == sc_float32) ? 1e-2 : 1e-6;\n", test.sc_type);
+    fprintf(file, "    double tolerance = (%s == sc_float32) ? 3e-2 : 1e-6;\n", test.sc_type);
+    fprintf(file, "    ccb_arena* scratch = ccb_init_arena();\n");
+    fprintf(file, "\n");
+    fprintf(file, "    uint64_t shapes[5][2] = {{6, 4}, {4, 5}, {5, 0}, {5, 0}, {5, 0}};\n");
+    fprintf(file, "    sc_tensor* params[5];\n");
+    fprintf(file, "    for (uint64_t p = 0; p < 5; p++) {\n");
+    fprintf(file, "        params[p] = sc_create_tensor(sc_create_dimensions(shapes[p][1] ? 2 : 1, arena, shapes[p]), %s, arena);\n", test.sc_type);
+    fprintf(file, "        sc_vector view = {params[p]->data, params[p]->size, %s};\n", test.sc_type);
+    fprintf(file, "        for (uint64_t i = 0; i < view.size; i++) {\n");
+    fprintf(file, "            double value = (p == 3) ? 1.0 + 0.2 * cos((double)i) : sin((double)(i + 3 * p) * 0.9);\n");
+    fprintf(file, "            sc_set_vector_element(&view, i, to_sc_value(value, %s));\n", test.sc_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    uint64_t c_dims[] = {6, 5};\n");
+    fprintf(file, "    sc_tensor* c = sc_create_tensor(sc_create_dimensions(2, arena, c_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector c_view = {c->data, c->size, %s};\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < c->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&c_view, i, to_sc_value(cos((double)i * 1.7), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector* labels = sc_create_vector(6, sc_int32, arena);\n");
+    fprintf(file, "    for (uint64_t i = 0; i < 6; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(labels, i, to_sc_value((double)((i * 3) %% 5), sc_int32));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_var* leaves[5];\n");
+    fprintf(file, "    sc_tape* tape = sc_tape_create(arena);\n");
+    fprintf(file, "    sc_var* loss = autodiff_%s_loss(tape, params, c, labels, leaves);\n", test.data_type);
+    fprintf(file, "    if (!loss || sc_tape_backward(tape, loss) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run the tape\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < tape->count; i++) {\n");
+    fprintf(file, "        sc_var* node = tape->nodes[i];\n");
+    fprintf(file, "        int expected = (node->op == sc_ad_op_leaf && node->requires_grad) || node == loss;\n");
+    fprintf(file, "        if ((node->grad != NULL) != expected) {\n");
+    fprintf(file, "            CCB_WARNING(\"Node %%\" PRIu64 \" (op %%d) %%s a gradient\", i, node->op, expected ? \"lacks\" : \"keeps\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (uint64_t p = 0; p < 5; p++) {\n");
+    fprintf(file, "        sc_vector view = {params[p]->data, params[p]->size, %s};\n", test.sc_type);
+    fprintf(file, "        sc_vector grad = {leaves[p]->grad->data, leaves[p]->grad->size, %s};\n", test.sc_type);
+    fprintf(file, "        for (uint64_t i = 0; i < view.size; i++) {\n");
+    fprintf(file, "            double value = sc_value_to_f64(sc_get_vector_element(&view, i));\n");
+    fprintf(file, "            sc_var* unused[5];\n");
+    fprintf(file, "            sc_set_vector_element(&view, i, to_sc_value(value + h, %s));\n", test.sc_type);
+    fprintf(file, "            ccb_arena_reset(scratch);\n");
+    fprintf(file, "            double plus = sc_value_to_f64(sc_get_vector_element(&(sc_vector){autodiff_%s_loss(sc_tape_create(scratch), params, c, labels, unused)->value->data, 1, %s}, 0));\n", test.data_type, test.sc_type);
+    fprintf(file, "            sc_set_vector_element(&view, i, to_sc_value(value - h, %s));\n", test.sc_type);
+    fprintf(file, "            ccb_arena_reset(scratch);\n");
+    fprintf(file, "            double minus = sc_value_to_f64(sc_get_vector_element(&(sc_vector){autodiff_%s_loss(sc_tape_create(scratch), params, c, labels, unused)->value->data, 1, %s}, 0));\n", test.data_type, test.sc_type);
+    fprintf(file, "            sc_set_vector_element(&view, i, to_sc_value(value, %s));\n", test.sc_type);
+    fprintf(file, "            double numeric = (plus - minus) / (2.0 * h);\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(&grad, i));\n");
+    fprintf(file, "            if (fabs(got - numeric) > tolerance * (1.0 + fabs(numeric))) {\n");
+    fprintf(file, "                CCB_WARNING(\"Gradient mismatch of parameter %%\" PRIu64 \" at %%\" PRIu64 \": %%f vs %%f\", p, i, got, numeric);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // shape errors\n");
+    fprintf(file, "    sc_tape* other = sc_tape_create(scratch);\n");
+    fprintf(file, "    if (sc_ad_add(other, sc_ad_leaf(other, params[0], 1), sc_ad_leaf(other, params[1], 1)) != NULL ||\n");
+    fprintf(file, "        sc_ad_matmul(other, sc_ad_leaf(other, params[0], 1), sc_ad_leaf(other, params[0], 1)) != NULL) {\n");
+    fprintf(file, "        CCB_WARNING(\"Mismatched shapes were accepted\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    ccb_arena_free(scratch);\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_optim(FILE* file, test_data test) {
+    fprintf(file, "// double reference of the update of one element\n");
+    fprintf(file, "static double optim_%s_reference(const sc_optim_options* o, uint64_t step, double p, double g, double* m, double* v) {\n", test.data_type);
+    fprintf(file, "    if (o->kind == sc_optim_adamw) {\n");
+    fprintf(file, "        p *= 1.0 - o->learning_rate * o->weight_decay;\n");
+    fprintf(file, "    } else {\n");
+    fprintf(file, "        g += o->weight_decay * p;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (o->kind == sc_optim_sgd) {\n");
+    fprintf(file, "        *m = o->momentum * *m + g;\n");
+    fprintf(file, "        return p - o->learning_rate * (o->nesterov ? g + o->momentum * *m : *m);\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (o->kind == sc_optim_rmsprop) {\n");
+    fprintf(file, "        *v = o->beta2 * *v + (1.0 - o->beta2) * g * g;\n");
+    fprintf(file, "        *m = o->momentum * *m + g / (sqrt(*v) + o->eps);\n");
+    fprintf(file, "        return p - o->learning_rate * *m;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    *m = o->beta1 * *m + (1.0 - o->beta1) * g;\n");
+    fprintf(file, "    *v = o->beta2 * *v + (1.0 - o->beta2) * g * g;\n");
+    fprintf(file, "    double m_hat = *m / (1.0 - pow(o->beta1, (double)step));\n");
+    fprintf(file, "    double v_hat = *v / (1.0 - pow(o->beta2, (double)step));\n");
+    fprintf(file, "    return p - o->learning_rate * m_hat / (sqrt(v_hat) + o->eps);\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static float optim_%s_bf16_to_f32(uint16_t bits) {\n", test.data_type);
+    fprintf(file, "    uint32_t wide = (uint32_t)bits << 16;\n");
+    fprintf(file, "    float out;\n");
+    fprintf(file, "    memcpy(&out, &wide, sizeof(float));\n");
+    fprintf(file, "    return out;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static uint16_t optim_%s_f32_to_bf16(float value) {\n", test.data_type);
+    fprintf(file, "    uint32_t bits;\n");
+    fprintf(file, "    memcpy(&bits, &value, sizeof(float));\n");
+    fprintf(file, "    return (uint16_t)((bits + 0x7fff + ((bits >> 16) & 1)) >> 16);\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "// bfloat16 parameters with float32 gradients: master weights and stochastic rounding\n");
+    fprintf(file, "static int optim_%s_bf16(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    uint64_t n = 4099;\n");
+    fprintf(file, "    sc_vector* param = sc_create_vector(n, sc_float16, arena);\n");
+    fprintf(file, "    sc_vector* grad = sc_create_vector(n, sc_float32, arena);\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        ((uint16_t*)param->data)[i] = optim_%s_f32_to_bf16(1.0f);\n", test.data_type);
+    fprintf(file, "        ((float*)grad->data)[i] = -0x1.0p-10f;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // plain SGD steps smaller than half an ulp of 1: lost by rounding to nearest, kept by the master weights\n");
+    fprintf(file, "    sc_optim_options options = sc_optim_default_options(sc_optim_sgd);\n");
+    fprintf(file, "    options.learning_rate = 1.0;\n");
+    fprintf(file, "    options.momentum = 0.0;\n");
+    fprintf(file, "    options.master_weights = 0;\n");
+    fprintf(file, "    sc_optim_state* nearest = sc_optim_create(param, &options, arena);\n");
+    fprintf(file, "    options.master_weights = 1;\n");
+    fprintf(file, "    sc_vector* copy = sc_create_vector(n, sc_float16, arena);\n");
+    fprintf(file, "    memcpy(copy->data, param->data, n * sizeof(uint16_t));\n");
+    fprintf(file, "    sc_optim_state* master = sc_optim_create(copy, &options, arena);\n");
+    fprintf(file, "    for (int s = 0; s < 8; s++) {\n");
+    fprintf(file, "        if (sc_optim_step(nearest, param, grad, arena) != 0 || sc_optim_step(master, copy, grad, arena) != 0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to run bfloat16 steps\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        float p = optim_%s_bf16_to_f32(((uint16_t*)param->data)[i]);\n", test.data_type);
+    fprintf(file, "        float q = optim_%s_bf16_to_f32(((uint16_t*)copy->data)[i]);\n", test.data_type);
+    fprintf(file, "        if (p != 1.0f || master->master[i] != 1.0f + 0x1.0p-7f || q != 1.0f + 0x1.0p-7f) {\n");
+    fprintf(file, "            CCB_WARNING(\"bfloat16 update mismatch at %%\" PRIu64 \": nearest %%f, master %%f (%%f)\", i, p, q, master->master[i]);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // stochastic rounding: unbiased on average, reproducible from the seed\n");
+    fprintf(file, "    options.master_weights = 0;\n");
+    fprintf(file, "    options.stochastic_rounding = 1;\n");
+    fprintf(file, "    options.seed = 42;\n");
+    fprintf(file, "    double mean[2];\n");
+    fprintf(file, "    uint16_t first = 0;\n");
+    fprintf(file, "    for (int run = 0; run < 2; run++) {\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            ((uint16_t*)param->data)[i] = optim_%s_f32_to_bf16(1.0f);\n", test.data_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_optim_state* state = sc_optim_create(param, &options, arena);\n");
+    fprintf(file, "        if (sc_optim_step(state, param, grad, arena) != 0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to run a stochastic rounding step\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        mean[run] = 0.0;\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            mean[run] += optim_%s_bf16_to_f32(((uint16_t*)param->data)[i]) / (double)n;\n", test.data_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        if (run == 0) {\n");
+    fprintf(file, "            first = ((uint16_t*)param->data)[n - 1];\n");
+    fprintf(file, "        } else if (mean[0] != mean[1] || first != ((uint16_t*)param->data)[n - 1]) {\n");
+    fprintf(file, "            CCB_WARNING(\"Stochastic rounding is not reproducible\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (fabs(mean[0] - (1.0 + 0x1.0p-10)) > 0x1.0p-13) {\n");
+    fprintf(file, "        CCB_WARNING(\"Stochastic rounding is biased: mean %%.8f vs %%.8f\", mean[0], 1.0 + 0x1.0p-10);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_optim_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // every optimiser against a double reference over a few steps\n");
+    fprintf(file, "    if (%s != sc_float32 && %s != sc_float64) {\n", test.sc_type, test.sc_type);
+    fprintf(file, "        sc_vector* param = sc_create_vector(16, %s, arena);\n", test.sc_type);
+    fprintf(file, "        if (%s == sc_float16) {\n", test.sc_type);
+    fprintf(file, "            return (sc_optim_create(param, NULL, arena) != NULL) ? 0 : -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        return (sc_optim_create(param, NULL, arena) == NULL) ? 0 : -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double tolerance = (%s == sc_float32) ? 1e-5 : 1e-12;\n", test.sc_type);
+    fprintf(file, "    uint64_t n = 10007;\n");
+    fprintf(file, "    sc_optim_kind kinds[] = {sc_optim_sgd, sc_optim_sgd, sc_optim_adam, sc_optim_adamw, sc_optim_rmsprop};\n");
+    fprintf(file, "    for (int k = 0; k < 5; k++) {\n");
+    fprintf(file, "        sc_optim_options options = sc_optim_default_options(kinds[k]);\n");
+    fprintf(file, "        options.learning_rate = 0.05;\n");
+    fprintf(file, "        options.nesterov = (k == 1);\n");
+    fprintf(file, "        options.momentum = (kinds[k] == sc_optim_rmsprop) ? 0.5 : options.momentum;\n");
+    fprintf(file, "        options.weight_decay = (kinds[k] == sc_optim_adamw) ? 0.1 : 0.01;\n");
+    fprintf(file, "\n");
+    fprintf(file, "        sc_vector* param = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "        sc_vector* grad = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "        double* expected = (double*)ccb_arena_malloc(arena, 3 * n * sizeof(double));\n");
+    fprintf(file, "        double* m = expected + n;\n");
+    fprintf(file, "        double* v = expected + 2 * n;\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            expected[i] = sin((double)i * 0.37);\n");
+    fprintf(file, "            m[i] = 0.0;\n");
+    fprintf(file, "            v[i] = 0.0;\n");
+    fprintf(file, "            sc_set_vector_element(param, i, to_sc_value(expected[i], %s));\n", test.sc_type);
+    fprintf(file, "            expected[i] = sc_value_to_f64(sc_get_vector_element(param, i));\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_optim_state* state = sc_optim_create(param, &options, arena);\n");
+    fprintf(file, "        if (!state) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to create optimiser %%d\", kinds[k]);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t step = 1; step <= 3; step++) {\n");
+    fprintf(file, "            for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "                sc_set_vector_element(grad, i, to_sc_value(cos((double)(i * step) * 0.11) * (double)step, %s));\n", test.sc_type);
+    fprintf(file, "                double g = sc_value_to_f64(sc_get_vector_element(grad, i));\n");
+    fprintf(file, "                expected[i] = optim_%s_reference(&options, step, expected[i], g, m + i, v + i);\n", test.data_type);
+    fprintf(file, "            }\n");
+    fprintf(file, "            if (sc_optim_step(state, param, grad, arena) != 0) {\n");
+    fprintf(file, "                CCB_WARNING(\"Failed to run optimiser %%d\", kinds[k]);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            double got = sc_value_to_f64(sc_get_vector_element(param, i));\n");
+    fprintf(file, "            if (fabs(got - expected[i]) > tolerance * (1.0 + fabs(expected[i]))) {\n");
+    fprintf(file, "                CCB_WARNING(\"Optimiser %%d mismatch at %%\" PRIu64 \": %%f vs %%f\", k, i, got, expected[i]);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_vector* small = sc_create_vector(3, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_optim_state* state = sc_optim_create(small, NULL, arena);\n");
+    fprintf(file, "    if (sc_optim_step(state, small, sc_create_vector(4, %s, arena), arena) == 0) {\n", test.sc_type);
+    fprintf(file, "        CCB_WARNING(\"A gradient of the wrong size was accepted\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return (%s == sc_float32) ? optim_%s_bf16(arena) : 0;\n", test.sc_type, test.data_type);
+    fprintf(file, "}\n");
+}
+
+void gen_test_random(FILE* file, test_data test) {
+    fprintf(file, "static int random_%s_stats(sc_vector* v, double lo, double hi, double* mean, double* std) {\n", test.data_type);
+    fprintf(file, "    double sum = 0.0;\n");
+    fprintf(file, "    double squares = 0.0;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < v->size; i++) {\n");
+    fprintf(file, "        double x = sc_value_to_f64(sc_get_vector_element(v, i));\n");
+    fprintf(file, "        if (!(x >= lo && x <= hi)) {\n");
+    fprintf(file, "            CCB_WARNING(\"Random value %%f at %%\" PRIu64 \" is out of [%%f, %%f]\", x, i, lo, hi);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sum += x;\n");
+    fprintf(file, "        squares += x * x;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    *mean = sum / (double)v->size;\n");
+    fprintf(file, "    *std = sqrt(squares / (double)v->size - *mean * *mean);\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_random_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // Philox known answer, fills independent of the chunking, value ranges and moments\n");
+    fprintf(file, "    uint32_t counter[4] = {0, 0, 0, 0};\n");
+    fprintf(file, "    uint32_t key[2] = {0, 0};\n");
+    fprintf(file, "    uint32_t words[4];\n");
+    fprintf(file, "    sc_philox4x32(counter, key, words);\n");
+    fprintf(file, "    if (words[0] != 0x6627e8d5 || words[1] != 0xe169c58d || words[2] != 0xbc57ac4c || words[3] != 0x9b00dbd8) {\n");
+    fprintf(file, "        CCB_WARNING(\"Philox4x32-10 known answer mismatch: %%08x %%08x %%08x %%08x\", words[0], words[1], words[2], words[3]);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    int integer = %s == sc_int32 || %s == sc_int64 || %s == sc_uint8;\n", test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "    double lo = (%s == sc_uint8) ? 2.0 : -3.0;\n", test.sc_type);
+    fprintf(file, "    double hi = lo + 10.0;\n");
+    fprintf(file, "    uint64_t n = 70001;\n");
+    fprintf(file, "    uint64_t small = 10007;\n");
+    fprintf(file, "    uint64_t bytes = sc_type_size(%s);\n", test.sc_type);
+    fprintf(file, "\n");
+    fprintf(file, "    sc_rng rng = sc_rng_create(0x1234567890ull);\n");
+    fprintf(file, "    sc_vector* big = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    if (sc_rng_uniform(&rng, big, lo, hi, arena) != 0 || rng.counter != (n + 31) / 32 * 8) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run a uniform fill\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_rng other = sc_rng_create(0x1234567890ull);\n");
+    fprintf(file, "    sc_vector* part = sc_create_vector(small, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_rng_uniform(&other, part, lo, hi, arena);\n");
+    fprintf(file, "    if (memcmp(big->data, part->data, small * bytes) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"A fill depends on its size\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_rng_uniform(&other, part, lo, hi, arena);\n");
+    fprintf(file, "    if (memcmp(big->data, part->data, small * bytes) == 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"The counter did not advance\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (%s == sc_float32) {\n", test.sc_type);
+    fprintf(file, "        // element i is the word (i %% 32) / 8 of the block (i / 32) * 8 + i %% 8 (the AVX2 kernel may fuse the multiply add)\n");
+    fprintf(file, "        uint32_t seed_key[2] = {0x34567890u, 0x12u};\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i += 97) {\n");
+    fprintf(file, "            uint64_t block = i / 32 * 8 + i %% 8;\n");
+    fprintf(file, "            uint32_t c[4] = {(uint32_t)block, (uint32_t)(block >> 32), 0, 0};\n");
+    fprintf(file, "            sc_philox4x32(c, seed_key, words);\n");
+    fprintf(file, "            float expected = (float)lo + (float)(words[(i %% 32) / 8] >> 8) * 0x1.0p-24f * 10.0f;\n");
+    fprintf(file, "            if (fabsf(((float*)big->data)[i] - expected) > 1e-5f) {\n");
+    fprintf(file, "                CCB_WARNING(\"Uniform value mismatch at %%\" PRIu64 \": %%f vs %%f\", i, ((float*)big->data)[i], expected);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double mean, std;\n");
+    fprintf(file, "    if (random_%s_stats(big, lo, integer ? hi - 1.0 : hi, &mean, &std) != 0 ||\n", test.data_type);
+    fprintf(file, "        fabs(mean - (integer ? lo + 4.5 : lo + 5.0)) > 0.05 || fabs(std - (integer ? sqrt(99.0 / 12.0) : sqrt(100.0 / 12.0))) > 0.05) {\n");
+    fprintf(file, "        CCB_WARNING(\"Uniform moments mismatch: mean %%f, std %%f\", mean, std);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    double center = integer ? 50.0 : 0.0;\n");
+    fprintf(file, "    double spread = integer ? 10.0 : 1.0;\n");
+    fprintf(file, "    if (sc_rng_normal(&rng, big, center, spread, arena) != 0 || random_%s_stats(big, center - 7.0 * spread, center + 7.0 * spread, &mean, &std) != 0 ||\n", test.data_type);
+    fprintf(file, "        fabs(mean - center) > 0.03 * spread || fabs(std - spread) > 0.03 * spread) {\n");
+    fprintf(file, "        CCB_WARNING(\"Normal moments mismatch: mean %%f, std %%f\", mean, std);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    // truncated to [mean - std, mean + 2 std]: mean + std (phi(-1) - phi(2)) / (Phi(2) - Phi(-1))\n");
+    fprintf(file, "    double expected = center + spread * 0.18797 / 0.81859;\n");
+    fprintf(file, "    if (sc_rng_truncated_normal(&rng, big, center, spread, center - spread, center + 2.0 * spread, arena) != 0 ||\n");
+    fprintf(file, "        random_%s_stats(big, center - spread, center + 2.0 * spread, &mean, &std) != 0 || (!integer && fabs(mean - expected) > 0.02)) {\n", test.data_type);
+    fprintf(file, "        CCB_WARNING(\"Truncated normal mismatch: mean %%f vs %%f\", mean, expected);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_rng_bernoulli(&rng, big, 0.3, arena) != 0 || random_%s_stats(big, 0.0, 1.0, &mean, &std) != 0 || fabs(mean - 0.3) > 0.01) {\n", test.data_type);
+    fprintf(file, "        CCB_WARNING(\"Bernoulli mean mismatch: %%f\", mean);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        double x = sc_value_to_f64(sc_get_vector_element(big, i));\n");
+    fprintf(file, "        if (x != 0.0 && x != 1.0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Bernoulli value %%f at %%\" PRIu64, x, i);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return (sc_rng_uniform(&rng, big, 1.0, 0.0, arena) != 0 && sc_rng_bernoulli(&rng, big, 1.5, arena) != 0) ? 0 : -1;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_factor(FILE* file, test_data test) {
+    fprintf(file, "static double factor_get_%s(sc_tensor* t, uint64_t i) {\n", test.data_type);
+    fprintf(file, "    sc_vector view = {t->data, t->size, t->type};\n");
+    fprintf(file, "    return sc_value_to_f64(sc_get_vector_element(&view, i));\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static void factor_set_%s(sc_tensor* t, uint64_t i, double value) {\n", test.data_type);
+    fprintf(file, "    sc_vector view = {t->data, t->size, t->type};\n");
+    fprintf(file, "    sc_set_vector_element(&view, i, to_sc_value(value, t->type));\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static sc_tensor* factor_matrix_%s(uint64_t rows, uint64_t cols, ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    uint64_t dims[] = {rows, cols};\n");
+    fprintf(file, "    return sc_create_tensor(sc_create_dimensions(2, arena, dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "// largest |A.x - b| over the nrhs columns, relative to the largest |b|\n");
+    fprintf(file, "static double factor_residual_%s(sc_tensor* a, sc_tensor* x, sc_tensor* b, uint64_t nrhs) {\n", test.data_type);
+    fprintf(file, "    uint64_t m = a->dims->dims[0];\n");
+    fprintf(file, "    uint64_t n = a->dims->dims[1];\n");
+    fprintf(file, "    double worst = 0.0;\n");
+    fprintf(file, "    double scale = 1e-30;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < m; i++) {\n");
+    fprintf(file, "        for (uint64_t c = 0; c < nrhs; c++) {\n");
+    fprintf(file, "            double sum = 0.0;\n");
+    fprintf(file, "            for (uint64_t p = 0; p < n; p++) {\n");
+    fprintf(file, "                sum += factor_get_%s(a, i * n + p) * factor_get_%s(x, p * nrhs + c);\n", test.data_type, test.data_type);
+    fprintf(file, "            }\n");
+    fprintf(file, "            double target = factor_get_%s(b, i * nrhs + c);\n", test.data_type);
+    fprintf(file, "            worst = fmax(worst, fabs(sum - target));\n");
+    fprintf(file, "            scale = fmax(scale, fabs(target));\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return worst / scale;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_factor_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // residuals of the blocked LU / Cholesky / QR / trsm solvers (sizes across the 64 panel) and of the batched solvers\n");
+    fprintf(file, "    uint64_t n = 100;\n");
+    fprintf(file, "    uint64_t nrhs = 3;\n");
+    fprintf(file, "    sc_tensor* a = factor_matrix_%s(n, n, arena);\n", test.data_type);
+    fprintf(file, "    sc_tensor* b = factor_matrix_%s(n, nrhs, arena);\n", test.data_type);
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        for (uint64_t j = 0; j < n; j++) {\n");
+    fprintf(file, "            factor_set_%s(a, i * n + j, (double)((i * 7 + j * 13) %% 19) / 19.0 - 0.5 + ((i == j) ? 4.0 : 0.0));\n", test.data_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t c = 0; c < nrhs; c++) {\n");
+    fprintf(file, "            factor_set_%s(b, i * nrhs + c, (double)((i * 5 + c * 3) %% 11) - 5.0);\n", test.data_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    uint64_t* pivots = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));\n");
+    fprintf(file, "    if (%s != sc_float32 && %s != sc_float64) {\n", test.sc_type, test.sc_type);
+    fprintf(file, "        if (sc_lu_inplace(a, pivots, arena) != -1 || sc_solve(a, b, arena) != NULL) {\n");
+    fprintf(file, "            CCB_WARNING(\"Factorisations should only accept float32 and float64\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        return 0;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double tolerance = (%s == sc_float32) ? 1e-4 : 1e-10;\n", test.sc_type);
+    fprintf(file, "\n");
+    fprintf(file, "    // LU\n");
+    fprintf(file, "    sc_tensor* x = sc_solve(a, b, arena);\n");
+    fprintf(file, "    if (!x || factor_residual_%s(a, x, b, nrhs) > tolerance) {\n", test.data_type);
+    fprintf(file, "        CCB_WARNING(\"LU solve residual too large\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_tensor* inverse = sc_inverse(a, arena);\n");
+    fprintf(file, "    if (!inverse) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to invert the matrix\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i += 9) {\n");
+    fprintf(file, "        for (uint64_t j = 0; j < n; j += 7) {\n");
+    fprintf(file, "            double sum = 0.0;\n");
+    fprintf(file, "            for (uint64_t p = 0; p < n; p++) {\n");
+    fprintf(file, "                sum += factor_get_%s(a, i * n + p) * factor_get_%s(inverse, p * n + j);\n", test.data_type, test.data_type);
+    fprintf(file, "            }\n");
+    fprintf(file, "            if (fabs(sum - ((i == j) ? 1.0 : 0.0)) > tolerance * 10.0) {\n");
+    fprintf(file, "                CCB_WARNING(\"A.A^-1 [%%u, %%u] = %%f\", i, j, sum);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_tensor* singular = factor_matrix_%s(n, n, arena);\n", test.data_type);
+    fprintf(file, "    memcpy(singular->data, a->data, n * n * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        factor_set_%s(singular, i * n + 70, 0.0);\n", test.data_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_solve(singular, b, arena) != NULL || sc_lu_inplace(singular, pivots, arena) != 1) {\n");
+    fprintf(file, "        CCB_WARNING(\"Singular matrix not detected by LU\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // Cholesky on A^T.A + n.I, then trsm of the factor against the explicit products\n");
+    fprintf(file, "    sc_tensor* spd = factor_matrix_%s(n, n, arena);\n", test.data_type);
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        for (uint64_t j = 0; j < n; j++) {\n");
+    fprintf(file, "            double sum = (i == j) ? (double)n : 0.0;\n");
+    fprintf(file, "            for (uint64_t p = 0; p < n; p++) {\n");
+    fprintf(file, "                sum += factor_get_%s(a, p * n + i) * factor_get_%s(a, p * n + j);\n", test.data_type, test.data_type);
+    fprintf(file, "            }\n");
+    fprintf(file, "            factor_set_%s(spd, i * n + j, sum);\n", test.data_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_tensor* l = factor_matrix_%s(n, n, arena);\n", test.data_type);
+    fprintf(file, "    memcpy(l->data, spd->data, n * n * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "    memcpy(x->data, b->data, n * nrhs * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "    if (sc_cholesky_inplace(l, 0.0, arena) != 0 || factor_get_%s(l, 5 * n + 50) != 0.0 ||\n", test.data_type);
+    fprintf(file, "        sc_cholesky_solve(l, x, arena) != 0 || factor_residual_%s(spd, x, b, nrhs) > tolerance) {\n", test.data_type);
+    fprintf(file, "        CCB_WARNING(\"Cholesky solve residual too large\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t trans = 0; trans < 2; trans++) {\n");
+    fprintf(file, "        sc_tensor* op = factor_matrix_%s(n, n, arena);\n", test.data_type);
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            for (uint64_t j = 0; j < n; j++) {\n");
+    fprintf(file, "                factor_set_%s(op, i * n + j, trans ? factor_get_%s(l, j * n + i) : factor_get_%s(l, i * n + j));\n", test.data_type, test.data_type, test.data_type);
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        memcpy(x->data, b->data, n * nrhs * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "        if (sc_trsm(l, x, 1, (int)trans, 0, arena) != 0 || factor_residual_%s(op, x, b, nrhs) > tolerance) {\n", test.data_type);
+    fprintf(file, "            CCB_WARNING(\"trsm (trans %%u) residual too large\", trans);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    factor_set_%s(spd, 80 * n + 80, -1.0);\n", test.data_type);
+    fprintf(file, "    if (sc_cholesky_inplace(spd, 0.0, arena) != 1) {\n");
+    fprintf(file, "        CCB_WARNING(\"Indefinite matrix not detected by Cholesky\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // QR least squares on [150, 100]: the residual is orthogonal to the columns\n");
+    fprintf(file, "    uint64_t m = 150;\n");
+    fprintf(file, "    sc_tensor* tall = factor_matrix_%s(m, n, arena);\n", test.data_type);
+    fprintf(file, "    sc_tensor* qr = factor_matrix_%s(m, n, arena);\n", test.data_type);
+    fprintf(file, "    sc_tensor* rhs = factor_matrix_%s(m, 1, arena);\n", test.data_type);
+    fprintf(file, "    sc_tensor* solution = factor_matrix_%s(n, 1, arena);\n", test.data_type);
+    fprintf(file, "    for (uint64_t i = 0; i < m; i++) {\n");
+    fprintf(file, "        for (uint64_t j = 0; j < n; j++) {\n");
+    fprintf(file, "            factor_set_%s(tall, i * n + j, factor_get_%s(a, (i %% n) * n + j) + ((i >= n && i - n == j %% 50) ? 1.0 : 0.0));\n", test.data_type, test.data_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        factor_set_%s(rhs, i, (double)((i * 3) %% 13) - 6.0);\n", test.data_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    memcpy(qr->data, tall->data, m * n * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "    sc_tensor* qtb = factor_matrix_%s(m, 1, arena);\n", test.data_type);
+    fprintf(file, "    memcpy(qtb->data, rhs->data, m * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "    sc_vector* tau = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    if (sc_qr_inplace(qr, tau, arena) != 0 || sc_qr_solve(qr, tau, qtb, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to solve the least squares problem\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    memcpy(solution->data, qtb->data, n * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "    double worst = 0.0;\n");
+    fprintf(file, "    double scale = 1e-30;\n");
+    fprintf(file, "    for (uint64_t j = 0; j < n; j++) {\n");
+    fprintf(file, "        double dot = 0.0;\n");
+    fprintf(file, "        for (uint64_t i = 0; i < m; i++) {\n");
+    fprintf(file, "            double fitted = 0.0;\n");
+    fprintf(file, "            for (uint64_t p = 0; p < n; p++) {\n");
+    fprintf(file, "                fitted += factor_get_%s(tall, i * n + p) * factor_get_%s(solution, p);\n", test.data_type, test.data_type);
+    fprintf(file, "            }\n");
+    fprintf(file, "            dot += factor_get_%s(tall, i * n + j) * (fitted - factor_get_%s(rhs, i));\n", test.data_type, test.data_type);
+    fprintf(file, "            scale = fmax(scale, fabs(factor_get_%s(tall, i * n + j) * factor_get_%s(rhs, i)));\n", test.data_type, test.data_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        worst = fmax(worst, fabs(dot));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (worst / scale > tolerance * 100.0) {\n");
+    fprintf(file, "        CCB_WARNING(\"QR normal equations residual too large: %%e\", worst / scale);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // batched LU and Cholesky on 50 systems of 12, one of them singular / indefinite\n");
+    fprintf(file, "    uint64_t batch = 50;\n");
+    fprintf(file, "    uint64_t small = 12;\n");
+    fprintf(file, "    uint64_t batch_dims[] = {batch, small, small};\n");
+    fprintf(file, "    uint64_t rhs_dims[] = {batch, small};\n");
+    fprintf(file, "    sc_tensor* systems = sc_create_tensor(sc_create_dimensions(3, arena, batch_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* factors = sc_create_tensor(sc_create_dimensions(3, arena, batch_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* targets = sc_create_tensor(sc_create_dimensions(2, arena, rhs_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* solutions = sc_create_tensor(sc_create_dimensions(2, arena, rhs_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (int cholesky = 0; cholesky < 2; cholesky++) {\n");
+    fprintf(file, "        for (uint64_t s = 0; s < batch; s++) {\n");
+    fprintf(file, "            for (uint64_t i = 0; i < small; i++) {\n");
+    fprintf(file, "                for (uint64_t j = 0; j < small; j++) {\n");
+    fprintf(file, "                    double value = cholesky ? 1.0 / (1.0 + (double)(i > j ? i - j : j - i)) + ((i == j) ? (double)s * 0.1 : 0.0)\n");
+    fprintf(file, "                                            : (double)((s + i * 5 + j * 3) %% 7) - 3.0 + ((i == j) ? 8.0 : 0.0);\n");
+    fprintf(file, "                    factor_set_%s(systems, (s * small + i) * small + j, value);\n", test.data_type);
+    fprintf(file, "                }\n");
+    fprintf(file, "                factor_set_%s(targets, s * small + i, (double)((s + i) %% 5) - 2.0);\n", test.data_type);
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t j = 0; j < small; j++) {\n");
+    fprintf(file, "            factor_set_%s(systems, (17 * small + 4) * small + j, cholesky ? ((j == 4) ? -1.0 : 0.0) : 0.0);\n", test.data_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        memcpy(factors->data, systems->data, systems->size * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "        memcpy(solutions->data, targets->data, targets->size * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "        int failures = cholesky ? sc_batched_cholesky_solve(factors, solutions, arena) : sc_batched_lu_solve(factors, solutions, arena);\n");
+    fprintf(file, "        if (failures != 1) {\n");
+    fprintf(file, "            CCB_WARNING(\"Batched solve (cholesky %%d) reported %%d failures\", cholesky, failures);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        uint64_t system_dims[] = {small, small};\n");
+    fprintf(file, "        uint64_t vector_dims[] = {small, 1};\n");
+    fprintf(file, "        sc_dimensions system_shape = {2, system_dims};\n");
+    fprintf(file, "        sc_dimensions vector_shape = {2, vector_dims};\n");
+    fprintf(file, "        for (uint64_t s = 0; s < batch; s++) {\n");
+    fprintf(file, "            if (s == 17) {\n");
+    fprintf(file, "                continue;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            sc_tensor system = {(uint8_t*)systems->data + s * small * small * sc_type_size(%s), &system_shape, small * small, %s};\n", test.sc_type, test.sc_type);
+    fprintf(file, "            sc_tensor solved = {(uint8_t*)solutions->data + s * small * sc_type_size(%s), &vector_shape, small, %s};\n", test.sc_type, test.sc_type);
+    fprintf(file, "            sc_tensor target = {(uint8_t*)targets->data + s * small * sc_type_size(%s), &vector_shape, small, %s};\n", test.sc_type, test.sc_type);
+    fprintf(file, "            if (factor_residual_%s(&system, &solved, &target, 1) > tolerance) {\n", test.data_type);
+    fprintf(file, "                CCB_WARNING(\"Batched solve (cholesky %%d) residual too large for system %%u\", cholesky, s);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_geometry(FILE* file, test_data test) {
+    fprintf(file, "static double geometry_get_%s(sc_soa* s, uint32_t c, uint64_t i) {\n", test.data_type);
+    fprintf(file, "    return (s->type == sc_float64) ? ((double*)s->data)[c * s->stride + i] : (double)((float*)s->data)[c * s->stride + i];\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_geometry_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // batched kernels against per item references, on a count with a SIMD tail, in place and with broadcast items\n");
+    fprintf(file, "    uint64_t count = 1003;\n");
+    fprintf(file, "    if (%s != sc_float32 && %s != sc_float64) {\n", test.sc_type, test.sc_type);
+    fprintf(file, "        if (sc_create_soa(count, 3, %s, arena) != NULL) {\n", test.sc_type);
+    fprintf(file, "            CCB_WARNING(\"Batches should only accept float32 and float64\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        return 0;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double tolerance = (%s == sc_float32) ? 1e-5 : 1e-12;\n", test.sc_type);
+    fprintf(file, "    uint64_t dims[] = {count, 3};\n");
+    fprintf(file, "    sc_tensor* aos = sc_create_tensor(sc_create_dimensions(2, arena, dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector flat = {aos->data, aos->size, aos->type};\n");
+    fprintf(file, "    for (uint64_t k = 0; k < aos->size; k++) {\n");
+    fprintf(file, "        sc_set_vector_element(&flat, k, to_sc_value((double)((k * 37) %% 23) / 7.0 - 1.5, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_soa* a = sc_create_soa(count, 3, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_soa* b = sc_create_soa(count, 3, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_soa* out = sc_create_soa(count, 3, %s, arena);\n", test.sc_type);
+    fprintf(file, "    if (!a || !b || !out || sc_soa_pack(aos, a, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to create the batches\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < count; i++) {\n");
+    fprintf(file, "        for (uint32_t c = 0; c < 3; c++) {\n");
+    fprintf(file, "            double value = geometry_get_%s(a, c, count - 1 - i) + 0.25 * c;\n", test.data_type);
+    fprintf(file, "            if (%s == sc_float64) ((double*)b->data)[c * b->stride + i] = value; else ((float*)b->data)[c * b->stride + i] = (float)value;\n", test.sc_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // AoS round trip\n");
+    fprintf(file, "    sc_tensor* back = sc_create_tensor(sc_create_dimensions(2, arena, dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    if (sc_soa_unpack(a, back, arena) != 0 || memcmp(back->data, aos->data, aos->size * sc_type_size(%s)) != 0) {\n", test.sc_type);
+    fprintf(file, "        CCB_WARNING(\"AoS -> SoA -> AoS round trip failed\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // cross against sc_vector_cross, dot\n");
+    fprintf(file, "    sc_vector* dots = sc_create_vector(count, %s, arena);\n", test.sc_type);
+    fprintf(file, "    if (sc_soa_cross(a, b, out, arena) != 0 || sc_soa_dot(a, b, dots, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to run cross / dot\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector* va = sc_create_vector(3, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* vb = sc_create_vector(3, %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < count; i++) {\n");
+    fprintf(file, "        double dot = 0.0;\n");
+    fprintf(file, "        for (uint32_t c = 0; c < 3; c++) {\n");
+    fprintf(file, "            sc_set_vector_element(va, c, to_sc_value(geometry_get_%s(a, c, i), %s));\n", test.data_type, test.sc_type);
+    fprintf(file, "            sc_set_vector_element(vb, c, to_sc_value(geometry_get_%s(b, c, i), %s));\n", test.data_type, test.sc_type);
+    fprintf(file, "            dot += geometry_get_%s(a, c, i) * geometry_get_%s(b, c, i);\n", test.data_type, test.data_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_vector* cross = sc_vector_cross(va, vb, arena);\n");
+    fprintf(file, "        for (uint32_t c = 0; c < 3; c++) {\n");
+    fprintf(file, "            if (fabs(sc_value_to_f64(sc_get_vector_element(cross, c)) - geometry_get_%s(out, c, i)) > tolerance * 10.0) {\n", test.data_type);
+    fprintf(file, "                CCB_WARNING(\"Cross mismatch at item %%u\", i);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        if (fabs(sc_value_to_f64(sc_get_vector_element(dots, i)) - dot) > tolerance * 10.0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Dot mismatch at item %%u\", i);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // normalise in place, a zero vector stays 0\n");
+    fprintf(file, "    for (uint32_t c = 0; c < 3; c++) {\n");
+    fprintf(file, "        if (%s == sc_float64) ((double*)b->data)[c * b->stride + 5] = 0.0; else ((float*)b->data)[c * b->stride + 5] = 0.0f;\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_soa_normalize(b, b, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to normalise\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < count; i++) {\n");
+    fprintf(file, "        double norm2 = 0.0;\n");
+    fprintf(file, "        for (uint32_t c = 0; c < 3; c++) {\n");
+    fprintf(file, "            norm2 += geometry_get_%s(b, c, i) * geometry_get_%s(b, c, i);\n", test.data_type, test.data_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        if ((i == 5) ? norm2 != 0.0 : fabs(norm2 - 1.0) > tolerance * 10.0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Normalised item %%u has a squared norm of %%f\", i, norm2);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // a unit quaternion and its rotation matrix (broadcast), also as a 4x4 affine transform with a translation\n");
+    fprintf(file, "    double qx = 0.1, qy = -0.5, qz = 0.3, qw = 0.8;\n");
+    fprintf(file, "    double qn = sqrt(qx * qx + qy * qy + qz * qz + qw * qw);\n");
+    fprintf(file, "    sc_soa* q = sc_create_soa(1, 4, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_soa* m3 = sc_create_soa(1, 9, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_soa* m4 = sc_create_soa(1, 16, %s, arena);\n", test.sc_type);
+    fprintf(file, "    double qv[4] = {qx, qy, qz, qw};\n");
+    fprintf(file, "    double r[9] = {1 - 2 * (qy * qy + qz * qz) / (qn * qn), 2 * (qx * qy - qz * qw) / (qn * qn), 2 * (qx * qz + qy * qw) / (qn * qn),\n");
+    fprintf(file, "                   2 * (qx * qy + qz * qw) / (qn * qn), 1 - 2 * (qx * qx + qz * qz) / (qn * qn), 2 * (qy * qz - qx * qw) / (qn * qn),\n");
+    fprintf(file, "                   2 * (qx * qz - qy * qw) / (qn * qn), 2 * (qy * qz + qx * qw) / (qn * qn), 1 - 2 * (qx * qx + qy * qy) / (qn * qn)};\n");
+    fprintf(file, "    double translation[3] = {1.0, -2.0, 0.5};\n");
+    fprintf(file, "    for (uint32_t c = 0; c < 16; c++) {\n");
+    fprintf(file, "        double value = (c %% 4 == 3) ? ((c < 12) ? translation[c / 4] : 1.0) : ((c < 12) ? r[(c / 4) * 3 + c %% 4] : 0.0);\n");
+    fprintf(file, "        if (%s == sc_float64) ((double*)m4->data)[c * m4->stride] = value; else ((float*)m4->data)[c * m4->stride] = (float)value;\n", test.sc_type);
+    fprintf(file, "        if (c < 9) {\n");
+    fprintf(file, "            if (%s == sc_float64) ((double*)m3->data)[c * m3->stride] = r[c]; else ((float*)m3->data)[c * m3->stride] = (float)r[c];\n", test.sc_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        if (c < 4) {\n");
+    fprintf(file, "            if (%s == sc_float64) ((double*)q->data)[c * q->stride] = qv[c]; else ((float*)q->data)[c * q->stride] = (float)qv[c];\n", test.sc_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_soa_normalize(q, q, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to normalise the quaternion\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_soa* rotated = sc_create_soa(count, 3, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_soa* affine = sc_create_soa(count, 3, %s, arena);\n", test.sc_type);
+    fprintf(file, "    if (sc_soa_rotate(q, a, rotated, arena) != 0 || sc_soa_transform(m3, a, out, arena) != 0 ||\n");
+    fprintf(file, "        sc_soa_transform(m4, a, affine, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to rotate / transform\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < count; i++) {\n");
+    fprintf(file, "        for (uint32_t c = 0; c < 3; c++) {\n");
+    fprintf(file, "            double expected = 0.0;\n");
+    fprintf(file, "            for (uint32_t p = 0; p < 3; p++) {\n");
+    fprintf(file, "                expected += r[c * 3 + p] * geometry_get_%s(a, p, i);\n", test.data_type);
+    fprintf(file, "            }\n");
+    fprintf(file, "            if (fabs(geometry_get_%s(out, c, i) - expected) > tolerance * 10.0 ||\n", test.data_type);
+    fprintf(file, "                fabs(geometry_get_%s(rotated, c, i) - expected) > tolerance * 10.0 ||\n", test.data_type);
+    fprintf(file, "                fabs(geometry_get_%s(affine, c, i) - expected - translation[c]) > tolerance * 10.0) {\n", test.data_type);
+    fprintf(file, "                CCB_WARNING(\"Rotation mismatch at item %%u component %%u\", i, c);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // per item quaternions: q_i applied in place gives the same as the broadcast rotation\n");
+    fprintf(file, "    sc_soa* qs = sc_create_soa(count, 4, %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < count; i++) {\n");
+    fprintf(file, "        for (uint32_t c = 0; c < 4; c++) {\n");
+    fprintf(file, "            if (%s == sc_float64) ((double*)qs->data)[c * qs->stride + i] = ((double*)q->data)[c * q->stride];\n", test.sc_type);
+    fprintf(file, "            else ((float*)qs->data)[c * qs->stride + i] = ((float*)q->data)[c * q->stride];\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_soa_rotate(qs, a, a, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to rotate in place\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < count; i++) {\n");
+    fprintf(file, "        for (uint32_t c = 0; c < 3; c++) {\n");
+    fprintf(file, "            if (geometry_get_%s(a, c, i) != geometry_get_%s(rotated, c, i)) {\n", test.data_type, test.data_type);
+    fprintf(file, "                CCB_WARNING(\"In place rotation differs at item %%u\", i);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_soa_cross(a, qs, out, arena) != -1) {\n");
+    fprintf(file, "        CCB_WARNING(\"Cross of a quaternion batch should fail\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_distance(FILE* file, test_data test) {
+    fprintf(file, "static double distance_reference_%s(sc_vector* q, uint64_t qi, sc_vector* c, uint64_t ci, uint64_t dim, sc_metric metric) {\n", test.data_type);
+    fprintf(file, "    double dot = 0.0, qn = 0.0, cn = 0.0;\n");
+    fprintf(file, "    for (uint64_t p = 0; p < dim; p++) {\n");
+    fprintf(file, "        double a = sc_value_to_f64(sc_get_vector_element(q, qi * dim + p));\n");
+    fprintf(file, "        double b = sc_value_to_f64(sc_get_vector_element(c, ci * dim + p));\n");
+    fprintf(file, "        dot += a * b;\n");
+    fprintf(file, "        qn += a * a;\n");
+    fprintf(file, "        cn += b * b;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    switch (metric) {\n");
+    fprintf(file, "        case sc_metric_inner_product: return dot;\n");
+    fprintf(file, "        case sc_metric_cosine: return (qn * cn > 0.0) ? 1.0 - dot / sqrt(qn * cn) : 1.0;\n");
+    fprintf(file, "        case sc_metric_euclidean: return sqrt(fmax(qn + cn - 2.0 * dot, 0.0));\n");
+    fprintf(file, "        default: return fmax(qn + cn - 2.0 * dot, 0.0);\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_distance_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // full matrices and fused top k against a brute force reference, over several query blocks and corpus tiles\n");
+    fprintf(file, "    uint64_t nq = 100;\n");
+    fprintf(file, "    uint64_t n = 600;\n");
+    fprintf(file, "    uint64_t dim = 20;\n");
+    fprintf(file, "    uint64_t k = 7;\n");
+    fprintf(file, "    uint64_t q_dims[] = {nq, dim};\n");
+    fprintf(file, "    uint64_t c_dims[] = {n, dim};\n");
+    fprintf(file, "    sc_tensor* queries = sc_create_tensor(sc_create_dimensions(2, arena, q_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* corpus = sc_create_tensor(sc_create_dimensions(2, arena, c_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector qv = {queries->data, queries->size, %s};\n", test.sc_type);
+    fprintf(file, "    sc_vector cv = {corpus->data, corpus->size, %s};\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < queries->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&qv, i, to_sc_value((double)((i * 31 + 7) %% 29) / 8.0 - 1.75, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < corpus->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&cv, i, to_sc_value((double)((i * 17 + 3) %% 37) / 10.0 - 1.8, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_point_set* q = sc_point_set_create(queries, arena);\n");
+    fprintf(file, "    sc_point_set* c = sc_point_set_create(corpus, arena);\n");
+    fprintf(file, "    if (%s != sc_float16 && %s != sc_float32 && %s != sc_float64) {\n", test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "        if (q != NULL) {\n");
+    fprintf(file, "            CCB_WARNING(\"Point sets should only accept floating point types\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        return 0;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (!q || !c) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to create the point sets\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double tolerance = (%s == sc_float64) ? 1e-9 : 1e-3;\n", test.sc_type);
+    fprintf(file, "\n");
+    fprintf(file, "    sc_metric metrics[] = {sc_metric_sqeuclidean, sc_metric_euclidean, sc_metric_cosine, sc_metric_inner_product};\n");
+    fprintf(file, "    uint64_t* indices = (uint64_t*)ccb_arena_malloc(arena, nq * k * sizeof(uint64_t));\n");
+    fprintf(file, "    double* expected = (double*)ccb_arena_malloc(arena, n * sizeof(double));\n");
+    fprintf(file, "    for (int m = 0; m < 4; m++) {\n");
+    fprintf(file, "        sc_tensor* matrix = sc_pairwise_distances(q, c, metrics[m], arena);\n");
+    fprintf(file, "        uint64_t t_dims[] = {nq, k};\n");
+    fprintf(file, "        sc_tensor* best = sc_create_tensor(sc_create_dimensions(2, arena, t_dims), matrix ? matrix->type : sc_float32, arena);\n");
+    fprintf(file, "        if (!matrix || sc_pairwise_topk(q, c, metrics[m], k, indices, best, arena) != 0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to compute distances for metric %%d\", m);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_vector mv = {matrix->data, matrix->size, matrix->type};\n");
+    fprintf(file, "        sc_vector bv = {best->data, best->size, best->type};\n");
+    fprintf(file, "        double sign = (metrics[m] == sc_metric_inner_product) ? -1.0 : 1.0;\n");
+    fprintf(file, "        for (uint64_t i = 0; i < nq; i++) {\n");
+    fprintf(file, "            for (uint64_t j = 0; j < n; j++) {\n");
+    fprintf(file, "                expected[j] = distance_reference_%s(&qv, i, &cv, j, dim, metrics[m]);\n", test.data_type);
+    fprintf(file, "                double got = sc_value_to_f64(sc_get_vector_element(&mv, i * n + j));\n");
+    fprintf(file, "                if (fabs(got - expected[j]) > tolerance * (1.0 + fabs(expected[j]))) {\n");
+    fprintf(file, "                    CCB_WARNING(\"Metric %%d [%%u, %%u]: expected %%f, got %%f\", m, i, j, expected[j], got);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            // the j-th reported value is the j-th best of the reference and matches its index\n");
+    fprintf(file, "            for (uint64_t j = 0; j < k; j++) {\n");
+    fprintf(file, "                uint64_t better = 0;\n");
+    fprintf(file, "                double value = sc_value_to_f64(sc_get_vector_element(&bv, i * k + j));\n");
+    fprintf(file, "                double own = expected[indices[i * k + j]];\n");
+    fprintf(file, "                for (uint64_t p = 0; p < n; p++) {\n");
+    fprintf(file, "                    better += (sign * expected[p] < sign * own - tolerance * (1.0 + fabs(own)));\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "                if (better > j || fabs(value - own) > tolerance * (1.0 + fabs(own)) ||\n");
+    fprintf(file, "                    (j > 0 && sign * value < sign * sc_value_to_f64(sc_get_vector_element(&bv, i * k + j - 1)))) {\n");
+    fprintf(file, "                    CCB_WARNING(\"Metric %%d query %%u: rank %%u is not the %%u-th best (%%u better)\", m, i, j, j, better);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_pairwise_topk(q, c, sc_metric_cosine, n + 1, indices, NULL, arena) != -1) {\n");
+    fprintf(file, "        CCB_WARNING(\"k larger than the corpus should fail\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_ann(FILE* file, test_data test) {
+    fprintf(file, "static double ann_recall_%s(uint64_t* got, uint64_t* expected, uint64_t nq, uint64_t k) {\n", test.data_type);
+    fprintf(file, "    uint64_t hits = 0;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < nq; i++) {\n");
+    fprintf(file, "        for (uint64_t a = 0; a < k; a++) {\n");
+    fprintf(file, "            for (uint64_t b = 0; b < k; b++) {\n");
+    fprintf(file, "                hits += (got[i * k + a] == expected[i * k + b]);\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return (double)hits / (double)(nq * k);\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_ann_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // IVF and HNSW against the brute force top k: exact with every list probed, high recall otherwise, same results after a save and load\n");
+    fprintf(file, "    uint64_t n = 2000;\n");
+    fprintf(file, "    uint64_t nq = 50;\n");
+    fprintf(file, "    uint64_t dim = 16;\n");
+    fprintf(file, "    uint64_t k = 10;\n");
+    fprintf(file, "    uint64_t p_dims[] = {n, dim};\n");
+    fprintf(file, "    uint64_t q_dims[] = {nq, dim};\n");
+    fprintf(file, "    sc_tensor* points = sc_create_tensor(sc_create_dimensions(2, arena, p_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* queries = sc_create_tensor(sc_create_dimensions(2, arena, q_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_rng rng = sc_rng_create(7);\n");
+    fprintf(file, "    sc_rng_uniform_tensor(&rng, points, -5.0, 5.0, arena);\n");
+    fprintf(file, "    sc_rng_uniform_tensor(&rng, queries, -5.0, 5.0, arena);\n");
+    fprintf(file, "    sc_ivf_index* ivf = sc_ivf_build(points, sc_metric_euclidean, 20, 42, arena);\n");
+    fprintf(file, "    sc_hnsw_index* hnsw = sc_hnsw_build(points, sc_metric_euclidean, 12, 64, 42, arena);\n");
+    fprintf(file, "    if (%s != sc_float16 && %s != sc_float32 && %s != sc_float64) {\n", test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "        if (ivf != NULL || hnsw != NULL) {\n");
+    fprintf(file, "            CCB_WARNING(\"ANN indexes should only accept floating point types\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        return 0;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (!ivf || !hnsw) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to build the indexes\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    uint64_t r_dims[] = {nq, k};\n");
+    fprintf(file, "    uint64_t* expected = (uint64_t*)ccb_arena_malloc(arena, nq * k * sizeof(uint64_t));\n");
+    fprintf(file, "    uint64_t* got = (uint64_t*)ccb_arena_malloc(arena, nq * k * sizeof(uint64_t));\n");
+    fprintf(file, "    uint64_t* reloaded = (uint64_t*)ccb_arena_malloc(arena, nq * k * sizeof(uint64_t));\n");
+    fprintf(file, "    sc_tensor* expected_distances = sc_create_tensor(sc_create_dimensions(2, arena, r_dims), (%s == sc_float64) ? sc_float64 : sc_float32, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* distances = sc_create_tensor(sc_create_dimensions(2, arena, r_dims), sc_float32, arena);\n");
+    fprintf(file, "    sc_vector ev = {expected_distances->data, expected_distances->size, expected_distances->type};\n");
+    fprintf(file, "    float* dv = (float*)distances->data;\n");
+    fprintf(file, "    if (sc_pairwise_topk(sc_point_set_create(queries, arena), sc_point_set_create(points, arena), sc_metric_euclidean, k, expected, expected_distances, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to compute the brute force top k\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    if (sc_ivf_search(ivf, queries, k, 20, got, distances, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to search the IVF index\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t i = 0; i < nq * k; i++) {\n");
+    fprintf(file, "        double want = sc_value_to_f64(sc_get_vector_element(&ev, i));\n");
+    fprintf(file, "        if (fabs(dv[i] - want) > 1e-3 * (1.0 + want)) {\n");
+    fprintf(file, "            CCB_WARNING(\"IVF probing every list [%%u]: expected distance %%f, got %%f\", i, want, dv[i]);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_ivf_search(ivf, queries, k, 8, got, NULL, arena) != 0 || ann_recall_%s(got, expected, nq, k) < 0.8) {\n", test.data_type);
+    fprintf(file, "        CCB_WARNING(\"IVF recall with 8 of 20 lists is %%f\", ann_recall_%s(got, expected, nq, k));\n", test.data_type);
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_hnsw_search(hnsw, queries, k, 64, got, distances, arena) != 0 || ann_recall_%s(got, expected, nq, k) < 0.9) {\n", test.data_type);
+    fprintf(file, "        CCB_WARNING(\"HNSW recall is %%f\", ann_recall_%s(got, expected, nq, k));\n", test.data_type);
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    const char* ivf_path = \"scandium_test_%s.ivf\";\n", test.data_type);
+    fprintf(file, "    const char* hnsw_path = \"scandium_test_%s.hnsw\";\n", test.data_type);
+    fprintf(file, "    sc_ivf_index* ivf_loaded = (sc_ivf_save(ivf, ivf_path) == 0) ? sc_ivf_load(ivf_path, arena) : NULL;\n");
+    fprintf(file, "    sc_hnsw_index* hnsw_loaded = (sc_hnsw_save(hnsw, hnsw_path) == 0) ? sc_hnsw_load(hnsw_path, arena) : NULL;\n");
+    fprintf(file, "    if (!ivf_loaded || !hnsw_loaded || sc_ivf_load(hnsw_path, arena) != NULL) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to save and load the indexes\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    int same = 1;\n");
+    fprintf(file, "    sc_ivf_search(ivf, queries, k, 5, got, NULL, arena);\n");
+    fprintf(file, "    sc_ivf_search(ivf_loaded, queries, k, 5, reloaded, NULL, arena);\n");
+    fprintf(file, "    same = same && memcmp(got, reloaded, nq * k * sizeof(uint64_t)) == 0;\n");
+    fprintf(file, "    sc_hnsw_search(hnsw, queries, k, 32, got, NULL, arena);\n");
+    fprintf(file, "    sc_hnsw_search(hnsw_loaded, queries, k, 32, reloaded, NULL, arena);\n");
+    fprintf(file, "    same = same && memcmp(got, reloaded, nq * k * sizeof(uint64_t)) == 0;\n");
+    fprintf(file, "    sc_ivf_close(ivf_loaded);\n");
+    fprintf(file, "    sc_hnsw_close(hnsw_loaded);\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // corrupted headers: a count that does not match the section sizes, then a section offset that wraps around\n");
+    fprintf(file, "    uint64_t offset = UINT64_MAX - 63;\n");
+    fprintf(file, "    int rejected = 1;\n");
+    fprintf(file, "    for (uint64_t c = 0; c < 2; c++) {\n");
+    fprintf(file, "        // count is after the magic and the 8 uint32 fields (restored on the second pass), the section offsets\n");
+    fprintf(file, "        // after count, dim and nlist\n");
+    fprintf(file, "        uint64_t count = n + 1 - c;\n");
+    fprintf(file, "        FILE* index_file = fopen(hnsw_path, \"r+b\");\n");
+    fprintf(file, "        int patched = index_file != NULL && fseek(index_file, 40, SEEK_SET) == 0 && fwrite(&count, sizeof(uint64_t), 1, index_file) == 1;\n");
+    fprintf(file, "        patched = patched && (c == 0 || (fseek(index_file, 64, SEEK_SET) == 0 && fwrite(&offset, sizeof(uint64_t), 1, index_file) == 1));\n");
+    fprintf(file, "        if (index_file != NULL) {\n");
+    fprintf(file, "            fclose(index_file);\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        rejected = rejected && patched && sc_hnsw_load(hnsw_path, arena) == NULL;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    remove(ivf_path);\n");
+    fprintf(file, "    remove(hnsw_path);\n");
+    fprintf(file, "    if (!same) {\n");
+    fprintf(file, "        CCB_WARNING(\"Loaded indexes should give the results of the built ones\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (!rejected) {\n");
+    fprintf(file, "        CCB_WARNING(\"Corrupted index headers should be rejected\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_kmeans(FILE* file, test_data test) {
+    fprintf(file, "int test_kmeans_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // well separated gaussian clusters: both seedings recover them, the fits are reproducible and the mini-batch updates get close to Lloyd\n");
+    fprintf(file, "    uint64_t n = 3000;\n");
+    fprintf(file, "    uint64_t dim = 8;\n");
+    fprintf(file, "    uint64_t k = 5;\n");
+    fprintf(file, "    uint64_t dims[] = {n, dim};\n");
+    fprintf(file, "    sc_tensor* points = sc_create_tensor(sc_create_dimensions(2, arena, dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector pv = {points->data, points->size, %s};\n", test.sc_type);
+    fprintf(file, "    sc_rng rng = sc_rng_create(3);\n");
+    fprintf(file, "    sc_rng_normal_tensor(&rng, points, 0.0, 1.0, arena);\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        for (uint64_t p = 0; p < dim; p++) {\n");
+    fprintf(file, "            double center = 20.0 * (double)(((i %% k) >> p) & 1);\n");
+    fprintf(file, "            double value = sc_value_to_f64(sc_get_vector_element(&pv, i * dim + p));\n");
+    fprintf(file, "            sc_set_vector_element(&pv, i * dim + p, to_sc_value(value + center, %s));\n", test.sc_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_kmeans_options options = sc_kmeans_default_options(k);\n");
+    fprintf(file, "    options.seed = 11;\n");
+    fprintf(file, "    uint64_t* labels = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));\n");
+    fprintf(file, "    uint64_t* assigned = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));\n");
+    fprintf(file, "    sc_kmeans_model* model = sc_kmeans_fit(points, &options, labels, arena);\n");
+    fprintf(file, "    if (%s != sc_float16 && %s != sc_float32 && %s != sc_float64) {\n", test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "        if (model != NULL) {\n");
+    fprintf(file, "            CCB_WARNING(\"k-means should only accept floating point types\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        return 0;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    for (int seeding = 0; seeding < 2; seeding++) {\n");
+    fprintf(file, "        options.seeding = seeding ? sc_kmeans_plus_plus : sc_kmeans_parallel;\n");
+    fprintf(file, "        model = sc_kmeans_fit(points, &options, labels, arena);\n");
+    fprintf(file, "        sc_kmeans_model* again = sc_kmeans_fit(points, &options, NULL, arena);\n");
+    fprintf(file, "        if (!model || !again) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to fit k-means with seeding %%d\", seeding);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        if (memcmp(model->means, again->means, k * dim * sizeof(double)) != 0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Fits with the same seed should give the same centroids\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        // every true cluster is one label and the inertia is the noise: n dim\n");
+    fprintf(file, "        uint64_t total = 0;\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            if (labels[i] != labels[i %% k]) {\n");
+    fprintf(file, "                CCB_WARNING(\"Seeding %%d: point %%u has label %%u, its cluster has %%u\", seeding, i, labels[i], labels[i %% k]);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t c = 0; c < k; c++) {\n");
+    fprintf(file, "            total += model->counts[c];\n");
+    fprintf(file, "            if (model->counts[c] != n / k) {\n");
+    fprintf(file, "                CCB_WARNING(\"Seeding %%d: centroid %%u has %%u points for %%u\", seeding, c, model->counts[c], n / k);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        double expected = (double)(n * dim);\n");
+    fprintf(file, "        if (total != n || fabs(model->inertia - expected) > 0.1 * expected) {\n");
+    fprintf(file, "            CCB_WARNING(\"Seeding %%d: inertia %%f for about %%f, %%u points counted\", seeding, model->inertia, expected, total);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        double inertia = 0.0;\n");
+    fprintf(file, "        if (sc_kmeans_assign(model, points, assigned, &inertia, arena) != 0 || memcmp(labels, assigned, n * sizeof(uint64_t)) != 0 ||\n");
+    fprintf(file, "            fabs(inertia - model->inertia) > 1e-6 * inertia) {\n");
+    fprintf(file, "            CCB_WARNING(\"Assignments should match the labels of the fit\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // mini-batches of 500 rows for 3 passes, seeded on the first batch\n");
+    fprintf(file, "    uint64_t batch_rows = 500;\n");
+    fprintf(file, "    uint64_t b_dims[] = {batch_rows, dim};\n");
+    fprintf(file, "    sc_tensor batch = {points->data, sc_create_dimensions(2, arena, b_dims), batch_rows * dim, %s};\n", test.sc_type);
+    fprintf(file, "    options.seeding = sc_kmeans_parallel;\n");
+    fprintf(file, "    sc_kmeans_model* streaming = sc_kmeans_seed(&batch, &options, arena);\n");
+    fprintf(file, "    if (!streaming) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to seed the mini-batch model\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t pass = 0; pass < 3; pass++) {\n");
+    fprintf(file, "        for (uint64_t start = 0; start < n; start += batch_rows) {\n");
+    fprintf(file, "            batch.data = (uint8_t*)points->data + start * dim * sc_type_size(%s);\n", test.sc_type);
+    fprintf(file, "            if (sc_kmeans_partial_fit(streaming, &batch, arena) != 0) {\n");
+    fprintf(file, "                CCB_WARNING(\"Failed to run a mini-batch update\");\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double inertia = 0.0;\n");
+    fprintf(file, "    if (sc_kmeans_assign(streaming, points, assigned, &inertia, arena) != 0 || inertia > 1.05 * model->inertia ||\n");
+    fprintf(file, "        streaming->iterations != 3 * n / batch_rows) {\n");
+    fprintf(file, "        CCB_WARNING(\"Mini-batch inertia %%f, Lloyd %%f\", inertia, model->inertia);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_selection(FILE* file, test_data test) {
+    fprintf(file, "static int selection_before_%s(double x, uint64_t i, double y, uint64_t j, int largest) {\n", test.data_type);
+    fprintf(file, "    // reference order: NaN last, ties by index\n");
+    fprintf(file, "    int better = (largest ? x > y : x < y) || (x == x && y != y);\n");
+    fprintf(file, "    int worse = (largest ? y > x : y < x) || (y == y && x != x);\n");
+    fprintf(file, "    return better || (!worse && i < j);\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static uint64_t selection_brute_best_%s(sc_vector* a, uint64_t start, uint64_t count, uint64_t stride, int largest, uint8_t* taken) {\n", test.data_type);
+    fprintf(file, "    uint64_t best = UINT64_MAX;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < count; i++) {\n");
+    fprintf(file, "        if (taken && taken[i]) {\n");
+    fprintf(file, "            continue;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        double x = sc_value_to_f64(sc_get_vector_element(a, start + i * stride));\n");
+    fprintf(file, "        if (best == UINT64_MAX || selection_before_%s(x, i, sc_value_to_f64(sc_get_vector_element(a, start + best * stride)), best, largest)) {\n", test.data_type);
+    fprintf(file, "            best = i;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return best;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static int selection_check_nth_%s(sc_vector* a, uint64_t start, uint64_t count, uint64_t stride, uint64_t n) {\n", test.data_type);
+    fprintf(file, "    double pivot = sc_value_to_f64(sc_get_vector_element(a, start + n * stride));\n");
+    fprintf(file, "    for (uint64_t i = 0; i < count; i++) {\n");
+    fprintf(file, "        double x = sc_value_to_f64(sc_get_vector_element(a, start + i * stride));\n");
+    fprintf(file, "        if ((i < n && selection_before_%s(pivot, 0, x, 0, 0) && !(pivot == x)) || (i > n && selection_before_%s(x, 0, pivot, 0, 0) && !(pivot == x))) {\n", test.data_type, test.data_type);
+    fprintf(file, "            CCB_WARNING(\"nth element: %%f at %%u is on the wrong side of %%f at %%u\", x, i, pivot, n);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_selection_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // argmin / argmax, top k and nth element against brute force scans, with ties and NaN for the float types\n");
+    fprintf(file, "    int is_float = %s == sc_float16 || %s == sc_float32 || %s == sc_float64 || %s == sc_half;\n", test.sc_type, test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "    uint64_t n = 140003;\n");
+    fprintf(file, "    sc_vector* a = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* sorted = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(a, i, to_sc_value((double)((i * 7919) %% 200) + (is_float ? 0.25 : 0.0), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (is_float) {\n");
+    fprintf(file, "        sc_set_vector_element(a, 3, to_sc_value(NAN, %s));\n", test.sc_type);
+    fprintf(file, "        sc_set_vector_element(a, 70000, to_sc_value(NAN, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (int largest = 0; largest < 2; largest++) {\n");
+    fprintf(file, "        uint64_t index = 0;\n");
+    fprintf(file, "        int status = largest ? sc_vector_argmax(a, &index, arena) : sc_vector_argmin(a, &index, arena);\n");
+    fprintf(file, "        uint64_t expected = selection_brute_best_%s(a, 0, n, 1, largest, NULL);\n", test.data_type);
+    fprintf(file, "        if (status != 0 || index != expected) {\n");
+    fprintf(file, "            CCB_WARNING(\"arg%%s: %%u for %%u\", largest ? \"max\" : \"min\", index, expected);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "\n");
+    fprintf(file, "        uint64_t k = 37;\n");
+    fprintf(file, "        uint64_t* indices = (uint64_t*)ccb_arena_malloc(arena, k * sizeof(uint64_t));\n");
+    fprintf(file, "        sc_vector* values = sc_create_vector(k, %s, arena);\n", test.sc_type);
+    fprintf(file, "        uint8_t* taken = (uint8_t*)ccb_arena_malloc(arena, n);\n");
+    fprintf(file, "        memset(taken, 0, n);\n");
+    fprintf(file, "        if (sc_vector_topk(a, k, largest, indices, values, arena) != 0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to run top k\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t j = 0; j < k; j++) {\n");
+    fprintf(file, "            expected = selection_brute_best_%s(a, 0, n, 1, largest, taken);\n", test.data_type);
+    fprintf(file, "            taken[expected] = 1;\n");
+    fprintf(file, "            double value = sc_value_to_f64(sc_get_vector_element(values, j));\n");
+    fprintf(file, "            double reference = sc_value_to_f64(sc_get_vector_element(a, expected));\n");
+    fprintf(file, "            if (indices[j] != expected || !(value == reference || (value != value && reference != reference))) {\n");
+    fprintf(file, "                CCB_WARNING(\"top k %%d: rank %%u is %%u (%%f) for %%u (%%f)\", largest, j, indices[j], value, expected, reference);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // every NaN: the first element\n");
+    fprintf(file, "    sc_vector* nans = sc_create_vector(20, %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < 20; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(nans, i, to_sc_value(is_float ? NAN : 1.0, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    uint64_t first = 1;\n");
+    fprintf(file, "    if (sc_vector_argmax(nans, &first, arena) != 0 || first != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"argmax of equal values should be 0, got %%u\", first);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    uint64_t positions[] = {0, 1, n / 3, n - 5, n - 1};\n");
+    fprintf(file, "    for (int p = 0; p < 5; p++) {\n");
+    fprintf(file, "        memcpy(sorted->data, a->data, n * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "        if (sc_vector_nth_element(sorted, positions[p]) != 0 || selection_check_nth_%s(sorted, 0, n, 1, positions[p]) != 0) {\n", test.data_type);
+    fprintf(file, "            CCB_WARNING(\"Failed nth element %%u\", positions[p]);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_vector_topk(a, 0, 1, positions, NULL, arena) == 0 || sc_vector_nth_element(a, n) == 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"k = 0 and n = size should be rejected\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    // along the middle and the last axis of a [6, 37, 301] tensor\n");
+    fprintf(file, "    uint64_t dims[] = {6, 37, 301};\n");
+    fprintf(file, "    sc_tensor* t = sc_create_tensor(sc_create_dimensions(3, arena, dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector tv = {t->data, t->size, %s};\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < t->size; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(&tv, i, to_sc_value((double)((i * 104729) %% 97), %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    uint64_t k = 4;\n");
+    fprintf(file, "    for (int axis = 1; axis < 3; axis++) {\n");
+    fprintf(file, "        uint64_t length = dims[axis];\n");
+    fprintf(file, "        uint64_t inner = (axis == 1) ? dims[2] : 1;\n");
+    fprintf(file, "        uint64_t outer = t->size / (length * inner);\n");
+    fprintf(file, "        uint64_t out_dims[] = {6, 37, 301};\n");
+    fprintf(file, "        out_dims[axis] = k;\n");
+    fprintf(file, "        sc_tensor* values = sc_create_tensor(sc_create_dimensions(3, arena, out_dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "        sc_vector vv = {values->data, values->size, %s};\n", test.sc_type);
+    fprintf(file, "        uint64_t* indices = (uint64_t*)ccb_arena_malloc(arena, outer * k * inner * sizeof(uint64_t));\n");
+    fprintf(file, "        uint64_t* best = (uint64_t*)ccb_arena_malloc(arena, outer * inner * sizeof(uint64_t));\n");
+    fprintf(file, "        uint8_t* taken = (uint8_t*)ccb_arena_malloc(arena, length);\n");
+    fprintf(file, "        if (sc_tensor_argmin(t, axis - 3, best, arena) != 0 || sc_tensor_topk(t, axis, k, 1, indices, values, arena) != 0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed to select along axis %%d\", axis);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t o = 0; o < outer; o++) {\n");
+    fprintf(file, "            for (uint64_t i = 0; i < inner; i++) {\n");
+    fprintf(file, "                uint64_t start = o * length * inner + i;\n");
+    fprintf(file, "                if (best[o * inner + i] != selection_brute_best_%s(&tv, start, length, inner, 0, NULL)) {\n", test.data_type);
+    fprintf(file, "                    CCB_WARNING(\"Axis %%d: wrong argmin of line (%%u, %%u)\", axis, o, i);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "                memset(taken, 0, length);\n");
+    fprintf(file, "                for (uint64_t j = 0; j < k; j++) {\n");
+    fprintf(file, "                    uint64_t expected = selection_brute_best_%s(&tv, start, length, inner, 1, taken);\n", test.data_type);
+    fprintf(file, "                    taken[expected] = 1;\n");
+    fprintf(file, "                    uint64_t out = (o * k + j) * inner + i;\n");
+    fprintf(file, "                    double value = sc_value_to_f64(sc_get_vector_element(&vv, out));\n");
+    fprintf(file, "                    if (indices[out] != expected || value != sc_value_to_f64(sc_get_vector_element(&tv, start + expected * inner))) {\n");
+    fprintf(file, "                        CCB_WARNING(\"Axis %%d: rank %%u of line (%%u, %%u) is %%u for %%u\", axis, j, o, i, indices[out], expected);\n");
+    fprintf(file, "                        return -1;\n");
+    fprintf(file, "                    }\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        if (sc_tensor_nth_element(t, axis, length / 2, arena) != 0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Failed nth element along axis %%d\", axis);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (uint64_t line = 0; line < outer * inner; line++) {\n");
+    fprintf(file, "            uint64_t start = (line / inner) * length * inner + line %% inner;\n");
+    fprintf(file, "            if (selection_check_nth_%s(&tv, start, length, inner, length / 2) != 0) {\n", test.data_type);
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_tensor_argmax(t, 3, positions, arena) == 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Axis 3 should be rejected\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_sort(FILE* file, test_data test) {
+    fprintf(file, "static int sort_order_%s(double x, double y, int descending) {\n", test.data_type);
+    fprintf(file, "    // reference order: NaN last in both orders, -0 before +0\n");
+    fprintf(file, "    if (x != x || y != y) {\n");
+    fprintf(file, "        return (x != x) - (y != y);\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    int c = (x < y) ? -1 : (x > y) ? 1 : (x == 0.0) ? (signbit(x) ? 0 : 1) - (signbit(y) ? 0 : 1) : 0;\n");
+    fprintf(file, "    return descending ? -c : c;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static int sort_same_%s(double x, double y) {\n", test.data_type);
+    fprintf(file, "    return (x != x) ? (y != y) : (x == y && signbit(x) == signbit(y));\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_sort_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // argsort is a stable sorting permutation, sort and sort by key agree with it, for both orders\n");
+    fprintf(file, "    int is_float = %s == sc_float16 || %s == sc_float32 || %s == sc_float64 || %s == sc_half;\n", test.sc_type, test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "    uint64_t sizes[] = {0, 1, 9, 70001, 140003};\n");
+    fprintf(file, "    for (int s = 0; s < 5; s++) {\n");
+    fprintf(file, "        uint64_t n = sizes[s];\n");
+    fprintf(file, "        sc_vector* a = sc_create_vector(n ? n : 1, %s, arena);\n", test.sc_type);
+    fprintf(file, "        a->size = n;\n");
+    fprintf(file, "        for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "            double value = (%s == sc_uint8) ? (double)((i * 7919) %% 256) : (double)((int64_t)((i * 7919) %% 2001) - 1000);\n", test.sc_type);
+    fprintf(file, "            value = is_float ? value * 0.5 : value;\n");
+    fprintf(file, "            sc_set_vector_element(a, i, to_sc_value(value, %s));\n", test.sc_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        if (is_float && n > 8) {\n");
+    fprintf(file, "            sc_set_vector_element(a, 1, to_sc_value(NAN, %s));\n", test.sc_type);
+    fprintf(file, "            sc_set_vector_element(a, 2, to_sc_value(-INFINITY, %s));\n", test.sc_type);
+    fprintf(file, "            sc_set_vector_element(a, 3, to_sc_value(INFINITY, %s));\n", test.sc_type);
+    fprintf(file, "            sc_set_vector_element(a, 4, to_sc_value(-0.0, %s));\n", test.sc_type);
+    fprintf(file, "            sc_set_vector_element(a, 5, to_sc_value(-NAN, %s));\n", test.sc_type);
+    fprintf(file, "            sc_set_vector_element(a, n - 1, to_sc_value(0.0, %s));\n", test.sc_type);
+    fprintf(file, "        }\n");
+    fprintf(file, "        for (int descending = 0; descending < 2; descending++) {\n");
+    fprintf(file, "            uint64_t* indices = (uint64_t*)ccb_arena_malloc(arena, (n + 1) * sizeof(uint64_t));\n");
+    fprintf(file, "            uint8_t* seen = (uint8_t*)ccb_arena_malloc(arena, n + 1);\n");
+    fprintf(file, "            memset(seen, 0, n + 1);\n");
+    fprintf(file, "            if (sc_vector_argsort(a, descending, indices, arena) != 0) {\n");
+    fprintf(file, "                CCB_WARNING(\"Failed to argsort %%u elements\", n);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            for (uint64_t j = 0; j < n; j++) {\n");
+    fprintf(file, "                if (indices[j] >= n || seen[indices[j]]) {\n");
+    fprintf(file, "                    CCB_WARNING(\"argsort of %%u elements is not a permutation at %%u\", n, j);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "                seen[indices[j]] = 1;\n");
+    fprintf(file, "                if (j == 0) {\n");
+    fprintf(file, "                    continue;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "                double x = sc_value_to_f64(sc_get_vector_element(a, indices[j - 1]));\n");
+    fprintf(file, "                double y = sc_value_to_f64(sc_get_vector_element(a, indices[j]));\n");
+    fprintf(file, "                int c = sort_order_%s(x, y, descending);\n", test.data_type);
+    fprintf(file, "                if (c > 0 || (c == 0 && indices[j - 1] > indices[j] && sort_same_%s(x, y))) {\n", test.data_type);
+    fprintf(file, "                    CCB_WARNING(\"argsort %%d: %%f at %%u before %%f at %%u\", descending, x, indices[j - 1], y, indices[j]);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "\n");
+    fprintf(file, "            // sort by key with the positions as values, then an in place sort\n");
+    fprintf(file, "            sc_vector* keys = sc_create_vector(n ? n : 1, %s, arena);\n", test.sc_type);
+    fprintf(file, "            sc_vector* values = sc_create_vector(n ? n : 1, sc_int64, arena);\n");
+    fprintf(file, "            keys->size = n;\n");
+    fprintf(file, "            values->size = n;\n");
+    fprintf(file, "            memcpy(keys->data, a->data, n * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "            for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "                ((int64_t*)values->data)[i] = (int64_t)i;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            if (sc_vector_sort_by_key(keys, values, descending, arena) != 0) {\n");
+    fprintf(file, "                CCB_WARNING(\"Failed to sort by key %%u elements\", n);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            sc_vector* sorted = sc_create_vector(n ? n : 1, %s, arena);\n", test.sc_type);
+    fprintf(file, "            sorted->size = n;\n");
+    fprintf(file, "            memcpy(sorted->data, a->data, n * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "            if (sc_vector_sort(sorted, descending, arena) != 0) {\n");
+    fprintf(file, "                CCB_WARNING(\"Failed to sort %%u elements\", n);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            for (uint64_t j = 0; j < n; j++) {\n");
+    fprintf(file, "                double expected = sc_value_to_f64(sc_get_vector_element(a, indices[j]));\n");
+    fprintf(file, "                double by_key = sc_value_to_f64(sc_get_vector_element(keys, j));\n");
+    fprintf(file, "                double value = sc_value_to_f64(sc_get_vector_element(sorted, j));\n");
+    fprintf(file, "                if (((int64_t*)values->data)[j] != (int64_t)indices[j] || !sort_same_%s(by_key, expected) || !sort_same_%s(value, expected)) {\n", test.data_type, test.data_type);
+    fprintf(file, "                    CCB_WARNING(\"sort %%d of %%\" PRIu64 \" elements: rank %%\" PRIu64 \" is %%f / %%f (value %%\" PRId64 \") for %%f\", descending, n, j, value, by_key,\n");
+    fprintf(file, "                                ((int64_t*)values->data)[j], expected);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_scan(FILE* file, test_data test) {
+    fprintf(file, "static double scan_combine_%s(double a, double b, sc_scan_op op) {\n", test.data_type);
+    fprintf(file, "    // reference arithmetic of the type: wrapping int32 / int64, saturating uint8, NaN propagating max / min\n");
+    fprintf(file, "    double r;\n");
+    fprintf(file, "    if (op == sc_scan_max || op == sc_scan_min) {\n");
+    fprintf(file, "        return ((op == sc_scan_max ? b > a : b < a) || b != b) ? b : a;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (%s == sc_int32) {\n", test.sc_type);
+    fprintf(file, "        uint32_t x = (uint32_t)(int32_t)a;\n");
+    fprintf(file, "        uint32_t y = (uint32_t)(int32_t)b;\n");
+    fprintf(file, "        return (double)(int32_t)(op == sc_scan_sum ? x + y : x * y);\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (%s == sc_int64) {\n", test.sc_type);
+    fprintf(file, "        uint64_t x = (uint64_t)(int64_t)a;\n");
+    fprintf(file, "        uint64_t y = (uint64_t)(int64_t)b;\n");
+    fprintf(file, "        return (double)(int64_t)(op == sc_scan_sum ? x + y : x * y);\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    r = (op == sc_scan_sum) ? a + b : a * b;\n");
+    fprintf(file, "    return (%s == sc_uint8 && r > 255.0) ? 255.0 : r;\n", test.sc_type);
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static int scan_check_%s(sc_vector* in, sc_vector* out, uint64_t start, uint64_t count, uint64_t stride, sc_scan_op op, int exclusive) {\n", test.data_type);
+    fprintf(file, "    double identity = (op == sc_scan_sum) ? 0.0 : (op == sc_scan_prod) ? 1.0 : (op == sc_scan_max) ? -INFINITY : INFINITY;\n");
+    fprintf(file, "    if (%s == sc_int32 || %s == sc_int64 || %s == sc_uint8) {\n", test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "        double low = (%s == sc_int32) ? (double)INT32_MIN : (%s == sc_int64) ? (double)INT64_MIN : 0.0;\n", test.sc_type, test.sc_type);
+    fprintf(file, "        double high = (%s == sc_int32) ? (double)INT32_MAX : (%s == sc_int64) ? (double)INT64_MAX : 255.0;\n", test.sc_type, test.sc_type);
+    fprintf(file, "        identity = (op == sc_scan_max) ? low : (op == sc_scan_min) ? high : identity;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double running = identity;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < count; i++) {\n");
+    fprintf(file, "        double next = scan_combine_%s(running, sc_value_to_f64(sc_get_vector_element(in, start + i * stride)), op);\n", test.data_type);
+    fprintf(file, "        double expected = sc_value_to_f64(to_sc_value(exclusive ? running : next, %s));\n", test.sc_type);
+    fprintf(file, "        double got = sc_value_to_f64(sc_get_vector_element(out, start + i * stride));\n");
+    fprintf(file, "        if (!(got == expected || (got != got && expected != expected))) {\n");
+    fprintf(file, "            CCB_WARNING(\"scan op %%d exclusive %%d: %%f at %%u for %%f\", (int)op, exclusive, got, i, expected);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        running = next;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static void scan_fill_%s(sc_vector* v, sc_scan_op op, int with_nan) {\n", test.data_type);
+    fprintf(file, "    // exact in every type: sums of -2..2 (0..4 for uint8), products of 2, 1, -1 (and 0.5 for the floats)\n");
+    fprintf(file, "    int is_float = %s == sc_float16 || %s == sc_float32 || %s == sc_float64 || %s == sc_half;\n", test.sc_type, test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "    double factors[] = {2.0, is_float ? 0.5 : 1.0, (%s == sc_uint8) ? 1.0 : -1.0, 1.0};\n", test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < v->size; i++) {\n");
+    fprintf(file, "        double value = (double)((i * 7919) %% 5) - ((%s == sc_uint8) ? 0.0 : 2.0);\n", test.sc_type);
+    fprintf(file, "        if (op == sc_scan_prod) {\n");
+    fprintf(file, "            value = factors[i %% 4];\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sc_set_vector_element(v, i, to_sc_value(value, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (with_nan && is_float) {\n");
+    fprintf(file, "        sc_set_vector_element(v, v->size / 2 + 3, to_sc_value(NAN, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_scan_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // vector scans over several chunks (in place or not) and scans along every axis against serial references\n");
+    fprintf(file, "    uint64_t n = 200003;\n");
+    fprintf(file, "    sc_vector* a = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* out = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* copy = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    for (int op = sc_scan_sum; op <= sc_scan_min; op++) {\n");
+    fprintf(file, "        for (int exclusive = 0; exclusive < 2; exclusive++) {\n");
+    fprintf(file, "            scan_fill_%s(a, (sc_scan_op)op, op >= sc_scan_max);\n", test.data_type);
+    fprintf(file, "            memcpy(copy->data, a->data, n * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "            if (sc_vector_scan(a, out, (sc_scan_op)op, exclusive, arena) != 0 || scan_check_%s(a, out, 0, n, 1, (sc_scan_op)op, exclusive) != 0) {\n", test.data_type);
+    fprintf(file, "                CCB_WARNING(\"Vector scan %%d %%d failed\", op, exclusive);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            if (sc_vector_scan(copy, copy, (sc_scan_op)op, exclusive, arena) != 0 || memcmp(copy->data, out->data, n * sc_type_size(%s)) != 0) {\n", test.sc_type);
+    fprintf(file, "                CCB_WARNING(\"In place scan %%d %%d differs\", op, exclusive);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_vector_cumsum(a, out, arena) != 0 || sc_vector_scan(a, copy, (sc_scan_op)7, 0, arena) == 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"cumsum should succeed and an unknown operation fail\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    uint64_t dims[] = {4, 300, 257};\n");
+    fprintf(file, "    sc_tensor* t = sc_create_tensor(sc_create_dimensions(3, arena, dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_tensor* t_out = sc_create_tensor(sc_create_dimensions(3, arena, dims), %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector tv = {t->data, t->size, %s};\n", test.sc_type);
+    fprintf(file, "    sc_vector tov = {t_out->data, t_out->size, %s};\n", test.sc_type);
+    fprintf(file, "    for (int op = sc_scan_sum; op <= sc_scan_min; op++) {\n");
+    fprintf(file, "        scan_fill_%s(&tv, (sc_scan_op)op, op >= sc_scan_max);\n", test.data_type);
+    fprintf(file, "        for (int64_t axis = -1; axis < 3; axis++) {\n");
+    fprintf(file, "            int64_t resolved = (axis < 0) ? axis + 3 : axis;\n");
+    fprintf(file, "            uint64_t length = dims[resolved];\n");
+    fprintf(file, "            uint64_t inner = 1;\n");
+    fprintf(file, "            for (int64_t d = resolved + 1; d < 3; d++) {\n");
+    fprintf(file, "                inner *= dims[d];\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            uint64_t outer = t->size / (length * inner);\n");
+    fprintf(file, "            int exclusive = (axis == 1);\n");
+    fprintf(file, "            if (sc_tensor_scan(t, t_out, axis, (sc_scan_op)op, exclusive, arena) != 0) {\n");
+    fprintf(file, "                CCB_WARNING(\"Failed to scan along axis %%\" PRId64, axis);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            for (uint64_t line = 0; line < outer * inner; line++) {\n");
+    fprintf(file, "                uint64_t start = (line / inner) * length * inner + line %% inner;\n");
+    fprintf(file, "                if (scan_check_%s(&tv, &tov, start, length, inner, (sc_scan_op)op, exclusive) != 0) {\n", test.data_type);
+    fprintf(file, "                    CCB_WARNING(\"Axis %%\" PRId64 \" op %%d: line %%\" PRIu64 \" differs\", axis, op, line);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (sc_tensor_scan(t, t_out, 3, sc_scan_sum, 0, arena) == 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Axis 3 should be rejected\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_segment(FILE* file, test_data test) {
+    fprintf(file, "static void segment_fill_%s(sc_vector* v) {\n", test.data_type);
+    fprintf(file, "    // small integers keep every sum exact, a NaN lands in one segment for the float types\n");
+    fprintf(file, "    int is_float = !(%s == sc_int32 || %s == sc_int64 || %s == sc_uint8);\n", test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "    for (uint64_t i = 0; i < v->size; i++) {\n");
+    fprintf(file, "        double value = (double)((i * 7919) %% 9) - ((%s == sc_uint8) ? 0.0 : 4.0);\n", test.sc_type);
+    fprintf(file, "        sc_set_vector_element(v, i, to_sc_value(value, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    if (is_float) {\n");
+    fprintf(file, "        sc_set_vector_element(v, 1234, to_sc_value(NAN, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static int segment_same_%s(double got, double expected) {\n", test.data_type);
+    fprintf(file, "    return got == expected || (got != got && expected != expected);\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static int segment_check_%s(sc_vector* values, const int64_t* rows, uint64_t n, int64_t group, sc_segment_outputs* out) {\n", test.data_type);
+    fprintf(file, "    // brute force statistics of the rows of group (rows[i] == group) against the outputs at group\n");
+    fprintf(file, "    int is_float = !(%s == sc_int32 || %s == sc_int64 || %s == sc_uint8);\n", test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "    double sum = 0.0;\n");
+    fprintf(file, "    double low = INFINITY;\n");
+    fprintf(file, "    double high = -INFINITY;\n");
+    fprintf(file, "    uint64_t count = 0;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        if (rows[i] != group) {\n");
+    fprintf(file, "            continue;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        double x = sc_value_to_f64(sc_get_vector_element(values, i));\n");
+    fprintf(file, "        sum += x;\n");
+    fprintf(file, "        low = (x < low || x != x) ? x : low;\n");
+    fprintf(file, "        high = (x > high || x != x) ? x : high;\n");
+    fprintf(file, "        count++;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double empty = is_float ? NAN : 0.0;\n");
+    fprintf(file, "    double mean = count ? sum / (double)count : NAN;\n");
+    fprintf(file, "    low = count ? sc_value_to_f64(to_sc_value(low, %s)) : empty;\n", test.sc_type);
+    fprintf(file, "    high = count ? sc_value_to_f64(to_sc_value(high, %s)) : empty;\n", test.sc_type);
+    fprintf(file, "    uint64_t g = (uint64_t)group;\n");
+    fprintf(file, "    if (!segment_same_%s(sc_value_to_f64(sc_get_vector_element(out->sum, g)), sum)\n", test.data_type);
+    fprintf(file, "        || !segment_same_%s(sc_value_to_f64(sc_get_vector_element(out->mean, g)), mean)\n", test.data_type);
+    fprintf(file, "        || sc_value_to_f64(sc_get_vector_element(out->count, g)) != (double)count\n");
+    fprintf(file, "        || !segment_same_%s(sc_value_to_f64(sc_get_vector_element(out->min, g)), low)\n", test.data_type);
+    fprintf(file, "        || !segment_same_%s(sc_value_to_f64(sc_get_vector_element(out->max, g)), high)) {\n", test.data_type);
+    fprintf(file, "        CCB_WARNING(\"group %%\" PRId64 \" (%%\" PRIu64 \" rows): sum %%f mean %%f min %%f max %%f\", group, count, sum, mean, low, high);\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_segment_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // sorted segments (empty ones, a segment over several chunks) and unsorted keys against brute force statistics\n");
+    fprintf(file, "    uint64_t n = 300007;\n");
+    fprintf(file, "    sc_vector* values = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    segment_fill_%s(values);\n", test.data_type);
+    fprintf(file, "    int64_t* rows = (int64_t*)ccb_arena_malloc(arena, n * sizeof(int64_t));\n");
+    fprintf(file, "\n");
+    fprintf(file, "    uint64_t segments = 0;\n");
+    fprintf(file, "    int64_t bounds[4096];\n");
+    fprintf(file, "    bounds[0] = 5;\n");
+    fprintf(file, "    while ((uint64_t)bounds[segments] < n - 20000) {\n");
+    fprintf(file, "        int64_t length = (segments %% 13 == 0) ? 0 : (segments == 10) ? 150000 : (int64_t)((segments * 31) %% 97);\n");
+    fprintf(file, "        bounds[segments + 1] = bounds[segments] + length;\n");
+    fprintf(file, "        segments++;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_vector* offsets = sc_create_vector(segments + 1, sc_int32, arena);\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        rows[i] = -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t s = 0; s <= segments; s++) {\n");
+    fprintf(file, "        sc_set_vector_element(offsets, s, to_sc_value((double)bounds[s], sc_int32));\n");
+    fprintf(file, "        for (int64_t i = bounds[s]; s < segments && i < bounds[s + 1]; i++) {\n");
+    fprintf(file, "            rows[i] = (int64_t)s;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_segment_outputs out = {sc_create_vector(segments, sc_float64, arena), sc_create_vector(segments, sc_float64, arena),\n");
+    fprintf(file, "                              sc_create_vector(segments, sc_int64, arena), sc_create_vector(segments, %s, arena),\n", test.sc_type);
+    fprintf(file, "                              sc_create_vector(segments, %s, arena)};\n", test.sc_type);
+    fprintf(file, "    if (sc_segment_reduce(values, offsets, &out, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to reduce segments\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t s = 0; s < segments; s++) {\n");
+    fprintf(file, "        if (segment_check_%s(values, rows, n, (int64_t)s, &out) != 0) {\n", test.data_type);
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    uint64_t groups = 37;\n");
+    fprintf(file, "    sc_vector* keys = sc_create_vector(n, sc_int32, arena);\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        rows[i] = (i %% 11 == 3) ? -1 : (int64_t)((i * 7919) %% groups);\n");
+    fprintf(file, "        sc_set_vector_element(keys, i, to_sc_value((double)rows[i], sc_int32));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_segment_outputs grouped = {sc_create_vector(groups, sc_float64, arena), sc_create_vector(groups, sc_float64, arena),\n");
+    fprintf(file, "                                  sc_create_vector(groups, sc_int64, arena), sc_create_vector(groups, %s, arena),\n", test.sc_type);
+    fprintf(file, "                                  sc_create_vector(groups, %s, arena)};\n", test.sc_type);
+    fprintf(file, "    if (sc_group_reduce(values, keys, groups, &grouped, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to reduce groups\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (uint64_t g = 0; g < groups; g++) {\n");
+    fprintf(file, "        if (segment_check_%s(values, rows, n, (int64_t)g, &grouped) != 0) {\n", test.data_type);
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_vector* few = sc_create_vector(n, sc_uint8, arena);\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        rows[i] = (int64_t)(i %% 5 == 0 ? 4 : i %% 3);\n");
+    fprintf(file, "        sc_set_vector_element(few, i, to_sc_value((double)rows[i], sc_uint8));\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_segment_outputs partial = {sc_create_vector(5, sc_float64, arena), sc_create_vector(5, sc_float64, arena),\n");
+    fprintf(file, "                                  sc_create_vector(5, sc_int64, arena), sc_create_vector(5, %s, arena),\n", test.sc_type);
+    fprintf(file, "                                  sc_create_vector(5, %s, arena)};\n", test.sc_type);
+    fprintf(file, "    if (sc_group_reduce(values, few, 5, &partial, arena) != 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Failed to reduce uint8 keys\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    for (int64_t g = 0; g < 5; g++) {\n");
+    fprintf(file, "        if (segment_check_%s(values, rows, n, g, &partial) != 0) {\n", test.data_type);
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    sc_set_vector_element(keys, n - 1, to_sc_value((double)groups, sc_int32));\n");
+    fprintf(file, "    sc_set_vector_element(offsets, 1, to_sc_value(1.0, sc_int32));\n");
+    fprintf(file, "    sc_segment_outputs none = {NULL, NULL, NULL, NULL, NULL};\n");
+    fprintf(file, "    if (sc_group_reduce(values, keys, groups, &grouped, arena) == 0 || sc_segment_reduce(values, offsets, &out, arena) == 0\n");
+    fprintf(file, "        || sc_group_reduce(values, few, 4, &partial, arena) == 0 || sc_group_reduce(values, few, 5, &none, arena) == 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Out of range keys, decreasing offsets, wrong output sizes and no outputs should be rejected\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
+void gen_test_rolling(FILE* file, test_data test) {
+    fprintf(file, "static double rolling_reference_%s(sc_vector* a, uint64_t i, uint64_t window, sc_rolling_stat stat) {\n", test.data_type);
+    fprintf(file, "    // brute force statistic of the window ending at i\n");
+    fprintf(file, "    uint64_t first = (i + 1 > window) ? i + 1 - window : 0;\n");
+    fprintf(file, "    double sum = 0.0;\n");
+    fprintf(file, "    double squares = 0.0;\n");
+    fprintf(file, "    double low = INFINITY;\n");
+    fprintf(file, "    double high = -INFINITY;\n");
+    fprintf(file, "    for (uint64_t j = first; j <= i; j++) {\n");
+    fprintf(file, "        double x = sc_value_to_f64(sc_get_vector_element(a, j));\n");
+    fprintf(file, "        if (x != x) {\n");
+    fprintf(file, "            return NAN;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        sum += x;\n");
+    fprintf(file, "        squares += x * x;\n");
+    fprintf(file, "        low = (x < low) ? x : low;\n");
+    fprintf(file, "        high = (x > high) ? x : high;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double count = (double)(i + 1 - first);\n");
+    fprintf(file, "    double mean = sum / count;\n");
+    fprintf(file, "    double variance = squares / count - mean * mean;\n");
+    fprintf(file, "    double values[] = {sum, mean, (variance > 0.0) ? sqrt(variance) : 0.0, low, high};\n");
+    fprintf(file, "    return values[stat];\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "static int rolling_close_%s(double got, double expected, double tolerance) {\n", test.data_type);
+    fprintf(file, "    return (got != got && expected != expected) || fabs(got - expected) <= tolerance;\n");
+    fprintf(file, "}\n");
+    fprintf(file, "\n");
+    fprintf(file, "int test_rolling_%s(ccb_arena* arena) {\n", test.data_type);
+    fprintf(file, "    // windows of every size (one value, inside a task range, over several ranges, the whole series) with a NaN,\n");
+    fprintf(file, "    // sampled against brute force windows, then the ewma against the serial recurrence\n");
+    fprintf(file, "    uint64_t n = 200003;\n");
+    fprintf(file, "    sc_vector* a = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* out = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    sc_vector* copy = sc_create_vector(n, %s, arena);\n", test.sc_type);
+    fprintf(file, "    if (%s == sc_int32 || %s == sc_int64 || %s == sc_uint8) {\n", test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "        if (sc_vector_rolling_mean(a, out, 8, arena) == 0 || sc_vector_ewma(a, out, 0.5, arena) == 0) {\n");
+    fprintf(file, "            CCB_WARNING(\"Integer vectors should be rejected\");\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "        return 0;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    // quarters in [-4, 4] are exact in every float type\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        sc_set_vector_element(a, i, to_sc_value((double)((i * 7919) %% 33) * 0.25 - 4.0, %s));\n", test.sc_type);
+    fprintf(file, "    }\n");
+    fprintf(file, "    sc_set_vector_element(a, 150001, to_sc_value(NAN, %s));\n", test.sc_type);
+    fprintf(file, "    double eps = (%s == sc_float16) ? 1.0 / 128.0 : (%s == sc_half) ? 1.0 / 1024.0 : (%s == sc_float32) ? 1e-6 : 1e-12;\n", test.sc_type, test.sc_type, test.sc_type);
+    fprintf(file, "    uint64_t windows[] = {1, 7, 100, 70001, n + 5};\n");
+    fprintf(file, "    for (int w = 0; w < 5; w++) {\n");
+    fprintf(file, "        for (int stat = sc_rolling_sum; stat <= sc_rolling_max; stat++) {\n");
+    fprintf(file, "            if (sc_vector_rolling(a, out, windows[w], (sc_rolling_stat)stat, arena) != 0) {\n");
+    fprintf(file, "                CCB_WARNING(\"Rolling statistic %%d of window %%\" PRIu64 \" failed\", stat, windows[w]);\n");
+    fprintf(file, "                return -1;\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "            uint64_t step = (windows[w] > 100) ? 4999 : 1;\n");
+    fprintf(file, "            for (uint64_t i = 0; i < n; i += (i < 300 || (i > 149900 && i < 150200)) ? 1 : step) {\n");
+    fprintf(file, "                double expected = rolling_reference_%s(a, i, windows[w], (sc_rolling_stat)stat);\n", test.data_type);
+    fprintf(file, "                double got = sc_value_to_f64(sc_get_vector_element(out, i));\n");
+    fprintf(file, "                double scale = (stat == sc_rolling_sum) ? 4.0 * (double)((i + 1 < windows[w]) ? i + 1 : windows[w]) : 4.0;\n");
+    fprintf(file, "                if (!rolling_close_%s(got, expected, 2.0 * eps * scale)) {\n", test.data_type);
+    fprintf(file, "                    CCB_WARNING(\"Window %%\" PRIu64 \" stat %%d: %%f at %%\" PRIu64 \" for %%f\", windows[w], stat, got, i, expected);\n");
+    fprintf(file, "                    return -1;\n");
+    fprintf(file, "                }\n");
+    fprintf(file, "            }\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    double alpha = 0.125;\n");
+    fprintf(file, "    sc_set_vector_element(a, 0, to_sc_value(NAN, %s));\n", test.sc_type);
+    fprintf(file, "    memcpy(copy->data, a->data, n * sc_type_size(%s));\n", test.sc_type);
+    fprintf(file, "    if (sc_vector_ewma(a, out, alpha, arena) != 0 || sc_vector_ewma(copy, copy, alpha, arena) != 0\n");
+    fprintf(file, "        || memcmp(copy->data, out->data, n * sc_type_size(%s)) != 0) {\n", test.sc_type);
+    fprintf(file, "        CCB_WARNING(\"ewma failed or differs in place\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    double average = NAN;\n");
+    fprintf(file, "    for (uint64_t i = 0; i < n; i++) {\n");
+    fprintf(file, "        double x = sc_value_to_f64(sc_get_vector_element(a, i));\n");
+    fprintf(file, "        average = (x != x) ? average : (average != average) ? x : alpha * x + (1.0 - alpha) * average;\n");
+    fprintf(file, "        double got = sc_value_to_f64(sc_get_vector_element(out, i));\n");
+    fprintf(file, "        if (!rolling_close_%s(got, average, 8.0 * eps)) {\n", test.data_type);
+    fprintf(file, "            CCB_WARNING(\"ewma: %%f at %%\" PRIu64 \" for %%f\", got, i, average);\n");
+    fprintf(file, "            return -1;\n");
+    fprintf(file, "        }\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "\n");
+    fprintf(file, "    if (sc_vector_rolling_sum(a, out, 0, arena) == 0 || sc_vector_rolling_max(a, a, 8, arena) == 0\n");
+    fprintf(file, "        || sc_vector_rolling(a, out, 8, (sc_rolling_stat)9, arena) == 0 || sc_vector_ewma(a, out, 0.0, arena) == 0\n");
+    fprintf(file, "        || sc_vector_ewma(a, out, 1.5, arena) == 0) {\n");
+    fprintf(file, "        CCB_WARNING(\"Empty windows, in place windows, unknown statistics and alpha out of (0, 1] should be rejected\");\n");
+    fprintf(file, "        return -1;\n");
+    fprintf(file, "    }\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
+
 int main(void) {
     FILE* file = fopen(TEST_FILE, "w");
 
@@ -1172,6 +4405,7 @@ int main(void) {
     
     // header
     fprintf(file, "#include \"scandium.h\"\n");
+    fprintf(file, "#include <inttypes.h>\n");
     fprintf(file, "#include <string.h>\n");
     fprintf(file, "#include <math.h>\n\n");
 
@@ -1220,6 +4454,45 @@ int main(void) {
         gen_test_get_sub_tensor(file, tests[i]);
         gen_test_get_slice_vector(file, tests[i]);
         gen_test_get_slice_tensor(file, tests[i]);
+        gen_test_layer_norm(file, tests[i]);
+        gen_test_rms_norm(file, tests[i]);
+        gen_test_batch_norm(file, tests[i]);
+        gen_test_tensor_matmul(file, tests[i]);
+        gen_test_conv2d(file, tests[i]);
+        gen_test_conv1d(file, tests[i]);
+        gen_test_pool2d(file, tests[i]);
+        gen_test_transpose(file, tests[i]);
+        gen_test_transpose_int(file, tests[i]);
+        gen_test_permute_nhwc(file, tests[i]);
+        gen_test_permute_nd(file, tests[i]);
+        gen_test_sparse_vector(file, tests[i]);
+        gen_test_spmv(file, tests[i]);
+        gen_test_spmm(file, tests[i]);
+        gen_test_quantize(file, tests[i]);
+        gen_test_qgemm(file, tests[i]);
+        gen_test_half_convert(file, tests[i]);
+        gen_test_half_ops(file, tests[i]);
+        gen_test_int_ops(file, tests[i]);
+        gen_test_int_cast(file, tests[i]);
+        gen_test_cast_rounding(file, tests[i]);
+        gen_test_mixed_ops(file, tests[i]);
+        gen_test_fused_ops(file, tests[i]);
+        gen_test_linreg(file, tests[i]);
+        gen_test_logreg(file, tests[i]);
+        gen_test_nn(file, tests[i]);
+        gen_test_autodiff(file, tests[i]);
+        gen_test_optim(file, tests[i]);
+        gen_test_random(file, tests[i]);
+        gen_test_factor(file, tests[i]);
+        gen_test_geometry(file, tests[i]);
+        gen_test_distance(file, tests[i]);
+        gen_test_ann(file, tests[i]);
+        gen_test_kmeans(file, tests[i]);
+        gen_test_selection(file, tests[i]);
+        gen_test_sort(file, tests[i]);
+        gen_test_scan(file, tests[i]);
+        gen_test_segment(file, tests[i]);
+        gen_test_rolling(file, tests[i]);
     }
 
 
@@ -1278,6 +4551,45 @@ int main(void) {
         helper_generate_test_run(file, "get_sub_tensor", tests[i].data_type);
         helper_generate_test_run(file, "get_slice_vector", tests[i].data_type);
         helper_generate_test_run(file, "get_slice_tensor", tests[i].data_type);
+        helper_generate_test_run(file, "layer_norm", tests[i].data_type);
+        helper_generate_test_run(file, "rms_norm", tests[i].data_type);
+        helper_generate_test_run(file, "batch_norm", tests[i].data_type);
+        helper_generate_test_run(file, "tensor_matmul", tests[i].data_type);
+        helper_generate_test_run(file, "conv2d", tests[i].data_type);
+        helper_generate_test_run(file, "conv1d", tests[i].data_type);
+        helper_generate_test_run(file, "pool2d", tests[i].data_type);
+        helper_generate_test_run(file, "transpose", tests[i].data_type);
+        helper_generate_test_run(file, "transpose_int", tests[i].data_type);
+        helper_generate_test_run(file, "permute_nhwc", tests[i].data_type);
+        helper_generate_test_run(file, "permute_nd", tests[i].data_type);
+        helper_generate_test_run(file, "sparse_vector", tests[i].data_type);
+        helper_generate_test_run(file, "spmv", tests[i].data_type);
+        helper_generate_test_run(file, "spmm", tests[i].data_type);
+        helper_generate_test_run(file, "quantize", tests[i].data_type);
+        helper_generate_test_run(file, "qgemm", tests[i].data_type);
+        helper_generate_test_run(file, "half_convert", tests[i].data_type);
+        helper_generate_test_run(file, "half_ops", tests[i].data_type);
+        helper_generate_test_run(file, "int_ops", tests[i].data_type);
+        helper_generate_test_run(file, "int_cast", tests[i].data_type);
+        helper_generate_test_run(file, "cast_rounding", tests[i].data_type);
+        helper_generate_test_run(file, "mixed_ops", tests[i].data_type);
+        helper_generate_test_run(file, "fused_ops", tests[i].data_type);
+        helper_generate_test_run(file, "linreg", tests[i].data_type);
+        helper_generate_test_run(file, "logreg", tests[i].data_type);
+        helper_generate_test_run(file, "nn", tests[i].data_type);
+        helper_generate_test_run(file, "autodiff", tests[i].data_type);
+        helper_generate_test_run(file, "optim", tests[i].data_type);
+        helper_generate_test_run(file, "random", tests[i].data_type);
+        helper_generate_test_run(file, "factor", tests[i].data_type);
+        helper_generate_test_run(file, "geometry", tests[i].data_type);
+        helper_generate_test_run(file, "distance", tests[i].data_type);
+        helper_generate_test_run(file, "ann", tests[i].data_type);
+        helper_generate_test_run(file, "kmeans", tests[i].data_type);
+        helper_generate_test_run(file, "selection", tests[i].data_type);
+        helper_generate_test_run(file, "sort", tests[i].data_type);
+        helper_generate_test_run(file, "scan", tests[i].data_type);
+        helper_generate_test_run(file, "segment", tests[i].data_type);
+        helper_generate_test_run(file, "rolling", tests[i].data_type);
     
     }
 
@@ -0,0 +1,434 @@
+#include "data.h"
+#include "geometry.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+// items of a work unit
+#define GEOMETRY_CHUNK 4096
+// components of the largest item (4x4 matrix)
+#define GEOMETRY_MAX_COMPONENTS 16
+
+
+typedef enum {
+    geometry_cross,
+    geometry_dot,
+    geometry_normalize,
+    geometry_transform,
+    geometry_rotate,
+} geometry_op;
+
+struct geometry_args {
+    geometry_op op;
+    sc_TYPES type;
+    uint64_t count;
+    uint32_t a_components;
+    uint32_t b_components;
+    int a_broadcast;            // a holds one item applied to all
+    const char* a[GEOMETRY_MAX_COMPONENTS];
+    const char* b[GEOMETRY_MAX_COMPONENTS];
+    char* out[GEOMETRY_MAX_COMPONENTS];
+};
+
+
+/*
+    the kernels are written once on lanes of W items: scalar (W = 1) for the tails and the CPUs without AVX2,
+    __m256 (W = 8) and __m256d (W = 4) otherwise, all the inputs of a lane are loaded before its outputs are
+    stored so that the output can alias an input
+    they return the first item they did not process
+*/
+#define GEOMETRY_KERNELS(SUFFIX, TARGET, T, V, W, LD, ST, SET1, ADD, SUB, MUL, FMA, INV_NORM)                 \
+static TARGET uint64_t cross_##SUFFIX(const struct geometry_args* g, uint64_t i, uint64_t end) {                 \
+    for (; i + W <= end; i += W) {                                                                             \
+        V ax = LD((const T*)g->a[0] + i), ay = LD((const T*)g->a[1] + i), az = LD((const T*)g->a[2] + i);     \
+        V bx = LD((const T*)g->b[0] + i), by = LD((const T*)g->b[1] + i), bz = LD((const T*)g->b[2] + i);     \
+        ST((T*)g->out[0] + i, SUB(MUL(ay, bz), MUL(az, by)));                                                  \
+        ST((T*)g->out[1] + i, SUB(MUL(az, bx), MUL(ax, bz)));                                                  \
+        ST((T*)g->out[2] + i, SUB(MUL(ax, by), MUL(ay, bx)));                                                  \
+    }                                                                                                          \
+    return i;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+static TARGET uint64_t dot_##SUFFIX(const struct geometry_args* g, uint64_t i, uint64_t end) {                   \
+    for (; i + W <= end; i += W) {                                                                             \
+        V sum = MUL(LD((const T*)g->a[0] + i), LD((const T*)g->b[0] + i));                                     \
+        for (uint32_t c = 1; c < g->a_components; c++) {                                                       \
+            sum = FMA(LD((const T*)g->a[c] + i), LD((const T*)g->b[c] + i), sum);                              \
+        }                                                                                                      \
+        ST((T*)g->out[0] + i, sum);                                                                            \
+    }                                                                                                          \
+    return i;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+static TARGET uint64_t normalize_##SUFFIX(const struct geometry_args* g, uint64_t i, uint64_t end) {             \
+    V x[4];                                                                                                    \
+    for (; i + W <= end; i += W) {                                                                             \
+        x[0] = LD((const T*)g->a[0] + i);                                                                      \
+        V norm2 = MUL(x[0], x[0]);                                                                             \
+        for (uint32_t c = 1; c < g->a_components; c++) {                                                       \
+            x[c] = LD((const T*)g->a[c] + i);                                                                  \
+            norm2 = FMA(x[c], x[c], norm2);                                                                    \
+        }                                                                                                      \
+        V inv = INV_NORM(norm2);                                                                               \
+        for (uint32_t c = 0; c < g->a_components; c++) {                                                       \
+            ST((T*)g->out[c] + i, MUL(x[c], inv));                                                             \
+        }                                                                                                      \
+    }                                                                                                          \
+    return i;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+/* a: matrices (9 or 16 components), b: vectors (3 or 4 components) */                                       \
+static TARGET uint64_t transform_##SUFFIX(const struct geometry_args* g, uint64_t i, uint64_t end) {             \
+    uint32_t dim = (g->a_components == 9) ? 3 : 4;                                                             \
+    int affine = (dim == 4 && g->b_components == 3);                                                           \
+    V m[GEOMETRY_MAX_COMPONENTS];                                                                              \
+    V v[4];                                                                                                    \
+    V o[4];                                                                                                    \
+    if (g->a_broadcast) {                                                                                      \
+        for (uint32_t c = 0; c < g->a_components; c++) {                                                       \
+            m[c] = SET1(((const T*)g->a[c])[0]);                                                               \
+        }                                                                                                      \
+    }                                                                                                          \
+    for (; i + W <= end; i += W) {                                                                             \
+        if (!g->a_broadcast) {                                                                                 \
+            for (uint32_t c = 0; c < g->a_components; c++) {                                                   \
+                m[c] = LD((const T*)g->a[c] + i);                                                              \
+            }                                                                                                  \
+        }                                                                                                      \
+        for (uint32_t c = 0; c < g->b_components; c++) {                                                       \
+            v[c] = LD((const T*)g->b[c] + i);                                                                  \
+        }                                                                                                      \
+        for (uint32_t r = 0; r < g->b_components; r++) {                                                       \
+            const V* row = m + r * dim;                                                                        \
+            V sum = FMA(row[2], v[2], FMA(row[1], v[1], MUL(row[0], v[0])));                                   \
+            if (dim == 4) {                                                                                    \
+                sum = affine ? ADD(sum, row[3]) : FMA(row[3], v[3], sum);                                      \
+            }                                                                                                  \
+            o[r] = sum;                                                                                        \
+        }                                                                                                      \
+        for (uint32_t r = 0; r < g->b_components; r++) {                                                       \
+            ST((T*)g->out[r] + i, o[r]);                                                                       \
+        }                                                                                                      \
+    }                                                                                                          \
+    return i;                                                                                                  \
+}                                                                                                              \
+                                                                                                               \
+/* v' = v + w.t + q x t with t = 2 q x v, a: quaternions (x, y, z, w), b: 3D vectors */                        \
+static TARGET uint64_t rotate_##SUFFIX(const struct geometry_args* g, uint64_t i, uint64_t end) {                \
+    V q[4];                                                                                                    \
+    V two = SET1((T)2);                                                                                        \
+    if (g->a_broadcast) {                                                                                      \
+        for (uint32_t c = 0; c < 4; c++) {                                                                     \
+            q[c] = SET1(((const T*)g->a[c])[0]);                                                               \
+        }                                                                                                      \
+    }                                                                                                          \
+    for (; i + W <= end; i += W) {                                                                             \
+        if (!g->a_broadcast) {                                                                                 \
+            for (uint32_t c = 0; c < 4; c++) {                                                                 \
+                q[c] = LD((const T*)g->a[c] + i);                                                              \
+            }                                                                                                  \
+        }                                                                                                      \
+        V vx = LD((const T*)g->b[0] + i), vy = LD((const T*)g->b[1] + i), vz = LD((const T*)g->b[2] + i);     \
+        V tx = MUL(two, SUB(MUL(q[1], vz), MUL(q[2], vy)));                                                    \
+        V ty = MUL(two, SUB(MUL(q[2], vx), MUL(q[0], vz)));                                                    \
+        V tz = MUL(two, SUB(MUL(q[0], vy), MUL(q[1], vx)));                                                    \
+        ST((T*)g->out[0] + i, ADD(FMA(q[3], tx, vx), SUB(MUL(q[1], tz), MUL(q[2], ty))));                      \
+        ST((T*)g->out[1] + i, ADD(FMA(q[3], ty, vy), SUB(MUL(q[2], tx), MUL(q[0], tz))));                      \
+        ST((T*)g->out[2] + i, ADD(FMA(q[3], tz, vz), SUB(MUL(q[0], ty), MUL(q[1], tx))));                      \
+    }                                                                                                          \
+    return i;                                                                                                  \
+}
+
+
+#define SCALAR_LD(p) (*(p))
+#define SCALAR_ST(p, x) (*(p) = (x))
+#define SCALAR_SET1(x) (x)
+#define SCALAR_ADD(a, b) ((a) + (b))
+#define SCALAR_SUB(a, b) ((a) - (b))
+#define SCALAR_MUL(a, b) ((a) * (b))
+#define SCALAR_FMA(a, b, c) ((a) * (b) + (c))
+#define SCALAR_INV_NORM_F32(n2) (((n2) > 0.0f) ? 1.0f / sqrtf(n2) : 0.0f)
+#define SCALAR_INV_NORM_F64(n2) (((n2) > 0.0) ? 1.0 / sqrt(n2) : 0.0)
+
+#define AVX_INV_NORM_F32(n2) _mm256_and_ps(_mm256_cmp_ps((n2), _mm256_setzero_ps(), _CMP_GT_OQ), \
+                                           _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(n2)))
+#define AVX_INV_NORM_F64(n2) _mm256_and_pd(_mm256_cmp_pd((n2), _mm256_setzero_pd(), _CMP_GT_OQ), \
+                                           _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(n2)))
+
+GEOMETRY_KERNELS(f32, , float, float, 1, SCALAR_LD, SCALAR_ST, SCALAR_SET1, SCALAR_ADD, SCALAR_SUB, SCALAR_MUL, SCALAR_FMA,
+                 SCALAR_INV_NORM_F32)
+GEOMETRY_KERNELS(f64, , double, double, 1, SCALAR_LD, SCALAR_ST, SCALAR_SET1, SCALAR_ADD, SCALAR_SUB, SCALAR_MUL, SCALAR_FMA,
+                 SCALAR_INV_NORM_F64)
+GEOMETRY_KERNELS(f32_avx2, SC_TARGET_AVX2, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_add_ps,
+                 _mm256_sub_ps, _mm256_mul_ps, _mm256_fmadd_ps, AVX_INV_NORM_F32)
+GEOMETRY_KERNELS(f64_avx2, SC_TARGET_AVX2, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_add_pd,
+                 _mm256_sub_pd, _mm256_mul_pd, _mm256_fmadd_pd, AVX_INV_NORM_F64)
+
+
+typedef uint64_t (*geometry_kernel_fn)(const struct geometry_args* g, uint64_t i, uint64_t end);
+
+// [op][type float32 / float64][scalar / avx2]
+static const geometry_kernel_fn kernels[5][2][2] = {
+    {{cross_f32, cross_f32_avx2}, {cross_f64, cross_f64_avx2}},
+    {{dot_f32, dot_f32_avx2}, {dot_f64, dot_f64_avx2}},
+    {{normalize_f32, normalize_f32_avx2}, {normalize_f64, normalize_f64_avx2}},
+    {{transform_f32, transform_f32_avx2}, {transform_f64, transform_f64_avx2}},
+    {{rotate_f32, rotate_f32_avx2}, {rotate_f64, rotate_f64_avx2}},
+};
+
+
+static int geometry_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    const struct geometry_args* g = (const struct geometry_args*)raw;
+    uint64_t first = start * GEOMETRY_CHUNK;
+    uint64_t last = (end * GEOMETRY_CHUNK < g->count) ? end * GEOMETRY_CHUNK : g->count;
+    const geometry_kernel_fn* fns = kernels[g->op][g->type == sc_float64];
+    if (sc_has_avx2_fma()) {
+        first = fns[1](g, first, last);
+    }
+    fns[0](g, first, last);
+    return 0;
+}
+
+
+static int run(struct geometry_args* g, ccb_arena* arena) {
+    uint64_t chunks = (g->count + GEOMETRY_CHUNK - 1) / GEOMETRY_CHUNK;
+    uint64_t work = g->count * (uint64_t)(g->a_components + g->b_components);
+    if (chunks > 0 && sc_run_range_task(geometry_kernel, g, chunks, work, arena) != 0) {
+        CCB_ERROR("Failed to run batched geometry kernel");
+        return -1;
+    }
+    return 0;
+}
+
+
+static void component_pointers(const sc_soa* soa, const char** out) {
+    uint64_t size = sc_type_size(soa->type);
+    for (uint32_t c = 0; c < soa->components; c++) {
+        out[c] = (const char*)soa->data + c * soa->stride * size;
+    }
+}
+
+
+static int check_soa(const sc_soa* soa, const char* name, uint32_t components_a, uint32_t components_b) {
+    CCB_NOTNULL(soa, "%s is NULL", name);
+    if (soa->type != sc_float32 && soa->type != sc_float64) {
+        CCB_ERROR("Batches of %s must be float32 or float64, got type %d", name, soa->type);
+        return -1;
+    }
+    if (soa->components != components_a && soa->components != components_b) {
+        if (components_a == components_b) {
+            CCB_ERROR("%s has %u components, expected %u", name, soa->components, components_a);
+        } else {
+            CCB_ERROR("%s has %u components, expected %u or %u", name, soa->components, components_a, components_b);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+
+// the inputs a (possibly a single broadcast item) and b, and the output, share type and count
+static int prepare(struct geometry_args* g, geometry_op op, sc_soa* a, sc_soa* b, sc_soa* out, int broadcast) {
+    memset(g, 0, sizeof(*g));
+    g->op = op;
+    g->type = b->type;
+    g->count = b->count;
+    g->a_components = a->components;
+    g->b_components = b->components;
+    g->a_broadcast = broadcast && a->count == 1;
+    if (a->type != b->type || (a->count != b->count && !g->a_broadcast)) {
+        CCB_ERROR("Batch mismatch: %" PRIu64 " items of type %d against %" PRIu64 " items of type %d", a->count, a->type, b->count, b->type);
+        return -1;
+    }
+    if (out != NULL) {
+        if (out->type != b->type || out->count != b->count || out->components != b->components) {
+            CCB_ERROR("The output batch must have %" PRIu64 " items of %u components of type %d", b->count, b->components, b->type);
+            return -1;
+        }
+        component_pointers(out, (const char**)g->out);
+    }
+    component_pointers(a, g->a);
+    component_pointers(b, g->b);
+    return 0;
+}
+
+
+sc_soa* sc_create_soa(uint64_t count, uint32_t components, sc_TYPES type, ccb_arena* arena) {
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (type != sc_float32 && type != sc_float64) {
+        CCB_ERROR("Batches must be float32 or float64, got type %d", type);
+        return NULL;
+    }
+    if (components == 0 || components > GEOMETRY_MAX_COMPONENTS) {
+        CCB_ERROR("Batches have 1 to %d components, got %u", GEOMETRY_MAX_COMPONENTS, components);
+        return NULL;
+    }
+    sc_soa* soa = (sc_soa*)ccb_arena_malloc(arena, sizeof(sc_soa));
+    CCB_NOTNULL(soa, "Failed to allocate batch");
+    soa->count = count;
+    soa->stride = (count + 7) & ~(uint64_t)7;
+    soa->components = components;
+    soa->type = type;
+    uint64_t bytes = soa->stride * components * sc_type_size(type);
+    soa->data = ccb_arena_malloc(arena, bytes > 0 ? bytes : 1);
+    CCB_NOTNULL(soa->data, "Failed to allocate batch data");
+    memset(soa->data, 0, bytes);
+    return soa;
+}
+
+
+// ####################
+// AoS <-> SoA transposes
+// ####################
+
+struct layout_args {
+    const sc_soa* soa;
+    void* aos;
+    int pack;
+};
+
+
+#define LAYOUT_COPY(T)                                                                                         \
+    for (uint64_t i = first; i < last; i++) {                                                                  \
+        for (uint32_t c = 0; c < components; c++) {                                                            \
+            if (args->pack) {                                                                                  \
+                ((T*)soa->data)[c * soa->stride + i] = ((const T*)args->aos)[i * components + c];               \
+            } else {                                                                                           \
+                ((T*)args->aos)[i * components + c] = ((const T*)soa->data)[c * soa->stride + i];               \
+            }                                                                                                  \
+        }                                                                                                      \
+    }
+
+
+static int layout_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct layout_args* args = (struct layout_args*)raw;
+    const sc_soa* soa = args->soa;
+    uint32_t components = soa->components;
+    uint64_t first = start * GEOMETRY_CHUNK;
+    uint64_t last = (end * GEOMETRY_CHUNK < soa->count) ? end * GEOMETRY_CHUNK : soa->count;
+    if (soa->type == sc_float64) {
+        LAYOUT_COPY(uint64_t)
+    } else {
+        LAYOUT_COPY(uint32_t)
+    }
+    return 0;
+}
+
+
+static int convert_layout(sc_tensor* aos, sc_soa* soa, int pack, ccb_arena* arena) {
+    CCB_NOTNULL(aos, "aos is NULL");
+    CCB_NOTNULL(soa, "soa is NULL");
+    if (aos->type != soa->type || aos->dims->dims_count != 2 || aos->dims->dims[0] != soa->count ||
+        aos->dims->dims[1] != soa->components) {
+        CCB_ERROR("The array of structures must be [%" PRIu64 ", %u] of type %d", soa->count, soa->components, soa->type);
+        return -1;
+    }
+    struct layout_args args = {soa, aos->data, pack};
+    uint64_t chunks = (soa->count + GEOMETRY_CHUNK - 1) / GEOMETRY_CHUNK;
+    if (chunks > 0 && sc_run_range_task(layout_kernel, &args, chunks, soa->count * soa->components, arena) != 0) {
+        CCB_ERROR("Failed to convert batch layout");
+        return -1;
+    }
+    return 0;
+}
+
+
+int sc_soa_pack(sc_tensor* aos, sc_soa* out, ccb_arena* arena) {
+    return convert_layout(aos, out, 1, arena);
+}
+
+
+int sc_soa_unpack(sc_soa* soa, sc_tensor* out, ccb_arena* arena) {
+    return convert_layout(out, soa, 0, arena);
+}
+
+
+// ###########
+// operations
+// ###########
+
+int sc_soa_cross(sc_soa* a, sc_soa* b, sc_soa* out, ccb_arena* arena) {
+    if (check_soa(a, "a", 3, 3) != 0 || check_soa(b, "b", 3, 3) != 0) {
+        return -1;
+    }
+    CCB_NOTNULL(out, "out is NULL");
+    struct geometry_args g;
+    if (prepare(&g, geometry_cross, a, b, out, 0) != 0) {
+        return -1;
+    }
+    return run(&g, arena);
+}
+
+
+int sc_soa_dot(sc_soa* a, sc_soa* b, sc_vector* out, ccb_arena* arena) {
+    if (check_soa(a, "a", 3, 4) != 0 || check_soa(b, "b", 3, 4) != 0) {
+        return -1;
+    }
+    CCB_NOTNULL(out, "out is NULL");
+    if (a->components != b->components) {
+        CCB_ERROR("Dot products of %u and %u components", a->components, b->components);
+        return -1;
+    }
+    if (out->type != b->type || out->size != b->count) {
+        CCB_ERROR("The output vector must have %" PRIu64 " elements of type %d", b->count, b->type);
+        return -1;
+    }
+    struct geometry_args g;
+    if (prepare(&g, geometry_dot, a, b, NULL, 0) != 0) {
+        return -1;
+    }
+    g.out[0] = (char*)out->data;
+    return run(&g, arena);
+}
+
+
+int sc_soa_normalize(sc_soa* a, sc_soa* out, ccb_arena* arena) {
+    if (check_soa(a, "a", 3, 4) != 0) {
+        return -1;
+    }
+    CCB_NOTNULL(out, "out is NULL");
+    struct geometry_args g;
+    if (prepare(&g, geometry_normalize, a, a, out, 0) != 0) {
+        return -1;
+    }
+    return run(&g, arena);
+}
+
+
+int sc_soa_transform(sc_soa* m, sc_soa* v, sc_soa* out, ccb_arena* arena) {
+    if (check_soa(m, "m", 9, 16) != 0 || check_soa(v, "v", 3, 4) != 0) {
+        return -1;
+    }
+    CCB_NOTNULL(out, "out is NULL");
+    if (m->components == 9 && v->components != 3) {
+        CCB_ERROR("3x3 matrices transform 3D vectors, got %u components", v->components);
+        return -1;
+    }
+    struct geometry_args g;
+    if (prepare(&g, geometry_transform, m, v, out, 1) != 0) {
+        return -1;
+    }
+    return run(&g, arena);
+}
+
+
+int sc_soa_rotate(sc_soa* q, sc_soa* v, sc_soa* out, ccb_arena* arena) {
+    if (check_soa(q, "q", 4, 4) != 0 || check_soa(v, "v", 3, 3) != 0) {
+        return -1;
+    }
+    CCB_NOTNULL(out, "out is NULL");
+    struct geometry_args g;
+    if (prepare(&g, geometry_rotate, q, v, out, 1) != 0) {
+        return -1;
+    }
+    return run(&g, arena);
+}
@@ -0,0 +1,63 @@
+#ifndef __GEOMETRY_H__
+#define __GEOMETRY_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    batched small vector kernels on structure of arrays (SoA) batches: component c of item i is stored at
+    data[c * stride + i], so one AVX register holds the same component of 8 (float32) or 4 (float64) items
+    and cross / dot / normalise / transforms need no shuffles
+    3D and 4D vectors have 3 and 4 components, quaternions 4 (x, y, z, w), 3x3 and 4x4 matrices 9 and 16
+    (row major, M[r][c] is component 4 r + c for a 4x4)
+    the kernels run on the engine thread pool, the output can be one of the inputs (in place)
+    matrices and quaternions given as a batch of one item are applied to every item
+*/
+
+typedef struct {
+    void* data;
+    uint64_t count;         // items
+    uint64_t stride;        // elements between two components, count rounded up to 8
+    uint32_t components;
+    sc_TYPES type;          // float32 or float64
+} sc_soa;
+
+
+/* Creates a batch of count items, its values are 0
+   - uint32_t components: 3 or 4 for vectors and quaternions, 9 or 16 for matrices (any count up to 16 is accepted)
+   - sc_TYPES type: float32 or float64
+   - return: a pointer to the batch, NULL on error
+*/
+sc_soa* sc_create_soa(uint64_t count, uint32_t components, sc_TYPES type, ccb_arena* arena);
+/* Fills a batch from an array of structures
+   - sc_tensor* aos: [count, components] tensor of the type of the batch
+   - sc_soa* out: batch with the same count and components
+   - return: 0 on success
+*/
+int sc_soa_pack(sc_tensor* aos, sc_soa* out, ccb_arena* arena);
+/* Writes a batch into a [count, components] array of structures of its type */
+int sc_soa_unpack(sc_soa* soa, sc_tensor* out, ccb_arena* arena);
+
+/* out = a x b for batches of 3D vectors */
+int sc_soa_cross(sc_soa* a, sc_soa* b, sc_soa* out, ccb_arena* arena);
+/* Dot products of batches of 3D or 4D vectors
+   - sc_vector* out: count elements of the type of the batches
+*/
+int sc_soa_dot(sc_soa* a, sc_soa* b, sc_vector* out, ccb_arena* arena);
+/* out = a / |a| for batches of 3D or 4D vectors (and quaternions), zero vectors stay 0 */
+int sc_soa_normalize(sc_soa* a, sc_soa* out, ccb_arena* arena);
+/* out = M.v
+   - sc_soa* m: 3x3 or 4x4 matrices, one per item or a single one
+   - sc_soa* v: vectors with as many components as the rows of the matrices, or 3D points with 4x4 matrices
+                (affine transform with w = 1, the last row of M is not used)
+   - sc_soa* out: same count and components as v
+*/
+int sc_soa_transform(sc_soa* m, sc_soa* v, sc_soa* out, ccb_arena* arena);
+/* out = q.v.q^-1, rotation of 3D vectors by unit quaternions
+   - sc_soa* q: quaternions (x, y, z, w), one per item or a single one
+*/
+int sc_soa_rotate(sc_soa* q, sc_soa* v, sc_soa* out, ccb_arena* arena);
+
+
+#endif // __GEOMETRY_H__
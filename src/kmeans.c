@@ -0,0 +1,769 @@
+#include "data.h"
+#include "kmeans.h"
+#include "distance.h"
+#include "random.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+
+
+// rows of a work unit of the seeding and update kernels
+#define KMEANS_CHUNK_ROWS 1024
+// Philox streams of the seeding draws
+#define KMEANS_STREAM_FIRST 0
+#define KMEANS_STREAM_PLUS_PLUS 1
+#define KMEANS_STREAM_PARALLEL 2
+#define KMEANS_STREAM_REDUCE 3
+
+
+sc_kmeans_options sc_kmeans_default_options(uint64_t k) {
+    sc_kmeans_options options;
+    options.k = k;
+    options.seeding = sc_kmeans_parallel;
+    options.max_iterations = 100;
+    options.tolerance = 1e-4;
+    options.rounds = 2;
+    options.oversampling = 2.0;
+    options.seed = 0;
+    return options;
+}
+
+
+// 53 bits uniform in [0, 1) of element index of a stream
+static double uniform(uint64_t seed, uint64_t index, uint32_t stream, uint32_t round) {
+    uint32_t counter[4] = {(uint32_t)index, (uint32_t)(index >> 32), stream, round};
+    uint32_t key[2] = {(uint32_t)seed, (uint32_t)(seed >> 32)};
+    uint32_t words[4];
+    sc_philox4x32(counter, key, words);
+    return (double)(((uint64_t)(words[0] >> 5) << 26) | (words[1] >> 6)) * (1.0 / 9007199254740992.0);
+}
+
+
+static uint64_t chunk_count(uint64_t n) {
+    return (n + KMEANS_CHUNK_ROWS - 1) / KMEANS_CHUNK_ROWS;
+}
+
+
+static int check_points(sc_tensor* points, uint64_t dim, const char* name) {
+    CCB_NOTNULL(points, "%s is NULL", name);
+    if (points->type != sc_float16 && points->type != sc_float32 && points->type != sc_float64) {
+        CCB_ERROR("%s must be bfloat16, float32 or float64, got type %d", name, points->type);
+        return -1;
+    }
+    if (points->dims->dims_count != 2 || points->dims->dims[0] == 0 || (dim != 0 && points->dims->dims[1] != dim)) {
+        CCB_ERROR("%s must be a non empty [n, %" PRIu64 "] tensor", name, dim);
+        return -1;
+    }
+    return 0;
+}
+
+
+// gemm top 1: nearest center of every point, the squared distances are returned in the compute type of the points
+static sc_tensor* nearest(sc_point_set* points, sc_tensor* centers, uint64_t* labels, ccb_arena* arena) {
+    uint64_t dims[] = {points->points->dims->dims[0], 1};
+    sc_point_set* set = sc_point_set_create(centers, arena);
+    sc_tensor* distances = sc_create_tensor(sc_create_dimensions(2, arena, dims), (centers->type == sc_float64) ? sc_float64 : sc_float32, arena);
+    if (set == NULL || distances == NULL || sc_pairwise_topk(points, set, sc_metric_sqeuclidean, 1, labels, distances, arena) != 0) {
+        CCB_ERROR("Failed to assign the points to their nearest centers");
+        return NULL;
+    }
+    return distances;
+}
+
+
+static inline double distance_at(const sc_tensor* distances, uint64_t i) {
+    return (distances->type == sc_float64) ? ((const double*)distances->data)[i] : (double)((const float*)distances->data)[i];
+}
+
+
+// ##########
+// seeding
+// ##########
+
+// squared distance of two rows, float32 lanes for bfloat16 / float32 rows and float64 lanes for float64 rows
+static double row_distance(const void* a, const void* b, uint64_t dim, sc_TYPES type) {
+    uint64_t p = 0;
+    if (type == sc_float64) {
+        const double* x = (const double*)a;
+        const double* y = (const double*)b;
+        __m256d acc = _mm256_setzero_pd();
+        for (; p + 4 <= dim; p += 4) {
+            __m256d d = _mm256_sub_pd(_mm256_loadu_pd(x + p), _mm256_loadu_pd(y + p));
+            acc = _mm256_add_pd(acc, _mm256_mul_pd(d, d));
+        }
+        double sum = sc_hsum_f64x4(acc);
+        for (; p < dim; p++) {
+            sum += (x[p] - y[p]) * (x[p] - y[p]);
+        }
+        return sum;
+    }
+    __m256 acc = _mm256_setzero_ps();
+    for (; p + 8 <= dim; p += 8) {
+        __m256 d = _mm256_sub_ps(sc_load_f32x8(a, p, type), sc_load_f32x8(b, p, type));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(d, d));
+    }
+    float sum = sc_hsum_f32x8(acc);
+    for (; p < dim; p++) {
+        float d = sc_load_f32(a, p, type) - sc_load_f32(b, p, type);
+        sum += d * d;
+    }
+    return sum;
+}
+
+
+/*
+    the mass of a point is its weight times its squared distance to the nearest center chosen so far, every chunk
+    sums the mass of its rows in order so that the draws do not depend on the thread count
+    the distances to new centers are folded in with min: one center is compared to the rows directly, a batch
+    of centers goes through a gemm top 1 first
+*/
+struct mass_args {
+    double* d2;                     // [n]
+    const sc_tensor* points;        // rows compared to center
+    const void* center;             // row of the new center, NULL for none
+    const sc_tensor* distances;     // [n] distances to a batch of new centers, NULL for none
+    const uint64_t* labels;         // [n] nearest center of the batch
+    uint64_t* owner;                // [n] index of the nearest center, NULL when not tracked
+    uint64_t offset;                // index of the first center of the batch
+    const double* weights;          // [n], NULL for 1
+    double* sums;                   // [chunks]
+    uint64_t count;
+};
+
+
+static int mass_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct mass_args* args = (struct mass_args*)raw;
+    uint64_t dim = args->points->dims->dims[1];
+    uint64_t row_size = dim * sc_type_size(args->points->type);
+    for (uint64_t c = start; c < end; c++) {
+        uint64_t first = c * KMEANS_CHUNK_ROWS;
+        uint64_t last = (first + KMEANS_CHUNK_ROWS < args->count) ? first + KMEANS_CHUNK_ROWS : args->count;
+        double sum = 0.0;
+        for (uint64_t i = first; i < last; i++) {
+            double d = INFINITY;
+            if (args->center != NULL) {
+                d = row_distance((const uint8_t*)args->points->data + i * row_size, args->center, dim, args->points->type);
+            } else if (args->distances != NULL) {
+                d = distance_at(args->distances, i);
+            }
+            if (d < args->d2[i]) {
+                args->d2[i] = d;
+                if (args->owner != NULL) {
+                    args->owner[i] = args->offset + args->labels[i];
+                }
+            }
+            sum += (args->weights ? args->weights[i] : 1.0) * args->d2[i];
+        }
+        args->sums[c] = sum;
+    }
+    return 0;
+}
+
+
+static int fold_mass(struct mass_args* args, const void* center, const sc_tensor* distances, ccb_arena* arena) {
+    args->center = center;
+    args->distances = distances;
+    uint64_t work = (center != NULL) ? args->count * args->points->dims->dims[1] : args->count;
+    return sc_run_range_task(mass_kernel, args, chunk_count(args->count), work, arena);
+}
+
+
+// draws a point with a probability proportional to its mass, UINT64_MAX when every mass is 0
+static uint64_t pick(const struct mass_args* args, double u) {
+    uint64_t chunks = chunk_count(args->count);
+    double total = 0.0;
+    for (uint64_t c = 0; c < chunks; c++) {
+        total += args->sums[c];
+    }
+    if (!(total > 0.0)) {
+        return UINT64_MAX;
+    }
+    double target = u * total;
+    uint64_t c = 0;
+    for (; c + 1 < chunks && target >= args->sums[c]; c++) {
+        target -= args->sums[c];
+    }
+    // rounding can leave the target past the last point with a mass, which is then taken
+    uint64_t chosen = UINT64_MAX;
+    uint64_t last = ((c + 1) * KMEANS_CHUNK_ROWS < args->count) ? (c + 1) * KMEANS_CHUNK_ROWS : args->count;
+    for (uint64_t i = c * KMEANS_CHUNK_ROWS; i < last; i++) {
+        double mass = (args->weights ? args->weights[i] : 1.0) * args->d2[i];
+        if (mass > 0.0) {
+            chosen = i;
+            if (target < mass) {
+                break;
+            }
+            target -= mass;
+        }
+    }
+    for (uint64_t i = 0; chosen == UINT64_MAX && i < args->count; i++) {
+        chosen = ((args->weights ? args->weights[i] : 1.0) * args->d2[i] > 0.0) ? i : UINT64_MAX;
+    }
+    return chosen;
+}
+
+
+/*
+    (weighted) k-means++: after every draw the distances of the rows to the new center are folded in the
+    distances to the nearest center, when every mass is 0 (less distinct points than k) the draw is uniform
+*/
+static int plus_plus(sc_tensor* points, const double* weights, uint64_t k, uint64_t seed, uint32_t stream, uint64_t* chosen,
+                     ccb_arena* arena, ccb_arena* step) {
+    uint64_t n = points->dims->dims[0];
+    uint64_t row_size = points->dims->dims[1] * sc_type_size(points->type);
+    struct mass_args args;
+    memset(&args, 0, sizeof(args));
+    args.d2 = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    args.points = points;
+    args.weights = weights;
+    args.sums = (double*)ccb_arena_malloc(arena, chunk_count(n) * sizeof(double));
+    args.count = n;
+    if (args.d2 == NULL || args.sums == NULL) {
+        CCB_ERROR("Failed to allocate k-means++ buffers");
+        return -1;
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        args.d2[i] = 1.0;
+    }
+    if (fold_mass(&args, NULL, NULL, step) != 0) {
+        return -1;
+    }
+
+    for (uint64_t c = 0; c < k; c++) {
+        double u = uniform(seed, c, stream, 0);
+        uint64_t row = pick(&args, u);
+        chosen[c] = (row != UINT64_MAX) ? row : (uint64_t)(u * (double)n);
+        if (c == 0) {
+            for (uint64_t i = 0; i < n; i++) {
+                args.d2[i] = INFINITY;
+            }
+        }
+        if (c + 1 < k) {
+            ccb_arena_reset(step);
+            if (fold_mass(&args, (const uint8_t*)points->data + chosen[c] * row_size, NULL, step) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+
+struct sample_args {
+    const double* d2;
+    uint8_t* flags;
+    double scale;           // oversampling k / total mass
+    uint64_t seed;
+    uint32_t round;
+    uint64_t count;
+};
+
+
+static int sample_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sample_args* args = (struct sample_args*)raw;
+    uint64_t last = (end * KMEANS_CHUNK_ROWS < args->count) ? end * KMEANS_CHUNK_ROWS : args->count;
+    for (uint64_t i = start * KMEANS_CHUNK_ROWS; i < last; i++) {
+        args->flags[i] = uniform(args->seed, i, KMEANS_STREAM_PARALLEL, args->round) < args->scale * args->d2[i];
+    }
+    return 0;
+}
+
+
+// copies rows of a point set in a new tensor
+static sc_tensor* gather_rows(sc_point_set* set, const uint64_t* rows, uint64_t count, ccb_arena* arena) {
+    sc_tensor* points = set->points;
+    uint64_t dim = points->dims->dims[1];
+    uint64_t row_size = dim * sc_type_size(points->type);
+    uint64_t dims[] = {count, dim};
+    sc_tensor* out = sc_create_tensor(sc_create_dimensions(2, arena, dims), points->type, arena);
+    CCB_NOTNULL(out, "Failed to allocate gathered rows");
+    for (uint64_t j = 0; j < count; j++) {
+        memcpy((uint8_t*)out->data + j * row_size, (const uint8_t*)points->data + rows[j] * row_size, row_size);
+    }
+    return out;
+}
+
+
+/*
+    k-means||: every round draws each point with probability oversampling k d2 / total (independent Philox draws)
+    and folds the distances to the drawn points with one gemm top 1, the fold also keeps the nearest candidate
+    of every point, which gives the weights of the candidates for their reduction to k with a weighted k-means++
+*/
+static int parallel_seed(sc_point_set* set, const sc_kmeans_options* options, uint64_t* chosen, ccb_arena* arena,
+                         ccb_arena* step) {
+    uint64_t n = set->points->dims->dims[0];
+    uint64_t k = options->k;
+    struct mass_args args;
+    memset(&args, 0, sizeof(args));
+    args.d2 = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    args.points = set->points;
+    args.sums = (double*)ccb_arena_malloc(arena, chunk_count(n) * sizeof(double));
+    args.count = n;
+    uint64_t* labels = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    args.labels = labels;
+    args.owner = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    uint64_t* candidates = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    uint8_t* flags = (uint8_t*)ccb_arena_malloc(arena, n);
+    if (args.d2 == NULL || args.sums == NULL || labels == NULL || args.owner == NULL || candidates == NULL || flags == NULL) {
+        CCB_ERROR("Failed to allocate k-means|| buffers");
+        return -1;
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        args.d2[i] = INFINITY;
+        args.owner[i] = 0;
+    }
+    uint64_t count = 1;
+    candidates[0] = (uint64_t)(uniform(options->seed, 0, KMEANS_STREAM_FIRST, 0) * (double)n);
+    uint64_t fresh = 0;
+
+    for (uint64_t round = 0; round <= options->rounds; round++) {
+        ccb_arena_reset(step);
+        args.offset = fresh;
+        sc_tensor* distances = nearest(set, gather_rows(set, candidates + fresh, count - fresh, step), labels, step);
+        if (distances == NULL || fold_mass(&args, NULL, distances, step) != 0) {
+            return -1;
+        }
+        // the gemm distance of a point to itself is not exactly 0 in float32
+        for (uint64_t j = fresh; j < count; j++) {
+            args.sums[candidates[j] / KMEANS_CHUNK_ROWS] -= args.d2[candidates[j]];
+            args.d2[candidates[j]] = 0.0;
+            args.owner[candidates[j]] = j;
+        }
+        if (round == options->rounds) {
+            break;
+        }
+        double total = 0.0;
+        for (uint64_t c = 0; c < chunk_count(n); c++) {
+            total += args.sums[c];
+        }
+        if (!(total > 0.0)) {
+            break;
+        }
+        struct sample_args sample = {args.d2, flags, options->oversampling * (double)k / total, options->seed, (uint32_t)round, n};
+        if (sc_run_range_task(sample_kernel, &sample, chunk_count(n), n, step) != 0) {
+            return -1;
+        }
+        fresh = count;
+        for (uint64_t i = 0; i < n; i++) {
+            if (flags[i]) {
+                candidates[count++] = i;
+            }
+        }
+        if (count == fresh) {
+            break;
+        }
+    }
+    if (count < k) {
+        return plus_plus(set->points, NULL, k, options->seed, KMEANS_STREAM_PLUS_PLUS, chosen, arena, step);
+    }
+
+    double* weights = (double*)ccb_arena_malloc(arena, count * sizeof(double));
+    uint64_t* picked = (uint64_t*)ccb_arena_malloc(arena, k * sizeof(uint64_t));
+    sc_tensor* rows = gather_rows(set, candidates, count, arena);
+    CCB_NOTNULL(picked, "Failed to allocate k-means|| weights");
+    memset(weights, 0, count * sizeof(double));
+    for (uint64_t i = 0; i < n; i++) {
+        weights[args.owner[i]] += 1.0;
+    }
+    if (plus_plus(rows, weights, k, options->seed, KMEANS_STREAM_REDUCE, picked, arena, step) != 0) {
+        return -1;
+    }
+    for (uint64_t c = 0; c < k; c++) {
+        chosen[c] = candidates[picked[c]];
+    }
+    return 0;
+}
+
+
+// ########
+// model
+// ########
+
+static void refresh_centroids(sc_kmeans_model* model) {
+    sc_convert_buffer(model->means, sc_float64, model->centroids->data, model->type, model->options.k * model->dim);
+}
+
+
+static sc_kmeans_model* seed_model(sc_point_set* set, const sc_kmeans_options* options, ccb_arena* arena, ccb_arena* step) {
+    sc_tensor* points = set->points;
+    uint64_t n = points->dims->dims[0];
+    uint64_t dim = points->dims->dims[1];
+    if (options->k == 0 || options->k > n) {
+        CCB_ERROR("k must be in [1, %" PRIu64 "], got %" PRIu64, n, options->k);
+        return NULL;
+    }
+    if (options->seeding != sc_kmeans_plus_plus && options->seeding != sc_kmeans_parallel) {
+        CCB_ERROR("Unknown k-means seeding %d", options->seeding);
+        return NULL;
+    }
+    if (options->seeding == sc_kmeans_parallel && !(options->oversampling > 0.0)) {
+        CCB_ERROR("k-means|| oversampling must be positive, got %f", options->oversampling);
+        return NULL;
+    }
+
+    sc_kmeans_model* model = (sc_kmeans_model*)ccb_arena_malloc(arena, sizeof(sc_kmeans_model));
+    CCB_NOTNULL(model, "Failed to allocate k-means model");
+    uint64_t k = options->k;
+    uint64_t dims[] = {k, dim};
+    model->options = *options;
+    model->dim = dim;
+    model->type = points->type;
+    model->means = (double*)ccb_arena_malloc(arena, k * dim * sizeof(double));
+    model->centroids = sc_create_tensor(sc_create_dimensions(2, arena, dims), points->type, arena);
+    model->counts = (uint64_t*)ccb_arena_malloc(arena, k * sizeof(uint64_t));
+    model->inertia = 0.0;
+    model->iterations = 0;
+    uint64_t* chosen = (uint64_t*)ccb_arena_malloc(arena, k * sizeof(uint64_t));
+    if (model->means == NULL || model->centroids == NULL || model->counts == NULL || chosen == NULL) {
+        CCB_ERROR("Failed to allocate k-means centroids");
+        return NULL;
+    }
+    int status = (options->seeding == sc_kmeans_parallel) ? parallel_seed(set, options, chosen, arena, step)
+                                                          : plus_plus(points, NULL, k, options->seed, KMEANS_STREAM_PLUS_PLUS, chosen, arena, step);
+    if (status != 0) {
+        CCB_ERROR("Failed to seed the k-means centroids");
+        return NULL;
+    }
+    uint64_t row_size = dim * sc_type_size(points->type);
+    for (uint64_t c = 0; c < k; c++) {
+        sc_convert_buffer((const uint8_t*)points->data + chosen[c] * row_size, points->type, model->means + c * dim, sc_float64, dim);
+    }
+    memset(model->counts, 0, k * sizeof(uint64_t));
+    refresh_centroids(model);
+    return model;
+}
+
+
+sc_kmeans_model* sc_kmeans_seed(sc_tensor* points, const sc_kmeans_options* options, ccb_arena* arena) {
+    CCB_NOTNULL(options, "options is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (check_points(points, 0, "points") != 0) {
+        return NULL;
+    }
+    sc_point_set* set = sc_point_set_create(points, arena);
+    ccb_arena* step = ccb_init_arena();
+    CCB_NOTNULL(step, "Failed to create k-means step arena");
+    sc_kmeans_model* model = (set != NULL) ? seed_model(set, options, arena, step) : NULL;
+    ccb_arena_free(step);
+    return model;
+}
+
+
+// ##################
+// centroid updates
+// ##################
+
+/*
+    every thread adds its rows to its own [k, dim] fixed point sums and [k] counts, the merge pass sums the
+    threads for a range of centroids and clears the partial sums for the next update
+*/
+struct accumulator {
+    uint64_t threads;
+    int64_t* sums;          // [threads, k, dim]
+    uint64_t* counts;       // [threads, k]
+    double* rows;           // [threads, dim] rows converted to float64
+    uint64_t* totals;       // [k] points of the last update
+};
+
+
+static struct accumulator* create_accumulator(uint64_t k, uint64_t dim, ccb_arena* arena) {
+    struct accumulator* acc = (struct accumulator*)ccb_arena_malloc(arena, sizeof(struct accumulator));
+    CCB_NOTNULL(acc, "Failed to allocate k-means accumulator");
+    acc->threads = sc_get_engine_thread_count();
+    acc->sums = (int64_t*)ccb_arena_malloc(arena, acc->threads * k * dim * sizeof(int64_t));
+    acc->counts = (uint64_t*)ccb_arena_malloc(arena, acc->threads * k * sizeof(uint64_t));
+    acc->rows = (double*)ccb_arena_malloc(arena, acc->threads * dim * sizeof(double));
+    acc->totals = (uint64_t*)ccb_arena_malloc(arena, k * sizeof(uint64_t));
+    if (acc->sums == NULL || acc->counts == NULL || acc->rows == NULL || acc->totals == NULL) {
+        CCB_ERROR("Failed to allocate k-means partial sums");
+        return NULL;
+    }
+    memset(acc->sums, 0, acc->threads * k * dim * sizeof(int64_t));
+    memset(acc->counts, 0, acc->threads * k * sizeof(uint64_t));
+    return acc;
+}
+
+
+struct update_args {
+    struct accumulator* acc;
+    const uint8_t* points;
+    sc_TYPES type;
+    uint64_t count;
+    uint64_t dim;
+    uint64_t k;
+    const uint64_t* labels;
+    double scale;               // fixed point scale of the sums
+    double* max_abs;            // [threads] scale pass
+    double* means;              // merge pass
+    const uint64_t* previous;   // merge pass: points already in the means (mini-batch), NULL to replace them
+};
+
+
+static int max_abs_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct update_args* args = (struct update_args*)raw;
+    double* row = args->acc->rows + thread_id * args->dim;
+    uint64_t row_size = args->dim * sc_type_size(args->type);
+    uint64_t last = (end * KMEANS_CHUNK_ROWS < args->count) ? end * KMEANS_CHUNK_ROWS : args->count;
+    double max_abs = args->max_abs[thread_id];
+    for (uint64_t i = start * KMEANS_CHUNK_ROWS; i < last; i++) {
+        sc_convert_buffer(args->points + i * row_size, args->type, row, sc_float64, args->dim);
+        for (uint64_t p = 0; p < args->dim; p++) {
+            max_abs = (fabs(row[p]) > max_abs) ? fabs(row[p]) : max_abs;
+        }
+    }
+    args->max_abs[thread_id] = max_abs;
+    return 0;
+}
+
+
+static int sum_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct update_args* args = (struct update_args*)raw;
+    double* row = args->acc->rows + thread_id * args->dim;
+    int64_t* sums = args->acc->sums + thread_id * args->k * args->dim;
+    uint64_t* counts = args->acc->counts + thread_id * args->k;
+    uint64_t row_size = args->dim * sc_type_size(args->type);
+    uint64_t last = (end * KMEANS_CHUNK_ROWS < args->count) ? end * KMEANS_CHUNK_ROWS : args->count;
+    for (uint64_t i = start * KMEANS_CHUNK_ROWS; i < last; i++) {
+        sc_convert_buffer(args->points + i * row_size, args->type, row, sc_float64, args->dim);
+        int64_t* sum = sums + args->labels[i] * args->dim;
+        for (uint64_t p = 0; p < args->dim; p++) {
+            sum[p] += (int64_t)llrint(row[p] * args->scale);
+        }
+        counts[args->labels[i]]++;
+    }
+    return 0;
+}
+
+
+static int merge_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct update_args* args = (struct update_args*)raw;
+    struct accumulator* acc = args->acc;
+    uint64_t dim = args->dim;
+    for (uint64_t c = start; c < end; c++) {
+        uint64_t total = 0;
+        for (uint64_t t = 0; t < acc->threads; t++) {
+            total += acc->counts[t * args->k + c];
+            acc->counts[t * args->k + c] = 0;
+        }
+        acc->totals[c] = total;
+        uint64_t previous = args->previous ? args->previous[c] : 0;
+        double* mean = args->means + c * dim;
+        for (uint64_t p = 0; p < dim; p++) {
+            int64_t sum = 0;
+            for (uint64_t t = 0; t < acc->threads; t++) {
+                sum += acc->sums[(t * args->k + c) * dim + p];
+                acc->sums[(t * args->k + c) * dim + p] = 0;
+            }
+            if (total > 0) {
+                mean[p] = (mean[p] * (double)previous + (double)sum / args->scale) / (double)(previous + total);
+            }
+        }
+    }
+    return 0;
+}
+
+
+/*
+    largest scale that keeps the sums of n points below 2^61: n |x| < 2^(e_n + e_max)
+    the rounding error of a coordinate is then below max |x| n 2^-62
+*/
+static int fixed_point_scale(struct update_args* args, ccb_arena* arena) {
+    args->max_abs = (double*)ccb_arena_malloc(arena, args->acc->threads * sizeof(double));
+    CCB_NOTNULL(args->max_abs, "Failed to allocate k-means scale buffer");
+    memset(args->max_abs, 0, args->acc->threads * sizeof(double));
+    if (sc_run_range_task(max_abs_kernel, args, chunk_count(args->count), args->count * args->dim, arena) != 0) {
+        return -1;
+    }
+    double max_abs = 0.0;
+    for (uint64_t t = 0; t < args->acc->threads; t++) {
+        max_abs = (args->max_abs[t] > max_abs) ? args->max_abs[t] : max_abs;
+    }
+    if (!isfinite(max_abs)) {
+        CCB_ERROR("k-means points must be finite");
+        return -1;
+    }
+    int e_max = 0;
+    int e_n = 0;
+    frexp(max_abs, &e_max);
+    frexp((double)args->count, &e_n);
+    args->scale = (max_abs > 0.0) ? ldexp(1.0, 61 - e_max - e_n) : 1.0;
+    return 0;
+}
+
+
+static int update_means(struct update_args* args, ccb_arena* arena) {
+    if (sc_run_range_task(sum_kernel, args, chunk_count(args->count), args->count * args->dim, arena) != 0 ||
+        sc_run_range_task(merge_kernel, args, args->k, args->k * args->dim * args->acc->threads, arena) != 0) {
+        CCB_ERROR("Failed to update the k-means centroids");
+        return -1;
+    }
+    return 0;
+}
+
+
+static double sum_distances(const sc_tensor* distances, double* d2, uint64_t n) {
+    double inertia = 0.0;
+    for (uint64_t i = 0; i < n; i++) {
+        double d = distance_at(distances, i);
+        if (d2 != NULL) {
+            d2[i] = d;
+        }
+        inertia += d;
+    }
+    return inertia;
+}
+
+
+sc_kmeans_model* sc_kmeans_fit(sc_tensor* points, const sc_kmeans_options* options, uint64_t* labels, ccb_arena* arena) {
+    CCB_NOTNULL(options, "options is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (check_points(points, 0, "points") != 0) {
+        return NULL;
+    }
+    uint64_t n = points->dims->dims[0];
+    uint64_t dim = points->dims->dims[1];
+    sc_point_set* set = sc_point_set_create(points, arena);
+    if (set == NULL) {
+        return NULL;
+    }
+    ccb_arena* step = ccb_init_arena();
+    CCB_NOTNULL(step, "Failed to create k-means step arena");
+    sc_kmeans_model* model = seed_model(set, options, arena, step);
+    if (model == NULL) {
+        ccb_arena_free(step);
+        return NULL;
+    }
+    uint64_t k = options->k;
+    labels = labels ? labels : (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    double* d2 = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    struct update_args args;
+    args.acc = create_accumulator(k, dim, arena);
+    args.points = (const uint8_t*)points->data;
+    args.type = points->type;
+    args.count = n;
+    args.dim = dim;
+    args.k = k;
+    args.labels = labels;
+    args.means = model->means;
+    args.previous = NULL;
+    if (labels == NULL || d2 == NULL || args.acc == NULL || fixed_point_scale(&args, arena) != 0) {
+        ccb_arena_free(step);
+        return NULL;
+    }
+
+    ccb_arena_reset(step);
+    sc_tensor* distances = nearest(set, model->centroids, labels, step);
+    if (distances == NULL) {
+        ccb_arena_free(step);
+        return NULL;
+    }
+    model->inertia = sum_distances(distances, d2, n);
+    while (model->iterations < options->max_iterations) {
+        if (update_means(&args, step) != 0) {
+            ccb_arena_free(step);
+            return NULL;
+        }
+        // an empty cluster takes the point farthest from its centroid (lowest index on ties)
+        for (uint64_t c = 0; c < k; c++) {
+            if (args.acc->totals[c] > 0) {
+                continue;
+            }
+            uint64_t far = 0;
+            for (uint64_t i = 1; i < n; i++) {
+                far = (d2[i] > d2[far]) ? i : far;
+            }
+            if (!(d2[far] > 0.0)) {
+                break;
+            }
+            sc_convert_buffer(args.points + far * dim * sc_type_size(args.type), args.type, model->means + c * dim, sc_float64, dim);
+            d2[far] = 0.0;
+        }
+        refresh_centroids(model);
+        model->iterations++;
+
+        double previous = model->inertia;
+        ccb_arena_reset(step);
+        distances = nearest(set, model->centroids, labels, step);
+        if (distances == NULL) {
+            ccb_arena_free(step);
+            return NULL;
+        }
+        model->inertia = sum_distances(distances, d2, n);
+        if (previous - model->inertia <= options->tolerance * model->inertia) {
+            break;
+        }
+    }
+    memset(model->counts, 0, k * sizeof(uint64_t));
+    for (uint64_t i = 0; i < n; i++) {
+        model->counts[labels[i]]++;
+    }
+    ccb_arena_free(step);
+    return model;
+}
+
+
+int sc_kmeans_assign(sc_kmeans_model* model, sc_tensor* points, uint64_t* labels, double* inertia, ccb_arena* arena) {
+    CCB_NOTNULL(model, "model is NULL");
+    CCB_NOTNULL(labels, "labels is NULL");
+    if (check_points(points, model->dim, "points") != 0) {
+        return -1;
+    }
+    if (points->type != model->type) {
+        CCB_ERROR("points must have the type of the model (%d), got %d", model->type, points->type);
+        return -1;
+    }
+    sc_point_set* set = sc_point_set_create(points, arena);
+    sc_tensor* distances = (set != NULL) ? nearest(set, model->centroids, labels, arena) : NULL;
+    if (distances == NULL) {
+        return -1;
+    }
+    if (inertia != NULL) {
+        *inertia = sum_distances(distances, NULL, points->dims->dims[0]);
+    }
+    return 0;
+}
+
+
+int sc_kmeans_partial_fit(sc_kmeans_model* model, sc_tensor* batch, ccb_arena* arena) {
+    CCB_NOTNULL(model, "model is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (check_points(batch, model->dim, "batch") != 0) {
+        return -1;
+    }
+    if (batch->type != model->type) {
+        CCB_ERROR("batch must have the type of the model (%d), got %d", model->type, batch->type);
+        return -1;
+    }
+    uint64_t n = batch->dims->dims[0];
+    uint64_t k = model->options.k;
+    struct update_args args;
+    args.acc = create_accumulator(k, model->dim, arena);
+    args.points = (const uint8_t*)batch->data;
+    args.type = batch->type;
+    args.count = n;
+    args.dim = model->dim;
+    args.k = k;
+    args.labels = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    args.means = model->means;
+    args.previous = model->counts;
+    double inertia = 0.0;
+    if (args.acc == NULL || args.labels == NULL || fixed_point_scale(&args, arena) != 0 ||
+        sc_kmeans_assign(model, batch, (uint64_t*)args.labels, &inertia, arena) != 0 || update_means(&args, arena) != 0) {
+        return -1;
+    }
+    for (uint64_t c = 0; c < k; c++) {
+        model->counts[c] += args.acc->totals[c];
+    }
+    refresh_centroids(model);
+    model->inertia = inertia;
+    model->iterations++;
+    return 0;
+}
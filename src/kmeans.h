@@ -0,0 +1,75 @@
+#ifndef __KMEANS_H__
+#define __KMEANS_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    k-means clustering of [n, dim] point tensors (bfloat16, float32 or float64)
+    the assignment step is the gemm top 1 of the distance module, the centroid update accumulates per thread
+    partial sums merged without locks by a second pass over the [k, dim] sums
+    the sums are fixed point int64 (scaled from the largest coordinate), their total does not depend on the
+    order of the additions, so a fit only depends on the seed and not on the thread count
+    the seeding draws come from Philox streams keyed by the seed
+    the centroids are kept in float64 and rounded to the type of the points for the assignments
+*/
+
+typedef enum {
+    sc_kmeans_plus_plus,        // k-means++: k draws proportional to the squared distance to the chosen centroids
+    sc_kmeans_parallel,         // k-means||: a few rounds of oversampled draws, reduced with a weighted k-means++
+} sc_kmeans_seeding;
+
+typedef struct {
+    uint64_t k;
+    sc_kmeans_seeding seeding;
+    uint64_t max_iterations;    // Lloyd iterations
+    double tolerance;           // stops when an iteration lowers the inertia by less than tolerance * inertia
+    uint64_t rounds;            // k-means|| sampling rounds
+    double oversampling;        // k-means|| expected draws per round, in multiples of k
+    uint64_t seed;
+} sc_kmeans_options;
+
+typedef struct {
+    sc_kmeans_options options;
+    uint64_t dim;
+    sc_TYPES type;              // of the points
+    double* means;              // [k, dim] float64 centroids
+    sc_tensor* centroids;       // [k, dim] means rounded to the type of the points
+    uint64_t* counts;           // [k] points of the last assignment (points seen for the mini-batch updates)
+    double inertia;             // sum of the squared distances of the points to their centroid
+    uint64_t iterations;        // Lloyd iterations or mini-batch updates done
+} sc_kmeans_model;
+
+
+/* Default options: k-means|| (2 rounds, oversampling 2), 100 iterations, tolerance 1e-4, seed 0 */
+sc_kmeans_options sc_kmeans_default_options(uint64_t k);
+/* Seeds the centroids without running Lloyd iterations (starting point of the mini-batch updates)
+   - sc_tensor* points: [n, dim] points, n >= k
+   - const sc_kmeans_options* options: options of the model, k >= 1
+   - ccb_arena* arena: arena where the model will be allocated
+   - return: a pointer to the model, NULL on error
+*/
+sc_kmeans_model* sc_kmeans_seed(sc_tensor* points, const sc_kmeans_options* options, ccb_arena* arena);
+/* Seeds the centroids then runs Lloyd iterations until convergence
+   - uint64_t* labels: [n] centroid of every point for the final centroids, can be NULL
+   - return: a pointer to the model, NULL on error
+*/
+sc_kmeans_model* sc_kmeans_fit(sc_tensor* points, const sc_kmeans_options* options, uint64_t* labels, ccb_arena* arena);
+/* Nearest centroid of every point
+   - sc_tensor* points: [n, dim] points of the type of the model
+   - uint64_t* labels: [n] centroid indices
+   - double* inertia: sum of the squared distances to the nearest centroids, can be NULL
+   - return: 0 on success
+*/
+int sc_kmeans_assign(sc_kmeans_model* model, sc_tensor* points, uint64_t* labels, double* inertia, ccb_arena* arena);
+/* Mini-batch update: every centroid moves to the mean of the points it has seen, the inertia of the model is the
+   one of the batch before the update
+   - sc_tensor* batch: [b, dim] points of the type of the model
+   - ccb_arena* arena: scratch of the update, it can be reset after the call
+   - return: 0 on success
+*/
+int sc_kmeans_partial_fit(sc_kmeans_model* model, sc_tensor* batch, ccb_arena* arena);
+
+
+#endif // __KMEANS_H__
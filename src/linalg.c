@@ -1,6 +1,8 @@
 #include "data.h"
 #include "linalg.h"
 #include "sc_engine.h"
+#include "sc_gemm.h"
+#include "sc_simd.h"
 #include "const.h"
 #include "ccbase/logs/log.h"
 
@@ -31,8 +33,16 @@ sc_vector* sc_for_each_vector_op(sc_vector* a, sc_vector* b, sc_value_t (*func)(
         return NULL;
     }
     if (a->type != b->type) {
-        CCB_ERROR("Vector type mismatch: %d vs %d", a->type, b->type);
-        return NULL;
+        // promoted type, the operands are converted chunk by chunk
+        sc_TYPES type = sc_promote_types(a->type, b->type);
+        sc_vector* result = sc_create_vector(a->size, type, arena);
+        CCB_NOTNULL(result, "Failed to create result vector");
+
+        if (sc_run_mixed_element_wise_task(a->data, a->type, b->data, b->type, (sc_value_t){0}, result->data, type, func, a->size, arena) != 0) {
+            CCB_ERROR("Failed to execute mixed vector operation task");
+            return NULL;
+        }
+        return result;
     }
 
     sc_vector* result = sc_create_vector(a->size, a->type, arena);
@@ -59,8 +69,18 @@ sc_vector* sc_for_each_vector_op_inplace(sc_vector* a, sc_vector* b, sc_value_t
     }
     
     if (a->type != b->type) {
-        CCB_ERROR("Vector type mismatch: %d vs %d", a->type, b->type);
-        return NULL;
+        if (sc_promote_types(a->type, b->type) != a->type) {
+            CCB_ERROR("Vector type mismatch: %d can not hold the promoted type %d", a->type, sc_promote_types(a->type, b->type));
+            return NULL;
+        }
+
+        int status = sc_run_mixed_element_wise_task(a->data, a->type, b->data, b->type, (sc_value_t){0}, a->data, a->type, func, a->size, local_arena);
+        ccb_arena_reset(local_arena);
+        if (status != 0) {
+            CCB_ERROR("Failed to execute mixed vector operation task");
+            return NULL;
+        }
+        return a;
     }
 
     sc_vector* result = a;
@@ -82,8 +102,19 @@ sc_vector* sc_for_each_vector_op_inplace(sc_vector* a, sc_vector* b, sc_value_t
 
 sc_vector* sc_for_each_vector_scalar_op(sc_vector* a, sc_value_t b, sc_value_t (*func)(sc_value_t, sc_value_t), ccb_arena* arena) {
     if (a->type != b.type) {
-        CCB_ERROR("Vector and scalar type mismatch: %d vs %d", a->type, b.type);
-        return NULL;
+        sc_TYPES type = sc_promote_types(a->type, b.type);
+        if (type == a->type) {
+            b = sc_value_as(b, type);
+        } else {
+            sc_vector* result = sc_create_vector(a->size, type, arena);
+            CCB_NOTNULL(result, "Failed to create result vector");
+
+            if (sc_run_mixed_element_wise_task(a->data, a->type, NULL, type, b, result->data, type, func, a->size, arena) != 0) {
+                CCB_ERROR("Failed to execute mixed vector operation task");
+                return NULL;
+            }
+            return result;
+        }
     }
     sc_vector* result = sc_create_vector(a->size, a->type, arena);
     CCB_NOTNULL(result, "Failed to create result vector");
@@ -105,8 +136,11 @@ sc_vector* sc_for_each_vector_scalar_op_inplace(sc_vector* a, sc_value_t b, sc_v
     init_tmp_arena();
 
     if (a->type != b.type) {
-        CCB_ERROR("Vector and scalar type mismatch: %d vs %d", a->type, b.type);
-        return NULL;
+        if (sc_promote_types(a->type, b.type) != a->type) {
+            CCB_ERROR("Vector and scalar type mismatch: %d can not hold the promoted type %d", a->type, sc_promote_types(a->type, b.type));
+            return NULL;
+        }
+        b = sc_value_as(b, a->type);
     }
     sc_vector* result = a;
     CCB_NOTNULL(result, "Failed to create result vector");
@@ -128,6 +162,46 @@ sc_vector* sc_for_each_vector_scalar_op_inplace(sc_vector* a, sc_value_t b, sc_v
 }
 
 
+// ternary ops, b and c are NULL for the broadcast scalars (converted to the type of a)
+static sc_vector* ternary_op(sc_vector* a, sc_vector* b, sc_value_t b_scalar, sc_vector* c, sc_value_t c_scalar, sc_value_t* c_scale,
+                             sc_vector* out, sc_value_t (*func)(sc_value_t, sc_value_t, sc_value_t), ccb_arena* arena) {
+    if ((b && b->size != a->size) || (c && c->size != a->size) || out->size != a->size) {
+        CCB_ERROR("Vector size mismatch: %u, %u and %u", a->size, b ? b->size : a->size, c ? c->size : a->size);
+        return NULL;
+    }
+    if ((b && b->type != a->type) || (c && c->type != a->type) || out->type != a->type) {
+        CCB_ERROR("Vector type mismatch: %d, %d and %d", a->type, b ? b->type : a->type, c ? c->type : a->type);
+        return NULL;
+    }
+
+    sc_value_t scale = c_scale ? sc_value_as(*c_scale, a->type) : (sc_value_t){0};
+    sc_ternary_operands operands = {c, sc_value_as(b_scalar, a->type), sc_value_as(c_scalar, a->type), c_scale ? &scale : NULL};
+    sc_task* task = sc_create_vector_ternary_task(a, b, &operands, out, func, a->size, arena);
+
+    sc_task_result result;
+    sc_execute_task(task, sc_select_execution_mode(a->size), &result, arena);
+
+    if (!result.succes) {
+        CCB_ERROR("Failed to execute ternary vector operation task");
+        return NULL;
+    }
+    return out;
+}
+
+sc_vector* sc_for_each_vector_ternary_op(sc_vector* a, sc_vector* b, sc_vector* c, sc_value_t (*func)(sc_value_t, sc_value_t, sc_value_t), ccb_arena* arena) {
+    sc_vector* out = sc_create_vector(a->size, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create result vector");
+    return ternary_op(a, b, (sc_value_t){0}, c, (sc_value_t){0}, NULL, out, func, arena);
+}
+
+sc_vector* sc_for_each_vector_ternary_op_inplace(sc_vector* a, sc_vector* b, sc_vector* c, sc_value_t (*func)(sc_value_t, sc_value_t, sc_value_t)) {
+    init_tmp_arena();
+    sc_vector* out = ternary_op(a, b, (sc_value_t){0}, c, (sc_value_t){0}, NULL, a, func, local_arena);
+    ccb_arena_reset(local_arena);
+    return out;
+}
+
+
 sc_value_t sc_vector_reduce(sc_vector* a, sc_value_t (*func)(sc_value_t, sc_value_t), sc_value_t initial) {
     init_tmp_arena();
 
@@ -229,6 +303,24 @@ sc_vector* sc_vector_map_args_inplace(sc_vector* a, sc_value_t (*func)(sc_value_
 // #################
 // Scalar operations
 // #################
+
+// the engine widens sc_half elements to float32, the scalar argument follows the element type
+static inline sc_value_t args_value(sc_value_t a, void* args) {
+    sc_value_t b = *(sc_value_t*)args;
+    return (b.type == a.type) ? b : sc_value_as(b, a.type);
+}
+
+// integer division truncates, a division by zero gives 0 and min / -1 wraps around to min
+static inline int64_t int_div(int64_t a, int64_t b, int64_t min) {
+    if (b == 0) {
+        return 0;
+    }
+    if (b == -1 && a == min) {
+        return min;
+    }
+    return a / b;
+}
+
 sc_value_t sc_scalar_add(sc_value_t a, sc_value_t b) {
     if (a.type != b.type) {
         CCB_ERROR("Value type mismatch: %d vs %d", a.type, b.type);
@@ -238,10 +330,18 @@ sc_value_t sc_scalar_add(sc_value_t a, sc_value_t b) {
     switch (a.type) {
         case sc_float16:
             return (sc_value_t){.type=sc_float16, .value.f16 = a.value.f16 + b.value.f16};
+        case sc_half:
+            return (sc_value_t){.type=sc_half, .value.half = sc_f32_to_half_bits(sc_half_bits_to_f32(a.value.half) + sc_half_bits_to_f32(b.value.half))};
         case sc_float32:
             return (sc_value_t){.type=sc_float32, .value.f32 = a.value.f32 + b.value.f32};
         case sc_float64:
             return (sc_value_t){.type=sc_float64, .value.f64 = a.value.f64 + b.value.f64};
+        case sc_int32:
+            return (sc_value_t){.type=sc_int32, .value.i32 = (int32_t)((uint32_t)a.value.i32 + (uint32_t)b.value.i32)};
+        case sc_int64:
+            return (sc_value_t){.type=sc_int64, .value.i64 = (int64_t)((uint64_t)a.value.i64 + (uint64_t)b.value.i64)};
+        case sc_uint8:
+            return (sc_value_t){.type=sc_uint8, .value.u8 = (a.value.u8 > UINT8_MAX - b.value.u8) ? UINT8_MAX : a.value.u8 + b.value.u8};
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", a.type);
             return (sc_value_t){0};
@@ -250,7 +350,7 @@ sc_value_t sc_scalar_add(sc_value_t a, sc_value_t b) {
 
 sc_value_t sc_scalar_add_args(sc_value_t a, void* args) {
     CCB_NOTNULL(args, "b is NULL");
-    return sc_scalar_add(a, *(sc_value_t*)args);
+    return sc_scalar_add(a, args_value(a, args));
 }
 
 
@@ -263,10 +363,18 @@ sc_value_t sc_scalar_sub(sc_value_t a, sc_value_t b) {
     switch (a.type) {
         case sc_float16:
             return (sc_value_t){.type=sc_float16, .value.f16 = a.value.f16 - b.value.f16};
+        case sc_half:
+            return (sc_value_t){.type=sc_half, .value.half = sc_f32_to_half_bits(sc_half_bits_to_f32(a.value.half) - sc_half_bits_to_f32(b.value.half))};
         case sc_float32:
             return (sc_value_t){.type=sc_float32, .value.f32 = a.value.f32 - b.value.f32};
         case sc_float64:
             return (sc_value_t){.type=sc_float64, .value.f64 = a.value.f64 - b.value.f64};
+        case sc_int32:
+            return (sc_value_t){.type=sc_int32, .value.i32 = (int32_t)((uint32_t)a.value.i32 - (uint32_t)b.value.i32)};
+        case sc_int64:
+            return (sc_value_t){.type=sc_int64, .value.i64 = (int64_t)((uint64_t)a.value.i64 - (uint64_t)b.value.i64)};
+        case sc_uint8:
+            return (sc_value_t){.type=sc_uint8, .value.u8 = (a.value.u8 > b.value.u8) ? a.value.u8 - b.value.u8 : 0};
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", a.type);
             return (sc_value_t){0};
@@ -275,7 +383,7 @@ sc_value_t sc_scalar_sub(sc_value_t a, sc_value_t b) {
 
 sc_value_t sc_scalar_sub_args(sc_value_t a, void* args) {
     CCB_NOTNULL(args, "b is NULL");
-    return sc_scalar_sub(a, *(sc_value_t*)args);
+    return sc_scalar_sub(a, args_value(a, args));
 }
 
 
@@ -288,10 +396,18 @@ sc_value_t sc_scalar_mul(sc_value_t a, sc_value_t b) {
     switch (a.type) {
         case sc_float16:
             return (sc_value_t){.type=sc_float16, .value.f16 = a.value.f16 * b.value.f16};
+        case sc_half:
+            return (sc_value_t){.type=sc_half, .value.half = sc_f32_to_half_bits(sc_half_bits_to_f32(a.value.half) * sc_half_bits_to_f32(b.value.half))};
         case sc_float32:
             return (sc_value_t){.type=sc_float32, .value.f32 = a.value.f32 * b.value.f32};
         case sc_float64:
             return (sc_value_t){.type=sc_float64, .value.f64 = a.value.f64 * b.value.f64};
+        case sc_int32:
+            return (sc_value_t){.type=sc_int32, .value.i32 = (int32_t)((uint32_t)a.value.i32 * (uint32_t)b.value.i32)};
+        case sc_int64:
+            return (sc_value_t){.type=sc_int64, .value.i64 = (int64_t)((uint64_t)a.value.i64 * (uint64_t)b.value.i64)};
+        case sc_uint8:
+            return (sc_value_t){.type=sc_uint8, .value.u8 = (a.value.u8 * b.value.u8 > UINT8_MAX) ? UINT8_MAX : a.value.u8 * b.value.u8};
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", a.type);
             return (sc_value_t){0};
@@ -300,7 +416,7 @@ sc_value_t sc_scalar_mul(sc_value_t a, sc_value_t b) {
 
 sc_value_t sc_scalar_mul_args(sc_value_t a, void* args) {
     CCB_NOTNULL(args, "b is NULL");
-    return sc_scalar_mul(a, *(sc_value_t*)args);
+    return sc_scalar_mul(a, args_value(a, args));
 }
 
 
@@ -313,10 +429,18 @@ sc_value_t sc_scalar_div(sc_value_t a, sc_value_t b) {
     switch (a.type) {
         case sc_float16:
             return (sc_value_t){.type=sc_float16, .value.f16 = a.value.f16 / b.value.f16};
+        case sc_half:
+            return (sc_value_t){.type=sc_half, .value.half = sc_f32_to_half_bits(sc_half_bits_to_f32(a.value.half) / sc_half_bits_to_f32(b.value.half))};
         case sc_float32:
             return (sc_value_t){.type=sc_float32, .value.f32 = a.value.f32 / b.value.f32};
         case sc_float64:
             return (sc_value_t){.type=sc_float64, .value.f64 = a.value.f64 / b.value.f64};
+        case sc_int32:
+            return (sc_value_t){.type=sc_int32, .value.i32 = (int32_t)int_div(a.value.i32, b.value.i32, INT32_MIN)};
+        case sc_int64:
+            return (sc_value_t){.type=sc_int64, .value.i64 = int_div(a.value.i64, b.value.i64, INT64_MIN)};
+        case sc_uint8:
+            return (sc_value_t){.type=sc_uint8, .value.u8 = (b.value.u8 == 0) ? 0 : a.value.u8 / b.value.u8};
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", a.type);
             return (sc_value_t){0};
@@ -325,7 +449,7 @@ sc_value_t sc_scalar_div(sc_value_t a, sc_value_t b) {
 
 sc_value_t sc_scalar_div_args(sc_value_t a, void* args) {
     CCB_NOTNULL(args, "b is NULL");
-    return sc_scalar_div(a, *(sc_value_t*)args);
+    return sc_scalar_div(a, args_value(a, args));
 }
 
 
@@ -333,10 +457,18 @@ sc_value_t sc_scalar_abs(sc_value_t a) {
     switch (a.type) {
         case sc_float16:
             return (sc_value_t){.type=sc_float16, .value.f16 = (float)fabsf((float)a.value.f16)};
+        case sc_half:
+            return (sc_value_t){.type=sc_half, .value.half = (uint16_t)(a.value.half & 0x7fff)};
         case sc_float32:
             return (sc_value_t){.type=sc_float32, .value.f32 = fabsf(a.value.f32)};
         case sc_float64:
             return (sc_value_t){.type=sc_float64, .value.f64 = fabs(a.value.f64)};
+        case sc_int32:
+            return (sc_value_t){.type=sc_int32, .value.i32 = (a.value.i32 < 0) ? (int32_t)(0u - (uint32_t)a.value.i32) : a.value.i32};
+        case sc_int64:
+            return (sc_value_t){.type=sc_int64, .value.i64 = (a.value.i64 < 0) ? (int64_t)(0ull - (uint64_t)a.value.i64) : a.value.i64};
+        case sc_uint8:
+            return a;
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", a.type);
             return (sc_value_t){0};
@@ -353,10 +485,16 @@ sc_value_t sc_scalar_pow(sc_value_t a, sc_value_t b) {
     switch (a.type) {
         case sc_float16:
             return (sc_value_t){.type=sc_float16, .value.f16 = powf((float)a.value.f16, (float)b.value.f16)};
+        case sc_half:
+            return (sc_value_t){.type=sc_half, .value.half = sc_f32_to_half_bits(powf(sc_half_bits_to_f32(a.value.half), sc_half_bits_to_f32(b.value.half)))};
         case sc_float32:
             return (sc_value_t){.type=sc_float32, .value.f32 = powf(a.value.f32, b.value.f32)};
         case sc_float64:
             return (sc_value_t){.type=sc_float64, .value.f64 = pow(a.value.f64, b.value.f64)};
+        case sc_int32:
+        case sc_int64:
+        case sc_uint8:
+            return to_sc_value(pow(sc_value_to_f64(a), sc_value_to_f64(b)), a.type);
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", a.type);
             return (sc_value_t){0};
@@ -365,7 +503,7 @@ sc_value_t sc_scalar_pow(sc_value_t a, sc_value_t b) {
 
 sc_value_t sc_scalar_pow_args(sc_value_t a, void* args) {
     CCB_NOTNULL(args, "b is NULL");
-    return sc_scalar_pow(a, *(sc_value_t*)args);
+    return sc_scalar_pow(a, args_value(a, args));
 }
 
 
@@ -378,10 +516,16 @@ sc_value_t sc_scalar_root(sc_value_t a, sc_value_t b) {
     switch (a.type) {
         case sc_float16:
             return (sc_value_t){.type=sc_float16, .value.f16 = powf((float)a.value.f16, 1.0/(float)b.value.f16)};
+        case sc_half:
+            return (sc_value_t){.type=sc_half, .value.half = sc_f32_to_half_bits(powf(sc_half_bits_to_f32(a.value.half), 1.0/sc_half_bits_to_f32(b.value.half)))};
         case sc_float32:
             return (sc_value_t){.type=sc_float32, .value.f32 = powf(a.value.f32, 1.0/b.value.f32)};
         case sc_float64:
             return (sc_value_t){.type=sc_float64, .value.f64 = pow(a.value.f64, 1.0/b.value.f64)};
+        case sc_int32:
+        case sc_int64:
+        case sc_uint8:
+            return to_sc_value(pow(sc_value_to_f64(a), 1.0 / sc_value_to_f64(b)), a.type);
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", a.type);
             return (sc_value_t){0};
@@ -390,9 +534,153 @@ sc_value_t sc_scalar_root(sc_value_t a, sc_value_t b) {
 
 sc_value_t sc_scalar_root_args(sc_value_t a, void* args) {
     CCB_NOTNULL(args, "b is NULL");
-    return sc_scalar_root(a, *(sc_value_t*)args);
+    return sc_scalar_root(a, args_value(a, args));
+}
+
+
+sc_value_t sc_scalar_and(sc_value_t a, sc_value_t b) {
+    if (a.type != b.type) {
+        CCB_ERROR("Value type mismatch: %d vs %d", a.type, b.type);
+        return (sc_value_t){0};
+    }
+
+    switch (a.type) {
+        case sc_int32:
+            return (sc_value_t){.type=sc_int32, .value.i32 = a.value.i32 & b.value.i32};
+        case sc_int64:
+            return (sc_value_t){.type=sc_int64, .value.i64 = a.value.i64 & b.value.i64};
+        case sc_uint8:
+            return (sc_value_t){.type=sc_uint8, .value.u8 = a.value.u8 & b.value.u8};
+        default:
+            CCB_ERROR("Bitwise operations need an integer type, got %d", a.type);
+            return (sc_value_t){0};
+    }
+}
+
+
+sc_value_t sc_scalar_or(sc_value_t a, sc_value_t b) {
+    if (a.type != b.type) {
+        CCB_ERROR("Value type mismatch: %d vs %d", a.type, b.type);
+        return (sc_value_t){0};
+    }
+
+    switch (a.type) {
+        case sc_int32:
+            return (sc_value_t){.type=sc_int32, .value.i32 = a.value.i32 | b.value.i32};
+        case sc_int64:
+            return (sc_value_t){.type=sc_int64, .value.i64 = a.value.i64 | b.value.i64};
+        case sc_uint8:
+            return (sc_value_t){.type=sc_uint8, .value.u8 = a.value.u8 | b.value.u8};
+        default:
+            CCB_ERROR("Bitwise operations need an integer type, got %d", a.type);
+            return (sc_value_t){0};
+    }
+}
+
+
+sc_value_t sc_scalar_xor(sc_value_t a, sc_value_t b) {
+    if (a.type != b.type) {
+        CCB_ERROR("Value type mismatch: %d vs %d", a.type, b.type);
+        return (sc_value_t){0};
+    }
+
+    switch (a.type) {
+        case sc_int32:
+            return (sc_value_t){.type=sc_int32, .value.i32 = a.value.i32 ^ b.value.i32};
+        case sc_int64:
+            return (sc_value_t){.type=sc_int64, .value.i64 = a.value.i64 ^ b.value.i64};
+        case sc_uint8:
+            return (sc_value_t){.type=sc_uint8, .value.u8 = a.value.u8 ^ b.value.u8};
+        default:
+            CCB_ERROR("Bitwise operations need an integer type, got %d", a.type);
+            return (sc_value_t){0};
+    }
 }
 
+sc_value_t sc_scalar_not(sc_value_t a) {
+    switch (a.type) {
+        case sc_int32:
+            return (sc_value_t){.type=sc_int32, .value.i32 = ~a.value.i32};
+        case sc_int64:
+            return (sc_value_t){.type=sc_int64, .value.i64 = ~a.value.i64};
+        case sc_uint8:
+            return (sc_value_t){.type=sc_uint8, .value.u8 = (uint8_t)~a.value.u8};
+        default:
+            CCB_ERROR("Bitwise operations need an integer type, got %d", a.type);
+            return (sc_value_t){0};
+    }
+}
+
+
+
+sc_value_t sc_scalar_fma(sc_value_t a, sc_value_t b, sc_value_t c) {
+    if (a.type != b.type || a.type != c.type) {
+        CCB_ERROR("Value type mismatch: %d, %d and %d", a.type, b.type, c.type);
+        return (sc_value_t){0};
+    }
+
+    switch (a.type) {
+        case sc_float16:
+            return (sc_value_t){.type=sc_float16, .value.f16 = fmaf((float)a.value.f16, (float)b.value.f16, (float)c.value.f16)};
+        case sc_half:
+            return (sc_value_t){.type=sc_half, .value.half = sc_f32_to_half_bits(fmaf(sc_half_bits_to_f32(a.value.half), sc_half_bits_to_f32(b.value.half), sc_half_bits_to_f32(c.value.half)))};
+        case sc_float32:
+            return (sc_value_t){.type=sc_float32, .value.f32 = fmaf(a.value.f32, b.value.f32, c.value.f32)};
+        case sc_float64:
+            return (sc_value_t){.type=sc_float64, .value.f64 = fma(a.value.f64, b.value.f64, c.value.f64)};
+        case sc_int32:
+        case sc_int64:
+        case sc_uint8:
+            return sc_scalar_add(sc_scalar_mul(a, b), c);
+        default:
+            CCB_ERROR("Unsupported sc_TYPES value %d", a.type);
+            return (sc_value_t){0};
+    }
+}
+
+sc_value_t sc_scalar_lerp(sc_value_t a, sc_value_t b, sc_value_t t) {
+    if (a.type != b.type || a.type != t.type) {
+        CCB_ERROR("Value type mismatch: %d, %d and %d", a.type, b.type, t.type);
+        return (sc_value_t){0};
+    }
+
+    switch (a.type) {
+        case sc_float32:
+            return (sc_value_t){.type=sc_float32, .value.f32 = fmaf(t.value.f32, b.value.f32 - a.value.f32, a.value.f32)};
+        case sc_float64:
+            return (sc_value_t){.type=sc_float64, .value.f64 = fma(t.value.f64, b.value.f64 - a.value.f64, a.value.f64)};
+        case sc_float16:
+        case sc_half: {
+            float x = sc_value_to_f32(a);
+            return to_sc_value(fmaf(sc_value_to_f32(t), sc_value_to_f32(b) - x, x), a.type);
+        }
+        case sc_int32:
+        case sc_int64:
+        case sc_uint8: {
+            double x = sc_value_to_f64(a);
+            return to_sc_value(x + sc_value_to_f64(t) * (sc_value_to_f64(b) - x), a.type);
+        }
+        default:
+            CCB_ERROR("Unsupported sc_TYPES value %d", a.type);
+            return (sc_value_t){0};
+    }
+}
+
+sc_value_t sc_scalar_clamp(sc_value_t x, sc_value_t lo, sc_value_t hi) {
+    if (x.type != lo.type || x.type != hi.type) {
+        CCB_ERROR("Value type mismatch: %d, %d and %d", x.type, lo.type, hi.type);
+        return (sc_value_t){0};
+    }
+
+    // min(hi, max(lo, x)) with NaN going through unchanged, like the SIMD kernels
+    sc_value_t out = x;
+    if (sc_type_is_integer(x.type)) {
+        out = (sc_value_to_i64(out) < sc_value_to_i64(lo)) ? lo : out;
+        return (sc_value_to_i64(out) > sc_value_to_i64(hi)) ? hi : out;
+    }
+    out = (sc_value_to_f64(out) < sc_value_to_f64(lo)) ? lo : out;
+    return (sc_value_to_f64(out) > sc_value_to_f64(hi)) ? hi : out;
+}
 
 
 
@@ -493,6 +781,120 @@ sc_vector* sc_vector_div_scalar_inplace(sc_vector* a, sc_value_t b) {
     return sc_for_each_vector_scalar_op_inplace(a, b, sc_scalar_div);
 }
 
+// and
+sc_vector* sc_vector_and(sc_vector* a, sc_vector* b, ccb_arena* arena) {
+    return sc_for_each_vector_op(a, b, sc_scalar_and, arena);
+}
+
+sc_vector* sc_vector_and_inplace(sc_vector* a, sc_vector* b) {
+    return sc_for_each_vector_op_inplace(a, b, sc_scalar_and);
+}
+
+// or
+sc_vector* sc_vector_or(sc_vector* a, sc_vector* b, ccb_arena* arena) {
+    return sc_for_each_vector_op(a, b, sc_scalar_or, arena);
+}
+
+sc_vector* sc_vector_or_inplace(sc_vector* a, sc_vector* b) {
+    return sc_for_each_vector_op_inplace(a, b, sc_scalar_or);
+}
+
+// xor
+sc_vector* sc_vector_xor(sc_vector* a, sc_vector* b, ccb_arena* arena) {
+    return sc_for_each_vector_op(a, b, sc_scalar_xor, arena);
+}
+
+sc_vector* sc_vector_xor_inplace(sc_vector* a, sc_vector* b) {
+    return sc_for_each_vector_op_inplace(a, b, sc_scalar_xor);
+}
+
+// not
+sc_vector* sc_vector_not(sc_vector* a, ccb_arena* arena) {
+    return sc_vector_map(a, sc_scalar_not, arena);
+}
+
+sc_vector* sc_vector_not_inplace(sc_vector* a) {
+    return sc_vector_map_inplace(a, sc_scalar_not);
+}
+
+// fused ops (BLAS level 1), one pass through the ternary engine op
+sc_vector* sc_vector_fma(sc_vector* a, sc_vector* b, sc_vector* c, ccb_arena* arena) {
+    return sc_for_each_vector_ternary_op(a, b, c, sc_scalar_fma, arena);
+}
+
+static sc_vector* axpby(sc_value_t alpha, sc_vector* x, sc_value_t beta, sc_vector* y, sc_vector* out, ccb_arena* arena) {
+    // beta = 0 does not read y (its NaN are not propagated), beta = 1 is a plain axpy
+    double beta_value = sc_value_to_f64(beta);
+    if (beta_value == 0.0) {
+        if (y->size != x->size) {
+            CCB_ERROR("Vector size mismatch: %u vs %u", x->size, y->size);
+            return NULL;
+        }
+        return ternary_op(x, NULL, alpha, NULL, to_sc_value(0.0, x->type), NULL, out, sc_scalar_fma, arena);
+    }
+    return ternary_op(x, NULL, alpha, y, (sc_value_t){0}, (beta_value == 1.0) ? NULL : &beta, out, sc_scalar_fma, arena);
+}
+
+sc_vector* sc_vector_axpy(sc_value_t alpha, sc_vector* x, sc_vector* y, ccb_arena* arena) {
+    sc_vector* out = sc_create_vector(x->size, x->type, arena);
+    CCB_NOTNULL(out, "Failed to create result vector");
+    return ternary_op(x, NULL, alpha, y, (sc_value_t){0}, NULL, out, sc_scalar_fma, arena);
+}
+
+sc_vector* sc_vector_axpy_inplace(sc_value_t alpha, sc_vector* x, sc_vector* y) {
+    init_tmp_arena();
+    sc_vector* out = ternary_op(x, NULL, alpha, y, (sc_value_t){0}, NULL, y, sc_scalar_fma, local_arena);
+    ccb_arena_reset(local_arena);
+    return out;
+}
+
+sc_vector* sc_vector_axpby(sc_value_t alpha, sc_vector* x, sc_value_t beta, sc_vector* y, ccb_arena* arena) {
+    sc_vector* out = sc_create_vector(x->size, x->type, arena);
+    CCB_NOTNULL(out, "Failed to create result vector");
+    return axpby(alpha, x, beta, y, out, arena);
+}
+
+sc_vector* sc_vector_axpby_inplace(sc_value_t alpha, sc_vector* x, sc_value_t beta, sc_vector* y) {
+    init_tmp_arena();
+    sc_vector* out = axpby(alpha, x, beta, y, y, local_arena);
+    ccb_arena_reset(local_arena);
+    return out;
+}
+
+sc_vector* sc_vector_scal(sc_value_t alpha, sc_vector* x, ccb_arena* arena) {
+    return sc_for_each_vector_scalar_op(x, alpha, sc_scalar_mul, arena);
+}
+
+sc_vector* sc_vector_scal_inplace(sc_value_t alpha, sc_vector* x) {
+    return sc_for_each_vector_scalar_op_inplace(x, alpha, sc_scalar_mul);
+}
+
+sc_vector* sc_vector_lerp(sc_vector* a, sc_vector* b, sc_value_t t, ccb_arena* arena) {
+    sc_vector* out = sc_create_vector(a->size, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create result vector");
+    return ternary_op(a, b, (sc_value_t){0}, NULL, t, NULL, out, sc_scalar_lerp, arena);
+}
+
+sc_vector* sc_vector_lerp_inplace(sc_vector* a, sc_vector* b, sc_value_t t) {
+    init_tmp_arena();
+    sc_vector* out = ternary_op(a, b, (sc_value_t){0}, NULL, t, NULL, a, sc_scalar_lerp, local_arena);
+    ccb_arena_reset(local_arena);
+    return out;
+}
+
+sc_vector* sc_vector_clamp(sc_vector* x, sc_value_t lo, sc_value_t hi, ccb_arena* arena) {
+    sc_vector* out = sc_create_vector(x->size, x->type, arena);
+    CCB_NOTNULL(out, "Failed to create result vector");
+    return ternary_op(x, NULL, lo, NULL, hi, NULL, out, sc_scalar_clamp, arena);
+}
+
+sc_vector* sc_vector_clamp_inplace(sc_vector* x, sc_value_t lo, sc_value_t hi) {
+    init_tmp_arena();
+    sc_vector* out = ternary_op(x, NULL, lo, NULL, hi, NULL, x, sc_scalar_clamp, local_arena);
+    ccb_arena_reset(local_arena);
+    return out;
+}
+
 // ##########################
 // Advanced Vector operations
 // ##########################
@@ -503,7 +905,7 @@ sc_value_t sc_vector_dot(sc_vector* a, sc_vector* b) {
 
     sc_vector* tmp = sc_vector_mul_ellement_wise(a, b, local_arena);
 
-    sc_value_t out = sc_vector_reduce(tmp, sc_scalar_add, (sc_value_t){.type=a->type, .value.f32=0});
+    sc_value_t out = sc_vector_reduce(tmp, sc_scalar_add, to_sc_value(0.0, a->type));
     ccb_arena_reset(local_arena);
     return out;
 }   
@@ -534,6 +936,17 @@ sc_vector* sc_vector_cross(sc_vector* a, sc_vector* b, ccb_arena* arena) {
             break;
         }
 
+        case sc_half: {
+            float a_data[3], b_data[3], out_data[3];
+            sc_convert_half_to_f32((uint16_t*)a->data, a_data, 3);
+            sc_convert_half_to_f32((uint16_t*)b->data, b_data, 3);
+            out_data[0] = a_data[1] * b_data[2] - a_data[2] * b_data[1];
+            out_data[1] = a_data[2] * b_data[0] - a_data[0] * b_data[2];
+            out_data[2] = a_data[0] * b_data[1] - a_data[1] * b_data[0];
+            sc_convert_f32_to_half(out_data, (uint16_t*)out->data, 3);
+            break;
+        }
+
         case sc_float32: {
             float* a_data = (float*)a->data;
             float* b_data = (float*)b->data;
@@ -589,6 +1002,17 @@ sc_vector* sc_vector_cross_inplace(sc_vector* a, sc_vector* b) {
             break;
         }
 
+        case sc_half: {
+            float a_data[3], b_data[3], out_data[3];
+            sc_convert_half_to_f32((uint16_t*)a->data, a_data, 3);
+            sc_convert_half_to_f32((uint16_t*)b->data, b_data, 3);
+            out_data[0] = a_data[1] * b_data[2] - a_data[2] * b_data[1];
+            out_data[1] = a_data[2] * b_data[0] - a_data[0] * b_data[2];
+            out_data[2] = a_data[0] * b_data[1] - a_data[1] * b_data[0];
+            sc_convert_f32_to_half(out_data, (uint16_t*)a->data, 3);
+            break;
+        }
+
         case sc_float32: {
             float* a_data = (float*)a->data;
             float* b_data = (float*)b->data;
@@ -644,7 +1068,6 @@ sc_value_t sc_vector_norm(sc_vector* a, uint64_t p, ccb_arena* tmp_arena) {
 
 
     sc_value_t out = to_sc_value(0.0, a->type);
-    sc_vector_reduce(a, sc_scalar_add, out);
 
 
     if (p==1) {
@@ -681,6 +1104,48 @@ sc_vector* sc_vector_normalize_inplace(sc_vector* a, ccb_arena* arena) {
 }
 
 
+// #################
+// tensor operations
+// #################
+
+sc_tensor* sc_tensor_matmul(sc_tensor* a, sc_tensor* b, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(b, "b is NULL");
+
+    if (a->dims->dims_count < 2 || b->dims->dims_count != 2) {
+        CCB_ERROR("matmul expects a tensor of at least 2 dimensions and a matrix, got %u and %u dimensions", a->dims->dims_count, b->dims->dims_count);
+        return NULL;
+    }
+
+    if (a->type != b->type) {
+        CCB_ERROR("Tensor type mismatch: %d vs %d", a->type, b->type);
+        return NULL;
+    }
+
+    uint64_t k = a->dims->dims[a->dims->dims_count - 1];
+    uint64_t n = b->dims->dims[1];
+    if (b->dims->dims[0] != k) {
+        CCB_ERROR("matmul inner dimension mismatch: %u vs %u", k, b->dims->dims[0]);
+        return NULL;
+    }
 
+    uint64_t m = 1;
+    for (uint64_t i = 0; i < a->dims->dims_count - 1; i++) {
+        m *= a->dims->dims[i];
+    }
 
+    sc_dimensions* dims = sc_create_dimensions(a->dims->dims_count, arena, a->dims->dims);
+    CCB_NOTNULL(dims, "Failed to create dimensions");
+    dims->dims[dims->dims_count - 1] = n;
 
+    sc_tensor* out = sc_create_tensor(dims, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create output tensor");
+
+    sc_gemm_desc desc = sc_gemm_row_major(m, n, k, a->data, a->type, 0, b->data, b->type, 0, out->data, out->type, 1.0, 0.0);
+    if (sc_gemm(&desc, arena) != 0) {
+        CCB_ERROR("Failed to compute matmul");
+        return NULL;
+    }
+
+    return out;
+}
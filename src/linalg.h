@@ -41,6 +41,32 @@ sc_value_t sc_scalar_pow(sc_value_t a, sc_value_t b);
    !! a.type must equal b.type
 */
 sc_value_t sc_scalar_root(sc_value_t a, sc_value_t b);
+/*
+    bitwise and / or / xor for the integer types
+   !! a.type must equal b.type
+*/
+sc_value_t sc_scalar_and(sc_value_t a, sc_value_t b);
+sc_value_t sc_scalar_or(sc_value_t a, sc_value_t b);
+sc_value_t sc_scalar_xor(sc_value_t a, sc_value_t b);
+/*
+    bitwise not for the integer types
+*/
+sc_value_t sc_scalar_not(sc_value_t a);
+/*
+    fused multiply add a * b + c (single rounding for the floating point types)
+   !! a, b and c must have the same type
+*/
+sc_value_t sc_scalar_fma(sc_value_t a, sc_value_t b, sc_value_t c);
+/*
+    linear interpolation a + t * (b - a)
+   !! a, b and t must have the same type
+*/
+sc_value_t sc_scalar_lerp(sc_value_t a, sc_value_t b, sc_value_t t);
+/*
+    clamps x to [lo, hi], NaN is kept
+   !! x, lo and hi must have the same type
+*/
+sc_value_t sc_scalar_clamp(sc_value_t x, sc_value_t lo, sc_value_t hi);
 
 /* 
    type agnostic addition for sc_values_t
@@ -193,6 +219,96 @@ sc_vector* sc_vector_div_scalar(sc_vector* a, sc_value_t b, ccb_arena* arena);
 */
 sc_vector* sc_vector_div_scalar_inplace(sc_vector* a, sc_value_t b);
 
+/* Element-wise bitwise and / or / xor between 2 integer sc_vector
+   - sc_vector* a: first input vector
+   - sc_vector* b: second input vector
+   - ccb_arena* arena: arena where the result vector will be allocated
+   - return: a pointer to the result vector
+*/
+sc_vector* sc_vector_and(sc_vector* a, sc_vector* b, ccb_arena* arena);
+sc_vector* sc_vector_or(sc_vector* a, sc_vector* b, ccb_arena* arena);
+sc_vector* sc_vector_xor(sc_vector* a, sc_vector* b, ccb_arena* arena);
+/* Element-wise bitwise and / or / xor between 2 integer sc_vector
+   - sc_vector* a: first input vector
+   - sc_vector* b: second input vector
+   - return: a pointer to the result vector (a)
+   !! the value in the 1st vector will be replaced by the results
+*/
+sc_vector* sc_vector_and_inplace(sc_vector* a, sc_vector* b);
+sc_vector* sc_vector_or_inplace(sc_vector* a, sc_vector* b);
+sc_vector* sc_vector_xor_inplace(sc_vector* a, sc_vector* b);
+/* Element-wise bitwise not of an integer sc_vector
+   - sc_vector* a: input vector
+   - ccb_arena* arena: arena where the result vector will be allocated
+   - return: a pointer to the result vector
+*/
+sc_vector* sc_vector_not(sc_vector* a, ccb_arena* arena);
+/* Element-wise bitwise not of an integer sc_vector
+   - sc_vector* a: input vector
+   - return: a pointer to the result vector (a)
+   !! the value in the vector will be replaced by the results
+*/
+sc_vector* sc_vector_not_inplace(sc_vector* a);
+
+/* Fused multiply add a * b + c in one pass
+   - sc_vector* a, sc_vector* b, sc_vector* c: input vectors of the same size and type
+   - ccb_arena* arena: arena where the result vector will be allocated
+   - return: a pointer to the result vector
+*/
+sc_vector* sc_vector_fma(sc_vector* a, sc_vector* b, sc_vector* c, ccb_arena* arena);
+/* alpha * x + y (BLAS axpy)
+   - sc_value_t alpha: scale of x (converted to the type of x)
+   - sc_vector* x, sc_vector* y: input vectors of the same size and type
+   - ccb_arena* arena: arena where the result vector will be allocated
+   - return: a pointer to the result vector
+*/
+sc_vector* sc_vector_axpy(sc_value_t alpha, sc_vector* x, sc_vector* y, ccb_arena* arena);
+/* alpha * x + y stored in y
+   - return: a pointer to the result vector (y)
+*/
+sc_vector* sc_vector_axpy_inplace(sc_value_t alpha, sc_vector* x, sc_vector* y);
+/* alpha * x + beta * y (BLAS axpby), y is not read when beta is 0
+   - sc_value_t alpha, sc_value_t beta: scales of x and y (converted to the type of x)
+   - sc_vector* x, sc_vector* y: input vectors of the same size and type
+   - ccb_arena* arena: arena where the result vector will be allocated
+   - return: a pointer to the result vector
+*/
+sc_vector* sc_vector_axpby(sc_value_t alpha, sc_vector* x, sc_value_t beta, sc_vector* y, ccb_arena* arena);
+/* alpha * x + beta * y stored in y
+   - return: a pointer to the result vector (y)
+*/
+sc_vector* sc_vector_axpby_inplace(sc_value_t alpha, sc_vector* x, sc_value_t beta, sc_vector* y);
+/* alpha * x (BLAS scal)
+   - ccb_arena* arena: arena where the result vector will be allocated
+   - return: a pointer to the result vector
+*/
+sc_vector* sc_vector_scal(sc_value_t alpha, sc_vector* x, ccb_arena* arena);
+/* alpha * x stored in x
+   - return: a pointer to the result vector (x)
+*/
+sc_vector* sc_vector_scal_inplace(sc_value_t alpha, sc_vector* x);
+/* Linear interpolation a + t * (b - a)
+   - sc_vector* a, sc_vector* b: input vectors of the same size and type
+   - sc_value_t t: interpolation factor (converted to the type of a)
+   - ccb_arena* arena: arena where the result vector will be allocated
+   - return: a pointer to the result vector
+*/
+sc_vector* sc_vector_lerp(sc_vector* a, sc_vector* b, sc_value_t t, ccb_arena* arena);
+/* Linear interpolation stored in a
+   - return: a pointer to the result vector (a)
+*/
+sc_vector* sc_vector_lerp_inplace(sc_vector* a, sc_vector* b, sc_value_t t);
+/* Clamps every element to [lo, hi], NaN is kept
+   - sc_value_t lo, sc_value_t hi: bounds (converted to the type of x)
+   - ccb_arena* arena: arena where the result vector will be allocated
+   - return: a pointer to the result vector
+*/
+sc_vector* sc_vector_clamp(sc_vector* x, sc_value_t lo, sc_value_t hi, ccb_arena* arena);
+/* Clamps every element to [lo, hi] in place
+   - return: a pointer to the result vector (x)
+*/
+sc_vector* sc_vector_clamp_inplace(sc_vector* x, sc_value_t lo, sc_value_t hi);
+
 /* Computes the dot product of two vectors.
    - sc_vector* a: first input vector
    - sc_vector* b: second input vector
@@ -269,6 +385,7 @@ sc_vector* sc_vector_map_args_inplace(sc_vector* a, sc_value_t (*func)(sc_value_
 */
 sc_value_t sc_vector_reduce(sc_vector* a, sc_value_t (*func)(sc_value_t, sc_value_t), sc_value_t initial);
 /* Generic element-wise operation between two vectors, creating a new vector.
+   vectors of different types are computed in sc_promote_types(a->type, b->type) (same for a scalar of another type)
    - sc_vector* a: first input vector
    - sc_vector* b: second input vector
    - sc_value_t (*func)(sc_value_t, sc_value_t): function for the element-wise operation
@@ -280,7 +397,7 @@ sc_vector* sc_for_each_vector_op(sc_vector* a, sc_vector* b, sc_value_t (*func)(
    - sc_vector* a: first input vector
    - sc_vector* b: second input vector
    - sc_value_t (*func)(sc_value_t, sc_value_t): function for the element-wise operation
-   - return: a pointer to the modified vector (a)
+   - return: a pointer to the modified vector (a), NULL if the promoted type is not the type of a
    !! the value in the 1st vector will be replaced by the results
 */
 sc_vector* sc_for_each_vector_op_inplace(sc_vector* a, sc_vector* b, sc_value_t (*func)(sc_value_t, sc_value_t));
@@ -300,6 +417,29 @@ sc_vector* sc_for_each_vector_scalar_op(sc_vector* a, sc_value_t b, sc_value_t (
    !! the value in the vector will be replaced by the results
 */
 sc_vector* sc_for_each_vector_scalar_op_inplace(sc_vector* a, sc_value_t b, sc_value_t (*func)(sc_value_t, sc_value_t));
+/* Generic element-wise operation between three vectors out = func(a, b, c), creating a new vector.
+   - sc_vector* a, sc_vector* b, sc_vector* c: input vectors of the same size and type
+   - sc_value_t (*func)(sc_value_t, sc_value_t, sc_value_t): function for the element-wise operation
+   - ccb_arena* arena: arena where the result vector will be allocated
+   - return: a pointer to the new vector
+*/
+sc_vector* sc_for_each_vector_ternary_op(sc_vector* a, sc_vector* b, sc_vector* c, sc_value_t (*func)(sc_value_t, sc_value_t, sc_value_t), ccb_arena* arena);
+/* Generic in-place element-wise operation between three vectors.
+   - return: a pointer to the modified vector (a)
+   !! the value in the 1st vector will be replaced by the results
+*/
+sc_vector* sc_for_each_vector_ternary_op_inplace(sc_vector* a, sc_vector* b, sc_vector* c, sc_value_t (*func)(sc_value_t, sc_value_t, sc_value_t));
+
+
+// tensor operations
+
+/* Matrix product of a tensor by a matrix: out[..., m, n] = sum_k a[..., m, k] * b[k, n]
+   - sc_tensor* a: left tensor, at least 2 dimensions, the leading dimensions are batched rows
+   - sc_tensor* b: right matrix (k x n), same type as a
+   - ccb_arena* arena: arena where the result and the scratch will be allocated
+   - return: a pointer to the result tensor
+*/
+sc_tensor* sc_tensor_matmul(sc_tensor* a, sc_tensor* b, ccb_arena* arena);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,658 @@
+#include "data.h"
+#include "nn.h"
+#include "normalization.h"
+#include "sc_engine.h"
+#include "sc_gemm.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+// alignment of the workspace blocks, in bytes
+#define NN_ALIGN 64
+// sqrt(2 / pi) and the cubic coefficient of the gelu tanh approximation
+#define NN_GELU_C 0.7978845608028654
+#define NN_GELU_A 0.044715
+
+
+struct nn_args {
+    sc_TYPES type;
+    sc_nn_activation activation;
+    uint64_t cols;
+
+    // forward: y = activation(x + bias), pre keeps x + bias
+    const void* x;
+    const void* bias;
+    void* pre;
+    void* y;
+
+    // backward: dx = dy * activation'(y, pre), partials are the per thread column sums of dx
+    const void* dy;
+    void* dx;
+    double* partials;
+
+    // dropout
+    uint8_t* mask;
+    double rate;
+    uint64_t seed;
+};
+
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// uniform in [0, 1) from a seed and an index
+static double uniform(uint64_t seed, uint64_t index) {
+    return (double)(splitmix64(seed ^ splitmix64(index)) >> 11) * 0x1.0p-53;
+}
+
+
+// the row kernels of the activations, instantiated for float and double
+#define NN_ROW_KERNELS(SUFFIX, T, EXP, TANH)                                                                     \
+static inline T gelu_##SUFFIX(T v) {                                                                            \
+    return (T)0.5 * v * ((T)1 + TANH((T)NN_GELU_C * (v + (T)NN_GELU_A * v * v * v)));                          \
+}                                                                                                               \
+                                                                                                                \
+static inline T gelu_grad_##SUFFIX(T v) {                                                                       \
+    T t = TANH((T)NN_GELU_C * (v + (T)NN_GELU_A * v * v * v));                                                  \
+    return (T)0.5 * ((T)1 + t) + (T)0.5 * v * ((T)1 - t * t) * (T)NN_GELU_C * ((T)1 + (T)(3 * NN_GELU_A) * v * v); \
+}                                                                                                               \
+                                                                                                                \
+static void forward_row_##SUFFIX(sc_nn_activation activation, const T* x, const T* bias, T* pre, T* y, uint64_t n) { \
+    if (bias != NULL) {                                                                                         \
+        for (uint64_t j = 0; j < n; j++) {                                                                      \
+            y[j] = x[j] + bias[j];                                                                              \
+        }                                                                                                       \
+    } else if (x != y) {                                                                                        \
+        memcpy(y, x, n * sizeof(T));                                                                            \
+    }                                                                                                           \
+    if (pre != NULL) {                                                                                          \
+        memcpy(pre, y, n * sizeof(T));                                                                          \
+    }                                                                                                           \
+    switch (activation) {                                                                                       \
+        case sc_nn_relu:                                                                                        \
+            for (uint64_t j = 0; j < n; j++) y[j] = (y[j] > (T)0) ? y[j] : (T)0;                                \
+            break;                                                                                              \
+        case sc_nn_sigmoid:                                                                                     \
+            for (uint64_t j = 0; j < n; j++) y[j] = (T)1 / ((T)1 + EXP(-y[j]));                                 \
+            break;                                                                                              \
+        case sc_nn_tanh:                                                                                        \
+            for (uint64_t j = 0; j < n; j++) y[j] = TANH(y[j]);                                                 \
+            break;                                                                                              \
+        case sc_nn_gelu:                                                                                        \
+            for (uint64_t j = 0; j < n; j++) y[j] = gelu_##SUFFIX(y[j]);                                        \
+            break;                                                                                              \
+        default:                                                                                                \
+            break;                                                                                              \
+    }                                                                                                           \
+}                                                                                                               \
+                                                                                                                \
+static void backward_row_##SUFFIX(sc_nn_activation activation, const T* dy, const T* y, const T* pre, T* dx, double* sums, uint64_t n) { \
+    switch (activation) {                                                                                       \
+        case sc_nn_relu:                                                                                        \
+            for (uint64_t j = 0; j < n; j++) dx[j] = (y[j] > (T)0) ? dy[j] : (T)0;                              \
+            break;                                                                                              \
+        case sc_nn_sigmoid:                                                                                     \
+            for (uint64_t j = 0; j < n; j++) dx[j] = dy[j] * y[j] * ((T)1 - y[j]);                              \
+            break;                                                                                              \
+        case sc_nn_tanh:                                                                                        \
+            for (uint64_t j = 0; j < n; j++) dx[j] = dy[j] * ((T)1 - y[j] * y[j]);                              \
+            break;                                                                                              \
+        case sc_nn_gelu:                                                                                        \
+            for (uint64_t j = 0; j < n; j++) dx[j] = dy[j] * gelu_grad_##SUFFIX(pre[j]);                        \
+            break;                                                                                              \
+        default:                                                                                                \
+            if (dx != dy) memcpy(dx, dy, n * sizeof(T));                                                        \
+            break;                                                                                              \
+    }                                                                                                           \
+    if (sums != NULL) {                                                                                         \
+        for (uint64_t j = 0; j < n; j++) sums[j] += dx[j];                                                      \
+    }                                                                                                           \
+}
+
+NN_ROW_KERNELS(f32, float, expf, tanhf)
+NN_ROW_KERNELS(f64, double, exp, tanh)
+
+
+static int forward_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct nn_args* args = (struct nn_args*)raw;
+    uint64_t n = args->cols;
+
+    for (uint64_t r = start; r < end; r++) {
+        if (args->type == sc_float64) {
+            forward_row_f64(args->activation, (const double*)args->x + r * n, (const double*)args->bias,
+                            (args->pre != NULL) ? (double*)args->pre + r * n : NULL, (double*)args->y + r * n, n);
+        } else {
+            forward_row_f32(args->activation, (const float*)args->x + r * n, (const float*)args->bias,
+                            (args->pre != NULL) ? (float*)args->pre + r * n : NULL, (float*)args->y + r * n, n);
+        }
+    }
+    return 0;
+}
+
+
+static int backward_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct nn_args* args = (struct nn_args*)raw;
+    uint64_t n = args->cols;
+    double* sums = (args->partials != NULL) ? args->partials + thread_id * n : NULL;
+
+    for (uint64_t r = start; r < end; r++) {
+        if (args->type == sc_float64) {
+            backward_row_f64(args->activation, (const double*)args->dy + r * n, (const double*)args->y + r * n,
+                             (args->pre != NULL) ? (const double*)args->pre + r * n : NULL, (double*)args->dx + r * n, sums, n);
+        } else {
+            backward_row_f32(args->activation, (const float*)args->dy + r * n, (const float*)args->y + r * n,
+                             (args->pre != NULL) ? (const float*)args->pre + r * n : NULL, (float*)args->dx + r * n, sums, n);
+        }
+    }
+    return 0;
+}
+
+
+// the mask of an element only depends on the seed of the step and its index
+static int dropout_forward_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct nn_args* args = (struct nn_args*)raw;
+    uint64_t n = args->cols;
+    double scale = 1.0 / (1.0 - args->rate);
+
+    for (uint64_t i = start * n; i < end * n; i++) {
+        uint8_t keep = uniform(args->seed, i) >= args->rate;
+        args->mask[i] = keep;
+        if (args->type == sc_float64) {
+            ((double*)args->y)[i] = keep ? ((const double*)args->x)[i] * scale : 0.0;
+        } else {
+            ((float*)args->y)[i] = keep ? ((const float*)args->x)[i] * (float)scale : 0.0f;
+        }
+    }
+    return 0;
+}
+
+
+static int dropout_backward_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct nn_args* args = (struct nn_args*)raw;
+    uint64_t n = args->cols;
+    double scale = 1.0 / (1.0 - args->rate);
+
+    for (uint64_t i = start * n; i < end * n; i++) {
+        if (args->type == sc_float64) {
+            ((double*)args->dx)[i] = args->mask[i] ? ((const double*)args->dy)[i] * scale : 0.0;
+        } else {
+            ((float*)args->dx)[i] = args->mask[i] ? ((const float*)args->dy)[i] * (float)scale : 0.0f;
+        }
+    }
+    return 0;
+}
+
+
+// ######
+// layers
+// ######
+
+sc_nn_network* sc_nn_create(uint64_t in_features, sc_TYPES type, uint64_t seed, ccb_arena* arena) {
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (type != sc_float32 && type != sc_float64) {
+        CCB_ERROR("Neural networks are float32 or float64, got type %d", type);
+        return NULL;
+    }
+    if (in_features == 0) {
+        CCB_ERROR("A network needs at least one input feature");
+        return NULL;
+    }
+
+    sc_nn_network* net = (sc_nn_network*)ccb_arena_malloc(arena, sizeof(sc_nn_network));
+    CCB_NOTNULL(net, "Failed to allocate network");
+    memset(net, 0, sizeof(sc_nn_network));
+    net->type = type;
+    net->in_features = in_features;
+    net->out_features = in_features;
+    net->seed = seed;
+    return net;
+}
+
+
+static sc_nn_layer* push_layer(sc_nn_network* net, sc_nn_layer_kind kind, uint64_t out_features, ccb_arena* arena) {
+    CCB_NOTNULL(net, "net is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (net->batch != 0) {
+        CCB_ERROR("Layers can not be added to a bound network");
+        return NULL;
+    }
+    if (out_features == 0) {
+        CCB_ERROR("A layer needs at least one output feature");
+        return NULL;
+    }
+
+    if (net->count == net->capacity) {
+        uint64_t capacity = (net->capacity == 0) ? 8 : 2 * net->capacity;
+        sc_nn_layer* layers = (sc_nn_layer*)ccb_arena_malloc(arena, capacity * sizeof(sc_nn_layer));
+        CCB_NOTNULL(layers, "Failed to allocate layers");
+        if (net->count > 0) {
+            memcpy(layers, net->layers, net->count * sizeof(sc_nn_layer));
+        }
+        net->layers = layers;
+        net->capacity = capacity;
+    }
+
+    sc_nn_layer* layer = &net->layers[net->count++];
+    memset(layer, 0, sizeof(sc_nn_layer));
+    layer->kind = kind;
+    layer->in_features = net->out_features;
+    layer->out_features = out_features;
+    layer->activation = sc_nn_identity;
+    net->out_features = out_features;
+    return layer;
+}
+
+
+static sc_vector* create_filled_vector(uint64_t size, sc_TYPES type, double value, ccb_arena* arena) {
+    sc_vector* vector = sc_create_vector(size, type, arena);
+    CCB_NOTNULL(vector, "Failed to create parameter vector");
+    for (uint64_t i = 0; i < size; i++) {
+        sc_set_vector_element(vector, i, to_sc_value(value, type));
+    }
+    return vector;
+}
+
+
+static sc_tensor* create_matrix(uint64_t rows, uint64_t cols, sc_TYPES type, ccb_arena* arena) {
+    uint64_t dims[] = {rows, cols};
+    sc_tensor* tensor = sc_create_tensor(sc_create_dimensions(2, arena, dims), type, arena);
+    CCB_NOTNULL(tensor, "Failed to create parameter tensor");
+    memset(tensor->data, 0, tensor->size * sc_type_size(type));
+    return tensor;
+}
+
+
+int sc_nn_add_dense(sc_nn_network* net, uint64_t out_features, sc_nn_activation activation, ccb_arena* arena) {
+    sc_nn_layer* layer = push_layer(net, sc_nn_dense, out_features, arena);
+    if (layer == NULL) {
+        return -1;
+    }
+    layer->activation = activation;
+    layer->weight = create_matrix(out_features, layer->in_features, net->type, arena);
+    layer->grad_weight = create_matrix(out_features, layer->in_features, net->type, arena);
+    layer->bias = create_filled_vector(out_features, net->type, 0.0, arena);
+    layer->grad_bias = create_filled_vector(out_features, net->type, 0.0, arena);
+    if (!layer->weight || !layer->grad_weight || !layer->bias || !layer->grad_bias) {
+        return -1;
+    }
+
+    // Glorot uniform, He uniform for relu
+    double fan = (activation == sc_nn_relu) ? (double)layer->in_features / 2.0 : (double)(layer->in_features + out_features) / 2.0;
+    double limit = sqrt(3.0 / fan);
+    uint64_t seed = splitmix64(net->seed + net->count);
+    for (uint64_t i = 0; i < layer->weight->size; i++) {
+        double value = (2.0 * uniform(seed, i) - 1.0) * limit;
+        if (net->type == sc_float64) {
+            ((double*)layer->weight->data)[i] = value;
+        } else {
+            ((float*)layer->weight->data)[i] = (float)value;
+        }
+    }
+    return 0;
+}
+
+
+int sc_nn_add_activation(sc_nn_network* net, sc_nn_activation activation, ccb_arena* arena) {
+    CCB_NOTNULL(net, "net is NULL");
+    sc_nn_layer* layer = push_layer(net, sc_nn_activation_layer, net->out_features, arena);
+    if (layer == NULL) {
+        return -1;
+    }
+    layer->activation = activation;
+    return 0;
+}
+
+
+int sc_nn_add_dropout(sc_nn_network* net, double rate, ccb_arena* arena) {
+    CCB_NOTNULL(net, "net is NULL");
+    if (!(rate >= 0.0 && rate < 1.0)) {
+        CCB_ERROR("Dropout rate must be in [0, 1), got %g", rate);
+        return -1;
+    }
+    sc_nn_layer* layer = push_layer(net, sc_nn_dropout, net->out_features, arena);
+    if (layer == NULL) {
+        return -1;
+    }
+    layer->rate = rate;
+    return 0;
+}
+
+
+int sc_nn_add_layer_norm(sc_nn_network* net, double eps, ccb_arena* arena) {
+    CCB_NOTNULL(net, "net is NULL");
+    sc_nn_layer* layer = push_layer(net, sc_nn_layer_norm, net->out_features, arena);
+    if (layer == NULL) {
+        return -1;
+    }
+    layer->eps = eps;
+    layer->gamma = create_filled_vector(layer->out_features, net->type, 1.0, arena);
+    layer->grad_gamma = create_filled_vector(layer->out_features, net->type, 0.0, arena);
+    layer->bias = create_filled_vector(layer->out_features, net->type, 0.0, arena);
+    layer->grad_bias = create_filled_vector(layer->out_features, net->type, 0.0, arena);
+    if (!layer->gamma || !layer->grad_gamma || !layer->bias || !layer->grad_bias) {
+        return -1;
+    }
+    return 0;
+}
+
+
+// #########
+// workspace
+// #########
+
+// sizes the workspace when base is NULL, carves it from base otherwise
+struct nn_cursor {
+    uint8_t* base;
+    uint64_t offset;
+};
+
+static void* carve(struct nn_cursor* cursor, uint64_t bytes) {
+    cursor->offset = (cursor->offset + NN_ALIGN - 1) / NN_ALIGN * NN_ALIGN;
+    void* block = (cursor->base != NULL) ? cursor->base + cursor->offset : NULL;
+    cursor->offset += bytes;
+    return block;
+}
+
+static sc_tensor* carve_matrix(struct nn_cursor* cursor, uint64_t rows, uint64_t cols, sc_TYPES type) {
+    sc_tensor* tensor = (sc_tensor*)carve(cursor, sizeof(sc_tensor));
+    sc_dimensions* dims = (sc_dimensions*)carve(cursor, sizeof(sc_dimensions));
+    uint64_t* sizes = (uint64_t*)carve(cursor, 2 * sizeof(uint64_t));
+    void* data = carve(cursor, rows * cols * sc_type_size(type));
+    if (cursor->base == NULL) {
+        return NULL;
+    }
+
+    sizes[0] = rows;
+    sizes[1] = cols;
+    dims->dims_count = 2;
+    dims->dims = sizes;
+    tensor->data = data;
+    tensor->dims = dims;
+    tensor->size = rows * cols;
+    tensor->type = type;
+    return tensor;
+}
+
+static uint64_t layout(sc_nn_network* net, uint64_t batch, uint8_t* base) {
+    struct nn_cursor cursor = {base, 0};
+    uint64_t threads = sc_get_engine_thread_count();
+    uint64_t el_size = sc_type_size(net->type);
+
+    for (uint64_t l = 0; l < net->count; l++) {
+        sc_nn_layer* layer = &net->layers[l];
+        sc_tensor* output = carve_matrix(&cursor, batch, layer->out_features, net->type);
+        sc_tensor* grad_input = carve_matrix(&cursor, batch, layer->in_features, net->type);
+        void* cache = NULL;
+        void* partials = NULL;
+        if (layer->kind == sc_nn_dense) {
+            cache = carve(&cursor, batch * layer->out_features * el_size);
+            partials = carve(&cursor, threads * layer->out_features * sizeof(double));
+        } else if (layer->kind == sc_nn_dropout) {
+            cache = carve(&cursor, batch * layer->out_features);
+        }
+
+        if (base != NULL) {
+            layer->output = output;
+            layer->grad_input = grad_input;
+            layer->cache = cache;
+            layer->partials = partials;
+        }
+    }
+    return cursor.offset;
+}
+
+
+uint64_t sc_nn_workspace_size(sc_nn_network* net, uint64_t batch) {
+    CCB_NOTNULL(net, "net is NULL");
+    // the block returned by the arena is aligned by hand
+    return layout(net, batch, NULL) + NN_ALIGN;
+}
+
+
+int sc_nn_bind(sc_nn_network* net, uint64_t batch, ccb_arena* arena) {
+    CCB_NOTNULL(net, "net is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (net->count == 0) {
+        CCB_ERROR("The network has no layers");
+        return -1;
+    }
+    if (batch == 0) {
+        CCB_ERROR("The batch size must be positive");
+        return -1;
+    }
+    if (net->batch != 0) {
+        CCB_ERROR("The network is already bound for batches of %" PRIu64 " rows", net->batch);
+        return -1;
+    }
+
+    uint64_t size = sc_nn_workspace_size(net, batch);
+    uint8_t* raw = (uint8_t*)ccb_arena_malloc(arena, size);
+    if (raw == NULL) {
+        CCB_ERROR("Failed to allocate a workspace of %" PRIu64 " bytes", size);
+        return -1;
+    }
+    uint8_t* base = (uint8_t*)(((uintptr_t)raw + NN_ALIGN - 1) & ~(uintptr_t)(NN_ALIGN - 1));
+    layout(net, batch, base);
+    net->batch = batch;
+    return 0;
+}
+
+
+static void set_rows(sc_tensor* tensor, uint64_t rows) {
+    tensor->dims->dims[0] = rows;
+    tensor->size = rows * tensor->dims->dims[1];
+}
+
+
+// ################
+// forward/backward
+// ################
+
+static int run_rows(int (*func)(void*, uint64_t, uint64_t, uint64_t), struct nn_args* args, uint64_t rows, ccb_arena* scratch) {
+    if (sc_run_range_task(func, args, rows, rows * args->cols, scratch) != 0) {
+        CCB_ERROR("Failed to run network layer task");
+        return -1;
+    }
+    return 0;
+}
+
+
+static int layer_forward(sc_nn_network* net, sc_nn_layer* layer, sc_tensor* input, int training, ccb_arena* scratch) {
+    uint64_t rows = net->rows;
+    uint64_t el_size = sc_type_size(net->type);
+    struct nn_args args = {0};
+    args.type = net->type;
+    args.activation = layer->activation;
+    args.cols = layer->out_features;
+
+    switch (layer->kind) {
+        case sc_nn_dense: {
+            sc_gemm_desc desc = sc_gemm_row_major(rows, layer->out_features, layer->in_features,
+                                                  input->data, net->type, 0, layer->weight->data, net->type, 1,
+                                                  layer->output->data, net->type, 1.0, 0.0);
+            if (sc_gemm(&desc, scratch) != 0) {
+                CCB_ERROR("Failed to run dense layer gemm");
+                return -1;
+            }
+            // bias and activation epilogue in place, gelu keeps the pre activations for the backward pass
+            args.x = layer->output->data;
+            args.bias = layer->bias->data;
+            args.pre = (layer->activation == sc_nn_gelu) ? layer->cache : NULL;
+            args.y = layer->output->data;
+            return run_rows(forward_kernel, &args, rows, scratch);
+        }
+        case sc_nn_activation_layer:
+            args.x = input->data;
+            args.y = layer->output->data;
+            return run_rows(forward_kernel, &args, rows, scratch);
+        case sc_nn_dropout:
+            if (!training || layer->rate == 0.0) {
+                memcpy(layer->output->data, input->data, rows * layer->out_features * el_size);
+                return 0;
+            }
+            args.x = input->data;
+            args.y = layer->output->data;
+            args.mask = (uint8_t*)layer->cache;
+            args.rate = layer->rate;
+            args.seed = splitmix64(net->seed ^ splitmix64(net->step + ((uint64_t)(layer - net->layers) << 48)));
+            return run_rows(dropout_forward_kernel, &args, rows, scratch);
+        case sc_nn_layer_norm:
+            memcpy(layer->output->data, input->data, rows * layer->out_features * el_size);
+            if (sc_layer_norm_inplace(layer->output, layer->gamma, layer->bias, layer->eps, &layer->stats, scratch) == NULL) {
+                CCB_ERROR("Failed to run layer norm");
+                return -1;
+            }
+            return 0;
+    }
+    return -1;
+}
+
+
+static int layer_backward(sc_nn_network* net, sc_nn_layer* layer, sc_tensor* input, sc_tensor* dy, ccb_arena* scratch) {
+    uint64_t rows = net->rows;
+    uint64_t el_size = sc_type_size(net->type);
+    struct nn_args args = {0};
+    args.type = net->type;
+    args.activation = layer->activation;
+    args.cols = layer->out_features;
+
+    switch (layer->kind) {
+        case sc_nn_dense: {
+            // dz = dy * activation' and the bias gradient in one pass, dz overwrites the pre activations
+            uint64_t threads = sc_get_engine_thread_count();
+            memset(layer->partials, 0, threads * layer->out_features * sizeof(double));
+            args.dy = dy->data;
+            args.y = layer->output->data;
+            args.pre = layer->cache;
+            args.dx = layer->cache;
+            args.partials = (double*)layer->partials;
+            if (run_rows(backward_kernel, &args, rows, scratch) != 0) {
+                return -1;
+            }
+            for (uint64_t j = 0; j < layer->out_features; j++) {
+                double sum = 0.0;
+                for (uint64_t t = 0; t < threads; t++) {
+                    sum += args.partials[t * layer->out_features + j];
+                }
+                sc_set_vector_element(layer->grad_bias, j, to_sc_value(sum, net->type));
+            }
+
+            // dW = dz^T.x and dx = dz.W
+            sc_gemm_desc grad_weight = sc_gemm_row_major(layer->out_features, layer->in_features, rows,
+                                                         layer->cache, net->type, 1, input->data, net->type, 0,
+                                                         layer->grad_weight->data, net->type, 1.0, 0.0);
+            sc_gemm_desc grad_input = sc_gemm_row_major(rows, layer->in_features, layer->out_features,
+                                                        layer->cache, net->type, 0, layer->weight->data, net->type, 0,
+                                                        layer->grad_input->data, net->type, 1.0, 0.0);
+            if (sc_gemm(&grad_weight, scratch) != 0 || sc_gemm(&grad_input, scratch) != 0) {
+                CCB_ERROR("Failed to run dense layer backward gemm");
+                return -1;
+            }
+            return 0;
+        }
+        case sc_nn_activation_layer:
+            args.dy = dy->data;
+            args.y = layer->output->data;
+            args.pre = input->data;
+            args.dx = layer->grad_input->data;
+            return run_rows(backward_kernel, &args, rows, scratch);
+        case sc_nn_dropout:
+            if (!net->training || layer->rate == 0.0) {
+                memcpy(layer->grad_input->data, dy->data, rows * layer->out_features * el_size);
+                return 0;
+            }
+            args.dy = dy->data;
+            args.dx = layer->grad_input->data;
+            args.mask = (uint8_t*)layer->cache;
+            args.rate = layer->rate;
+            return run_rows(dropout_backward_kernel, &args, rows, scratch);
+        case sc_nn_layer_norm: {
+            sc_tensor* dx = sc_layer_norm_backward(dy, input, layer->gamma, &layer->stats, layer->grad_gamma, layer->grad_bias, scratch);
+            if (dx == NULL) {
+                CCB_ERROR("Failed to run layer norm backward");
+                return -1;
+            }
+            memcpy(layer->grad_input->data, dx->data, rows * layer->in_features * el_size);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+
+sc_tensor* sc_nn_forward(sc_nn_network* net, sc_tensor* x, int training, ccb_arena* scratch) {
+    CCB_NOTNULL(net, "net is NULL");
+    CCB_NOTNULL(x, "x is NULL");
+    CCB_NOTNULL(scratch, "scratch is NULL");
+    if (net->batch == 0) {
+        CCB_ERROR("The network is not bound, call sc_nn_bind first");
+        return NULL;
+    }
+    if (x->dims->dims_count != 2 || x->dims->dims[1] != net->in_features || x->type != net->type) {
+        CCB_ERROR("x must be a [rows, %" PRIu64 "] tensor of type %d", net->in_features, net->type);
+        return NULL;
+    }
+    uint64_t rows = x->dims->dims[0];
+    if (rows == 0 || rows > net->batch) {
+        CCB_ERROR("x has %" PRIu64 " rows, the network is bound for 1 to %" PRIu64, rows, net->batch);
+        return NULL;
+    }
+
+    net->rows = rows;
+    net->training = training != 0;
+    if (net->training) {
+        net->step++;
+    }
+    sc_tensor* input = x;
+    for (uint64_t l = 0; l < net->count; l++) {
+        sc_nn_layer* layer = &net->layers[l];
+        set_rows(layer->output, rows);
+        set_rows(layer->grad_input, rows);
+        if (layer_forward(net, layer, input, net->training, scratch) != 0) {
+            net->input = NULL;
+            return NULL;
+        }
+        input = layer->output;
+    }
+    net->input = x;
+    return input;
+}
+
+
+sc_tensor* sc_nn_backward(sc_nn_network* net, sc_tensor* grad_output, ccb_arena* scratch) {
+    CCB_NOTNULL(net, "net is NULL");
+    CCB_NOTNULL(grad_output, "grad_output is NULL");
+    CCB_NOTNULL(scratch, "scratch is NULL");
+    if (net->input == NULL) {
+        CCB_ERROR("No forward pass to differentiate");
+        return NULL;
+    }
+    if (grad_output->dims->dims_count != 2 || grad_output->dims->dims[0] != net->rows ||
+        grad_output->dims->dims[1] != net->out_features || grad_output->type != net->type) {
+        CCB_ERROR("grad_output must be a [%" PRIu64 ", %" PRIu64 "] tensor of type %d", net->rows, net->out_features, net->type);
+        return NULL;
+    }
+
+    sc_tensor* dy = grad_output;
+    for (uint64_t l = net->count; l-- > 0;) {
+        sc_nn_layer* layer = &net->layers[l];
+        sc_tensor* input = (l == 0) ? net->input : net->layers[l - 1].output;
+        if (layer_backward(net, layer, input, dy, scratch) != 0) {
+            return NULL;
+        }
+        dy = layer->grad_input;
+    }
+    return dy;
+}
@@ -0,0 +1,124 @@
+#ifndef __NN_H__
+#define __NN_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+#include "normalization.h"
+
+/*
+    modular neural networks on [rows, features] tensors: a network is a stack of layers (dense, activation,
+    dropout, layer norm) with forward and backward passes
+    every layer declares its workspace (outputs, input gradients, caches) for a batch size, sc_nn_bind carves
+    all of it from one pre-sized block so a training step never allocates from the workspace arena
+    the bias and the activation of a dense layer are applied by one epilogue pass over the gemm output, the
+    backward pass computes the activation derivative and the bias gradient in one pass too
+    the gemms run on the engine thread pool, the networks are float32 or float64
+*/
+
+typedef enum {
+    sc_nn_identity,
+    sc_nn_relu,
+    sc_nn_sigmoid,
+    sc_nn_tanh,
+    sc_nn_gelu,             // tanh approximation
+} sc_nn_activation;
+
+typedef enum {
+    sc_nn_dense,
+    sc_nn_activation_layer,
+    sc_nn_dropout,
+    sc_nn_layer_norm,
+} sc_nn_layer_kind;
+
+typedef struct {
+    sc_nn_layer_kind kind;
+    uint64_t in_features;
+    uint64_t out_features;
+    sc_nn_activation activation;
+    double rate;            // dropout probability
+    double eps;             // layer norm
+
+    // parameters and their gradients (written by the backward pass), NULL when the layer has none
+    sc_tensor* weight;      // dense [out, in]
+    sc_vector* bias;        // dense bias, layer norm shift
+    sc_vector* gamma;       // layer norm scale
+    sc_tensor* grad_weight;
+    sc_vector* grad_bias;
+    sc_vector* grad_gamma;
+
+    // workspace, set by sc_nn_bind
+    sc_tensor* output;      // [rows, out]
+    sc_tensor* grad_input;  // [rows, in]
+    void* cache;            // dense: pre activations then output gradients, dropout: mask
+    void* partials;         // dense: per thread bias gradients
+    sc_norm_stats stats;    // layer norm statistics, allocated in the scratch arena by the forward pass
+} sc_nn_layer;
+
+typedef struct {
+    sc_TYPES type;
+    uint64_t in_features;
+    uint64_t out_features;  // of the last layer
+    uint64_t seed;          // initialisation of the weights and dropout masks
+    sc_nn_layer* layers;
+    uint64_t count;
+    uint64_t capacity;
+
+    uint64_t batch;         // rows the workspace was bound for, 0 before sc_nn_bind
+    uint64_t rows;          // rows of the current step
+    uint64_t step;          // forward passes in training mode
+    int training;           // mode of the last forward pass
+    sc_tensor* input;       // input of the last forward pass
+} sc_nn_network;
+
+
+/* Creates an empty network
+   - uint64_t in_features: number of columns of the input
+   - sc_TYPES type: float32 or float64
+   - uint64_t seed: seed of the weights initialisation and of the dropout masks
+   - ccb_arena* arena: arena where the network will be allocated
+   - return: a pointer to the network
+*/
+sc_nn_network* sc_nn_create(uint64_t in_features, sc_TYPES type, uint64_t seed, ccb_arena* arena);
+/* Adds a dense layer y = activation(x.W^T + b), W is initialised uniformly (Glorot, He for relu) and b to 0
+   - uint64_t out_features: number of outputs
+   - sc_nn_activation activation: activation fused in the layer
+   - ccb_arena* arena: arena where the parameters and their gradients will be allocated
+   - return: 0 on success
+*/
+int sc_nn_add_dense(sc_nn_network* net, uint64_t out_features, sc_nn_activation activation, ccb_arena* arena);
+/* Adds an element wise activation layer */
+int sc_nn_add_activation(sc_nn_network* net, sc_nn_activation activation, ccb_arena* arena);
+/* Adds an inverted dropout layer: in training the values are zeroed with probability rate and scaled by 1 / (1 - rate)
+   the mask only depends on the seed, the step and the element index (not on the thread count)
+*/
+int sc_nn_add_dropout(sc_nn_network* net, double rate, ccb_arena* arena);
+/* Adds a layer norm with a scale (1) and a shift (0) per feature */
+int sc_nn_add_layer_norm(sc_nn_network* net, double eps, ccb_arena* arena);
+
+/* Size in bytes of the workspace of a network for a batch size */
+uint64_t sc_nn_workspace_size(sc_nn_network* net, uint64_t batch);
+/* Allocates the workspace of all the layers in one block, layers can not be added after
+   - uint64_t batch: maximum number of rows of a step
+   - ccb_arena* arena: arena holding the workspace (sc_nn_workspace_size bytes)
+   - return: 0 on success
+*/
+int sc_nn_bind(sc_nn_network* net, uint64_t batch, ccb_arena* arena);
+
+/* Forward pass
+   - sc_tensor* x: input [rows, in_features] with rows <= batch, same type as the network, kept until the backward pass
+   - int training: 1 to apply the dropout
+   - ccb_arena* scratch: arena where the tasks, the gemm buffers and the statistics will be allocated,
+     it must not be reset before the backward pass of the step
+   - return: a pointer to the output [rows, out_features] (workspace of the last layer)
+*/
+sc_tensor* sc_nn_forward(sc_nn_network* net, sc_tensor* x, int training, ccb_arena* scratch);
+/* Backward pass of the last forward pass, the gradients of the parameters are overwritten
+   - sc_tensor* grad_output: gradient of the loss with respect to the output [rows, out_features]
+   - ccb_arena* scratch: same arena as the forward pass
+   - return: a pointer to the gradient of the input [rows, in_features] (workspace of the first layer)
+*/
+sc_tensor* sc_nn_backward(sc_nn_network* net, sc_tensor* grad_output, ccb_arena* scratch);
+
+
+#endif // __NN_H__
@@ -0,0 +1,1076 @@
+#include "data.h"
+#include "normalization.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+struct norm_args {
+    sc_TYPES type;
+    uint64_t rows;
+    uint64_t cols;
+    double eps;
+
+    void* x;
+    void* y;
+    void* dy;
+    void* dx;
+    void* gamma;
+    void* beta;
+
+    // statistics (float for float32/bfloat16, double for float64)
+    void* mean;
+    void* rstd;
+
+    // per channel coefficients (batch norm)
+    void* coef_a;
+    void* coef_b;
+    void* coef_c;
+
+    // per thread partial sums, partial_stride elements per thread
+    void* partial;
+    uint64_t* partial_count;
+    uint64_t partial_stride;
+};
+
+
+// #######
+// helpers
+// #######
+
+static sc_TYPES stats_type(sc_TYPES type) {
+    return (type == sc_float64) ? sc_float64 : sc_float32;
+}
+
+
+static int check_norm_input(sc_tensor* x, sc_vector* gamma, sc_vector* beta, uint64_t* rows, uint64_t* cols) {
+    if (x->type != sc_float16 && x->type != sc_float32 && x->type != sc_float64) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", x->type);
+        return -1;
+    }
+
+    if (x->dims->dims_count == 0 || x->size == 0) {
+        CCB_ERROR("Cannot normalise an empty tensor");
+        return -1;
+    }
+
+    *cols = x->dims->dims[x->dims->dims_count - 1];
+    *rows = x->size / *cols;
+
+    if (gamma != NULL && (gamma->size != *cols || gamma->type != x->type)) {
+        CCB_ERROR("gamma mismatch: size %" PRIu64 " type %d, expected size %" PRIu64 " type %d", gamma->size, gamma->type, *cols, x->type);
+        return -1;
+    }
+
+    if (beta != NULL && (beta->size != *cols || beta->type != x->type)) {
+        CCB_ERROR("beta mismatch: size %" PRIu64 " type %d, expected size %" PRIu64 " type %d", beta->size, beta->type, *cols, x->type);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static int check_same_shape(sc_tensor* a, sc_tensor* b) {
+    if (a->type != b->type || a->size != b->size || a->dims->dims_count != b->dims->dims_count) {
+        CCB_ERROR("Tensor mismatch: size %" PRIu64 " vs %" PRIu64 ", type %d vs %d", a->size, b->size, a->type, b->type);
+        return -1;
+    }
+
+    for (uint64_t i = 0; i < a->dims->dims_count; i++) {
+        if (a->dims->dims[i] != b->dims->dims[i]) {
+            CCB_ERROR("Tensor dimension %" PRIu64 " mismatch: %" PRIu64 " vs %" PRIu64, i, a->dims->dims[i], b->dims->dims[i]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+static int check_stats(sc_vector* vector, uint64_t count, sc_TYPES type) {
+    if (vector == NULL || vector->size != count || vector->type != stats_type(type)) {
+        return -1;
+    }
+    return 0;
+}
+
+
+// target is NULL when the caller does not want the statistics
+static void* create_stats_buffer(sc_vector** target, uint64_t count, sc_TYPES type, ccb_arena* arena) {
+    if (target == NULL) {
+        return NULL;
+    }
+
+    *target = sc_create_vector(count, stats_type(type), arena);
+    CCB_NOTNULL(*target, "Failed to create statistics vector");
+    return (*target)->data;
+}
+
+
+static void* create_partials(struct norm_args* args, uint64_t stride, ccb_arena* arena) {
+    uint64_t threads = sc_get_engine_thread_count();
+    uint64_t el_size = (args->type == sc_float64) ? sizeof(double) : sizeof(float);
+
+    args->partial_stride = stride;
+    args->partial = ccb_arena_malloc(arena, threads * stride * el_size);
+    CCB_NOTNULL(args->partial, "Failed to allocate partial sums");
+    memset(args->partial, 0, threads * stride * el_size);
+
+    args->partial_count = (uint64_t*)ccb_arena_malloc(arena, threads * sizeof(uint64_t));
+    CCB_NOTNULL(args->partial_count, "Failed to allocate partial counts");
+    memset(args->partial_count, 0, threads * sizeof(uint64_t));
+
+    return args->partial;
+}
+
+
+// sum the per thread partial sums of [offset, offset + count) into a vector
+static void reduce_partials(struct norm_args* args, uint64_t offset, uint64_t count, sc_vector* out) {
+    uint64_t threads = sc_get_engine_thread_count();
+
+    for (uint64_t c = 0; c < count; c++) {
+        double sum = 0.0;
+        for (uint64_t t = 0; t < threads; t++) {
+            if (args->type == sc_float64) {
+                sum += ((double*)args->partial)[t * args->partial_stride + offset + c];
+            } else {
+                sum += ((float*)args->partial)[t * args->partial_stride + offset + c];
+            }
+        }
+        sc_set_vector_element(out, c, to_sc_value(sum, out->type));
+    }
+}
+
+
+static sc_tensor* create_like(sc_tensor* x, ccb_arena* arena) {
+    sc_dimensions* dims = sc_clone_dimensions(x->dims, arena);
+    CCB_NOTNULL(dims, "Failed to clone dimensions");
+
+    sc_tensor* out = sc_create_tensor(dims, x->type, arena);
+    CCB_NOTNULL(out, "Failed to create result tensor");
+    return out;
+}
+
+
+// merge the welford state (count_b, mean_b, m2_b) into (count, mean, m2) (Chan et al.)
+static inline void welford_merge(double* count, double* mean, double* m2, double count_b, double mean_b, double m2_b) {
+    if (count_b == 0) {
+        return;
+    }
+
+    double total = *count + count_b;
+    double delta = mean_b - *mean;
+    *mean += delta * count_b / total;
+    *m2 += m2_b + delta * delta * (*count) * count_b / total;
+    *count = total;
+}
+
+
+// single pass mean / variance of a row of float32 or bfloat16, 8 welford states (one per lane) merged at the end
+static void welford_row_f32(const void* x, sc_TYPES type, uint64_t n, float* mean_out, float* var_out) {
+    __m256 mean = _mm256_setzero_ps();
+    __m256 m2 = _mm256_setzero_ps();
+    uint64_t lane_count = 0;
+
+    uint64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        lane_count++;
+        __m256 inv = _mm256_set1_ps(1.0f / (float)lane_count);
+        __m256 v = sc_load_f32x8(x, i, type);
+        __m256 delta = _mm256_sub_ps(v, mean);
+        mean = _mm256_add_ps(mean, _mm256_mul_ps(delta, inv));
+        m2 = _mm256_add_ps(m2, _mm256_mul_ps(delta, _mm256_sub_ps(v, mean)));
+    }
+
+    float lane_mean[8], lane_m2[8];
+    _mm256_storeu_ps(lane_mean, mean);
+    _mm256_storeu_ps(lane_m2, m2);
+
+    double count = 0.0, m = 0.0, s = 0.0;
+    for (int l = 0; l < 8; l++) {
+        welford_merge(&count, &m, &s, (double)lane_count, lane_mean[l], lane_m2[l]);
+    }
+
+    for (; i < n; i++) {
+        double v = sc_load_f32(x, i, type);
+        count += 1.0;
+        double delta = v - m;
+        m += delta / count;
+        s += delta * (v - m);
+    }
+
+    *mean_out = (float)m;
+    *var_out = (float)(s / (double)n);
+}
+
+
+static void welford_row_f64(const double* x, uint64_t n, double* mean_out, double* var_out) {
+    double m = 0.0, s = 0.0;
+    for (uint64_t i = 0; i < n; i++) {
+        double delta = x[i] - m;
+        m += delta / (double)(i + 1);
+        s += delta * (x[i] - m);
+    }
+
+    *mean_out = m;
+    *var_out = s / (double)n;
+}
+
+
+static float mean_square_row_f32(const void* x, sc_TYPES type, uint64_t n) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+
+    uint64_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 v0 = sc_load_f32x8(x, i, type);
+        __m256 v1 = sc_load_f32x8(x, i + 8, type);
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(v0, v0));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(v1, v1));
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = sc_load_f32x8(x, i, type);
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(v, v));
+    }
+
+    float sum = sc_hsum_f32x8(_mm256_add_ps(acc0, acc1));
+    for (; i < n; i++) {
+        float v = sc_load_f32(x, i, type);
+        sum += v * v;
+    }
+
+    return sum / (float)n;
+}
+
+
+// y = (x - mean) * rstd * gamma + beta
+static void affine_row_f32(const void* x, void* y, const void* gamma, const void* beta, sc_TYPES type, uint64_t n, float mean, float rstd) {
+    __m256 vmean = _mm256_set1_ps(mean);
+    __m256 vrstd = _mm256_set1_ps(rstd);
+
+    uint64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_sub_ps(sc_load_f32x8(x, i, type), vmean), vrstd);
+        if (gamma != NULL) {
+            v = _mm256_mul_ps(v, sc_load_f32x8(gamma, i, type));
+        }
+        if (beta != NULL) {
+            v = _mm256_add_ps(v, sc_load_f32x8(beta, i, type));
+        }
+        sc_store_f32x8(y, i, v, type);
+    }
+
+    for (; i < n; i++) {
+        float v = (sc_load_f32(x, i, type) - mean) * rstd;
+        if (gamma != NULL) {
+            v *= sc_load_f32(gamma, i, type);
+        }
+        if (beta != NULL) {
+            v += sc_load_f32(beta, i, type);
+        }
+        sc_store_f32(y, i, v, type);
+    }
+}
+
+
+static void affine_row_f64(const double* x, double* y, const double* gamma, const double* beta, uint64_t n, double mean, double rstd) {
+    for (uint64_t i = 0; i < n; i++) {
+        double v = (x[i] - mean) * rstd;
+        if (gamma != NULL) {
+            v *= gamma[i];
+        }
+        if (beta != NULL) {
+            v += beta[i];
+        }
+        y[i] = v;
+    }
+}
+
+
+/*
+    backward of a normalised row, xhat = (x - mean) * rstd, g = dy * gamma
+    dx = rstd * (g - mean(g) - xhat * mean(g * xhat))
+    layer norm uses the mean(g) term, rms norm does not (center = 0)
+    the gradients of gamma and beta are accumulated in the thread partials
+*/
+static void backward_row_f32(const void* x, const void* dy, void* dx, const void* gamma, sc_TYPES type, uint64_t n,
+                             float mean, float rstd, int center, float* dgamma, float* dbeta) {
+    __m256 vmean = _mm256_set1_ps(mean);
+    __m256 vrstd = _mm256_set1_ps(rstd);
+    __m256 sum_g = _mm256_setzero_ps();
+    __m256 sum_gx = _mm256_setzero_ps();
+
+    uint64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 vdy = sc_load_f32x8(dy, i, type);
+        __m256 xhat = _mm256_mul_ps(_mm256_sub_ps(sc_load_f32x8(x, i, type), vmean), vrstd);
+        __m256 g = (gamma != NULL) ? _mm256_mul_ps(vdy, sc_load_f32x8(gamma, i, type)) : vdy;
+
+        sum_g = _mm256_add_ps(sum_g, g);
+        sum_gx = _mm256_add_ps(sum_gx, _mm256_mul_ps(g, xhat));
+
+        _mm256_storeu_ps(&dgamma[i], _mm256_add_ps(_mm256_loadu_ps(&dgamma[i]), _mm256_mul_ps(vdy, xhat)));
+        if (dbeta != NULL) {
+            _mm256_storeu_ps(&dbeta[i], _mm256_add_ps(_mm256_loadu_ps(&dbeta[i]), vdy));
+        }
+    }
+
+    float s_g = sc_hsum_f32x8(sum_g);
+    float s_gx = sc_hsum_f32x8(sum_gx);
+    uint64_t tail = i;
+    for (; i < n; i++) {
+        float vdy = sc_load_f32(dy, i, type);
+        float xhat = (sc_load_f32(x, i, type) - mean) * rstd;
+        float g = (gamma != NULL) ? vdy * sc_load_f32(gamma, i, type) : vdy;
+
+        s_g += g;
+        s_gx += g * xhat;
+        dgamma[i] += vdy * xhat;
+        if (dbeta != NULL) {
+            dbeta[i] += vdy;
+        }
+    }
+
+    float mean_g = center ? s_g / (float)n : 0.0f;
+    float mean_gx = s_gx / (float)n;
+    __m256 vmean_g = _mm256_set1_ps(mean_g);
+    __m256 vmean_gx = _mm256_set1_ps(mean_gx);
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        __m256 vdy = sc_load_f32x8(dy, i, type);
+        __m256 xhat = _mm256_mul_ps(_mm256_sub_ps(sc_load_f32x8(x, i, type), vmean), vrstd);
+        __m256 g = (gamma != NULL) ? _mm256_mul_ps(vdy, sc_load_f32x8(gamma, i, type)) : vdy;
+
+        __m256 v = _mm256_sub_ps(_mm256_sub_ps(g, vmean_g), _mm256_mul_ps(xhat, vmean_gx));
+        sc_store_f32x8(dx, i, _mm256_mul_ps(v, vrstd), type);
+    }
+
+    for (i = tail; i < n; i++) {
+        float vdy = sc_load_f32(dy, i, type);
+        float xhat = (sc_load_f32(x, i, type) - mean) * rstd;
+        float g = (gamma != NULL) ? vdy * sc_load_f32(gamma, i, type) : vdy;
+
+        sc_store_f32(dx, i, rstd * (g - mean_g - xhat * mean_gx), type);
+    }
+}
+
+
+static void backward_row_f64(const double* x, const double* dy, double* dx, const double* gamma, uint64_t n,
+                             double mean, double rstd, int center, double* dgamma, double* dbeta) {
+    double s_g = 0.0, s_gx = 0.0;
+
+    for (uint64_t i = 0; i < n; i++) {
+        double xhat = (x[i] - mean) * rstd;
+        double g = (gamma != NULL) ? dy[i] * gamma[i] : dy[i];
+
+        s_g += g;
+        s_gx += g * xhat;
+        dgamma[i] += dy[i] * xhat;
+        if (dbeta != NULL) {
+            dbeta[i] += dy[i];
+        }
+    }
+
+    double mean_g = center ? s_g / (double)n : 0.0;
+    double mean_gx = s_gx / (double)n;
+
+    for (uint64_t i = 0; i < n; i++) {
+        double xhat = (x[i] - mean) * rstd;
+        double g = (gamma != NULL) ? dy[i] * gamma[i] : dy[i];
+        dx[i] = rstd * (g - mean_g - xhat * mean_gx);
+    }
+}
+
+
+// #################
+// row wise kernels
+// #################
+
+static int layer_norm_kernel(void* _args, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct norm_args* args = (struct norm_args*)_args;
+    uint64_t n = args->cols;
+
+    for (uint64_t r = start; r < end; r++) {
+        if (args->type == sc_float64) {
+            double* x = (double*)args->x + r * n;
+            double* y = (double*)args->y + r * n;
+            double mean, var;
+
+            welford_row_f64(x, n, &mean, &var);
+            double rstd = 1.0 / sqrt(var + args->eps);
+            affine_row_f64(x, y, (double*)args->gamma, (double*)args->beta, n, mean, rstd);
+
+            if (args->mean != NULL) {
+                ((double*)args->mean)[r] = mean;
+                ((double*)args->rstd)[r] = rstd;
+            }
+
+        } else {
+            uint64_t el_size = (args->type == sc_float16) ? 2 : 4;
+            void* x = (unsigned char*)args->x + r * n * el_size;
+            void* y = (unsigned char*)args->y + r * n * el_size;
+            float mean, var;
+
+            welford_row_f32(x, args->type, n, &mean, &var);
+            float rstd = 1.0f / sqrtf(var + (float)args->eps);
+            affine_row_f32(x, y, args->gamma, args->beta, args->type, n, mean, rstd);
+
+            if (args->mean != NULL) {
+                ((float*)args->mean)[r] = mean;
+                ((float*)args->rstd)[r] = rstd;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+static int rms_norm_kernel(void* _args, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct norm_args* args = (struct norm_args*)_args;
+    uint64_t n = args->cols;
+
+    for (uint64_t r = start; r < end; r++) {
+        if (args->type == sc_float64) {
+            double* x = (double*)args->x + r * n;
+            double* y = (double*)args->y + r * n;
+
+            double sum = 0.0;
+            for (uint64_t i = 0; i < n; i++) {
+                sum += x[i] * x[i];
+            }
+            double rstd = 1.0 / sqrt(sum / (double)n + args->eps);
+            affine_row_f64(x, y, (double*)args->gamma, NULL, n, 0.0, rstd);
+
+            if (args->rstd != NULL) {
+                ((double*)args->rstd)[r] = rstd;
+            }
+
+        } else {
+            uint64_t el_size = (args->type == sc_float16) ? 2 : 4;
+            void* x = (unsigned char*)args->x + r * n * el_size;
+            void* y = (unsigned char*)args->y + r * n * el_size;
+
+            float rstd = 1.0f / sqrtf(mean_square_row_f32(x, args->type, n) + (float)args->eps);
+            affine_row_f32(x, y, args->gamma, NULL, args->type, n, 0.0f, rstd);
+
+            if (args->rstd != NULL) {
+                ((float*)args->rstd)[r] = rstd;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+// shared by layer norm (mean != NULL) and rms norm (mean == NULL)
+static int row_norm_backward_kernel(void* _args, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct norm_args* args = (struct norm_args*)_args;
+    uint64_t n = args->cols;
+    int center = args->mean != NULL;
+
+    for (uint64_t r = start; r < end; r++) {
+        if (args->type == sc_float64) {
+            double* partial = (double*)args->partial + thread_id * args->partial_stride;
+            double mean = center ? ((double*)args->mean)[r] : 0.0;
+
+            backward_row_f64((double*)args->x + r * n, (double*)args->dy + r * n, (double*)args->dx + r * n,
+                             (double*)args->gamma, n, mean, ((double*)args->rstd)[r], center,
+                             partial, center ? partial + n : NULL);
+
+        } else {
+            float* partial = (float*)args->partial + thread_id * args->partial_stride;
+            uint64_t el_size = (args->type == sc_float16) ? 2 : 4;
+            uint64_t offset = r * n * el_size;
+            float mean = center ? ((float*)args->mean)[r] : 0.0f;
+
+            backward_row_f32((unsigned char*)args->x + offset, (unsigned char*)args->dy + offset, (unsigned char*)args->dx + offset,
+                             args->gamma, args->type, n, mean, ((float*)args->rstd)[r], center,
+                             partial, center ? partial + n : NULL);
+        }
+    }
+
+    return 0;
+}
+
+
+// ######################
+// channel wise kernels
+// ######################
+
+// per thread welford state of each channel over the rows [start, end)
+static int batch_norm_stats_kernel(void* _args, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct norm_args* args = (struct norm_args*)_args;
+    uint64_t n = args->cols;
+    uint64_t count = 0;
+
+    if (args->type == sc_float64) {
+        double* mean = (double*)args->partial + thread_id * args->partial_stride;
+        double* m2 = mean + n;
+
+        for (uint64_t r = start; r < end; r++) {
+            const double* x = (double*)args->x + r * n;
+            count++;
+            double inv = 1.0 / (double)count;
+
+            for (uint64_t c = 0; c < n; c++) {
+                double delta = x[c] - mean[c];
+                mean[c] += delta * inv;
+                m2[c] += delta * (x[c] - mean[c]);
+            }
+        }
+
+    } else {
+        float* mean = (float*)args->partial + thread_id * args->partial_stride;
+        float* m2 = mean + n;
+        uint64_t el_size = (args->type == sc_float16) ? 2 : 4;
+
+        for (uint64_t r = start; r < end; r++) {
+            const void* x = (unsigned char*)args->x + r * n * el_size;
+            count++;
+            float inv = 1.0f / (float)count;
+            __m256 vinv = _mm256_set1_ps(inv);
+
+            uint64_t c = 0;
+            for (; c + 8 <= n; c += 8) {
+                __m256 v = sc_load_f32x8(x, c, args->type);
+                __m256 m = _mm256_loadu_ps(&mean[c]);
+                __m256 delta = _mm256_sub_ps(v, m);
+                m = _mm256_add_ps(m, _mm256_mul_ps(delta, vinv));
+                _mm256_storeu_ps(&mean[c], m);
+                _mm256_storeu_ps(&m2[c], _mm256_add_ps(_mm256_loadu_ps(&m2[c]), _mm256_mul_ps(delta, _mm256_sub_ps(v, m))));
+            }
+            for (; c < n; c++) {
+                float v = sc_load_f32(x, c, args->type);
+                float delta = v - mean[c];
+                mean[c] += delta * inv;
+                m2[c] += delta * (v - mean[c]);
+            }
+        }
+    }
+
+    args->partial_count[thread_id] = count;
+    return 0;
+}
+
+
+// out = x * coef_a + coef_b (+ dy * coef_c when dy is set), coefficients per channel
+static int channel_affine_kernel(void* _args, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct norm_args* args = (struct norm_args*)_args;
+    uint64_t n = args->cols;
+    void* out = (args->dy != NULL) ? args->dx : args->y;
+
+    for (uint64_t r = start; r < end; r++) {
+        if (args->type == sc_float64) {
+            const double* x = (double*)args->x + r * n;
+            const double* dy = (args->dy != NULL) ? (double*)args->dy + r * n : NULL;
+            double* y = (double*)out + r * n;
+            const double* a = (double*)args->coef_a;
+            const double* b = (double*)args->coef_b;
+            const double* c = (double*)args->coef_c;
+
+            for (uint64_t i = 0; i < n; i++) {
+                double v = x[i] * a[i] + b[i];
+                if (dy != NULL) {
+                    v += dy[i] * c[i];
+                }
+                y[i] = v;
+            }
+
+        } else {
+            uint64_t el_size = (args->type == sc_float16) ? 2 : 4;
+            const void* x = (unsigned char*)args->x + r * n * el_size;
+            const void* dy = (args->dy != NULL) ? (unsigned char*)args->dy + r * n * el_size : NULL;
+            void* y = (unsigned char*)out + r * n * el_size;
+            const float* a = (float*)args->coef_a;
+            const float* b = (float*)args->coef_b;
+            const float* c = (float*)args->coef_c;
+
+            uint64_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256 v = _mm256_add_ps(_mm256_mul_ps(sc_load_f32x8(x, i, args->type), _mm256_loadu_ps(&a[i])), _mm256_loadu_ps(&b[i]));
+                if (dy != NULL) {
+                    v = _mm256_add_ps(v, _mm256_mul_ps(sc_load_f32x8(dy, i, args->type), _mm256_loadu_ps(&c[i])));
+                }
+                sc_store_f32x8(y, i, v, args->type);
+            }
+            for (; i < n; i++) {
+                float v = sc_load_f32(x, i, args->type) * a[i] + b[i];
+                if (dy != NULL) {
+                    v += sc_load_f32(dy, i, args->type) * c[i];
+                }
+                sc_store_f32(y, i, v, args->type);
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+// per thread sums of dy and dy * xhat for each channel
+static int batch_norm_backward_reduce_kernel(void* _args, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct norm_args* args = (struct norm_args*)_args;
+    uint64_t n = args->cols;
+
+    if (args->type == sc_float64) {
+        double* sum_dy = (double*)args->partial + thread_id * args->partial_stride;
+        double* sum_dyx = sum_dy + n;
+        const double* mean = (double*)args->mean;
+        const double* rstd = (double*)args->rstd;
+
+        for (uint64_t r = start; r < end; r++) {
+            const double* x = (double*)args->x + r * n;
+            const double* dy = (double*)args->dy + r * n;
+            for (uint64_t c = 0; c < n; c++) {
+                sum_dy[c] += dy[c];
+                sum_dyx[c] += dy[c] * (x[c] - mean[c]) * rstd[c];
+            }
+        }
+
+    } else {
+        float* sum_dy = (float*)args->partial + thread_id * args->partial_stride;
+        float* sum_dyx = sum_dy + n;
+        const float* mean = (float*)args->mean;
+        const float* rstd = (float*)args->rstd;
+        uint64_t el_size = (args->type == sc_float16) ? 2 : 4;
+
+        for (uint64_t r = start; r < end; r++) {
+            const void* x = (unsigned char*)args->x + r * n * el_size;
+            const void* dy = (unsigned char*)args->dy + r * n * el_size;
+
+            uint64_t c = 0;
+            for (; c + 8 <= n; c += 8) {
+                __m256 vdy = sc_load_f32x8(dy, c, args->type);
+                __m256 xhat = _mm256_mul_ps(_mm256_sub_ps(sc_load_f32x8(x, c, args->type), _mm256_loadu_ps(&mean[c])), _mm256_loadu_ps(&rstd[c]));
+                _mm256_storeu_ps(&sum_dy[c], _mm256_add_ps(_mm256_loadu_ps(&sum_dy[c]), vdy));
+                _mm256_storeu_ps(&sum_dyx[c], _mm256_add_ps(_mm256_loadu_ps(&sum_dyx[c]), _mm256_mul_ps(vdy, xhat)));
+            }
+            for (; c < n; c++) {
+                float vdy = sc_load_f32(dy, c, args->type);
+                sum_dy[c] += vdy;
+                sum_dyx[c] += vdy * (sc_load_f32(x, c, args->type) - mean[c]) * rstd[c];
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+// ##############
+// layer norm api
+// ##############
+
+sc_tensor* sc_layer_norm_inplace(sc_tensor* x, sc_vector* gamma, sc_vector* beta, double eps, sc_norm_stats* stats, ccb_arena* arena) {
+    uint64_t rows, cols;
+    if (check_norm_input(x, gamma, beta, &rows, &cols) != 0) {
+        return NULL;
+    }
+
+    struct norm_args args = {0};
+    args.type = x->type;
+    args.rows = rows;
+    args.cols = cols;
+    args.eps = eps;
+    args.x = x->data;
+    args.y = x->data;
+    args.gamma = (gamma != NULL) ? gamma->data : NULL;
+    args.beta = (beta != NULL) ? beta->data : NULL;
+    args.mean = create_stats_buffer((stats != NULL) ? &stats->mean : NULL, rows, x->type, arena);
+    args.rstd = create_stats_buffer((stats != NULL) ? &stats->rstd : NULL, rows, x->type, arena);
+
+    if (sc_run_range_task(layer_norm_kernel, &args, rows, x->size, arena) != 0) {
+        CCB_ERROR("Failed to execute layer norm task");
+        return NULL;
+    }
+
+    return x;
+}
+
+
+sc_tensor* sc_layer_norm(sc_tensor* x, sc_vector* gamma, sc_vector* beta, double eps, sc_norm_stats* stats, ccb_arena* arena) {
+    uint64_t rows, cols;
+    if (check_norm_input(x, gamma, beta, &rows, &cols) != 0) {
+        return NULL;
+    }
+
+    sc_tensor* out = create_like(x, arena);
+
+    struct norm_args args = {0};
+    args.type = x->type;
+    args.rows = rows;
+    args.cols = cols;
+    args.eps = eps;
+    args.x = x->data;
+    args.y = out->data;
+    args.gamma = (gamma != NULL) ? gamma->data : NULL;
+    args.beta = (beta != NULL) ? beta->data : NULL;
+    args.mean = create_stats_buffer((stats != NULL) ? &stats->mean : NULL, rows, x->type, arena);
+    args.rstd = create_stats_buffer((stats != NULL) ? &stats->rstd : NULL, rows, x->type, arena);
+
+    if (sc_run_range_task(layer_norm_kernel, &args, rows, x->size, arena) != 0) {
+        CCB_ERROR("Failed to execute layer norm task");
+        return NULL;
+    }
+
+    return out;
+}
+
+
+static sc_tensor* row_norm_backward(sc_tensor* dy, sc_tensor* x, sc_vector* gamma, sc_norm_stats* stats, sc_vector* dgamma, sc_vector* dbeta, int center, ccb_arena* arena) {
+    uint64_t rows, cols;
+    if (check_norm_input(x, gamma, NULL, &rows, &cols) != 0 || check_same_shape(dy, x) != 0) {
+        return NULL;
+    }
+
+    CCB_NOTNULL(stats, "stats is NULL");
+    if (check_stats(stats->rstd, rows, x->type) != 0 || (center && check_stats(stats->mean, rows, x->type) != 0)) {
+        CCB_ERROR("Statistics do not match the input (%" PRIu64 " rows)", rows);
+        return NULL;
+    }
+
+    if ((dgamma != NULL && dgamma->size != cols) || (dbeta != NULL && dbeta->size != cols)) {
+        CCB_ERROR("Gradient vectors must have %" PRIu64 " elements", cols);
+        return NULL;
+    }
+
+    sc_tensor* dx = create_like(x, arena);
+
+    struct norm_args args = {0};
+    args.type = x->type;
+    args.rows = rows;
+    args.cols = cols;
+    args.x = x->data;
+    args.dy = dy->data;
+    args.dx = dx->data;
+    args.gamma = (gamma != NULL) ? gamma->data : NULL;
+    args.mean = center ? stats->mean->data : NULL;
+    args.rstd = stats->rstd->data;
+    create_partials(&args, 2 * cols, arena);
+
+    if (sc_run_range_task(row_norm_backward_kernel, &args, rows, x->size, arena) != 0) {
+        CCB_ERROR("Failed to execute normalisation backward task");
+        return NULL;
+    }
+
+    if (dgamma != NULL) {
+        reduce_partials(&args, 0, cols, dgamma);
+    }
+    if (dbeta != NULL) {
+        reduce_partials(&args, cols, cols, dbeta);
+    }
+
+    return dx;
+}
+
+
+sc_tensor* sc_layer_norm_backward(sc_tensor* dy, sc_tensor* x, sc_vector* gamma, sc_norm_stats* stats, sc_vector* dgamma, sc_vector* dbeta, ccb_arena* arena) {
+    return row_norm_backward(dy, x, gamma, stats, dgamma, dbeta, 1, arena);
+}
+
+
+// ############
+// rms norm api
+// ############
+
+sc_tensor* sc_rms_norm_inplace(sc_tensor* x, sc_vector* gamma, double eps, sc_norm_stats* stats, ccb_arena* arena) {
+    uint64_t rows, cols;
+    if (check_norm_input(x, gamma, NULL, &rows, &cols) != 0) {
+        return NULL;
+    }
+
+    struct norm_args args = {0};
+    args.type = x->type;
+    args.rows = rows;
+    args.cols = cols;
+    args.eps = eps;
+    args.x = x->data;
+    args.y = x->data;
+    args.gamma = (gamma != NULL) ? gamma->data : NULL;
+    args.rstd = create_stats_buffer((stats != NULL) ? &stats->rstd : NULL, rows, x->type, arena);
+    if (stats != NULL) {
+        stats->mean = NULL;
+    }
+
+    if (sc_run_range_task(rms_norm_kernel, &args, rows, x->size, arena) != 0) {
+        CCB_ERROR("Failed to execute rms norm task");
+        return NULL;
+    }
+
+    return x;
+}
+
+
+sc_tensor* sc_rms_norm(sc_tensor* x, sc_vector* gamma, double eps, sc_norm_stats* stats, ccb_arena* arena) {
+    uint64_t rows, cols;
+    if (check_norm_input(x, gamma, NULL, &rows, &cols) != 0) {
+        return NULL;
+    }
+
+    sc_tensor* out = create_like(x, arena);
+
+    struct norm_args args = {0};
+    args.type = x->type;
+    args.rows = rows;
+    args.cols = cols;
+    args.eps = eps;
+    args.x = x->data;
+    args.y = out->data;
+    args.gamma = (gamma != NULL) ? gamma->data : NULL;
+    args.rstd = create_stats_buffer((stats != NULL) ? &stats->rstd : NULL, rows, x->type, arena);
+    if (stats != NULL) {
+        stats->mean = NULL;
+    }
+
+    if (sc_run_range_task(rms_norm_kernel, &args, rows, x->size, arena) != 0) {
+        CCB_ERROR("Failed to execute rms norm task");
+        return NULL;
+    }
+
+    return out;
+}
+
+
+sc_tensor* sc_rms_norm_backward(sc_tensor* dy, sc_tensor* x, sc_vector* gamma, sc_norm_stats* stats, sc_vector* dgamma, ccb_arena* arena) {
+    return row_norm_backward(dy, x, gamma, stats, dgamma, NULL, 0, arena);
+}
+
+
+// ##############
+// batch norm api
+// ##############
+
+// coef_a / coef_b / coef_c hold cols values of the statistics type
+static void create_coefficients(struct norm_args* args, ccb_arena* arena) {
+    uint64_t el_size = (args->type == sc_float64) ? sizeof(double) : sizeof(float);
+
+    args->coef_a = ccb_arena_malloc(arena, args->cols * el_size);
+    args->coef_b = ccb_arena_malloc(arena, args->cols * el_size);
+    args->coef_c = ccb_arena_malloc(arena, args->cols * el_size);
+    CCB_NOTNULL(args->coef_a, "Failed to allocate coefficients");
+    CCB_NOTNULL(args->coef_b, "Failed to allocate coefficients");
+    CCB_NOTNULL(args->coef_c, "Failed to allocate coefficients");
+}
+
+
+static void set_stat(void* buffer, sc_TYPES type, uint64_t index, double value) {
+    if (type == sc_float64) {
+        ((double*)buffer)[index] = value;
+    } else {
+        ((float*)buffer)[index] = (float)value;
+    }
+}
+
+
+static double get_stat(void* buffer, sc_TYPES type, uint64_t index) {
+    if (type == sc_float64) {
+        return ((double*)buffer)[index];
+    }
+    return ((float*)buffer)[index];
+}
+
+
+static double get_param(sc_vector* vector, uint64_t index, double fallback) {
+    if (vector == NULL) {
+        return fallback;
+    }
+    return sc_value_to_f64(sc_get_vector_element(vector, index));
+}
+
+
+sc_tensor* sc_batch_norm(sc_tensor* x, sc_vector* gamma, sc_vector* beta, sc_vector* running_mean, sc_vector* running_var, double momentum, double eps, sc_norm_stats* stats, ccb_arena* arena) {
+    uint64_t rows, cols;
+    if (check_norm_input(x, gamma, beta, &rows, &cols) != 0) {
+        return NULL;
+    }
+
+    if ((running_mean != NULL && running_mean->size != cols) || (running_var != NULL && running_var->size != cols)) {
+        CCB_ERROR("Running statistics must have %" PRIu64 " elements", cols);
+        return NULL;
+    }
+
+    sc_tensor* out = create_like(x, arena);
+
+    struct norm_args args = {0};
+    args.type = x->type;
+    args.rows = rows;
+    args.cols = cols;
+    args.eps = eps;
+    args.x = x->data;
+    args.y = out->data;
+    create_partials(&args, 2 * cols, arena);
+    create_coefficients(&args, arena);
+
+    if (sc_run_range_task(batch_norm_stats_kernel, &args, rows, x->size, arena) != 0) {
+        CCB_ERROR("Failed to execute batch norm statistics task");
+        return NULL;
+    }
+
+    void* mean_out = create_stats_buffer((stats != NULL) ? &stats->mean : NULL, cols, x->type, arena);
+    void* rstd_out = create_stats_buffer((stats != NULL) ? &stats->rstd : NULL, cols, x->type, arena);
+    uint64_t threads = sc_get_engine_thread_count();
+
+    // merge the thread states in thread order and fold gamma / beta in the coefficients
+    for (uint64_t c = 0; c < cols; c++) {
+        double count = 0.0, mean = 0.0, m2 = 0.0;
+        for (uint64_t t = 0; t < threads; t++) {
+            uint64_t base = t * args.partial_stride;
+            welford_merge(&count, &mean, &m2, (double)args.partial_count[t],
+                          get_stat(args.partial, x->type, base + c), get_stat(args.partial, x->type, base + cols + c));
+        }
+
+        double var = m2 / (double)rows;
+        double rstd = 1.0 / sqrt(var + eps);
+        double scale = get_param(gamma, c, 1.0) * rstd;
+
+        set_stat(args.coef_a, x->type, c, scale);
+        set_stat(args.coef_b, x->type, c, get_param(beta, c, 0.0) - mean * scale);
+
+        if (mean_out != NULL) {
+            set_stat(mean_out, x->type, c, mean);
+            set_stat(rstd_out, x->type, c, rstd);
+        }
+
+        if (running_mean != NULL) {
+            double value = (1.0 - momentum) * sc_value_to_f64(sc_get_vector_element(running_mean, c)) + momentum * mean;
+            sc_set_vector_element(running_mean, c, to_sc_value(value, running_mean->type));
+        }
+        if (running_var != NULL) {
+            double unbiased = (rows > 1) ? m2 / (double)(rows - 1) : var;
+            double value = (1.0 - momentum) * sc_value_to_f64(sc_get_vector_element(running_var, c)) + momentum * unbiased;
+            sc_set_vector_element(running_var, c, to_sc_value(value, running_var->type));
+        }
+    }
+
+    if (sc_run_range_task(channel_affine_kernel, &args, rows, x->size, arena) != 0) {
+        CCB_ERROR("Failed to execute batch norm task");
+        return NULL;
+    }
+
+    return out;
+}
+
+
+sc_tensor* sc_batch_norm_inference(sc_tensor* x, sc_vector* gamma, sc_vector* beta, sc_vector* running_mean, sc_vector* running_var, double eps, ccb_arena* arena) {
+    uint64_t rows, cols;
+    if (check_norm_input(x, gamma, beta, &rows, &cols) != 0) {
+        return NULL;
+    }
+
+    CCB_NOTNULL(running_mean, "running_mean is NULL");
+    CCB_NOTNULL(running_var, "running_var is NULL");
+    if (running_mean->size != cols || running_var->size != cols) {
+        CCB_ERROR("Running statistics must have %" PRIu64 " elements", cols);
+        return NULL;
+    }
+
+    sc_tensor* out = create_like(x, arena);
+
+    struct norm_args args = {0};
+    args.type = x->type;
+    args.rows = rows;
+    args.cols = cols;
+    args.x = x->data;
+    args.y = out->data;
+    create_coefficients(&args, arena);
+
+    for (uint64_t c = 0; c < cols; c++) {
+        double rstd = 1.0 / sqrt(sc_value_to_f64(sc_get_vector_element(running_var, c)) + eps);
+        double scale = get_param(gamma, c, 1.0) * rstd;
+        double mean = sc_value_to_f64(sc_get_vector_element(running_mean, c));
+
+        set_stat(args.coef_a, x->type, c, scale);
+        set_stat(args.coef_b, x->type, c, get_param(beta, c, 0.0) - mean * scale);
+    }
+
+    if (sc_run_range_task(channel_affine_kernel, &args, rows, x->size, arena) != 0) {
+        CCB_ERROR("Failed to execute batch norm task");
+        return NULL;
+    }
+
+    return out;
+}
+
+
+sc_tensor* sc_batch_norm_backward(sc_tensor* dy, sc_tensor* x, sc_vector* gamma, sc_norm_stats* stats, sc_vector* dgamma, sc_vector* dbeta, ccb_arena* arena) {
+    uint64_t rows, cols;
+    if (check_norm_input(x, gamma, NULL, &rows, &cols) != 0 || check_same_shape(dy, x) != 0) {
+        return NULL;
+    }
+
+    CCB_NOTNULL(stats, "stats is NULL");
+    if (check_stats(stats->mean, cols, x->type) != 0 || check_stats(stats->rstd, cols, x->type) != 0) {
+        CCB_ERROR("Statistics do not match the input (%" PRIu64 " channels)", cols);
+        return NULL;
+    }
+
+    if ((dgamma != NULL && dgamma->size != cols) || (dbeta != NULL && dbeta->size != cols)) {
+        CCB_ERROR("Gradient vectors must have %" PRIu64 " elements", cols);
+        return NULL;
+    }
+
+    sc_tensor* dx = create_like(x, arena);
+
+    struct norm_args args = {0};
+    args.type = x->type;
+    args.rows = rows;
+    args.cols = cols;
+    args.x = x->data;
+    args.dy = dy->data;
+    args.dx = dx->data;
+    args.mean = stats->mean->data;
+    args.rstd = stats->rstd->data;
+    create_partials(&args, 2 * cols, arena);
+    create_coefficients(&args, arena);
+
+    if (sc_run_range_task(batch_norm_backward_reduce_kernel, &args, rows, x->size, arena) != 0) {
+        CCB_ERROR("Failed to execute batch norm backward task");
+        return NULL;
+    }
+
+    if (dbeta != NULL) {
+        reduce_partials(&args, 0, cols, dbeta);
+    }
+    if (dgamma != NULL) {
+        reduce_partials(&args, cols, cols, dgamma);
+    }
+
+    // dx = k * (dy - mean(dy) - xhat * mean(dy * xhat)), k = gamma * rstd, expanded to dx = x * a + b + dy * c
+    uint64_t threads = sc_get_engine_thread_count();
+    for (uint64_t c = 0; c < cols; c++) {
+        double sum_dy = 0.0, sum_dyx = 0.0;
+        for (uint64_t t = 0; t < threads; t++) {
+            sum_dy += get_stat(args.partial, x->type, t * args.partial_stride + c);
+            sum_dyx += get_stat(args.partial, x->type, t * args.partial_stride + cols + c);
+        }
+
+        double mean = get_stat(args.mean, x->type, c);
+        double rstd = get_stat(args.rstd, x->type, c);
+        double k = get_param(gamma, c, 1.0) * rstd;
+        double mean_dy = sum_dy / (double)rows;
+        double mean_dyx = sum_dyx / (double)rows;
+
+        set_stat(args.coef_a, x->type, c, -k * rstd * mean_dyx);
+        set_stat(args.coef_b, x->type, c, -k * mean_dy + k * rstd * mean * mean_dyx);
+        set_stat(args.coef_c, x->type, c, k);
+    }
+
+    if (sc_run_range_task(channel_affine_kernel, &args, rows, x->size, arena) != 0) {
+        CCB_ERROR("Failed to execute batch norm backward task");
+        return NULL;
+    }
+
+    return dx;
+}
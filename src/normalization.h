@@ -0,0 +1,117 @@
+#ifndef __NORMALIZATION_H__
+#define __NORMALIZATION_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    fused normalisation kernels for neural networks
+    the statistics are computed in a single pass (Welford) and a second pass applies scale and shift
+    a row is the last dimension of the tensor, layer and rms norm normalise each row,
+    batch norm normalise each column (channel) over all the rows
+    float32 and bfloat16 inputs are accumulated in float32, float64 inputs in float64
+*/
+
+/*
+    statistics saved by a forward pass and consumed by the backward pass
+    - mean: mean per row (layer norm) or per channel (batch norm), NULL for rms norm
+    - rstd: 1/sqrt(var + eps) per row or per channel
+    both vectors are float32 (float64 for float64 inputs)
+*/
+typedef struct {
+    sc_vector* mean;
+    sc_vector* rstd;
+} sc_norm_stats;
+
+
+/* Layer normalisation of each row of a tensor: (x - mean) / sqrt(var + eps) * gamma + beta
+   - sc_tensor* x: input tensor, the last dimension is normalised
+   - sc_vector* gamma: scale (size = last dimension, same type as x), NULL for 1
+   - sc_vector* beta: shift (size = last dimension, same type as x), NULL for 0
+   - double eps: value added to the variance
+   - sc_norm_stats* stats: filled with the statistics needed by the backward pass, may be NULL
+   - ccb_arena* arena: arena where the result and the statistics will be allocated
+   - return: a pointer to the result tensor
+*/
+sc_tensor* sc_layer_norm(sc_tensor* x, sc_vector* gamma, sc_vector* beta, double eps, sc_norm_stats* stats, ccb_arena* arena);
+/* Layer normalisation of each row of a tensor, in-place.
+   - same arguments as sc_layer_norm, the arena only holds the statistics
+   - return: a pointer to the result tensor (x)
+   !! the value in the tensor will be replaced by the results
+*/
+sc_tensor* sc_layer_norm_inplace(sc_tensor* x, sc_vector* gamma, sc_vector* beta, double eps, sc_norm_stats* stats, ccb_arena* arena);
+/* Backward pass of the layer normalisation.
+   - sc_tensor* dy: gradient of the output
+   - sc_tensor* x: input of the forward pass
+   - sc_vector* gamma: scale used by the forward pass, NULL for 1
+   - sc_norm_stats* stats: statistics saved by the forward pass
+   - sc_vector* dgamma: receives the gradient of gamma, may be NULL
+   - sc_vector* dbeta: receives the gradient of beta, may be NULL
+   - ccb_arena* arena: arena where the gradient of x will be allocated
+   - return: a pointer to the gradient of x
+*/
+sc_tensor* sc_layer_norm_backward(sc_tensor* dy, sc_tensor* x, sc_vector* gamma, sc_norm_stats* stats, sc_vector* dgamma, sc_vector* dbeta, ccb_arena* arena);
+
+/* RMS normalisation of each row of a tensor: x / sqrt(mean(x^2) + eps) * gamma
+   - sc_tensor* x: input tensor, the last dimension is normalised
+   - sc_vector* gamma: scale (size = last dimension, same type as x), NULL for 1
+   - double eps: value added to the mean square
+   - sc_norm_stats* stats: filled with the statistics needed by the backward pass, may be NULL
+   - ccb_arena* arena: arena where the result and the statistics will be allocated
+   - return: a pointer to the result tensor
+*/
+sc_tensor* sc_rms_norm(sc_tensor* x, sc_vector* gamma, double eps, sc_norm_stats* stats, ccb_arena* arena);
+/* RMS normalisation of each row of a tensor, in-place.
+   - same arguments as sc_rms_norm, the arena only holds the statistics
+   - return: a pointer to the result tensor (x)
+   !! the value in the tensor will be replaced by the results
+*/
+sc_tensor* sc_rms_norm_inplace(sc_tensor* x, sc_vector* gamma, double eps, sc_norm_stats* stats, ccb_arena* arena);
+/* Backward pass of the RMS normalisation.
+   - sc_tensor* dy: gradient of the output
+   - sc_tensor* x: input of the forward pass
+   - sc_vector* gamma: scale used by the forward pass, NULL for 1
+   - sc_norm_stats* stats: statistics saved by the forward pass
+   - sc_vector* dgamma: receives the gradient of gamma, may be NULL
+   - ccb_arena* arena: arena where the gradient of x will be allocated
+   - return: a pointer to the gradient of x
+*/
+sc_tensor* sc_rms_norm_backward(sc_tensor* dy, sc_tensor* x, sc_vector* gamma, sc_norm_stats* stats, sc_vector* dgamma, ccb_arena* arena);
+
+/* Batch normalisation (training mode), each channel (last dimension) is normalised over all the rows
+   - sc_tensor* x: input tensor, channels last (NC, NHWC, ...)
+   - sc_vector* gamma: scale per channel (same type as x), NULL for 1
+   - sc_vector* beta: shift per channel (same type as x), NULL for 0
+   - sc_vector* running_mean: updated with momentum if not NULL (statistics type)
+   - sc_vector* running_var: updated with momentum if not NULL, unbiased variance (statistics type)
+   - double momentum: running = (1 - momentum) * running + momentum * batch
+   - double eps: value added to the variance
+   - sc_norm_stats* stats: filled with the statistics needed by the backward pass, may be NULL
+   - ccb_arena* arena: arena where the result, the statistics and the scratch will be allocated
+   - return: a pointer to the result tensor
+*/
+sc_tensor* sc_batch_norm(sc_tensor* x, sc_vector* gamma, sc_vector* beta, sc_vector* running_mean, sc_vector* running_var, double momentum, double eps, sc_norm_stats* stats, ccb_arena* arena);
+/* Batch normalisation (inference mode) with the running statistics
+   - sc_tensor* x: input tensor, channels last
+   - sc_vector* gamma, beta: scale and shift per channel, NULL for 1 and 0
+   - sc_vector* running_mean, running_var: statistics per channel (statistics type)
+   - double eps: value added to the variance
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the result tensor
+*/
+sc_tensor* sc_batch_norm_inference(sc_tensor* x, sc_vector* gamma, sc_vector* beta, sc_vector* running_mean, sc_vector* running_var, double eps, ccb_arena* arena);
+/* Backward pass of the batch normalisation (training mode).
+   - sc_tensor* dy: gradient of the output
+   - sc_tensor* x: input of the forward pass
+   - sc_vector* gamma: scale used by the forward pass, NULL for 1
+   - sc_norm_stats* stats: statistics saved by the forward pass
+   - sc_vector* dgamma: receives the gradient of gamma, may be NULL
+   - sc_vector* dbeta: receives the gradient of beta, may be NULL
+   - ccb_arena* arena: arena where the gradient of x and the scratch will be allocated
+   - return: a pointer to the gradient of x
+*/
+sc_tensor* sc_batch_norm_backward(sc_tensor* dy, sc_tensor* x, sc_vector* gamma, sc_norm_stats* stats, sc_vector* dgamma, sc_vector* dbeta, ccb_arena* arena);
+
+
+#endif // __NORMALIZATION_H__
@@ -0,0 +1,382 @@
+#include "data.h"
+#include "optim.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+// elements of a work unit
+#define OPTIM_CHUNK 4096
+
+
+// per step constants of the update, the same for all the elements
+struct optim_coeffs {
+    sc_optim_kind kind;
+    double l2;              // added to the gradient
+    double decay;           // decoupled decay factor of the parameters
+    double momentum;
+    int nesterov;
+    double beta1;
+    double beta2;
+    double eps;
+    double rate;            // learning rate, divided by the first moment bias correction for Adam
+    double v_scale;         // 1 / sqrt of the second moment bias correction for Adam
+};
+
+struct optim_args {
+    struct optim_coeffs c;
+    uint64_t size;
+    sc_TYPES param_type;
+    sc_TYPES grad_type;
+    void* param;
+    const void* grad;
+    float* master;
+    void* m;
+    void* v;
+    int stochastic;
+    uint32_t key;           // stochastic rounding key of the step
+};
+
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+
+// noise of the stochastic rounding of an element (murmur3 finalizer)
+static inline uint32_t rounding_noise(uint32_t key, uint32_t index) {
+    uint32_t h = (index * 0x9E3779B9u) ^ key;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h & 0xffff;
+}
+
+
+// rounds up with a probability equal to the fraction of the dropped bits
+static inline uint16_t round_bf16_stochastic(float value, uint32_t noise) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    if ((bits & 0x7fffffff) > 0x7f800000) {
+        return (uint16_t)((bits >> 16) | 0x0040);
+    }
+    return (uint16_t)((bits + noise) >> 16);
+}
+
+
+// update of one element, m and v are NULL when the optimiser does not keep them
+#define OPTIM_UPDATE(SUFFIX, T, SQRT)                                                                           \
+static inline T update_##SUFFIX(const struct optim_coeffs* c, T p, T g, T* m, T* v) {                          \
+    g += (T)c->l2 * p;                                                                                         \
+    p *= (T)c->decay;                                                                                          \
+    T u;                                                                                                       \
+    switch (c->kind) {                                                                                         \
+        case sc_optim_sgd:                                                                                     \
+            if (m == NULL) {                                                                                   \
+                u = g;                                                                                         \
+                break;                                                                                         \
+            }                                                                                                  \
+            *m = (T)c->momentum * *m + g;                                                                      \
+            u = c->nesterov ? g + (T)c->momentum * *m : *m;                                                    \
+            break;                                                                                             \
+        case sc_optim_rmsprop:                                                                                 \
+            *v = (T)c->beta2 * *v + (T)(1.0 - c->beta2) * g * g;                                               \
+            u = g / (SQRT(*v) + (T)c->eps);                                                                    \
+            if (m != NULL) {                                                                                   \
+                *m = (T)c->momentum * *m + u;                                                                  \
+                u = *m;                                                                                        \
+            }                                                                                                  \
+            break;                                                                                             \
+        default:                                                                                               \
+            *m = (T)c->beta1 * *m + (T)(1.0 - c->beta1) * g;                                                   \
+            *v = (T)c->beta2 * *v + (T)(1.0 - c->beta2) * g * g;                                               \
+            u = *m / (SQRT(*v) * (T)c->v_scale + (T)c->eps);                                                   \
+            break;                                                                                             \
+    }                                                                                                          \
+    return p - (T)c->rate * u;                                                                                 \
+}
+
+OPTIM_UPDATE(f32, float, sqrtf)
+OPTIM_UPDATE(f64, double, sqrt)
+
+
+static void step_f64(const struct optim_args* args, uint64_t start, uint64_t end) {
+    double* p = (double*)args->param;
+    const double* g = (const double*)args->grad;
+    double* m = (double*)args->m;
+    double* v = (double*)args->v;
+    for (uint64_t i = start; i < end; i++) {
+        p[i] = update_f64(&args->c, p[i], g[i], (m != NULL) ? m + i : NULL, (v != NULL) ? v + i : NULL);
+    }
+}
+
+
+// float32 and bfloat16 parameters, one element
+static inline void step_f32_element(const struct optim_args* args, uint64_t i) {
+    float* m = (float*)args->m;
+    float* v = (float*)args->v;
+    float p = (args->master != NULL) ? args->master[i] : sc_load_f32(args->param, i, args->param_type);
+    float g = sc_load_f32(args->grad, i, args->grad_type);
+    p = update_f32(&args->c, p, g, (m != NULL) ? m + i : NULL, (v != NULL) ? v + i : NULL);
+    if (args->master != NULL) {
+        args->master[i] = p;
+    }
+    if (args->param_type == sc_float16 && args->stochastic) {
+        ((uint16_t*)args->param)[i] = round_bf16_stochastic(p, rounding_noise(args->key, (uint32_t)i));
+    } else {
+        sc_store_f32(args->param, i, p, args->param_type);
+    }
+}
+
+
+static void step_f32(const struct optim_args* args, uint64_t start, uint64_t end) {
+    for (uint64_t i = start; i < end; i++) {
+        step_f32_element(args, i);
+    }
+}
+
+
+static inline SC_TARGET_AVX2 __m256i rounding_noise_x8(uint32_t key, uint64_t index) {
+    __m256i h = _mm256_add_epi32(_mm256_set1_epi32((int)(uint32_t)index), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    h = _mm256_xor_si256(_mm256_mullo_epi32(h, _mm256_set1_epi32((int)0x9E3779B9u)), _mm256_set1_epi32((int)key));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)0x85EBCA6Bu));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)0xC2B2AE35u));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    return _mm256_and_si256(h, _mm256_set1_epi32(0xffff));
+}
+
+
+static inline SC_TARGET_AVX2 void store_bf16x8_stochastic(uint16_t* dst, __m256 value, __m256i noise) {
+    __m256i bits = _mm256_castps_si256(value);
+    __m256i rounded = _mm256_add_epi32(bits, noise);
+    // NaN stays a quiet NaN instead of being carried into the sign bit
+    __m256 nan = _mm256_cmp_ps(value, value, _CMP_UNORD_Q);
+    __m256i quiet = _mm256_or_si256(bits, _mm256_set1_epi32(0x00400000));
+    rounded = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(rounded), _mm256_castsi256_ps(quiet), nan));
+    rounded = _mm256_srli_epi32(rounded, 16);
+    __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(rounded), _mm256_extracti128_si256(rounded, 1));
+    _mm_storeu_si128((__m128i*)dst, packed);
+}
+
+
+static SC_TARGET_AVX2 void step_f32_avx2(const struct optim_args* args, uint64_t start, uint64_t end) {
+    const struct optim_coeffs* c = &args->c;
+    float* m = (float*)args->m;
+    float* v = (float*)args->v;
+    __m256 l2 = _mm256_set1_ps((float)c->l2);
+    __m256 decay = _mm256_set1_ps((float)c->decay);
+    __m256 momentum = _mm256_set1_ps((float)c->momentum);
+    __m256 beta1 = _mm256_set1_ps((float)c->beta1);
+    __m256 beta1_c = _mm256_set1_ps((float)(1.0 - c->beta1));
+    __m256 beta2 = _mm256_set1_ps((float)c->beta2);
+    __m256 beta2_c = _mm256_set1_ps((float)(1.0 - c->beta2));
+    __m256 eps = _mm256_set1_ps((float)c->eps);
+    __m256 rate = _mm256_set1_ps((float)c->rate);
+    __m256 v_scale = _mm256_set1_ps((float)c->v_scale);
+
+    uint64_t i = start;
+    for (; i + 8 <= end; i += 8) {
+        __m256 p = (args->master != NULL) ? _mm256_loadu_ps(args->master + i) : sc_load_f32x8(args->param, i, args->param_type);
+        __m256 g = _mm256_fmadd_ps(l2, p, sc_load_f32x8(args->grad, i, args->grad_type));
+        p = _mm256_mul_ps(p, decay);
+        __m256 u;
+        switch (c->kind) {
+            case sc_optim_sgd:
+                if (m == NULL) {
+                    u = g;
+                    break;
+                }
+                u = _mm256_fmadd_ps(momentum, _mm256_loadu_ps(m + i), g);
+                _mm256_storeu_ps(m + i, u);
+                if (c->nesterov) {
+                    u = _mm256_fmadd_ps(momentum, u, g);
+                }
+                break;
+            case sc_optim_rmsprop: {
+                __m256 vi = _mm256_fmadd_ps(beta2, _mm256_loadu_ps(v + i), _mm256_mul_ps(beta2_c, _mm256_mul_ps(g, g)));
+                _mm256_storeu_ps(v + i, vi);
+                u = _mm256_div_ps(g, _mm256_add_ps(_mm256_sqrt_ps(vi), eps));
+                if (m != NULL) {
+                    u = _mm256_fmadd_ps(momentum, _mm256_loadu_ps(m + i), u);
+                    _mm256_storeu_ps(m + i, u);
+                }
+                break;
+            }
+            default: {
+                __m256 mi = _mm256_fmadd_ps(beta1, _mm256_loadu_ps(m + i), _mm256_mul_ps(beta1_c, g));
+                __m256 vi = _mm256_fmadd_ps(beta2, _mm256_loadu_ps(v + i), _mm256_mul_ps(beta2_c, _mm256_mul_ps(g, g)));
+                _mm256_storeu_ps(m + i, mi);
+                _mm256_storeu_ps(v + i, vi);
+                u = _mm256_div_ps(mi, _mm256_fmadd_ps(_mm256_sqrt_ps(vi), v_scale, eps));
+                break;
+            }
+        }
+        p = _mm256_fnmadd_ps(rate, u, p);
+
+        if (args->master != NULL) {
+            _mm256_storeu_ps(args->master + i, p);
+        }
+        if (args->param_type == sc_float16 && args->stochastic) {
+            store_bf16x8_stochastic((uint16_t*)args->param + i, p, rounding_noise_x8(args->key, i));
+        } else {
+            sc_store_f32x8(args->param, i, p, args->param_type);
+        }
+    }
+    for (; i < end; i++) {
+        step_f32_element(args, i);
+    }
+}
+
+
+static int optim_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct optim_args* args = (struct optim_args*)raw;
+    uint64_t first = start * OPTIM_CHUNK;
+    uint64_t last = (end * OPTIM_CHUNK < args->size) ? end * OPTIM_CHUNK : args->size;
+    if (args->param_type == sc_float64) {
+        step_f64(args, first, last);
+    } else if (sc_has_avx2_fma()) {
+        step_f32_avx2(args, first, last);
+    } else {
+        step_f32(args, first, last);
+    }
+    return 0;
+}
+
+
+sc_optim_options sc_optim_default_options(sc_optim_kind kind) {
+    sc_optim_options options;
+    options.kind = kind;
+    options.learning_rate = (kind == sc_optim_adam || kind == sc_optim_adamw) ? 1e-3 : 1e-2;
+    options.momentum = (kind == sc_optim_sgd) ? 0.9 : 0.0;
+    options.nesterov = 0;
+    options.beta1 = 0.9;
+    options.beta2 = (kind == sc_optim_rmsprop) ? 0.99 : 0.999;
+    options.eps = 1e-8;
+    options.weight_decay = (kind == sc_optim_adamw) ? 1e-2 : 0.0;
+    options.master_weights = 1;
+    options.stochastic_rounding = 0;
+    options.seed = 0;
+    return options;
+}
+
+
+static void* create_moment(uint64_t size, sc_TYPES type, ccb_arena* arena) {
+    uint64_t bytes = size * ((type == sc_float64) ? sizeof(double) : sizeof(float));
+    void* moment = ccb_arena_malloc(arena, bytes);
+    CCB_NOTNULL(moment, "Failed to allocate optimiser moment");
+    memset(moment, 0, bytes);
+    return moment;
+}
+
+
+sc_optim_state* sc_optim_create(sc_vector* param, const sc_optim_options* options, ccb_arena* arena) {
+    CCB_NOTNULL(param, "param is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (param->type != sc_float16 && param->type != sc_float32 && param->type != sc_float64) {
+        CCB_ERROR("Optimisers need bfloat16, float32 or float64 parameters, got type %d", param->type);
+        return NULL;
+    }
+    sc_optim_options defaults = sc_optim_default_options(sc_optim_adam);
+    if (options == NULL) {
+        options = &defaults;
+    }
+    if (options->kind != sc_optim_sgd && options->kind != sc_optim_adam && options->kind != sc_optim_adamw &&
+        options->kind != sc_optim_rmsprop) {
+        CCB_ERROR("Unknown optimiser %d", options->kind);
+        return NULL;
+    }
+
+    sc_optim_state* state = (sc_optim_state*)ccb_arena_malloc(arena, sizeof(sc_optim_state));
+    CCB_NOTNULL(state, "Failed to allocate optimiser state");
+    memset(state, 0, sizeof(sc_optim_state));
+    state->options = *options;
+    state->type = param->type;
+    state->size = param->size;
+
+    int first = options->kind == sc_optim_adam || options->kind == sc_optim_adamw || options->momentum != 0.0;
+    int second = options->kind != sc_optim_sgd;
+    if (first && (state->m = create_moment(param->size, param->type, arena)) == NULL) {
+        return NULL;
+    }
+    if (second && (state->v = create_moment(param->size, param->type, arena)) == NULL) {
+        return NULL;
+    }
+    if (param->type == sc_float16 && options->master_weights) {
+        state->master = (float*)ccb_arena_malloc(arena, param->size * sizeof(float));
+        CCB_NOTNULL(state->master, "Failed to allocate master weights");
+        for (uint64_t i = 0; i < param->size; i++) {
+            state->master[i] = sc_load_f32(param->data, i, sc_float16);
+        }
+    }
+    return state;
+}
+
+
+int sc_optim_step(sc_optim_state* state, sc_vector* param, sc_vector* grad, ccb_arena* arena) {
+    CCB_NOTNULL(state, "state is NULL");
+    CCB_NOTNULL(param, "param is NULL");
+    CCB_NOTNULL(grad, "grad is NULL");
+    if (param->type != state->type || param->size != state->size) {
+        CCB_ERROR("The parameters do not match the optimiser state (%" PRIu64 " elements of type %d)", state->size, state->type);
+        return -1;
+    }
+    if (grad->size != param->size || (grad->type != param->type && !(param->type == sc_float16 && grad->type == sc_float32))) {
+        CCB_ERROR("The gradient (%" PRIu64 " elements of type %d) does not match the parameters", grad->size, grad->type);
+        return -1;
+    }
+
+    const sc_optim_options* options = &state->options;
+    state->step++;
+    struct optim_args args;
+    memset(&args, 0, sizeof(args));
+    args.c.kind = options->kind;
+    args.c.momentum = options->momentum;
+    args.c.nesterov = options->nesterov;
+    args.c.beta1 = options->beta1;
+    args.c.beta2 = options->beta2;
+    args.c.eps = options->eps;
+    args.c.rate = options->learning_rate;
+    args.c.v_scale = 1.0;
+    args.c.l2 = options->weight_decay;
+    args.c.decay = 1.0;
+    if (options->kind == sc_optim_adamw) {
+        args.c.l2 = 0.0;
+        args.c.decay = 1.0 - options->learning_rate * options->weight_decay;
+    }
+    if (options->kind == sc_optim_adam || options->kind == sc_optim_adamw) {
+        args.c.rate = options->learning_rate / (1.0 - pow(options->beta1, (double)state->step));
+        args.c.v_scale = 1.0 / sqrt(1.0 - pow(options->beta2, (double)state->step));
+    }
+
+    args.size = param->size;
+    args.param_type = param->type;
+    args.grad_type = grad->type;
+    args.param = param->data;
+    args.grad = grad->data;
+    args.master = state->master;
+    args.m = state->m;
+    args.v = state->v;
+    args.stochastic = options->stochastic_rounding;
+    args.key = (uint32_t)splitmix64(options->seed ^ splitmix64(state->step));
+
+    uint64_t chunks = (param->size + OPTIM_CHUNK - 1) / OPTIM_CHUNK;
+    if (chunks > 0 && sc_run_range_task(optim_kernel, &args, chunks, param->size, arena) != 0) {
+        CCB_ERROR("Failed to run optimiser step");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef __OPTIM_H__
+#define __OPTIM_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    fused in place optimiser updates: one pass reads the parameters, the gradients and the moments once
+    and writes the parameters and the moments once, on the engine thread pool (AVX2 FMA when available)
+    bfloat16 parameters are updated from float32 master weights kept in the state, without master weights
+    the update is computed in float32 and rounded back to bfloat16, to nearest or stochastically
+    the stochastic rounding noise only depends on the seed, the step and the element index (not on the thread count)
+    float32 and bfloat16 parameters keep float32 moments, float64 parameters keep float64 moments
+*/
+
+typedef enum {
+    sc_optim_sgd,           // SGD with optional (Nesterov) momentum
+    sc_optim_adam,
+    sc_optim_adamw,         // Adam with decoupled weight decay
+    sc_optim_rmsprop,       // RMSProp with optional momentum
+} sc_optim_kind;
+
+typedef struct {
+    sc_optim_kind kind;
+    double learning_rate;
+    double momentum;        // SGD and RMSProp, 0 for none
+    int nesterov;           // SGD
+    double beta1;           // Adam
+    double beta2;           // Adam, RMSProp smoothing
+    double eps;
+    double weight_decay;    // L2 added to the gradient, decoupled for AdamW
+    int master_weights;     // bfloat16 parameters: keep a float32 copy
+    int stochastic_rounding;// bfloat16 parameters: round the written values stochastically instead of to nearest
+    uint64_t seed;
+} sc_optim_options;
+
+typedef struct {
+    sc_optim_options options;
+    sc_TYPES type;          // of the parameters
+    uint64_t size;
+    uint64_t step;          // updates done
+    float* master;          // float32 copy of bfloat16 parameters, NULL otherwise
+    void* m;                // momentum or first moment, NULL when unused
+    void* v;                // second moment, NULL when unused
+} sc_optim_state;
+
+
+/* Default options of an optimiser (Adam betas 0.9 / 0.999, AdamW decay 0.01, SGD momentum 0.9, RMSProp 0.99) */
+sc_optim_options sc_optim_default_options(sc_optim_kind kind);
+/* Creates the state of the optimiser of one parameter vector
+   - sc_vector* param: parameters, bfloat16, float32 or float64, the master weights are copied from it
+   - const sc_optim_options* options: NULL for sc_optim_default_options(sc_optim_adam)
+   - ccb_arena* arena: arena where the state will be allocated
+   - return: a pointer to the state, the moments are 0
+*/
+sc_optim_state* sc_optim_create(sc_vector* param, const sc_optim_options* options, ccb_arena* arena);
+/* Updates the parameters in place with one step
+   - sc_vector* param: same vector (size and type) as the one of sc_optim_create, tensors can be viewed as vectors
+   - sc_vector* grad: gradient, same type as the parameters (float32 is also accepted for bfloat16 parameters)
+   - ccb_arena* arena: arena where the tasks will be allocated
+   - return: 0 on success
+*/
+int sc_optim_step(sc_optim_state* state, sc_vector* param, sc_vector* grad, ccb_arena* arena);
+
+
+#endif // __OPTIM_H__
@@ -1,7 +1,26 @@
 #include "scandium.h"
 
 #include <time.h>
+#include <string.h>
+#include <math.h>
 #define STRESS_TEST_ITERATIONS 100
+#define CONV_BENCHMARK_ITERATIONS 5
+#define TRANSPOSE_BENCHMARK_ITERATIONS 10
+#define SPARSE_BENCHMARK_ITERATIONS 10
+#define QUANT_BENCHMARK_ITERATIONS 10
+#define HALF_BENCHMARK_ITERATIONS 10
+#define INT_BENCHMARK_ITERATIONS 10
+#define CAST_BENCHMARK_ITERATIONS 10
+#define FUSED_BENCHMARK_ITERATIONS 10
+#define LINREG_BENCHMARK_ITERATIONS 5
+#define LOGREG_BENCHMARK_ITERATIONS 3
+#define NN_BENCHMARK_ITERATIONS 10
+#define AUTODIFF_BENCHMARK_ITERATIONS 20
+#define OPTIM_BENCHMARK_ITERATIONS 10
+#define RANDOM_BENCHMARK_ITERATIONS 10
+#define FACTOR_BENCHMARK_ITERATIONS 3
+#define GEOMETRY_BENCHMARK_ITERATIONS 10
+#define DISTANCE_BENCHMARK_ITERATIONS 3
 
 
 
@@ -37,6 +56,1516 @@ void stress_test(sc_vector* a, sc_vector* b) {
 }
 
 
+// clock() adds the time of every thread on linux, the benchmarks of the multi threaded kernels use the wall time
+double wall_time(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+// no argument runs every benchmark, otherwise only the named ones
+int benchmark_selected(int argc, char** argv, const char* name) {
+    if (argc < 2) {
+        return 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+sc_tensor* random_tensor(uint64_t dims_count, uint64_t* dims, ccb_arena* arena) {
+    sc_tensor* tensor = sc_create_tensor(sc_create_dimensions(dims_count, arena, dims), sc_float32, arena);
+    CCB_NOTNULL(tensor, "Failed to create tensor");
+
+    float* data = (float*)tensor->data;
+    for (uint64_t i = 0; i < tensor->size; i++) {
+        data[i] = (float)rand() / (float)RAND_MAX - 0.5f;
+    }
+    return tensor;
+}
+
+
+typedef struct {
+    const char* name;
+    uint64_t batch, in_c, in_h, in_w;
+    uint64_t out_c, k_h, k_w;
+    uint64_t stride, padding;
+} conv_layer;
+
+
+void conv_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    // typical CNN layers (lenet / resnet), in_h = 1 is a 1d convolution
+    conv_layer layers[] = {
+        {"lenet conv 5x5 1->32",     8,   1,  28,   28,   32, 5, 5, 1, 2},
+        {"mnist conv 3x3 1->32",     8,   1,  28,   28,   32, 3, 3, 1, 1},
+        {"lenet conv 5x5 6->16",     8,   6,  14,   14,   16, 5, 5, 1, 0},
+        {"resnet stem 7x7/2 3->64",  8,   3, 224,  224,   64, 7, 7, 2, 3},
+        {"resnet 3x3 64->64",        8,  64,  56,   56,   64, 3, 3, 1, 1},
+        {"resnet 3x3 256->256",      8, 256,  14,   14,  256, 3, 3, 1, 1},
+        {"resnet 1x1 256->1024",     8, 256,  14,   14, 1024, 1, 1, 1, 0},
+        {"conv1d 3 128->128",        8, 128,   1, 1024,  128, 1, 3, 1, 1},
+    };
+    sc_conv_algorithm algorithms[] = {sc_conv_direct, sc_conv_im2col};
+    const char* algorithm_names[] = {"direct", "im2col"};
+
+    printf("\nConvolution benchmark (float32, %d iterations)\n", CONV_BENCHMARK_ITERATIONS);
+    for (uint64_t l = 0; l < sizeof(layers) / sizeof(conv_layer); l++) {
+        conv_layer c = layers[l];
+        int is_1d = (c.in_h == 1);
+
+        sc_tensor* x = is_1d ? random_tensor(3, (uint64_t[]){c.batch, c.in_c, c.in_w}, arena)
+                             : random_tensor(4, (uint64_t[]){c.batch, c.in_c, c.in_h, c.in_w}, arena);
+        sc_tensor* w = is_1d ? random_tensor(3, (uint64_t[]){c.out_c, c.in_c, c.k_w}, arena)
+                             : random_tensor(4, (uint64_t[]){c.out_c, c.in_c, c.k_h, c.k_w}, arena);
+
+        for (int a = 0; a < 2; a++) {
+            sc_conv_params params = is_1d ? sc_conv1d_params(c.stride, c.padding, 1) : sc_conv2d_params(c.stride, c.padding, 1);
+            params.algorithm = algorithms[a];
+
+            sc_tensor* y = NULL;
+            double start = 0.0;
+            for (int i = 0; i <= CONV_BENCHMARK_ITERATIONS; i++) {
+                if (i == 1) start = wall_time(); // first run is a warm up
+                ccb_arena_reset(scratch);
+                y = is_1d ? sc_conv1d(x, w, NULL, params, scratch, scratch) : sc_conv2d(x, w, NULL, params, scratch, scratch);
+                CCB_NOTNULL(y, "Failed to run the convolution");
+            }
+            double time_spent = (wall_time() - start) / CONV_BENCHMARK_ITERATIONS;
+            double flops = 2.0 * (double)y->size * (double)(c.in_c * c.k_h * c.k_w);
+
+            printf("%-26s %-6s: %8.3f ms, %7.2f GFlop/s\n", c.name, algorithm_names[a], time_spent * 1e3, flops / time_spent * 1e-9);
+        }
+    }
+
+    sc_tensor* x = random_tensor(4, (uint64_t[]){8, 64, 112, 112}, arena);
+    double start = wall_time();
+    for (int i = 0; i < CONV_BENCHMARK_ITERATIONS; i++) {
+        ccb_arena_reset(scratch);
+        CCB_NOTNULL(sc_max_pool2d(x, sc_pool2d_params(3, 2, 1), scratch), "Failed to run the max pooling");
+    }
+    printf("%-26s %-6s: %8.3f ms\n", "resnet max pool 3x3/2", "", (wall_time() - start) / CONV_BENCHMARK_ITERATIONS * 1e3);
+
+    start = wall_time();
+    for (int i = 0; i < CONV_BENCHMARK_ITERATIONS; i++) {
+        ccb_arena_reset(scratch);
+        CCB_NOTNULL(sc_avg_pool2d(x, sc_pool2d_params(2, 2, 0), scratch), "Failed to run the avg pooling");
+    }
+    printf("%-26s %-6s: %8.3f ms\n", "avg pool 2x2/2", "", (wall_time() - start) / CONV_BENCHMARK_ITERATIONS * 1e3);
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void transpose_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    struct {
+        const char* name;
+        uint64_t dims_count;
+        uint64_t dims[4];
+        uint64_t axes[4];
+    } cases[] = {
+        {"matrix 4099x4101",         2, {4099, 4101},        {1, 0}},
+        {"matrix 4096x4096",         2, {4096, 4096},        {1, 0}},
+        {"NCHW -> NHWC 32x64x56x56", 4, {32, 64, 56, 56},    {0, 2, 3, 1}},
+        {"NHWC -> NCHW 32x56x56x64", 4, {32, 56, 56, 64},    {0, 3, 1, 2}},
+        {"heads 64x128x16x64",       4, {64, 128, 16, 64},   {0, 2, 1, 3}},
+    };
+
+    printf("\nTranspose benchmark (float32, %d iterations)\n", TRANSPOSE_BENCHMARK_ITERATIONS);
+    for (uint64_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        sc_tensor* x = random_tensor(cases[c].dims_count, cases[c].dims, arena);
+
+        double start = 0.0;
+        for (int i = 0; i <= TRANSPOSE_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            ccb_arena_reset(scratch);
+            CCB_NOTNULL(sc_tensor_permute(x, cases[c].axes, scratch), "Failed to run the permutation");
+        }
+        double time_spent = (wall_time() - start) / TRANSPOSE_BENCHMARK_ITERATIONS;
+        double bytes = 2.0 * (double)x->size * sizeof(float);
+
+        printf("%-26s: %8.3f ms, %6.2f GB/s\n", cases[c].name, time_spent * 1e3, bytes / time_spent * 1e-9);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void sparse_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    // 99% zeros, the dense products are the baseline
+    uint64_t size = 8000;
+    uint64_t n = 64;
+    sc_tensor* dense = random_tensor(2, (uint64_t[]){size, size}, arena);
+    float* data = (float*)dense->data;
+    for (uint64_t i = 0; i < dense->size; i++) {
+        if (rand() % 100 != 0) data[i] = 0.0f;
+    }
+    sc_tensor* x = random_tensor(2, (uint64_t[]){size, 1}, arena);
+    sc_tensor* b = random_tensor(2, (uint64_t[]){size, n}, arena);
+    sc_vector xv = {x->data, x->size, x->type};
+
+    double start = wall_time();
+    sc_sparse_matrix* a = sc_dense_to_sparse_matrix(dense, sc_sparse_csr, arena);
+    CCB_NOTNULL(a, "Failed to convert the matrix");
+    printf("\nSparse benchmark (float32 %lux%lu, %lu nonzeros, %d iterations)\n", (unsigned long)size, (unsigned long)size, (unsigned long)a->nnz, SPARSE_BENCHMARK_ITERATIONS);
+    printf("%-26s: %8.3f ms\n", "dense -> CSR", (wall_time() - start) * 1e3);
+
+    const char* names[] = {"SpMV", "dense matrix x vector", "SpMM (n = 64)", "dense matmul (n = 64)"};
+    for (int c = 0; c < 4; c++) {
+        start = wall_time();
+        for (int i = 0; i < SPARSE_BENCHMARK_ITERATIONS; i++) {
+            ccb_arena_reset(scratch);
+            void* out = NULL;
+            switch (c) {
+                case 0: out = sc_spmv(a, &xv, scratch); break;
+                case 1: out = sc_tensor_matmul(dense, x, scratch); break;
+                case 2: out = sc_spmm(a, b, scratch); break;
+                default: out = sc_tensor_matmul(dense, b, scratch); break;
+            }
+            CCB_NOTNULL(out, "Failed to run %s", names[c]);
+        }
+        printf("%-26s: %8.3f ms\n", names[c], (wall_time() - start) / SPARSE_BENCHMARK_ITERATIONS * 1e3);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void quant_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    // dense layer 4096 -> 4096, weights [out, in] with per channel scales, the float baseline uses the transposed weights
+    uint64_t n = 4096;
+    uint64_t k = 4096;
+    sc_tensor* w = random_tensor(2, (uint64_t[]){n, k}, arena);
+    sc_tensor* wt = sc_tensor_transpose(w, arena);
+    sc_qtensor* qw = sc_quantize(w, sc_qint8, 1, 0, arena);
+    CCB_NOTNULL(qw, "Failed to quantise the weights");
+
+    printf("\nQuantised benchmark (dense layer %lux%lu, %d iterations)\n", (unsigned long)n, (unsigned long)k, QUANT_BENCHMARK_ITERATIONS);
+    uint64_t batches[] = {1, 8, 64};
+    for (uint64_t b = 0; b < sizeof(batches) / sizeof(uint64_t); b++) {
+        uint64_t m = batches[b];
+        sc_tensor* x = random_tensor(2, (uint64_t[]){m, k}, arena);
+        sc_qtensor* qx = sc_quantize(x, sc_quint8, 0, -1, arena);
+        CCB_NOTNULL(qx, "Failed to quantise the activations");
+
+        double times[2];
+        for (int c = 0; c < 2; c++) {
+            double start = 0.0;
+            for (int i = 0; i <= QUANT_BENCHMARK_ITERATIONS; i++) {
+                if (i == 1) start = wall_time(); // first run is a warm up
+                ccb_arena_reset(scratch);
+                void* out = (c == 0) ? (void*)sc_qgemm(qx, qw, NULL, sc_float32, scratch) : (void*)sc_tensor_matmul(x, wt, scratch);
+                CCB_NOTNULL(out, "Failed to run the product");
+            }
+            times[c] = (wall_time() - start) / QUANT_BENCHMARK_ITERATIONS;
+        }
+
+        double ops = 2.0 * (double)(m * n * k);
+        printf("batch %-4lu int8 %8.3f ms (%6.2f GOp/s), float32 %8.3f ms (%6.2f GFlop/s)\n", (unsigned long)m,
+               times[0] * 1e3, ops / times[0] * 1e-9, times[1] * 1e3, ops / times[1] * 1e-9);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void half_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    uint64_t size = 1 << 24;
+    float* wide = (float*)ccb_arena_malloc(arena, size * sizeof(float));
+    uint16_t* narrow = (uint16_t*)ccb_arena_malloc(arena, size * sizeof(uint16_t));
+    CCB_NOTNULL(wide, "Failed to allocate the float32 buffer");
+    CCB_NOTNULL(narrow, "Failed to allocate the half buffer");
+    for (uint64_t i = 0; i < size; i++) {
+        wide[i] = (float)rand() / (float)RAND_MAX * 200.0f - 100.0f;
+    }
+
+    printf("\nHalf precision benchmark (%lu elements, %d iterations)\n", (unsigned long)size, HALF_BENCHMARK_ITERATIONS);
+    for (int c = 0; c < 2; c++) {
+        double start = 0.0;
+        for (int i = 0; i <= HALF_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            if (c == 0) {
+                sc_convert_f32_to_half(wide, narrow, size);
+            } else {
+                sc_convert_half_to_f32(narrow, wide, size);
+            }
+        }
+        double time_spent = (wall_time() - start) / HALF_BENCHMARK_ITERATIONS;
+        double bytes = (double)size * (sizeof(float) + sizeof(uint16_t));
+        printf("%-26s: %8.3f ms, %6.2f GB/s\n", (c == 0) ? "float32 -> half" : "half -> float32", time_spent * 1e3, bytes / time_spent * 1e-9);
+    }
+
+    sc_TYPES types[] = {sc_float32, sc_float16, sc_half};
+    const char* names[] = {"vector add float32", "vector add bfloat16", "vector add half"};
+    for (int t = 0; t < 3; t++) {
+        sc_vector* a = sc_create_vector(size, types[t], arena);
+        sc_vector* b = sc_create_vector(size, types[t], arena);
+        CCB_NOTNULL(a, "Failed to create vector a");
+        CCB_NOTNULL(b, "Failed to create vector b");
+        memset(a->data, 0, size * ((types[t] == sc_float32) ? 4 : 2));
+        memset(b->data, 0, size * ((types[t] == sc_float32) ? 4 : 2));
+
+        double start = 0.0;
+        for (int i = 0; i <= HALF_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            ccb_arena_reset(scratch);
+            CCB_NOTNULL(sc_vector_add(a, b, scratch), "Failed to add the vectors");
+        }
+        double time_spent = (wall_time() - start) / HALF_BENCHMARK_ITERATIONS;
+        printf("%-26s: %8.3f ms, %6.2f Gop/s\n", names[t], time_spent * 1e3, (double)size / time_spent * 1e-9);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void int_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    uint64_t size = 1 << 24;
+    sc_vector* x = sc_create_vector(size, sc_float32, arena);
+    CCB_NOTNULL(x, "Failed to create vector x");
+    for (uint64_t i = 0; i < size; i++) {
+        ((float*)x->data)[i] = (float)rand() / (float)RAND_MAX * 200.0f;
+    }
+
+    printf("\nInteger benchmark (%lu elements, %d iterations)\n", (unsigned long)size, INT_BENCHMARK_ITERATIONS);
+    sc_TYPES types[] = {sc_float32, sc_int32, sc_int64, sc_uint8};
+    const char* names[] = {"float32", "int32", "int64", "uint8"};
+    for (int t = 0; t < 4; t++) {
+        sc_vector* a = sc_vector_cast(x, types[t], arena);
+        CCB_NOTNULL(a, "Failed to cast the vector");
+
+        double times[3];
+        for (int c = 0; c < 3; c++) {
+            double start = 0.0;
+            for (int i = 0; i <= INT_BENCHMARK_ITERATIONS; i++) {
+                if (i == 1) start = wall_time(); // first run is a warm up
+                ccb_arena_reset(scratch);
+                void* out = (c == 0) ? (void*)sc_vector_add(a, a, scratch) :
+                            ((c == 1) ? (void*)sc_vector_cast(x, types[t], scratch) : (void*)sc_vector_cast(a, sc_float32, scratch));
+                CCB_NOTNULL(out, "Failed to run the operation");
+            }
+            times[c] = (wall_time() - start) / INT_BENCHMARK_ITERATIONS;
+        }
+        printf("%-8s add %8.3f ms, cast from float32 %8.3f ms, cast to float32 %8.3f ms\n", names[t], times[0] * 1e3, times[1] * 1e3, times[2] * 1e3);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void cast_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    uint64_t size = 1 << 24;
+    sc_vector* x = sc_create_vector(size, sc_float32, arena);
+    CCB_NOTNULL(x, "Failed to create vector x");
+    for (uint64_t i = 0; i < size; i++) {
+        ((float*)x->data)[i] = (float)rand() / (float)RAND_MAX * 200.0f - 100.0f;
+    }
+
+    printf("\nCast benchmark (%lu elements, %d iterations)\n", (unsigned long)size, CAST_BENCHMARK_ITERATIONS);
+    sc_TYPES from[] = {sc_float32, sc_float32, sc_float64, sc_float16, sc_float32};
+    sc_TYPES to[] = {sc_float16, sc_float64, sc_float16, sc_half, sc_half};
+    const char* names[] = {"float32 -> bfloat16", "float32 -> float64", "float64 -> bfloat16", "bfloat16 -> half", "float32 -> half"};
+    for (int p = 0; p < 5; p++) {
+        sc_vector* a = sc_vector_cast(x, from[p], arena);
+        CCB_NOTNULL(a, "Failed to cast the vector");
+
+        double times[2];
+        sc_rounding_mode modes[] = {sc_round_nearest_even, sc_round_toward_zero};
+        for (int m = 0; m < 2; m++) {
+            double start = 0.0;
+            for (int i = 0; i <= CAST_BENCHMARK_ITERATIONS; i++) {
+                if (i == 1) start = wall_time(); // first run is a warm up
+                ccb_arena_reset(scratch);
+                CCB_NOTNULL(sc_vector_cast_rounding(a, to[p], modes[m], scratch), "Failed to cast the vector");
+            }
+            times[m] = (wall_time() - start) / CAST_BENCHMARK_ITERATIONS;
+        }
+        printf("%-20s nearest %8.3f ms, toward zero %8.3f ms\n", names[p], times[0] * 1e3, times[1] * 1e3);
+    }
+
+    // mixed add against casting a copy first
+    sc_vector* b = sc_vector_cast(x, sc_float16, arena);
+    CCB_NOTNULL(b, "Failed to cast the vector");
+    double times[2];
+    for (int c = 0; c < 2; c++) {
+        double start = 0.0;
+        for (int i = 0; i <= CAST_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            ccb_arena_reset(scratch);
+            sc_vector* out = (c == 0) ? sc_vector_add(x, b, scratch) : sc_vector_add(x, sc_vector_cast(b, sc_float32, scratch), scratch);
+            CCB_NOTNULL(out, "Failed to add the vectors");
+        }
+        times[c] = (wall_time() - start) / CAST_BENCHMARK_ITERATIONS;
+    }
+    printf("float32 + bfloat16   mixed %8.3f ms, cast then add %8.3f ms\n", times[0] * 1e3, times[1] * 1e3);
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void fused_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    uint64_t size = 1 << 24;
+    printf("\nFused ops benchmark (%lu elements, %d iterations)\n", (unsigned long)size, FUSED_BENCHMARK_ITERATIONS);
+    sc_TYPES types[] = {sc_float32, sc_float64};
+    const char* names[] = {"float32", "float64"};
+    for (int t = 0; t < 2; t++) {
+        sc_vector* x = sc_create_vector(size, types[t], arena);
+        sc_vector* y = sc_create_vector(size, types[t], arena);
+        CCB_NOTNULL(x, "Failed to create vector x");
+        CCB_NOTNULL(y, "Failed to create vector y");
+        for (uint64_t i = 0; i < size; i++) {
+            sc_set_vector_element(x, i, to_sc_value((double)rand() / (double)RAND_MAX, types[t]));
+            sc_set_vector_element(y, i, to_sc_value((double)rand() / (double)RAND_MAX, types[t]));
+        }
+        sc_value_t alpha = to_sc_value(0.5, types[t]);
+        sc_value_t beta = to_sc_value(0.9, types[t]);
+
+        // axpby fused, then with the binary ops and temporaries
+        double times[2];
+        for (int c = 0; c < 2; c++) {
+            double start = 0.0;
+            for (int i = 0; i <= FUSED_BENCHMARK_ITERATIONS; i++) {
+                if (i == 1) start = wall_time(); // first run is a warm up
+                ccb_arena_reset(scratch);
+                sc_vector* out = (c == 0) ? sc_vector_axpby(alpha, x, beta, y, scratch)
+                                          : sc_vector_add(sc_vector_mul_scalar(x, alpha, scratch), sc_vector_mul_scalar(y, beta, scratch), scratch);
+                CCB_NOTNULL(out, "Failed to run axpby");
+            }
+            times[c] = (wall_time() - start) / FUSED_BENCHMARK_ITERATIONS;
+        }
+        printf("%-8s axpby fused %8.3f ms, unfused %8.3f ms\n", names[t], times[0] * 1e3, times[1] * 1e3);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void linreg_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    printf("\nLinear regression benchmark (float32, %d iterations)\n", LINREG_BENCHMARK_ITERATIONS);
+    uint64_t rows[] = {1 << 14, 1 << 16, 1 << 18};
+    uint64_t features[] = {16, 64, 256};
+    for (int r = 0; r < 3; r++) {
+        for (int f = 0; f < 3; f++) {
+            ccb_arena_reset(arena);
+            uint64_t dims[] = {rows[r], features[f]};
+            sc_tensor* x = sc_create_tensor(sc_create_dimensions(2, arena, dims), sc_float32, arena);
+            sc_vector* y = sc_create_vector(rows[r], sc_float32, arena);
+            CCB_NOTNULL(x, "Failed to create tensor x");
+            CCB_NOTNULL(y, "Failed to create vector y");
+            float* x_data = (float*)x->data;
+            float* y_data = (float*)y->data;
+            for (uint64_t i = 0; i < x->size; i++) {
+                x_data[i] = (float)rand() / (float)RAND_MAX;
+            }
+            for (uint64_t i = 0; i < rows[r]; i++) {
+                y_data[i] = (float)rand() / (float)RAND_MAX;
+            }
+
+            double start = 0.0;
+            for (int i = 0; i <= LINREG_BENCHMARK_ITERATIONS; i++) {
+                if (i == 1) start = wall_time(); // first run is a warm up
+                ccb_arena_reset(scratch);
+                sc_linreg_model* model = sc_linreg_fit(x, y, 1e-3, 1, scratch);
+                CCB_NOTNULL(model, "Failed to fit the linear regression");
+            }
+            double time_spent = (wall_time() - start) / LINREG_BENCHMARK_ITERATIONS;
+            double gflops = (double)rows[r] * (double)(features[f] + 2) * (double)(features[f] + 2) / time_spent * 1e-9;
+            printf("%8lu rows x %4lu features: %8.3f ms (%.2f GFLOPS)\n", (unsigned long)rows[r], (unsigned long)features[f], time_spent * 1e3, gflops);
+        }
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void logreg_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    uint64_t rows = 1 << 18;
+    uint64_t features = 64;
+    printf("\nLogistic regression benchmark (float32 %lux%lu, %d iterations)\n", (unsigned long)rows, (unsigned long)features, LOGREG_BENCHMARK_ITERATIONS);
+    uint64_t dims[] = {rows, features};
+    sc_tensor* x = sc_create_tensor(sc_create_dimensions(2, arena, dims), sc_float32, arena);
+    sc_vector* y = sc_create_vector(rows, sc_float32, arena);
+    CCB_NOTNULL(x, "Failed to create tensor x");
+    CCB_NOTNULL(y, "Failed to create vector y");
+    float* x_data = (float*)x->data;
+    float* y_data = (float*)y->data;
+    for (uint64_t i = 0; i < rows; i++) {
+        float z = 0.0f;
+        for (uint64_t j = 0; j < features; j++) {
+            x_data[i * features + j] = (float)rand() / (float)RAND_MAX - 0.5f;
+            z += x_data[i * features + j] * (float)((j % 5) - 2);
+        }
+        y_data[i] = (z > 0.0f) ? 1.0f : 0.0f;
+    }
+
+    // one SGD epoch with batches of 256 rows, then L-BFGS to convergence
+    sc_logreg_options options[2];
+    options[0] = sc_logreg_default_options();
+    options[0].optimizer = sc_logreg_sgd;
+    options[0].iterations = 1;
+    options[1] = sc_logreg_default_options();
+    options[1].l2 = 1e-4;
+    const char* names[] = {"sgd epoch", "lbfgs fit"};
+    for (int o = 0; o < 2; o++) {
+        double start = 0.0;
+        uint64_t iterations = 0;
+        for (int i = 0; i <= LOGREG_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            ccb_arena_reset(scratch);
+            sc_logreg_model* model = sc_logreg_fit(x, y, &options[o], scratch);
+            CCB_NOTNULL(model, "Failed to fit the logistic regression");
+            iterations = model->iterations;
+        }
+        double time_spent = (wall_time() - start) / LOGREG_BENCHMARK_ITERATIONS;
+        printf("%-10s: %9.3f ms (%lu iterations)\n", names[o], time_spent * 1e3, (unsigned long)iterations);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void nn_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* workspace = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(workspace, "Failed to create workspace arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    // 784 - 1024 (relu) - 1024 (gelu) - 10 MLP
+    uint64_t batch = 256;
+    uint64_t sizes[] = {784, 1024, 1024, 10};
+    sc_nn_network* net = sc_nn_create(sizes[0], sc_float32, 1, arena);
+    CCB_NOTNULL(net, "Failed to create network");
+    sc_nn_add_dense(net, sizes[1], sc_nn_relu, arena);
+    sc_nn_add_dropout(net, 0.1, arena);
+    sc_nn_add_dense(net, sizes[2], sc_nn_gelu, arena);
+    sc_nn_add_layer_norm(net, 1e-5, arena);
+    sc_nn_add_dense(net, sizes[3], sc_nn_identity, arena);
+    if (sc_nn_bind(net, batch, workspace) != 0) {
+        CCB_ERROR("Failed to bind network");
+        return;
+    }
+    printf("\nNeural network benchmark (float32 MLP 784-1024-1024-10, batch %lu, workspace %.2f MB, %d iterations)\n",
+           (unsigned long)batch, (double)sc_nn_workspace_size(net, batch) / (1024.0 * 1024.0), NN_BENCHMARK_ITERATIONS);
+
+    uint64_t x_dims[] = {batch, sizes[0]};
+    uint64_t y_dims[] = {batch, sizes[3]};
+    sc_tensor* x = sc_create_tensor(sc_create_dimensions(2, arena, x_dims), sc_float32, arena);
+    sc_tensor* dy = sc_create_tensor(sc_create_dimensions(2, arena, y_dims), sc_float32, arena);
+    CCB_NOTNULL(x, "Failed to create tensor x");
+    CCB_NOTNULL(dy, "Failed to create tensor dy");
+    for (uint64_t i = 0; i < x->size; i++) {
+        ((float*)x->data)[i] = (float)rand() / (float)RAND_MAX;
+    }
+    for (uint64_t i = 0; i < dy->size; i++) {
+        ((float*)dy->data)[i] = (float)rand() / (float)RAND_MAX - 0.5f;
+    }
+
+    double flops = 0.0;
+    for (int l = 0; l < 3; l++) {
+        flops += 2.0 * (double)batch * (double)sizes[l] * (double)sizes[l + 1];
+    }
+    double times[2];
+    for (int pass = 0; pass < 2; pass++) {
+        double start = 0.0;
+        for (int i = 0; i <= NN_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            ccb_arena_reset(scratch);
+            CCB_NOTNULL(sc_nn_forward(net, x, 1, scratch), "Failed to run forward pass");
+            if (pass == 1) {
+                CCB_NOTNULL(sc_nn_backward(net, dy, scratch), "Failed to run backward pass");
+            }
+        }
+        times[pass] = (wall_time() - start) / NN_BENCHMARK_ITERATIONS;
+    }
+    printf("%-18s: %8.3f ms (%.2f GFLOPS)\n", "forward", times[0] * 1e3, flops / times[0] * 1e-9);
+    printf("%-18s: %8.3f ms (%.2f GFLOPS)\n", "forward + backward", times[1] * 1e3, 3.0 * flops / times[1] * 1e-9);
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(workspace);
+    ccb_arena_free(arena);
+}
+
+
+void autodiff_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* workspace = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(workspace, "Failed to create workspace arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    // one training step of a 784 - 256 (relu) - 10 MLP with a softmax cross entropy loss
+    uint64_t batch = 256;
+    uint64_t sizes[] = {784, 256, 10};
+    printf("\nAutodiff benchmark (float32 MLP 784-256-10, batch %lu, cross entropy, %d iterations)\n", (unsigned long)batch,
+           AUTODIFF_BENCHMARK_ITERATIONS);
+
+    uint64_t x_dims[] = {batch, sizes[0]};
+    uint64_t w1_dims[] = {sizes[0], sizes[1]};
+    uint64_t w2_dims[] = {sizes[1], sizes[2]};
+    sc_tensor* x = sc_create_tensor(sc_create_dimensions(2, arena, x_dims), sc_float32, arena);
+    sc_tensor* w1 = sc_create_tensor(sc_create_dimensions(2, arena, w1_dims), sc_float32, arena);
+    sc_tensor* w2 = sc_create_tensor(sc_create_dimensions(2, arena, w2_dims), sc_float32, arena);
+    sc_tensor* b1 = sc_create_tensor(sc_create_dimensions(1, arena, &sizes[1]), sc_float32, arena);
+    sc_tensor* b2 = sc_create_tensor(sc_create_dimensions(1, arena, &sizes[2]), sc_float32, arena);
+    sc_vector* labels = sc_create_vector(batch, sc_int32, arena);
+    CCB_NOTNULL(labels, "Failed to create labels");
+    sc_tensor* tensors[] = {x, w1, w2, b1, b2};
+    for (int t = 0; t < 5; t++) {
+        CCB_NOTNULL(tensors[t], "Failed to create tensor");
+        for (uint64_t i = 0; i < tensors[t]->size; i++) {
+            ((float*)tensors[t]->data)[i] = ((float)rand() / (float)RAND_MAX - 0.5f) * ((t == 0) ? 1.0f : 0.1f);
+        }
+    }
+    for (uint64_t i = 0; i < batch; i++) {
+        ((int32_t*)labels->data)[i] = rand() % (int)sizes[2];
+    }
+
+    // the same step with the nn module and a hand written softmax cross entropy gradient
+    sc_nn_network* net = sc_nn_create(sizes[0], sc_float32, 1, arena);
+    CCB_NOTNULL(net, "Failed to create network");
+    sc_nn_add_dense(net, sizes[1], sc_nn_relu, arena);
+    sc_nn_add_dense(net, sizes[2], sc_nn_identity, arena);
+    if (sc_nn_bind(net, batch, workspace) != 0) {
+        CCB_ERROR("Failed to bind network");
+        return;
+    }
+    uint64_t y_dims[] = {batch, sizes[2]};
+    sc_tensor* dy = sc_create_tensor(sc_create_dimensions(2, arena, y_dims), sc_float32, arena);
+    CCB_NOTNULL(dy, "Failed to create tensor dy");
+
+    double times[2];
+    uint64_t used = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        double start = 0.0;
+        for (int i = 0; i <= AUTODIFF_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            ccb_arena_reset(scratch);
+            if (pass == 0) {
+                uint64_t capacity = scratch->capacity;
+                sc_tape* tape = sc_tape_create(scratch);
+                sc_var* h = sc_ad_relu(tape, sc_ad_add_bias(tape, sc_ad_matmul(tape, sc_ad_leaf(tape, x, 0), sc_ad_leaf(tape, w1, 1)), sc_ad_leaf(tape, b1, 1)));
+                sc_var* logits = sc_ad_add_bias(tape, sc_ad_matmul(tape, h, sc_ad_leaf(tape, w2, 1)), sc_ad_leaf(tape, b2, 1));
+                sc_var* loss = sc_ad_cross_entropy(tape, logits, labels);
+                CCB_NOTNULL(loss, "Failed to record the tape");
+                if (sc_tape_backward(tape, loss) != 0) {
+                    CCB_ERROR("Failed to run the tape backward");
+                    return;
+                }
+                used = capacity - scratch->capacity;
+            } else {
+                sc_tensor* y = sc_nn_forward(net, x, 1, scratch);
+                CCB_NOTNULL(y, "Failed to run forward pass");
+                for (uint64_t r = 0; r < batch; r++) {
+                    const float* row = (const float*)y->data + r * sizes[2];
+                    float* grad = (float*)dy->data + r * sizes[2];
+                    float largest = row[0];
+                    for (uint64_t j = 1; j < sizes[2]; j++) largest = (row[j] > largest) ? row[j] : largest;
+                    float total = 0.0f;
+                    for (uint64_t j = 0; j < sizes[2]; j++) {
+                        grad[j] = expf(row[j] - largest);
+                        total += grad[j];
+                    }
+                    for (uint64_t j = 0; j < sizes[2]; j++) {
+                        grad[j] = (grad[j] / total - (((int32_t*)labels->data)[r] == (int32_t)j ? 1.0f : 0.0f)) / (float)batch;
+                    }
+                }
+                CCB_NOTNULL(sc_nn_backward(net, dy, scratch), "Failed to run backward pass");
+            }
+        }
+        times[pass] = (wall_time() - start) / AUTODIFF_BENCHMARK_ITERATIONS;
+    }
+    printf("%-18s: %8.3f ms (%.2f MB of arena per step)\n", "tape", times[0] * 1e3, (double)used / (1024.0 * 1024.0));
+    printf("%-18s: %8.3f ms\n", "hand written", times[1] * 1e3);
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(workspace);
+    ccb_arena_free(arena);
+}
+
+
+static sc_value_t optim_benchmark_sqrt(sc_value_t value) {
+    return to_sc_value(sqrt(sc_value_to_f64(value)), value.type);
+}
+
+
+void optim_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    uint64_t n = 1 << 24;
+    printf("\nOptimiser benchmark (%lu parameters, %d iterations)\n", (unsigned long)n, OPTIM_BENCHMARK_ITERATIONS);
+    sc_vector* param = sc_create_vector(n, sc_float32, arena);
+    sc_vector* grad = sc_create_vector(n, sc_float32, arena);
+    sc_vector* param_bf16 = sc_create_vector(n, sc_float16, arena);
+    sc_vector* m = sc_create_vector(n, sc_float32, arena);
+    sc_vector* v = sc_create_vector(n, sc_float32, arena);
+    CCB_NOTNULL(param_bf16, "Failed to create vectors");
+    for (uint64_t i = 0; i < n; i++) {
+        ((float*)param->data)[i] = (float)rand() / (float)RAND_MAX - 0.5f;
+        ((float*)grad->data)[i] = ((float)rand() / (float)RAND_MAX - 0.5f) * 1e-2f;
+        ((uint16_t*)param_bf16->data)[i] = (uint16_t)(((uint32_t)0x3f800000) >> 16);
+        ((float*)m->data)[i] = 0.0f;
+        ((float*)v->data)[i] = 0.0f;
+    }
+
+    const char* names[] = {"adam (composed)", "adam", "adamw", "sgd momentum", "rmsprop", "adam bf16 master", "sgd bf16 stoch."};
+    sc_optim_kind kinds[] = {sc_optim_adam, sc_optim_adam, sc_optim_adamw, sc_optim_sgd, sc_optim_rmsprop, sc_optim_adam, sc_optim_sgd};
+    for (int b = 0; b < 7; b++) {
+        sc_optim_options options = sc_optim_default_options(kinds[b]);
+        options.momentum = (b == 6) ? 0.0 : options.momentum;
+        options.master_weights = (b == 5);
+        options.stochastic_rounding = (b == 6);
+        sc_vector* target = (b >= 5) ? param_bf16 : param;
+        ccb_arena_reset(scratch);
+        sc_optim_state* state = sc_optim_create(target, &options, scratch);
+        CCB_NOTNULL(state, "Failed to create optimiser");
+
+        double start = 0.0;
+        for (int i = 0; i <= OPTIM_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            if (b == 0) {
+                // the same Adam step from the vector API, one memory pass and one temporary per call
+                ccb_arena* step = ccb_init_arena();
+                sc_vector_axpby_inplace(to_sc_value(0.1, sc_float32), grad, to_sc_value(0.9, sc_float32), m);
+                sc_vector* g2 = sc_vector_mul_ellement_wise(grad, grad, step);
+                sc_vector_axpby_inplace(to_sc_value(0.001, sc_float32), g2, to_sc_value(0.999, sc_float32), v);
+                sc_vector* m_hat = sc_vector_scal(to_sc_value(1.0 / 0.1, sc_float32), m, step);
+                sc_vector* v_hat = sc_vector_scal(to_sc_value(1.0 / 0.001, sc_float32), v, step);
+                sc_vector* denom = sc_vector_map(v_hat, optim_benchmark_sqrt, step);
+                sc_vector_add_scalar_inplace(denom, to_sc_value(1e-8, sc_float32));
+                sc_vector* update = sc_vector_div_ellement_wise(m_hat, denom, step);
+                sc_vector_axpy_inplace(to_sc_value(-1e-3, sc_float32), update, param);
+                ccb_arena_free(step);
+            } else if (sc_optim_step(state, target, grad, scratch) != 0) {
+                CCB_ERROR("Failed to run optimiser step");
+                return;
+            }
+        }
+        double time = (wall_time() - start) / OPTIM_BENCHMARK_ITERATIONS;
+        printf("%-18s: %8.3f ms (%.3f ns per parameter)\n", names[b], time * 1e3, time / (double)n * 1e9);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void random_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+
+    uint64_t n = 1 << 24;
+    printf("\nRandom fill benchmark (%lu elements, %d iterations)\n", (unsigned long)n, RANDOM_BENCHMARK_ITERATIONS);
+    sc_vector* f32 = sc_create_vector(n, sc_float32, arena);
+    sc_vector* f64 = sc_create_vector(n, sc_float64, arena);
+    sc_vector* bf16 = sc_create_vector(n, sc_float16, arena);
+    CCB_NOTNULL(bf16, "Failed to create vectors");
+
+    const char* names[] = {"rand() loop f32", "uniform f32", "uniform f64", "uniform bf16", "normal f32", "normal f64", "trunc normal f32", "bernoulli f32"};
+    sc_rng rng = sc_rng_create(42);
+    for (int b = 0; b < 8; b++) {
+        double start = 0.0;
+        for (int i = 0; i <= RANDOM_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            int status = 0;
+            switch (b) {
+                case 0:
+                    for (uint64_t k = 0; k < n; k++) {
+                        ((float*)f32->data)[k] = (float)rand() / (float)RAND_MAX;
+                    }
+                    break;
+                case 1: status = sc_rng_uniform(&rng, f32, 0.0, 1.0, arena); break;
+                case 2: status = sc_rng_uniform(&rng, f64, 0.0, 1.0, arena); break;
+                case 3: status = sc_rng_uniform(&rng, bf16, 0.0, 1.0, arena); break;
+                case 4: status = sc_rng_normal(&rng, f32, 0.0, 1.0, arena); break;
+                case 5: status = sc_rng_normal(&rng, f64, 0.0, 1.0, arena); break;
+                case 6: status = sc_rng_truncated_normal(&rng, f32, 0.0, 1.0, -2.0, 2.0, arena); break;
+                default: status = sc_rng_bernoulli(&rng, f32, 0.5, arena); break;
+            }
+            if (status != 0) {
+                CCB_ERROR("Failed to run random fill");
+                return;
+            }
+        }
+        double time = (wall_time() - start) / RANDOM_BENCHMARK_ITERATIONS;
+        printf("%-18s: %8.3f ms (%.3f ns per element)\n", names[b], time * 1e3, time / (double)n * 1e9);
+    }
+
+    ccb_arena_free(arena);
+}
+
+
+void factor_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+
+    uint64_t n = 1024;
+    printf("\nFactorisation benchmark (%lu x %lu float64, %d iterations)\n", (unsigned long)n, (unsigned long)n, FACTOR_BENCHMARK_ITERATIONS);
+    uint64_t dims[] = {n, n};
+    sc_tensor* source = sc_create_tensor(sc_create_dimensions(2, arena, dims), sc_float64, arena);
+    sc_tensor* a = sc_create_tensor(sc_create_dimensions(2, arena, dims), sc_float64, arena);
+    sc_vector* tau = sc_create_vector(n, sc_float64, arena);
+    uint64_t* pivots = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    CCB_NOTNULL(pivots, "Failed to create matrices");
+    double* data = (double*)source->data;
+    for (uint64_t i = 0; i < n; i++) {
+        for (uint64_t j = 0; j < n; j++) {
+            // symmetric and diagonally dominant so that the three factorisations apply
+            data[i * n + j] = (double)((i * j + 3 * (i + j)) % 101) / 101.0 + ((i == j) ? (double)n : 0.0);
+        }
+    }
+
+    const char* names[] = {"LU", "Cholesky", "QR"};
+    double flops[] = {2.0 / 3.0 * n * n * n, 1.0 / 3.0 * n * n * n, 4.0 / 3.0 * n * n * n};
+    for (int b = 0; b < 3; b++) {
+        double elapsed = 0.0;
+        for (int i = 0; i <= FACTOR_BENCHMARK_ITERATIONS; i++) {
+            memcpy(a->data, source->data, n * n * sizeof(double));
+            double start = wall_time();
+            int status = (b == 0) ? sc_lu_inplace(a, pivots, arena)
+                       : ((b == 1) ? sc_cholesky_inplace(a, 0.0, arena) : sc_qr_inplace(a, tau, arena));
+            if (status != 0) {
+                CCB_ERROR("Failed to run %s", names[b]);
+                return;
+            }
+            if (i > 0) elapsed += wall_time() - start; // first run is a warm up
+        }
+        double time = elapsed / FACTOR_BENCHMARK_ITERATIONS;
+        printf("%-8s: %8.3f ms (%.2f GFLOPS)\n", names[b], time * 1e3, flops[b] / time * 1e-9);
+    }
+
+    // stacks of small systems, one gemm free factorisation per system
+    uint64_t batch = 10000;
+    uint64_t small = 16;
+    uint64_t batch_dims[] = {batch, small, small};
+    uint64_t rhs_dims[] = {batch, small};
+    sc_tensor* systems = sc_create_tensor(sc_create_dimensions(3, arena, batch_dims), sc_float32, arena);
+    sc_tensor* factors = sc_create_tensor(sc_create_dimensions(3, arena, batch_dims), sc_float32, arena);
+    sc_tensor* targets = sc_create_tensor(sc_create_dimensions(2, arena, rhs_dims), sc_float32, arena);
+    CCB_NOTNULL(targets, "Failed to create systems");
+    for (uint64_t s = 0; s < batch; s++) {
+        for (uint64_t i = 0; i < small; i++) {
+            for (uint64_t j = 0; j < small; j++) {
+                ((float*)systems->data)[(s * small + i) * small + j] = 1.0f / (1.0f + (float)((i > j) ? i - j : j - i)) + ((i == j) ? 1.0f : 0.0f);
+            }
+        }
+    }
+    for (int b = 0; b < 2; b++) {
+        double elapsed = 0.0;
+        for (int i = 0; i <= FACTOR_BENCHMARK_ITERATIONS; i++) {
+            memcpy(factors->data, systems->data, batch * small * small * sizeof(float));
+            for (uint64_t k = 0; k < batch * small; k++) {
+                ((float*)targets->data)[k] = 1.0f;
+            }
+            double start = wall_time();
+            int status = (b == 0) ? sc_batched_lu_solve(factors, targets, arena) : sc_batched_cholesky_solve(factors, targets, arena);
+            if (status != 0) {
+                CCB_ERROR("Failed to run batched solve");
+                return;
+            }
+            if (i > 0) elapsed += wall_time() - start;
+        }
+        double time = elapsed / FACTOR_BENCHMARK_ITERATIONS;
+        printf("batched %-8s: %8.3f ms for %lu systems of %lu (%.1f ns per system)\n", (b == 0) ? "LU" : "Cholesky", time * 1e3,
+               (unsigned long)batch, (unsigned long)small, time / (double)batch * 1e9);
+    }
+
+    ccb_arena_free(arena);
+}
+
+
+void geometry_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+
+    uint64_t n = 1 << 22;
+    printf("\nBatched geometry benchmark (%lu float32 items, %d iterations)\n", (unsigned long)n, GEOMETRY_BENCHMARK_ITERATIONS);
+    uint64_t dims[] = {n, 3};
+    sc_tensor* aos = sc_create_tensor(sc_create_dimensions(2, arena, dims), sc_float32, arena);
+    sc_soa* a = sc_create_soa(n, 3, sc_float32, arena);
+    sc_soa* b = sc_create_soa(n, 3, sc_float32, arena);
+    sc_soa* out = sc_create_soa(n, 3, sc_float32, arena);
+    sc_soa* q = sc_create_soa(n, 4, sc_float32, arena);
+    sc_soa* m = sc_create_soa(n, 9, sc_float32, arena);
+    sc_vector* dots = sc_create_vector(n, sc_float32, arena);
+    CCB_NOTNULL(dots, "Failed to create batches");
+    for (uint64_t k = 0; k < n * 3; k++) {
+        ((float*)aos->data)[k] = (float)(k % 97) / 97.0f - 0.5f;
+    }
+    for (uint64_t k = 0; k < q->stride * 4; k++) {
+        ((float*)q->data)[k] = 0.5f;
+    }
+    for (uint64_t k = 0; k < m->stride * 9; k++) {
+        ((float*)m->data)[k] = (float)(k % 5) * 0.25f;
+    }
+    sc_soa_pack(aos, b, arena);
+
+    // the per item reference keeps the small vectors in one arena that is reset every iteration
+    ccb_arena* items = ccb_init_arena();
+    CCB_NOTNULL(items, "Failed to create arena");
+    sc_vector* va = sc_create_vector(3, sc_float32, arena);
+    sc_vector* vb = sc_create_vector(3, sc_float32, arena);
+
+    const char* names[] = {"sc_vector_cross loop", "soa pack", "soa unpack", "soa cross", "soa dot", "soa normalize", "soa transform 3x3", "soa rotate"};
+    for (int bench = 0; bench < 8; bench++) {
+        double start = 0.0;
+        for (int i = 0; i <= GEOMETRY_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            int status = 0;
+            switch (bench) {
+                case 0:
+                    for (uint64_t k = 0; k < n; k++) {
+                        memcpy(va->data, (float*)aos->data + k * 3, 3 * sizeof(float));
+                        memcpy(vb->data, (float*)aos->data + ((k * 7) % n) * 3, 3 * sizeof(float));
+                        sc_vector* cross = sc_vector_cross(va, vb, items);
+                        memcpy((float*)aos->data + k * 3, cross->data, 3 * sizeof(float));
+                    }
+                    ccb_arena_reset(items);
+                    break;
+                case 1: status = sc_soa_pack(aos, a, arena); break;
+                case 2: status = sc_soa_unpack(a, aos, arena); break;
+                case 3: status = sc_soa_cross(a, b, out, arena); break;
+                case 4: status = sc_soa_dot(a, b, dots, arena); break;
+                case 5: status = sc_soa_normalize(a, out, arena); break;
+                case 6: status = sc_soa_transform(m, a, out, arena); break;
+                default: status = sc_soa_rotate(q, a, out, arena); break;
+            }
+            if (status != 0) {
+                CCB_ERROR("Failed to run geometry kernel");
+                return;
+            }
+        }
+        double time = (wall_time() - start) / GEOMETRY_BENCHMARK_ITERATIONS;
+        printf("%-22s: %8.3f ms (%.3f ns per item)\n", names[bench], time * 1e3, time / (double)n * 1e9);
+    }
+
+    ccb_arena_free(items);
+    ccb_arena_free(arena);
+}
+
+
+void distance_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+
+    uint64_t nq = 1000;
+    uint64_t n = 50000;
+    uint64_t dim = 128;
+    uint64_t k = 10;
+    printf("\nPairwise distance benchmark (%lu queries, %lu points, dim %lu, float32, %d iterations)\n",
+           (unsigned long)nq, (unsigned long)n, (unsigned long)dim, DISTANCE_BENCHMARK_ITERATIONS);
+    uint64_t q_dims[] = {nq, dim};
+    uint64_t c_dims[] = {n, dim};
+    sc_tensor* queries = sc_create_tensor(sc_create_dimensions(2, arena, q_dims), sc_float32, arena);
+    sc_tensor* corpus = sc_create_tensor(sc_create_dimensions(2, arena, c_dims), sc_float32, arena);
+    uint64_t* indices = (uint64_t*)ccb_arena_malloc(arena, nq * k * sizeof(uint64_t));
+    CCB_NOTNULL(indices, "Failed to create points");
+    for (uint64_t i = 0; i < nq * dim; i++) {
+        ((float*)queries->data)[i] = (float)((i * 31) % 101) / 101.0f;
+    }
+    for (uint64_t i = 0; i < n * dim; i++) {
+        ((float*)corpus->data)[i] = (float)((i * 17) % 103) / 103.0f;
+    }
+
+    // per pair sc_vector_dot on the first queries, scaled to all of them
+    uint64_t sampled = 10;
+    double start = wall_time();
+    double checksum = 0.0;
+    for (uint64_t i = 0; i < sampled; i++) {
+        sc_vector qv = {(float*)queries->data + i * dim, dim, sc_float32};
+        for (uint64_t j = 0; j < n; j++) {
+            sc_vector cv = {(float*)corpus->data + j * dim, dim, sc_float32};
+            checksum += sc_value_to_f64(sc_vector_dot(&qv, &cv));
+        }
+    }
+    double time = (wall_time() - start) * (double)nq / (double)sampled;
+    printf("%-22s: %10.3f ms (extrapolated from %lu queries, checksum %.1f)\n", "sc_vector_dot loop", time * 1e3,
+           (unsigned long)sampled, checksum);
+
+    // the full [1000, 50000] matrices (200 MB each) stay in the arena
+    const char* names[] = {"point set norms", "full L2 matrix", "fused L2 top 10", "fused cosine top 10"};
+    sc_point_set* q = sc_point_set_create(queries, arena);
+    sc_point_set* c = sc_point_set_create(corpus, arena);
+    for (int b = 0; b < 4; b++) {
+        start = 0.0;
+        for (int i = 0; i <= DISTANCE_BENCHMARK_ITERATIONS; i++) {
+            if (i == 1) start = wall_time(); // first run is a warm up
+            int status = 0;
+            switch (b) {
+                case 0: status = (sc_point_set_create(corpus, arena) != NULL) ? 0 : -1; break;
+                case 1: status = (sc_pairwise_distances(q, c, sc_metric_sqeuclidean, arena) != NULL) ? 0 : -1; break;
+                case 2: status = sc_pairwise_topk(q, c, sc_metric_sqeuclidean, k, indices, NULL, arena); break;
+                default: status = sc_pairwise_topk(q, c, sc_metric_cosine, k, indices, NULL, arena); break;
+            }
+            if (status != 0) {
+                CCB_ERROR("Failed to run distance benchmark");
+                return;
+            }
+        }
+        time = (wall_time() - start) / DISTANCE_BENCHMARK_ITERATIONS;
+        printf("%-22s: %10.3f ms (%.2f GFLOPS)\n", names[b], time * 1e3,
+               (b == 0 ? 2.0 * n * dim : 2.0 * nq * n * dim) / time * 1e-9);
+    }
+
+    ccb_arena_free(arena);
+}
+
+
+void kmeans_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+
+    uint64_t n = 200000;
+    uint64_t dim = 64;
+    uint64_t k = 256;
+    uint64_t iterations = 10;
+    printf("\nK-means benchmark (%lu points, dim %lu, k %lu, float32, %lu Lloyd iterations)\n", (unsigned long)n,
+           (unsigned long)dim, (unsigned long)k, (unsigned long)iterations);
+    uint64_t dims[] = {n, dim};
+    sc_tensor* points = sc_create_tensor(sc_create_dimensions(2, arena, dims), sc_float32, arena);
+    CCB_NOTNULL(points, "Failed to create points");
+    sc_rng rng = sc_rng_create(5);
+    sc_rng_normal_tensor(&rng, points, 0.0, 1.0, arena);
+
+    const char* names[] = {"k-means++ seeding", "k-means|| seeding", "k-means|| + Lloyd"};
+    sc_kmeans_options options = sc_kmeans_default_options(k);
+    options.tolerance = 0.0;
+    double seeding = 0.0;
+    for (int b = 0; b < 3; b++) {
+        options.seeding = (b == 0) ? sc_kmeans_plus_plus : sc_kmeans_parallel;
+        options.max_iterations = (b == 2) ? iterations : 0;
+        double start = wall_time();
+        sc_kmeans_model* model = sc_kmeans_fit(points, &options, NULL, arena);
+        double time = wall_time() - start;
+        if (model == NULL) {
+            CCB_ERROR("Failed to run k-means benchmark");
+            return;
+        }
+        printf("%-22s: %10.3f ms (inertia %.4e)\n", names[b], time * 1e3, model->inertia);
+        if (b == 1) {
+            seeding = time;
+        } else if (b == 2) {
+            // one update and one gemm assignment per iteration
+            time = (time - seeding) / iterations;
+            printf("%-22s: %10.3f ms (%.2f GFLOPS of assignment)\n", "Lloyd iteration", time * 1e3, 2.0 * n * k * dim / time * 1e-9);
+        }
+    }
+
+    uint64_t batch_rows = 4096;
+    uint64_t b_dims[] = {batch_rows, dim};
+    sc_tensor batch = {points->data, sc_create_dimensions(2, arena, b_dims), batch_rows * dim, sc_float32};
+    sc_kmeans_model* streaming = sc_kmeans_seed(&batch, &options, arena);
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(streaming, "Failed to seed mini-batch model");
+    double start = wall_time();
+    for (uint64_t first = 0; first + batch_rows <= n; first += batch_rows) {
+        batch.data = (float*)points->data + first * dim;
+        if (sc_kmeans_partial_fit(streaming, &batch, scratch) != 0) {
+            CCB_ERROR("Failed to run mini-batch update");
+            return;
+        }
+        ccb_arena_reset(scratch);
+    }
+    double time = wall_time() - start;
+    double inertia = 0.0;
+    uint64_t* labels = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    sc_kmeans_assign(streaming, points, labels, &inertia, arena);
+    printf("%-22s: %10.3f ms (one pass of %lu rows batches, inertia %.4e)\n", "mini-batch", time * 1e3,
+           (unsigned long)batch_rows, inertia);
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+static double ann_recall(const uint64_t* got, const uint64_t* expected, uint64_t nq, uint64_t k) {
+    uint64_t hits = 0;
+    for (uint64_t i = 0; i < nq; i++) {
+        for (uint64_t a = 0; a < k; a++) {
+            for (uint64_t b = 0; b < k; b++) {
+                hits += (got[i * k + a] == expected[i * k + b]);
+            }
+        }
+    }
+    return (double)hits / (double)(nq * k);
+}
+
+
+void ann_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+
+    uint64_t n = 50000;
+    uint64_t nq = 1000;
+    uint64_t dim = 64;
+    uint64_t k = 10;
+    uint64_t clusters = 200;
+    printf("\nANN benchmark (%lu points in %lu gaussian clusters, %lu queries, dim %lu, float32, recall@%lu)\n",
+           (unsigned long)n, (unsigned long)clusters, (unsigned long)nq, (unsigned long)dim, (unsigned long)k);
+    uint64_t c_dims[] = {clusters, dim};
+    uint64_t p_dims[] = {n, dim};
+    uint64_t q_dims[] = {nq, dim};
+    sc_tensor* centers = sc_create_tensor(sc_create_dimensions(2, arena, c_dims), sc_float32, arena);
+    sc_tensor* points = sc_create_tensor(sc_create_dimensions(2, arena, p_dims), sc_float32, arena);
+    sc_tensor* queries = sc_create_tensor(sc_create_dimensions(2, arena, q_dims), sc_float32, arena);
+    uint64_t* expected = (uint64_t*)ccb_arena_malloc(arena, nq * k * sizeof(uint64_t));
+    uint64_t* got = (uint64_t*)ccb_arena_malloc(arena, nq * k * sizeof(uint64_t));
+    CCB_NOTNULL(got, "Failed to create points");
+    sc_rng rng = sc_rng_create(1);
+    sc_rng_uniform_tensor(&rng, centers, -4.0, 4.0, arena);
+    sc_rng_normal_tensor(&rng, points, 0.0, 3.0, arena);
+    sc_rng_normal_tensor(&rng, queries, 0.0, 3.0, arena);
+    for (uint64_t i = 0; i < n + nq; i++) {
+        float* row = (i < n) ? (float*)points->data + i * dim : (float*)queries->data + (i - n) * dim;
+        const float* center = (const float*)centers->data + (i * 7919 % clusters) * dim;
+        for (uint64_t p = 0; p < dim; p++) {
+            row[p] += center[p];
+        }
+    }
+
+    double start = wall_time();
+    if (sc_pairwise_topk(sc_point_set_create(queries, arena), sc_point_set_create(points, arena), sc_metric_sqeuclidean, k,
+                         expected, NULL, arena) != 0) {
+        CCB_ERROR("Failed to run brute force search");
+        return;
+    }
+    double time = wall_time() - start;
+    printf("%-22s: %10.0f QPS\n", "gemm brute force", nq / time);
+
+    start = wall_time();
+    sc_ivf_index* ivf = sc_ivf_build(points, sc_metric_sqeuclidean, 256, 1, arena);
+    printf("%-22s: %10.3f s\n", "IVF build (256 lists)", wall_time() - start);
+    start = wall_time();
+    sc_hnsw_index* hnsw = sc_hnsw_build(points, sc_metric_sqeuclidean, 16, 100, 1, arena);
+    printf("%-22s: %10.3f s\n", "HNSW build (m 16)", wall_time() - start);
+    if (ivf == NULL || hnsw == NULL) {
+        CCB_ERROR("Failed to build the indexes");
+        return;
+    }
+
+    uint64_t nprobes[] = {1, 4, 16, 64};
+    for (int b = 0; b < 4; b++) {
+        start = wall_time();
+        if (sc_ivf_search(ivf, queries, k, nprobes[b], got, NULL, arena) != 0) {
+            CCB_ERROR("Failed to run IVF search");
+            return;
+        }
+        time = wall_time() - start;
+        printf("IVF nprobe %-11lu: %10.0f QPS, recall %.3f\n", (unsigned long)nprobes[b], nq / time,
+               ann_recall(got, expected, nq, k));
+    }
+    uint64_t efs[] = {16, 32, 64, 128};
+    for (int b = 0; b < 4; b++) {
+        start = wall_time();
+        if (sc_hnsw_search(hnsw, queries, k, efs[b], got, NULL, arena) != 0) {
+            CCB_ERROR("Failed to run HNSW search");
+            return;
+        }
+        time = wall_time() - start;
+        printf("HNSW ef %-14lu: %10.0f QPS, recall %.3f\n", (unsigned long)efs[b], nq / time, ann_recall(got, expected, nq, k));
+    }
+
+    ccb_arena_free(arena);
+}
+
+
+static int selection_compare_f32(const void* a, const void* b) {
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+void selection_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+
+    uint64_t n = 1 << 24;
+    uint64_t k = 100;
+    int repeats = 10;
+    printf("\nSelection benchmark (%lu float32, k %lu)\n", (unsigned long)n, (unsigned long)k);
+    sc_vector* a = sc_create_vector(n, sc_float32, arena);
+    sc_vector* copy = sc_create_vector(n, sc_float32, arena);
+    CCB_NOTNULL(a, "Failed to create vector");
+    CCB_NOTNULL(copy, "Failed to create vector");
+    uint64_t dims[] = {n};
+    sc_tensor view = {a->data, sc_create_dimensions(1, arena, dims), n, sc_float32};
+    sc_rng rng = sc_rng_create(9);
+    sc_rng_uniform_tensor(&rng, &view, 0.0, 1.0, arena);
+    const float* data = (const float*)a->data;
+    uint64_t* indices = (uint64_t*)ccb_arena_malloc(arena, k * sizeof(uint64_t));
+
+    // naive scalar scan
+    uint64_t naive = 0;
+    double start = wall_time();
+    for (int i = 0; i <= repeats; i++) {
+        if (i == 1) start = wall_time();
+        naive = 0;
+        for (uint64_t j = 1; j < n; j++) {
+            naive = (data[j] > data[naive]) ? j : naive;
+        }
+    }
+    double time = (wall_time() - start) / repeats;
+    printf("%-24s: %10.3f ms (%.2f GB/s)\n", "argmax naive loop", time * 1e3, n * sizeof(float) / time * 1e-9);
+
+    uint64_t index = 0;
+    for (int i = 0; i <= repeats; i++) {
+        if (i == 1) start = wall_time();
+        sc_vector_argmax(a, &index, arena);
+    }
+    time = (wall_time() - start) / repeats;
+    printf("%-24s: %10.3f ms (%.2f GB/s)%s\n", "sc_vector_argmax", time * 1e3, n * sizeof(float) / time * 1e-9,
+           index == naive ? "" : " MISMATCH");
+
+    for (int i = 0; i <= repeats; i++) {
+        if (i == 1) start = wall_time();
+        sc_vector_topk(a, k, 1, indices, NULL, arena);
+    }
+    time = (wall_time() - start) / repeats;
+    printf("%-24s: %10.3f ms (%.2f GB/s)\n", "sc_vector_topk", time * 1e3, n * sizeof(float) / time * 1e-9);
+
+    // the copies are not timed
+    time = 0.0;
+    for (int i = 0; i < repeats; i++) {
+        memcpy(copy->data, a->data, n * sizeof(float));
+        start = wall_time();
+        sc_vector_nth_element(copy, n - k);
+        time += wall_time() - start;
+    }
+    printf("%-24s: %10.3f ms\n", "sc_vector_nth_element", time / repeats * 1e3);
+
+    memcpy(copy->data, a->data, n * sizeof(float));
+    start = wall_time();
+    qsort(copy->data, n, sizeof(float), selection_compare_f32);
+    time = wall_time() - start;
+    printf("%-24s: %10.3f ms (full sort for the top k)\n", "qsort", time * 1e3);
+
+    // one argmax per row of a [4096, 4096] tensor
+    uint64_t rows_dims[] = {4096, n / 4096};
+    sc_tensor rows = {a->data, sc_create_dimensions(2, arena, rows_dims), n, sc_float32};
+    uint64_t* row_best = (uint64_t*)ccb_arena_malloc(arena, 4096 * sizeof(uint64_t));
+    for (int i = 0; i <= repeats; i++) {
+        if (i == 1) start = wall_time();
+        sc_tensor_argmax(&rows, -1, row_best, arena);
+    }
+    time = (wall_time() - start) / repeats;
+    printf("%-24s: %10.3f ms (%.2f GB/s)\n", "sc_tensor_argmax rows", time * 1e3, n * sizeof(float) / time * 1e-9);
+    for (int i = 0; i <= repeats; i++) {
+        if (i == 1) start = wall_time();
+        sc_tensor_argmax(&rows, 0, row_best, arena);
+    }
+    time = (wall_time() - start) / repeats;
+    printf("%-24s: %10.3f ms (%.2f GB/s)\n", "sc_tensor_argmax columns", time * 1e3, n * sizeof(float) / time * 1e-9);
+
+    ccb_arena_free(arena);
+}
+
+
+static int sort_compare_f32(const void* a, const void* b) {
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+void sort_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create arena");
+
+    uint64_t n = 1 << 24;
+    int repeats = 5;
+    printf("\nSort benchmark (%lu elements)\n", (unsigned long)n);
+    sc_vector* a = sc_create_vector(n, sc_float32, arena);
+    sc_vector* copy = sc_create_vector(n, sc_float32, arena);
+    sc_vector* ints = sc_create_vector(n, sc_int32, arena);
+    sc_vector* int_copy = sc_create_vector(n, sc_int32, arena);
+    uint64_t* indices = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    CCB_NOTNULL(indices, "Failed to allocate indices");
+    uint64_t dims[] = {n};
+    sc_tensor view = {a->data, sc_create_dimensions(1, arena, dims), n, sc_float32};
+    sc_rng rng = sc_rng_create(13);
+    sc_rng_normal_tensor(&rng, &view, 0.0, 1.0, arena);
+    for (uint64_t i = 0; i < n; i++) {
+        ((int32_t*)ints->data)[i] = (int32_t)(((float*)a->data)[i] * 1e8f);
+    }
+
+    // the copies are not timed, qsort runs once
+    const char* names[] = {"qsort float32", "sc_vector_sort float32", "sc_vector_argsort float32", "sc_vector_sort int32"};
+    for (int b = 0; b < 4; b++) {
+        int runs = (b == 0) ? 1 : repeats;
+        double time = 0.0;
+        for (int i = 0; i < runs; i++) {
+            memcpy(copy->data, a->data, n * sizeof(float));
+            memcpy(int_copy->data, ints->data, n * sizeof(int32_t));
+            ccb_arena_reset(scratch);
+            double start = wall_time();
+            if (b == 0) {
+                qsort(copy->data, n, sizeof(float), sort_compare_f32);
+            } else if (b == 1) {
+                sc_vector_sort(copy, 0, scratch);
+            } else if (b == 2) {
+                sc_vector_argsort(a, 0, indices, scratch);
+            } else {
+                sc_vector_sort(int_copy, 0, scratch);
+            }
+            time += wall_time() - start;
+        }
+        time /= runs;
+        printf("%-26s: %10.3f ms (%.1f M elements/s)\n", names[b], time * 1e3, n / time * 1e-6);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+
+void scan_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+
+    uint64_t n = 1 << 24;
+    int repeats = 10;
+    printf("\nScan benchmark (%lu elements)\n", (unsigned long)n);
+    sc_vector* a = sc_create_vector(n, sc_float32, arena);
+    sc_vector* out = sc_create_vector(n, sc_float32, arena);
+    sc_vector* wide = sc_create_vector(n, sc_float64, arena);
+    sc_vector* wide_out = sc_create_vector(n, sc_float64, arena);
+    sc_vector* counts = sc_create_vector(n, sc_int64, arena);
+    sc_vector* offsets = sc_create_vector(n, sc_int64, arena);
+    uint64_t dims[] = {n};
+    sc_tensor view = {a->data, sc_create_dimensions(1, arena, dims), n, sc_float32};
+    sc_rng rng = sc_rng_create(17);
+    sc_rng_uniform_tensor(&rng, &view, 0.0, 1.0, arena);
+    for (uint64_t i = 0; i < n; i++) {
+        ((double*)wide->data)[i] = ((float*)a->data)[i];
+        ((int64_t*)counts->data)[i] = (int64_t)(i % 7);
+    }
+
+    // naive serial loop
+    const float* src = (const float*)a->data;
+    float* dst = (float*)out->data;
+    double start = wall_time();
+    for (int i = 0; i <= repeats; i++) {
+        if (i == 1) start = wall_time();
+        float running = 0.0f;
+        for (uint64_t j = 0; j < n; j++) {
+            running += src[j];
+            dst[j] = running;
+        }
+    }
+    double time = (wall_time() - start) / repeats;
+    printf("%-30s: %10.3f ms (%.2f GB/s)\n", "cumsum naive loop float32", time * 1e3, 2.0 * n * sizeof(float) / time * 1e-9);
+
+    const char* names[] = {"cumsum float32", "cummax float32", "cumsum float64", "exclusive cumsum int64"};
+    uint64_t sizes[] = {sizeof(float), sizeof(float), sizeof(double), sizeof(int64_t)};
+    for (int b = 0; b < 4; b++) {
+        for (int i = 0; i <= repeats; i++) {
+            if (i == 1) start = wall_time();
+            if (b == 0) {
+                sc_vector_cumsum(a, out, arena);
+            } else if (b == 1) {
+                sc_vector_cummax(a, out, arena);
+            } else if (b == 2) {
+                sc_vector_cumsum(wide, wide_out, arena);
+            } else {
+                sc_vector_scan(counts, offsets, sc_scan_sum, 1, arena);
+            }
+        }
+        time = (wall_time() - start) / repeats;
+        printf("%-30s: %10.3f ms (%.2f GB/s)\n", names[b], time * 1e3, 2.0 * n * sizes[b] / time * 1e-9);
+    }
+
+    ccb_arena_free(arena);
+}
+
+
+void segment_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    uint64_t n = 1 << 25;
+    uint64_t groups = 1000;
+    int repeats = 5;
+    printf("\nSegment benchmark (%lu rows, %lu groups)\n", (unsigned long)n, (unsigned long)groups);
+    sc_vector* values = sc_create_vector(n, sc_float32, arena);
+    sc_vector* keys = sc_create_vector(n, sc_int32, arena);
+    sc_vector* offsets = sc_create_vector(groups + 1, sc_int64, arena);
+    uint64_t dims[] = {n};
+    sc_tensor view = {values->data, sc_create_dimensions(1, arena, dims), n, sc_float32};
+    sc_rng rng = sc_rng_create(23);
+    sc_rng_uniform_tensor(&rng, &view, 0.0, 1.0, arena);
+    for (uint64_t i = 0; i < n; i++) {
+        ((int32_t*)keys->data)[i] = (int32_t)((i * 2654435761u) % groups);
+    }
+    for (uint64_t g = 0; g <= groups; g++) {
+        ((int64_t*)offsets->data)[g] = (int64_t)(g * (n / groups));
+    }
+    sc_segment_outputs out = {sc_create_vector(groups, sc_float32, arena), sc_create_vector(groups, sc_float32, arena),
+                              sc_create_vector(groups, sc_int64, arena), sc_create_vector(groups, sc_float32, arena),
+                              sc_create_vector(groups, sc_float32, arena)};
+
+    // naive serial group by
+    double* sums = (double*)ccb_arena_malloc(arena, groups * sizeof(double));
+    uint64_t* counts = (uint64_t*)ccb_arena_malloc(arena, groups * sizeof(uint64_t));
+    const float* data = (const float*)values->data;
+    const int32_t* key = (const int32_t*)keys->data;
+    double start = wall_time();
+    for (int i = 0; i <= repeats; i++) {
+        if (i == 1) start = wall_time();
+        memset(sums, 0, groups * sizeof(double));
+        memset(counts, 0, groups * sizeof(uint64_t));
+        for (uint64_t j = 0; j < n; j++) {
+            sums[key[j]] += data[j];
+            counts[key[j]]++;
+        }
+    }
+    double time = (wall_time() - start) / repeats;
+    printf("%-30s: %10.3f ms (%.1f M rows/s)\n", "group sum naive loop", time * 1e3, n / time * 1e-6);
+
+    const char* names[] = {"group by sum, mean, count", "group by all statistics", "segments all statistics"};
+    sc_segment_outputs sum_only = {out.sum, out.mean, out.count, NULL, NULL};
+    for (int b = 0; b < 3; b++) {
+        for (int i = 0; i <= repeats; i++) {
+            if (i == 1) start = wall_time();
+            if (b == 0) {
+                sc_group_reduce(values, keys, groups, &sum_only, scratch);
+            } else if (b == 1) {
+                sc_group_reduce(values, keys, groups, &out, scratch);
+            } else {
+                sc_segment_reduce(values, offsets, &out, scratch);
+            }
+            ccb_arena_reset(scratch);
+        }
+        time = (wall_time() - start) / repeats;
+        printf("%-30s: %10.3f ms (%.1f M rows/s)\n", names[b], time * 1e3, n / time * 1e-6);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
+void rolling_benchmark(void) {
+    ccb_arena* arena = ccb_init_arena();
+    ccb_arena* scratch = ccb_init_arena();
+    CCB_NOTNULL(arena, "Failed to create arena");
+    CCB_NOTNULL(scratch, "Failed to create scratch arena");
+
+    uint64_t n = 1 << 24;
+    uint64_t window = 1000;
+    int repeats = 5;
+    printf("\nRolling benchmark (%lu values, window %lu)\n", (unsigned long)n, (unsigned long)window);
+    sc_vector* a = sc_create_vector(n, sc_float32, arena);
+    sc_vector* out = sc_create_vector(n, sc_float32, arena);
+    uint64_t dims[] = {n};
+    sc_tensor view = {a->data, sc_create_dimensions(1, arena, dims), n, sc_float32};
+    sc_rng rng = sc_rng_create(29);
+    sc_rng_normal_tensor(&rng, &view, 100.0, 1.0, arena);
+
+    // naive serial running sum (add the new value, subtract the old one)
+    const float* src = (const float*)a->data;
+    float* dst = (float*)out->data;
+    double start = wall_time();
+    for (int i = 0; i <= repeats; i++) {
+        if (i == 1) start = wall_time();
+        double running = 0.0;
+        for (uint64_t j = 0; j < n; j++) {
+            running += src[j] - ((j >= window) ? src[j - window] : 0.0f);
+            dst[j] = (float)(running / (double)((j + 1 < window) ? j + 1 : window));
+        }
+    }
+    double time = (wall_time() - start) / repeats;
+    printf("%-30s: %10.3f ms (%.2f GB/s)\n", "rolling mean naive loop", time * 1e3, 2.0 * n * sizeof(float) / time * 1e-9);
+
+    const char* names[] = {"rolling sum", "rolling mean", "rolling std", "rolling min", "rolling max", "ewma"};
+    for (int b = 0; b < 6; b++) {
+        for (int i = 0; i <= repeats; i++) {
+            if (i == 1) start = wall_time();
+            if (b < 5) {
+                sc_vector_rolling(a, out, window, (sc_rolling_stat)b, scratch);
+            } else {
+                sc_vector_ewma(a, out, 0.01, scratch);
+            }
+            ccb_arena_reset(scratch);
+        }
+        time = (wall_time() - start) / repeats;
+        printf("%-30s: %10.3f ms (%.2f GB/s)\n", names[b], time * 1e3, 2.0 * n * sizeof(float) / time * 1e-9);
+    }
+
+    ccb_arena_free(scratch);
+    ccb_arena_free(arena);
+}
+
 int main(int argc, char** argv) {
     ccb_InitLog("log/perfs.log");
     CCB_INFO("suports avx %d", __builtin_cpu_supports("avx"))
@@ -46,49 +1575,143 @@ int main(int argc, char** argv) {
 
 
 
-    ccb_arena* arena = ccb_init_arena();
-    CCB_NOTNULL(arena, "Failed to create arena");
+    if (benchmark_selected(argc, argv, "stress")) {
+        ccb_arena* arena = ccb_init_arena();
+        CCB_NOTNULL(arena, "Failed to create arena");
 
-    // Example usage of scandium library
-    uint64_t size = 10000000;
-    uint64_t op_count = 19*size;
+        // Example usage of scandium library
+        uint64_t size = 10000000;
+        uint64_t op_count = 19*size;
 
-    sc_vector* vec1 = sc_create_vector(size, sc_float32, arena);
-    sc_vector* vec2 = sc_create_vector(size, sc_float32, arena);
-    sc_vector* result = sc_create_vector(size, sc_float32, arena);
-    CCB_NOTNULL(vec1, "Failed to create vector 1");
-    CCB_NOTNULL(vec2, "Failed to create vector 2");
+        sc_vector* vec1 = sc_create_vector(size, sc_float32, arena);
+        sc_vector* vec2 = sc_create_vector(size, sc_float32, arena);
+        sc_vector* result = sc_create_vector(size, sc_float32, arena);
+        CCB_NOTNULL(vec1, "Failed to create vector 1");
+        CCB_NOTNULL(vec2, "Failed to create vector 2");
 
-    // Initialize vectors
-    float* data1 = (float*)vec1->data;
-    float* data2 = (float*)vec2->data;
-    for (uint64_t i = 0; i < size; i++) {
-        data1[i] = (float)i;
-        data2[i] = (float)(size - i);
-    }
+        // Initialize vectors
+        float* data1 = (float*)vec1->data;
+        float* data2 = (float*)vec2->data;
+        for (uint64_t i = 0; i < size; i++) {
+            data1[i] = (float)i;
+            data2[i] = (float)(size - i);
+        }
 
-    // Perform element-wise addition
-    clock_t start = clock();
-    stress_test(vec1, vec2);
-    clock_t end = clock();
+        // Perform element-wise addition
+        clock_t start = clock();
+        stress_test(vec1, vec2);
+        clock_t end = clock();
 
-    double time_spent = ((double)end - (double)start)/CLOCKS_PER_SEC / STRESS_TEST_ITERATIONS;
-    printf("Stress test took %f seconds per iteration.\n", time_spent);
+        double time_spent = ((double)end - (double)start)/CLOCKS_PER_SEC / STRESS_TEST_ITERATIONS;
+        printf("Stress test took %f seconds per iteration.\n", time_spent);
     
-    char letters[] = "kMGTP";
-    float reminder =  op_count/time_spent;
-    char letter = ' ';
-    for (int i = 0; i < 5; i++) {
-        if (reminder < 1000) {
-            break;
+        char letters[] = "kMGTP";
+        float reminder =  op_count/time_spent;
+        char letter = ' ';
+        for (int i = 0; i < 5; i++) {
+            if (reminder < 1000) {
+                break;
+            }
+            letter = letters[i];
+            reminder /= 1000;
         }
-        letter = letters[i];
-        reminder /= 1000;
+
+        printf("Engine speed: %.02f %cop/s\n", reminder, letter);
+
+        // Clean up
+        ccb_arena_free(arena);
     }
 
-    printf("Engine speed: %.02f %cop/s\n", reminder, letter);
+    if (benchmark_selected(argc, argv, "conv")) {
+        conv_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "transpose")) {
+        transpose_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "sparse")) {
+        sparse_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "quant")) {
+        quant_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "half")) {
+        half_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "int")) {
+        int_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "cast")) {
+        cast_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "fused")) {
+        fused_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "linreg")) {
+        linreg_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "logreg")) {
+        logreg_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "nn")) {
+        nn_benchmark();
+    }
+    if (benchmark_selected(argc, argv, "autodiff")) {
+        autodiff_benchmark();
+    }
+    if (benchmark_selected(argc, argv, "optim")) {
+        optim_benchmark();
+    }
+    if (benchmark_selected(argc, argv, "random")) {
+        random_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "factor")) {
+        factor_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "geometry")) {
+        geometry_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "distance")) {
+        distance_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "kmeans")) {
+        kmeans_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "ann")) {
+        ann_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "selection")) {
+        selection_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "sort")) {
+        sort_benchmark();
+    }
+
+    if (benchmark_selected(argc, argv, "scan")) {
+        scan_benchmark();
+    }
+    if (benchmark_selected(argc, argv, "segment")) {
+        segment_benchmark();
+    }
+    if (benchmark_selected(argc, argv, "rolling")) {
+        rolling_benchmark();
+    }
 
-    // Clean up
-    ccb_arena_free(arena);
     return 0;
 }
\ No newline at end of file
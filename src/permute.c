@@ -0,0 +1,478 @@
+#include "data.h"
+#include "permute.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// square tile of the 2d transposes, 128 x 128 float32 is 64 KB read + 64 KB written (L2 resident)
+#define PERMUTE_TILE 128
+// contiguous copies are split in chunks of this many bytes
+#define PERMUTE_COPY_CHUNK (256 * 1024)
+
+
+struct permute_args {
+    const uint8_t* src;
+    uint8_t* dst;
+    uint64_t el_size;
+
+    // batched axes, in output order, strides in elements
+    uint64_t outer_count;
+    uint64_t outer_dims[SC_PERMUTE_MAX_DIMS];
+    uint64_t outer_src_stride[SC_PERMUTE_MAX_DIMS];
+    uint64_t outer_dst_stride[SC_PERMUTE_MAX_DIMS];
+
+    // copy: contiguous rows of inner elements split in chunks
+    uint64_t inner;
+    uint64_t inner_chunk;
+    uint64_t inner_chunks;
+
+    // transpose: dst[c * dst_ld + r] = src[r * src_ld + c]
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t src_ld;
+    uint64_t dst_ld;
+    uint64_t row_tiles;
+    uint64_t col_tiles;
+
+    int stream;
+};
+
+
+// ###################
+// in-register kernels
+// ###################
+
+static inline void store_f32x8(float* dst, __m256 value, int stream) {
+    if (stream) {
+        _mm256_stream_ps(dst, value);
+    } else {
+        _mm256_storeu_ps(dst, value);
+    }
+}
+
+static inline void store_f64x4(double* dst, __m256d value, int stream) {
+    if (stream) {
+        _mm256_stream_pd(dst, value);
+    } else {
+        _mm256_storeu_pd(dst, value);
+    }
+}
+
+static inline void store_i16x8(uint16_t* dst, __m128i value, int stream) {
+    if (stream) {
+        _mm_stream_si128((__m128i*)dst, value);
+    } else {
+        _mm_storeu_si128((__m128i*)dst, value);
+    }
+}
+
+
+// stream is only honoured when every destination row is aligned
+static void transpose_8x8_f32(const float* src, uint64_t src_ld, float* dst, uint64_t dst_ld, int stream) {
+    stream = stream && ((uintptr_t)dst % 32 == 0) && (dst_ld * sizeof(float) % 32 == 0);
+
+    __m256 r0 = _mm256_loadu_ps(src);
+    __m256 r1 = _mm256_loadu_ps(src + src_ld);
+    __m256 r2 = _mm256_loadu_ps(src + 2 * src_ld);
+    __m256 r3 = _mm256_loadu_ps(src + 3 * src_ld);
+    __m256 r4 = _mm256_loadu_ps(src + 4 * src_ld);
+    __m256 r5 = _mm256_loadu_ps(src + 5 * src_ld);
+    __m256 r6 = _mm256_loadu_ps(src + 6 * src_ld);
+    __m256 r7 = _mm256_loadu_ps(src + 7 * src_ld);
+
+    // interleave pairs of rows, then pairs of pairs, then swap the 128 bit halves
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+    __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+    __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+    __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+
+    __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+    store_f32x8(dst, _mm256_permute2f128_ps(s0, s4, 0x20), stream);
+    store_f32x8(dst + dst_ld, _mm256_permute2f128_ps(s1, s5, 0x20), stream);
+    store_f32x8(dst + 2 * dst_ld, _mm256_permute2f128_ps(s2, s6, 0x20), stream);
+    store_f32x8(dst + 3 * dst_ld, _mm256_permute2f128_ps(s3, s7, 0x20), stream);
+    store_f32x8(dst + 4 * dst_ld, _mm256_permute2f128_ps(s0, s4, 0x31), stream);
+    store_f32x8(dst + 5 * dst_ld, _mm256_permute2f128_ps(s1, s5, 0x31), stream);
+    store_f32x8(dst + 6 * dst_ld, _mm256_permute2f128_ps(s2, s6, 0x31), stream);
+    store_f32x8(dst + 7 * dst_ld, _mm256_permute2f128_ps(s3, s7, 0x31), stream);
+}
+
+
+static void transpose_4x4_f64(const double* src, uint64_t src_ld, double* dst, uint64_t dst_ld, int stream) {
+    stream = stream && ((uintptr_t)dst % 32 == 0) && (dst_ld * sizeof(double) % 32 == 0);
+
+    __m256d r0 = _mm256_loadu_pd(src);
+    __m256d r1 = _mm256_loadu_pd(src + src_ld);
+    __m256d r2 = _mm256_loadu_pd(src + 2 * src_ld);
+    __m256d r3 = _mm256_loadu_pd(src + 3 * src_ld);
+
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+    store_f64x4(dst, _mm256_permute2f128_pd(t0, t2, 0x20), stream);
+    store_f64x4(dst + dst_ld, _mm256_permute2f128_pd(t1, t3, 0x20), stream);
+    store_f64x4(dst + 2 * dst_ld, _mm256_permute2f128_pd(t0, t2, 0x31), stream);
+    store_f64x4(dst + 3 * dst_ld, _mm256_permute2f128_pd(t1, t3, 0x31), stream);
+}
+
+
+static void transpose_8x8_i16(const uint16_t* src, uint64_t src_ld, uint16_t* dst, uint64_t dst_ld, int stream) {
+    stream = stream && ((uintptr_t)dst % 16 == 0) && (dst_ld * sizeof(uint16_t) % 16 == 0);
+
+    __m128i a0 = _mm_loadu_si128((const __m128i*)src);
+    __m128i a1 = _mm_loadu_si128((const __m128i*)(src + src_ld));
+    __m128i a2 = _mm_loadu_si128((const __m128i*)(src + 2 * src_ld));
+    __m128i a3 = _mm_loadu_si128((const __m128i*)(src + 3 * src_ld));
+    __m128i a4 = _mm_loadu_si128((const __m128i*)(src + 4 * src_ld));
+    __m128i a5 = _mm_loadu_si128((const __m128i*)(src + 5 * src_ld));
+    __m128i a6 = _mm_loadu_si128((const __m128i*)(src + 6 * src_ld));
+    __m128i a7 = _mm_loadu_si128((const __m128i*)(src + 7 * src_ld));
+
+    __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+    __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+    __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+    __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+    __m128i b4 = _mm_unpacklo_epi16(a4, a5);
+    __m128i b5 = _mm_unpackhi_epi16(a4, a5);
+    __m128i b6 = _mm_unpacklo_epi16(a6, a7);
+    __m128i b7 = _mm_unpackhi_epi16(a6, a7);
+
+    __m128i c0 = _mm_unpacklo_epi32(b0, b2);
+    __m128i c1 = _mm_unpackhi_epi32(b0, b2);
+    __m128i c2 = _mm_unpacklo_epi32(b1, b3);
+    __m128i c3 = _mm_unpackhi_epi32(b1, b3);
+    __m128i c4 = _mm_unpacklo_epi32(b4, b6);
+    __m128i c5 = _mm_unpackhi_epi32(b4, b6);
+    __m128i c6 = _mm_unpacklo_epi32(b5, b7);
+    __m128i c7 = _mm_unpackhi_epi32(b5, b7);
+
+    store_i16x8(dst, _mm_unpacklo_epi64(c0, c4), stream);
+    store_i16x8(dst + dst_ld, _mm_unpackhi_epi64(c0, c4), stream);
+    store_i16x8(dst + 2 * dst_ld, _mm_unpacklo_epi64(c1, c5), stream);
+    store_i16x8(dst + 3 * dst_ld, _mm_unpackhi_epi64(c1, c5), stream);
+    store_i16x8(dst + 4 * dst_ld, _mm_unpacklo_epi64(c2, c6), stream);
+    store_i16x8(dst + 5 * dst_ld, _mm_unpackhi_epi64(c2, c6), stream);
+    store_i16x8(dst + 6 * dst_ld, _mm_unpacklo_epi64(c3, c7), stream);
+    store_i16x8(dst + 7 * dst_ld, _mm_unpackhi_epi64(c3, c7), stream);
+}
+
+
+// #####
+// tiles
+// #####
+
+static void transpose_scalar(const uint8_t* src, uint64_t src_ld, uint8_t* dst, uint64_t dst_ld, uint64_t rows, uint64_t cols, uint64_t el_size) {
+    for (uint64_t c = 0; c < cols; c++) {
+        for (uint64_t r = 0; r < rows; r++) {
+            memcpy(dst + (c * dst_ld + r) * el_size, src + (r * src_ld + c) * el_size, el_size);
+        }
+    }
+}
+
+
+// rows x cols tile, the full SIMD blocks go through the in-register kernels and the borders through the scalar loop
+// the blocks walk down the source columns so that each destination row is written as contiguous cache lines
+static void transpose_tile(const uint8_t* src, uint64_t src_ld, uint8_t* dst, uint64_t dst_ld, uint64_t rows, uint64_t cols, uint64_t el_size, int stream) {
+    uint64_t block = (el_size == 8) ? 4 : 8;
+    if (el_size != 2 && el_size != 4 && el_size != 8) {
+        transpose_scalar(src, src_ld, dst, dst_ld, rows, cols, el_size);
+        return;
+    }
+
+    uint64_t full_rows = rows / block * block;
+    uint64_t full_cols = cols / block * block;
+
+    for (uint64_t c = 0; c < full_cols; c += block) {
+        for (uint64_t r = 0; r < full_rows; r += block) {
+            const uint8_t* s = src + (r * src_ld + c) * el_size;
+            uint8_t* d = dst + (c * dst_ld + r) * el_size;
+            switch (el_size) {
+                case 2: transpose_8x8_i16((const uint16_t*)s, src_ld, (uint16_t*)d, dst_ld, stream); break;
+                case 4: transpose_8x8_f32((const float*)s, src_ld, (float*)d, dst_ld, stream); break;
+                default: transpose_4x4_f64((const double*)s, src_ld, (double*)d, dst_ld, stream); break;
+            }
+        }
+    }
+
+    // right border (all rows), bottom border (full columns only)
+    transpose_scalar(src + full_cols * el_size, src_ld, dst + full_cols * dst_ld * el_size, dst_ld, rows, cols - full_cols, el_size);
+    transpose_scalar(src + full_rows * src_ld * el_size, src_ld, dst + full_rows * el_size, dst_ld, rows - full_rows, full_cols, el_size);
+}
+
+
+// element offsets of the outer index in the source and the destination
+static void outer_offsets(struct permute_args* a, uint64_t index, uint64_t* src_offset, uint64_t* dst_offset) {
+    *src_offset = 0;
+    *dst_offset = 0;
+    for (uint64_t k = a->outer_count; k > 0; k--) {
+        uint64_t i = index % a->outer_dims[k - 1];
+        index /= a->outer_dims[k - 1];
+        *src_offset += i * a->outer_src_stride[k - 1];
+        *dst_offset += i * a->outer_dst_stride[k - 1];
+    }
+}
+
+
+static int transpose_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct permute_args* a = (struct permute_args*)raw;
+    uint64_t tiles = a->row_tiles * a->col_tiles;
+
+    for (uint64_t u = start; u < end; u++) {
+        uint64_t src_offset, dst_offset;
+        outer_offsets(a, u / tiles, &src_offset, &dst_offset);
+
+        uint64_t r0 = (u % tiles) / a->col_tiles * PERMUTE_TILE;
+        uint64_t c0 = (u % tiles) % a->col_tiles * PERMUTE_TILE;
+        uint64_t rows = (a->rows - r0 < PERMUTE_TILE) ? a->rows - r0 : PERMUTE_TILE;
+        uint64_t cols = (a->cols - c0 < PERMUTE_TILE) ? a->cols - c0 : PERMUTE_TILE;
+
+        const uint8_t* src = a->src + (src_offset + r0 * a->src_ld + c0) * a->el_size;
+        uint8_t* dst = a->dst + (dst_offset + c0 * a->dst_ld + r0) * a->el_size;
+        transpose_tile(src, a->src_ld, dst, a->dst_ld, rows, cols, a->el_size, a->stream);
+    }
+
+    // streaming stores are weakly ordered, make them visible before the task completes
+    if (a->stream) {
+        _mm_sfence();
+    }
+    return 0;
+}
+
+
+static int copy_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct permute_args* a = (struct permute_args*)raw;
+
+    for (uint64_t u = start; u < end; u++) {
+        uint64_t src_offset, dst_offset;
+        outer_offsets(a, u / a->inner_chunks, &src_offset, &dst_offset);
+
+        uint64_t i0 = (u % a->inner_chunks) * a->inner_chunk;
+        uint64_t count = (a->inner - i0 < a->inner_chunk) ? a->inner - i0 : a->inner_chunk;
+        memcpy(a->dst + (dst_offset + i0) * a->el_size, a->src + (src_offset + i0) * a->el_size, count * a->el_size);
+    }
+    return 0;
+}
+
+
+// ###########
+// permutation
+// ###########
+
+// drops the axes of size 1 and merges the runs of output axes that are consecutive input axes
+// returns the number of remaining axes, dims and axes are rewritten in place
+static uint64_t simplify_axes(uint64_t count, uint64_t* dims, uint64_t* axes) {
+    int64_t remap[SC_PERMUTE_MAX_DIMS];
+    uint64_t kept_dims[SC_PERMUTE_MAX_DIMS];
+    uint64_t kept = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        remap[i] = (dims[i] == 1) ? -1 : (int64_t)kept;
+        if (dims[i] != 1) {
+            kept_dims[kept++] = dims[i];
+        }
+    }
+
+    uint64_t kept_axes[SC_PERMUTE_MAX_DIMS];
+    uint64_t m = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        if (remap[axes[i]] >= 0) {
+            kept_axes[m++] = (uint64_t)remap[axes[i]];
+        }
+    }
+
+    // groups of consecutive input axes, in output order
+    uint64_t group_first[SC_PERMUTE_MAX_DIMS];
+    uint64_t group_size[SC_PERMUTE_MAX_DIMS];
+    uint64_t groups = 0;
+    for (uint64_t i = 0; i < m; i++) {
+        if (i > 0 && kept_axes[i] == kept_axes[i - 1] + 1) {
+            group_size[groups - 1] *= kept_dims[kept_axes[i]];
+            continue;
+        }
+        group_first[groups] = kept_axes[i];
+        group_size[groups] = kept_dims[kept_axes[i]];
+        groups++;
+    }
+
+    // the merged input axes keep the order of their first axis
+    for (uint64_t g = 0; g < groups; g++) {
+        uint64_t rank = 0;
+        for (uint64_t h = 0; h < groups; h++) {
+            rank += (group_first[h] < group_first[g]);
+        }
+        axes[g] = rank;
+        dims[rank] = group_size[g];
+    }
+
+    return groups;
+}
+
+
+int sc_permute_buffer(const void* src, void* dst, uint64_t el_size, uint64_t dims_count, uint64_t* dims, uint64_t* axes, ccb_arena* arena) {
+    CCB_NOTNULL(dims, "dims is NULL");
+    CCB_NOTNULL(axes, "axes is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+
+    if (dims_count > SC_PERMUTE_MAX_DIMS) {
+        CCB_ERROR("Cannot permute more than %u dimensions, got %" PRIu64, SC_PERMUTE_MAX_DIMS, dims_count);
+        return -1;
+    }
+
+    uint64_t total = 1;
+    uint64_t seen = 0;
+    for (uint64_t i = 0; i < dims_count; i++) {
+        if (axes[i] >= dims_count || (seen & (1ull << axes[i]))) {
+            CCB_ERROR("axes is not a permutation (axis %" PRIu64 " at %" PRIu64 ")", axes[i], i);
+            return -1;
+        }
+        seen |= 1ull << axes[i];
+        total *= dims[i];
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+    CCB_NOTNULL(src, "src is NULL");
+    CCB_NOTNULL(dst, "dst is NULL");
+
+    uint64_t d[SC_PERMUTE_MAX_DIMS];
+    uint64_t p[SC_PERMUTE_MAX_DIMS];
+    memcpy(d, dims, dims_count * sizeof(uint64_t));
+    memcpy(p, axes, dims_count * sizeof(uint64_t));
+    uint64_t n = simplify_axes(dims_count, d, p);
+
+    // row major strides of the input and of the output (in output order)
+    uint64_t src_stride[SC_PERMUTE_MAX_DIMS];
+    uint64_t dst_stride[SC_PERMUTE_MAX_DIMS];
+    for (uint64_t k = n, s = 1; k > 0; k--) {
+        src_stride[k - 1] = s;
+        s *= d[k - 1];
+    }
+    for (uint64_t k = n, s = 1; k > 0; k--) {
+        dst_stride[k - 1] = s;
+        s *= d[p[k - 1]];
+    }
+
+    struct permute_args args;
+    memset(&args, 0, sizeof(args));
+    args.src = (const uint8_t*)src;
+    args.dst = (uint8_t*)dst;
+    args.el_size = el_size;
+    args.stream = (total * el_size > sc_get_llc_size());
+
+    int transpose = (n >= 2 && p[n - 1] != n - 1);
+    uint64_t skip = n;
+    if (transpose) {
+        // input axis p[n-1] becomes the contiguous output axis, the contiguous input axis n-1 moves to skip
+        for (uint64_t i = 0; i < n; i++) {
+            if (p[i] == n - 1) skip = i;
+        }
+        args.rows = d[p[n - 1]];
+        args.cols = d[n - 1];
+        args.src_ld = src_stride[p[n - 1]];
+        args.dst_ld = dst_stride[skip];
+        args.row_tiles = (args.rows + PERMUTE_TILE - 1) / PERMUTE_TILE;
+        args.col_tiles = (args.cols + PERMUTE_TILE - 1) / PERMUTE_TILE;
+    } else {
+        args.inner = (n == 0) ? 1 : d[n - 1];
+        args.inner_chunk = PERMUTE_COPY_CHUNK / el_size + 1;
+        args.inner_chunks = (args.inner + args.inner_chunk - 1) / args.inner_chunk;
+    }
+
+    for (uint64_t i = 0; n > 0 && i < n - 1; i++) {
+        if (i == skip) continue;
+        args.outer_dims[args.outer_count] = d[p[i]];
+        args.outer_src_stride[args.outer_count] = src_stride[p[i]];
+        args.outer_dst_stride[args.outer_count] = dst_stride[i];
+        args.outer_count++;
+    }
+
+    uint64_t outer_total = 1;
+    for (uint64_t k = 0; k < args.outer_count; k++) {
+        outer_total *= args.outer_dims[k];
+    }
+
+    int result = transpose ? sc_run_range_task(transpose_kernel, &args, outer_total * args.row_tiles * args.col_tiles, total, arena)
+                           : sc_run_range_task(copy_kernel, &args, outer_total * args.inner_chunks, total, arena);
+    if (result != 0) {
+        CCB_ERROR("Failed to run permute task");
+        return -1;
+    }
+    return 0;
+}
+
+
+// #######
+// api
+// #######
+
+sc_tensor* sc_tensor_permute(sc_tensor* a, uint64_t* axes, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(axes, "axes is NULL");
+
+    uint64_t count = a->dims->dims_count;
+    if (count > SC_PERMUTE_MAX_DIMS) {
+        CCB_ERROR("Cannot permute more than %u dimensions, got %" PRIu64, SC_PERMUTE_MAX_DIMS, count);
+        return NULL;
+    }
+
+    uint64_t dims[SC_PERMUTE_MAX_DIMS];
+    for (uint64_t i = 0; i < count; i++) {
+        if (axes[i] >= count) {
+            CCB_ERROR("Invalid axis %" PRIu64 " for a tensor of %" PRIu64 " dimensions", axes[i], count);
+            return NULL;
+        }
+        dims[i] = a->dims->dims[axes[i]];
+    }
+
+    sc_dimensions* out_dims = sc_create_dimensions(count, arena, dims);
+    CCB_NOTNULL(out_dims, "Failed to create output dimensions");
+    sc_tensor* out = sc_create_tensor(out_dims, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create output tensor");
+
+    if (sc_permute_buffer(a->data, out->data, sc_type_size(a->type), count, a->dims->dims, axes, arena) != 0) {
+        return NULL;
+    }
+    return out;
+}
+
+
+sc_tensor* sc_tensor_transpose(sc_tensor* a, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+
+    uint64_t count = a->dims->dims_count;
+    if (count < 2 || count > SC_PERMUTE_MAX_DIMS) {
+        CCB_ERROR("Cannot transpose a tensor of %" PRIu64 " dimensions", count);
+        return NULL;
+    }
+
+    uint64_t axes[SC_PERMUTE_MAX_DIMS];
+    for (uint64_t i = 0; i < count; i++) {
+        axes[i] = i;
+    }
+    axes[count - 2] = count - 1;
+    axes[count - 1] = count - 2;
+
+    return sc_tensor_permute(a, axes, arena);
+}
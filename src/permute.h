@@ -0,0 +1,45 @@
+#ifndef __PERMUTE_H__
+#define __PERMUTE_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    layout changes of tensors (transpose, NCHW <-> NHWC, any axis permutation)
+    the axes of size 1 are dropped and the axes that stay adjacent are merged, what remains is either
+    a copy of contiguous rows or a batch of 2d transposes done in cache tiles with in-register
+    8x8 (float32, bfloat16) or 4x4 (float64) SIMD transposes
+    tiles are distributed over the engine threads, outputs larger than the last level cache use streaming stores
+*/
+
+#define SC_PERMUTE_MAX_DIMS 16
+
+
+/* Permutes the dimensions of a tensor: out.dims[i] = a.dims[axes[i]]
+   - sc_tensor* a: input tensor
+   - uint64_t* axes: permutation of [0, dims_count)
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the result tensor
+*/
+sc_tensor* sc_tensor_permute(sc_tensor* a, uint64_t* axes, ccb_arena* arena);
+/* Transposes the last 2 dimensions of a tensor (batched over the leading dimensions)
+   - sc_tensor* a: input tensor, at least 2 dimensions
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the result tensor
+*/
+sc_tensor* sc_tensor_transpose(sc_tensor* a, ccb_arena* arena);
+/* Permutes the dimensions of a raw row major buffer, for any element size
+   - const void* src: input buffer
+   - void* dst: output buffer (must not overlap src)
+   - uint64_t el_size: size of an element in bytes
+   - uint64_t dims_count: number of dimensions (at most SC_PERMUTE_MAX_DIMS)
+   - uint64_t* dims: dimensions of the input
+   - uint64_t* axes: permutation of [0, dims_count), output dimension i is input dimension axes[i]
+   - ccb_arena* arena: arena where the task will be allocated
+   - return: 0 on success
+*/
+int sc_permute_buffer(const void* src, void* dst, uint64_t el_size, uint64_t dims_count, uint64_t* dims, uint64_t* axes, ccb_arena* arena);
+
+
+#endif // __PERMUTE_H__
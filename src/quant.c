@@ -0,0 +1,696 @@
+#include "data.h"
+#include "quant.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+// quantise / dequantise work units, in elements
+#define QUANT_CHUNK (64 * 1024)
+// rows of a (m) and rows of b (n) of a GEMM work unit
+#define QGEMM_MB 2
+#define QGEMM_NC 64
+
+
+struct quant_args {
+    sc_TYPES type;
+    sc_qtype qtype;
+    const void* x;
+    void* q;
+    void* y;
+    uint64_t size;
+
+    // element i uses the scale of channel (i / inner) % channels
+    uint64_t inner;
+    uint64_t channels;
+    const float* scales;
+    const int32_t* zero_points;
+
+    // row sums
+    uint64_t row_size;
+    int32_t* row_sums;
+};
+
+
+struct qgemm_args {
+    const uint8_t* a;
+    const int8_t* b;
+    uint64_t m;
+    uint64_t n;
+    uint64_t k;
+
+    // uint8 activations are read as int8 (xor 0x80) with the zero point moved by 128
+    uint8_t flip;
+    int64_t za;
+    const int32_t* a_sums;
+    const int32_t* b_sums;
+    const int32_t* zb;
+    float sa;
+    const float* sb;
+
+    const void* bias;
+    sc_TYPES bias_type;
+
+    // output, requantised when quantized is set
+    void* c;
+    sc_TYPES c_type;
+    int quantized;
+    sc_qtype c_qtype;
+    float inv_c_scale;
+    int32_t c_zero_point;
+
+    uint64_t m_blocks;
+};
+
+
+// #######
+// helpers
+// #######
+
+static double load_value(const void* base, uint64_t index, sc_TYPES type) {
+    if (type == sc_float64) {
+        return ((const double*)base)[index];
+    }
+    return sc_load_f32(base, index, type);
+}
+
+static void store_value(void* base, uint64_t index, double value, sc_TYPES type) {
+    if (type == sc_float64) {
+        ((double*)base)[index] = value;
+        return;
+    }
+    sc_store_f32(base, index, (float)value, type);
+}
+
+static int check_type(sc_TYPES type) {
+    if (type != sc_float16 && type != sc_float32 && type != sc_float64) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", type);
+        return -1;
+    }
+    return 0;
+}
+
+// int8 stays symmetric so that -128 never reaches the sign trick of the dot kernels
+static int32_t qmin(sc_qtype type) {
+    return (type == sc_qint8) ? -127 : 0;
+}
+
+static int32_t qmax(sc_qtype type) {
+    return (type == sc_qint8) ? 127 : 255;
+}
+
+static int32_t clamp_q(int64_t value, sc_qtype type) {
+    return (int32_t)((value < qmin(type)) ? qmin(type) : (value > qmax(type)) ? qmax(type) : value);
+}
+
+static int32_t load_q(const void* base, uint64_t index, sc_qtype type) {
+    return (type == sc_qint8) ? ((const int8_t*)base)[index] : ((const uint8_t*)base)[index];
+}
+
+
+// allocates the header and the data of a quantised tensor, the scales are left to the caller
+static sc_qtensor* create_qtensor(sc_dimensions* dims, sc_qtype type, int64_t axis, ccb_arena* arena) {
+    CCB_NOTNULL(dims, "dims is NULL");
+    if (type != sc_qint8 && type != sc_quint8) {
+        CCB_ERROR("Unsupported sc_qtype value %d", type);
+        return NULL;
+    }
+    if (axis >= (int64_t)dims->dims_count || axis < -1) {
+        CCB_ERROR("Invalid channel axis %" PRId64 " for %" PRIu64 " dimensions", axis, dims->dims_count);
+        return NULL;
+    }
+
+    sc_qtensor* q = (sc_qtensor*)ccb_arena_malloc(arena, sizeof(sc_qtensor));
+    CCB_NOTNULL(q, "Failed to allocate the quantised tensor");
+
+    q->size = 1;
+    for (uint64_t i = 0; i < dims->dims_count; i++) {
+        q->size *= dims->dims[i];
+    }
+    q->dims = sc_create_dimensions(dims->dims_count, arena, dims->dims);
+    q->type = type;
+    q->axis = axis;
+    q->channels = (axis < 0) ? 1 : dims->dims[axis];
+
+    uint64_t last = (dims->dims_count == 0) ? 1 : dims->dims[dims->dims_count - 1];
+    q->data = ccb_arena_malloc(arena, q->size + 32);
+    q->scales = (float*)ccb_arena_malloc(arena, q->channels * sizeof(float));
+    q->zero_points = (int32_t*)ccb_arena_malloc(arena, q->channels * sizeof(int32_t));
+    q->row_sums = (int32_t*)ccb_arena_malloc(arena, (last == 0 ? 1 : q->size / last) * sizeof(int32_t) + 1);
+    CCB_NOTNULL(q->dims, "Failed to create the dimensions");
+    CCB_NOTNULL(q->data, "Failed to allocate the quantised data");
+    CCB_NOTNULL(q->scales, "Failed to allocate the scales");
+    CCB_NOTNULL(q->zero_points, "Failed to allocate the zero points");
+    CCB_NOTNULL(q->row_sums, "Failed to allocate the row sums");
+    return q;
+}
+
+// number of elements sharing a scale before the channel changes
+static uint64_t channel_inner(sc_dimensions* dims, int64_t axis) {
+    uint64_t inner = 1;
+    for (uint64_t i = (axis < 0) ? 0 : (uint64_t)axis + 1; i < dims->dims_count; i++) {
+        inner *= dims->dims[i];
+    }
+    return (inner == 0) ? 1 : inner;
+}
+
+
+// #################
+// quantise kernels
+// #################
+
+// 8 float32 lanes -> 8 clamped quantised bytes
+static inline void quantize_f32x8(__m256 value, __m256 inv_scale, __m128i zero_point, __m128i low, __m128i high, uint8_t* out, sc_qtype type) {
+    __m256i rounded = _mm256_cvtps_epi32(_mm256_mul_ps(value, inv_scale));
+    __m128i lo = _mm_add_epi32(_mm256_castsi256_si128(rounded), zero_point);
+    __m128i hi = _mm_add_epi32(_mm256_extractf128_si256(rounded, 1), zero_point);
+    lo = _mm_min_epi32(_mm_max_epi32(lo, low), high);
+    hi = _mm_min_epi32(_mm_max_epi32(hi, low), high);
+
+    __m128i words = _mm_packs_epi32(lo, hi);
+    __m128i bytes = (type == sc_qint8) ? _mm_packs_epi16(words, words) : _mm_packus_epi16(words, words);
+    _mm_storel_epi64((__m128i*)out, bytes);
+}
+
+static void quantize_run(struct quant_args* args, uint64_t start, uint64_t end, uint64_t channel) {
+    float scale = args->scales[channel];
+    int32_t zero_point = args->zero_points ? args->zero_points[channel] : 0;
+    float inv = 1.0f / scale;
+    uint8_t* q = (uint8_t*)args->q;
+
+    __m256 inv_scale = _mm256_set1_ps(inv);
+    __m128i zp = _mm_set1_epi32(zero_point);
+    __m128i low = _mm_set1_epi32(qmin(args->qtype));
+    __m128i high = _mm_set1_epi32(qmax(args->qtype));
+
+    uint64_t i = start;
+    if (args->type != sc_float64) {
+        for (; i + 8 <= end; i += 8) {
+            quantize_f32x8(sc_load_f32x8(args->x, i, args->type), inv_scale, zp, low, high, q + i, args->qtype);
+        }
+    } else {
+        const double* x = (const double*)args->x;
+        for (; i + 8 <= end; i += 8) {
+            __m256 value = _mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(x + i + 4)), _mm256_cvtpd_ps(_mm256_loadu_pd(x + i)));
+            quantize_f32x8(value, inv_scale, zp, low, high, q + i, args->qtype);
+        }
+    }
+
+    for (; i < end; i++) {
+        int32_t value = clamp_q((int64_t)lrintf((float)load_value(args->x, i, args->type) * inv) + zero_point, args->qtype);
+        q[i] = (uint8_t)value;
+    }
+}
+
+static int quantize_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct quant_args* args = (struct quant_args*)raw;
+
+    for (uint64_t u = start; u < end; u++) {
+        uint64_t i = u * QUANT_CHUNK;
+        uint64_t chunk_end = (i + QUANT_CHUNK < args->size) ? i + QUANT_CHUNK : args->size;
+        while (i < chunk_end) {
+            uint64_t run_end = (i / args->inner + 1) * args->inner;
+            run_end = (run_end < chunk_end) ? run_end : chunk_end;
+            quantize_run(args, i, run_end, (i / args->inner) % args->channels);
+            i = run_end;
+        }
+    }
+    return 0;
+}
+
+
+static void dequantize_run(struct quant_args* args, uint64_t start, uint64_t end, uint64_t channel) {
+    float scale = args->scales[channel];
+    int32_t zero_point = args->zero_points[channel];
+    const uint8_t* q = (const uint8_t*)args->q;
+
+    uint64_t i = start;
+    if (args->type != sc_float64) {
+        __m256 vscale = _mm256_set1_ps(scale);
+        __m128i zp = _mm_set1_epi32(zero_point);
+        for (; i + 8 <= end; i += 8) {
+            __m128i bytes = _mm_loadl_epi64((const __m128i*)(q + i));
+            __m128i lo = (args->qtype == sc_qint8) ? _mm_cvtepi8_epi32(bytes) : _mm_cvtepu8_epi32(bytes);
+            __m128i hi = (args->qtype == sc_qint8) ? _mm_cvtepi8_epi32(_mm_srli_si128(bytes, 4)) : _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4));
+            __m256i values = _mm256_set_m128i(_mm_sub_epi32(hi, zp), _mm_sub_epi32(lo, zp));
+            sc_store_f32x8(args->y, i, _mm256_mul_ps(_mm256_cvtepi32_ps(values), vscale), args->type);
+        }
+    }
+
+    for (; i < end; i++) {
+        store_value(args->y, i, (double)(load_q(q, i, args->qtype) - zero_point) * scale, args->type);
+    }
+}
+
+static int dequantize_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct quant_args* args = (struct quant_args*)raw;
+
+    for (uint64_t u = start; u < end; u++) {
+        uint64_t i = u * QUANT_CHUNK;
+        uint64_t chunk_end = (i + QUANT_CHUNK < args->size) ? i + QUANT_CHUNK : args->size;
+        while (i < chunk_end) {
+            uint64_t run_end = (i / args->inner + 1) * args->inner;
+            run_end = (run_end < chunk_end) ? run_end : chunk_end;
+            dequantize_run(args, i, run_end, (i / args->inner) % args->channels);
+            i = run_end;
+        }
+    }
+    return 0;
+}
+
+
+static int row_sums_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct quant_args* args = (struct quant_args*)raw;
+
+    for (uint64_t r = start; r < end; r++) {
+        int32_t sum = 0;
+        for (uint64_t i = r * args->row_size; i < (r + 1) * args->row_size; i++) {
+            sum += load_q(args->q, i, args->qtype);
+        }
+        args->row_sums[r] = sum;
+    }
+    return 0;
+}
+
+static int compute_row_sums(sc_qtensor* q, ccb_arena* arena) {
+    struct quant_args args = {0};
+    args.q = q->data;
+    args.qtype = q->type;
+    args.row_size = (q->dims->dims_count == 0) ? 1 : q->dims->dims[q->dims->dims_count - 1];
+    args.row_sums = q->row_sums;
+
+    uint64_t rows = (args.row_size == 0) ? 0 : q->size / args.row_size;
+    return sc_run_range_task(row_sums_kernel, &args, rows, q->size, arena);
+}
+
+
+// ###########
+// dot kernels
+// ###########
+
+// a . b for signed bytes with maddubs: |a| (unsigned) times b with the sign of a, pairs of products
+// stay below 2 * 128 * 127 so the int16 sums never saturate as long as b avoids -128
+#define QDOT_STEP(acc, ua, sa, b) acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(ua, _mm256_sign_epi8(b, sa)), ones))
+
+SC_TARGET_AVX2 static inline int32_t hsum_epi32(__m256i value) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+static int32_t dot_tail(const uint8_t* a, const int8_t* b, uint64_t start, uint64_t k, uint8_t flip) {
+    int32_t sum = 0;
+    for (uint64_t i = start; i < k; i++) {
+        sum += (int32_t)(int8_t)(a[i] ^ flip) * b[i];
+    }
+    return sum;
+}
+
+SC_TARGET_AVX2 static void dot_2x4(const uint8_t* a, const int8_t* b, uint64_t k, uint8_t flip, int32_t out[2][4]) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i vflip = _mm256_set1_epi8((char)flip);
+    __m256i acc[2][4];
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 4; j++) acc[i][j] = _mm256_setzero_si256();
+    }
+
+    uint64_t p = 0;
+    for (; p + 32 <= k; p += 32) {
+        __m256i a0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + p)), vflip);
+        __m256i a1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + k + p)), vflip);
+        __m256i u0 = _mm256_abs_epi8(a0);
+        __m256i u1 = _mm256_abs_epi8(a1);
+        for (int j = 0; j < 4; j++) {
+            __m256i bj = _mm256_loadu_si256((const __m256i*)(b + j * k + p));
+            QDOT_STEP(acc[0][j], u0, a0, bj);
+            QDOT_STEP(acc[1][j], u1, a1, bj);
+        }
+    }
+
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 4; j++) {
+            out[i][j] = hsum_epi32(acc[i][j]) + dot_tail(a + i * k, b + j * k, p, k, flip);
+        }
+    }
+}
+
+SC_TARGET_AVX2 static void dot_1x4(const uint8_t* a, const int8_t* b, uint64_t k, uint8_t flip, int32_t out[4]) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i vflip = _mm256_set1_epi8((char)flip);
+    __m256i acc[4];
+    for (int j = 0; j < 4; j++) acc[j] = _mm256_setzero_si256();
+
+    uint64_t p = 0;
+    for (; p + 32 <= k; p += 32) {
+        __m256i a0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + p)), vflip);
+        __m256i u0 = _mm256_abs_epi8(a0);
+        for (int j = 0; j < 4; j++) {
+            QDOT_STEP(acc[j], u0, a0, _mm256_loadu_si256((const __m256i*)(b + j * k + p)));
+        }
+    }
+
+    for (int j = 0; j < 4; j++) {
+        out[j] = hsum_epi32(acc[j]) + dot_tail(a, b + j * k, p, k, flip);
+    }
+}
+
+SC_TARGET_AVX2 static int32_t dot_1x1_avx2(const uint8_t* a, const int8_t* b, uint64_t k, uint8_t flip) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i vflip = _mm256_set1_epi8((char)flip);
+    __m256i acc = _mm256_setzero_si256();
+
+    uint64_t p = 0;
+    for (; p + 32 <= k; p += 32) {
+        __m256i a0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + p)), vflip);
+        QDOT_STEP(acc, _mm256_abs_epi8(a0), a0, _mm256_loadu_si256((const __m256i*)(b + p)));
+    }
+    return hsum_epi32(acc) + dot_tail(a, b, p, k, flip);
+}
+
+static int32_t dot_1x1(const uint8_t* a, const int8_t* b, uint64_t k, uint8_t flip) {
+    return sc_has_avx2_fma() ? dot_1x1_avx2(a, b, k, flip) : dot_tail(a, b, 0, k, flip);
+}
+
+
+// ############
+// gemm kernels
+// ############
+
+// zero point corrections, scales, bias and (re)quantisation of c[i, j]
+static void store_output(struct qgemm_args* args, uint64_t i, uint64_t j, int32_t dot) {
+    int64_t zb = args->zb[j];
+    int64_t acc = (int64_t)dot - zb * args->a_sums[i] - args->za * args->b_sums[j] + (int64_t)args->k * args->za * zb;
+    float value = args->sa * args->sb[j] * (float)acc;
+    if (args->bias) {
+        value += (float)load_value(args->bias, j, args->bias_type);
+    }
+
+    if (args->quantized) {
+        ((uint8_t*)args->c)[i * args->n + j] = (uint8_t)clamp_q((int64_t)lrintf(value * args->inv_c_scale) + args->c_zero_point, args->c_qtype);
+    } else {
+        store_value(args->c, i * args->n + j, value, args->c_type);
+    }
+}
+
+static int qgemm_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct qgemm_args* args = (struct qgemm_args*)raw;
+    uint64_t k = args->k;
+    int avx2 = sc_has_avx2_fma();
+
+    for (uint64_t u = start; u < end; u++) {
+        // consecutive units share the same rows of b
+        uint64_t i0 = (u % args->m_blocks) * QGEMM_MB;
+        uint64_t j0 = (u / args->m_blocks) * QGEMM_NC;
+        uint64_t i_end = (i0 + QGEMM_MB < args->m) ? i0 + QGEMM_MB : args->m;
+        uint64_t j_end = (j0 + QGEMM_NC < args->n) ? j0 + QGEMM_NC : args->n;
+
+        uint64_t j = j0;
+        if (avx2) {
+            for (; j + 4 <= j_end; j += 4) {
+                if (i_end - i0 == 2) {
+                    int32_t out[2][4];
+                    dot_2x4(args->a + i0 * k, args->b + j * k, k, args->flip, out);
+                    for (uint64_t jj = 0; jj < 4; jj++) {
+                        store_output(args, i0, j + jj, out[0][jj]);
+                        store_output(args, i0 + 1, j + jj, out[1][jj]);
+                    }
+                } else {
+                    int32_t out[4];
+                    dot_1x4(args->a + i0 * k, args->b + j * k, k, args->flip, out);
+                    for (uint64_t jj = 0; jj < 4; jj++) {
+                        store_output(args, i0, j + jj, out[jj]);
+                    }
+                }
+            }
+        }
+
+        for (; j < j_end; j++) {
+            for (uint64_t i = i0; i < i_end; i++) {
+                store_output(args, i, j, dot_1x1(args->a + i * k, args->b + j * k, k, args->flip));
+            }
+        }
+    }
+    return 0;
+}
+
+
+// ###
+// api
+// ###
+
+sc_qtensor* sc_quantize_with(sc_tensor* x, sc_qtype type, int64_t axis, float* scales, int32_t* zero_points, ccb_arena* arena) {
+    CCB_NOTNULL(x, "x is NULL");
+    CCB_NOTNULL(scales, "scales is NULL");
+    if (check_type(x->type) != 0) {
+        return NULL;
+    }
+
+    sc_qtensor* q = create_qtensor(x->dims, type, axis, arena);
+    CCB_NOTNULL(q, "Failed to create the quantised tensor");
+
+    for (uint64_t c = 0; c < q->channels; c++) {
+        if (!(scales[c] > 0.0f) || isinf(scales[c])) {
+            CCB_ERROR("Invalid scale %f for channel %" PRIu64, scales[c], c);
+            return NULL;
+        }
+        q->scales[c] = scales[c];
+        q->zero_points[c] = zero_points ? zero_points[c] : 0;
+    }
+
+    struct quant_args args = {0};
+    args.type = x->type;
+    args.qtype = type;
+    args.x = x->data;
+    args.q = q->data;
+    args.size = x->size;
+    args.inner = channel_inner(x->dims, axis);
+    args.channels = q->channels;
+    args.scales = q->scales;
+    args.zero_points = q->zero_points;
+
+    if (sc_run_range_task(quantize_kernel, &args, (x->size + QUANT_CHUNK - 1) / QUANT_CHUNK, x->size, arena) != 0
+        || compute_row_sums(q, arena) != 0) {
+        CCB_ERROR("Failed to quantise the tensor");
+        return NULL;
+    }
+    return q;
+}
+
+
+sc_qtensor* sc_quantize(sc_tensor* x, sc_qtype type, int symmetric, int64_t axis, ccb_arena* arena) {
+    CCB_NOTNULL(x, "x is NULL");
+    if (check_type(x->type) != 0) {
+        return NULL;
+    }
+    if (axis >= (int64_t)x->dims->dims_count || axis < -1) {
+        CCB_ERROR("Invalid channel axis %" PRId64 " for %" PRIu64 " dimensions", axis, x->dims->dims_count);
+        return NULL;
+    }
+
+    uint64_t channels = (axis < 0) ? 1 : x->dims->dims[axis];
+    uint64_t inner = channel_inner(x->dims, axis);
+    float* scales = (float*)ccb_arena_malloc(arena, channels * sizeof(float) + 1);
+    int32_t* zero_points = (int32_t*)ccb_arena_malloc(arena, channels * sizeof(int32_t) + 1);
+    double* low = (double*)ccb_arena_malloc(arena, channels * sizeof(double) + 1);
+    double* high = (double*)ccb_arena_malloc(arena, channels * sizeof(double) + 1);
+    CCB_NOTNULL(scales, "Failed to allocate the scales");
+    CCB_NOTNULL(zero_points, "Failed to allocate the zero points");
+    CCB_NOTNULL(low, "Failed to allocate the ranges");
+    CCB_NOTNULL(high, "Failed to allocate the ranges");
+
+    // the range always contains 0 so that padding and ReLU outputs are exact
+    for (uint64_t c = 0; c < channels; c++) {
+        low[c] = 0.0;
+        high[c] = 0.0;
+    }
+    for (uint64_t i = 0; i < x->size; i++) {
+        uint64_t c = (i / inner) % channels;
+        double value = load_value(x->data, i, x->type);
+        low[c] = (value < low[c]) ? value : low[c];
+        high[c] = (value > high[c]) ? value : high[c];
+    }
+
+    for (uint64_t c = 0; c < channels; c++) {
+        double scale;
+        if (symmetric) {
+            double amax = (-low[c] > high[c]) ? -low[c] : high[c];
+            scale = amax / 127.0;
+            zero_points[c] = (type == sc_qint8) ? 0 : 128;
+        } else {
+            scale = (high[c] - low[c]) / (double)(qmax(type) - qmin(type));
+            zero_points[c] = (scale > 0.0) ? clamp_q(qmin(type) - (int64_t)llrint(low[c] / scale), type) : 0;
+        }
+        scales[c] = (scale > 0.0) ? (float)scale : 1.0f;
+    }
+
+    return sc_quantize_with(x, type, axis, scales, zero_points, arena);
+}
+
+
+sc_tensor* sc_dequantize(sc_qtensor* q, sc_TYPES type, ccb_arena* arena) {
+    CCB_NOTNULL(q, "q is NULL");
+    if (check_type(type) != 0) {
+        return NULL;
+    }
+
+    sc_tensor* out = sc_create_tensor(sc_create_dimensions(q->dims->dims_count, arena, q->dims->dims), type, arena);
+    CCB_NOTNULL(out, "Failed to create result tensor");
+
+    struct quant_args args = {0};
+    args.type = type;
+    args.qtype = q->type;
+    args.q = q->data;
+    args.y = out->data;
+    args.size = q->size;
+    args.inner = channel_inner(q->dims, q->axis);
+    args.channels = q->channels;
+    args.scales = q->scales;
+    args.zero_points = q->zero_points;
+
+    if (sc_run_range_task(dequantize_kernel, &args, (q->size + QUANT_CHUNK - 1) / QUANT_CHUNK, q->size, arena) != 0) {
+        CCB_ERROR("Failed to dequantise the tensor");
+        return NULL;
+    }
+    return out;
+}
+
+
+double sc_qdot(sc_qtensor* a, sc_qtensor* b) {
+    if (!a || !b || a->size != b->size || a->channels != 1 || b->channels != 1 || b->type != sc_qint8) {
+        CCB_ERROR("Invalid quantised dot operands (same size, single scale, int8 b)");
+        return 0.0;
+    }
+
+    uint8_t flip = (a->type == sc_quint8) ? 0x80 : 0;
+    int64_t za = a->zero_points[0] - (flip ? 128 : 0);
+    int64_t zb = b->zero_points[0];
+
+    int64_t sum_a = 0;
+    int64_t sum_b = 0;
+    uint64_t rows = (a->dims->dims_count == 0 || a->dims->dims[a->dims->dims_count - 1] == 0) ? 1 : a->size / a->dims->dims[a->dims->dims_count - 1];
+    for (uint64_t r = 0; r < rows; r++) {
+        sum_a += a->row_sums[r];
+    }
+    rows = (b->dims->dims_count == 0 || b->dims->dims[b->dims->dims_count - 1] == 0) ? 1 : b->size / b->dims->dims[b->dims->dims_count - 1];
+    for (uint64_t r = 0; r < rows; r++) {
+        sum_b += b->row_sums[r];
+    }
+    sum_a -= (flip ? 128 : 0) * (int64_t)a->size;
+
+    int64_t dot = dot_1x1((const uint8_t*)a->data, (const int8_t*)b->data, a->size, flip);
+    int64_t acc = dot - zb * sum_a - za * sum_b + (int64_t)a->size * za * zb;
+    return (double)a->scales[0] * (double)b->scales[0] * (double)acc;
+}
+
+
+// shared setup of the quantised GEMMs, c is allocated by the caller
+static int run_qgemm(sc_qtensor* a, sc_qtensor* b, sc_vector* bias, struct qgemm_args* args, ccb_arena* arena) {
+    if (a->dims->dims_count != 2 || b->dims->dims_count != 2 || a->dims->dims[1] != b->dims->dims[1]) {
+        CCB_ERROR("Quantised GEMM expects a [m, k] and b [n, k]");
+        return -1;
+    }
+    if (a->channels != 1 || b->type != sc_qint8 || (b->channels != 1 && b->axis != 0)) {
+        CCB_ERROR("Quantised GEMM expects a single scale for a and an int8 b with a single scale or one per row");
+        return -1;
+    }
+    if (bias && bias->size != b->dims->dims[0]) {
+        CCB_ERROR("Bias size mismatch: %" PRIu64 " vs %" PRIu64, bias->size, b->dims->dims[0]);
+        return -1;
+    }
+
+    args->m = a->dims->dims[0];
+    args->n = b->dims->dims[0];
+    args->k = a->dims->dims[1];
+    args->a = (const uint8_t*)a->data;
+    args->b = (const int8_t*)b->data;
+    args->flip = (a->type == sc_quint8) ? 0x80 : 0;
+    args->za = a->zero_points[0] - (args->flip ? 128 : 0);
+    args->sa = a->scales[0];
+    args->bias = bias ? bias->data : NULL;
+    args->bias_type = bias ? bias->type : sc_float32;
+    args->b_sums = b->row_sums;
+
+    // per row scales and zero points of b, the row sums of a are moved with the flip
+    float* sb = (float*)ccb_arena_malloc(arena, args->n * sizeof(float) + 1);
+    int32_t* zb = (int32_t*)ccb_arena_malloc(arena, args->n * sizeof(int32_t) + 1);
+    int32_t* a_sums = (int32_t*)ccb_arena_malloc(arena, args->m * sizeof(int32_t) + 1);
+    CCB_NOTNULL(sb, "Failed to allocate the scales");
+    CCB_NOTNULL(zb, "Failed to allocate the zero points");
+    CCB_NOTNULL(a_sums, "Failed to allocate the row sums");
+    for (uint64_t j = 0; j < args->n; j++) {
+        sb[j] = b->scales[(b->channels == 1) ? 0 : j];
+        zb[j] = b->zero_points[(b->channels == 1) ? 0 : j];
+    }
+    for (uint64_t i = 0; i < args->m; i++) {
+        a_sums[i] = a->row_sums[i] - (args->flip ? 128 * (int32_t)args->k : 0);
+    }
+    args->sb = sb;
+    args->zb = zb;
+    args->a_sums = a_sums;
+
+    args->m_blocks = (args->m + QGEMM_MB - 1) / QGEMM_MB;
+    uint64_t units = args->m_blocks * ((args->n + QGEMM_NC - 1) / QGEMM_NC);
+    if (sc_run_range_task(qgemm_kernel, args, units, args->m * args->n * args->k, arena) != 0) {
+        CCB_ERROR("Failed to run the quantised GEMM");
+        return -1;
+    }
+    return 0;
+}
+
+
+sc_tensor* sc_qgemm(sc_qtensor* a, sc_qtensor* b, sc_vector* bias, sc_TYPES type, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(b, "b is NULL");
+    if (check_type(type) != 0 || a->dims->dims_count != 2 || b->dims->dims_count != 2) {
+        CCB_ERROR("Quantised GEMM expects 2D operands and a floating point output");
+        return NULL;
+    }
+
+    sc_tensor* out = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){a->dims->dims[0], b->dims->dims[0]}), type, arena);
+    CCB_NOTNULL(out, "Failed to create result tensor");
+
+    struct qgemm_args args = {0};
+    args.c = out->data;
+    args.c_type = type;
+    if (run_qgemm(a, b, bias, &args, arena) != 0) {
+        return NULL;
+    }
+    return out;
+}
+
+
+sc_qtensor* sc_qgemm_requantize(sc_qtensor* a, sc_qtensor* b, sc_vector* bias, sc_qtype type, float scale, int32_t zero_point, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(b, "b is NULL");
+    if (a->dims->dims_count != 2 || b->dims->dims_count != 2 || !(scale > 0.0f)) {
+        CCB_ERROR("Quantised GEMM expects 2D operands and a positive output scale");
+        return NULL;
+    }
+
+    sc_qtensor* out = create_qtensor(sc_create_dimensions(2, arena, (uint64_t[]){a->dims->dims[0], b->dims->dims[0]}), type, -1, arena);
+    CCB_NOTNULL(out, "Failed to create the quantised result");
+    out->scales[0] = scale;
+    out->zero_points[0] = zero_point;
+
+    struct qgemm_args args = {0};
+    args.c = out->data;
+    args.quantized = 1;
+    args.c_qtype = type;
+    args.inv_c_scale = 1.0f / scale;
+    args.c_zero_point = zero_point;
+    if (run_qgemm(a, b, bias, &args, arena) != 0 || compute_row_sums(out, arena) != 0) {
+        return NULL;
+    }
+    return out;
+}
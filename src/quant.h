@@ -0,0 +1,82 @@
+#ifndef __QUANT_H__
+#define __QUANT_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    8 bits quantised tensors: real = (q - zero_point) * scale
+    int8 values are kept in [-127, 127] (symmetric range, so that the AVX2 kernels never saturate),
+    uint8 values use [0, 255]
+    the scales are per tensor (axis = -1) or per channel along one axis (typically the output channels of weights)
+    the integer GEMM accumulates in int32 and applies the scales, bias and requantisation on the output tile
+*/
+
+typedef enum {
+    sc_qint8,
+    sc_quint8,
+} sc_qtype;
+
+typedef struct {
+    void* data;             // int8_t or uint8_t
+    sc_dimensions* dims;
+    uint64_t size;
+    sc_qtype type;
+    int64_t axis;           // channel axis of the scales, -1 for a single scale
+    uint64_t channels;      // number of scales
+    float* scales;
+    int32_t* zero_points;
+    int32_t* row_sums;      // sums of the values along the last axis, used by the zero point corrections
+} sc_qtensor;
+
+
+/* Quantises a tensor, the scales are computed from the range of each channel (zero is always representable)
+   - sc_tensor* x: input tensor
+   - sc_qtype type: int8 or uint8
+   - int symmetric: 1 for a zero point of 0 (int8) or 128 (uint8), 0 to fit [min, max]
+   - int64_t axis: channel axis of the scales, -1 for a single scale
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the quantised tensor
+*/
+sc_qtensor* sc_quantize(sc_tensor* x, sc_qtype type, int symmetric, int64_t axis, ccb_arena* arena);
+/* Quantises a tensor with known scales and zero points (calibrated activations)
+   - sc_tensor* x: input tensor
+   - sc_qtype type: int8 or uint8
+   - int64_t axis: channel axis of the scales, -1 for a single scale
+   - float* scales, int32_t* zero_points: one per channel (zero_points can be NULL for 0)
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the quantised tensor
+*/
+sc_qtensor* sc_quantize_with(sc_tensor* x, sc_qtype type, int64_t axis, float* scales, int32_t* zero_points, ccb_arena* arena);
+/* Converts a quantised tensor back to floating point
+   - sc_qtensor* q: quantised tensor
+   - sc_TYPES type: type of the result
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the result tensor
+*/
+sc_tensor* sc_dequantize(sc_qtensor* q, sc_TYPES type, ccb_arena* arena);
+
+/* Dot product of two quantised tensors with a single scale each, int32 accumulation
+   - sc_qtensor* a, sc_qtensor* b: tensors of the same size, b must be int8
+   - return: the real dot product
+*/
+double sc_qdot(sc_qtensor* a, sc_qtensor* b);
+/* Quantised matrix product c = a . b^T + bias with a floating point output (GEMV when m = 1)
+   - sc_qtensor* a: activations [m, k], int8 or uint8, single scale
+   - sc_qtensor* b: weights [n, k] (dense layer layout), int8, single scale or one scale per row (axis 0)
+   - sc_vector* bias: bias of size n (any floating point type), NULL for 0
+   - sc_TYPES type: type of the result
+   - ccb_arena* arena: arena where the result and the scratch will be allocated
+   - return: a pointer to the result tensor [m, n]
+*/
+sc_tensor* sc_qgemm(sc_qtensor* a, sc_qtensor* b, sc_vector* bias, sc_TYPES type, ccb_arena* arena);
+/* Same as sc_qgemm with the requantisation fused in the output tile
+   - sc_qtype type: type of the result
+   - float scale, int32_t zero_point: quantisation of the result
+   - return: a pointer to the quantised result [m, n] with a single scale
+*/
+sc_qtensor* sc_qgemm_requantize(sc_qtensor* a, sc_qtensor* b, sc_vector* bias, sc_qtype type, float scale, int32_t zero_point, ccb_arena* arena);
+
+
+#endif // __QUANT_H__
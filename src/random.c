@@ -0,0 +1,554 @@
+#include "data.h"
+#include "random.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+// elements of a work unit, a multiple of RNG_BLOCK
+#define RNG_CHUNK 4096
+// elements generated at once on the stack, a multiple of the 32 elements of 8 interleaved Philox blocks
+#define RNG_BLOCK 256
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+#define RNG_TWO_PI 6.283185307179586
+
+
+typedef enum {
+    rng_uniform,
+    rng_normal,
+    rng_truncated_normal,
+    rng_bernoulli,
+} rng_kind;
+
+struct rng_args {
+    rng_kind kind;
+    sc_TYPES type;
+    uint64_t size;
+    void* out;
+    uint32_t key[2];
+    uint64_t counter;       // first Philox block of the fill
+    int wide;               // two words per element
+    int narrow;             // computed in float32
+
+    // uniform: [a, b), normal: mean a and std b, truncated normal: also the bounds of the standard normal
+    double a;
+    double b;
+    double cdf_lo;
+    double cdf_hi;
+    double z_lo;
+    double z_hi;
+    int flip;               // truncated normal computed on the mirrored interval
+    uint64_t threshold;     // bernoulli: words below it give 1
+};
+
+
+sc_rng sc_rng_create(uint64_t seed) {
+    sc_rng rng;
+    rng.seed = seed;
+    rng.counter = 0;
+    return rng;
+}
+
+
+void sc_philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t x0 = counter[0], x1 = counter[1], x2 = counter[2], x3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * x0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * x2;
+        uint32_t y0 = (uint32_t)(p1 >> 32) ^ x1 ^ k0;
+        uint32_t y2 = (uint32_t)(p0 >> 32) ^ x3 ^ k1;
+        x0 = y0;
+        x1 = (uint32_t)p1;
+        x2 = y2;
+        x3 = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = x0;
+    out[1] = x1;
+    out[2] = x2;
+    out[3] = x3;
+}
+
+
+// words of groups of 8 blocks from block, out[32 g + 8 j + l] is the word j of the block block + 8 g + l
+static void philox_words(const uint32_t key[2], uint64_t block, uint64_t groups, uint32_t stream, uint32_t* out) {
+    for (uint64_t g = 0; g < groups; g++) {
+        for (uint32_t l = 0; l < 8; l++) {
+            uint64_t index = block + 8 * g + l;
+            uint32_t counter[4] = {(uint32_t)index, (uint32_t)(index >> 32), stream, 0};
+            uint32_t words[4];
+            sc_philox4x32(counter, key, words);
+            for (int j = 0; j < 4; j++) {
+                out[32 * g + 8 * j + l] = words[j];
+            }
+        }
+    }
+}
+
+
+// high 32 bits of the products of the lanes by m
+static inline SC_TARGET_AVX2 __m256i mulhi_epu32(__m256i a, __m256i m) {
+    __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(a, m), 32);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+    return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+
+// same as philox_words, the 8 blocks of a group are the 8 lanes
+static SC_TARGET_AVX2 void philox_words_avx2(const uint32_t key[2], uint64_t block, uint64_t groups, uint32_t stream, uint32_t* out) {
+    const __m256i m0 = _mm256_set1_epi32((int)PHILOX_M0);
+    const __m256i m1 = _mm256_set1_epi32((int)PHILOX_M1);
+    for (uint64_t g = 0; g < groups; g++) {
+        uint32_t lo[8], hi[8];
+        for (uint32_t l = 0; l < 8; l++) {
+            uint64_t index = block + 8 * g + l;
+            lo[l] = (uint32_t)index;
+            hi[l] = (uint32_t)(index >> 32);
+        }
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)lo);
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)hi);
+        __m256i x2 = _mm256_set1_epi32((int)stream);
+        __m256i x3 = _mm256_setzero_si256();
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; round++) {
+            __m256i y0 = _mm256_xor_si256(_mm256_xor_si256(mulhi_epu32(x2, m1), x1), _mm256_set1_epi32((int)k0));
+            __m256i y2 = _mm256_xor_si256(_mm256_xor_si256(mulhi_epu32(x0, m0), x3), _mm256_set1_epi32((int)k1));
+            x1 = _mm256_mullo_epi32(x2, m1);
+            x3 = _mm256_mullo_epi32(x0, m0);
+            x0 = y0;
+            x2 = y2;
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        _mm256_storeu_si256((__m256i*)(out + 32 * g), x0);
+        _mm256_storeu_si256((__m256i*)(out + 32 * g + 8), x1);
+        _mm256_storeu_si256((__m256i*)(out + 32 * g + 16), x2);
+        _mm256_storeu_si256((__m256i*)(out + 32 * g + 24), x3);
+    }
+}
+
+
+// uniform in [0, 1), offset 1 gives (0, 1] and 0.5 gives (0, 1)
+static inline float uniform_f32(uint32_t word, float offset) {
+    return ((float)(word >> 8) + offset) * 0x1.0p-24f;
+}
+
+static inline double uniform_f64(const struct rng_args* args, const uint32_t* w0, const uint32_t* w1, uint64_t k, double offset) {
+    if (args->wide) {
+        return ((double)(((uint64_t)w0[k] << 21) ^ (w1[k] >> 11)) + offset) * 0x1.0p-53;
+    }
+    return ((double)(w0[k] >> 8) + offset) * 0x1.0p-24;
+}
+
+
+// quantile of the standard normal: Acklam's rational approximation (relative error 1.2e-9), refined with
+// one Halley step for the float64 results
+static double normal_quantile(double p, int refine) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00};
+    double x;
+    if (p < 0.02425 || p > 1.0 - 0.02425) {
+        double q = sqrt(-2.0 * log((p < 0.5) ? p : 1.0 - p));
+        x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+        x = (p < 0.5) ? x : -x;
+    } else {
+        double q = p - 0.5;
+        double r = q * q;
+        x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+            (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    }
+    if (!refine) {
+        return x;
+    }
+    double e = 0.5 * erfc(-x / sqrt(2.0)) - p;
+    double u = e * sqrt(RNG_TWO_PI) * exp(x * x / 2.0);
+    return x - u / (1.0 + x * u / 2.0);
+}
+
+
+// float32 log of positive normal values (Cephes logf)
+static inline SC_TARGET_AVX2 __m256 log_f32x8(__m256 x) {
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0x7e)));
+    // mantissa in [0.5, 1), then in [sqrt(1/2), sqrt(2)) - 1
+    x = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f000000)));
+    __m256 small = _mm256_cmp_ps(x, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+    e = _mm256_sub_ps(e, _mm256_and_ps(one, small));
+    x = _mm256_add_ps(_mm256_sub_ps(x, one), _mm256_and_ps(x, small));
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(7.0376836292e-2f);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.1514610310e-1f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.1676998740e-1f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.2420140846e-1f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.4249322787e-1f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-1.6668057665e-1f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(2.0000714765e-1f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(-2.4999993993e-1f));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(3.3333331174e-1f));
+    y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+    y = _mm256_fmadd_ps(e, _mm256_set1_ps(-2.12194440e-4f), y);
+    y = _mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, y);
+    return _mm256_fmadd_ps(e, _mm256_set1_ps(0.693359375f), _mm256_add_ps(x, y));
+}
+
+
+// float32 sin and cos of values in [-pi, pi] (Cephes sinf / cosf)
+static inline SC_TARGET_AVX2 void sincos_f32x8(__m256 x, __m256* sin_out, __m256* cos_out) {
+    __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    __m256 sign_sin = _mm256_and_ps(x, sign_mask);
+    x = _mm256_andnot_ps(sign_mask, x);
+
+    // octant j (made even) and x - j pi / 4 in three parts
+    __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f)));
+    j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    __m256 y = _mm256_cvtepi32_ps(j);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(-0.78515625f), x);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(-2.4187564849853515625e-4f), x);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(-3.77489497744594108e-8f), x);
+
+    sign_sin = _mm256_xor_ps(sign_sin, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29)));
+    __m256 sign_cos = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 c = _mm256_set1_ps(2.443315711809948e-5f);
+    c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(-1.388731625493765e-3f));
+    c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(4.166664568298827e-2f));
+    c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+    c = _mm256_add_ps(_mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, c), _mm256_set1_ps(1.0f));
+    __m256 s = _mm256_set1_ps(-1.9515295891e-4f);
+    s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(8.3321608736e-3f));
+    s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(-1.6666654611e-1f));
+    s = _mm256_fmadd_ps(_mm256_mul_ps(s, z), x, x);
+
+    *sin_out = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), sign_sin);
+    *cos_out = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sign_cos);
+}
+
+
+// uniform [lo, hi) on float32, the values rounded up to hi are moved to the float below it
+static SC_TARGET_AVX2 void uniform_f32_avx2(const struct rng_args* args, const uint32_t* w0, uint64_t count, float* fv) {
+    __m256 lo = _mm256_set1_ps((float)args->a);
+    __m256 top = _mm256_set1_ps(nextafterf((float)args->b, (float)args->a));
+    __m256 width = _mm256_set1_ps((float)(args->b - args->a));
+    __m256 scale = _mm256_set1_ps(0x1.0p-24f);
+    for (uint64_t k = 0; k < count; k += 8) {
+        __m256 u = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(_mm256_loadu_si256((const __m256i*)(w0 + k)), 8)), scale);
+        _mm256_storeu_ps(fv + k, _mm256_min_ps(_mm256_add_ps(lo, _mm256_mul_ps(u, width)), top));
+    }
+}
+
+
+// Box-Muller on float32, same pairing of the words as transform
+static SC_TARGET_AVX2 void normal_f32_avx2(const struct rng_args* args, const uint32_t* w0, uint64_t count, float* fv) {
+    __m256 scale = _mm256_set1_ps(0x1.0p-24f);
+    __m256 two_pi = _mm256_set1_ps((float)RNG_TWO_PI);
+    __m256 pi = _mm256_set1_ps((float)(RNG_TWO_PI / 2.0));
+    __m256 mean = _mm256_set1_ps((float)args->a);
+    __m256 std = _mm256_set1_ps((float)args->b);
+    for (uint64_t k = 0; k < count; k += 16) {
+        __m256i a = _mm256_srli_epi32(_mm256_loadu_si256((const __m256i*)(w0 + k)), 8);
+        __m256i b = _mm256_srli_epi32(_mm256_loadu_si256((const __m256i*)(w0 + k + 8)), 8);
+        __m256 u1 = _mm256_mul_ps(_mm256_add_ps(_mm256_cvtepi32_ps(a), _mm256_set1_ps(1.0f)), scale);
+        __m256 theta = _mm256_fmsub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(b), scale), two_pi, pi);
+        __m256 r = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_mul_ps(_mm256_set1_ps(-2.0f), log_f32x8(u1))), std);
+        __m256 s, c;
+        sincos_f32x8(theta, &s, &c);
+        _mm256_storeu_ps(fv + k, _mm256_fmadd_ps(r, c, mean));
+        _mm256_storeu_ps(fv + k + 8, _mm256_fmadd_ps(r, s, mean));
+    }
+}
+
+
+// values of count elements (a multiple of 32) from their words
+static void transform(const struct rng_args* args, const uint32_t* w0, const uint32_t* w1, uint64_t count, float* fv, double* dv) {
+    int integer = args->type == sc_int32 || args->type == sc_int64 || args->type == sc_uint8;
+    switch (args->kind) {
+        case rng_uniform:
+            if (args->narrow && sc_has_avx2_fma()) {
+                uniform_f32_avx2(args, w0, count, fv);
+            } else if (args->narrow) {
+                float lo = (float)args->a;
+                float top = nextafterf((float)args->b, lo);
+                float width = (float)(args->b - args->a);
+                for (uint64_t k = 0; k < count; k++) {
+                    float v = lo + uniform_f32(w0[k], 0.0f) * width;
+                    fv[k] = (v < top) ? v : top;
+                }
+            } else {
+                for (uint64_t k = 0; k < count; k++) {
+                    double v = args->a + uniform_f64(args, w0, w1, k, 0.0) * (args->b - args->a);
+                    if (integer) {
+                        v = floor(v);
+                        v = (v < args->b || args->b <= args->a) ? v : v - 1.0;
+                    } else if (v >= args->b) {
+                        v = nextafter(args->b, args->a);
+                    }
+                    dv[k] = v;
+                }
+            }
+            break;
+        case rng_normal:
+            // word j of a block pairs with word j + 1: r cos and r sin of the same draw
+            if (args->narrow && sc_has_avx2_fma()) {
+                normal_f32_avx2(args, w0, count, fv);
+                break;
+            }
+            for (uint64_t k = 0; k < count; k += 32) {
+                for (uint64_t j = 0; j < 32; j += 16) {
+                    for (uint64_t l = 0; l < 8; l++) {
+                        uint64_t i0 = k + j + l;
+                        uint64_t i1 = i0 + 8;
+                        if (args->narrow) {
+                            float r = sqrtf(-2.0f * logf(uniform_f32(w0[i0], 1.0f))) * (float)args->b;
+                            float theta = (float)RNG_TWO_PI * uniform_f32(w0[i1], 0.0f) - (float)(RNG_TWO_PI / 2.0);
+                            fv[i0] = (float)args->a + r * cosf(theta);
+                            fv[i1] = (float)args->a + r * sinf(theta);
+                        } else {
+                            double r = sqrt(-2.0 * log(uniform_f64(args, w0, w1, i0, 1.0))) * args->b;
+                            double theta = RNG_TWO_PI * uniform_f64(args, w0, w1, i1, 0.0) - RNG_TWO_PI / 2.0;
+                            dv[i0] = args->a + r * cos(theta);
+                            dv[i1] = args->a + r * sin(theta);
+                        }
+                    }
+                }
+            }
+            break;
+        case rng_truncated_normal:
+            for (uint64_t k = 0; k < count; k++) {
+                double p = args->cdf_lo + uniform_f64(args, w0, w1, k, 0.5) * (args->cdf_hi - args->cdf_lo);
+                double z = normal_quantile((p > 0.0) ? ((p < 1.0) ? p : 1.0 - 0x1.0p-53) : 0x1.0p-1074, !args->narrow);
+                z = (z < args->z_lo) ? args->z_lo : ((z > args->z_hi) ? args->z_hi : z);
+                double v = args->a + args->b * (args->flip ? -z : z);
+                if (args->narrow) {
+                    fv[k] = (float)v;
+                } else {
+                    dv[k] = v;
+                }
+            }
+            break;
+        case rng_bernoulli:
+            for (uint64_t k = 0; k < count; k++) {
+                if (args->narrow) {
+                    fv[k] = (w0[k] < args->threshold) ? 1.0f : 0.0f;
+                } else {
+                    dv[k] = (w0[k] < args->threshold) ? 1.0 : 0.0;
+                }
+            }
+            break;
+    }
+}
+
+
+static inline double saturate(double v, double lo, double hi) {
+    v = nearbyint(v);
+    return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+
+static void store(const struct rng_args* args, uint64_t index, uint64_t count, const float* fv, const double* dv) {
+    switch (args->type) {
+        case sc_float32:
+            memcpy((float*)args->out + index, fv, count * sizeof(float));
+            break;
+        case sc_float16:
+            for (uint64_t k = 0; k < count; k++) ((uint16_t*)args->out)[index + k] = sc_f32_to_bf16_bits(fv[k]);
+            break;
+        case sc_half:
+            for (uint64_t k = 0; k < count; k++) ((uint16_t*)args->out)[index + k] = sc_f32_to_half_bits(fv[k]);
+            break;
+        case sc_float64:
+            memcpy((double*)args->out + index, dv, count * sizeof(double));
+            break;
+        case sc_int32:
+            for (uint64_t k = 0; k < count; k++) ((int32_t*)args->out)[index + k] = (int32_t)saturate(dv[k], (double)INT32_MIN, (double)INT32_MAX);
+            break;
+        case sc_int64:
+            // 2^63 is the first double above INT64_MAX
+            for (uint64_t k = 0; k < count; k++) {
+                double v = saturate(dv[k], -0x1.0p63, 0x1.0p63);
+                ((int64_t*)args->out)[index + k] = (v >= 0x1.0p63) ? INT64_MAX : (int64_t)v;
+            }
+            break;
+        case sc_uint8:
+            for (uint64_t k = 0; k < count; k++) ((uint8_t*)args->out)[index + k] = (uint8_t)saturate(dv[k], 0.0, 255.0);
+            break;
+        default:
+            break;
+    }
+}
+
+
+static int rng_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct rng_args* args = (struct rng_args*)raw;
+    uint32_t w0[RNG_BLOCK];
+    uint32_t w1[RNG_BLOCK];
+    float fv[RNG_BLOCK];
+    double dv[RNG_BLOCK];
+    uint64_t first = start * RNG_CHUNK;
+    uint64_t last = (end * RNG_CHUNK < args->size) ? end * RNG_CHUNK : args->size;
+
+    for (uint64_t index = first; index < last; index += RNG_BLOCK) {
+        uint64_t count = (last - index < RNG_BLOCK) ? last - index : RNG_BLOCK;
+        uint64_t groups = (count + 31) / 32;
+        uint64_t block = args->counter + index / 32 * 8;
+        if (sc_has_avx2_fma()) {
+            philox_words_avx2(args->key, block, groups, 0, w0);
+            if (args->wide) {
+                philox_words_avx2(args->key, block, groups, 1, w1);
+            }
+        } else {
+            philox_words(args->key, block, groups, 0, w0);
+            if (args->wide) {
+                philox_words(args->key, block, groups, 1, w1);
+            }
+        }
+        transform(args, w0, w1, groups * 32, fv, dv);
+        store(args, index, count, fv, dv);
+    }
+    return 0;
+}
+
+
+static int fill(sc_rng* rng, sc_vector* out, struct rng_args* args, ccb_arena* arena) {
+    CCB_NOTNULL(rng, "rng is NULL");
+    CCB_NOTNULL(out, "out is NULL");
+    if (out->type != sc_float16 && out->type != sc_float32 && out->type != sc_float64 && out->type != sc_half &&
+        out->type != sc_int32 && out->type != sc_int64 && out->type != sc_uint8) {
+        CCB_ERROR("Unsupported type %d for a random fill", out->type);
+        return -1;
+    }
+    args->type = out->type;
+    args->size = out->size;
+    args->out = out->data;
+    args->key[0] = (uint32_t)rng->seed;
+    args->key[1] = (uint32_t)(rng->seed >> 32);
+    args->counter = rng->counter;
+    args->narrow = out->type == sc_float32 || out->type == sc_float16 || out->type == sc_half;
+    args->wide = (out->type == sc_float64 || out->type == sc_int32 || out->type == sc_int64) && args->kind != rng_bernoulli;
+
+    uint64_t chunks = (out->size + RNG_CHUNK - 1) / RNG_CHUNK;
+    if (chunks > 0 && sc_run_range_task(rng_kernel, args, chunks, out->size, arena) != 0) {
+        CCB_ERROR("Failed to run random fill");
+        return -1;
+    }
+    rng->counter += (out->size + 31) / 32 * 8;
+    return 0;
+}
+
+
+int sc_rng_uniform(sc_rng* rng, sc_vector* out, double lo, double hi, ccb_arena* arena) {
+    if (!(lo <= hi)) {
+        CCB_ERROR("Invalid uniform range [%g, %g)", lo, hi);
+        return -1;
+    }
+    struct rng_args args = {0};
+    args.kind = rng_uniform;
+    args.a = lo;
+    args.b = hi;
+    return fill(rng, out, &args, arena);
+}
+
+
+int sc_rng_normal(sc_rng* rng, sc_vector* out, double mean, double std, ccb_arena* arena) {
+    if (!(std >= 0.0)) {
+        CCB_ERROR("Invalid standard deviation %g", std);
+        return -1;
+    }
+    struct rng_args args = {0};
+    args.kind = rng_normal;
+    args.a = mean;
+    args.b = std;
+    return fill(rng, out, &args, arena);
+}
+
+
+int sc_rng_truncated_normal(sc_rng* rng, sc_vector* out, double mean, double std, double lo, double hi, ccb_arena* arena) {
+    if (!(std > 0.0) || !(lo < hi)) {
+        CCB_ERROR("Invalid truncated normal (std %g, range [%g, %g])", std, lo, hi);
+        return -1;
+    }
+    struct rng_args args = {0};
+    args.kind = rng_truncated_normal;
+    args.a = mean;
+    args.b = std;
+    args.z_lo = (lo - mean) / std;
+    args.z_hi = (hi - mean) / std;
+    // the lower tail keeps the precision of the cdf, an interval above the mean is mirrored
+    if (args.z_lo > 0.0) {
+        double z = args.z_lo;
+        args.z_lo = -args.z_hi;
+        args.z_hi = -z;
+        args.flip = 1;
+    }
+    args.cdf_lo = 0.5 * erfc(-args.z_lo / sqrt(2.0));
+    args.cdf_hi = 0.5 * erfc(-args.z_hi / sqrt(2.0));
+    return fill(rng, out, &args, arena);
+}
+
+
+int sc_rng_bernoulli(sc_rng* rng, sc_vector* out, double p, ccb_arena* arena) {
+    if (!(p >= 0.0 && p <= 1.0)) {
+        CCB_ERROR("Invalid probability %g", p);
+        return -1;
+    }
+    struct rng_args args = {0};
+    args.kind = rng_bernoulli;
+    args.threshold = (uint64_t)(p * 4294967296.0);
+    return fill(rng, out, &args, arena);
+}
+
+
+static sc_vector* tensor_view(sc_tensor* tensor, sc_vector* view) {
+    if (tensor == NULL) {
+        return NULL;
+    }
+    view->data = tensor->data;
+    view->size = tensor->size;
+    view->type = tensor->type;
+    return view;
+}
+
+
+int sc_rng_uniform_tensor(sc_rng* rng, sc_tensor* out, double lo, double hi, ccb_arena* arena) {
+    sc_vector view;
+    return sc_rng_uniform(rng, tensor_view(out, &view), lo, hi, arena);
+}
+
+
+int sc_rng_normal_tensor(sc_rng* rng, sc_tensor* out, double mean, double std, ccb_arena* arena) {
+    sc_vector view;
+    return sc_rng_normal(rng, tensor_view(out, &view), mean, std, arena);
+}
+
+
+int sc_rng_truncated_normal_tensor(sc_rng* rng, sc_tensor* out, double mean, double std, double lo, double hi, ccb_arena* arena) {
+    sc_vector view;
+    return sc_rng_truncated_normal(rng, tensor_view(out, &view), mean, std, lo, hi, arena);
+}
+
+
+int sc_rng_bernoulli_tensor(sc_rng* rng, sc_tensor* out, double p, ccb_arena* arena) {
+    sc_vector view;
+    return sc_rng_bernoulli(rng, tensor_view(out, &view), p, arena);
+}
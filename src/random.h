@@ -0,0 +1,54 @@
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    counter based random fills (Philox4x32-10): the value of an element only depends on the seed, the counter
+    of the generator and the element index, so a fill is the same for any thread count or chunking
+    one Philox block gives 4 words, element 32 g + 8 j + l takes the word j of the block 8 g + l so that the
+    AVX2 kernel computes 8 blocks at once (one per lane) and stores them without shuffles
+    float64, int32 and int64 fills draw two words per element (53 bit uniforms), the other types one
+    every fill advances the counter of the generator past the blocks it used
+    the float32 transforms have an AVX2 kernel (vectorised log / sincos for the normals), its values can differ
+    from the portable path in the last bit
+*/
+
+typedef struct {
+    uint64_t seed;
+    uint64_t counter;       // next Philox block
+} sc_rng;
+
+
+/* Creates a generator at counter 0 */
+sc_rng sc_rng_create(uint64_t seed);
+/* One Philox4x32-10 block
+   - const uint32_t counter[4]: 128 bit counter
+   - const uint32_t key[2]: 64 bit key
+   - uint32_t out[4]: the 4 random words
+*/
+void sc_philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]);
+
+/* Fills a vector with uniform values in [lo, hi)
+   - sc_vector* out: vector of any type, integer types get floor(value)
+   - ccb_arena* arena: arena where the tasks will be allocated
+   - return: 0 on success
+*/
+int sc_rng_uniform(sc_rng* rng, sc_vector* out, double lo, double hi, ccb_arena* arena);
+/* Fills a vector with normal values (Box-Muller), integer types are rounded to nearest and saturated */
+int sc_rng_normal(sc_rng* rng, sc_vector* out, double mean, double std, ccb_arena* arena);
+/* Fills a vector with normal values restricted to [lo, hi] (inverse transform, no rejection) */
+int sc_rng_truncated_normal(sc_rng* rng, sc_vector* out, double mean, double std, double lo, double hi, ccb_arena* arena);
+/* Fills a vector with 1 (probability p) or 0 */
+int sc_rng_bernoulli(sc_rng* rng, sc_vector* out, double p, ccb_arena* arena);
+
+// same fills on all the elements of a tensor
+int sc_rng_uniform_tensor(sc_rng* rng, sc_tensor* out, double lo, double hi, ccb_arena* arena);
+int sc_rng_normal_tensor(sc_rng* rng, sc_tensor* out, double mean, double std, ccb_arena* arena);
+int sc_rng_truncated_normal_tensor(sc_rng* rng, sc_tensor* out, double mean, double std, double lo, double hi, ccb_arena* arena);
+int sc_rng_bernoulli_tensor(sc_rng* rng, sc_tensor* out, double p, ccb_arena* arena);
+
+
+#endif // __RANDOM_H__
@@ -0,0 +1,980 @@
+#include "data.h"
+#include "regression.h"
+#include "sc_engine.h"
+#include "sc_gemm.h"
+#include "factor.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+
+// rows of Z converted to float64 per work unit (k of the SYRK gemm)
+#define LINREG_BLOCK_ROWS 256
+// rows of the Gram strip computed by one gemm call
+#define LINREG_STRIP 96
+// pivots (Cholesky) and diagonal of R (QR) below this fraction of the equilibrated diagonal are dependent
+#define LINREG_PIVOT_TOL 1e-10
+// rows of a logistic regression work unit
+#define LOGREG_BLOCK_ROWS 64
+// per thread gradient buffers are padded to a cache line (in doubles) to avoid false sharing
+#define LOGREG_LINE 8
+// backtracking steps of the L-BFGS line search and its sufficient decrease constant
+#define LOGREG_LINE_SEARCH_STEPS 30
+#define LOGREG_ARMIJO 1e-4
+
+
+struct linreg_args {
+    const sc_tensor* x;
+    const sc_vector* y;
+    uint64_t rows;
+    uint64_t features;
+    uint64_t dim;
+
+    // per thread Gram (dim x dim), block of Z and gemm scratch
+    double* grams;
+    double* blocks;
+    uint8_t* scratch;
+};
+
+
+static int linreg_range_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct linreg_args* args = (struct linreg_args*)raw;
+    uint64_t dim = args->dim;
+    uint64_t features = args->features;
+    uint64_t x_size = sc_type_size(args->x->type);
+    uint64_t y_size = sc_type_size(args->y->type);
+    double* gram = args->grams + thread_id * dim * dim;
+    double* z = args->blocks + thread_id * LINREG_BLOCK_ROWS * dim;
+    void* scratch = args->scratch + thread_id * sc_gemm_scratch_size();
+
+    for (uint64_t block = start; block < end; block++) {
+        uint64_t r0 = block * LINREG_BLOCK_ROWS;
+        uint64_t rb = (args->rows - r0 < LINREG_BLOCK_ROWS) ? args->rows - r0 : LINREG_BLOCK_ROWS;
+
+        // Z = [X | 1 | y] in float64
+        for (uint64_t r = 0; r < rb; r++) {
+            double* row = z + r * dim;
+            sc_convert_buffer((const uint8_t*)args->x->data + (r0 + r) * features * x_size, args->x->type, row, sc_float64, features);
+            row[features] = 1.0;
+            sc_convert_buffer((const uint8_t*)args->y->data + (r0 + r) * y_size, args->y->type, row + features + 1, sc_float64, 1);
+        }
+
+        // upper strips of Z^T.Z, the diagonal blocks are computed whole
+        for (uint64_t i0 = 0; i0 < dim; i0 += LINREG_STRIP) {
+            sc_gemm_desc desc;
+            desc.m = (dim - i0 < LINREG_STRIP) ? dim - i0 : LINREG_STRIP;
+            desc.n = dim - i0;
+            desc.k = rb;
+            desc.a = z + i0;
+            desc.a_type = sc_float64;
+            desc.a_row_stride = 1;
+            desc.a_col_stride = (int64_t)dim;
+            desc.b = z + i0;
+            desc.b_type = sc_float64;
+            desc.b_row_stride = (int64_t)dim;
+            desc.b_col_stride = 1;
+            desc.c = gram + i0 * dim + i0;
+            desc.c_type = sc_float64;
+            desc.c_row_stride = (int64_t)dim;
+            desc.c_col_stride = 1;
+            desc.alpha = 1.0;
+            desc.beta = 1.0;
+            if (sc_gemm_serial(&desc, scratch) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+
+sc_linreg_state* sc_linreg_create(uint64_t features, int fit_intercept, ccb_arena* arena) {
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (features == 0) {
+        CCB_ERROR("A linear regression needs at least one feature");
+        return NULL;
+    }
+
+    sc_linreg_state* state = (sc_linreg_state*)ccb_arena_malloc(arena, sizeof(sc_linreg_state));
+    CCB_NOTNULL(state, "Failed to allocate linear regression state");
+    state->features = features;
+    state->fit_intercept = fit_intercept != 0;
+    state->rows = 0;
+    state->dim = features + 2;
+    state->gram = (double*)ccb_arena_malloc(arena, state->dim * state->dim * sizeof(double));
+    CCB_NOTNULL(state->gram, "Failed to allocate linear regression Gram matrix");
+    memset(state->gram, 0, state->dim * state->dim * sizeof(double));
+    return state;
+}
+
+
+int sc_linreg_accumulate(sc_linreg_state* state, sc_tensor* x, sc_vector* y, ccb_arena* arena) {
+    CCB_NOTNULL(state, "state is NULL");
+    CCB_NOTNULL(x, "x is NULL");
+    CCB_NOTNULL(y, "y is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (x->dims->dims_count != 2 || x->dims->dims[1] != state->features) {
+        CCB_ERROR("x must be a [rows, %" PRIu64 "] tensor", state->features);
+        return -1;
+    }
+    uint64_t rows = x->dims->dims[0];
+    if (y->size != rows) {
+        CCB_ERROR("y has %" PRIu64 " values for %" PRIu64 " rows", y->size, rows);
+        return -1;
+    }
+    if (rows == 0) {
+        return 0;
+    }
+
+    uint64_t dim = state->dim;
+    uint64_t threads = sc_get_engine_thread_count();
+    uint64_t blocks = (rows + LINREG_BLOCK_ROWS - 1) / LINREG_BLOCK_ROWS;
+
+    struct linreg_args args;
+    args.x = x;
+    args.y = y;
+    args.rows = rows;
+    args.features = state->features;
+    args.dim = dim;
+    args.grams = (double*)ccb_arena_malloc(arena, threads * dim * dim * sizeof(double));
+    CCB_NOTNULL(args.grams, "Failed to allocate linear regression partial Gram matrices");
+    args.blocks = (double*)ccb_arena_malloc(arena, threads * LINREG_BLOCK_ROWS * dim * sizeof(double));
+    CCB_NOTNULL(args.blocks, "Failed to allocate linear regression row blocks");
+    args.scratch = (uint8_t*)ccb_arena_malloc(arena, threads * sc_gemm_scratch_size());
+    CCB_NOTNULL(args.scratch, "Failed to allocate gemm scratch");
+    memset(args.grams, 0, threads * dim * dim * sizeof(double));
+
+    if (sc_run_range_task(linreg_range_kernel, &args, blocks, rows * dim * dim / 2, arena) != 0) {
+        CCB_ERROR("Failed to run linear regression accumulation task");
+        return -1;
+    }
+
+    for (uint64_t t = 0; t < threads; t++) {
+        const double* partial = args.grams + t * dim * dim;
+        for (uint64_t i = 0; i < dim; i++) {
+            for (uint64_t j = i; j < dim; j++) {
+                state->gram[i * dim + j] += partial[i * dim + j];
+            }
+        }
+    }
+    state->rows += rows;
+    return 0;
+}
+
+
+/*
+    Householder QR with column pivoting of the n x n matrix a (row major, overwritten), b gets Q^T.b
+    the basic solution of R11 . u = (Q^T.b)[0:rank] is written in x (0 for the dependent columns)
+    return: the numerical rank
+*/
+static uint64_t pivoted_qr_solve(double* a, uint64_t n, double* b, double* x, ccb_arena* arena) {
+    double* norms = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    uint64_t* perm = (uint64_t*)ccb_arena_malloc(arena, n * sizeof(uint64_t));
+    double* v = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    if (norms == NULL || perm == NULL || v == NULL) {
+        CCB_ERROR("Failed to allocate QR scratch");
+        return 0;
+    }
+
+    for (uint64_t j = 0; j < n; j++) {
+        perm[j] = j;
+        norms[j] = 0.0;
+        for (uint64_t i = 0; i < n; i++) {
+            norms[j] += a[i * n + j] * a[i * n + j];
+        }
+    }
+
+    uint64_t rank = 0;
+    double r00 = 0.0;
+    for (uint64_t k = 0; k < n; k++) {
+        // the column of largest remaining norm, recomputed since the downdates lose precision
+        uint64_t p = k;
+        for (uint64_t j = k; j < n; j++) {
+            norms[j] = 0.0;
+            for (uint64_t i = k; i < n; i++) {
+                norms[j] += a[i * n + j] * a[i * n + j];
+            }
+            if (norms[j] > norms[p]) {
+                p = j;
+            }
+        }
+        if (p != k) {
+            for (uint64_t i = 0; i < n; i++) {
+                double t = a[i * n + k];
+                a[i * n + k] = a[i * n + p];
+                a[i * n + p] = t;
+            }
+            uint64_t t = perm[k];
+            perm[k] = perm[p];
+            perm[p] = t;
+            double tn = norms[k];
+            norms[k] = norms[p];
+            norms[p] = tn;
+        }
+
+        double norm = sqrt(norms[k]);
+        if (k == 0) {
+            r00 = norm;
+        }
+        if (norm <= LINREG_PIVOT_TOL * r00 || norm == 0.0) {
+            break;
+        }
+
+        // reflector v = x - alpha * e1 with alpha = -sign(x0) * |x|
+        double alpha = (a[k * n + k] > 0.0) ? -norm : norm;
+        double vv = 0.0;
+        for (uint64_t i = k; i < n; i++) {
+            v[i] = a[i * n + k];
+        }
+        v[k] -= alpha;
+        for (uint64_t i = k; i < n; i++) {
+            vv += v[i] * v[i];
+        }
+        if (vv > 0.0) {
+            for (uint64_t j = k + 1; j < n; j++) {
+                double dot = 0.0;
+                for (uint64_t i = k; i < n; i++) {
+                    dot += v[i] * a[i * n + j];
+                }
+                double s = 2.0 * dot / vv;
+                for (uint64_t i = k; i < n; i++) {
+                    a[i * n + j] -= s * v[i];
+                }
+            }
+            double dot = 0.0;
+            for (uint64_t i = k; i < n; i++) {
+                dot += v[i] * b[i];
+            }
+            double s = 2.0 * dot / vv;
+            for (uint64_t i = k; i < n; i++) {
+                b[i] -= s * v[i];
+            }
+        }
+        a[k * n + k] = alpha;
+        rank++;
+    }
+
+    for (uint64_t j = 0; j < n; j++) {
+        x[j] = 0.0;
+    }
+    for (uint64_t i = rank; i-- > 0;) {
+        double sum = b[i];
+        for (uint64_t j = i + 1; j < rank; j++) {
+            sum -= a[i * n + j] * v[j];
+        }
+        v[i] = sum / a[i * n + i];
+    }
+    for (uint64_t i = 0; i < rank; i++) {
+        x[perm[i]] = v[i];
+    }
+    return rank;
+}
+
+
+sc_linreg_model* sc_linreg_solve(sc_linreg_state* state, double ridge, ccb_arena* arena) {
+    CCB_NOTNULL(state, "state is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (ridge < 0.0 || isnan(ridge)) {
+        CCB_ERROR("ridge must be positive, got %g", ridge);
+        return NULL;
+    }
+    if (state->rows == 0) {
+        CCB_ERROR("No rows were accumulated");
+        return NULL;
+    }
+
+    uint64_t features = state->features;
+    uint64_t dim = state->dim;
+    uint64_t n = features + (uint64_t)state->fit_intercept;
+    const double* g = state->gram;
+
+    double* a = (double*)ccb_arena_malloc(arena, n * n * sizeof(double));
+    double* work = (double*)ccb_arena_malloc(arena, n * n * sizeof(double));
+    double* rhs = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    double* scale = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    double* beta = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    if (a == NULL || work == NULL || rhs == NULL || scale == NULL || beta == NULL) {
+        CCB_ERROR("Failed to allocate linear regression system");
+        return NULL;
+    }
+
+    // system over the features and the ones column, Z^T.Z is symmetric so only its upper triangle is read
+    for (uint64_t i = 0; i < n; i++) {
+        for (uint64_t j = i; j < n; j++) {
+            a[i * n + j] = g[i * dim + j];
+            a[j * n + i] = g[i * dim + j];
+        }
+        rhs[i] = g[i * dim + features + 1];
+    }
+    for (uint64_t i = 0; i < features; i++) {
+        a[i * n + i] += ridge;
+    }
+
+    // equilibrate to a unit diagonal so that the tolerances do not depend on the scale of the features
+    for (uint64_t i = 0; i < n; i++) {
+        scale[i] = (a[i * n + i] > 0.0) ? 1.0 / sqrt(a[i * n + i]) : 0.0;
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        for (uint64_t j = 0; j < n; j++) {
+            work[i * n + j] = a[i * n + j] * scale[i] * scale[j];
+        }
+        beta[i] = rhs[i] * scale[i];
+    }
+
+    sc_linreg_model* model = (sc_linreg_model*)ccb_arena_malloc(arena, sizeof(sc_linreg_model));
+    CCB_NOTNULL(model, "Failed to allocate linear regression model");
+    model->rows = state->rows;
+
+    // views of work and beta for the dense solvers
+    uint64_t square[2] = {n, n};
+    sc_dimensions work_dims = {2, square};
+    sc_dimensions beta_dims = {1, square};
+    sc_tensor work_view = {work, &work_dims, n * n, sc_float64};
+    sc_tensor beta_view = {beta, &beta_dims, n, sc_float64};
+
+    int status = sc_cholesky_inplace(&work_view, LINREG_PIVOT_TOL, arena);
+    if (status < 0) {
+        CCB_ERROR("Failed to factor the normal equations");
+        return NULL;
+    }
+    if (status == 0) {
+        if (sc_cholesky_solve(&work_view, &beta_view, arena) != 0) {
+            return NULL;
+        }
+        model->solver = sc_linreg_cholesky;
+        model->rank = n;
+    } else {
+        double* x = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+        CCB_NOTNULL(x, "Failed to allocate linear regression solution");
+        for (uint64_t i = 0; i < n; i++) {
+            for (uint64_t j = 0; j < n; j++) {
+                work[i * n + j] = a[i * n + j] * scale[i] * scale[j];
+            }
+            beta[i] = rhs[i] * scale[i];
+        }
+        model->rank = pivoted_qr_solve(work, n, beta, x, arena);
+        memcpy(beta, x, n * sizeof(double));
+        model->solver = sc_linreg_qr;
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        beta[i] *= scale[i];
+    }
+
+    model->weights = sc_create_vector(features, sc_float64, arena);
+    CCB_NOTNULL(model->weights, "Failed to allocate linear regression weights");
+    memcpy(model->weights->data, beta, features * sizeof(double));
+    model->intercept = state->fit_intercept ? beta[features] : 0.0;
+
+    // |y - Z.beta|^2 = y^T.y - 2 beta^T.Z^T.y + beta^T.Z^T.Z.beta, without the ridge
+    double residual = g[(features + 1) * dim + features + 1];
+    for (uint64_t i = 0; i < n; i++) {
+        double row = 0.0;
+        for (uint64_t j = 0; j < n; j++) {
+            row += ((i <= j) ? g[i * dim + j] : g[j * dim + i]) * beta[j];
+        }
+        residual += beta[i] * (row - 2.0 * rhs[i]);
+    }
+    model->residual = (residual > 0.0) ? residual : 0.0;
+    return model;
+}
+
+
+sc_linreg_model* sc_linreg_fit(sc_tensor* x, sc_vector* y, double ridge, int fit_intercept, ccb_arena* arena) {
+    CCB_NOTNULL(x, "x is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (x->dims->dims_count != 2) {
+        CCB_ERROR("x must be a [rows, features] tensor");
+        return NULL;
+    }
+
+    sc_linreg_state* state = sc_linreg_create(x->dims->dims[1], fit_intercept, arena);
+    if (state == NULL) {
+        return NULL;
+    }
+    if (sc_linreg_accumulate(state, x, y, arena) != 0) {
+        return NULL;
+    }
+    return sc_linreg_solve(state, ridge, arena);
+}
+
+
+sc_vector* sc_linreg_predict(sc_linreg_model* model, sc_tensor* x, sc_TYPES type, ccb_arena* arena) {
+    CCB_NOTNULL(model, "model is NULL");
+    CCB_NOTNULL(x, "x is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    uint64_t features = model->weights->size;
+    if (x->dims->dims_count != 2 || x->dims->dims[1] != features) {
+        CCB_ERROR("x must be a [rows, %" PRIu64 "] tensor", features);
+        return NULL;
+    }
+
+    uint64_t rows = x->dims->dims[0];
+    sc_vector* out = sc_create_vector(rows, type, arena);
+    CCB_NOTNULL(out, "Failed to allocate predictions");
+    double* acc = (double*)ccb_arena_malloc(arena, (rows + 1) * sizeof(double));
+    CCB_NOTNULL(acc, "Failed to allocate predictions accumulator");
+    for (uint64_t i = 0; i < rows; i++) {
+        acc[i] = model->intercept;
+    }
+
+    sc_gemm_desc desc = sc_gemm_row_major(rows, 1, features, x->data, x->type, 0,
+                                          model->weights->data, sc_float64, 0,
+                                          acc, sc_float64, 1.0, 1.0);
+    if (sc_gemm(&desc, arena) != 0) {
+        CCB_ERROR("Failed to compute predictions");
+        return NULL;
+    }
+    if (sc_convert_buffer(acc, sc_float64, out->data, type, rows) != 0) {
+        CCB_ERROR("Failed to convert predictions");
+        return NULL;
+    }
+    return out;
+}
+
+
+// ###################
+// Logistic regression
+// ###################
+
+struct logreg_args {
+    const sc_tensor* x;
+    const sc_vector* y;
+    uint64_t r0;
+    uint64_t rows;
+    uint64_t features;
+    const double* theta;    // weights then intercept
+    int use_fma;
+
+    // per thread: gradient (features), intercept gradient and loss, then a converted row and the block labels
+    double* grads;
+    uint64_t grad_stride;
+    double* buffers;
+    uint64_t buffer_stride;
+};
+
+
+struct logreg_work {
+    uint64_t threads;
+    double* grads;
+    uint64_t grad_stride;
+    double* buffers;
+    uint64_t buffer_stride;
+    ccb_arena* steps;       // tasks of one gradient evaluation, reset after it
+};
+
+
+SC_TARGET_AVX2 static double dot_fma(const double* a, const double* b, uint64_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    uint64_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+    }
+    double sum = sc_hsum_f64x4(_mm256_add_pd(acc0, acc1));
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+SC_TARGET_AVX2 static void axpy_fma(double alpha, const double* x, double* y, uint64_t n) {
+    __m256d scale = _mm256_set1_pd(alpha);
+    uint64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(y + i, _mm256_fmadd_pd(scale, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    for (; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+static double dot_f64(const double* a, const double* b, uint64_t n) {
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+    uint64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc[0] += a[i] * b[i];
+        acc[1] += a[i + 1] * b[i + 1];
+        acc[2] += a[i + 2] * b[i + 2];
+        acc[3] += a[i + 3] * b[i + 3];
+    }
+    double sum = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+static void axpy_f64(double alpha, const double* x, double* y, uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+
+static double sigmoid(double z) {
+    if (z >= 0.0) {
+        return 1.0 / (1.0 + exp(-z));
+    }
+    double e = exp(z);
+    return e / (1.0 + e);
+}
+
+// log(1 + exp(z)) without overflow
+static double softplus(double z) {
+    return (z > 0.0) ? z + log1p(exp(-z)) : log1p(exp(z));
+}
+
+
+// z = w.x + b -> p = sigmoid(z) -> r = p - y -> g += r * x, one pass per row
+static int logreg_range_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct logreg_args* args = (struct logreg_args*)raw;
+    uint64_t features = args->features;
+    uint64_t x_size = sc_type_size(args->x->type);
+    uint64_t y_size = sc_type_size(args->y->type);
+    double* grad = args->grads + thread_id * args->grad_stride;
+    double* row = args->buffers + thread_id * args->buffer_stride;
+    double* labels = row + features;
+    const double* w = args->theta;
+    double b = args->theta[features];
+
+    for (uint64_t block = start; block < end; block++) {
+        uint64_t r0 = args->r0 + block * LOGREG_BLOCK_ROWS;
+        uint64_t rb = (args->r0 + args->rows - r0 < LOGREG_BLOCK_ROWS) ? args->r0 + args->rows - r0 : LOGREG_BLOCK_ROWS;
+        sc_convert_buffer((const uint8_t*)args->y->data + r0 * y_size, args->y->type, labels, sc_float64, rb);
+
+        for (uint64_t r = 0; r < rb; r++) {
+            const double* x;
+            if (args->x->type == sc_float64) {
+                x = (const double*)args->x->data + (r0 + r) * features;
+            } else {
+                sc_convert_buffer((const uint8_t*)args->x->data + (r0 + r) * features * x_size, args->x->type, row, sc_float64, features);
+                x = row;
+            }
+
+            double z = (args->use_fma ? dot_fma(w, x, features) : dot_f64(w, x, features)) + b;
+            double residual = sigmoid(z) - labels[r];
+            if (args->use_fma) {
+                axpy_fma(residual, x, grad, features);
+            } else {
+                axpy_f64(residual, x, grad, features);
+            }
+            grad[features] += residual;
+            grad[features + 1] += softplus(z) - labels[r] * z;
+        }
+    }
+    return 0;
+}
+
+
+static int check_chunk(sc_tensor* x, sc_vector* y, uint64_t features) {
+    if (x == NULL || y == NULL) {
+        CCB_ERROR("Chunk without rows or labels");
+        return -1;
+    }
+    if (x->dims->dims_count != 2 || x->dims->dims[1] != features) {
+        CCB_ERROR("Chunk rows must be a [rows, %" PRIu64 "] tensor", features);
+        return -1;
+    }
+    if (y->size != x->dims->dims[0]) {
+        CCB_ERROR("Chunk has %" PRIu64 " labels for %" PRIu64 " rows", y->size, x->dims->dims[0]);
+        return -1;
+    }
+    return 0;
+}
+
+
+/*
+    adds the gradient sums of the rows [r0, r0 + rows) of a chunk to grad (features + 1) and their log loss to loss
+*/
+static int logreg_gradient(sc_tensor* x, sc_vector* y, uint64_t r0, uint64_t rows, const double* theta, uint64_t features,
+                           struct logreg_work* work, double* grad, double* loss) {
+    memset(work->grads, 0, work->threads * work->grad_stride * sizeof(double));
+
+    struct logreg_args args;
+    args.x = x;
+    args.y = y;
+    args.r0 = r0;
+    args.rows = rows;
+    args.features = features;
+    args.theta = theta;
+    args.use_fma = sc_has_avx2_fma();
+    args.grads = work->grads;
+    args.grad_stride = work->grad_stride;
+    args.buffers = work->buffers;
+    args.buffer_stride = work->buffer_stride;
+
+    uint64_t blocks = (rows + LOGREG_BLOCK_ROWS - 1) / LOGREG_BLOCK_ROWS;
+    int status = sc_run_range_task(logreg_range_kernel, &args, blocks, rows * features, work->steps);
+    ccb_arena_reset(work->steps);
+    if (status != 0) {
+        CCB_ERROR("Failed to run logistic regression gradient task");
+        return -1;
+    }
+
+    for (uint64_t t = 0; t < work->threads; t++) {
+        const double* partial = work->grads + t * work->grad_stride;
+        for (uint64_t j = 0; j <= features; j++) {
+            grad[j] += partial[j];
+        }
+        *loss += partial[features + 1];
+    }
+    return 0;
+}
+
+
+/*
+    mean loss and gradient over all the chunks of the source, with the l2 penalty
+    return: the number of rows, 0 on failure
+*/
+static uint64_t logreg_evaluate(const sc_logreg_source* source, uint64_t features, const sc_logreg_options* options,
+                                const double* theta, struct logreg_work* work, double* grad, double* loss) {
+    uint64_t n = features + 1;
+    uint64_t total = 0;
+    memset(grad, 0, n * sizeof(double));
+    *loss = 0.0;
+
+    sc_tensor* x = NULL;
+    sc_vector* y = NULL;
+    for (uint64_t index = 0; source->chunk(source->context, index, &x, &y); index++) {
+        if (check_chunk(x, y, features) != 0) {
+            return 0;
+        }
+        uint64_t rows = x->dims->dims[0];
+        if (rows > 0 && logreg_gradient(x, y, 0, rows, theta, features, work, grad, loss) != 0) {
+            return 0;
+        }
+        total += rows;
+    }
+    if (total == 0) {
+        CCB_ERROR("The source has no rows");
+        return 0;
+    }
+
+    double penalty = 0.0;
+    for (uint64_t j = 0; j < n; j++) {
+        grad[j] /= (double)total;
+    }
+    for (uint64_t j = 0; j < features; j++) {
+        grad[j] += options->l2 * theta[j];
+        penalty += theta[j] * theta[j];
+    }
+    if (!options->fit_intercept) {
+        grad[features] = 0.0;
+    }
+    *loss = *loss / (double)total + 0.5 * options->l2 * penalty;
+    return total;
+}
+
+
+static int logreg_sgd(const sc_logreg_source* source, uint64_t features, const sc_logreg_options* options,
+                      double* theta, struct logreg_work* work, sc_logreg_model* model, ccb_arena* arena) {
+    uint64_t n = features + 1;
+    double* grad = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    CCB_NOTNULL(grad, "Failed to allocate gradient");
+
+    double previous = INFINITY;
+    model->iterations = 0;
+    for (uint64_t epoch = 0; epoch < options->iterations; epoch++) {
+        double epoch_loss = 0.0;
+        uint64_t total = 0;
+
+        sc_tensor* x = NULL;
+        sc_vector* y = NULL;
+        for (uint64_t index = 0; source->chunk(source->context, index, &x, &y); index++) {
+            if (check_chunk(x, y, features) != 0) {
+                return -1;
+            }
+            uint64_t rows = x->dims->dims[0];
+            for (uint64_t r0 = 0; r0 < rows; r0 += options->batch_size) {
+                uint64_t batch = (rows - r0 < options->batch_size) ? rows - r0 : options->batch_size;
+                double loss = 0.0;
+                memset(grad, 0, n * sizeof(double));
+                if (logreg_gradient(x, y, r0, batch, theta, features, work, grad, &loss) != 0) {
+                    return -1;
+                }
+
+                double step = options->learning_rate / (double)batch;
+                for (uint64_t j = 0; j < features; j++) {
+                    theta[j] -= step * grad[j] + options->learning_rate * options->l2 * theta[j];
+                }
+                if (options->fit_intercept) {
+                    theta[features] -= step * grad[features];
+                }
+                epoch_loss += loss;
+                total += batch;
+            }
+        }
+        if (total == 0) {
+            CCB_ERROR("The source has no rows");
+            return -1;
+        }
+
+        double penalty = 0.0;
+        for (uint64_t j = 0; j < features; j++) {
+            penalty += theta[j] * theta[j];
+        }
+        model->loss = epoch_loss / (double)total + 0.5 * options->l2 * penalty;
+        model->iterations = epoch + 1;
+        if (fabs(previous - model->loss) < options->tolerance * (1.0 + fabs(model->loss))) {
+            break;
+        }
+        previous = model->loss;
+    }
+    return 0;
+}
+
+
+static int logreg_lbfgs(const sc_logreg_source* source, uint64_t features, const sc_logreg_options* options,
+                        double* theta, struct logreg_work* work, sc_logreg_model* model, ccb_arena* arena) {
+    uint64_t n = features + 1;
+    uint64_t m = (options->history == 0) ? 1 : options->history;
+    double* grad = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    double* next_grad = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    double* next = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    double* direction = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    double* s = (double*)ccb_arena_malloc(arena, m * n * sizeof(double));
+    double* yk = (double*)ccb_arena_malloc(arena, m * n * sizeof(double));
+    double* rho = (double*)ccb_arena_malloc(arena, m * sizeof(double));
+    double* alpha = (double*)ccb_arena_malloc(arena, m * sizeof(double));
+    if (!grad || !next_grad || !next || !direction || !s || !yk || !rho || !alpha) {
+        CCB_ERROR("Failed to allocate L-BFGS state");
+        return -1;
+    }
+
+    double loss;
+    if (logreg_evaluate(source, features, options, theta, work, grad, &loss) == 0) {
+        return -1;
+    }
+
+    uint64_t stored = 0;    // correction pairs, the newest is at (newest % m)
+    uint64_t newest = 0;
+    model->iterations = 0;
+    for (uint64_t iteration = 0; iteration < options->iterations; iteration++) {
+        double largest = 0.0;
+        for (uint64_t j = 0; j < n; j++) {
+            largest = fmax(largest, fabs(grad[j]));
+        }
+        if (largest < options->tolerance) {
+            break;
+        }
+
+        // two loop recursion: direction = -H.grad
+        for (uint64_t j = 0; j < n; j++) {
+            direction[j] = -grad[j];
+        }
+        for (uint64_t c = 0; c < stored; c++) {
+            uint64_t k = (newest + m - c) % m;
+            alpha[k] = rho[k] * dot_f64(s + k * n, direction, n);
+            axpy_f64(-alpha[k], yk + k * n, direction, n);
+        }
+        if (stored > 0) {
+            uint64_t k = newest % m;
+            double gamma = dot_f64(s + k * n, yk + k * n, n) / dot_f64(yk + k * n, yk + k * n, n);
+            for (uint64_t j = 0; j < n; j++) {
+                direction[j] *= gamma;
+            }
+        }
+        for (uint64_t c = stored; c-- > 0;) {
+            uint64_t k = (newest + m - c) % m;
+            double beta = rho[k] * dot_f64(yk + k * n, direction, n);
+            axpy_f64(alpha[k] - beta, s + k * n, direction, n);
+        }
+
+        double slope = dot_f64(grad, direction, n);
+        if (!(slope < 0.0)) {
+            // not a descent direction, restart from the gradient
+            stored = 0;
+            for (uint64_t j = 0; j < n; j++) {
+                direction[j] = -grad[j];
+            }
+            slope = -dot_f64(grad, grad, n);
+        }
+
+        // backtracking line search, the first step is scaled since the direction is the raw gradient
+        double step = (stored == 0) ? fmin(1.0, 1.0 / sqrt(-slope)) : 1.0;
+        double next_loss = loss;
+        int accepted = 0;
+        for (int t = 0; t < LOGREG_LINE_SEARCH_STEPS; t++) {
+            for (uint64_t j = 0; j < n; j++) {
+                next[j] = theta[j] + step * direction[j];
+            }
+            if (logreg_evaluate(source, features, options, next, work, next_grad, &next_loss) == 0) {
+                return -1;
+            }
+            if (next_loss <= loss + LOGREG_ARMIJO * step * slope) {
+                accepted = 1;
+                break;
+            }
+            step *= 0.5;
+        }
+        if (!accepted) {
+            break;
+        }
+
+        // store the correction pair when it keeps H positive definite
+        uint64_t k = (stored == 0) ? newest : (newest + 1) % m;
+        for (uint64_t j = 0; j < n; j++) {
+            s[k * n + j] = next[j] - theta[j];
+            yk[k * n + j] = next_grad[j] - grad[j];
+        }
+        double curvature = dot_f64(s + k * n, yk + k * n, n);
+        if (curvature > 1e-12) {
+            rho[k] = 1.0 / curvature;
+            newest = k;
+            stored = (stored < m) ? stored + 1 : m;
+        } else if (stored == m) {
+            // the slot of the oldest pair was overwritten
+            stored--;
+        }
+
+        memcpy(theta, next, n * sizeof(double));
+        memcpy(grad, next_grad, n * sizeof(double));
+        loss = next_loss;
+        model->iterations = iteration + 1;
+    }
+    model->loss = loss;
+    return 0;
+}
+
+
+sc_logreg_options sc_logreg_default_options(void) {
+    sc_logreg_options options;
+    options.optimizer = sc_logreg_lbfgs;
+    options.iterations = 100;
+    options.batch_size = 256;
+    options.learning_rate = 0.1;
+    options.l2 = 0.0;
+    options.history = 10;
+    options.tolerance = 1e-6;
+    options.fit_intercept = 1;
+    return options;
+}
+
+
+sc_logreg_model* sc_logreg_fit_source(const sc_logreg_source* source, uint64_t features, const sc_logreg_options* options, ccb_arena* arena) {
+    CCB_NOTNULL(source, "source is NULL");
+    CCB_NOTNULL(source->chunk, "source has no chunk function");
+    CCB_NOTNULL(arena, "arena is NULL");
+    sc_logreg_options defaults = sc_logreg_default_options();
+    if (options == NULL) {
+        options = &defaults;
+    }
+    if (features == 0) {
+        CCB_ERROR("A logistic regression needs at least one feature");
+        return NULL;
+    }
+    if (options->optimizer == sc_logreg_sgd && (options->batch_size == 0 || !(options->learning_rate > 0.0))) {
+        CCB_ERROR("SGD needs a batch size and a positive learning rate");
+        return NULL;
+    }
+    if (options->l2 < 0.0 || isnan(options->l2)) {
+        CCB_ERROR("l2 must be positive, got %g", options->l2);
+        return NULL;
+    }
+
+    uint64_t n = features + 1;
+    struct logreg_work work;
+    work.threads = sc_get_engine_thread_count();
+    work.grad_stride = (features + 2 + LOGREG_LINE - 1) / LOGREG_LINE * LOGREG_LINE;
+    work.buffer_stride = features + LOGREG_BLOCK_ROWS;
+    work.grads = (double*)ccb_arena_malloc(arena, work.threads * work.grad_stride * sizeof(double));
+    work.buffers = (double*)ccb_arena_malloc(arena, work.threads * work.buffer_stride * sizeof(double));
+    double* theta = (double*)ccb_arena_malloc(arena, n * sizeof(double));
+    if (!work.grads || !work.buffers || !theta) {
+        CCB_ERROR("Failed to allocate logistic regression scratch");
+        return NULL;
+    }
+    memset(theta, 0, n * sizeof(double));
+
+    sc_logreg_model* model = (sc_logreg_model*)ccb_arena_malloc(arena, sizeof(sc_logreg_model));
+    CCB_NOTNULL(model, "Failed to allocate logistic regression model");
+    model->weights = sc_create_vector(features, sc_float64, arena);
+    CCB_NOTNULL(model->weights, "Failed to allocate logistic regression weights");
+
+    work.steps = ccb_init_arena();
+    CCB_NOTNULL(work.steps, "Failed to create logistic regression step arena");
+    int status = (options->optimizer == sc_logreg_sgd) ? logreg_sgd(source, features, options, theta, &work, model, arena)
+                                                       : logreg_lbfgs(source, features, options, theta, &work, model, arena);
+    ccb_arena_free(work.steps);
+    if (status != 0) {
+        return NULL;
+    }
+
+    memcpy(model->weights->data, theta, features * sizeof(double));
+    model->intercept = theta[features];
+    return model;
+}
+
+
+struct tensor_source {
+    sc_tensor* x;
+    sc_vector* y;
+};
+
+static int tensor_chunk(void* context, uint64_t index, sc_tensor** x, sc_vector** y) {
+    struct tensor_source* source = (struct tensor_source*)context;
+    if (index > 0) {
+        return 0;
+    }
+    *x = source->x;
+    *y = source->y;
+    return 1;
+}
+
+
+sc_logreg_model* sc_logreg_fit(sc_tensor* x, sc_vector* y, const sc_logreg_options* options, ccb_arena* arena) {
+    CCB_NOTNULL(x, "x is NULL");
+    CCB_NOTNULL(y, "y is NULL");
+    if (x->dims->dims_count != 2) {
+        CCB_ERROR("x must be a [rows, features] tensor");
+        return NULL;
+    }
+
+    struct tensor_source context = {x, y};
+    sc_logreg_source source = {tensor_chunk, &context};
+    return sc_logreg_fit_source(&source, x->dims->dims[1], options, arena);
+}
+
+
+sc_vector* sc_logreg_predict(sc_logreg_model* model, sc_tensor* x, sc_TYPES type, ccb_arena* arena) {
+    CCB_NOTNULL(model, "model is NULL");
+    CCB_NOTNULL(x, "x is NULL");
+    CCB_NOTNULL(arena, "arena is NULL");
+    uint64_t features = model->weights->size;
+    if (x->dims->dims_count != 2 || x->dims->dims[1] != features) {
+        CCB_ERROR("x must be a [rows, %" PRIu64 "] tensor", features);
+        return NULL;
+    }
+
+    uint64_t rows = x->dims->dims[0];
+    sc_vector* out = sc_create_vector(rows, type, arena);
+    CCB_NOTNULL(out, "Failed to allocate probabilities");
+    double* acc = (double*)ccb_arena_malloc(arena, (rows + 1) * sizeof(double));
+    CCB_NOTNULL(acc, "Failed to allocate probabilities accumulator");
+    for (uint64_t i = 0; i < rows; i++) {
+        acc[i] = model->intercept;
+    }
+
+    sc_gemm_desc desc = sc_gemm_row_major(rows, 1, features, x->data, x->type, 0,
+                                          model->weights->data, sc_float64, 0,
+                                          acc, sc_float64, 1.0, 1.0);
+    if (sc_gemm(&desc, arena) != 0) {
+        CCB_ERROR("Failed to compute probabilities");
+        return NULL;
+    }
+    for (uint64_t i = 0; i < rows; i++) {
+        acc[i] = sigmoid(acc[i]);
+    }
+    if (sc_convert_buffer(acc, sc_float64, out->data, type, rows) != 0) {
+        CCB_ERROR("Failed to convert probabilities");
+        return NULL;
+    }
+    return out;
+}
@@ -0,0 +1,147 @@
+#ifndef __REGRESSION_H__
+#define __REGRESSION_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    linear regression y = X.w + b fitted in closed form (normal equations)
+    the rows are accumulated in float64 over blocks of rows: every engine thread builds the upper
+    triangle of Z^T.Z for Z = [X | 1 | y] with the blocked gemm (SYRK), so X can be streamed in
+    chunks of any type and never needs to be resident
+    the solve equilibrates X^T.X + ridge * I (the intercept is not penalised) to a unit diagonal and
+    factorises it with a blocked Cholesky, when it is not numerically positive definite (collinear
+    features) a Householder QR with column pivoting gives the basic solution: the weights of the
+    dependent features are 0
+*/
+
+typedef enum {
+    sc_linreg_cholesky,
+    sc_linreg_qr,
+} sc_linreg_solver;
+
+typedef struct {
+    uint64_t features;
+    int fit_intercept;
+    uint64_t rows;
+    uint64_t dim;           // features + 2, columns of Z
+    double* gram;           // dim x dim, upper triangle of Z^T.Z
+} sc_linreg_state;
+
+typedef struct {
+    sc_vector* weights;     // float64, one per feature
+    double intercept;
+    uint64_t rows;
+    uint64_t rank;          // numerical rank of the system
+    sc_linreg_solver solver;
+    double residual;        // sum of the squared residuals on the accumulated rows
+} sc_linreg_model;
+
+
+/* Creates an empty accumulator
+   - uint64_t features: number of columns of X
+   - int fit_intercept: 1 to fit b, 0 for b = 0
+   - ccb_arena* arena: arena where the state will be allocated
+   - return: a pointer to the state
+*/
+sc_linreg_state* sc_linreg_create(uint64_t features, int fit_intercept, ccb_arena* arena);
+/* Adds a chunk of rows to the normal equations, can be called any number of times
+   - sc_tensor* x: rows [rows, features], any type
+   - sc_vector* y: targets, one per row, any type
+   - ccb_arena* arena: arena where the task and the per thread scratch will be allocated
+   - return: 0 on success
+*/
+int sc_linreg_accumulate(sc_linreg_state* state, sc_tensor* x, sc_vector* y, ccb_arena* arena);
+/* Solves the accumulated normal equations
+   - double ridge: L2 penalty on the weights (0 for ordinary least squares)
+   - ccb_arena* arena: arena where the model and the scratch will be allocated
+   - return: a pointer to the model
+*/
+sc_linreg_model* sc_linreg_solve(sc_linreg_state* state, double ridge, ccb_arena* arena);
+/* Accumulates and solves in one call
+   - sc_tensor* x: rows [rows, features], any type
+   - sc_vector* y: targets, one per row
+   - double ridge: L2 penalty on the weights
+   - int fit_intercept: 1 to fit b, 0 for b = 0
+   - ccb_arena* arena: arena where the model and the scratch will be allocated
+   - return: a pointer to the model
+*/
+sc_linreg_model* sc_linreg_fit(sc_tensor* x, sc_vector* y, double ridge, int fit_intercept, ccb_arena* arena);
+/* Predicts X.w + b
+   - sc_tensor* x: rows [rows, features], bfloat16, float32 or float64
+   - sc_TYPES type: type of the result
+   - ccb_arena* arena: arena where the result and the scratch will be allocated
+   - return: a pointer to the predictions, one per row
+*/
+sc_vector* sc_linreg_predict(sc_linreg_model* model, sc_tensor* x, sc_TYPES type, ccb_arena* arena);
+
+
+/*
+    logistic regression P(y = 1 | x) = sigmoid(x.w + b) trained on the mean log loss + l2 / 2 * |w|^2
+    one pass over a mini-batch fuses the dot product, the sigmoid, the residual and the gradient accumulation
+    row by row, every engine thread accumulates in its own gradient buffer and the buffers are summed after
+    the task (no locks or atomics)
+    the rows come from a chunk source so the data can be streamed, L-BFGS makes one pass over all the
+    chunks per evaluation of the loss
+*/
+
+typedef enum {
+    sc_logreg_sgd,          // mini-batch SGD, one step per batch
+    sc_logreg_lbfgs,        // full batch L-BFGS with a backtracking line search
+} sc_logreg_optimizer;
+
+typedef struct {
+    sc_logreg_optimizer optimizer;
+    uint64_t iterations;    // SGD epochs or L-BFGS iterations
+    uint64_t batch_size;    // SGD rows per step
+    double learning_rate;   // SGD step
+    double l2;
+    uint64_t history;       // L-BFGS correction pairs
+    double tolerance;       // stop when the gradient (L-BFGS) or the epoch loss change (SGD) is below it
+    int fit_intercept;
+} sc_logreg_options;
+
+typedef struct {
+    // sets x ([rows, features]) and y (labels in [0, 1]) to the chunk index, returns 0 when there is no such chunk
+    // the chunks are requested from index 0 at every epoch / evaluation
+    int (*chunk)(void* context, uint64_t index, sc_tensor** x, sc_vector** y);
+    void* context;
+} sc_logreg_source;
+
+typedef struct {
+    sc_vector* weights;     // float64, one per feature
+    double intercept;
+    uint64_t iterations;    // SGD epochs or L-BFGS iterations run
+    double loss;            // mean log loss + l2 penalty at the end of the training
+} sc_logreg_model;
+
+
+// L-BFGS, 100 iterations, batches of 256 rows, learning rate 0.1, no l2, 10 corrections, tolerance 1e-6, intercept
+sc_logreg_options sc_logreg_default_options(void);
+/* Trains a logistic regression on in memory data
+   - sc_tensor* x: rows [rows, features], any type
+   - sc_vector* y: labels in [0, 1], one per row, any type
+   - const sc_logreg_options* options: NULL for sc_logreg_default_options()
+   - ccb_arena* arena: arena where the model will be allocated
+   - return: a pointer to the model
+*/
+sc_logreg_model* sc_logreg_fit(sc_tensor* x, sc_vector* y, const sc_logreg_options* options, ccb_arena* arena);
+/* Trains a logistic regression on streamed chunks
+   - const sc_logreg_source* source: chunks of rows and labels
+   - uint64_t features: number of columns of every chunk
+   - const sc_logreg_options* options: NULL for sc_logreg_default_options()
+   - ccb_arena* arena: arena where the model will be allocated
+   - return: a pointer to the model
+*/
+sc_logreg_model* sc_logreg_fit_source(const sc_logreg_source* source, uint64_t features, const sc_logreg_options* options, ccb_arena* arena);
+/* Predicts P(y = 1 | x)
+   - sc_tensor* x: rows [rows, features], bfloat16, float32 or float64
+   - sc_TYPES type: type of the result
+   - ccb_arena* arena: arena where the result and the scratch will be allocated
+   - return: a pointer to the probabilities, one per row
+*/
+sc_vector* sc_logreg_predict(sc_logreg_model* model, sc_tensor* x, sc_TYPES type, ccb_arena* arena);
+
+
+#endif // __REGRESSION_H__
@@ -0,0 +1,498 @@
+#include "data.h"
+#include "rolling.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+
+
+// least values of a task range of the sliding windows (rounded up to whole windows) and of an ewma chunk
+#define ROLLING_CHUNK 65536
+
+
+struct rolling_args {
+    const void* in;
+    void* out;
+    sc_TYPES type;
+    uint64_t size;
+    // sliding windows
+    uint64_t window;
+    uint64_t span;                  // values of a task range, multiple of window
+    sc_rolling_stat stat;
+    double* sums;                   // [threads, 2 * (window + 1)] suffixes and suffix squares of a block
+    // ewma
+    double alpha;
+    double beta;                    // 1 - alpha
+    uint64_t start;                 // first value that is not NaN
+    double* last;                   // [chunks] average at the end of a chunk started from 0
+    double* decay;                  // [chunks] weight of the carry at the end of a chunk
+    double* carry;                  // [chunks] average before a chunk
+};
+
+
+// sliding window statistics from the combined values (sum, min or max), sums of squares and 1 / count
+#define ROLLING_VALUE(v, squares, inverse) ((void)(squares), (void)(inverse), (v))
+#define ROLLING_MEAN(v, squares, inverse) ((void)(squares), (v) * (inverse))
+#define ROLLING_STD(v, squares, inverse) rolling_std(v, squares, inverse)
+#define ROLLING_ADD(a, b) ((a) + (b))
+#define ROLLING_MAX(a, b) max_nan(a, b)
+#define ROLLING_MIN(a, b) min_nan(a, b)
+
+
+// NaN of either side propagates without branching on the data (the SSE max and min return the second operand)
+static inline double max_nan(double a, double b) {
+    __m128d x = _mm_set_sd(a);
+    __m128d m = _mm_max_sd(x, _mm_set_sd(b));
+    return _mm_cvtsd_f64(_mm_blendv_pd(m, x, _mm_cmpunord_sd(x, x)));
+}
+
+
+static inline double min_nan(double a, double b) {
+    __m128d x = _mm_set_sd(a);
+    __m128d m = _mm_min_sd(x, _mm_set_sd(b));
+    return _mm_cvtsd_f64(_mm_blendv_pd(m, x, _mm_cmpunord_sd(x, x)));
+}
+
+
+// population std of the values shifted by their block shift
+static inline double rolling_std(double sum, double squares, double inverse) {
+    double mean = sum * inverse;
+    double variance = squares * inverse - mean * mean;
+    return (variance < 0.0) ? 0.0 : sqrt(variance);
+}
+
+
+// first value of a block, subtracted from the values of the std windows before squaring them
+static inline double block_shift(double x) {
+    return isfinite(x) ? x : 0.0;
+}
+
+
+// output i + J of a window kernel from the prefix T and the prefix sum of squares Q of its block
+#define ROLLING_EMIT(OP, STORE, FINISH, J, T, Q)                                                               \
+    do {                                                                                                       \
+        uint64_t k = i + J - block + 1;                                                                        \
+        double inverse = (i + J + 1 < window) ? 1.0 / (double)(i + J + 1) : scale;                             \
+        double value = OP(suffix[k], T);                                                                       \
+        out[i + J] = STORE(FINISH(value, suffix_squares[k] + (Q), inverse));                                   \
+    } while (0)
+
+/*
+    sliding window kernel of the outputs [first, last) (first is a multiple of the window), one instance per
+    float type and statistic: the window of i is the suffix of the previous block from i - window + 1 combined
+    with the prefix of its block up to i, prefixes and suffixes move four values at a time so the running
+    combination only waits on one operation out of four
+    - OP: combining operation (sum, min or max) and IDENTITY its identity
+    - SQUARES: 1 to also combine the squares of the shifted values (std)
+    - FINISH: statistic from the combined value, the sum of squares and 1 / count
+*/
+#define ROLLING_WINDOWS(SUFFIX, ST, LOAD, STORE, NAME, OP, IDENTITY, SQUARES, FINISH)                          \
+static void suffix_##NAME##_##SUFFIX(const ST* data, uint64_t block, uint64_t window, double shift,            \
+                                     double* suffix, double* suffix_squares) {                                 \
+    double running = IDENTITY;                                                                                 \
+    double running_squares = 0.0;                                                                              \
+    suffix[window] = running;                                                                                  \
+    suffix_squares[window] = running_squares;                                                                  \
+    uint64_t k = window;                                                                                       \
+    for (; k >= 4; k -= 4) {                                                                                   \
+        double d3 = (double)LOAD(data[block + k - 1]) - shift;                                                 \
+        double d2 = (double)LOAD(data[block + k - 2]) - shift;                                                 \
+        double d1 = (double)LOAD(data[block + k - 3]) - shift;                                                 \
+        double d0 = (double)LOAD(data[block + k - 4]) - shift;                                                 \
+        double t2 = OP(d2, d3);                                                                                \
+        double t1 = OP(d1, t2);                                                                                \
+        double t0 = OP(d0, t1);                                                                                \
+        suffix[k - 1] = OP(d3, running);                                                                       \
+        suffix[k - 2] = OP(t2, running);                                                                       \
+        suffix[k - 3] = OP(t1, running);                                                                       \
+        suffix[k - 4] = OP(t0, running);                                                                       \
+        running = suffix[k - 4];                                                                               \
+        if (SQUARES) {                                                                                         \
+            double q3 = d3 * d3;                                                                               \
+            double q2 = d2 * d2 + q3;                                                                          \
+            double q1 = d1 * d1 + q2;                                                                          \
+            double q0 = d0 * d0 + q1;                                                                          \
+            suffix_squares[k - 1] = q3 + running_squares;                                                      \
+            suffix_squares[k - 2] = q2 + running_squares;                                                      \
+            suffix_squares[k - 3] = q1 + running_squares;                                                      \
+            suffix_squares[k - 4] = q0 + running_squares;                                                      \
+            running_squares = suffix_squares[k - 4];                                                           \
+        }                                                                                                      \
+    }                                                                                                          \
+    for (; k > 0; k--) {                                                                                       \
+        double d = (double)LOAD(data[block + k - 1]) - shift;                                                  \
+        running = OP(d, running);                                                                              \
+        suffix[k - 1] = running;                                                                               \
+        if (SQUARES) {                                                                                         \
+            running_squares += d * d;                                                                          \
+            suffix_squares[k - 1] = running_squares;                                                           \
+        }                                                                                                      \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static void NAME##_##SUFFIX(const struct rolling_args* args, uint64_t first, uint64_t last,                    \
+                            uint64_t thread_id) {                                                              \
+    const ST* data = (const ST*)args->in;                                                                      \
+    ST* out = (ST*)args->out;                                                                                  \
+    uint64_t window = args->window;                                                                            \
+    double scale = 1.0 / (double)window;                                                                       \
+    double* suffix = args->sums + thread_id * 2 * (window + 1);                                                \
+    double* suffix_squares = suffix + window + 1;                                                              \
+    double shift = SQUARES ? block_shift((double)LOAD(data[first])) : 0.0;                                     \
+    if (first == 0) {                                                                                          \
+        for (uint64_t k = 0; k <= window; k++) {                                                               \
+            suffix[k] = IDENTITY;                                                                              \
+            suffix_squares[k] = 0.0;                                                                           \
+        }                                                                                                      \
+    } else {                                                                                                   \
+        suffix_##NAME##_##SUFFIX(data, first - window, window, shift, suffix, suffix_squares);                 \
+    }                                                                                                          \
+    for (uint64_t block = first; block < last; block += window) {                                              \
+        uint64_t end = (block + window < last) ? block + window : last;                                        \
+        double running = IDENTITY;                                                                             \
+        double running_squares = 0.0;                                                                          \
+        uint64_t i = block;                                                                                    \
+        for (; i + 4 <= end; i += 4) {                                                                         \
+            double d0 = (double)LOAD(data[i]) - shift;                                                         \
+            double d1 = (double)LOAD(data[i + 1]) - shift;                                                     \
+            double d2 = (double)LOAD(data[i + 2]) - shift;                                                     \
+            double d3 = (double)LOAD(data[i + 3]) - shift;                                                     \
+            double t1 = OP(d0, d1);                                                                            \
+            double t2 = OP(t1, d2);                                                                            \
+            double t3 = OP(t2, d3);                                                                            \
+            double t0 = OP(running, d0);                                                                       \
+            t1 = OP(running, t1);                                                                              \
+            t2 = OP(running, t2);                                                                              \
+            running = OP(running, t3);                                                                         \
+            double q0 = 0.0;                                                                                   \
+            double q1 = 0.0;                                                                                   \
+            double q2 = 0.0;                                                                                   \
+            double q3 = 0.0;                                                                                   \
+            if (SQUARES) {                                                                                     \
+                q1 = d0 * d0 + d1 * d1;                                                                        \
+                q2 = q1 + d2 * d2;                                                                             \
+                q3 = q2 + d3 * d3;                                                                             \
+                q0 = running_squares + d0 * d0;                                                                \
+                q1 += running_squares;                                                                         \
+                q2 += running_squares;                                                                         \
+                running_squares += q3;                                                                         \
+            }                                                                                                  \
+            ROLLING_EMIT(OP, STORE, FINISH, 0, t0, q0);                                                        \
+            ROLLING_EMIT(OP, STORE, FINISH, 1, t1, q1);                                                        \
+            ROLLING_EMIT(OP, STORE, FINISH, 2, t2, q2);                                                        \
+            ROLLING_EMIT(OP, STORE, FINISH, 3, running, running_squares);                                      \
+        }                                                                                                      \
+        for (; i < end; i++) {                                                                                 \
+            double d = (double)LOAD(data[i]) - shift;                                                          \
+            running = OP(running, d);                                                                          \
+            running_squares += SQUARES ? d * d : 0.0;                                                          \
+            uint64_t k = i - block + 1;                                                                        \
+            double inverse = (i + 1 < window) ? 1.0 / (double)(i + 1) : scale;                                 \
+            double value = OP(suffix[k], running);                                                             \
+            out[i] = STORE(FINISH(value, suffix_squares[k] + running_squares, inverse));                       \
+        }                                                                                                      \
+        if (end < last) {                                                                                      \
+            shift = SQUARES ? block_shift((double)LOAD(data[end])) : 0.0;                                      \
+            suffix_##NAME##_##SUFFIX(data, block, window, shift, suffix, suffix_squares);                      \
+        }                                                                                                      \
+    }                                                                                                          \
+}
+
+
+/*
+    ewma kernels of the chunk [first, last), one instance per float type: the average moves four values at a
+    time (y[i + 4] = beta^4 * y[i] + the weighted sum of the four values) when none of them is NaN
+    - ewma_summary: average at the end of the chunk started from 0 and the weight of the carry (beta^values)
+    - ewma: outputs of the chunk from its carry, NaN before the first value
+*/
+#define ROLLING_EWMA(SUFFIX, ST, LOAD, STORE)                                                                  \
+static void ewma_summary_##SUFFIX(const struct rolling_args* args, uint64_t first, uint64_t last, double* y,   \
+                                  double* decay) {                                                             \
+    const ST* data = (const ST*)args->in;                                                                      \
+    double alpha = args->alpha;                                                                                \
+    double beta = args->beta;                                                                                  \
+    double beta4 = beta * beta * beta * beta;                                                                  \
+    double average = 0.0;                                                                                      \
+    double weight = 1.0;                                                                                       \
+    uint64_t i = first;                                                                                        \
+    for (; i + 4 <= last; i += 4) {                                                                            \
+        double x0 = (double)LOAD(data[i]);                                                                     \
+        double x1 = (double)LOAD(data[i + 1]);                                                                 \
+        double x2 = (double)LOAD(data[i + 2]);                                                                 \
+        double x3 = (double)LOAD(data[i + 3]);                                                                 \
+        if (x0 == x0 && x1 == x1 && x2 == x2 && x3 == x3) {                                                    \
+            double c = ((alpha * x0 * beta + alpha * x1) * beta + alpha * x2) * beta + alpha * x3;             \
+            average = beta4 * average + c;                                                                     \
+            weight *= beta4;                                                                                   \
+        } else {                                                                                               \
+            double x[4] = {x0, x1, x2, x3};                                                                    \
+            for (int j = 0; j < 4; j++) {                                                                      \
+                if (x[j] == x[j]) {                                                                            \
+                    average = beta * average + alpha * x[j];                                                   \
+                    weight *= beta;                                                                            \
+                }                                                                                              \
+            }                                                                                                  \
+        }                                                                                                      \
+    }                                                                                                          \
+    for (; i < last; i++) {                                                                                    \
+        double x = (double)LOAD(data[i]);                                                                      \
+        if (x == x) {                                                                                          \
+            average = beta * average + alpha * x;                                                              \
+            weight *= beta;                                                                                    \
+        }                                                                                                      \
+    }                                                                                                          \
+    *y = average;                                                                                              \
+    *decay = weight;                                                                                           \
+}                                                                                                              \
+                                                                                                               \
+static void ewma_##SUFFIX(const struct rolling_args* args, uint64_t first, uint64_t last, double carry) {      \
+    const ST* data = (const ST*)args->in;                                                                      \
+    ST* out = (ST*)args->out;                                                                                  \
+    double alpha = args->alpha;                                                                                \
+    double beta = args->beta;                                                                                  \
+    double beta2 = beta * beta;                                                                                \
+    double beta3 = beta2 * beta;                                                                               \
+    double beta4 = beta2 * beta2;                                                                              \
+    double average = carry;                                                                                    \
+    uint64_t i = first;                                                                                        \
+    for (; i < last && i < args->start; i++) {                                                                 \
+        out[i] = STORE(NAN);                                                                                   \
+    }                                                                                                          \
+    for (; i + 4 <= last; i += 4) {                                                                            \
+        double x0 = (double)LOAD(data[i]);                                                                     \
+        double x1 = (double)LOAD(data[i + 1]);                                                                 \
+        double x2 = (double)LOAD(data[i + 2]);                                                                 \
+        double x3 = (double)LOAD(data[i + 3]);                                                                 \
+        if (x0 == x0 && x1 == x1 && x2 == x2 && x3 == x3) {                                                    \
+            double c0 = alpha * x0;                                                                            \
+            double c1 = beta * c0 + alpha * x1;                                                                \
+            double c2 = beta * c1 + alpha * x2;                                                                \
+            double c3 = beta * c2 + alpha * x3;                                                                \
+            out[i] = STORE(beta * average + c0);                                                               \
+            out[i + 1] = STORE(beta2 * average + c1);                                                          \
+            out[i + 2] = STORE(beta3 * average + c2);                                                          \
+            average = beta4 * average + c3;                                                                    \
+            out[i + 3] = STORE(average);                                                                       \
+        } else {                                                                                               \
+            double x[4] = {x0, x1, x2, x3};                                                                    \
+            for (int j = 0; j < 4; j++) {                                                                      \
+                if (x[j] == x[j]) {                                                                            \
+                    average = beta * average + alpha * x[j];                                                   \
+                }                                                                                              \
+                out[i + j] = STORE(average);                                                                   \
+            }                                                                                                  \
+        }                                                                                                      \
+    }                                                                                                          \
+    for (; i < last; i++) {                                                                                    \
+        double x = (double)LOAD(data[i]);                                                                      \
+        if (x == x) {                                                                                          \
+            average = beta * average + alpha * x;                                                              \
+        }                                                                                                      \
+        out[i] = STORE(average);                                                                               \
+    }                                                                                                          \
+}
+
+#define ROLLING_KERNELS(SUFFIX, ST, LOAD, STORE)                                                               \
+ROLLING_WINDOWS(SUFFIX, ST, LOAD, STORE, sum, ROLLING_ADD, 0.0, 0, ROLLING_VALUE)                              \
+ROLLING_WINDOWS(SUFFIX, ST, LOAD, STORE, mean, ROLLING_ADD, 0.0, 0, ROLLING_MEAN)                              \
+ROLLING_WINDOWS(SUFFIX, ST, LOAD, STORE, std, ROLLING_ADD, 0.0, 1, ROLLING_STD)                                \
+ROLLING_WINDOWS(SUFFIX, ST, LOAD, STORE, min, ROLLING_MIN, INFINITY, 0, ROLLING_VALUE)                         \
+ROLLING_WINDOWS(SUFFIX, ST, LOAD, STORE, max, ROLLING_MAX, -INFINITY, 0, ROLLING_VALUE)                        \
+ROLLING_EWMA(SUFFIX, ST, LOAD, STORE)
+
+#define ROLLING_LOAD_SAME(v) (v)
+#define ROLLING_LOAD_BF16(v) sc_bf16_bits_to_f32(v)
+#define ROLLING_LOAD_HALF(v) sc_half_bits_to_f32(v)
+#define ROLLING_STORE_F32(v) (float)(v)
+#define ROLLING_STORE_F64(v) (v)
+#define ROLLING_STORE_BF16(v) sc_f32_to_bf16_bits((float)(v))
+#define ROLLING_STORE_HALF(v) sc_f32_to_half_bits((float)(v))
+
+ROLLING_KERNELS(bf16, uint16_t, ROLLING_LOAD_BF16, ROLLING_STORE_BF16)
+ROLLING_KERNELS(f32, float, ROLLING_LOAD_SAME, ROLLING_STORE_F32)
+ROLLING_KERNELS(f64, double, ROLLING_LOAD_SAME, ROLLING_STORE_F64)
+ROLLING_KERNELS(half, uint16_t, ROLLING_LOAD_HALF, ROLLING_STORE_HALF)
+
+typedef struct {
+    void (*windows[5])(const struct rolling_args*, uint64_t, uint64_t, uint64_t);
+    void (*ewma_summary)(const struct rolling_args*, uint64_t, uint64_t, double*, double*);
+    void (*ewma)(const struct rolling_args*, uint64_t, uint64_t, double);
+} rolling_kernels;
+
+#define ROLLING_ROW(SUFFIX)                                                                                    \
+    {{sum_##SUFFIX, mean_##SUFFIX, std_##SUFFIX, min_##SUFFIX, max_##SUFFIX},                                  \
+     ewma_summary_##SUFFIX, ewma_##SUFFIX}
+
+// in the order of sc_TYPES (the float types come first) and of sc_rolling_stat
+static const rolling_kernels kernels[4] = {
+    ROLLING_ROW(bf16),
+    ROLLING_ROW(f32),
+    ROLLING_ROW(f64),
+    ROLLING_ROW(half),
+};
+
+
+
+// ########
+// tasks
+// ########
+
+static int rolling_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct rolling_args* args = (struct rolling_args*)raw;
+    uint64_t first = start * args->span;
+    uint64_t last = (end * args->span < args->size) ? end * args->span : args->size;
+    kernels[args->type].windows[args->stat](args, first, last, thread_id);
+    return 0;
+}
+
+
+static int ewma_summary_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct rolling_args* args = (struct rolling_args*)raw;
+    for (uint64_t c = start; c < end; c++) {
+        uint64_t first = (c * ROLLING_CHUNK > args->start) ? c * ROLLING_CHUNK : args->start;
+        uint64_t last = ((c + 1) * ROLLING_CHUNK < args->size) ? (c + 1) * ROLLING_CHUNK : args->size;
+        kernels[args->type].ewma_summary(args, first, last, &args->last[c], &args->decay[c]);
+    }
+    return 0;
+}
+
+
+static int ewma_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct rolling_args* args = (struct rolling_args*)raw;
+    for (uint64_t c = start; c < end; c++) {
+        uint64_t last = ((c + 1) * ROLLING_CHUNK < args->size) ? (c + 1) * ROLLING_CHUNK : args->size;
+        kernels[args->type].ewma(args, c * ROLLING_CHUNK, last, args->carry[c]);
+    }
+    return 0;
+}
+
+
+static int check_vectors(sc_vector* a, sc_vector* out) {
+    CCB_NOTNULL(a, "vector is NULL");
+    CCB_NOTNULL(out, "output is NULL");
+    if (a->type != sc_float16 && a->type != sc_float32 && a->type != sc_float64 && a->type != sc_half) {
+        CCB_ERROR("rolling statistics need a float vector");
+        return -1;
+    }
+    if (out->size != a->size || out->type != a->type) {
+        CCB_ERROR("output must have the size and type of the vector");
+        return -1;
+    }
+    return 0;
+}
+
+
+int sc_vector_rolling(sc_vector* a, sc_vector* out, uint64_t window, sc_rolling_stat stat, ccb_arena* arena) {
+    if (check_vectors(a, out) != 0) {
+        return -1;
+    }
+    if (out->data == a->data) {
+        CCB_ERROR("rolling statistics can not be computed in place");
+        return -1;
+    }
+    if (window == 0 || window > UINT32_MAX) {
+        CCB_ERROR("window must be in [1, %u], got %" PRIu64, UINT32_MAX, window);
+        return -1;
+    }
+    if (stat < sc_rolling_sum || stat > sc_rolling_max) {
+        CCB_ERROR("Unknown rolling statistic %d", (int)stat);
+        return -1;
+    }
+    if (a->size == 0) {
+        return 0;
+    }
+    struct rolling_args args;
+    memset(&args, 0, sizeof(args));
+    args.in = a->data;
+    args.out = out->data;
+    args.type = a->type;
+    args.size = a->size;
+    args.window = (window < a->size) ? window : a->size;
+    args.span = ((ROLLING_CHUNK + args.window - 1) / args.window) * args.window;
+    args.stat = stat;
+    uint64_t threads = sc_get_engine_thread_count();
+    args.sums = (double*)ccb_arena_malloc(arena, threads * 2 * (args.window + 1) * sizeof(double));
+    CCB_NOTNULL(args.sums, "Failed to allocate the rolling suffixes");
+    uint64_t ranges = (args.size + args.span - 1) / args.span;
+    if (sc_run_range_task(rolling_kernel, &args, ranges, args.size, arena) != 0) {
+        CCB_ERROR("Failed to compute the rolling statistic");
+        return -1;
+    }
+    return 0;
+}
+
+
+int sc_vector_rolling_sum(sc_vector* a, sc_vector* out, uint64_t window, ccb_arena* arena) {
+    return sc_vector_rolling(a, out, window, sc_rolling_sum, arena);
+}
+
+
+int sc_vector_rolling_mean(sc_vector* a, sc_vector* out, uint64_t window, ccb_arena* arena) {
+    return sc_vector_rolling(a, out, window, sc_rolling_mean, arena);
+}
+
+
+int sc_vector_rolling_std(sc_vector* a, sc_vector* out, uint64_t window, ccb_arena* arena) {
+    return sc_vector_rolling(a, out, window, sc_rolling_std, arena);
+}
+
+
+int sc_vector_rolling_min(sc_vector* a, sc_vector* out, uint64_t window, ccb_arena* arena) {
+    return sc_vector_rolling(a, out, window, sc_rolling_min, arena);
+}
+
+
+int sc_vector_rolling_max(sc_vector* a, sc_vector* out, uint64_t window, ccb_arena* arena) {
+    return sc_vector_rolling(a, out, window, sc_rolling_max, arena);
+}
+
+
+int sc_vector_ewma(sc_vector* a, sc_vector* out, double alpha, ccb_arena* arena) {
+    if (check_vectors(a, out) != 0) {
+        return -1;
+    }
+    if (!(alpha > 0.0 && alpha <= 1.0)) {
+        CCB_ERROR("alpha must be in (0, 1], got %f", alpha);
+        return -1;
+    }
+    struct rolling_args args;
+    memset(&args, 0, sizeof(args));
+    args.in = a->data;
+    args.out = out->data;
+    args.type = a->type;
+    args.size = a->size;
+    args.alpha = alpha;
+    args.beta = 1.0 - alpha;
+    // the average starts at the first value: y[start - 1] = x[start]
+    double first_value = NAN;
+    while (args.start < a->size && first_value != first_value) {
+        first_value = sc_value_to_f64(sc_get_vector_element(a, args.start));
+        args.start += (first_value != first_value);
+    }
+    uint64_t chunks = (a->size + ROLLING_CHUNK - 1) / ROLLING_CHUNK;
+    args.last = (double*)ccb_arena_malloc(arena, 3 * (chunks + 1) * sizeof(double));
+    CCB_NOTNULL(args.last, "Failed to allocate the ewma carries");
+    args.decay = args.last + chunks + 1;
+    args.carry = args.decay + chunks + 1;
+    // chunks before the first value keep an average of 0 and a decay of 1
+    if (sc_run_range_task(ewma_summary_kernel, &args, chunks, a->size, arena) != 0) {
+        CCB_ERROR("Failed to summarize the ewma chunks");
+        return -1;
+    }
+    double carry = first_value;
+    for (uint64_t c = 0; c < chunks; c++) {
+        args.carry[c] = carry;
+        carry = args.decay[c] * carry + args.last[c];
+    }
+    if (sc_run_range_task(ewma_kernel, &args, chunks, a->size, arena) != 0) {
+        CCB_ERROR("Failed to compute the ewma");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef __ROLLING_H__
+#define __ROLLING_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    sliding window statistics and exponentially weighted moving averages of float vectors (bfloat16, float32,
+    float64, half), every statistic is computed in float64 and rounded once to the output type
+    - the series is cut in blocks of the window size, the running sums, minima and maxima restart at every block
+      (re-anchored) and the part of a window in the previous block comes from the suffixes of that block, so
+      nothing is ever subtracted: rounding errors do not build up along the series and a NaN only reaches the
+      windows holding it, stds shift the values of a block by its first value before squaring
+    - threads take contiguous ranges of blocks and read the block before their range again (overlap), the
+      results do not depend on the thread count
+    - ewma: y[i] = alpha * x[i] + (1 - alpha) * y[i - 1] from y = x at the first value, computed as a scan of the
+      affine maps over fixed chunks (chunk summaries, serial carries, chunks recomputed from their carry)
+    NaN values: a window holding a NaN gives NaN, the ewma skips them (keeps the previous average, NaN before
+    the first value)
+*/
+
+typedef enum {
+    sc_rolling_sum,
+    sc_rolling_mean,
+    sc_rolling_std,         // population standard deviation (divided by the count)
+    sc_rolling_min,
+    sc_rolling_max,
+} sc_rolling_stat;
+
+
+/* Sliding window statistic: out[i] = stat(a[i - window + 1], ..., a[i]), the first window - 1 outputs use the
+   values from a[0] (partial windows)
+   - sc_vector* a: float vector (bfloat16, float32, float64 or half)
+   - sc_vector* out: same size and type as a, other data than a
+   - uint64_t window: window size, at least 1
+   - sc_rolling_stat stat: computed statistic
+   - ccb_arena* arena: arena where the scratch and the tasks will be allocated
+   - return: 0 on success
+*/
+int sc_vector_rolling(sc_vector* a, sc_vector* out, uint64_t window, sc_rolling_stat stat, ccb_arena* arena);
+
+/* Sliding window statistics of a vector, see sc_vector_rolling */
+int sc_vector_rolling_sum(sc_vector* a, sc_vector* out, uint64_t window, ccb_arena* arena);
+int sc_vector_rolling_mean(sc_vector* a, sc_vector* out, uint64_t window, ccb_arena* arena);
+int sc_vector_rolling_std(sc_vector* a, sc_vector* out, uint64_t window, ccb_arena* arena);
+int sc_vector_rolling_min(sc_vector* a, sc_vector* out, uint64_t window, ccb_arena* arena);
+int sc_vector_rolling_max(sc_vector* a, sc_vector* out, uint64_t window, ccb_arena* arena);
+
+/* Exponentially weighted moving average: out[i] = alpha * a[i] + (1 - alpha) * out[i - 1], out = a at the first
+   value that is not NaN
+   - sc_vector* a: float vector
+   - sc_vector* out: same size and type as a, can be a
+   - double alpha: smoothing factor in (0, 1]
+   - return: 0 on success
+*/
+int sc_vector_ewma(sc_vector* a, sc_vector* out, double alpha, ccb_arena* arena);
+
+
+#endif // __ROLLING_H__
@@ -1,5 +1,6 @@
 #include "sc_engine.h"
 #include "sc_threads.h" 
+#include "sc_simd.h"
 #include "const.h"
 #include "ccbase/logs/log.h"
 #include "ccbase/utils/mem.h"
@@ -25,8 +26,8 @@ struct thread_data {
 };
 
 struct thread_control {
-    mutex_t run_mutex;
-    mutex_t wait_mutex;
+    semaphore_t start_semaphore;
+    semaphore_t done_semaphore;
     struct thread_data* task_data;
     int (*task_fn)(void*);
     int return_value;
@@ -66,17 +67,19 @@ void sc_init_thread_pool(uint64_t num_threads) {
     }
 
     for (uint64_t i = 0; i < num_threads; i++) {
-        create_mutex(&thread_controls[i].run_mutex);
-        create_mutex(&thread_controls[i].wait_mutex);
-        lock_mutex(thread_controls[i].wait_mutex);
+        // start is posted by the dispatcher, done is posted by the worker once the task returns
+        if (create_semaphore(&thread_controls[i].start_semaphore, 0) != 0 ||
+            create_semaphore(&thread_controls[i].done_semaphore, 0) != 0) {
+            CCB_ERROR("Failed to create semaphores for thread %d", i);
+            exit(1);
+        }
         thread_controls[i].task_data = NULL;
+        thread_controls[i].return_value = 0;
     
-        create_thread(&threads[i], sc_worker, &thread_controls[i]);
-        if (threads[i] == 0) {
+        if (create_thread(&threads[i], sc_worker, &thread_controls[i]) != 0) {
             CCB_ERROR("Failed to create thread %d", i);
             exit(1);
         }
-        unlock_mutex(thread_controls[i].run_mutex);   
     }
 
 
@@ -85,8 +88,22 @@ void sc_init_thread_pool(uint64_t num_threads) {
 
 void sc_destroy_thread_pool() {
     if (threads != NULL) {
+        // an empty task tells the worker to exit
+        for (uint64_t i = 0; i < thread_count; i++) {
+            thread_controls[i].task_data = NULL;
+            post_semaphore(thread_controls[i].start_semaphore);
+        }
+
+        for (uint64_t i = 0; i < thread_count; i++) {
+            join_thread(threads[i]);
+            destroy_semaphore(thread_controls[i].start_semaphore);
+            destroy_semaphore(thread_controls[i].done_semaphore);
+        }
+
         free(threads);
+        free(thread_controls);
         threads = NULL;
+        thread_controls = NULL;
         thread_count = 0;
     }
 }
@@ -95,19 +112,18 @@ void* sc_worker(void* arg) {
     struct thread_control* data = (struct thread_control*)arg;
 
     while(1) {
-        lock_mutex(data->wait_mutex);
-        lock_mutex(data->run_mutex);
-        unlock_mutex(data->wait_mutex);
+        wait_semaphore(data->start_semaphore);
 
         if (data->task_data == NULL) {
-            unlock_mutex(data->run_mutex);
             break;
         }
         data->return_value = data->task_fn(data->task_data);
         data->task_data = NULL;
-        unlock_mutex(data->run_mutex);
+        post_semaphore(data->done_semaphore);
                 
     }
+
+    return NULL;
 }
 
 
@@ -232,7 +248,7 @@ int map_avx_f32(float* a, float* out, sc_value_t (*func)(sc_value_t), uint64_t c
 int map_args_avx_f32(float* a, float* out, sc_value_t (*func)(sc_value_t, void*), void* args, uint64_t count) {
 
     if (func == sc_scalar_add_args) {
-        sc_value_t b = *(sc_value_t *)args;
+        sc_value_t b = to_sc_value(sc_value_to_f32(*(sc_value_t *)args), sc_float32);
         for (uint64_t i = 0; i < count; i+=8){
             __m256 x, y, _out;
             float b_f = b.value.f32;
@@ -254,7 +270,7 @@ int map_args_avx_f32(float* a, float* out, sc_value_t (*func)(sc_value_t, void*)
         return 0;
     
     } else if (func == sc_scalar_sub_args) {
-        sc_value_t b = *(sc_value_t *)args;
+        sc_value_t b = to_sc_value(sc_value_to_f32(*(sc_value_t *)args), sc_float32);
         for (uint64_t i = 0; i < count; i+=8){
             __m256 x, y, _out;
             float b_f = b.value.f32;
@@ -276,7 +292,7 @@ int map_args_avx_f32(float* a, float* out, sc_value_t (*func)(sc_value_t, void*)
         return 0;
 
     } else if (func == sc_scalar_mul_args) {
-        sc_value_t b = *(sc_value_t *)args;
+        sc_value_t b = to_sc_value(sc_value_to_f32(*(sc_value_t *)args), sc_float32);
         for (uint64_t i = 0; i < count; i+=8){
             __m256 x, y, _out;
             float b_f = b.value.f32;
@@ -300,7 +316,7 @@ int map_args_avx_f32(float* a, float* out, sc_value_t (*func)(sc_value_t, void*)
     
     } else if (func == sc_scalar_div_args) {
 
-        sc_value_t b = *(sc_value_t *)args;
+        sc_value_t b = to_sc_value(sc_value_to_f32(*(sc_value_t *)args), sc_float32);
         for (uint64_t i = 0; i < count; i+=8){
             __m256 x, y, _out;
             float b_f = b.value.f32;
@@ -327,7 +343,148 @@ int map_args_avx_f32(float* a, float* out, sc_value_t (*func)(sc_value_t, void*)
 }
 
 
+// AVX2 integer kernels, they work on 32 bytes blocks and return the number of elements processed
+// (the caller finishes the tail with the scalar loop), 0 when func has no integer kernel for the type
+typedef enum {
+    int_op_none,
+    int_op_and,
+    int_op_or,
+    int_op_xor,
+    int_op_add,
+    int_op_sub,
+    int_op_mul,
+} int_op;
+
+static int_op select_int_op(sc_value_t (*func)(sc_value_t, sc_value_t), sc_TYPES type) {
+    if (func == sc_scalar_and) return int_op_and;
+    if (func == sc_scalar_or) return int_op_or;
+    if (func == sc_scalar_xor) return int_op_xor;
+    if (func == sc_scalar_add) return int_op_add;
+    if (func == sc_scalar_sub) return int_op_sub;
+    if (func == sc_scalar_mul && type == sc_int32) return int_op_mul; // no 64 bits / saturating 8 bits multiply
+    return int_op_none;
+}
+
+static int_op select_int_args_op(sc_value_t (*func)(sc_value_t, void*), sc_TYPES type) {
+    if (func == sc_scalar_add_args) return int_op_add;
+    if (func == sc_scalar_sub_args) return int_op_sub;
+    if (func == sc_scalar_mul_args && type == sc_int32) return int_op_mul;
+    return int_op_none;
+}
+
+static SC_TARGET_AVX2 __m256i broadcast_int(sc_value_t value, sc_TYPES type) {
+    switch (type) {
+        case sc_int32: return _mm256_set1_epi32(sc_value_to_i32(value));
+        case sc_int64: return _mm256_set1_epi64x(sc_value_to_i64(value));
+        default:       return _mm256_set1_epi8((char)sc_value_to_u8(value));
+    }
+}
+
+static SC_TARGET_AVX2 inline __m256i apply_int_op(int_op op, sc_TYPES type, __m256i x, __m256i y) {
+    switch (op) {
+        case int_op_and: return _mm256_and_si256(x, y);
+        case int_op_or:  return _mm256_or_si256(x, y);
+        case int_op_xor: return _mm256_xor_si256(x, y);
+        case int_op_add:
+            return (type == sc_int32) ? _mm256_add_epi32(x, y) : ((type == sc_int64) ? _mm256_add_epi64(x, y) : _mm256_adds_epu8(x, y));
+        case int_op_sub:
+            return (type == sc_int32) ? _mm256_sub_epi32(x, y) : ((type == sc_int64) ? _mm256_sub_epi64(x, y) : _mm256_subs_epu8(x, y));
+        default:
+            return _mm256_mullo_epi32(x, y);
+    }
+}
+
+// b == NULL uses the broadcast scalar, the loop is specialised per operation so that the switch stays out of it
+static SC_TARGET_AVX2 uint64_t int_op_avx2(const uint8_t* a, const uint8_t* b, __m256i scalar, uint8_t* out, int_op op, sc_TYPES type, uint64_t count) {
+    uint64_t size = sc_type_size(type);
+    uint64_t bytes = (count * size) & ~(uint64_t)31;
+
+    #define INT_OP_LOOP(OP, TYPE)                                                                           \
+        for (uint64_t i = 0; i < bytes; i += 32) {                                                          \
+            __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));                                        \
+            __m256i y = b ? _mm256_loadu_si256((const __m256i*)(b + i)) : scalar;                           \
+            _mm256_storeu_si256((__m256i*)(out + i), apply_int_op(OP, TYPE, x, y));                         \
+        }
+
+    switch (op) {
+        case int_op_and: INT_OP_LOOP(int_op_and, sc_int32); break;
+        case int_op_or:  INT_OP_LOOP(int_op_or, sc_int32); break;
+        case int_op_xor: INT_OP_LOOP(int_op_xor, sc_int32); break;
+        case int_op_add:
+            if (type == sc_int32) { INT_OP_LOOP(int_op_add, sc_int32); }
+            else if (type == sc_int64) { INT_OP_LOOP(int_op_add, sc_int64); }
+            else { INT_OP_LOOP(int_op_add, sc_uint8); }
+            break;
+        case int_op_sub:
+            if (type == sc_int32) { INT_OP_LOOP(int_op_sub, sc_int32); }
+            else if (type == sc_int64) { INT_OP_LOOP(int_op_sub, sc_int64); }
+            else { INT_OP_LOOP(int_op_sub, sc_uint8); }
+            break;
+        case int_op_mul: INT_OP_LOOP(int_op_mul, sc_int32); break;
+        default: return 0;
+    }
+
+    #undef INT_OP_LOOP
+    return bytes / size;
+}
+
+// reductions with an associative operation keep one accumulator vector, folded with func at the end
+static SC_TARGET_AVX2 uint64_t int_reduce_avx2(const uint8_t* a, int_op op, sc_value_t (*func)(sc_value_t, sc_value_t), sc_TYPES type, uint64_t count, sc_value_t* out) {
+    if (op == int_op_none || op == int_op_sub || op == int_op_mul) {
+        return 0;
+    }
+    uint64_t size = sc_type_size(type);
+    uint64_t bytes = (count * size) & ~(uint64_t)31;
+    if (bytes == 0) {
+        return 0;
+    }
+
+    __m256i acc = _mm256_loadu_si256((const __m256i*)a);
+    for (uint64_t i = 32; i < bytes; i += 32) {
+        acc = apply_int_op(op, type, acc, _mm256_loadu_si256((const __m256i*)(a + i)));
+    }
+
+    uint8_t lanes[32];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    for (uint64_t i = 0; i < 32 / size; i++) {
+        sc_value_t lane = {.type = type};
+        memcpy(&lane.value, lanes + i * size, size);
+        *out = func(*out, lane);
+    }
+    return bytes / size;
+}
+
+static SC_TARGET_AVX2 uint64_t int_map_avx2(const uint8_t* a, uint8_t* out, sc_value_t (*func)(sc_value_t), sc_TYPES type, uint64_t count) {
+    uint64_t size = sc_type_size(type);
+    uint64_t bytes = (count * size) & ~(uint64_t)31;
+
+    if (func == sc_scalar_not) {
+        __m256i ones = _mm256_set1_epi32(-1);
+        for (uint64_t i = 0; i < bytes; i += 32) {
+            _mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)), ones));
+        }
+        return bytes / size;
+    }
+    if (func == sc_scalar_abs && type == sc_int32) {
+        for (uint64_t i = 0; i < bytes; i += 32) {
+            _mm256_storeu_si256((__m256i*)(out + i), _mm256_abs_epi32(_mm256_loadu_si256((const __m256i*)(a + i))));
+        }
+        return bytes / size;
+    }
+    return 0;
+}
+
+
 // single thread functions
+
+// sc_half buffers are processed SC_HALF_CHUNK elements at a time: the chunk is widened to float32 (F16C),
+// computed by the float32 kernels and narrowed back to 16 bits
+#define SC_HALF_CHUNK 512
+
+static inline uint64_t half_chunk_count(uint64_t count, uint64_t i) {
+    return (count - i < SC_HALF_CHUNK) ? count - i : SC_HALF_CHUNK;
+}
+
 int execute_element_wise_op(void* a, void* b, void* out, sc_value_t (*func)(sc_value_t, sc_value_t), sc_TYPES type, uint64_t count) {
     
     switch (type) {
@@ -343,6 +500,24 @@ int execute_element_wise_op(void* a, void* b, void* out, sc_value_t (*func)(sc_v
             break;
         }
 
+        case sc_half: {
+            uint16_t* a_data = (uint16_t*)a;
+            uint16_t* b_data = (uint16_t*)b;
+            uint16_t* out_data = (uint16_t*)out;
+            float a_chunk[SC_HALF_CHUNK], b_chunk[SC_HALF_CHUNK], out_chunk[SC_HALF_CHUNK];
+
+            for (uint64_t i = 0; i < count; i += SC_HALF_CHUNK) {
+                uint64_t n = half_chunk_count(count, i);
+                sc_convert_half_to_f32(a_data + i, a_chunk, n);
+                sc_convert_half_to_f32(b_data + i, b_chunk, n);
+                if (execute_element_wise_op(a_chunk, b_chunk, out_chunk, func, sc_float32, n) != 0) {
+                    return -1;
+                }
+                sc_convert_f32_to_half(out_chunk, out_data + i, n);
+            }
+            break;
+        }
+
         case sc_float32: {
             float* a_data = (float*)a;
             float* b_data = (float*)b;
@@ -374,6 +549,57 @@ int execute_element_wise_op(void* a, void* b, void* out, sc_value_t (*func)(sc_v
             break;
         }
 
+        case sc_int32: {
+            int32_t* a_data = (int32_t*)a;
+            int32_t* b_data = (int32_t*)b;
+            int32_t* out_data = (int32_t*)out;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_op_avx2((const uint8_t*)a, (const uint8_t*)b, _mm256_setzero_si256(), (uint8_t*)out, select_int_op(func, type), type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_int32, .value.i32=a_data[i]},
+                                   (sc_value_t){.type=sc_int32, .value.i32=b_data[i]}).value.i32;
+            }
+            break;
+        }
+
+        case sc_int64: {
+            int64_t* a_data = (int64_t*)a;
+            int64_t* b_data = (int64_t*)b;
+            int64_t* out_data = (int64_t*)out;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_op_avx2((const uint8_t*)a, (const uint8_t*)b, _mm256_setzero_si256(), (uint8_t*)out, select_int_op(func, type), type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_int64, .value.i64=a_data[i]},
+                                   (sc_value_t){.type=sc_int64, .value.i64=b_data[i]}).value.i64;
+            }
+            break;
+        }
+
+        case sc_uint8: {
+            uint8_t* a_data = (uint8_t*)a;
+            uint8_t* b_data = (uint8_t*)b;
+            uint8_t* out_data = (uint8_t*)out;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_op_avx2((const uint8_t*)a, (const uint8_t*)b, _mm256_setzero_si256(), (uint8_t*)out, select_int_op(func, type), type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_uint8, .value.u8=a_data[i]},
+                                   (sc_value_t){.type=sc_uint8, .value.u8=b_data[i]}).value.u8;
+            }
+            break;
+        }
+
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", type);
             return -1;
@@ -395,6 +621,23 @@ int execute_scalar_element_op(void* a, sc_value_t scalar, void* out, sc_value_t
             break;
         }
 
+        case sc_half: {
+            uint16_t* a_data = (uint16_t*)a;
+            uint16_t* out_data = (uint16_t*)out;
+            float a_chunk[SC_HALF_CHUNK], out_chunk[SC_HALF_CHUNK];
+            sc_value_t scalar_f32 = to_sc_value(sc_value_to_f32(scalar), sc_float32);
+
+            for (uint64_t i = 0; i < count; i += SC_HALF_CHUNK) {
+                uint64_t n = half_chunk_count(count, i);
+                sc_convert_half_to_f32(a_data + i, a_chunk, n);
+                if (execute_scalar_element_op(a_chunk, scalar_f32, out_chunk, func, sc_float32, n) != 0) {
+                    return -1;
+                }
+                sc_convert_f32_to_half(out_chunk, out_data + i, n);
+            }
+            break;
+        }
+
         case sc_float32: {
             float* a_data = (float*)a;
             float* out_data = (float*)out;
@@ -415,6 +658,51 @@ int execute_scalar_element_op(void* a, sc_value_t scalar, void* out, sc_value_t
             break;
         }
 
+        case sc_int32: {
+            int32_t* a_data = (int32_t*)a;
+            int32_t* out_data = (int32_t*)out;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_op_avx2((const uint8_t*)a, NULL, broadcast_int(scalar, type), (uint8_t*)out, select_int_op(func, type), type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_int32, .value.i32=a_data[i]}, scalar).value.i32;
+            }
+            break;
+        }
+
+        case sc_int64: {
+            int64_t* a_data = (int64_t*)a;
+            int64_t* out_data = (int64_t*)out;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_op_avx2((const uint8_t*)a, NULL, broadcast_int(scalar, type), (uint8_t*)out, select_int_op(func, type), type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_int64, .value.i64=a_data[i]}, scalar).value.i64;
+            }
+            break;
+        }
+
+        case sc_uint8: {
+            uint8_t* a_data = (uint8_t*)a;
+            uint8_t* out_data = (uint8_t*)out;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_op_avx2((const uint8_t*)a, NULL, broadcast_int(scalar, type), (uint8_t*)out, select_int_op(func, type), type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_uint8, .value.u8=a_data[i]}, scalar).value.u8;
+            }
+            break;
+        }
+
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", type);
             return -1;
@@ -437,6 +725,23 @@ int execute_reduce_op(void* a, sc_value_t init_val, sc_value_t (*func)(sc_value_
             break;
         }
 
+        case sc_half: {
+            // accumulates in float32, the result is narrowed once
+            uint16_t* a_data = (uint16_t*)a;
+            float a_chunk[SC_HALF_CHUNK];
+            sc_value_t acc = to_sc_value(sc_value_to_f32(init_val), sc_float32);
+
+            for (uint64_t i = 0; i < count; i += SC_HALF_CHUNK) {
+                uint64_t n = half_chunk_count(count, i);
+                sc_convert_half_to_f32(a_data + i, a_chunk, n);
+                for (uint64_t j = 0; j < n; j++) {
+                    acc = func(acc, to_sc_value(a_chunk[j], sc_float32));
+                }
+            }
+            *out = to_sc_value(sc_value_to_f32(acc), sc_half);
+            break;
+        }
+
         case sc_float32: {
             float* a_data = (float*)a;
 
@@ -455,6 +760,48 @@ int execute_reduce_op(void* a, sc_value_t init_val, sc_value_t (*func)(sc_value_
             break;
         }
 
+        case sc_int32: {
+            int32_t* a_data = (int32_t*)a;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_reduce_avx2((const uint8_t*)a, select_int_op(func, type), func, type, count, out);
+            }
+
+            for (; i < count; i++) {
+                *out = func(*out, (sc_value_t){.type=sc_int32, .value.i32=a_data[i]});
+            }
+            break;
+        }
+
+        case sc_int64: {
+            int64_t* a_data = (int64_t*)a;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_reduce_avx2((const uint8_t*)a, select_int_op(func, type), func, type, count, out);
+            }
+
+            for (; i < count; i++) {
+                *out = func(*out, (sc_value_t){.type=sc_int64, .value.i64=a_data[i]});
+            }
+            break;
+        }
+
+        case sc_uint8: {
+            uint8_t* a_data = (uint8_t*)a;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_reduce_avx2((const uint8_t*)a, select_int_op(func, type), func, type, count, out);
+            }
+
+            for (; i < count; i++) {
+                *out = func(*out, (sc_value_t){.type=sc_uint8, .value.u8=a_data[i]});
+            }
+            break;
+        }
+
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", type);
             return -1;
@@ -475,6 +822,22 @@ int execute_map_op(void* a, void* out, sc_value_t (*func)(sc_value_t), sc_TYPES
             break;
         }
 
+        case sc_half: {
+            uint16_t* a_data = (uint16_t*)a;
+            uint16_t* out_data = (uint16_t*)out;
+            float a_chunk[SC_HALF_CHUNK], out_chunk[SC_HALF_CHUNK];
+
+            for (uint64_t i = 0; i < count; i += SC_HALF_CHUNK) {
+                uint64_t n = half_chunk_count(count, i);
+                sc_convert_half_to_f32(a_data + i, a_chunk, n);
+                if (execute_map_op(a_chunk, out_chunk, func, sc_float32, n) != 0) {
+                    return -1;
+                }
+                sc_convert_f32_to_half(out_chunk, out_data + i, n);
+            }
+            break;
+        }
+
         case sc_float32: {
             float* a_data = (float*)a;
             float* out_data = (float*)out;
@@ -501,6 +864,51 @@ int execute_map_op(void* a, void* out, sc_value_t (*func)(sc_value_t), sc_TYPES
             break;
         }
 
+        case sc_int32: {
+            int32_t* a_data = (int32_t*)a;
+            int32_t* out_data = (int32_t*)out;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_map_avx2((const uint8_t*)a, (uint8_t*)out, func, type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_int32, .value.i32=a_data[i]}).value.i32;
+            }
+            break;
+        }
+
+        case sc_int64: {
+            int64_t* a_data = (int64_t*)a;
+            int64_t* out_data = (int64_t*)out;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_map_avx2((const uint8_t*)a, (uint8_t*)out, func, type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_int64, .value.i64=a_data[i]}).value.i64;
+            }
+            break;
+        }
+
+        case sc_uint8: {
+            uint8_t* a_data = (uint8_t*)a;
+            uint8_t* out_data = (uint8_t*)out;
+            uint64_t i = 0;
+
+            if (sc_has_avx2_fma()) {
+                i = int_map_avx2((const uint8_t*)a, (uint8_t*)out, func, type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_uint8, .value.u8=a_data[i]}).value.u8;
+            }
+            break;
+        }
+
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", type);
             return -1;
@@ -521,6 +929,22 @@ int execute_map_args_op(void* a, void* out, sc_value_t (*func)(sc_value_t, void*
             break;
         }
 
+        case sc_half: {
+            uint16_t* a_data = (uint16_t*)a;
+            uint16_t* out_data = (uint16_t*)out;
+            float a_chunk[SC_HALF_CHUNK], out_chunk[SC_HALF_CHUNK];
+
+            for (uint64_t i = 0; i < count; i += SC_HALF_CHUNK) {
+                uint64_t n = half_chunk_count(count, i);
+                sc_convert_half_to_f32(a_data + i, a_chunk, n);
+                if (execute_map_args_op(a_chunk, out_chunk, func, sc_float32, n, args) != 0) {
+                    return -1;
+                }
+                sc_convert_f32_to_half(out_chunk, out_data + i, n);
+            }
+            break;
+        }
+
         case sc_float32: {
             float* a_data = (float*)a;
             float* out_data = (float*)out;
@@ -547,6 +971,54 @@ int execute_map_args_op(void* a, void* out, sc_value_t (*func)(sc_value_t, void*
             break;
         }
 
+        case sc_int32: {
+            int32_t* a_data = (int32_t*)a;
+            int32_t* out_data = (int32_t*)out;
+            uint64_t i = 0;
+
+            int_op op = select_int_args_op(func, type);
+            if (op != int_op_none && sc_has_avx2_fma()) {
+                i = int_op_avx2((const uint8_t*)a, NULL, broadcast_int(*(sc_value_t*)args, type), (uint8_t*)out, op, type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_int32, .value.i32=a_data[i]}, args).value.i32;
+            }
+            break;
+        }
+
+        case sc_int64: {
+            int64_t* a_data = (int64_t*)a;
+            int64_t* out_data = (int64_t*)out;
+            uint64_t i = 0;
+
+            int_op op = select_int_args_op(func, type);
+            if (op != int_op_none && sc_has_avx2_fma()) {
+                i = int_op_avx2((const uint8_t*)a, NULL, broadcast_int(*(sc_value_t*)args, type), (uint8_t*)out, op, type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_int64, .value.i64=a_data[i]}, args).value.i64;
+            }
+            break;
+        }
+
+        case sc_uint8: {
+            uint8_t* a_data = (uint8_t*)a;
+            uint8_t* out_data = (uint8_t*)out;
+            uint64_t i = 0;
+
+            int_op op = select_int_args_op(func, type);
+            if (op != int_op_none && sc_has_avx2_fma()) {
+                i = int_op_avx2((const uint8_t*)a, NULL, broadcast_int(*(sc_value_t*)args, type), (uint8_t*)out, op, type, count);
+            }
+
+            for (; i < count; i++) {
+                out_data[i] = func((sc_value_t){.type=sc_uint8, .value.u8=a_data[i]}, args).value.u8;
+            }
+            break;
+        }
+
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", type);
             return -1;
@@ -556,6 +1028,134 @@ int execute_map_args_op(void* a, void* out, sc_value_t (*func)(sc_value_t, void*
 }
 
 
+// ternary ops: the known element functions have float32 / float64 kernels, the rest goes through func
+typedef enum {
+    ternary_none,
+    ternary_fma,
+    ternary_lerp,
+    ternary_clamp,
+} ternary_kind;
+
+static ternary_kind select_ternary(sc_value_t (*func)(sc_value_t, sc_value_t, sc_value_t)) {
+    if (func == sc_scalar_fma) return ternary_fma;
+    if (func == sc_scalar_lerp) return ternary_lerp;
+    if (func == sc_scalar_clamp) return ternary_clamp;
+    return ternary_none;
+}
+
+#define FMADD_PS_AVX(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#define FMADD_PD_AVX(a, b, c) _mm256_add_pd(_mm256_mul_pd(a, b), c)
+
+// b / c == NULL broadcast the scalars, clamp keeps NaN like sc_scalar_clamp (max / min return their 2nd operand on NaN)
+#define TERNARY_KERNEL(NAME, TARGET, T, VEC, LANES, LOADU, STOREU, SET1, MUL, SUB, MIN, MAX, FMADD)                          \
+    static TARGET uint64_t NAME(const T* a, const T* b, const T* c, T b_scalar, T c_scalar, const T* c_scale,                \
+                                T* out, ternary_kind kind, uint64_t count) {                                                   \
+        VEC y = SET1(b_scalar);                                                                                                \
+        VEC z = SET1(c_scalar);                                                                                                \
+        VEC scale = SET1(c_scale ? *c_scale : (T)1);                                                                           \
+        uint64_t i = 0;                                                                                                        \
+        for (; i + LANES <= count; i += LANES) {                                                                               \
+            VEC x = LOADU(a + i);                                                                                              \
+            if (b) y = LOADU(b + i);                                                                                           \
+            if (c) z = c_scale ? MUL(LOADU(c + i), scale) : LOADU(c + i);                                                      \
+            VEC r;                                                                                                             \
+            if (kind == ternary_fma) r = FMADD(x, y, z);                                                                       \
+            else if (kind == ternary_lerp) r = FMADD(z, SUB(y, x), x);                                                         \
+            else r = MIN(z, MAX(y, x));                                                                                        \
+            STOREU(out + i, r);                                                                                                \
+        }                                                                                                                      \
+        return i;                                                                                                              \
+    }
+
+TERNARY_KERNEL(ternary_avx_f32, , float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_mul_ps, _mm256_sub_ps, _mm256_min_ps, _mm256_max_ps, FMADD_PS_AVX)
+TERNARY_KERNEL(ternary_fma_f32, SC_TARGET_AVX2, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps, _mm256_mul_ps, _mm256_sub_ps, _mm256_min_ps, _mm256_max_ps, _mm256_fmadd_ps)
+TERNARY_KERNEL(ternary_avx_f64, , double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_mul_pd, _mm256_sub_pd, _mm256_min_pd, _mm256_max_pd, FMADD_PD_AVX)
+TERNARY_KERNEL(ternary_fma_f64, SC_TARGET_AVX2, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_mul_pd, _mm256_sub_pd, _mm256_min_pd, _mm256_max_pd, _mm256_fmadd_pd)
+
+#undef TERNARY_KERNEL
+
+int execute_ternary_op(void* a, void* b, void* c, sc_value_t b_scalar, sc_value_t c_scalar, sc_value_t* c_scale, void* out, sc_value_t (*func)(sc_value_t, sc_value_t, sc_value_t), sc_TYPES type, uint64_t count) {
+    ternary_kind kind = select_ternary(func);
+    uint64_t i = 0;
+
+    switch (type) {
+        case sc_float32:
+            if (kind != ternary_none) {
+                const float* scale = c_scale ? &c_scale->value.f32 : NULL;
+                i = sc_has_avx2_fma() ? ternary_fma_f32(a, b, c, b_scalar.value.f32, c_scalar.value.f32, scale, out, kind, count)
+                                      : ternary_avx_f32(a, b, c, b_scalar.value.f32, c_scalar.value.f32, scale, out, kind, count);
+            }
+            break;
+
+        case sc_float64:
+            if (kind != ternary_none) {
+                const double* scale = c_scale ? &c_scale->value.f64 : NULL;
+                i = sc_has_avx2_fma() ? ternary_fma_f64(a, b, c, b_scalar.value.f64, c_scalar.value.f64, scale, out, kind, count)
+                                      : ternary_avx_f64(a, b, c, b_scalar.value.f64, c_scalar.value.f64, scale, out, kind, count);
+            }
+            break;
+
+        case sc_float16:
+        case sc_half: {
+            // 16 bits chunks are widened to float32 and computed by the float32 kernels
+            float a_chunk[SC_HALF_CHUNK], b_chunk[SC_HALF_CHUNK], c_chunk[SC_HALF_CHUNK], out_chunk[SC_HALF_CHUNK];
+            sc_value_t b_f32 = to_sc_value(sc_value_to_f32(b_scalar), sc_float32);
+            sc_value_t c_f32 = to_sc_value(sc_value_to_f32(c_scalar), sc_float32);
+            sc_value_t scale_f32 = c_scale ? to_sc_value(sc_value_to_f32(*c_scale), sc_float32) : (sc_value_t){0};
+            uint16_t* a_data = (uint16_t*)a;
+            uint16_t* b_data = (uint16_t*)b;
+            uint16_t* c_data = (uint16_t*)c;
+            uint16_t* out_data = (uint16_t*)out;
+
+            for (; i < count; i += SC_HALF_CHUNK) {
+                uint64_t n = half_chunk_count(count, i);
+                sc_convert_buffer(a_data + i, type, a_chunk, sc_float32, n);
+                if (b) sc_convert_buffer(b_data + i, type, b_chunk, sc_float32, n);
+                if (c) sc_convert_buffer(c_data + i, type, c_chunk, sc_float32, n);
+                if (execute_ternary_op(a_chunk, b ? b_chunk : NULL, c ? c_chunk : NULL, b_f32, c_f32, c_scale ? &scale_f32 : NULL,
+                                       out_chunk, func, sc_float32, n) != 0) {
+                    return -1;
+                }
+                sc_convert_buffer(out_chunk, sc_float32, out_data + i, type, n);
+            }
+            return 0;
+        }
+
+        default:
+            break;
+    }
+
+    uint64_t size = sc_type_size(type);
+    if (size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", type);
+        return -1;
+    }
+
+    // remaining elements and the other functions / types
+    for (; i < count; i++) {
+        sc_value_t x = {.type = type};
+        sc_value_t y = b_scalar;
+        sc_value_t z = c_scalar;
+        memcpy(&x.value, (uint8_t*)a + i * size, size);
+        if (b) {
+            y = (sc_value_t){.type = type};
+            memcpy(&y.value, (uint8_t*)b + i * size, size);
+        }
+        if (c) {
+            z = (sc_value_t){.type = type};
+            memcpy(&z.value, (uint8_t*)c + i * size, size);
+            if (c_scale) {
+                z = sc_scalar_mul(z, *c_scale);
+            }
+        }
+        sc_value_t r = func(x, y, z);
+        memcpy((uint8_t*)out + i * size, &r.value, size);
+    }
+
+    return 0;
+}
+
+
 // multi thread warpers
 
 int multi_execute_element_wise_op(void* args) {
@@ -572,14 +1172,8 @@ int multi_execute_element_wise_op(void* args) {
     int start_delta = (data->count) / (float)data->thread_count;
     int end_delta = start_delta + data->count % data->thread_count;
     
-    int data_size = 0;
-    if (data->type == sc_float16) {
-        data_size = sizeof(__bf16);
-    } else if (data->type == sc_float32) {
-        data_size = sizeof(float);
-    } else if (data->type == sc_float64) {
-        data_size = sizeof(double);
-    } else {
+    int data_size = (int)sc_type_size(data->type);
+    if (data_size == 0) {
         CCB_ERROR("Unsupported sc_TYPES value %d", data->type);
         return -1;
     }
@@ -618,14 +1212,8 @@ int multi_execute_scalar_element_op(void* args) {
     int start_delta = data->count / data->thread_count;
     int end_delta = start_delta + data->count % data->thread_count;
     
-    int data_size = 0;
-    if (data->type == sc_float16) {
-        data_size = sizeof(__bf16);
-    } else if (data->type == sc_float32) {
-        data_size = sizeof(float);
-    } else if (data->type == sc_float64) {
-        data_size = sizeof(double);
-    } else {
+    int data_size = (int)sc_type_size(data->type);
+    if (data_size == 0) {
         CCB_ERROR("Unsupported sc_TYPES value %d", data->type);
         return -1;
     }
@@ -661,14 +1249,8 @@ int multi_execute_reduce_op(void* args) {
     int start_delta = data->count / data->thread_count;
     int end_delta = start_delta + data->count % data->thread_count;
     
-    int data_size = 0;
-    if (data->type == sc_float16) {
-        data_size = sizeof(__bf16);
-    } else if (data->type == sc_float32) {
-        data_size = sizeof(float);
-    } else if (data->type == sc_float64) {
-        data_size = sizeof(double);
-    } else {
+    int data_size = (int)sc_type_size(data->type);
+    if (data_size == 0) {
         CCB_ERROR("Unsupported sc_TYPES value %d", data->type);
         return -1;
     }
@@ -704,14 +1286,8 @@ int multi_execute_map_op(void* args) {
     int start_delta = data->count / data->thread_count;
     int end_delta = start_delta+ data->count % data->thread_count;
     
-    int data_size = 0;
-    if (data->type == sc_float16) {
-        data_size = sizeof(__bf16);
-    } else if (data->type == sc_float32) {
-        data_size = sizeof(float);
-    } else if (data->type == sc_float64) {
-        data_size = sizeof(double);
-    } else {
+    int data_size = (int)sc_type_size(data->type);
+    if (data_size == 0) {
         CCB_ERROR("Unsupported sc_TYPES value %d", data->type);
         return -1;
     }
@@ -749,14 +1325,8 @@ int multi_execute_map_args_op(void* args) {
     int start_delta = data->count / data->thread_count;
     int end_delta = start_delta+data->count % data->thread_count;
     
-    int data_size = 0;
-    if (data->type == sc_float16) {
-        data_size = sizeof(__bf16);
-    } else if (data->type == sc_float32) {
-        data_size = sizeof(float);
-    } else if (data->type == sc_float64) {
-        data_size = sizeof(double);
-    } else {
+    int data_size = (int)sc_type_size(data->type);
+    if (data_size == 0) {
         CCB_ERROR("Unsupported sc_TYPES value %d", data->type);
         return -1;
     }
@@ -780,6 +1350,61 @@ int multi_execute_map_args_op(void* args) {
 }
 
 
+int multi_execute_ternary_op(void* args) {
+    struct thread_data* data = (struct thread_data*)args;
+
+    CCB_NOTNULL(data, "data is NULL");
+    CCB_NOTNULL(data->a, "a is NULL");
+    CCB_NOTNULL(data->out, "out is NULL");
+    CCB_NOTNULL(data->args, "operands are NULL");
+
+    sc_ternary_operands* operands = (sc_ternary_operands*)data->args;
+    uint64_t data_size = sc_type_size(data->type);
+    if (data_size == 0) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", data->type);
+        return -1;
+    }
+
+    uint64_t start = data->count * data->id / data->thread_count;
+    uint64_t end = data->count * (data->id + 1) / data->thread_count;
+    uint64_t offset = start * data_size;
+
+    void* b = data->b ? (uint8_t*)data->b + offset : NULL;
+    void* c = operands->c ? (uint8_t*)operands->c->data + offset : NULL;
+    uint64_t return_code = execute_ternary_op((uint8_t*)data->a + offset, b, c, operands->b_scalar, operands->c_scalar, operands->c_scale,
+                                              (uint8_t*)data->out + offset, data->func.scalar_func_ternary, data->type, end - start);
+
+    if (return_code == 0) {
+        lock_mutex(data->mutex);
+        data->succes++;
+        unlock_mutex(data->mutex);
+    }
+
+    return return_code;
+}
+
+
+int multi_execute_range_op(void* args) {
+    struct thread_data* data = (struct thread_data*)args;
+
+    CCB_NOTNULL(data, "data is NULL");
+
+    // balanced split, the blocks differ by at most one unit
+    uint64_t start = data->count * data->id / data->thread_count;
+    uint64_t end = data->count * (data->id + 1) / data->thread_count;
+
+    uint64_t return_code = data->func.range_func(data->args, start, end, data->id);
+
+    if (return_code == 0) {
+        lock_mutex(data->mutex);
+        data->succes++;
+        unlock_mutex(data->mutex);
+    }
+
+    return return_code;
+}
+
+
 // engine functions
 sc_task_result* execute_single_thread(sc_task* task, sc_task_result* out) {
     
@@ -789,8 +1414,19 @@ sc_task_result* execute_single_thread(sc_task* task, sc_task_result* out) {
     sc_TYPES type;
 
     out->succes = 0;
-    CCB_NOTNULL(task->a, "task->a is NULL");
     CCB_NOTNULL(task->task_func.scalar_func, "task->task_func is NULL");
+
+    if (task->op_type == sc_range_op) {
+        if (task->task_func.range_func(task->args, 0, task->opration_count, 0) != 0) {
+            CCB_ERROR("Failed to execute operation");
+            return out;
+        }
+
+        out->succes = 1;
+        return out;
+    }
+
+    CCB_NOTNULL(task->a, "task->a is NULL");
     
     
     switch (task->data_type) {
@@ -849,6 +1485,15 @@ sc_task_result* execute_single_thread(sc_task* task, sc_task_result* out) {
             out_code = execute_map_args_op(a, out_data, task->task_func.scalar_func_map_args, type, task->opration_count, task->args);
             break;
 
+        case sc_ternary_op: {
+            CCB_NOTNULL(task->out, "task->out is NULL for ternary operation");
+            CCB_NOTNULL(task->args, "task->args is NULL for ternary operation");
+            sc_ternary_operands* operands = (sc_ternary_operands*)task->args;
+            void* c = operands->c ? operands->c->data : NULL;
+            out_code = execute_ternary_op(a, b, c, operands->b_scalar, operands->c_scalar, operands->c_scale, out_data, task->task_func.scalar_func_ternary, type, task->opration_count);
+            break;
+        }
+
         default:
             CCB_ERROR("Unsupported sc_TYPES value %d", task->op_type);
             return out;
@@ -899,7 +1544,13 @@ sc_task_result* execute_multi_thread(sc_task* task, sc_task_result* out) {
     out->succes = 0;
 
     // retreive data
-    switch (task->data_type) {
+    switch (task->op_type == sc_range_op ? -1 : task->data_type) {
+        case -1:
+            // range tasks only forward their args
+            type = sc_float32;
+            data_type = task->data_type;
+            break;
+
 
         case sc_vector_type:
             a = ((sc_vector*)task->a)->data;
@@ -957,31 +1608,43 @@ sc_task_result* execute_multi_thread(sc_task* task, sc_task_result* out) {
             case sc_element_wise_op:
                 thread_controls[i].task_data = &data[i];
                 thread_controls[i].task_fn = multi_execute_element_wise_op;
-                unlock_mutex(thread_controls[i].wait_mutex);
+                post_semaphore(thread_controls[i].start_semaphore);
                 break;
 
             case sc_element_scalar_op:
                 thread_controls[i].task_data = &data[i];
                 thread_controls[i].task_fn = multi_execute_scalar_element_op;
-                unlock_mutex(thread_controls[i].wait_mutex);
+                post_semaphore(thread_controls[i].start_semaphore);
                 break;
 
             case sc_reduce_op:
                 thread_controls[i].task_data = &data[i];
                 thread_controls[i].task_fn = multi_execute_reduce_op;
-                unlock_mutex(thread_controls[i].wait_mutex);
+                post_semaphore(thread_controls[i].start_semaphore);
                 break;
 
             case sc_map_op:
                 thread_controls[i].task_data = &data[i];
                 thread_controls[i].task_fn = multi_execute_map_op;
-                unlock_mutex(thread_controls[i].wait_mutex);
+                post_semaphore(thread_controls[i].start_semaphore);
                 break;
 
             case sc_map_args_op:
                 thread_controls[i].task_data = &data[i];
                 thread_controls[i].task_fn = multi_execute_map_args_op;
-                unlock_mutex(thread_controls[i].wait_mutex);
+                post_semaphore(thread_controls[i].start_semaphore);
+                break;
+
+            case sc_ternary_op:
+                thread_controls[i].task_data = &data[i];
+                thread_controls[i].task_fn = multi_execute_ternary_op;
+                post_semaphore(thread_controls[i].start_semaphore);
+                break;
+
+            case sc_range_op:
+                thread_controls[i].task_data = &data[i];
+                thread_controls[i].task_fn = multi_execute_range_op;
+                post_semaphore(thread_controls[i].start_semaphore);
                 break;
 
             default:
@@ -991,14 +1654,11 @@ sc_task_result* execute_multi_thread(sc_task* task, sc_task_result* out) {
     }
 
     for (uint64_t i = 0; i < thread_count; i++) {
-        lock_mutex(thread_controls[i].wait_mutex);
+        wait_semaphore(thread_controls[i].done_semaphore);
     }
 
     int rate = 0;
     for (uint64_t i = 0; i < thread_count; i++) {
-        lock_mutex(thread_controls[i].run_mutex);
-        unlock_mutex(thread_controls[i].run_mutex);
-
         if (thread_controls[i].return_value != 0) {
             CCB_ERROR("Failed to join thread %d", i);
             out->succes = 0;
@@ -1022,7 +1682,10 @@ sc_task_result* execute_multi_thread(sc_task* task, sc_task_result* out) {
         }
     }
 
-    switch (task->data_type) {
+    switch (task->op_type == sc_range_op ? -1 : task->data_type) {
+        case -1:
+            break;
+
         case sc_vector_type:
             if (task->op_type != sc_reduce_op){
                 ((sc_vector*)task->out)->data = out_data;
@@ -1097,3 +1760,115 @@ sc_task_result* sc_execute_task(sc_task* task, sc_execution_mode mode, sc_task_r
     }
 }
  
+
+
+uint64_t sc_get_engine_thread_count(void) {
+    return (uint64_t)get_cpu_count();
+}
+
+
+uint64_t sc_get_llc_size(void) {
+    static uint64_t size = 0;
+    if (size == 0) {
+        size = get_llc_size();
+    }
+    return size;
+}
+
+
+sc_execution_mode sc_select_execution_mode(uint64_t element_count) {
+    if (element_count > MULTITHRAD_OPRATION_TRESHOLD) {
+        return sc_multi_thread;
+    }
+    return sc_single_thread;
+}
+
+
+int sc_run_range_task(int (*func)(void*, uint64_t, uint64_t, uint64_t), void* args, uint64_t count, uint64_t element_count, ccb_arena* arena) {
+    if (count == 0) {
+        return 0;
+    }
+
+    sc_task* task = sc_create_range_task(func, args, count, arena);
+
+    sc_task_result out;
+    sc_execute_task(task, sc_select_execution_mode(element_count), &out, arena);
+
+    if (!out.succes) {
+        CCB_ERROR("Failed to execute range task");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+// mixed types element wise ops
+#define SC_MIXED_CHUNK 512
+
+typedef struct {
+    const uint8_t* a;
+    const uint8_t* b;
+    uint8_t* out;
+    sc_TYPES a_type;
+    sc_TYPES b_type;
+    sc_TYPES out_type;
+    sc_value_t scalar;
+    sc_value_t (*func)(sc_value_t, sc_value_t);
+    uint64_t count;
+} mixed_args;
+
+// the range is in chunks so that every thread converts whole chunks
+static int mixed_kernel(void* args, uint64_t start_chunk, uint64_t end_chunk, uint64_t thread_id) {
+    (void)thread_id;
+    mixed_args* m = (mixed_args*)args;
+    uint64_t start = start_chunk * SC_MIXED_CHUNK;
+    uint64_t end = (end_chunk * SC_MIXED_CHUNK < m->count) ? end_chunk * SC_MIXED_CHUNK : m->count;
+    uint64_t a_size = sc_type_size(m->a_type);
+    uint64_t b_size = sc_type_size(m->b_type);
+    uint64_t out_size = sc_type_size(m->out_type);
+
+    // one chunk of each operand in the output type, small enough to stay in L1 between the cast and the op
+    double a_chunk[SC_MIXED_CHUNK], b_chunk[SC_MIXED_CHUNK];
+
+    for (uint64_t i = start; i < end; i += SC_MIXED_CHUNK) {
+        uint64_t n = (end - i < SC_MIXED_CHUNK) ? end - i : SC_MIXED_CHUNK;
+        void* a = (void*)(m->a + i * a_size);
+        void* out = m->out + i * out_size;
+
+        if (m->a_type != m->out_type) {
+            if (sc_convert_buffer(a, m->a_type, a_chunk, m->out_type, n) != 0) {
+                return -1;
+            }
+            a = a_chunk;
+        }
+
+        int status;
+        if (m->b == NULL) {
+            status = execute_scalar_element_op(a, m->scalar, out, m->func, m->out_type, n);
+        } else {
+            void* b = (void*)(m->b + i * b_size);
+            if (m->b_type != m->out_type) {
+                if (sc_convert_buffer(b, m->b_type, b_chunk, m->out_type, n) != 0) {
+                    return -1;
+                }
+                b = b_chunk;
+            }
+            status = execute_element_wise_op(a, b, out, m->func, m->out_type, n);
+        }
+        if (status != 0) {
+            return status;
+        }
+    }
+    return 0;
+}
+
+int sc_run_mixed_element_wise_task(void* a, sc_TYPES a_type, void* b, sc_TYPES b_type, sc_value_t scalar, void* out, sc_TYPES out_type, sc_value_t (*func)(sc_value_t, sc_value_t), uint64_t count, ccb_arena* arena) {
+    if (sc_type_size(a_type) == 0 || sc_type_size(b_type) == 0 || sc_type_size(out_type) == 0) {
+        CCB_ERROR("Unsupported types for a mixed operation: %d, %d -> %d", a_type, b_type, out_type);
+        return -1;
+    }
+
+    mixed_args args = {a, b, out, a_type, b_type, out_type, sc_value_as(scalar, out_type), func, count};
+    return sc_run_range_task(mixed_kernel, &args, (count + SC_MIXED_CHUNK - 1) / SC_MIXED_CHUNK, count, arena);
+}
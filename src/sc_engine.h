@@ -11,6 +11,8 @@
 /*
     the scandium execution engine
     it handels multithreading and the execution pipline
+    sc_half data is widened to float32 in small chunks, so the element functions receive float32 values
+    (reductions accumulate in float32) and the results are stored back as half precision
 */
 
 typedef enum {
@@ -23,7 +25,9 @@ typedef enum {
     sc_element_scalar_op,
     sc_reduce_op,
     sc_map_op,
-    sc_map_args_op
+    sc_map_args_op,
+    sc_ternary_op,
+    sc_range_op
 } sc_engine_op_type;
 
 typedef enum {
@@ -36,8 +40,22 @@ typedef union {
     sc_value_t (*scalar_func)(sc_value_t, sc_value_t);
     sc_value_t (*scalar_func_map)(sc_value_t);
     sc_value_t (*scalar_func_map_args)(sc_value_t, void*);
+    sc_value_t (*scalar_func_ternary)(sc_value_t, sc_value_t, sc_value_t);
+    int (*range_func)(void* args, uint64_t start, uint64_t end, uint64_t thread_id);
 } sc_engine_func;
 
+/*
+    operands of a ternary task out = func(a, b, c), passed as the task args
+    b (the task b) and c can be NULL, func then receives b_scalar / c_scalar for every element,
+    when c_scale is set c is multiplied by it before func (beta of axpby)
+    sc_scalar_fma, sc_scalar_lerp and sc_scalar_clamp have float32 / float64 SIMD kernels (FMA when available)
+*/
+typedef struct {
+    sc_vector* c;
+    sc_value_t b_scalar;
+    sc_value_t c_scalar;
+    sc_value_t* c_scale;
+} sc_ternary_operands;
 
 
 typedef struct {
@@ -69,9 +87,43 @@ sc_task* sc_create_task(sc_engine_data_type data_type, sc_engine_op_type op_type
 #define sc_create_vector_reduce_task(a, scalar, func, count, arena) sc_create_task(sc_vector_type, sc_reduce_op, a, NULL, NULL, scalar, NULL, (sc_engine_func){.scalar_func=func}, count, arena)
 #define sc_create_vector_map_task(a, out, func, count, arena) sc_create_task(sc_vector_type, sc_map_op, a, NULL, out, (sc_value_t){0}, NULL, (sc_engine_func){.scalar_func_map=func}, count, arena)
 #define sc_create_vector_map_args_task(a, out, func, args, count, arena) sc_create_task(sc_vector_type, sc_map_args_op, a, NULL, out, (sc_value_t){0}, args, (sc_engine_func){.scalar_func_map_args=func}, count, arena)
+#define sc_create_vector_ternary_task(a, b, operands, out, func, count, arena) sc_create_task(sc_vector_type, sc_ternary_op, a, b, out, (sc_value_t){0}, operands, (sc_engine_func){.scalar_func_ternary=func}, count, arena)
+
+/*
+    range tasks split [0, count) in contiguous blocks, one per thread, and call func(args, start, end, thread_id)
+    it is the entry point for kernels that are not element wise (rows of a tensor, tiles, segments, ...)
+    thread_id is always lower than sc_get_engine_thread_count(), it can be used to index per thread scratch
+*/
+#define sc_create_range_task(func, args, count, arena) sc_create_task(sc_vector_type, sc_range_op, NULL, NULL, NULL, (sc_value_t){0}, args, (sc_engine_func){.range_func=func}, count, arena)
 
 sc_task_result* sc_execute_task(sc_task* task, sc_execution_mode mode, sc_task_result* result, ccb_arena* arena);
 
+/*
+    maximum number of threads used by a multi thread task
+*/
+uint64_t sc_get_engine_thread_count(void);
+/*
+    size in bytes of the last level cache, kernels writing more than this use streaming stores
+*/
+uint64_t sc_get_llc_size(void);
+/*
+    pick the execution mode of a task from the number of elements it touches
+    (the opration_count of range tasks counts rows or tiles, not elements)
+*/
+sc_execution_mode sc_select_execution_mode(uint64_t element_count);
+/*
+    create and execute a range task, the execution mode is selected from element_count
+    return 0 on success
+*/
+int sc_run_range_task(int (*func)(void*, uint64_t, uint64_t, uint64_t), void* args, uint64_t count, uint64_t element_count, ccb_arena* arena);
+/*
+    element wise op between operands of different types, computed in out_type (b = NULL for an op with scalar)
+    the operands are converted in chunks that stay in L1 right before the op, no casted copy is allocated
+    out can alias an operand of type out_type
+    return 0 on success
+*/
+int sc_run_mixed_element_wise_task(void* a, sc_TYPES a_type, void* b, sc_TYPES b_type, sc_value_t scalar, void* out, sc_TYPES out_type, sc_value_t (*func)(sc_value_t, sc_value_t), uint64_t count, ccb_arena* arena);
+
 
 
 
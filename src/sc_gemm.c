@@ -0,0 +1,430 @@
+#include "data.h"
+#include "sc_gemm.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/*
+    BLIS like blocking: C is split in MC x NC tiles, each tile loops over K in KC blocks,
+    packs the A block (MC x KC, L2) and the B block (KC x NC, L3) in micro panels and the
+    micro kernel computes MR x NR of the tile accumulator with the whole micro panel of B in L1
+    the accumulator is always float32 / float64 so bfloat16 outputs are only rounded once
+*/
+#define GEMM_MR 6
+#define GEMM_NR_F32 16
+#define GEMM_NR_F64 8
+#define GEMM_KC 256
+#define GEMM_MC 96
+#define GEMM_NC 512
+#define GEMM_ALIGN 64
+
+#define GEMM_PACK_A_SIZE (GEMM_MC * GEMM_KC * sizeof(double))
+#define GEMM_PACK_B_SIZE (GEMM_KC * GEMM_NC * sizeof(double))
+#define GEMM_ACC_SIZE (GEMM_MC * GEMM_NC * sizeof(double))
+
+
+struct gemm_scratch {
+    void* pack_a;
+    void* pack_b;
+    void* acc;
+};
+
+struct gemm_args {
+    const sc_gemm_desc* desc;
+    uint64_t mc;
+    uint64_t nc;
+    uint64_t n_tiles;
+    uint8_t* scratch;
+};
+
+
+// ###########
+// micro kernels
+// ###########
+
+typedef void (*micro_kernel_f32)(uint64_t kc, const float* a, const float* b, float* c, uint64_t ldc, int first);
+typedef void (*micro_kernel_f64)(uint64_t kc, const double* a, const double* b, double* c, uint64_t ldc, int first);
+
+#define MADD_PS_AVX(acc, a, b) _mm256_add_ps(acc, _mm256_mul_ps(a, b))
+#define MADD_PS_FMA(acc, a, b) _mm256_fmadd_ps(a, b, acc)
+#define MADD_PD_AVX(acc, a, b) _mm256_add_pd(acc, _mm256_mul_pd(a, b))
+#define MADD_PD_FMA(acc, a, b) _mm256_fmadd_pd(a, b, acc)
+
+// 6 x 16 float32 block, 12 accumulators + 2 rows of B + 1 broadcast fit in the 16 ymm registers
+#define DEFINE_MICRO_KERNEL_F32(name, madd) \
+static void name(uint64_t kc, const float* a, const float* b, float* c, uint64_t ldc, int first) { \
+    __m256 acc[GEMM_MR][2]; \
+    _Pragma("GCC unroll 6") \
+    for (int r = 0; r < GEMM_MR; r++) { \
+        acc[r][0] = first ? _mm256_setzero_ps() : _mm256_loadu_ps(c + r * ldc); \
+        acc[r][1] = first ? _mm256_setzero_ps() : _mm256_loadu_ps(c + r * ldc + 8); \
+    } \
+    for (uint64_t k = 0; k < kc; k++) { \
+        __m256 b0 = _mm256_load_ps(b); \
+        __m256 b1 = _mm256_load_ps(b + 8); \
+        _Pragma("GCC unroll 6") \
+        for (int r = 0; r < GEMM_MR; r++) { \
+            __m256 ar = _mm256_broadcast_ss(a + r); \
+            acc[r][0] = madd(acc[r][0], ar, b0); \
+            acc[r][1] = madd(acc[r][1], ar, b1); \
+        } \
+        a += GEMM_MR; \
+        b += GEMM_NR_F32; \
+    } \
+    _Pragma("GCC unroll 6") \
+    for (int r = 0; r < GEMM_MR; r++) { \
+        _mm256_storeu_ps(c + r * ldc, acc[r][0]); \
+        _mm256_storeu_ps(c + r * ldc + 8, acc[r][1]); \
+    } \
+}
+
+// 6 x 8 float64 block
+#define DEFINE_MICRO_KERNEL_F64(name, madd) \
+static void name(uint64_t kc, const double* a, const double* b, double* c, uint64_t ldc, int first) { \
+    __m256d acc[GEMM_MR][2]; \
+    _Pragma("GCC unroll 6") \
+    for (int r = 0; r < GEMM_MR; r++) { \
+        acc[r][0] = first ? _mm256_setzero_pd() : _mm256_loadu_pd(c + r * ldc); \
+        acc[r][1] = first ? _mm256_setzero_pd() : _mm256_loadu_pd(c + r * ldc + 4); \
+    } \
+    for (uint64_t k = 0; k < kc; k++) { \
+        __m256d b0 = _mm256_load_pd(b); \
+        __m256d b1 = _mm256_load_pd(b + 4); \
+        _Pragma("GCC unroll 6") \
+        for (int r = 0; r < GEMM_MR; r++) { \
+            __m256d ar = _mm256_broadcast_sd(a + r); \
+            acc[r][0] = madd(acc[r][0], ar, b0); \
+            acc[r][1] = madd(acc[r][1], ar, b1); \
+        } \
+        a += GEMM_MR; \
+        b += GEMM_NR_F64; \
+    } \
+    _Pragma("GCC unroll 6") \
+    for (int r = 0; r < GEMM_MR; r++) { \
+        _mm256_storeu_pd(c + r * ldc, acc[r][0]); \
+        _mm256_storeu_pd(c + r * ldc + 4, acc[r][1]); \
+    } \
+}
+
+DEFINE_MICRO_KERNEL_F32(micro_f32_avx, MADD_PS_AVX)
+DEFINE_MICRO_KERNEL_F64(micro_f64_avx, MADD_PD_AVX)
+SC_TARGET_AVX2 DEFINE_MICRO_KERNEL_F32(micro_f32_fma, MADD_PS_FMA)
+SC_TARGET_AVX2 DEFINE_MICRO_KERNEL_F64(micro_f64_fma, MADD_PD_FMA)
+
+
+// #######
+// helpers
+// #######
+
+static inline double load_f64(const void* base, int64_t index, sc_TYPES type) {
+    switch (type) {
+        case sc_float64: return ((const double*)base)[index];
+        case sc_float32: return ((const float*)base)[index];
+        default: return sc_bf16_bits_to_f32(((const uint16_t*)base)[index]);
+    }
+}
+
+static inline void store_f64(void* base, int64_t index, double value, sc_TYPES type) {
+    switch (type) {
+        case sc_float64: ((double*)base)[index] = value; break;
+        case sc_float32: ((float*)base)[index] = (float)value; break;
+        default: ((uint16_t*)base)[index] = sc_f32_to_bf16_bits((float)value); break;
+    }
+}
+
+static int is_f64_product(const sc_gemm_desc* desc) {
+    return desc->a_type == sc_float64 || desc->b_type == sc_float64 || desc->c_type == sc_float64;
+}
+
+static int check_type(sc_TYPES type) {
+    return type == sc_float16 || type == sc_float32 || type == sc_float64;
+}
+
+static uint64_t round_up(uint64_t value, uint64_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+static struct gemm_scratch split_scratch(void* raw) {
+    uintptr_t base = ((uintptr_t)raw + GEMM_ALIGN - 1) & ~(uintptr_t)(GEMM_ALIGN - 1);
+    struct gemm_scratch scratch;
+    scratch.pack_a = (void*)base;
+    scratch.pack_b = (void*)(base + GEMM_PACK_A_SIZE);
+    scratch.acc = (void*)(base + GEMM_PACK_A_SIZE + GEMM_PACK_B_SIZE);
+    return scratch;
+}
+
+
+// #######
+// packing
+// #######
+
+// A block [i0, i0 + mc) x [p0, p0 + kc) in micro panels of MR rows, k major, missing rows are zero
+#define DEFINE_PACK_A(name, T, load) \
+static void name(const sc_gemm_desc* d, uint64_t i0, uint64_t p0, uint64_t mc, uint64_t kc, T* dst) { \
+    for (uint64_t ir = 0; ir < mc; ir += GEMM_MR) { \
+        T* panel = dst + ir * kc; \
+        for (uint64_t r = 0; r < GEMM_MR; r++) { \
+            if (ir + r >= mc) { \
+                for (uint64_t k = 0; k < kc; k++) panel[k * GEMM_MR + r] = 0; \
+                continue; \
+            } \
+            int64_t row = (int64_t)(i0 + ir + r) * d->a_row_stride + (int64_t)p0 * d->a_col_stride; \
+            for (uint64_t k = 0; k < kc; k++) { \
+                panel[k * GEMM_MR + r] = (T)load(d->a, row + (int64_t)k * d->a_col_stride, d->a_type); \
+            } \
+        } \
+    } \
+}
+
+// B block [p0, p0 + kc) x [j0, j0 + nc) in micro panels of NR columns, k major, missing columns are zero
+#define DEFINE_PACK_B(name, T, NR, load) \
+static void name(const sc_gemm_desc* d, uint64_t p0, uint64_t j0, uint64_t kc, uint64_t nc, T* dst) { \
+    for (uint64_t jr = 0; jr < nc; jr += NR) { \
+        T* panel = dst + jr * kc; \
+        uint64_t cols = (nc - jr < NR) ? nc - jr : NR; \
+        for (uint64_t k = 0; k < kc; k++) { \
+            int64_t row = (int64_t)(p0 + k) * d->b_row_stride + (int64_t)(j0 + jr) * d->b_col_stride; \
+            T* out = panel + k * NR; \
+            if (cols == NR && d->b_col_stride == 1 && d->b_type == (sizeof(T) == sizeof(float) ? sc_float32 : sc_float64)) { \
+                memcpy(out, (const T*)d->b + row, NR * sizeof(T)); \
+                continue; \
+            } \
+            for (uint64_t c = 0; c < cols; c++) out[c] = (T)load(d->b, row + (int64_t)c * d->b_col_stride, d->b_type); \
+            for (uint64_t c = cols; c < NR; c++) out[c] = 0; \
+        } \
+    } \
+}
+
+static inline float load_f32(const void* base, int64_t index, sc_TYPES type) {
+    return sc_load_f32(base, (uint64_t)index, type);
+}
+
+DEFINE_PACK_A(pack_a_f32, float, load_f32)
+DEFINE_PACK_B(pack_b_f32, float, GEMM_NR_F32, load_f32)
+DEFINE_PACK_A(pack_a_f64, double, load_f64)
+DEFINE_PACK_B(pack_b_f64, double, GEMM_NR_F64, load_f64)
+
+
+// #####
+// tiles
+// #####
+
+static void gemm_tile_f32(const sc_gemm_desc* d, uint64_t i0, uint64_t j0, uint64_t mc, uint64_t nc, struct gemm_scratch* s) {
+    float* pack_a = (float*)s->pack_a;
+    float* pack_b = (float*)s->pack_b;
+    float* acc = (float*)s->acc;
+    micro_kernel_f32 kernel = sc_has_avx2_fma() ? micro_f32_fma : micro_f32_avx;
+
+    if (d->k == 0) {
+        memset(acc, 0, GEMM_MC * GEMM_NC * sizeof(float));
+    }
+
+    for (uint64_t p0 = 0; p0 < d->k; p0 += GEMM_KC) {
+        uint64_t kc = (d->k - p0 < GEMM_KC) ? d->k - p0 : GEMM_KC;
+        pack_b_f32(d, p0, j0, kc, nc, pack_b);
+        pack_a_f32(d, i0, p0, mc, kc, pack_a);
+
+        for (uint64_t jr = 0; jr < nc; jr += GEMM_NR_F32) {
+            for (uint64_t ir = 0; ir < mc; ir += GEMM_MR) {
+                kernel(kc, pack_a + ir * kc, pack_b + jr * kc, acc + ir * GEMM_NC + jr, GEMM_NC, p0 == 0);
+            }
+        }
+    }
+
+    float alpha = (float)d->alpha;
+    float beta = (float)d->beta;
+    for (uint64_t i = 0; i < mc; i++) {
+        int64_t row = (int64_t)(i0 + i) * d->c_row_stride + (int64_t)j0 * d->c_col_stride;
+        for (uint64_t j = 0; j < nc; j++) {
+            int64_t index = row + (int64_t)j * d->c_col_stride;
+            float value = alpha * acc[i * GEMM_NC + j];
+            if (beta != 0.0f) {
+                value += beta * sc_load_f32(d->c, (uint64_t)index, d->c_type);
+            }
+            sc_store_f32(d->c, (uint64_t)index, value, d->c_type);
+        }
+    }
+}
+
+
+static void gemm_tile_f64(const sc_gemm_desc* d, uint64_t i0, uint64_t j0, uint64_t mc, uint64_t nc, struct gemm_scratch* s) {
+    double* pack_a = (double*)s->pack_a;
+    double* pack_b = (double*)s->pack_b;
+    double* acc = (double*)s->acc;
+    micro_kernel_f64 kernel = sc_has_avx2_fma() ? micro_f64_fma : micro_f64_avx;
+
+    if (d->k == 0) {
+        memset(acc, 0, GEMM_MC * GEMM_NC * sizeof(double));
+    }
+
+    for (uint64_t p0 = 0; p0 < d->k; p0 += GEMM_KC) {
+        uint64_t kc = (d->k - p0 < GEMM_KC) ? d->k - p0 : GEMM_KC;
+        pack_b_f64(d, p0, j0, kc, nc, pack_b);
+        pack_a_f64(d, i0, p0, mc, kc, pack_a);
+
+        for (uint64_t jr = 0; jr < nc; jr += GEMM_NR_F64) {
+            for (uint64_t ir = 0; ir < mc; ir += GEMM_MR) {
+                kernel(kc, pack_a + ir * kc, pack_b + jr * kc, acc + ir * GEMM_NC + jr, GEMM_NC, p0 == 0);
+            }
+        }
+    }
+
+    for (uint64_t i = 0; i < mc; i++) {
+        int64_t row = (int64_t)(i0 + i) * d->c_row_stride + (int64_t)j0 * d->c_col_stride;
+        for (uint64_t j = 0; j < nc; j++) {
+            int64_t index = row + (int64_t)j * d->c_col_stride;
+            double value = d->alpha * acc[i * GEMM_NC + j];
+            if (d->beta != 0.0) {
+                value += d->beta * load_f64(d->c, index, d->c_type);
+            }
+            store_f64(d->c, index, value, d->c_type);
+        }
+    }
+}
+
+
+static void gemm_tile(const sc_gemm_desc* d, uint64_t i0, uint64_t j0, uint64_t mc, uint64_t nc, struct gemm_scratch* s) {
+    if (is_f64_product(d)) {
+        gemm_tile_f64(d, i0, j0, mc, nc, s);
+    } else {
+        gemm_tile_f32(d, i0, j0, mc, nc, s);
+    }
+}
+
+
+static int gemm_range_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct gemm_args* args = (struct gemm_args*)raw;
+    const sc_gemm_desc* d = args->desc;
+    struct gemm_scratch scratch = split_scratch(args->scratch + thread_id * sc_gemm_scratch_size());
+
+    for (uint64_t t = start; t < end; t++) {
+        uint64_t i0 = (t / args->n_tiles) * args->mc;
+        uint64_t j0 = (t % args->n_tiles) * args->nc;
+        uint64_t mc = (d->m - i0 < args->mc) ? d->m - i0 : args->mc;
+        uint64_t nc = (d->n - j0 < args->nc) ? d->n - j0 : args->nc;
+        gemm_tile(d, i0, j0, mc, nc, &scratch);
+    }
+    return 0;
+}
+
+
+static int check_desc(const sc_gemm_desc* desc) {
+    CCB_NOTNULL(desc, "desc is NULL");
+    if (!check_type(desc->a_type) || !check_type(desc->b_type) || !check_type(desc->c_type)) {
+        CCB_ERROR("Unsupported gemm types %d %d %d", desc->a_type, desc->b_type, desc->c_type);
+        return -1;
+    }
+    if (desc->m * desc->n != 0 && desc->c == NULL) {
+        CCB_ERROR("gemm output is NULL");
+        return -1;
+    }
+    if (desc->m * desc->n * desc->k != 0 && (desc->a == NULL || desc->b == NULL)) {
+        CCB_ERROR("gemm operand is NULL");
+        return -1;
+    }
+    return 0;
+}
+
+
+// #######
+// api
+// #######
+
+sc_gemm_desc sc_gemm_row_major(uint64_t m, uint64_t n, uint64_t k,
+                               const void* a, sc_TYPES a_type, int trans_a,
+                               const void* b, sc_TYPES b_type, int trans_b,
+                               void* c, sc_TYPES c_type, double alpha, double beta) {
+    sc_gemm_desc desc;
+    desc.m = m;
+    desc.n = n;
+    desc.k = k;
+
+    // A is stored m x k, or k x m when transposed
+    desc.a = a;
+    desc.a_type = a_type;
+    desc.a_row_stride = trans_a ? 1 : (int64_t)k;
+    desc.a_col_stride = trans_a ? (int64_t)m : 1;
+
+    // B is stored k x n, or n x k when transposed
+    desc.b = b;
+    desc.b_type = b_type;
+    desc.b_row_stride = trans_b ? 1 : (int64_t)n;
+    desc.b_col_stride = trans_b ? (int64_t)k : 1;
+
+    desc.c = c;
+    desc.c_type = c_type;
+    desc.c_row_stride = (int64_t)n;
+    desc.c_col_stride = 1;
+
+    desc.alpha = alpha;
+    desc.beta = beta;
+    return desc;
+}
+
+
+uint64_t sc_gemm_scratch_size(void) {
+    return GEMM_PACK_A_SIZE + GEMM_PACK_B_SIZE + GEMM_ACC_SIZE + GEMM_ALIGN;
+}
+
+
+int sc_gemm_serial(const sc_gemm_desc* desc, void* scratch) {
+    if (check_desc(desc) != 0) {
+        return -1;
+    }
+    CCB_NOTNULL(scratch, "scratch is NULL");
+
+    struct gemm_scratch split = split_scratch(scratch);
+    for (uint64_t i0 = 0; i0 < desc->m; i0 += GEMM_MC) {
+        for (uint64_t j0 = 0; j0 < desc->n; j0 += GEMM_NC) {
+            uint64_t mc = (desc->m - i0 < GEMM_MC) ? desc->m - i0 : GEMM_MC;
+            uint64_t nc = (desc->n - j0 < GEMM_NC) ? desc->n - j0 : GEMM_NC;
+            gemm_tile(desc, i0, j0, mc, nc, &split);
+        }
+    }
+    return 0;
+}
+
+
+int sc_gemm(const sc_gemm_desc* desc, ccb_arena* arena) {
+    if (check_desc(desc) != 0) {
+        return -1;
+    }
+    CCB_NOTNULL(arena, "arena is NULL");
+
+    if (desc->m == 0 || desc->n == 0) {
+        return 0;
+    }
+
+    // shrink the tiles until every thread has work, the packing overhead stays small down to 64 x 12
+    uint64_t threads = sc_get_engine_thread_count();
+    uint64_t mc = GEMM_MC;
+    uint64_t nc = GEMM_NC;
+    while (((desc->m + mc - 1) / mc) * ((desc->n + nc - 1) / nc) < threads && nc > 64) {
+        nc /= 2;
+    }
+    while (((desc->m + mc - 1) / mc) * ((desc->n + nc - 1) / nc) < threads && mc > 2 * GEMM_MR) {
+        mc = round_up(mc / 2, GEMM_MR);
+    }
+
+    struct gemm_args args;
+    args.desc = desc;
+    args.mc = mc;
+    args.nc = nc;
+    args.n_tiles = (desc->n + nc - 1) / nc;
+    uint64_t tiles = ((desc->m + mc - 1) / mc) * args.n_tiles;
+
+    args.scratch = (uint8_t*)ccb_arena_malloc(arena, threads * sc_gemm_scratch_size());
+    CCB_NOTNULL(args.scratch, "Failed to allocate gemm scratch");
+
+    uint64_t work = desc->m * desc->n * (desc->k + 1);
+    if (sc_run_range_task(gemm_range_kernel, &args, tiles, work, arena) != 0) {
+        CCB_ERROR("Failed to run gemm task");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef __SC_GEMM_H__
+#define __SC_GEMM_H__
+
+#include <stdint.h>
+#include "data.h"
+#include "ccbase/utils/mem.h"
+
+/*
+    blocked matrix multiplication C = alpha * A.B + beta * C
+    A is m x k, B is k x n and C is m x n, each operand is described by its type and strides (in elements)
+    so transposed or strided views are multiplied without copies
+    float32 and bfloat16 operands are computed in float32, as soon as one operand is float64 the product is
+    computed in float64
+*/
+
+typedef struct {
+    uint64_t m;
+    uint64_t n;
+    uint64_t k;
+
+    const void* a;
+    sc_TYPES a_type;
+    int64_t a_row_stride;
+    int64_t a_col_stride;
+
+    const void* b;
+    sc_TYPES b_type;
+    int64_t b_row_stride;
+    int64_t b_col_stride;
+
+    void* c;
+    sc_TYPES c_type;
+    int64_t c_row_stride;
+    int64_t c_col_stride;
+
+    double alpha;
+    double beta;
+} sc_gemm_desc;
+
+
+// fill a descriptor for row major operands, trans_a / trans_b multiply by the transposed matrix
+sc_gemm_desc sc_gemm_row_major(uint64_t m, uint64_t n, uint64_t k,
+                               const void* a, sc_TYPES a_type, int trans_a,
+                               const void* b, sc_TYPES b_type, int trans_b,
+                               void* c, sc_TYPES c_type, double alpha, double beta);
+
+/*
+    size in bytes of the scratch needed by sc_gemm_serial
+*/
+uint64_t sc_gemm_scratch_size(void);
+/*
+    run the multiplication on the calling thread (use it inside engine tasks)
+    - void* scratch: sc_gemm_scratch_size() bytes
+    - return: 0 on success
+*/
+int sc_gemm_serial(const sc_gemm_desc* desc, void* scratch);
+/*
+    run the multiplication on the engine thread pool, tiles of C are distributed over the threads
+    - ccb_arena* arena: arena where the task and the per thread scratch will be allocated
+    - return: 0 on success
+*/
+int sc_gemm(const sc_gemm_desc* desc, ccb_arena* arena);
+
+
+#endif // __SC_GEMM_H__
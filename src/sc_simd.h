@@ -0,0 +1,197 @@
+#ifndef __SC_SIMD_H__
+#define __SC_SIMD_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "data.h"
+
+/*
+    internal SIMD helpers shared by the kernels of the library
+    the library is built with -mavx, kernels using newer instructions are
+    compiled with a target attribute and selected at runtime with __builtin_cpu_supports
+*/
+
+#define SC_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SC_TARGET_F16C __attribute__((target("f16c")))
+
+// kernels compiled with SC_TARGET_AVX2 may only run when this returns 1
+static inline int sc_has_avx2_fma(void) {
+    static int support = -1;
+    if (support < 0) {
+        support = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+    return support;
+}
+
+// kernels compiled with SC_TARGET_F16C may only run when this returns 1
+static inline int sc_has_f16c(void) {
+    static int support = -1;
+    if (support < 0) {
+        support = __builtin_cpu_supports("f16c");
+    }
+    return support;
+}
+
+
+// bfloat16 is the upper half of a float32, the conversion only works on the bits
+// so it behaves the same when __bf16 is not a native type
+static inline float sc_bf16_bits_to_f32(uint16_t bits) {
+    uint32_t wide = (uint32_t)bits << 16;
+    float out;
+    memcpy(&out, &wide, sizeof(float));
+    return out;
+}
+
+static inline uint16_t sc_f32_to_bf16_bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+
+    // keep NaN quiet instead of rounding it to infinity
+    if ((bits & 0x7fffffff) > 0x7f800000) {
+        return (uint16_t)((bits >> 16) | 0x0040);
+    }
+
+    // round to nearest even
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return (uint16_t)(bits >> 16);
+}
+
+
+// IEEE half precision (1 sign, 5 exponent, 10 mantissa bits), software conversions used
+// when F16C is missing and for the tails of the vectorised loops
+static inline float sc_half_bits_to_f32(uint16_t bits) {
+    uint32_t sign = (uint32_t)(bits & 0x8000) << 16;
+    uint32_t exponent = (bits >> 10) & 0x1f;
+    uint32_t mantissa = bits & 0x3ff;
+    uint32_t wide;
+
+    if (exponent == 0x1f) {
+        // infinity, NaN keeps its payload and becomes quiet (as vcvtph2ps does)
+        wide = sign | 0x7f800000 | (mantissa << 13) | ((mantissa != 0) ? 0x00400000 : 0);
+    } else if (exponent != 0) {
+        wide = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa != 0) {
+        // subnormal: mantissa * 2^-24 is exact in float32
+        float value = (float)mantissa * 5.9604644775390625e-8f;
+        memcpy(&wide, &value, sizeof(float));
+        wide |= sign;
+    } else {
+        wide = sign;
+    }
+
+    float out;
+    memcpy(&out, &wide, sizeof(float));
+    return out;
+}
+
+static inline uint16_t sc_f32_to_half_bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    uint32_t abs_bits = bits & 0x7fffffff;
+
+    if (abs_bits >= 0x7f800000) {
+        // infinity, NaN stays quiet
+        return sign | 0x7c00 | ((abs_bits > 0x7f800000) ? (0x0200 | ((abs_bits >> 13) & 0x3ff)) : 0);
+    }
+    if (abs_bits >= 0x477ff000) {
+        // 65520 and above round to infinity
+        return sign | 0x7c00;
+    }
+    if (abs_bits >= 0x38800000) {
+        // normal range, round to nearest even and rebias the exponent
+        abs_bits += 0x0fff + ((abs_bits >> 13) & 1);
+        return sign | (uint16_t)((abs_bits - 0x38000000) >> 13);
+    }
+
+    // subnormal range: adding 0.5 lets the FPU round to a multiple of 2^-24
+    float abs_value;
+    memcpy(&abs_value, &abs_bits, sizeof(float));
+    abs_value += 0.5f;
+    memcpy(&abs_bits, &abs_value, sizeof(float));
+    return sign | (uint16_t)(abs_bits - 0x3f000000);
+}
+
+static inline SC_TARGET_F16C __m256 sc_load_half_f16c(const uint16_t* src) {
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)src));
+}
+
+static inline SC_TARGET_F16C void sc_store_half_f16c(uint16_t* dst, __m256 value) {
+    _mm_storeu_si128((__m128i*)dst, _mm256_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+
+// load / store 8 float32 lanes from a float32 or bfloat16 buffer
+static inline __m256 sc_load_bf16x8(const uint16_t* src) {
+    __m128i raw = _mm_loadu_si128((const __m128i*)src);
+    __m128i lo = _mm_slli_epi32(_mm_cvtepu16_epi32(raw), 16);
+    __m128i hi = _mm_slli_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(raw, 8)), 16);
+    return _mm256_set_m128(_mm_castsi128_ps(hi), _mm_castsi128_ps(lo));
+}
+
+static inline __m128i sc_round_f32x4_to_bf16(__m128 value) {
+    __m128i bits = _mm_castps_si128(value);
+    __m128i lsb = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(1));
+    __m128i rounded = _mm_srli_epi32(_mm_add_epi32(bits, _mm_add_epi32(lsb, _mm_set1_epi32(0x7fff))), 16);
+
+    // keep NaN quiet instead of rounding it to infinity, as sc_f32_to_bf16_bits
+    __m128i nan = _mm_castps_si128(_mm_cmpunord_ps(value, value));
+    __m128i quiet = _mm_or_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x0040));
+    return _mm_blendv_epi8(rounded, quiet, nan);
+}
+
+static inline void sc_store_bf16x8(uint16_t* dst, __m256 value) {
+    __m128i lo = sc_round_f32x4_to_bf16(_mm256_castps256_ps128(value));
+    __m128i hi = sc_round_f32x4_to_bf16(_mm256_extractf128_ps(value, 1));
+    _mm_storeu_si128((__m128i*)dst, _mm_packus_epi32(lo, hi));
+}
+
+static inline __m256 sc_load_f32x8(const void* base, uint64_t index, sc_TYPES type) {
+    if (type == sc_float16) {
+        return sc_load_bf16x8((const uint16_t*)base + index);
+    }
+    return _mm256_loadu_ps((const float*)base + index);
+}
+
+static inline void sc_store_f32x8(void* base, uint64_t index, __m256 value, sc_TYPES type) {
+    if (type == sc_float16) {
+        sc_store_bf16x8((uint16_t*)base + index, value);
+        return;
+    }
+    _mm256_storeu_ps((float*)base + index, value);
+}
+
+static inline float sc_load_f32(const void* base, uint64_t index, sc_TYPES type) {
+    if (type == sc_float16) {
+        return sc_bf16_bits_to_f32(((const uint16_t*)base)[index]);
+    }
+    return ((const float*)base)[index];
+}
+
+static inline void sc_store_f32(void* base, uint64_t index, float value, sc_TYPES type) {
+    if (type == sc_float16) {
+        ((uint16_t*)base)[index] = sc_f32_to_bf16_bits(value);
+        return;
+    }
+    ((float*)base)[index] = value;
+}
+
+
+// horizontal sum of the 8 lanes
+static inline float sc_hsum_f32x8(__m256 value) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(value), _mm256_extractf128_ps(value, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+static inline double sc_hsum_f64x4(__m256d value) {
+    __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+    sum = _mm_add_sd(sum, _mm_unpackhi_pd(sum, sum));
+    return _mm_cvtsd_f64(sum);
+}
+
+
+#endif // __SC_SIMD_H__
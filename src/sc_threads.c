@@ -1,5 +1,8 @@
 #include "sc_threads.h"
 
+#include <stdlib.h>
+#include <errno.h>
+
 
 
 
@@ -14,6 +17,36 @@ int get_cpu_count() {
 }
 
 
+// size in bytes of the last level cache, 8 MB when it cannot be detected
+uint64_t get_llc_size() {
+    uint64_t size = 0;
+
+    #ifdef _WIN32
+        DWORD length = 0;
+        GetLogicalProcessorInformation(NULL, &length);
+        SYSTEM_LOGICAL_PROCESSOR_INFORMATION* info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION*)malloc(length);
+        if (info != NULL && GetLogicalProcessorInformation(info, &length)) {
+            int level = 0;
+            for (DWORD i = 0; i < length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION); i++) {
+                if (info[i].Relationship == RelationCache && info[i].Cache.Level >= level) {
+                    level = info[i].Cache.Level;
+                    size = info[i].Cache.Size;
+                }
+            }
+        }
+        free(info);
+    #else
+        #ifdef _SC_LEVEL3_CACHE_SIZE
+            long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+            long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+            size = (l3 > 0) ? (uint64_t)l3 : ((l2 > 0) ? (uint64_t)l2 : 0);
+        #endif
+    #endif
+
+    return (size > 0) ? size : 8 * 1024 * 1024;
+}
+
+
 
 
 int create_thread(thread_t* thread, void* (*start_routine)(void*), void* arg) {
@@ -60,8 +93,15 @@ int create_mutex(mutex_t* mutex) {
         }
         return 0;
     #else
-        int rc = pthread_mutex_init(mutex, NULL);
+        *mutex = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
+        if (*mutex == NULL) {
+            return -1;
+        }
+
+        int rc = pthread_mutex_init(*mutex, NULL);
         if (rc != 0) {
+            free(*mutex);
+            *mutex = NULL;
             return -1;
         }
         return 0;
@@ -77,7 +117,8 @@ int destroy_mutex(mutex_t mutex) {
         }
         return 0;
     #else
-        int rc = pthread_mutex_destroy(&mutex);
+        int rc = pthread_mutex_destroy(mutex);
+        free(mutex);
         if (rc != 0) {
             return -1;
         }
@@ -93,7 +134,7 @@ int lock_mutex(mutex_t mutex) {
         }
         return 0;
     #else
-        int rc = pthread_mutex_lock(&mutex);
+        int rc = pthread_mutex_lock(mutex);
         if (rc != 0) {
             return -1;
         }
@@ -110,7 +151,88 @@ int unlock_mutex(mutex_t mutex) {
         }
         return 0;
     #else
-        int rc = pthread_mutex_unlock(&mutex);
+        int rc = pthread_mutex_unlock(mutex);
+        if (rc != 0) {
+            return -1;
+        }
+        return 0;
+    #endif
+}
+
+
+
+int create_semaphore(semaphore_t* semaphore, unsigned int initial) {
+    #ifdef _WIN32
+        *semaphore = CreateSemaphore(NULL, initial, 0x7fffffff, NULL);
+        if (*semaphore == NULL) {
+            return -1;
+        }
+        return 0;
+    #else
+        *semaphore = (sem_t*)malloc(sizeof(sem_t));
+        if (*semaphore == NULL) {
+            return -1;
+        }
+
+        int rc = sem_init(*semaphore, 0, initial);
+        if (rc != 0) {
+            free(*semaphore);
+            *semaphore = NULL;
+            return -1;
+        }
+        return 0;
+    #endif
+}
+
+
+int destroy_semaphore(semaphore_t semaphore) {
+    #ifdef _WIN32
+        int rc = CloseHandle(semaphore);
+        if (rc == 0) {
+            return -1;
+        }
+        return 0;
+    #else
+        int rc = sem_destroy(semaphore);
+        free(semaphore);
+        if (rc != 0) {
+            return -1;
+        }
+        return 0;
+    #endif
+}
+
+
+int wait_semaphore(semaphore_t semaphore) {
+    #ifdef _WIN32
+        int rc = WaitForSingleObject(semaphore, INFINITE);
+        if (rc == WAIT_FAILED) {
+            return -1;
+        }
+        return 0;
+    #else
+        int rc;
+        do {
+            rc = sem_wait(semaphore);
+        } while (rc != 0 && errno == EINTR);
+
+        if (rc != 0) {
+            return -1;
+        }
+        return 0;
+    #endif
+}
+
+
+int post_semaphore(semaphore_t semaphore) {
+    #ifdef _WIN32
+        int rc = ReleaseSemaphore(semaphore, 1, NULL);
+        if (rc == 0) {
+            return -1;
+        }
+        return 0;
+    #else
+        int rc = sem_post(semaphore);
         if (rc != 0) {
             return -1;
         }
@@ -1,6 +1,8 @@
 #ifndef __SC_THREADS_H__
 #define __SC_THREADS_H__
 
+#include <stdint.h>
+
 // cross platform thread handling
 #ifdef _WIN32
 #include <windows.h>
@@ -8,23 +10,31 @@
 
 typedef HANDLE thread_t;
 typedef CRITICAL_SECTION* mutex_t;
+typedef HANDLE semaphore_t;
 #else
 #define min(a, b) ((a>b) ? (b) : (a))
 
 
 #include <pthread.h>
+#include <semaphore.h>
 #include <unistd.h>
 typedef pthread_t thread_t;
-typedef pthread_mutex_t mutex_t;
+typedef pthread_mutex_t* mutex_t;
+typedef sem_t* semaphore_t;
 #endif
 
 int get_cpu_count();
+uint64_t get_llc_size();
 int create_thread(thread_t* thread, void* (*start_routine)(void*), void* arg);
 int join_thread(thread_t thread);
 int create_mutex(mutex_t* mutex);
 int destroy_mutex(mutex_t mutex);
 int lock_mutex(mutex_t mutex);
 int unlock_mutex(mutex_t mutex);
+int create_semaphore(semaphore_t* semaphore, unsigned int initial);
+int destroy_semaphore(semaphore_t semaphore);
+int wait_semaphore(semaphore_t semaphore);
+int post_semaphore(semaphore_t semaphore);
 
 
 
@@ -0,0 +1,601 @@
+#include "data.h"
+#include "scan.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+
+
+// elements of a chunk, fixed so the float results do not depend on the thread count
+#define SCAN_CHUNK 65536
+// adjacent lines of an inner axis scanned together
+#define SCAN_TILE 256
+
+
+// running value of a scan, in the accumulation type of the scanned type
+typedef union {
+    float f32;
+    double f64;
+    int32_t i32;
+    int64_t i64;
+    uint8_t u8;
+} scan_value;
+
+
+static inline float combine_f32(float a, float b, sc_scan_op op) {
+    switch (op) {
+        case sc_scan_sum: return a + b;
+        case sc_scan_prod: return a * b;
+        case sc_scan_max: return (b > a || b != b) ? b : a;
+        default: return (b < a || b != b) ? b : a;
+    }
+}
+
+
+static inline double combine_f64(double a, double b, sc_scan_op op) {
+    switch (op) {
+        case sc_scan_sum: return a + b;
+        case sc_scan_prod: return a * b;
+        case sc_scan_max: return (b > a || b != b) ? b : a;
+        default: return (b < a || b != b) ? b : a;
+    }
+}
+
+
+static inline int32_t combine_i32(int32_t a, int32_t b, sc_scan_op op) {
+    switch (op) {
+        case sc_scan_sum: return (int32_t)((uint32_t)a + (uint32_t)b);
+        case sc_scan_prod: return (int32_t)((uint32_t)a * (uint32_t)b);
+        case sc_scan_max: return (b > a) ? b : a;
+        default: return (b < a) ? b : a;
+    }
+}
+
+
+static inline int64_t combine_i64(int64_t a, int64_t b, sc_scan_op op) {
+    switch (op) {
+        case sc_scan_sum: return (int64_t)((uint64_t)a + (uint64_t)b);
+        case sc_scan_prod: return (int64_t)((uint64_t)a * (uint64_t)b);
+        case sc_scan_max: return (b > a) ? b : a;
+        default: return (b < a) ? b : a;
+    }
+}
+
+
+// saturated sums and products of non negative values stay associative
+static inline uint8_t combine_u8(uint8_t a, uint8_t b, sc_scan_op op) {
+    uint32_t wide;
+    switch (op) {
+        case sc_scan_sum: wide = (uint32_t)a + b; return (wide > UINT8_MAX) ? UINT8_MAX : (uint8_t)wide;
+        case sc_scan_prod: wide = (uint32_t)a * b; return (wide > UINT8_MAX) ? UINT8_MAX : (uint8_t)wide;
+        case sc_scan_max: return (b > a) ? b : a;
+        default: return (b < a) ? b : a;
+    }
+}
+
+
+static scan_value scan_identity(sc_TYPES type, sc_scan_op op) {
+    scan_value value;
+    memset(&value, 0, sizeof(value));
+    int one = (op == sc_scan_prod);
+    switch (type) {
+        case sc_float16:
+        case sc_half:
+        case sc_float32:
+            value.f32 = (op == sc_scan_max) ? -INFINITY : (op == sc_scan_min) ? INFINITY : (float)one;
+            break;
+        case sc_float64:
+            value.f64 = (op == sc_scan_max) ? -INFINITY : (op == sc_scan_min) ? INFINITY : (double)one;
+            break;
+        case sc_int32:
+            value.i32 = (op == sc_scan_max) ? INT32_MIN : (op == sc_scan_min) ? INT32_MAX : one;
+            break;
+        case sc_int64:
+            value.i64 = (op == sc_scan_max) ? INT64_MIN : (op == sc_scan_min) ? INT64_MAX : one;
+            break;
+        case sc_uint8:
+            value.u8 = (op == sc_scan_min) ? UINT8_MAX : (uint8_t)one;
+            break;
+    }
+    return value;
+}
+
+
+static scan_value scan_combine(sc_TYPES type, sc_scan_op op, scan_value a, scan_value b) {
+    switch (type) {
+        case sc_float16:
+        case sc_half:
+        case sc_float32: a.f32 = combine_f32(a.f32, b.f32, op); break;
+        case sc_float64: a.f64 = combine_f64(a.f64, b.f64, op); break;
+        case sc_int32: a.i32 = combine_i32(a.i32, b.i32, op); break;
+        case sc_int64: a.i64 = combine_i64(a.i64, b.i64, op); break;
+        case sc_uint8: a.u8 = combine_u8(a.u8, b.u8, op); break;
+    }
+    return a;
+}
+
+
+/*
+    scalar kernels, one instance per type and operation:
+    - scan: strided line from a carried value, the carry ends as the total, nothing is written when write is 0
+    - fix: combines the carry into a scanned line
+    - vscan: count adjacent lines of an inner axis, one contiguous row at a time
+*/
+#define SCAN_KERNELS(SUFFIX, ST, KS, AT, LOAD, STORE, OPNAME, OP)                                              \
+static void scan_##SUFFIX##_##OPNAME(const void* in, void* out, uint64_t count, uint64_t stride,               \
+                                     scan_value* carry, int exclusive, int write) {                            \
+    const ST* src = (const ST*)in;                                                                             \
+    ST* dst = (ST*)out;                                                                                        \
+    AT running = carry->KS;                                                                                    \
+    for (uint64_t i = 0; i < count; i++) {                                                                     \
+        AT next = combine_##KS(running, LOAD(src[i * stride]), OP);                                            \
+        if (write) {                                                                                           \
+            dst[i * stride] = STORE(exclusive ? running : next);                                               \
+        }                                                                                                      \
+        running = next;                                                                                        \
+    }                                                                                                          \
+    carry->KS = running;                                                                                       \
+}                                                                                                              \
+                                                                                                               \
+static void fix_##SUFFIX##_##OPNAME(void* out, uint64_t count, uint64_t stride, const scan_value* carry) {     \
+    ST* dst = (ST*)out;                                                                                        \
+    AT value = carry->KS;                                                                                      \
+    for (uint64_t i = 0; i < count; i++) {                                                                     \
+        dst[i * stride] = STORE(combine_##KS(value, LOAD(dst[i * stride]), OP));                               \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static void vscan_##SUFFIX##_##OPNAME(const void* in, void* out, uint64_t length, uint64_t inner,              \
+                                      uint64_t count, int exclusive) {                                         \
+    AT running[SCAN_TILE];                                                                                     \
+    AT identity = scan_identity(SCAN_TYPE_##SUFFIX, OP).KS;                                                    \
+    for (uint64_t c = 0; c < count; c++) {                                                                     \
+        running[c] = identity;                                                                                 \
+    }                                                                                                          \
+    for (uint64_t l = 0; l < length; l++) {                                                                    \
+        const ST* src = (const ST*)in + l * inner;                                                             \
+        ST* dst = (ST*)out + l * inner;                                                                        \
+        for (uint64_t c = 0; c < count; c++) {                                                                 \
+            AT next = combine_##KS(running[c], LOAD(src[c]), OP);                                              \
+            dst[c] = STORE(exclusive ? running[c] : next);                                                     \
+            running[c] = next;                                                                                 \
+        }                                                                                                      \
+    }                                                                                                          \
+}
+
+#define SCAN_LOAD_SAME(v) (v)
+#define SCAN_STORE_SAME(v) (v)
+#define SCAN_LOAD_BF16(v) sc_bf16_bits_to_f32(v)
+#define SCAN_STORE_BF16(v) sc_f32_to_bf16_bits(v)
+#define SCAN_LOAD_HALF(v) sc_half_bits_to_f32(v)
+#define SCAN_STORE_HALF(v) sc_f32_to_half_bits(v)
+
+#define SCAN_TYPE_bf16 sc_float16
+#define SCAN_TYPE_half sc_half
+#define SCAN_TYPE_f32 sc_float32
+#define SCAN_TYPE_f64 sc_float64
+#define SCAN_TYPE_i32 sc_int32
+#define SCAN_TYPE_i64 sc_int64
+#define SCAN_TYPE_u8 sc_uint8
+
+#define SCAN_OPS(SUFFIX, ST, KS, AT, LOAD, STORE)                                                              \
+    SCAN_KERNELS(SUFFIX, ST, KS, AT, LOAD, STORE, sum, sc_scan_sum)                                            \
+    SCAN_KERNELS(SUFFIX, ST, KS, AT, LOAD, STORE, prod, sc_scan_prod)                                          \
+    SCAN_KERNELS(SUFFIX, ST, KS, AT, LOAD, STORE, max, sc_scan_max)                                            \
+    SCAN_KERNELS(SUFFIX, ST, KS, AT, LOAD, STORE, min, sc_scan_min)
+
+SCAN_OPS(bf16, uint16_t, f32, float, SCAN_LOAD_BF16, SCAN_STORE_BF16)
+SCAN_OPS(half, uint16_t, f32, float, SCAN_LOAD_HALF, SCAN_STORE_HALF)
+SCAN_OPS(f32, float, f32, float, SCAN_LOAD_SAME, SCAN_STORE_SAME)
+SCAN_OPS(f64, double, f64, double, SCAN_LOAD_SAME, SCAN_STORE_SAME)
+SCAN_OPS(i32, int32_t, i32, int32_t, SCAN_LOAD_SAME, SCAN_STORE_SAME)
+SCAN_OPS(i64, int64_t, i64, int64_t, SCAN_LOAD_SAME, SCAN_STORE_SAME)
+SCAN_OPS(u8, uint8_t, u8, uint8_t, SCAN_LOAD_SAME, SCAN_STORE_SAME)
+
+typedef struct {
+    void (*scan)(const void*, void*, uint64_t, uint64_t, scan_value*, int, int);
+    void (*fix)(void*, uint64_t, uint64_t, const scan_value*);
+    void (*vscan)(const void*, void*, uint64_t, uint64_t, uint64_t, int);
+} scan_kernels;
+
+#define SCAN_ROW(SUFFIX)                                                                                       \
+    {{scan_##SUFFIX##_sum, fix_##SUFFIX##_sum, vscan_##SUFFIX##_sum},                                          \
+     {scan_##SUFFIX##_prod, fix_##SUFFIX##_prod, vscan_##SUFFIX##_prod},                                       \
+     {scan_##SUFFIX##_max, fix_##SUFFIX##_max, vscan_##SUFFIX##_max},                                          \
+     {scan_##SUFFIX##_min, fix_##SUFFIX##_min, vscan_##SUFFIX##_min}}
+
+// [type, op], in the order of sc_TYPES and sc_scan_op
+static const scan_kernels kernels[7][4] = {
+    SCAN_ROW(bf16),
+    SCAN_ROW(f32),
+    SCAN_ROW(f64),
+    SCAN_ROW(half),
+    SCAN_ROW(i32),
+    SCAN_ROW(i64),
+    SCAN_ROW(u8),
+};
+
+
+// #############
+// AVX kernels
+// #############
+
+// max and min keep the NaN of either operand (the AVX ones return the second operand)
+static inline __m256 max_nan_f32x8(__m256 a, __m256 b) {
+    __m256 nan_a = _mm256_cmp_ps(a, a, _CMP_UNORD_Q);
+    return _mm256_or_ps(_mm256_and_ps(nan_a, a), _mm256_andnot_ps(nan_a, _mm256_max_ps(a, b)));
+}
+
+
+static inline __m256 min_nan_f32x8(__m256 a, __m256 b) {
+    __m256 nan_a = _mm256_cmp_ps(a, a, _CMP_UNORD_Q);
+    return _mm256_or_ps(_mm256_and_ps(nan_a, a), _mm256_andnot_ps(nan_a, _mm256_min_ps(a, b)));
+}
+
+
+static inline __m256d max_nan_f64x4(__m256d a, __m256d b) {
+    __m256d nan_a = _mm256_cmp_pd(a, a, _CMP_UNORD_Q);
+    return _mm256_or_pd(_mm256_and_pd(nan_a, a), _mm256_andnot_pd(nan_a, _mm256_max_pd(a, b)));
+}
+
+
+static inline __m256d min_nan_f64x4(__m256d a, __m256d b) {
+    __m256d nan_a = _mm256_cmp_pd(a, a, _CMP_UNORD_Q);
+    return _mm256_or_pd(_mm256_and_pd(nan_a, a), _mm256_andnot_pd(nan_a, _mm256_min_pd(a, b)));
+}
+
+
+/*
+    in register scans without AVX2 lane crossing shuffles: shifts by 1 then 2 lanes inside the 128 bit halves
+    (permute and blend of the identity), then the last lane of the low half is combined into the high half
+    the exclusive outputs are the inclusive ones shifted by one lane with the carry in the first lane
+*/
+#define SCAN_F32X8(OPNAME, VOP, OP)                                                                            \
+static void scan_f32x8_##OPNAME(const void* in, void* out, sc_TYPES type, uint64_t count, float* carry,        \
+                                int exclusive, int write) {                                                    \
+    __m256 identity = _mm256_set1_ps(scan_identity(sc_float32, OP).f32);                                       \
+    __m256 c = _mm256_set1_ps(*carry);                                                                         \
+    uint64_t i = 0;                                                                                            \
+    for (; i + 8 <= count; i += 8) {                                                                           \
+        __m256 x = sc_load_f32x8(in, i, type);                                                                 \
+        x = VOP(_mm256_blend_ps(_mm256_permute_ps(x, 0x93), identity, 0x11), x);                               \
+        x = VOP(_mm256_blend_ps(_mm256_permute_ps(x, 0x4e), identity, 0x33), x);                               \
+        __m256 low = _mm256_permute_ps(x, 0xff);                                                               \
+        x = VOP(_mm256_blend_ps(_mm256_permute2f128_ps(low, low, 0x00), identity, 0x0f), x);                   \
+        x = VOP(c, x);                                                                                         \
+        if (write) {                                                                                           \
+            if (exclusive) {                                                                                   \
+                __m256 r = _mm256_permute_ps(x, 0x93);                                                         \
+                __m256 shifted = _mm256_blend_ps(r, _mm256_permute2f128_ps(r, r, 0x08), 0x10);                 \
+                sc_store_f32x8(out, i, _mm256_blend_ps(shifted, c, 0x01), type);                               \
+            } else {                                                                                           \
+                sc_store_f32x8(out, i, x, type);                                                               \
+            }                                                                                                  \
+        }                                                                                                      \
+        __m256 last = _mm256_permute_ps(x, 0xff);                                                              \
+        c = _mm256_permute2f128_ps(last, last, 0x11);                                                          \
+    }                                                                                                          \
+    float running = _mm256_cvtss_f32(c);                                                                       \
+    for (; i < count; i++) {                                                                                   \
+        float next = combine_f32(running, sc_load_f32(in, i, type), OP);                                       \
+        if (write) {                                                                                           \
+            sc_store_f32(out, i, exclusive ? running : next, type);                                            \
+        }                                                                                                      \
+        running = next;                                                                                        \
+    }                                                                                                          \
+    *carry = running;                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static void fix_f32x8_##OPNAME(float* out, uint64_t count, float carry) {                                      \
+    __m256 c = _mm256_set1_ps(carry);                                                                          \
+    uint64_t i = 0;                                                                                            \
+    for (; i + 8 <= count; i += 8) {                                                                           \
+        _mm256_storeu_ps(out + i, VOP(c, _mm256_loadu_ps(out + i)));                                           \
+    }                                                                                                          \
+    for (; i < count; i++) {                                                                                   \
+        out[i] = combine_f32(carry, out[i], OP);                                                               \
+    }                                                                                                          \
+}
+
+#define SCAN_F64X4(OPNAME, VOP, OP)                                                                            \
+static void scan_f64x4_##OPNAME(const double* in, double* out, uint64_t count, double* carry, int exclusive) { \
+    __m256d identity = _mm256_set1_pd(scan_identity(sc_float64, OP).f64);                                      \
+    __m256d c = _mm256_set1_pd(*carry);                                                                        \
+    uint64_t i = 0;                                                                                            \
+    for (; i + 4 <= count; i += 4) {                                                                           \
+        __m256d x = _mm256_loadu_pd(in + i);                                                                   \
+        x = VOP(_mm256_blend_pd(_mm256_permute_pd(x, 0x5), identity, 0x5), x);                                 \
+        __m256d low = _mm256_permute_pd(x, 0xf);                                                               \
+        x = VOP(_mm256_blend_pd(_mm256_permute2f128_pd(low, low, 0x00), identity, 0x3), x);                    \
+        x = VOP(c, x);                                                                                         \
+        if (exclusive) {                                                                                       \
+            __m256d r = _mm256_permute_pd(x, 0x5);                                                             \
+            __m256d shifted = _mm256_blend_pd(r, _mm256_permute2f128_pd(r, r, 0x08), 0x4);                     \
+            _mm256_storeu_pd(out + i, _mm256_blend_pd(shifted, c, 0x1));                                       \
+        } else {                                                                                               \
+            _mm256_storeu_pd(out + i, x);                                                                      \
+        }                                                                                                      \
+        __m256d last = _mm256_permute_pd(x, 0xf);                                                              \
+        c = _mm256_permute2f128_pd(last, last, 0x11);                                                          \
+    }                                                                                                          \
+    double running = _mm256_cvtsd_f64(c);                                                                      \
+    for (; i < count; i++) {                                                                                   \
+        double next = combine_f64(running, in[i], OP);                                                         \
+        out[i] = exclusive ? running : next;                                                                   \
+        running = next;                                                                                        \
+    }                                                                                                          \
+    *carry = running;                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static void fix_f64x4_##OPNAME(double* out, uint64_t count, double carry) {                                    \
+    __m256d c = _mm256_set1_pd(carry);                                                                         \
+    uint64_t i = 0;                                                                                            \
+    for (; i + 4 <= count; i += 4) {                                                                           \
+        _mm256_storeu_pd(out + i, VOP(c, _mm256_loadu_pd(out + i)));                                           \
+    }                                                                                                          \
+    for (; i < count; i++) {                                                                                   \
+        out[i] = combine_f64(carry, out[i], OP);                                                               \
+    }                                                                                                          \
+}
+
+SCAN_F32X8(sum, _mm256_add_ps, sc_scan_sum)
+SCAN_F32X8(prod, _mm256_mul_ps, sc_scan_prod)
+SCAN_F32X8(max, max_nan_f32x8, sc_scan_max)
+SCAN_F32X8(min, min_nan_f32x8, sc_scan_min)
+SCAN_F64X4(sum, _mm256_add_pd, sc_scan_sum)
+SCAN_F64X4(prod, _mm256_mul_pd, sc_scan_prod)
+SCAN_F64X4(max, max_nan_f64x4, sc_scan_max)
+SCAN_F64X4(min, min_nan_f64x4, sc_scan_min)
+
+static void (*const scan_f32x8[4])(const void*, void*, sc_TYPES, uint64_t, float*, int, int) = {
+    scan_f32x8_sum, scan_f32x8_prod, scan_f32x8_max, scan_f32x8_min,
+};
+static void (*const fix_f32x8[4])(float*, uint64_t, float) = {
+    fix_f32x8_sum, fix_f32x8_prod, fix_f32x8_max, fix_f32x8_min,
+};
+static void (*const scan_f64x4[4])(const double*, double*, uint64_t, double*, int) = {
+    scan_f64x4_sum, scan_f64x4_prod, scan_f64x4_max, scan_f64x4_min,
+};
+static void (*const fix_f64x4[4])(double*, uint64_t, double) = {
+    fix_f64x4_sum, fix_f64x4_prod, fix_f64x4_max, fix_f64x4_min,
+};
+
+
+// ########
+// driver
+// ########
+
+/*
+    a tensor is seen as [outer, length, inner] around the axis, contiguous lines (inner 1) are cut in chunks
+    numbered line * per_line + chunk, inner axes are cut in tiles of adjacent lines
+*/
+struct scan_args {
+    const uint8_t* in;
+    uint8_t* out;
+    sc_TYPES type;
+    sc_scan_op op;
+    int exclusive;
+    uint64_t outer;
+    uint64_t length;
+    uint64_t inner;
+    uint64_t per_line;          // chunks of a line, tiles of an outer index
+    int rescan;                 // bfloat16 and half: the chunks after the first are scanned from their carry
+    scan_value* carries;        // [chunks] chunk totals, then the total of the chunks before
+    const scan_kernels* kernels;
+};
+
+
+static void chunk_range(const struct scan_args* args, uint64_t c, uint64_t* offset, uint64_t* count) {
+    uint64_t line = c / args->per_line;
+    uint64_t first = (c % args->per_line) * SCAN_CHUNK;
+    *offset = (line * args->length + first) * sc_type_size(args->type);
+    *count = (args->length - first < SCAN_CHUNK) ? args->length - first : SCAN_CHUNK;
+}
+
+
+static void run_scan(const struct scan_args* args, const void* in, void* out, uint64_t count, scan_value* carry, int write) {
+    if (args->type == sc_float32 || args->type == sc_float16) {
+        scan_f32x8[args->op](in, out, args->type, count, &carry->f32, args->exclusive, write);
+    } else if (args->type == sc_float64 && write) {
+        scan_f64x4[args->op]((const double*)in, (double*)out, count, &carry->f64, args->exclusive);
+    } else {
+        args->kernels->scan(in, out, count, 1, carry, args->exclusive, write);
+    }
+}
+
+
+static int chunk_scan_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct scan_args* args = (struct scan_args*)raw;
+    for (uint64_t c = start; c < end; c++) {
+        uint64_t offset;
+        uint64_t count;
+        chunk_range(args, c, &offset, &count);
+        scan_value carry = scan_identity(args->type, args->op);
+        run_scan(args, args->in + offset, args->out + offset, count, &carry, !args->rescan || c % args->per_line == 0);
+        args->carries[c] = carry;
+    }
+    return 0;
+}
+
+
+static int chunk_fix_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct scan_args* args = (struct scan_args*)raw;
+    for (uint64_t c = start; c < end; c++) {
+        if (c % args->per_line == 0) {
+            continue;
+        }
+        uint64_t offset;
+        uint64_t count;
+        chunk_range(args, c, &offset, &count);
+        scan_value carry = args->carries[c];
+        if (args->rescan) {
+            run_scan(args, args->in + offset, args->out + offset, count, &carry, 1);
+        } else if (args->type == sc_float32) {
+            fix_f32x8[args->op]((float*)(args->out + offset), count, carry.f32);
+        } else if (args->type == sc_float64) {
+            fix_f64x4[args->op]((double*)(args->out + offset), count, carry.f64);
+        } else {
+            args->kernels->fix(args->out + offset, count, 1, &carry);
+        }
+    }
+    return 0;
+}
+
+
+static int tile_scan_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct scan_args* args = (struct scan_args*)raw;
+    uint64_t size = sc_type_size(args->type);
+    for (uint64_t t = start; t < end; t++) {
+        uint64_t o = t / args->per_line;
+        uint64_t first = (t % args->per_line) * SCAN_TILE;
+        uint64_t count = (args->inner - first < SCAN_TILE) ? args->inner - first : SCAN_TILE;
+        uint64_t offset = (o * args->length * args->inner + first) * size;
+        args->kernels->vscan(args->in + offset, args->out + offset, args->length, args->inner, count, args->exclusive);
+    }
+    return 0;
+}
+
+
+static int scan_lines(struct scan_args* args, ccb_arena* arena) {
+    uint64_t total = args->outer * args->length * args->inner;
+    if (total == 0) {
+        return 0;
+    }
+    args->kernels = &kernels[args->type][args->op];
+    if (args->inner > 1) {
+        args->per_line = (args->inner + SCAN_TILE - 1) / SCAN_TILE;
+        if (sc_run_range_task(tile_scan_kernel, args, args->outer * args->per_line, total, arena) != 0) {
+            CCB_ERROR("Failed to scan tiles");
+            return -1;
+        }
+        return 0;
+    }
+
+    args->per_line = (args->length + SCAN_CHUNK - 1) / SCAN_CHUNK;
+    args->rescan = (args->type == sc_float16 || args->type == sc_half);
+    uint64_t chunks = args->outer * args->per_line;
+    args->carries = (scan_value*)ccb_arena_malloc(arena, chunks * sizeof(scan_value));
+    CCB_NOTNULL(args->carries, "Failed to allocate scan carries");
+    if (sc_run_range_task(chunk_scan_kernel, args, chunks, total, arena) != 0) {
+        CCB_ERROR("Failed to scan chunks");
+        return -1;
+    }
+    if (args->per_line == 1) {
+        return 0;
+    }
+    // exclusive scan of the chunk totals of every line
+    for (uint64_t line = 0; line < args->outer; line++) {
+        scan_value running = scan_identity(args->type, args->op);
+        for (uint64_t k = 0; k < args->per_line; k++) {
+            scan_value chunk = args->carries[line * args->per_line + k];
+            args->carries[line * args->per_line + k] = running;
+            running = scan_combine(args->type, args->op, running, chunk);
+        }
+    }
+    if (sc_run_range_task(chunk_fix_kernel, args, chunks, total, arena) != 0) {
+        CCB_ERROR("Failed to fix scanned chunks");
+        return -1;
+    }
+    return 0;
+}
+
+
+static int check_op(sc_scan_op op) {
+    if (op != sc_scan_sum && op != sc_scan_prod && op != sc_scan_max && op != sc_scan_min) {
+        CCB_ERROR("Unknown scan operation %d", (int)op);
+        return -1;
+    }
+    return 0;
+}
+
+
+int sc_vector_scan(sc_vector* a, sc_vector* out, sc_scan_op op, int exclusive, ccb_arena* arena) {
+    CCB_NOTNULL(a, "vector is NULL");
+    CCB_NOTNULL(out, "out is NULL");
+    if (check_op(op) != 0) {
+        return -1;
+    }
+    if (out->type != a->type || out->size != a->size) {
+        CCB_ERROR("out must have the size and the type of the vector");
+        return -1;
+    }
+    struct scan_args args;
+    memset(&args, 0, sizeof(args));
+    args.in = (const uint8_t*)a->data;
+    args.out = (uint8_t*)out->data;
+    args.type = a->type;
+    args.op = op;
+    args.exclusive = exclusive;
+    args.outer = 1;
+    args.length = a->size;
+    args.inner = 1;
+    return scan_lines(&args, arena);
+}
+
+
+int sc_tensor_scan(sc_tensor* a, sc_tensor* out, int64_t axis, sc_scan_op op, int exclusive, ccb_arena* arena) {
+    CCB_NOTNULL(a, "tensor is NULL");
+    CCB_NOTNULL(out, "out is NULL");
+    if (check_op(op) != 0) {
+        return -1;
+    }
+    if (out->type != a->type || out->size != a->size || out->dims->dims_count != a->dims->dims_count) {
+        CCB_ERROR("out must have the shape and the type of the tensor");
+        return -1;
+    }
+    int64_t count = (int64_t)a->dims->dims_count;
+    int64_t resolved = (axis < 0) ? axis + count : axis;
+    if (resolved < 0 || resolved >= count) {
+        CCB_ERROR("axis %" PRId64 " is out of range for %" PRId64 " dimensions", axis, count);
+        return -1;
+    }
+    struct scan_args args;
+    memset(&args, 0, sizeof(args));
+    args.in = (const uint8_t*)a->data;
+    args.out = (uint8_t*)out->data;
+    args.type = a->type;
+    args.op = op;
+    args.exclusive = exclusive;
+    args.outer = 1;
+    args.inner = 1;
+    for (int64_t d = 0; d < count; d++) {
+        if (a->dims->dims[d] != out->dims->dims[d]) {
+            CCB_ERROR("out must have the shape of the tensor");
+            return -1;
+        }
+        if (d < resolved) {
+            args.outer *= a->dims->dims[d];
+        } else if (d > resolved) {
+            args.inner *= a->dims->dims[d];
+        }
+    }
+    args.length = a->dims->dims[resolved];
+    return scan_lines(&args, arena);
+}
+
+
+int sc_vector_cumsum(sc_vector* a, sc_vector* out, ccb_arena* arena) {
+    return sc_vector_scan(a, out, sc_scan_sum, 0, arena);
+}
+
+
+int sc_vector_cumprod(sc_vector* a, sc_vector* out, ccb_arena* arena) {
+    return sc_vector_scan(a, out, sc_scan_prod, 0, arena);
+}
+
+
+int sc_vector_cummax(sc_vector* a, sc_vector* out, ccb_arena* arena) {
+    return sc_vector_scan(a, out, sc_scan_max, 0, arena);
+}
+
+
+int sc_vector_cummin(sc_vector* a, sc_vector* out, ccb_arena* arena) {
+    return sc_vector_scan(a, out, sc_scan_min, 0, arena);
+}
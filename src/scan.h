@@ -0,0 +1,52 @@
+#ifndef __SCAN_H__
+#define __SCAN_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    prefix scans (cumulative sums, products, maxima and minima) of vectors and along one axis of a tensor
+    a line is cut in fixed chunks: every chunk is scanned in parallel (AVX in register scans for float32,
+    bfloat16 and float64), the chunk totals are scanned, then the chunks after the first add the total of the
+    chunks before them, so the results do not depend on the thread count
+    bfloat16 and half accumulate in float32 and scan their chunks again from the carried total instead of
+    fixing rounded outputs, along an inner axis the lines of a tile are scanned together row by row
+    the integers follow their arithmetic: int32 and int64 wrap around, uint8 saturates
+    max and min propagate NaN
+*/
+
+typedef enum {
+    sc_scan_sum,
+    sc_scan_prod,
+    sc_scan_max,
+    sc_scan_min,
+} sc_scan_op;
+
+
+/* Prefix scan of a vector: out[i] = a[0] op ... op a[i] (inclusive) or a[0] op ... op a[i - 1] and the
+   identity of op at 0 (exclusive: 0, 1, -inf or +inf, the smallest or largest integer)
+   - sc_vector* a: vector of any type
+   - sc_vector* out: same size and type as a, can be a
+   - sc_scan_op op: combining operation
+   - int exclusive: 1 for the exclusive scan
+   - ccb_arena* arena: arena where the chunk totals and the tasks will be allocated
+   - return: 0 on success
+*/
+int sc_vector_scan(sc_vector* a, sc_vector* out, sc_scan_op op, int exclusive, ccb_arena* arena);
+/* Prefix scan of every line along an axis, see sc_vector_scan
+   - sc_tensor* a: tensor of any type
+   - sc_tensor* out: same shape and type as a, can be a
+   - int64_t axis: scanned axis, negative values count from the last one
+   - return: 0 on success
+*/
+int sc_tensor_scan(sc_tensor* a, sc_tensor* out, int64_t axis, sc_scan_op op, int exclusive, ccb_arena* arena);
+
+/* Inclusive scans of a vector, see sc_vector_scan */
+int sc_vector_cumsum(sc_vector* a, sc_vector* out, ccb_arena* arena);
+int sc_vector_cumprod(sc_vector* a, sc_vector* out, ccb_arena* arena);
+int sc_vector_cummax(sc_vector* a, sc_vector* out, ccb_arena* arena);
+int sc_vector_cummin(sc_vector* a, sc_vector* out, ccb_arena* arena);
+
+
+#endif // __SCAN_H__
@@ -4,6 +4,26 @@
 #include "const.h"
 #include "data.h"
 #include "linalg.h"
+#include "normalization.h"
+#include "conv.h"
+#include "permute.h"
+#include "sparse.h"
+#include "quant.h"
+#include "regression.h"
+#include "nn.h"
+#include "autodiff.h"
+#include "optim.h"
+#include "random.h"
+#include "factor.h"
+#include "geometry.h"
+#include "distance.h"
+#include "kmeans.h"
+#include "ann.h"
+#include "selection.h"
+#include "sort.h"
+#include "scan.h"
+#include "segment.h"
+#include "rolling.h"
 
 #include "ccbase/utils/mem.h"
 #include "ccbase/logs/log.h"
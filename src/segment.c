@@ -0,0 +1,557 @@
+#include "data.h"
+#include "segment.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+
+
+// values of a chunk of the sorted segments
+#define SEGMENT_CHUNK 65536
+
+// NaN of either side propagates, for the integers the NaN terms vanish
+#define SEGMENT_MIN(a, b) (((b) < (a) || (b) != (b)) ? (b) : (a))
+#define SEGMENT_MAX(a, b) (((b) > (a) || (b) != (b)) ? (b) : (a))
+
+
+// running statistics of a segment, float64 fields for float values, int64 fields for integer values
+typedef union {
+    double f;
+    int64_t i;
+} segment_number;
+
+typedef struct {
+    segment_number sum;
+    segment_number min;
+    segment_number max;
+    uint64_t count;
+} segment_acc;
+
+typedef struct {
+    int sum;                // sum or mean
+    int min;
+    int max;
+} segment_needs;
+
+
+static inline int is_integer(sc_TYPES type) {
+    return type == sc_int32 || type == sc_int64 || type == sc_uint8;
+}
+
+
+static inline void acc_init(segment_acc* acc, int integer) {
+    if (integer) {
+        acc->sum.i = 0;
+        acc->min.i = INT64_MAX;
+        acc->max.i = INT64_MIN;
+    } else {
+        acc->sum.f = 0.0;
+        acc->min.f = INFINITY;
+        acc->max.f = -INFINITY;
+    }
+    acc->count = 0;
+}
+
+
+static inline void acc_merge(segment_acc* dst, const segment_acc* src, int integer) {
+    if (src->count == 0) {
+        return;
+    }
+    if (integer) {
+        dst->sum.i = (int64_t)((uint64_t)dst->sum.i + (uint64_t)src->sum.i);
+        dst->min.i = SEGMENT_MIN(dst->min.i, src->min.i);
+        dst->max.i = SEGMENT_MAX(dst->max.i, src->max.i);
+    } else {
+        dst->sum.f += src->sum.f;
+        dst->min.f = SEGMENT_MIN(dst->min.f, src->min.f);
+        dst->max.f = SEGMENT_MAX(dst->max.f, src->max.f);
+    }
+    dst->count += src->count;
+}
+
+
+/*
+    scalar kernels, one instance per type:
+    - range: statistics of the contiguous values [start, end) into acc
+    - rows: values [start, end) into the table entries of their keys, one instance per key type, negative keys
+      are skipped and keys of groups or more are reported (return 1)
+*/
+#define SEGMENT_RANGE(SUFFIX, ST, F, AT, LOAD, ADD)                                                            \
+static void range_##SUFFIX(const ST* data, uint64_t start, uint64_t end, segment_needs needs,                  \
+                           segment_acc* acc) {                                                                 \
+    AT sum = acc->sum.F;                                                                                       \
+    AT low = acc->min.F;                                                                                       \
+    AT high = acc->max.F;                                                                                      \
+    for (uint64_t i = start; i < end; i++) {                                                                   \
+        AT x = (AT)LOAD(data[i]);                                                                              \
+        sum = ADD(sum, x);                                                                                     \
+        low = SEGMENT_MIN(low, x);                                                                             \
+        high = SEGMENT_MAX(high, x);                                                                           \
+    }                                                                                                          \
+    if (needs.sum) acc->sum.F = sum;                                                                           \
+    if (needs.min) acc->min.F = low;                                                                           \
+    if (needs.max) acc->max.F = high;                                                                          \
+    acc->count += end - start;                                                                                 \
+}
+
+#define SEGMENT_ROWS(SUFFIX, ST, F, AT, LOAD, ADD, KSUFFIX, KT)                                                \
+static int rows_##SUFFIX##_##KSUFFIX(const void* values, const void* keys, uint64_t start, uint64_t end,       \
+                                     uint64_t groups, segment_needs needs, segment_acc* table) {               \
+    const ST* data = (const ST*)values;                                                                        \
+    const KT* key = (const KT*)keys;                                                                           \
+    int error = 0;                                                                                             \
+    if (!needs.min && !needs.max) {                                                                            \
+        for (uint64_t i = start; i < end; i++) {                                                               \
+            uint64_t group = (uint64_t)(int64_t)key[i];                                                        \
+            if (group >= groups) {                                                                             \
+                error |= (int64_t)key[i] >= 0;                                                                 \
+                continue;                                                                                      \
+            }                                                                                                  \
+            table[group].sum.F = ADD(table[group].sum.F, (AT)LOAD(data[i]));                                   \
+            table[group].count++;                                                                              \
+        }                                                                                                      \
+        return error;                                                                                          \
+    }                                                                                                          \
+    for (uint64_t i = start; i < end; i++) {                                                                   \
+        uint64_t group = (uint64_t)(int64_t)key[i];                                                            \
+        if (group >= groups) {                                                                                 \
+            error |= (int64_t)key[i] >= 0;                                                                     \
+            continue;                                                                                          \
+        }                                                                                                      \
+        segment_acc* acc = &table[group];                                                                      \
+        AT x = (AT)LOAD(data[i]);                                                                              \
+        acc->sum.F = ADD(acc->sum.F, x);                                                                       \
+        acc->min.F = SEGMENT_MIN(acc->min.F, x);                                                               \
+        acc->max.F = SEGMENT_MAX(acc->max.F, x);                                                               \
+        acc->count++;                                                                                          \
+    }                                                                                                          \
+    return error;                                                                                              \
+}
+
+#define SEGMENT_KERNELS(SUFFIX, ST, F, AT, LOAD, ADD)                                                          \
+SEGMENT_RANGE(SUFFIX, ST, F, AT, LOAD, ADD)                                                                    \
+SEGMENT_ROWS(SUFFIX, ST, F, AT, LOAD, ADD, i32, int32_t)                                                       \
+SEGMENT_ROWS(SUFFIX, ST, F, AT, LOAD, ADD, i64, int64_t)                                                       \
+SEGMENT_ROWS(SUFFIX, ST, F, AT, LOAD, ADD, u8, uint8_t)
+
+#define SEGMENT_LOAD_SAME(v) (v)
+#define SEGMENT_LOAD_BF16(v) sc_bf16_bits_to_f32(v)
+#define SEGMENT_LOAD_HALF(v) sc_half_bits_to_f32(v)
+#define SEGMENT_ADD_FLOAT(a, b) ((a) + (b))
+// integer sums wrap around like the int64 arithmetic
+#define SEGMENT_ADD_INT(a, b) (int64_t)((uint64_t)(a) + (uint64_t)(b))
+
+SEGMENT_KERNELS(bf16, uint16_t, f, double, SEGMENT_LOAD_BF16, SEGMENT_ADD_FLOAT)
+SEGMENT_KERNELS(half, uint16_t, f, double, SEGMENT_LOAD_HALF, SEGMENT_ADD_FLOAT)
+SEGMENT_KERNELS(f32, float, f, double, SEGMENT_LOAD_SAME, SEGMENT_ADD_FLOAT)
+SEGMENT_KERNELS(f64, double, f, double, SEGMENT_LOAD_SAME, SEGMENT_ADD_FLOAT)
+SEGMENT_KERNELS(u8, uint8_t, i, int64_t, SEGMENT_LOAD_SAME, SEGMENT_ADD_INT)
+SEGMENT_KERNELS(i32, int32_t, i, int64_t, SEGMENT_LOAD_SAME, SEGMENT_ADD_INT)
+SEGMENT_KERNELS(i64, int64_t, i, int64_t, SEGMENT_LOAD_SAME, SEGMENT_ADD_INT)
+
+typedef int (*segment_rows_fn)(const void*, const void*, uint64_t, uint64_t, uint64_t, segment_needs, segment_acc*);
+
+#define SEGMENT_ROW(SUFFIX) {rows_##SUFFIX##_i32, rows_##SUFFIX##_i64, rows_##SUFFIX##_u8}
+
+// [value type, key type - sc_int32], in the order of sc_TYPES
+static const segment_rows_fn rows_kernels[7][3] = {
+    SEGMENT_ROW(bf16),
+    SEGMENT_ROW(f32),
+    SEGMENT_ROW(f64),
+    SEGMENT_ROW(half),
+    SEGMENT_ROW(i32),
+    SEGMENT_ROW(i64),
+    SEGMENT_ROW(u8),
+};
+
+
+// #############
+// AVX kernels
+// #############
+
+// keep the NaN of either operand (the AVX max and min return the second one)
+static inline __m256 max_nan_f32x8(__m256 a, __m256 b) {
+    __m256 nan_a = _mm256_cmp_ps(a, a, _CMP_UNORD_Q);
+    return _mm256_or_ps(_mm256_and_ps(nan_a, a), _mm256_andnot_ps(nan_a, _mm256_max_ps(a, b)));
+}
+
+
+static inline __m256 min_nan_f32x8(__m256 a, __m256 b) {
+    __m256 nan_a = _mm256_cmp_ps(a, a, _CMP_UNORD_Q);
+    return _mm256_or_ps(_mm256_and_ps(nan_a, a), _mm256_andnot_ps(nan_a, _mm256_min_ps(a, b)));
+}
+
+
+static inline __m256d max_nan_f64x4(__m256d a, __m256d b) {
+    __m256d nan_a = _mm256_cmp_pd(a, a, _CMP_UNORD_Q);
+    return _mm256_or_pd(_mm256_and_pd(nan_a, a), _mm256_andnot_pd(nan_a, _mm256_max_pd(a, b)));
+}
+
+
+static inline __m256d min_nan_f64x4(__m256d a, __m256d b) {
+    __m256d nan_a = _mm256_cmp_pd(a, a, _CMP_UNORD_Q);
+    return _mm256_or_pd(_mm256_and_pd(nan_a, a), _mm256_andnot_pd(nan_a, _mm256_min_pd(a, b)));
+}
+
+
+// float32 and bfloat16 lanes, the sums are widened to float64
+static void range_f32x8(const void* data, sc_TYPES type, uint64_t start, uint64_t end, segment_needs needs,
+                        segment_acc* acc) {
+    uint64_t i = start;
+    if (end - start >= 16) {
+        __m256d sum_low = _mm256_setzero_pd();
+        __m256d sum_high = _mm256_setzero_pd();
+        __m256 low = _mm256_set1_ps(INFINITY);
+        __m256 high = _mm256_set1_ps(-INFINITY);
+        for (; i + 8 <= end; i += 8) {
+            __m256 x = sc_load_f32x8(data, i, type);
+            sum_low = _mm256_add_pd(sum_low, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+            sum_high = _mm256_add_pd(sum_high, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+            low = min_nan_f32x8(low, x);
+            high = max_nan_f32x8(high, x);
+        }
+        float lows[8];
+        float highs[8];
+        _mm256_storeu_ps(lows, low);
+        _mm256_storeu_ps(highs, high);
+        if (needs.sum) {
+            acc->sum.f += sc_hsum_f64x4(_mm256_add_pd(sum_low, sum_high));
+        }
+        for (int l = 0; l < 8; l++) {
+            acc->min.f = SEGMENT_MIN(acc->min.f, (double)lows[l]);
+            acc->max.f = SEGMENT_MAX(acc->max.f, (double)highs[l]);
+        }
+        acc->count += i - start;
+    }
+    if (type == sc_float16) {
+        range_bf16((const uint16_t*)data, i, end, needs, acc);
+    } else {
+        range_f32((const float*)data, i, end, needs, acc);
+    }
+}
+
+
+static void range_f64x4(const double* data, uint64_t start, uint64_t end, segment_needs needs, segment_acc* acc) {
+    uint64_t i = start;
+    if (end - start >= 8) {
+        __m256d sum = _mm256_setzero_pd();
+        __m256d low = _mm256_set1_pd(INFINITY);
+        __m256d high = _mm256_set1_pd(-INFINITY);
+        for (; i + 4 <= end; i += 4) {
+            __m256d x = _mm256_loadu_pd(data + i);
+            sum = _mm256_add_pd(sum, x);
+            low = min_nan_f64x4(low, x);
+            high = max_nan_f64x4(high, x);
+        }
+        double lows[4];
+        double highs[4];
+        _mm256_storeu_pd(lows, low);
+        _mm256_storeu_pd(highs, high);
+        if (needs.sum) {
+            acc->sum.f += sc_hsum_f64x4(sum);
+        }
+        for (int l = 0; l < 4; l++) {
+            acc->min.f = SEGMENT_MIN(acc->min.f, lows[l]);
+            acc->max.f = SEGMENT_MAX(acc->max.f, highs[l]);
+        }
+        acc->count += i - start;
+    }
+    range_f64(data, i, end, needs, acc);
+}
+
+
+static void range_stats(const void* data, sc_TYPES type, uint64_t start, uint64_t end, segment_needs needs,
+                        segment_acc* acc) {
+    switch (type) {
+        case sc_float16:
+        case sc_float32: range_f32x8(data, type, start, end, needs, acc); break;
+        case sc_float64: range_f64x4((const double*)data, start, end, needs, acc); break;
+        case sc_half: range_half((const uint16_t*)data, start, end, needs, acc); break;
+        case sc_int32: range_i32((const int32_t*)data, start, end, needs, acc); break;
+        case sc_int64: range_i64((const int64_t*)data, start, end, needs, acc); break;
+        case sc_uint8: range_u8((const uint8_t*)data, start, end, needs, acc); break;
+    }
+}
+
+
+// ############
+// task args
+// ############
+
+struct segment_args {
+    const void* data;
+    sc_TYPES type;
+    uint64_t size;
+    int integer;
+    segment_needs needs;
+    segment_acc* accs;              // [segments or groups] results
+    // sorted segments
+    const uint64_t* offsets;        // [segments + 1]
+    uint64_t segments;
+    segment_acc* heads;             // [chunks] part of the segment a chunk starts in, begun in a previous chunk
+    uint64_t* head_segments;        // [chunks] UINT64_MAX when the chunk starts with a segment
+    // groups
+    const void* keys;
+    sc_TYPES key_type;
+    uint64_t groups;
+    uint64_t blocks;
+    uint64_t block_size;
+    segment_acc* tables;            // [blocks, groups]
+    int* errors;                    // [blocks] a key was out of range
+};
+
+
+static int segment_chunk_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct segment_args* args = (struct segment_args*)raw;
+    for (uint64_t c = start; c < end; c++) {
+        uint64_t first = c * SEGMENT_CHUNK;
+        uint64_t last = (first + SEGMENT_CHUNK < args->size) ? first + SEGMENT_CHUNK : args->size;
+        args->head_segments[c] = UINT64_MAX;
+        // last segment starting at or before the chunk
+        uint64_t lo = 0;
+        uint64_t hi = args->segments;
+        while (hi - lo > 1) {
+            uint64_t mid = (lo + hi) / 2;
+            if (args->offsets[mid] <= first) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        for (uint64_t s = lo; s < args->segments && args->offsets[s] < last; s++) {
+            uint64_t from = (args->offsets[s] > first) ? args->offsets[s] : first;
+            uint64_t to = (args->offsets[s + 1] < last) ? args->offsets[s + 1] : last;
+            if (from >= to) {
+                continue;
+            }
+            // the chunk holding the start of a segment owns its result
+            segment_acc* acc = (args->offsets[s] >= first) ? &args->accs[s] : &args->heads[c];
+            if (acc == &args->heads[c]) {
+                acc_init(acc, args->integer);
+                args->head_segments[c] = s;
+            }
+            range_stats(args->data, args->type, from, to, args->needs, acc);
+        }
+    }
+    return 0;
+}
+
+
+static int group_block_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct segment_args* args = (struct segment_args*)raw;
+    segment_rows_fn rows = rows_kernels[args->type][args->key_type - sc_int32];
+    for (uint64_t b = start; b < end; b++) {
+        segment_acc* table = args->tables + b * args->groups;
+        for (uint64_t g = 0; g < args->groups; g++) {
+            acc_init(&table[g], args->integer);
+        }
+        uint64_t first = b * args->block_size;
+        uint64_t last = (first + args->block_size < args->size) ? first + args->block_size : args->size;
+        args->errors[b] = rows(args->data, args->keys, first, last, args->groups, args->needs, table);
+    }
+    return 0;
+}
+
+
+static int group_merge_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct segment_args* args = (struct segment_args*)raw;
+    for (uint64_t g = start; g < end; g++) {
+        for (uint64_t b = 1; b < args->blocks; b++) {
+            acc_merge(&args->tables[g], &args->tables[b * args->groups + g], args->integer);
+        }
+    }
+    return 0;
+}
+
+
+// ##########
+// outputs
+// ##########
+
+static int check_outputs(sc_segment_outputs* outputs, uint64_t count, segment_needs* needs) {
+    CCB_NOTNULL(outputs, "outputs is NULL");
+    sc_vector* all[] = {outputs->sum, outputs->mean, outputs->count, outputs->min, outputs->max};
+    int any = 0;
+    for (int o = 0; o < 5; o++) {
+        if (all[o] == NULL) {
+            continue;
+        }
+        any = 1;
+        if (all[o]->size != count) {
+            CCB_ERROR("outputs must have %" PRIu64 " elements, got %" PRIu64, count, all[o]->size);
+            return -1;
+        }
+    }
+    if (!any) {
+        CCB_ERROR("at least one output is needed");
+        return -1;
+    }
+    needs->sum = outputs->sum != NULL || outputs->mean != NULL;
+    needs->min = outputs->min != NULL;
+    needs->max = outputs->max != NULL;
+    return 0;
+}
+
+
+// statistics in their natural type (float64 or int64) converted to the type of every output
+static int write_outputs(const segment_acc* accs, uint64_t count, int integer, sc_segment_outputs* outputs,
+                         ccb_arena* arena) {
+    double* real = (double*)ccb_arena_malloc(arena, count * sizeof(double));
+    int64_t* whole = (int64_t*)ccb_arena_malloc(arena, count * sizeof(int64_t));
+    if (real == NULL || whole == NULL) {
+        CCB_ERROR("Failed to allocate segment outputs");
+        return -1;
+    }
+    sc_vector* targets[] = {outputs->sum, outputs->mean, outputs->count, outputs->min, outputs->max};
+    for (int o = 0; o < 5; o++) {
+        sc_vector* target = targets[o];
+        if (target == NULL) {
+            continue;
+        }
+        // mean is always float64, count always int64, the others follow the values
+        int as_integer = (o == 2) || (o != 1 && integer);
+        for (uint64_t g = 0; g < count; g++) {
+            const segment_acc* acc = &accs[g];
+            int empty = (acc->count == 0);
+            switch (o) {
+                case 0:
+                    if (integer) whole[g] = acc->sum.i;
+                    else real[g] = acc->sum.f;
+                    break;
+                case 1:
+                    real[g] = empty ? NAN : (integer ? (double)acc->sum.i : acc->sum.f) / (double)acc->count;
+                    break;
+                case 2:
+                    whole[g] = (int64_t)acc->count;
+                    break;
+                case 3:
+                    if (integer) whole[g] = empty ? 0 : acc->min.i;
+                    else real[g] = empty ? NAN : acc->min.f;
+                    break;
+                default:
+                    if (integer) whole[g] = empty ? 0 : acc->max.i;
+                    else real[g] = empty ? NAN : acc->max.f;
+                    break;
+            }
+        }
+        int status = as_integer ? sc_convert_buffer(whole, sc_int64, target->data, target->type, count)
+                                : sc_convert_buffer(real, sc_float64, target->data, target->type, count);
+        if (status != 0) {
+            CCB_ERROR("Failed to convert a segment output");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+int sc_segment_reduce(sc_vector* values, sc_vector* offsets, sc_segment_outputs* outputs, ccb_arena* arena) {
+    CCB_NOTNULL(values, "values is NULL");
+    CCB_NOTNULL(offsets, "offsets is NULL");
+    if ((offsets->type != sc_int32 && offsets->type != sc_int64) || offsets->size == 0) {
+        CCB_ERROR("offsets must be a non empty int32 or int64 vector");
+        return -1;
+    }
+    struct segment_args args;
+    memset(&args, 0, sizeof(args));
+    args.segments = offsets->size - 1;
+    if (check_outputs(outputs, args.segments, &args.needs) != 0) {
+        return -1;
+    }
+    int64_t* bounds = (int64_t*)ccb_arena_malloc(arena, offsets->size * sizeof(int64_t));
+    CCB_NOTNULL(bounds, "Failed to allocate segment offsets");
+    sc_convert_buffer(offsets->data, offsets->type, bounds, sc_int64, offsets->size);
+    for (uint64_t s = 0; s < offsets->size; s++) {
+        if (bounds[s] < 0 || (s > 0 && bounds[s] < bounds[s - 1]) || (uint64_t)bounds[s] > values->size) {
+            CCB_ERROR("offsets must be non decreasing in [0, %" PRIu64 "], got %" PRId64 " at %" PRIu64, values->size, bounds[s], s);
+            return -1;
+        }
+    }
+    args.data = values->data;
+    args.type = values->type;
+    args.size = (uint64_t)bounds[args.segments];
+    args.integer = is_integer(values->type);
+    args.offsets = (const uint64_t*)bounds;
+    uint64_t chunks = (args.size + SEGMENT_CHUNK - 1) / SEGMENT_CHUNK;
+    args.accs = (segment_acc*)ccb_arena_malloc(arena, (args.segments + 1) * sizeof(segment_acc));
+    args.heads = (segment_acc*)ccb_arena_malloc(arena, (chunks + 1) * sizeof(segment_acc));
+    args.head_segments = (uint64_t*)ccb_arena_malloc(arena, (chunks + 1) * sizeof(uint64_t));
+    if (args.accs == NULL || args.heads == NULL || args.head_segments == NULL) {
+        CCB_ERROR("Failed to allocate segment statistics");
+        return -1;
+    }
+    for (uint64_t s = 0; s < args.segments; s++) {
+        acc_init(&args.accs[s], args.integer);
+    }
+    if (sc_run_range_task(segment_chunk_kernel, &args, chunks, args.size, arena) != 0) {
+        CCB_ERROR("Failed to reduce segments");
+        return -1;
+    }
+    for (uint64_t c = 0; c < chunks; c++) {
+        if (args.head_segments[c] != UINT64_MAX) {
+            acc_merge(&args.accs[args.head_segments[c]], &args.heads[c], args.integer);
+        }
+    }
+    return write_outputs(args.accs, args.segments, args.integer, outputs, arena);
+}
+
+
+int sc_group_reduce(sc_vector* values, sc_vector* keys, uint64_t groups, sc_segment_outputs* outputs, ccb_arena* arena) {
+    CCB_NOTNULL(values, "values is NULL");
+    CCB_NOTNULL(keys, "keys is NULL");
+    if (!is_integer(keys->type) || keys->size != values->size) {
+        CCB_ERROR("keys must be an integer vector of the size of the values");
+        return -1;
+    }
+    if (groups == 0) {
+        CCB_ERROR("groups must be positive");
+        return -1;
+    }
+    struct segment_args args;
+    memset(&args, 0, sizeof(args));
+    if (check_outputs(outputs, groups, &args.needs) != 0) {
+        return -1;
+    }
+    args.data = values->data;
+    args.type = values->type;
+    args.size = values->size;
+    args.integer = is_integer(values->type);
+    args.keys = keys->data;
+    args.key_type = keys->type;
+    args.groups = groups;
+    // one private table per block, fewer blocks than threads when the tables would outweigh the rows
+    uint64_t threads = sc_get_engine_thread_count();
+    uint64_t fill = values->size / groups;
+    args.blocks = (fill < threads) ? fill : threads;
+    args.blocks = (args.blocks == 0 || values->size < SEGMENT_CHUNK) ? 1 : args.blocks;
+    args.block_size = (values->size + args.blocks - 1) / args.blocks;
+    args.tables = (segment_acc*)ccb_arena_malloc(arena, args.blocks * groups * sizeof(segment_acc));
+    args.errors = (int*)ccb_arena_malloc(arena, args.blocks * sizeof(int));
+    if (args.tables == NULL || args.errors == NULL) {
+        CCB_ERROR("Failed to allocate group tables");
+        return -1;
+    }
+    memset(args.errors, 0, args.blocks * sizeof(int));
+    if (sc_run_range_task(group_block_kernel, &args, args.blocks, values->size, arena) != 0) {
+        CCB_ERROR("Failed to accumulate groups");
+        return -1;
+    }
+    for (uint64_t b = 0; b < args.blocks; b++) {
+        if (args.errors[b]) {
+            CCB_ERROR("keys must be lower than %" PRIu64 " groups", groups);
+            return -1;
+        }
+    }
+    if (args.blocks > 1 && sc_run_range_task(group_merge_kernel, &args, groups, groups * args.blocks, arena) != 0) {
+        CCB_ERROR("Failed to merge group tables");
+        return -1;
+    }
+    return write_outputs(args.tables, groups, args.integer, outputs, arena);
+}
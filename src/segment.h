@@ -0,0 +1,48 @@
+#ifndef __SEGMENT_H__
+#define __SEGMENT_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    per segment / per group reductions (sum, mean, count, min, max) of a value vector of any type
+    - segments: sorted rows, segment s is values[offsets[s], offsets[s + 1]), the values are cut in fixed chunks,
+      a chunk reduces every segment it holds with AVX kernels (float32, bfloat16, float64) and only the segment
+      it starts in (begun in a previous chunk) is merged afterwards
+    - groups: unsorted integer keys, every thread accumulates its rows into a private table of the groups, the
+      tables are merged group by group at the end
+    float values accumulate in float64, integer values in int64 (sums wrap around), the results are converted to
+    the type of every output vector, empty segments have a count and a sum of 0, a NaN mean, min and max for
+    float values (0 for integer values)
+    NaN values propagate to the sum, mean, min and max of their segment
+*/
+
+typedef struct {
+    sc_vector* sum;         // [segments] any type, can be NULL
+    sc_vector* mean;        // can be NULL
+    sc_vector* count;       // rows of every segment, can be NULL
+    sc_vector* min;         // can be NULL
+    sc_vector* max;         // can be NULL
+} sc_segment_outputs;
+
+
+/* Reductions of sorted segments given by offsets
+   - sc_vector* values: vector of any type
+   - sc_vector* offsets: [segments + 1] int32 or int64 non decreasing offsets, the last one at most values->size
+   - sc_segment_outputs* outputs: preallocated outputs of segments elements, at least one not NULL
+   - ccb_arena* arena: arena where the scratch and the tasks will be allocated
+   - return: 0 on success
+*/
+int sc_segment_reduce(sc_vector* values, sc_vector* offsets, sc_segment_outputs* outputs, ccb_arena* arena);
+/* Group by reductions of unsorted keys
+   - sc_vector* keys: int32, int64 or uint8 group of every value, same size as values, rows with a negative key
+     are skipped
+   - uint64_t groups: number of groups, every key must be lower
+   - sc_segment_outputs* outputs: preallocated outputs of groups elements, at least one not NULL
+   - return: 0 on success, -1 on error (a key out of range included)
+*/
+int sc_group_reduce(sc_vector* values, sc_vector* keys, uint64_t groups, sc_segment_outputs* outputs, ccb_arena* arena);
+
+
+#endif // __SEGMENT_H__
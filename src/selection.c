@@ -0,0 +1,878 @@
+#include "data.h"
+#include "selection.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+
+// elements of a work unit of the flat kernels
+#define SELECTION_CHUNK 65536
+// float32 lane indices are exact below 2^24
+#define SELECTION_LANE_BLOCK (1ull << 24)
+// nth element ranges sorted by insertion
+#define SELECTION_SMALL 16
+// bytes of the widest key (float64, int64)
+#define SELECTION_KEY_SIZE 8
+// adjacent lines of an inner axis reduced together
+#define SELECTION_TILE 256
+
+// x ranks before b: smaller (or larger) and NaN after everything, the NaN terms vanish for the integer types
+#define SELECTION_BETTER(x, b, largest) ((((largest) ? (x) > (b) : (x) < (b))) || ((x) == (x) && (b) != (b)))
+
+#define SELECTION_LOAD_SAME(v) (v)
+#define SELECTION_LOAD_BF16(v) sc_bf16_bits_to_f32(v)
+#define SELECTION_LOAD_HALF(v) sc_half_bits_to_f32(v)
+
+
+static inline uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+
+/*
+    bounded heaps of (key, index) pairs with the worst pair at the root, one instance per key type
+*/
+#define SELECTION_HEAP(KS, KT)                                                                                 \
+static inline int worse_##KS(KT key_a, uint64_t ia, KT key_b, uint64_t ib, int largest) {                      \
+    return SELECTION_BETTER(key_b, key_a, largest) || (!SELECTION_BETTER(key_a, key_b, largest) && ia > ib);   \
+}                                                                                                              \
+                                                                                                               \
+static void sift_down_##KS(KT* keys, uint64_t* ids, uint64_t count, uint64_t i, int largest) {                 \
+    for (;;) {                                                                                                 \
+        uint64_t top = i;                                                                                      \
+        uint64_t l = 2 * i + 1;                                                                                \
+        uint64_t r = l + 1;                                                                                    \
+        if (l < count && worse_##KS(keys[l], ids[l], keys[top], ids[top], largest)) top = l;                   \
+        if (r < count && worse_##KS(keys[r], ids[r], keys[top], ids[top], largest)) top = r;                   \
+        if (top == i) {                                                                                        \
+            return;                                                                                            \
+        }                                                                                                      \
+        KT key = keys[i];                                                                                      \
+        uint64_t id = ids[i];                                                                                  \
+        keys[i] = keys[top];                                                                                   \
+        ids[i] = ids[top];                                                                                     \
+        keys[top] = key;                                                                                       \
+        ids[top] = id;                                                                                         \
+        i = top;                                                                                               \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static inline void push_##KS(KT* keys, uint64_t* ids, uint64_t* count, uint64_t k, KT key, uint64_t id,        \
+                             int largest) {                                                                    \
+    if (*count < k) {                                                                                          \
+        uint64_t i = (*count)++;                                                                               \
+        while (i > 0 && worse_##KS(key, id, keys[(i - 1) / 2], ids[(i - 1) / 2], largest)) {                   \
+            keys[i] = keys[(i - 1) / 2];                                                                       \
+            ids[i] = ids[(i - 1) / 2];                                                                         \
+            i = (i - 1) / 2;                                                                                   \
+        }                                                                                                      \
+        keys[i] = key;                                                                                         \
+        ids[i] = id;                                                                                           \
+    } else if (worse_##KS(keys[0], ids[0], key, id, largest)) {                                                \
+        keys[0] = key;                                                                                         \
+        ids[0] = id;                                                                                           \
+        sift_down_##KS(keys, ids, k, 0, largest);                                                              \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+/* sorts a heap in place, best first */                                                                        \
+static void sort_heap_##KS(KT* keys, uint64_t* ids, uint64_t count, int largest) {                             \
+    for (uint64_t n = count; n > 1; n--) {                                                                     \
+        KT key = keys[0];                                                                                      \
+        uint64_t id = ids[0];                                                                                  \
+        keys[0] = keys[n - 1];                                                                                 \
+        ids[0] = ids[n - 1];                                                                                   \
+        keys[n - 1] = key;                                                                                     \
+        ids[n - 1] = id;                                                                                       \
+        sift_down_##KS(keys, ids, n - 1, 0, largest);                                                          \
+    }                                                                                                          \
+}
+
+SELECTION_HEAP(f32, float)
+SELECTION_HEAP(f64, double)
+SELECTION_HEAP(i32, int32_t)
+SELECTION_HEAP(i64, int64_t)
+SELECTION_HEAP(u8, uint8_t)
+
+
+/*
+    scalar scans of a strided line, one instance per storage type: argmin / argmax, top k pushes and the
+    quickselect of nth_element (median of three pseudo random pivots, three way partition)
+*/
+#define SELECTION_SCAN(SUFFIX, ST, KS, KT, LOAD)                                                               \
+static void argbest_##SUFFIX(const ST* data, uint64_t start, uint64_t end, uint64_t stride, int largest,       \
+                             uint64_t* index) {                                                                \
+    KT best = LOAD(data[start * stride]);                                                                      \
+    uint64_t at = start;                                                                                       \
+    for (uint64_t i = start + 1; i < end; i++) {                                                               \
+        KT x = LOAD(data[i * stride]);                                                                         \
+        if (SELECTION_BETTER(x, best, largest)) {                                                              \
+            best = x;                                                                                          \
+            at = i;                                                                                            \
+        }                                                                                                      \
+    }                                                                                                          \
+    *index = at;                                                                                               \
+}                                                                                                              \
+                                                                                                               \
+static void topk_##SUFFIX(const ST* data, uint64_t start, uint64_t end, uint64_t stride, uint64_t k,           \
+                          int largest, KT* keys, uint64_t* ids, uint64_t* count) {                             \
+    for (uint64_t i = start; i < end; i++) {                                                                   \
+        push_##KS(keys, ids, count, k, LOAD(data[i * stride]), i, largest);                                    \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+/* argmin / argmax of count adjacent lines of an inner axis, the rows are read contiguously */                 \
+static void argbest_tile_##SUFFIX(const ST* data, uint64_t length, uint64_t inner, uint64_t count, int largest, \
+                                  uint64_t* indices) {                                                         \
+    KT best[SELECTION_TILE];                                                                                   \
+    for (uint64_t c = 0; c < count; c++) {                                                                     \
+        best[c] = LOAD(data[c]);                                                                               \
+        indices[c] = 0;                                                                                        \
+    }                                                                                                          \
+    for (uint64_t l = 1; l < length; l++) {                                                                    \
+        const ST* row = data + l * inner;                                                                      \
+        for (uint64_t c = 0; c < count; c++) {                                                                 \
+            KT x = LOAD(row[c]);                                                                               \
+            if (SELECTION_BETTER(x, best[c], largest)) {                                                       \
+                best[c] = x;                                                                                   \
+                indices[c] = l;                                                                                \
+            }                                                                                                  \
+        }                                                                                                      \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static inline int less_##SUFFIX(ST a, ST b) {                                                                  \
+    KT x = LOAD(a);                                                                                            \
+    KT y = LOAD(b);                                                                                            \
+    return SELECTION_BETTER(x, y, 0);                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static void nth_##SUFFIX(ST* data, uint64_t count, uint64_t stride, uint64_t n) {                              \
+    uint64_t lo = 0;                                                                                           \
+    uint64_t hi = count;                                                                                       \
+    uint64_t round = 0;                                                                                        \
+    while (hi - lo > SELECTION_SMALL) {                                                                        \
+        uint64_t length = hi - lo;                                                                             \
+        uint64_t h = mix((lo << 32) ^ hi ^ (++round << 56));                                                   \
+        ST a = data[(lo + h % length) * stride];                                                               \
+        ST b = data[(lo + (h >> 21) % length) * stride];                                                       \
+        ST c = data[(lo + (h >> 42) % length) * stride];                                                       \
+        ST pivot = less_##SUFFIX(a, b) ? (less_##SUFFIX(b, c) ? b : (less_##SUFFIX(a, c) ? c : a))             \
+                                       : (less_##SUFFIX(a, c) ? a : (less_##SUFFIX(b, c) ? c : b));            \
+        /* [lo, lt) before the pivot, [lt, i) equal, [gt, hi) after */                                         \
+        uint64_t lt = lo;                                                                                      \
+        uint64_t gt = hi;                                                                                      \
+        uint64_t i = lo;                                                                                       \
+        while (i < gt) {                                                                                       \
+            ST x = data[i * stride];                                                                           \
+            if (less_##SUFFIX(x, pivot)) {                                                                     \
+                data[i * stride] = data[lt * stride];                                                          \
+                data[lt * stride] = x;                                                                         \
+                lt++;                                                                                          \
+                i++;                                                                                           \
+            } else if (less_##SUFFIX(pivot, x)) {                                                              \
+                gt--;                                                                                          \
+                data[i * stride] = data[gt * stride];                                                          \
+                data[gt * stride] = x;                                                                         \
+            } else {                                                                                           \
+                i++;                                                                                           \
+            }                                                                                                  \
+        }                                                                                                      \
+        if (n < lt) {                                                                                          \
+            hi = lt;                                                                                           \
+        } else if (n >= gt) {                                                                                  \
+            lo = gt;                                                                                           \
+        } else {                                                                                               \
+            return;                                                                                            \
+        }                                                                                                      \
+    }                                                                                                          \
+    for (uint64_t i = lo + 1; i < hi; i++) {                                                                   \
+        ST x = data[i * stride];                                                                               \
+        uint64_t j = i;                                                                                        \
+        for (; j > lo && less_##SUFFIX(x, data[(j - 1) * stride]); j--) {                                      \
+            data[j * stride] = data[(j - 1) * stride];                                                         \
+        }                                                                                                      \
+        data[j * stride] = x;                                                                                  \
+    }                                                                                                          \
+}
+
+SELECTION_SCAN(bf16, uint16_t, f32, float, SELECTION_LOAD_BF16)
+SELECTION_SCAN(half, uint16_t, f32, float, SELECTION_LOAD_HALF)
+SELECTION_SCAN(f32, float, f32, float, SELECTION_LOAD_SAME)
+SELECTION_SCAN(f64, double, f64, double, SELECTION_LOAD_SAME)
+SELECTION_SCAN(i32, int32_t, i32, int32_t, SELECTION_LOAD_SAME)
+SELECTION_SCAN(i64, int64_t, i64, int64_t, SELECTION_LOAD_SAME)
+SELECTION_SCAN(u8, uint8_t, u8, uint8_t, SELECTION_LOAD_SAME)
+
+
+// #############
+// AVX kernels
+// #############
+
+static inline __m256 better_f32x8(__m256 x, __m256 best, int largest) {
+    __m256 strict = largest ? _mm256_cmp_ps(x, best, _CMP_GT_OQ) : _mm256_cmp_ps(x, best, _CMP_LT_OQ);
+    __m256 over_nan = _mm256_andnot_ps(_mm256_cmp_ps(x, x, _CMP_UNORD_Q), _mm256_cmp_ps(best, best, _CMP_UNORD_Q));
+    return _mm256_or_ps(strict, over_nan);
+}
+
+
+// bitwise select: gcc folds a blendv of a combined compare mask into per lane branches
+static inline __m256 select_f32x8(__m256 a, __m256 b, __m256 mask) {
+    return _mm256_or_ps(_mm256_and_ps(mask, b), _mm256_andnot_ps(mask, a));
+}
+
+
+static inline __m256d select_f64x4(__m256d a, __m256d b, __m256d mask) {
+    return _mm256_or_pd(_mm256_and_pd(mask, b), _mm256_andnot_pd(mask, a));
+}
+
+
+static inline __m256d better_f64x4(__m256d x, __m256d best, int largest) {
+    __m256d strict = largest ? _mm256_cmp_pd(x, best, _CMP_GT_OQ) : _mm256_cmp_pd(x, best, _CMP_LT_OQ);
+    __m256d over_nan = _mm256_andnot_pd(_mm256_cmp_pd(x, x, _CMP_UNORD_Q), _mm256_cmp_pd(best, best, _CMP_UNORD_Q));
+    return _mm256_or_pd(strict, over_nan);
+}
+
+
+/*
+    four accumulators of lanes (so four independent compare and blend chains) keep their best value and the
+    index where it was seen (as a float, so blocks of 2^24 elements), a lane only takes strictly better values
+    so it keeps its first index, the ties between lanes and blocks go to the lowest index
+    one instance per load and direction keeps the accumulators in registers
+*/
+#define SELECTION_LANE_STEP(VT, BETTER, BLEND, ADD, best, lane, current, x, step, largest)                     \
+    {                                                                                                          \
+        current = ADD(current, step);                                                                          \
+        VT mask = BETTER(x, best, largest);                                                                    \
+        best = BLEND(best, x, mask);                                                                           \
+        lane = BLEND(lane, current, mask);                                                                     \
+    }
+
+#define SELECTION_ARGBEST_F32X8(SUFFIX, TYPE, LARGEST)                                                         \
+static void argbest_block_##SUFFIX(const void* data, uint64_t start, uint64_t end, float* keys, float* offsets) { \
+    __m256 step = _mm256_set1_ps(32.0f);                                                                       \
+    __m256 c0 = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);                                 \
+    __m256 c1 = _mm256_add_ps(c0, _mm256_set1_ps(8.0f));                                                       \
+    __m256 c2 = _mm256_add_ps(c0, _mm256_set1_ps(16.0f));                                                      \
+    __m256 c3 = _mm256_add_ps(c0, _mm256_set1_ps(24.0f));                                                      \
+    __m256 b0 = sc_load_f32x8(data, start, TYPE);                                                              \
+    __m256 b1 = sc_load_f32x8(data, start + 8, TYPE);                                                          \
+    __m256 b2 = sc_load_f32x8(data, start + 16, TYPE);                                                         \
+    __m256 b3 = sc_load_f32x8(data, start + 24, TYPE);                                                         \
+    __m256 l0 = c0, l1 = c1, l2 = c2, l3 = c3;                                                                 \
+    for (uint64_t j = start + 32; j < end; j += 32) {                                                          \
+        __m256 x0 = sc_load_f32x8(data, j, TYPE);                                                              \
+        __m256 x1 = sc_load_f32x8(data, j + 8, TYPE);                                                          \
+        __m256 x2 = sc_load_f32x8(data, j + 16, TYPE);                                                         \
+        __m256 x3 = sc_load_f32x8(data, j + 24, TYPE);                                                         \
+        SELECTION_LANE_STEP(__m256, better_f32x8, select_f32x8, _mm256_add_ps, b0, l0, c0, x0, step, LARGEST)  \
+        SELECTION_LANE_STEP(__m256, better_f32x8, select_f32x8, _mm256_add_ps, b1, l1, c1, x1, step, LARGEST)  \
+        SELECTION_LANE_STEP(__m256, better_f32x8, select_f32x8, _mm256_add_ps, b2, l2, c2, x2, step, LARGEST)  \
+        SELECTION_LANE_STEP(__m256, better_f32x8, select_f32x8, _mm256_add_ps, b3, l3, c3, x3, step, LARGEST)  \
+    }                                                                                                          \
+    _mm256_storeu_ps(keys, b0);                                                                                \
+    _mm256_storeu_ps(keys + 8, b1);                                                                            \
+    _mm256_storeu_ps(keys + 16, b2);                                                                           \
+    _mm256_storeu_ps(keys + 24, b3);                                                                           \
+    _mm256_storeu_ps(offsets, l0);                                                                             \
+    _mm256_storeu_ps(offsets + 8, l1);                                                                         \
+    _mm256_storeu_ps(offsets + 16, l2);                                                                        \
+    _mm256_storeu_ps(offsets + 24, l3);                                                                        \
+}
+
+#define SELECTION_ARGBEST_F64X4(SUFFIX, LARGEST)                                                               \
+static void argbest_block_##SUFFIX(const double* data, uint64_t start, uint64_t end, double* keys, double* offsets) { \
+    __m256d step = _mm256_set1_pd(16.0);                                                                       \
+    __m256d c0 = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);                                                            \
+    __m256d c1 = _mm256_add_pd(c0, _mm256_set1_pd(4.0));                                                       \
+    __m256d c2 = _mm256_add_pd(c0, _mm256_set1_pd(8.0));                                                       \
+    __m256d c3 = _mm256_add_pd(c0, _mm256_set1_pd(12.0));                                                      \
+    __m256d b0 = _mm256_loadu_pd(data + start);                                                                \
+    __m256d b1 = _mm256_loadu_pd(data + start + 4);                                                            \
+    __m256d b2 = _mm256_loadu_pd(data + start + 8);                                                            \
+    __m256d b3 = _mm256_loadu_pd(data + start + 12);                                                           \
+    __m256d l0 = c0, l1 = c1, l2 = c2, l3 = c3;                                                                \
+    for (uint64_t j = start + 16; j < end; j += 16) {                                                          \
+        __m256d x0 = _mm256_loadu_pd(data + j);                                                                \
+        __m256d x1 = _mm256_loadu_pd(data + j + 4);                                                            \
+        __m256d x2 = _mm256_loadu_pd(data + j + 8);                                                            \
+        __m256d x3 = _mm256_loadu_pd(data + j + 12);                                                           \
+        SELECTION_LANE_STEP(__m256d, better_f64x4, select_f64x4, _mm256_add_pd, b0, l0, c0, x0, step, LARGEST) \
+        SELECTION_LANE_STEP(__m256d, better_f64x4, select_f64x4, _mm256_add_pd, b1, l1, c1, x1, step, LARGEST) \
+        SELECTION_LANE_STEP(__m256d, better_f64x4, select_f64x4, _mm256_add_pd, b2, l2, c2, x2, step, LARGEST) \
+        SELECTION_LANE_STEP(__m256d, better_f64x4, select_f64x4, _mm256_add_pd, b3, l3, c3, x3, step, LARGEST) \
+    }                                                                                                          \
+    _mm256_storeu_pd(keys, b0);                                                                                \
+    _mm256_storeu_pd(keys + 4, b1);                                                                            \
+    _mm256_storeu_pd(keys + 8, b2);                                                                            \
+    _mm256_storeu_pd(keys + 12, b3);                                                                           \
+    _mm256_storeu_pd(offsets, l0);                                                                             \
+    _mm256_storeu_pd(offsets + 4, l1);                                                                         \
+    _mm256_storeu_pd(offsets + 8, l2);                                                                         \
+    _mm256_storeu_pd(offsets + 12, l3);                                                                        \
+}
+
+SELECTION_ARGBEST_F32X8(f32_min, sc_float32, 0)
+SELECTION_ARGBEST_F32X8(f32_max, sc_float32, 1)
+SELECTION_ARGBEST_F32X8(bf16_min, sc_float16, 0)
+SELECTION_ARGBEST_F32X8(bf16_max, sc_float16, 1)
+SELECTION_ARGBEST_F64X4(f64_min, 0)
+SELECTION_ARGBEST_F64X4(f64_max, 1)
+
+
+#define SELECTION_REDUCE_LANES(keys, offsets, count, base, largest, best, at)                                  \
+    for (uint64_t l = 0; l < (count); l++) {                                                                   \
+        uint64_t candidate = (base) + (uint64_t)(offsets)[l];                                                  \
+        if (SELECTION_BETTER((keys)[l], best, largest) ||                                                      \
+            (!SELECTION_BETTER(best, (keys)[l], largest) && candidate < (at))) {                               \
+            best = (keys)[l];                                                                                  \
+            at = candidate;                                                                                    \
+        }                                                                                                      \
+    }
+
+
+static void argbest_f32x8(const void* data, sc_TYPES type, uint64_t start, uint64_t end, int largest, uint64_t* index) {
+    float best = sc_load_f32(data, start, type);
+    uint64_t at = start;
+    uint64_t i = start;
+    while (end - i >= 64) {
+        uint64_t length = (end - i < SELECTION_LANE_BLOCK) ? end - i : SELECTION_LANE_BLOCK;
+        uint64_t block_end = i + length / 32 * 32;
+        float keys[32];
+        float offsets[32];
+        if (type == sc_float16) {
+            (largest ? argbest_block_bf16_max : argbest_block_bf16_min)(data, i, block_end, keys, offsets);
+        } else {
+            (largest ? argbest_block_f32_max : argbest_block_f32_min)(data, i, block_end, keys, offsets);
+        }
+        SELECTION_REDUCE_LANES(keys, offsets, 32, i, largest, best, at)
+        i = block_end;
+    }
+    for (; i < end; i++) {
+        float x = sc_load_f32(data, i, type);
+        if (SELECTION_BETTER(x, best, largest)) {
+            best = x;
+            at = i;
+        }
+    }
+    *index = at;
+}
+
+
+static void argbest_f64x4(const double* data, uint64_t start, uint64_t end, int largest, uint64_t* index) {
+    double best = data[start];
+    uint64_t at = start;
+    uint64_t i = start;
+    if (end - i >= 32) {
+        uint64_t block_end = i + (end - i) / 16 * 16;
+        double keys[16];
+        double offsets[16];
+        (largest ? argbest_block_f64_max : argbest_block_f64_min)(data, i, block_end, keys, offsets);
+        SELECTION_REDUCE_LANES(keys, offsets, 16, i, largest, best, at)
+        i = block_end;
+    }
+    for (; i < end; i++) {
+        if (SELECTION_BETTER(data[i], best, largest)) {
+            best = data[i];
+            at = i;
+        }
+    }
+    *index = at;
+}
+
+
+// once the heap is full only the lanes beating its root are pushed
+static void topk_f32x8(const void* data, sc_TYPES type, uint64_t start, uint64_t end, uint64_t k, int largest, float* keys,
+                       uint64_t* ids, uint64_t* count) {
+    uint64_t i = start;
+    for (; i < end && *count < k; i++) {
+        push_f32(keys, ids, count, k, sc_load_f32(data, i, type), i, largest);
+    }
+    for (; i + 8 <= end; i += 8) {
+        __m256 x = sc_load_f32x8(data, i, type);
+        int mask = _mm256_movemask_ps(better_f32x8(x, _mm256_set1_ps(keys[0]), largest));
+        if (mask == 0) {
+            continue;
+        }
+        float values[8];
+        _mm256_storeu_ps(values, x);
+        for (; mask != 0; mask &= mask - 1) {
+            int l = __builtin_ctz(mask);
+            push_f32(keys, ids, count, k, values[l], i + l, largest);
+        }
+    }
+    for (; i < end; i++) {
+        push_f32(keys, ids, count, k, sc_load_f32(data, i, type), i, largest);
+    }
+}
+
+
+static void topk_f64x4(const double* data, uint64_t start, uint64_t end, uint64_t k, int largest, double* keys,
+                       uint64_t* ids, uint64_t* count) {
+    uint64_t i = start;
+    for (; i < end && *count < k; i++) {
+        push_f64(keys, ids, count, k, data[i], i, largest);
+    }
+    for (; i + 4 <= end; i += 4) {
+        int mask = _mm256_movemask_pd(better_f64x4(_mm256_loadu_pd(data + i), _mm256_set1_pd(keys[0]), largest));
+        for (; mask != 0; mask &= mask - 1) {
+            int l = __builtin_ctz(mask);
+            push_f64(keys, ids, count, k, data[i + l], i + l, largest);
+        }
+    }
+    for (; i < end; i++) {
+        push_f64(keys, ids, count, k, data[i], i, largest);
+    }
+}
+
+
+// ##########
+// dispatch
+// ##########
+
+static void argbest_line(const void* data, sc_TYPES type, uint64_t start, uint64_t end, uint64_t stride, int largest,
+                         uint64_t* index) {
+    if (stride == 1 && (type == sc_float32 || type == sc_float16)) {
+        argbest_f32x8(data, type, start, end, largest, index);
+        return;
+    }
+    if (stride == 1 && type == sc_float64) {
+        argbest_f64x4((const double*)data, start, end, largest, index);
+        return;
+    }
+    switch (type) {
+        case sc_float16: argbest_bf16((const uint16_t*)data, start, end, stride, largest, index); break;
+        case sc_half: argbest_half((const uint16_t*)data, start, end, stride, largest, index); break;
+        case sc_float32: argbest_f32((const float*)data, start, end, stride, largest, index); break;
+        case sc_float64: argbest_f64((const double*)data, start, end, stride, largest, index); break;
+        case sc_int32: argbest_i32((const int32_t*)data, start, end, stride, largest, index); break;
+        case sc_int64: argbest_i64((const int64_t*)data, start, end, stride, largest, index); break;
+        case sc_uint8: argbest_u8((const uint8_t*)data, start, end, stride, largest, index); break;
+    }
+}
+
+
+static void topk_line(const void* data, sc_TYPES type, uint64_t start, uint64_t end, uint64_t stride, uint64_t k, int largest,
+                      void* keys, uint64_t* ids, uint64_t* count) {
+    if (stride == 1 && (type == sc_float32 || type == sc_float16)) {
+        topk_f32x8(data, type, start, end, k, largest, (float*)keys, ids, count);
+        return;
+    }
+    if (stride == 1 && type == sc_float64) {
+        topk_f64x4((const double*)data, start, end, k, largest, (double*)keys, ids, count);
+        return;
+    }
+    switch (type) {
+        case sc_float16: topk_bf16((const uint16_t*)data, start, end, stride, k, largest, (float*)keys, ids, count); break;
+        case sc_half: topk_half((const uint16_t*)data, start, end, stride, k, largest, (float*)keys, ids, count); break;
+        case sc_float32: topk_f32((const float*)data, start, end, stride, k, largest, (float*)keys, ids, count); break;
+        case sc_float64: topk_f64((const double*)data, start, end, stride, k, largest, (double*)keys, ids, count); break;
+        case sc_int32: topk_i32((const int32_t*)data, start, end, stride, k, largest, (int32_t*)keys, ids, count); break;
+        case sc_int64: topk_i64((const int64_t*)data, start, end, stride, k, largest, (int64_t*)keys, ids, count); break;
+        case sc_uint8: topk_u8((const uint8_t*)data, start, end, stride, k, largest, (uint8_t*)keys, ids, count); break;
+    }
+}
+
+
+static void sort_line(sc_TYPES type, void* keys, uint64_t* ids, uint64_t count, int largest) {
+    switch (type) {
+        case sc_float16:
+        case sc_half:
+        case sc_float32: sort_heap_f32((float*)keys, ids, count, largest); break;
+        case sc_float64: sort_heap_f64((double*)keys, ids, count, largest); break;
+        case sc_int32: sort_heap_i32((int32_t*)keys, ids, count, largest); break;
+        case sc_int64: sort_heap_i64((int64_t*)keys, ids, count, largest); break;
+        case sc_uint8: sort_heap_u8((uint8_t*)keys, ids, count, largest); break;
+    }
+}
+
+
+static void argbest_tile(const void* data, sc_TYPES type, uint64_t length, uint64_t inner, uint64_t count, int largest,
+                         uint64_t* indices) {
+    switch (type) {
+        case sc_float16: argbest_tile_bf16((const uint16_t*)data, length, inner, count, largest, indices); break;
+        case sc_half: argbest_tile_half((const uint16_t*)data, length, inner, count, largest, indices); break;
+        case sc_float32: argbest_tile_f32((const float*)data, length, inner, count, largest, indices); break;
+        case sc_float64: argbest_tile_f64((const double*)data, length, inner, count, largest, indices); break;
+        case sc_int32: argbest_tile_i32((const int32_t*)data, length, inner, count, largest, indices); break;
+        case sc_int64: argbest_tile_i64((const int64_t*)data, length, inner, count, largest, indices); break;
+        case sc_uint8: argbest_tile_u8((const uint8_t*)data, length, inner, count, largest, indices); break;
+    }
+}
+
+
+static void nth_line(void* data, sc_TYPES type, uint64_t count, uint64_t stride, uint64_t n) {
+    switch (type) {
+        case sc_float16: nth_bf16((uint16_t*)data, count, stride, n); break;
+        case sc_half: nth_half((uint16_t*)data, count, stride, n); break;
+        case sc_float32: nth_f32((float*)data, count, stride, n); break;
+        case sc_float64: nth_f64((double*)data, count, stride, n); break;
+        case sc_int32: nth_i32((int32_t*)data, count, stride, n); break;
+        case sc_int64: nth_i64((int64_t*)data, count, stride, n); break;
+        case sc_uint8: nth_u8((uint8_t*)data, count, stride, n); break;
+    }
+}
+
+
+// element a ranks before element b
+static int better_at(const void* data, sc_TYPES type, uint64_t a, uint64_t b, int largest) {
+#define SELECTION_BETTER_AT(KT, LOAD, ST)                                                                      \
+    {                                                                                                          \
+        KT x = LOAD(((const ST*)data)[a]);                                                                     \
+        KT y = LOAD(((const ST*)data)[b]);                                                                     \
+        return SELECTION_BETTER(x, y, largest) || (!SELECTION_BETTER(y, x, largest) && a < b);                 \
+    }
+    switch (type) {
+        case sc_float16: SELECTION_BETTER_AT(float, SELECTION_LOAD_BF16, uint16_t)
+        case sc_half: SELECTION_BETTER_AT(float, SELECTION_LOAD_HALF, uint16_t)
+        case sc_float32: SELECTION_BETTER_AT(float, SELECTION_LOAD_SAME, float)
+        case sc_float64: SELECTION_BETTER_AT(double, SELECTION_LOAD_SAME, double)
+        case sc_int32: SELECTION_BETTER_AT(int32_t, SELECTION_LOAD_SAME, int32_t)
+        case sc_int64: SELECTION_BETTER_AT(int64_t, SELECTION_LOAD_SAME, int64_t)
+        default: SELECTION_BETTER_AT(uint8_t, SELECTION_LOAD_SAME, uint8_t)
+    }
+#undef SELECTION_BETTER_AT
+}
+
+
+// ###############
+// flat vectors
+// ###############
+
+struct flat_args {
+    const void* data;
+    sc_TYPES type;
+    uint64_t size;
+    uint64_t k;
+    int largest;
+    uint64_t* candidates;   // argmin / argmax: [chunks] best index of every chunk
+    uint8_t* keys;          // top k: [threads, k] keys of the heaps
+    uint64_t* ids;          // top k: [threads, k]
+    uint64_t* counts;       // top k: [threads]
+};
+
+
+static int flat_argbest_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct flat_args* args = (struct flat_args*)raw;
+    for (uint64_t c = start; c < end; c++) {
+        uint64_t last = ((c + 1) * SELECTION_CHUNK < args->size) ? (c + 1) * SELECTION_CHUNK : args->size;
+        argbest_line(args->data, args->type, c * SELECTION_CHUNK, last, 1, args->largest, &args->candidates[c]);
+    }
+    return 0;
+}
+
+
+static int flat_topk_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct flat_args* args = (struct flat_args*)raw;
+    uint64_t first = start * SELECTION_CHUNK;
+    uint64_t last = (end * SELECTION_CHUNK < args->size) ? end * SELECTION_CHUNK : args->size;
+    topk_line(args->data, args->type, first, last, 1, args->k, args->largest, args->keys + thread_id * args->k * SELECTION_KEY_SIZE,
+              args->ids + thread_id * args->k, &args->counts[thread_id]);
+    return 0;
+}
+
+
+static int check_vector(sc_vector* a) {
+    CCB_NOTNULL(a, "vector is NULL");
+    if (a->size == 0) {
+        CCB_ERROR("vector is empty");
+        return -1;
+    }
+    return 0;
+}
+
+
+static int vector_argbest(sc_vector* a, int largest, uint64_t* index, ccb_arena* arena) {
+    CCB_NOTNULL(index, "index is NULL");
+    if (check_vector(a) != 0) {
+        return -1;
+    }
+    uint64_t chunks = (a->size + SELECTION_CHUNK - 1) / SELECTION_CHUNK;
+    struct flat_args args = {a->data, a->type, a->size, 0, largest, NULL, NULL, NULL, NULL};
+    args.candidates = (uint64_t*)ccb_arena_malloc(arena, chunks * sizeof(uint64_t));
+    CCB_NOTNULL(args.candidates, "Failed to allocate argmin / argmax candidates");
+    if (sc_run_range_task(flat_argbest_kernel, &args, chunks, a->size, arena) != 0) {
+        CCB_ERROR("Failed to run argmin / argmax");
+        return -1;
+    }
+    uint64_t best = args.candidates[0];
+    for (uint64_t c = 1; c < chunks; c++) {
+        best = better_at(a->data, a->type, args.candidates[c], best, largest) ? args.candidates[c] : best;
+    }
+    *index = best;
+    return 0;
+}
+
+
+int sc_vector_argmin(sc_vector* a, uint64_t* index, ccb_arena* arena) {
+    return vector_argbest(a, 0, index, arena);
+}
+
+
+int sc_vector_argmax(sc_vector* a, uint64_t* index, ccb_arena* arena) {
+    return vector_argbest(a, 1, index, arena);
+}
+
+
+int sc_vector_topk(sc_vector* a, uint64_t k, int largest, uint64_t* indices, sc_vector* values, ccb_arena* arena) {
+    CCB_NOTNULL(indices, "indices is NULL");
+    if (check_vector(a) != 0) {
+        return -1;
+    }
+    if (k == 0 || k > a->size) {
+        CCB_ERROR("k must be in [1, %" PRIu64 "], got %" PRIu64, a->size, k);
+        return -1;
+    }
+    if (values != NULL && (values->type != a->type || values->size != k)) {
+        CCB_ERROR("values must have %" PRIu64 " elements of the type of the vector", k);
+        return -1;
+    }
+    uint64_t threads = sc_get_engine_thread_count();
+    struct flat_args args = {a->data, a->type, a->size, k, largest, NULL, NULL, NULL, NULL};
+    args.keys = (uint8_t*)ccb_arena_malloc(arena, threads * k * SELECTION_KEY_SIZE);
+    args.ids = (uint64_t*)ccb_arena_malloc(arena, threads * k * sizeof(uint64_t));
+    args.counts = (uint64_t*)ccb_arena_malloc(arena, threads * sizeof(uint64_t));
+    uint64_t* cursors = (uint64_t*)ccb_arena_malloc(arena, threads * sizeof(uint64_t));
+    if (args.keys == NULL || args.ids == NULL || args.counts == NULL || cursors == NULL) {
+        CCB_ERROR("Failed to allocate top k heaps");
+        return -1;
+    }
+    memset(args.counts, 0, threads * sizeof(uint64_t));
+    memset(cursors, 0, threads * sizeof(uint64_t));
+    uint64_t chunks = (a->size + SELECTION_CHUNK - 1) / SELECTION_CHUNK;
+    if (sc_run_range_task(flat_topk_kernel, &args, chunks, a->size, arena) != 0) {
+        CCB_ERROR("Failed to run top k");
+        return -1;
+    }
+
+    // merge of the sorted thread heaps, the pairs (value, index) are distinct so the result is the same for any split
+    for (uint64_t t = 0; t < threads; t++) {
+        sort_line(a->type, args.keys + t * k * SELECTION_KEY_SIZE, args.ids + t * k, args.counts[t], largest);
+    }
+    uint64_t size = sc_type_size(a->type);
+    for (uint64_t j = 0; j < k; j++) {
+        uint64_t from = UINT64_MAX;
+        for (uint64_t t = 0; t < threads; t++) {
+            if (cursors[t] < args.counts[t] &&
+                (from == UINT64_MAX || better_at(a->data, a->type, args.ids[t * k + cursors[t]], args.ids[from * k + cursors[from]], largest))) {
+                from = t;
+            }
+        }
+        indices[j] = args.ids[from * k + cursors[from]++];
+        if (values != NULL) {
+            memcpy((uint8_t*)values->data + j * size, (const uint8_t*)a->data + indices[j] * size, size);
+        }
+    }
+    return 0;
+}
+
+
+int sc_vector_nth_element(sc_vector* a, uint64_t n) {
+    if (check_vector(a) != 0) {
+        return -1;
+    }
+    if (n >= a->size) {
+        CCB_ERROR("n must be lower than %" PRIu64 ", got %" PRIu64, a->size, n);
+        return -1;
+    }
+    nth_line(a->data, a->type, a->size, 1, n);
+    return 0;
+}
+
+
+// ##############
+// tensor axes
+// ##############
+
+/*
+    a tensor is seen as [outer, length, inner] around the axis, a line is the length elements of one (outer,
+    inner) pair, lines are numbered o * inner + i
+*/
+struct axis_args {
+    uint8_t* data;
+    sc_TYPES type;
+    uint64_t outer;
+    uint64_t length;
+    uint64_t inner;
+    uint64_t k;             // top k, n of nth_element
+    int largest;
+    uint64_t* indices;
+    uint8_t* values;
+    uint8_t* keys;          // top k: [threads, k]
+    uint64_t* ids;          // top k: [threads, k]
+};
+
+
+static int axis_shape(sc_tensor* a, int64_t axis, struct axis_args* args) {
+    CCB_NOTNULL(a, "tensor is NULL");
+    int64_t count = (int64_t)a->dims->dims_count;
+    int64_t resolved = (axis < 0) ? axis + count : axis;
+    if (resolved < 0 || resolved >= count) {
+        CCB_ERROR("axis %" PRId64 " is out of range for %" PRId64 " dimensions", axis, count);
+        return -1;
+    }
+    memset(args, 0, sizeof(struct axis_args));
+    args->data = (uint8_t*)a->data;
+    args->type = a->type;
+    args->outer = 1;
+    args->inner = 1;
+    for (int64_t d = 0; d < count; d++) {
+        if (d < resolved) {
+            args->outer *= a->dims->dims[d];
+        } else if (d > resolved) {
+            args->inner *= a->dims->dims[d];
+        }
+    }
+    args->length = a->dims->dims[resolved];
+    if (args->length == 0) {
+        CCB_ERROR("axis %" PRId64 " is empty", axis);
+        return -1;
+    }
+    return 0;
+}
+
+
+static inline uint8_t* line_start(const struct axis_args* args, uint64_t line) {
+    uint64_t o = line / args->inner;
+    uint64_t i = line % args->inner;
+    return args->data + (o * args->length * args->inner + i) * sc_type_size(args->type);
+}
+
+
+static int axis_argbest_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct axis_args* args = (struct axis_args*)raw;
+    if (args->inner == 1) {
+        for (uint64_t line = start; line < end; line++) {
+            argbest_line(line_start(args, line), args->type, 0, args->length, 1, args->largest, &args->indices[line]);
+        }
+        return 0;
+    }
+    // tiles of adjacent lines that share their outer index
+    for (uint64_t line = start; line < end;) {
+        uint64_t count = args->inner - line % args->inner;
+        count = (count < end - line) ? count : end - line;
+        count = (count < SELECTION_TILE) ? count : SELECTION_TILE;
+        argbest_tile(line_start(args, line), args->type, args->length, args->inner, count, args->largest, &args->indices[line]);
+        line += count;
+    }
+    return 0;
+}
+
+
+static int axis_topk_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct axis_args* args = (struct axis_args*)raw;
+    uint8_t* keys = args->keys + thread_id * args->k * SELECTION_KEY_SIZE;
+    uint64_t* ids = args->ids + thread_id * args->k;
+    uint64_t size = sc_type_size(args->type);
+    for (uint64_t line = start; line < end; line++) {
+        const uint8_t* base = line_start(args, line);
+        uint64_t count = 0;
+        topk_line(base, args->type, 0, args->length, args->inner, args->k, args->largest, keys, ids, &count);
+        sort_line(args->type, keys, ids, count, args->largest);
+        uint64_t o = line / args->inner;
+        uint64_t i = line % args->inner;
+        for (uint64_t j = 0; j < args->k; j++) {
+            uint64_t out = (o * args->k + j) * args->inner + i;
+            args->indices[out] = ids[j];
+            if (args->values != NULL) {
+                memcpy(args->values + out * size, base + ids[j] * args->inner * size, size);
+            }
+        }
+    }
+    return 0;
+}
+
+
+static int axis_nth_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct axis_args* args = (struct axis_args*)raw;
+    for (uint64_t line = start; line < end; line++) {
+        nth_line(line_start(args, line), args->type, args->length, args->inner, args->k);
+    }
+    return 0;
+}
+
+
+static int tensor_argbest(sc_tensor* a, int64_t axis, int largest, uint64_t* indices, ccb_arena* arena) {
+    CCB_NOTNULL(indices, "indices is NULL");
+    struct axis_args args;
+    if (axis_shape(a, axis, &args) != 0) {
+        return -1;
+    }
+    args.largest = largest;
+    args.indices = indices;
+    if (sc_run_range_task(axis_argbest_kernel, &args, args.outer * args.inner, a->size, arena) != 0) {
+        CCB_ERROR("Failed to run argmin / argmax along axis %" PRId64, axis);
+        return -1;
+    }
+    return 0;
+}
+
+
+int sc_tensor_argmin(sc_tensor* a, int64_t axis, uint64_t* indices, ccb_arena* arena) {
+    return tensor_argbest(a, axis, 0, indices, arena);
+}
+
+
+int sc_tensor_argmax(sc_tensor* a, int64_t axis, uint64_t* indices, ccb_arena* arena) {
+    return tensor_argbest(a, axis, 1, indices, arena);
+}
+
+
+int sc_tensor_topk(sc_tensor* a, int64_t axis, uint64_t k, int largest, uint64_t* indices, sc_tensor* values, ccb_arena* arena) {
+    CCB_NOTNULL(indices, "indices is NULL");
+    struct axis_args args;
+    if (axis_shape(a, axis, &args) != 0) {
+        return -1;
+    }
+    if (k == 0 || k > args.length) {
+        CCB_ERROR("k must be in [1, %" PRIu64 "], got %" PRIu64, args.length, k);
+        return -1;
+    }
+    if (values != NULL && (values->type != a->type || values->size != args.outer * k * args.inner)) {
+        CCB_ERROR("values must have the shape of the tensor with %" PRIu64 " along the axis and its type", k);
+        return -1;
+    }
+    uint64_t threads = sc_get_engine_thread_count();
+    args.k = k;
+    args.largest = largest;
+    args.indices = indices;
+    args.values = values ? (uint8_t*)values->data : NULL;
+    args.keys = (uint8_t*)ccb_arena_malloc(arena, threads * k * SELECTION_KEY_SIZE);
+    args.ids = (uint64_t*)ccb_arena_malloc(arena, threads * k * sizeof(uint64_t));
+    if (args.keys == NULL || args.ids == NULL) {
+        CCB_ERROR("Failed to allocate top k heaps");
+        return -1;
+    }
+    if (sc_run_range_task(axis_topk_kernel, &args, args.outer * args.inner, a->size, arena) != 0) {
+        CCB_ERROR("Failed to run top k along axis %" PRId64, axis);
+        return -1;
+    }
+    return 0;
+}
+
+
+int sc_tensor_nth_element(sc_tensor* a, int64_t axis, uint64_t n, ccb_arena* arena) {
+    struct axis_args args;
+    if (axis_shape(a, axis, &args) != 0) {
+        return -1;
+    }
+    if (n >= args.length) {
+        CCB_ERROR("n must be lower than %" PRIu64 ", got %" PRIu64, args.length, n);
+        return -1;
+    }
+    args.k = n;
+    if (sc_run_range_task(axis_nth_kernel, &args, args.outer * args.inner, a->size, arena) != 0) {
+        CCB_ERROR("Failed to run nth element along axis %" PRId64, axis);
+        return -1;
+    }
+    return 0;
+}
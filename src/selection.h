@@ -0,0 +1,62 @@
+#ifndef __SELECTION_H__
+#define __SELECTION_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    index returning reductions: argmin / argmax, top k and nth element selection, over flat vectors or along
+    one axis of a tensor, for every type
+    the values are compared in their own type (float32 for bfloat16 and half), NaN ranks after every other
+    value for both the smallest and the largest, equal values rank by index (the lowest first)
+    float32, bfloat16 and float64 argmin / argmax keep a vector of candidates per lane, along an inner axis tiles
+    of adjacent lines are reduced one contiguous row at a time, the top k keeps a heap per thread and only pushes
+    the lanes of a vector that beat its worst value
+*/
+
+
+/* Index of the smallest value (the first one on ties, the first element when every value is NaN)
+   - sc_vector* a: non empty vector
+   - uint64_t* index: written index
+   - ccb_arena* arena: arena where the tasks will be allocated
+   - return: 0 on success
+*/
+int sc_vector_argmin(sc_vector* a, uint64_t* index, ccb_arena* arena);
+/* Index of the largest value, see sc_vector_argmin */
+int sc_vector_argmax(sc_vector* a, uint64_t* index, ccb_arena* arena);
+/* k smallest or largest values
+   - uint64_t k: 1 to the vector size
+   - int largest: 1 for the largest values, 0 for the smallest
+   - uint64_t* indices: [k] indices, best first
+   - sc_vector* values: [k] values, same type as a, can be NULL
+   - return: 0 on success
+*/
+int sc_vector_topk(sc_vector* a, uint64_t k, int largest, uint64_t* indices, sc_vector* values, ccb_arena* arena);
+/* Partial sort in place: a[n] becomes the value a sorted vector has at n, the values before it are not
+   greater and the values after it are not smaller
+   - uint64_t n: 0 to the vector size - 1
+   - return: 0 on success
+*/
+int sc_vector_nth_element(sc_vector* a, uint64_t n);
+
+/* Index along an axis of the smallest value of every line
+   - sc_tensor* a: tensor with a non empty axis
+   - int64_t axis: reduced axis, negative values count from the last one
+   - uint64_t* indices: indices in the shape of a without the axis
+   - return: 0 on success
+*/
+int sc_tensor_argmin(sc_tensor* a, int64_t axis, uint64_t* indices, ccb_arena* arena);
+/* Index along an axis of the largest value of every line, see sc_tensor_argmin */
+int sc_tensor_argmax(sc_tensor* a, int64_t axis, uint64_t* indices, ccb_arena* arena);
+/* k smallest or largest values of every line along an axis
+   - uint64_t* indices: indices in the shape of a with k along the axis, best first
+   - sc_tensor* values: values in the same shape and the type of a, can be NULL
+   - return: 0 on success
+*/
+int sc_tensor_topk(sc_tensor* a, int64_t axis, uint64_t k, int largest, uint64_t* indices, sc_tensor* values, ccb_arena* arena);
+/* sc_vector_nth_element on every line along an axis, in place */
+int sc_tensor_nth_element(sc_tensor* a, int64_t axis, uint64_t n, ccb_arena* arena);
+
+
+#endif // __SELECTION_H__
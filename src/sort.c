@@ -0,0 +1,371 @@
+#include "data.h"
+#include "sort.h"
+#include "sc_engine.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+
+// buckets of an 8 bits digit
+#define SORT_RADIX 256
+// below this size the keys are one block (the tasks would cost more than the passes)
+#define SORT_PARALLEL_SIZE 65536
+
+
+/*
+    order preserving unsigned keys, one instance per type: floats flip every bit when negative and the sign
+    bit otherwise, signed integers flip the sign bit, descending orders flip every bit of the key, NaN take
+    the largest key in both orders
+    the encoding also counts the digits of every pass for its block
+*/
+#define SORT_CODEC(SUFFIX, UT, SIGN, FLOAT, INF, QNAN)                                                         \
+static void encode_##SUFFIX(const UT* data, UT* keys, uint64_t start, uint64_t end, int descending,            \
+                            uint64_t* counts, uint64_t stride) {                                               \
+    for (uint64_t i = start; i < end; i++) {                                                                   \
+        UT u = data[i];                                                                                        \
+        UT k = (FLOAT) ? (UT)((u & (SIGN)) ? (UT)~u : (UT)(u | (SIGN))) : (UT)(u ^ (SIGN));                    \
+        k = descending ? (UT)~k : k;                                                                           \
+        if ((FLOAT) && (UT)(u & (UT)~(UT)(SIGN)) > (UT)(INF)) {                                                \
+            k = (UT)~(UT)0;                                                                                    \
+        }                                                                                                      \
+        keys[i] = k;                                                                                           \
+        for (uint64_t p = 0; p < sizeof(UT); p++) {                                                            \
+            counts[p * stride + ((k >> (8 * p)) & 0xff)]++;                                                    \
+        }                                                                                                      \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static void decode_##SUFFIX(const UT* keys, UT* data, uint64_t start, uint64_t end, int descending) {          \
+    for (uint64_t i = start; i < end; i++) {                                                                   \
+        UT k = keys[i];                                                                                        \
+        if ((FLOAT) && k == (UT)~(UT)0) {                                                                      \
+            data[i] = (UT)(QNAN);                                                                              \
+            continue;                                                                                          \
+        }                                                                                                      \
+        k = descending ? (UT)~k : k;                                                                           \
+        data[i] = (FLOAT) ? (UT)((k & (SIGN)) ? (UT)(k & (UT)~(UT)(SIGN)) : (UT)~k) : (UT)(k ^ (SIGN));        \
+    }                                                                                                          \
+}
+
+SORT_CODEC(bf16, uint16_t, 0x8000u, 1, 0x7f80u, 0x7fc0u)
+SORT_CODEC(half, uint16_t, 0x8000u, 1, 0x7c00u, 0x7e00u)
+SORT_CODEC(f32, uint32_t, 0x80000000u, 1, 0x7f800000u, 0x7fc00000u)
+SORT_CODEC(f64, uint64_t, 0x8000000000000000ull, 1, 0x7ff0000000000000ull, 0x7ff8000000000000ull)
+SORT_CODEC(i32, uint32_t, 0x80000000u, 0, 0, 0)
+SORT_CODEC(i64, uint64_t, 0x8000000000000000ull, 0, 0, 0)
+SORT_CODEC(u8, uint8_t, 0, 0, 0, 0)
+
+
+/*
+    counting and scattering of one digit over a block of keys, one instance per key width, the scatter walks
+    the block in order so equal digits keep the order of the previous pass
+*/
+#define SORT_PASS(SUFFIX, UT)                                                                                  \
+static void histogram_##SUFFIX(const UT* keys, uint64_t start, uint64_t end, uint64_t shift, uint64_t* counts) { \
+    for (uint64_t i = start; i < end; i++) {                                                                   \
+        counts[(keys[i] >> shift) & 0xff]++;                                                                   \
+    }                                                                                                          \
+}                                                                                                              \
+                                                                                                               \
+static void scatter_##SUFFIX(const UT* keys, const uint64_t* ids, UT* keys_out, uint64_t* ids_out,             \
+                             uint64_t start, uint64_t end, uint64_t shift, uint64_t* offsets) {                \
+    if (ids == NULL) {                                                                                         \
+        for (uint64_t i = start; i < end; i++) {                                                               \
+            UT k = keys[i];                                                                                    \
+            keys_out[offsets[(k >> shift) & 0xff]++] = k;                                                      \
+        }                                                                                                      \
+        return;                                                                                                \
+    }                                                                                                          \
+    for (uint64_t i = start; i < end; i++) {                                                                   \
+        UT k = keys[i];                                                                                        \
+        uint64_t at = offsets[(k >> shift) & 0xff]++;                                                          \
+        keys_out[at] = k;                                                                                      \
+        ids_out[at] = ids[i];                                                                                  \
+    }                                                                                                          \
+}
+
+SORT_PASS(u8, uint8_t)
+SORT_PASS(u16, uint16_t)
+SORT_PASS(u32, uint32_t)
+SORT_PASS(u64, uint64_t)
+
+
+struct sort_args {
+    void* data;             // values of the sorted vector
+    sc_TYPES type;
+    uint64_t size;
+    uint64_t width;         // bytes of a key, one pass per byte
+    int descending;
+    uint64_t blocks;
+    uint64_t block_size;
+    void* keys[2];
+    uint64_t* ids[2];       // NULL when no permutation is needed
+    int current;            // buffers of the last pass
+    uint64_t pass;
+    uint64_t* histograms;   // [width, blocks, 256] digit counts, turned into offsets before the scatter
+    // permutation of the values of sc_vector_sort_by_key
+    const uint8_t* gather_from;
+    uint8_t* gather_to;
+    uint64_t gather_size;
+};
+
+
+static inline uint64_t block_end(const struct sort_args* args, uint64_t b) {
+    uint64_t end = (b + 1) * args->block_size;
+    return (end < args->size) ? end : args->size;
+}
+
+
+static int encode_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sort_args* args = (struct sort_args*)raw;
+    uint64_t stride = args->blocks * SORT_RADIX;
+    for (uint64_t b = start; b < end; b++) {
+        uint64_t first = b * args->block_size;
+        uint64_t last = block_end(args, b);
+        uint64_t* counts = args->histograms + b * SORT_RADIX;
+        for (uint64_t p = 0; p < args->width; p++) {
+            memset(counts + p * stride, 0, SORT_RADIX * sizeof(uint64_t));
+        }
+        switch (args->type) {
+            case sc_float16: encode_bf16((const uint16_t*)args->data, (uint16_t*)args->keys[0], first, last, args->descending, counts, stride); break;
+            case sc_half: encode_half((const uint16_t*)args->data, (uint16_t*)args->keys[0], first, last, args->descending, counts, stride); break;
+            case sc_float32: encode_f32((const uint32_t*)args->data, (uint32_t*)args->keys[0], first, last, args->descending, counts, stride); break;
+            case sc_float64: encode_f64((const uint64_t*)args->data, (uint64_t*)args->keys[0], first, last, args->descending, counts, stride); break;
+            case sc_int32: encode_i32((const uint32_t*)args->data, (uint32_t*)args->keys[0], first, last, args->descending, counts, stride); break;
+            case sc_int64: encode_i64((const uint64_t*)args->data, (uint64_t*)args->keys[0], first, last, args->descending, counts, stride); break;
+            case sc_uint8: encode_u8((const uint8_t*)args->data, (uint8_t*)args->keys[0], first, last, args->descending, counts, stride); break;
+        }
+        if (args->ids[0] != NULL) {
+            for (uint64_t i = first; i < last; i++) {
+                args->ids[0][i] = i;
+            }
+        }
+    }
+    return 0;
+}
+
+
+static int histogram_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sort_args* args = (struct sort_args*)raw;
+    const void* keys = args->keys[args->current];
+    uint64_t shift = 8 * args->pass;
+    for (uint64_t b = start; b < end; b++) {
+        uint64_t first = b * args->block_size;
+        uint64_t last = block_end(args, b);
+        uint64_t* counts = args->histograms + (args->pass * args->blocks + b) * SORT_RADIX;
+        memset(counts, 0, SORT_RADIX * sizeof(uint64_t));
+        switch (args->width) {
+            case 1: histogram_u8((const uint8_t*)keys, first, last, shift, counts); break;
+            case 2: histogram_u16((const uint16_t*)keys, first, last, shift, counts); break;
+            case 4: histogram_u32((const uint32_t*)keys, first, last, shift, counts); break;
+            default: histogram_u64((const uint64_t*)keys, first, last, shift, counts); break;
+        }
+    }
+    return 0;
+}
+
+
+static int scatter_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sort_args* args = (struct sort_args*)raw;
+    const void* keys = args->keys[args->current];
+    void* keys_out = args->keys[!args->current];
+    const uint64_t* ids = args->ids[args->current];
+    uint64_t* ids_out = args->ids[!args->current];
+    uint64_t shift = 8 * args->pass;
+    for (uint64_t b = start; b < end; b++) {
+        uint64_t first = b * args->block_size;
+        uint64_t last = block_end(args, b);
+        uint64_t* offsets = args->histograms + (args->pass * args->blocks + b) * SORT_RADIX;
+        switch (args->width) {
+            case 1: scatter_u8((const uint8_t*)keys, ids, (uint8_t*)keys_out, ids_out, first, last, shift, offsets); break;
+            case 2: scatter_u16((const uint16_t*)keys, ids, (uint16_t*)keys_out, ids_out, first, last, shift, offsets); break;
+            case 4: scatter_u32((const uint32_t*)keys, ids, (uint32_t*)keys_out, ids_out, first, last, shift, offsets); break;
+            default: scatter_u64((const uint64_t*)keys, ids, (uint64_t*)keys_out, ids_out, first, last, shift, offsets); break;
+        }
+    }
+    return 0;
+}
+
+
+static int decode_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sort_args* args = (struct sort_args*)raw;
+    const void* keys = args->keys[args->current];
+    for (uint64_t b = start; b < end; b++) {
+        uint64_t first = b * args->block_size;
+        uint64_t last = block_end(args, b);
+        switch (args->type) {
+            case sc_float16: decode_bf16((const uint16_t*)keys, (uint16_t*)args->data, first, last, args->descending); break;
+            case sc_half: decode_half((const uint16_t*)keys, (uint16_t*)args->data, first, last, args->descending); break;
+            case sc_float32: decode_f32((const uint32_t*)keys, (uint32_t*)args->data, first, last, args->descending); break;
+            case sc_float64: decode_f64((const uint64_t*)keys, (uint64_t*)args->data, first, last, args->descending); break;
+            case sc_int32: decode_i32((const uint32_t*)keys, (uint32_t*)args->data, first, last, args->descending); break;
+            case sc_int64: decode_i64((const uint64_t*)keys, (uint64_t*)args->data, first, last, args->descending); break;
+            case sc_uint8: decode_u8((const uint8_t*)keys, (uint8_t*)args->data, first, last, args->descending); break;
+        }
+    }
+    return 0;
+}
+
+
+static int gather_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sort_args* args = (struct sort_args*)raw;
+    const uint64_t* ids = args->ids[args->current];
+    for (uint64_t b = start; b < end; b++) {
+        uint64_t first = b * args->block_size;
+        uint64_t last = block_end(args, b);
+        switch (args->gather_size) {
+            case 1:
+                for (uint64_t i = first; i < last; i++) args->gather_to[i] = args->gather_from[ids[i]];
+                break;
+            case 2:
+                for (uint64_t i = first; i < last; i++) ((uint16_t*)args->gather_to)[i] = ((const uint16_t*)args->gather_from)[ids[i]];
+                break;
+            case 4:
+                for (uint64_t i = first; i < last; i++) ((uint32_t*)args->gather_to)[i] = ((const uint32_t*)args->gather_from)[ids[i]];
+                break;
+            default:
+                for (uint64_t i = first; i < last; i++) ((uint64_t*)args->gather_to)[i] = ((const uint64_t*)args->gather_from)[ids[i]];
+                break;
+        }
+    }
+    return 0;
+}
+
+
+/*
+    encodes the keys of a and runs the passes, the sorted keys (and indices) end in the buffers of
+    args->current, indices (when not NULL) is used as one of the two index buffers
+*/
+static int radix_sort(sc_vector* a, int descending, int with_ids, uint64_t* indices, struct sort_args* args, ccb_arena* arena) {
+    CCB_NOTNULL(a, "vector is NULL");
+    memset(args, 0, sizeof(struct sort_args));
+    args->data = a->data;
+    args->type = a->type;
+    args->size = a->size;
+    args->width = sc_type_size(a->type);
+    args->descending = descending;
+    if (a->size == 0) {
+        return 0;
+    }
+    uint64_t threads = sc_get_engine_thread_count();
+    args->blocks = (a->size < SORT_PARALLEL_SIZE || threads == 0) ? 1 : threads;
+    args->block_size = (a->size + args->blocks - 1) / args->blocks;
+    args->keys[0] = ccb_arena_malloc(arena, a->size * args->width);
+    args->keys[1] = ccb_arena_malloc(arena, a->size * args->width);
+    args->histograms = (uint64_t*)ccb_arena_malloc(arena, args->width * args->blocks * SORT_RADIX * sizeof(uint64_t));
+    if (args->keys[0] == NULL || args->keys[1] == NULL || args->histograms == NULL) {
+        CCB_ERROR("Failed to allocate radix sort scratch");
+        return -1;
+    }
+    if (with_ids) {
+        args->ids[0] = indices ? indices : (uint64_t*)ccb_arena_malloc(arena, a->size * sizeof(uint64_t));
+        args->ids[1] = (uint64_t*)ccb_arena_malloc(arena, a->size * sizeof(uint64_t));
+        if (args->ids[0] == NULL || args->ids[1] == NULL) {
+            CCB_ERROR("Failed to allocate radix sort indices");
+            return -1;
+        }
+    }
+    if (sc_run_range_task(encode_kernel, args, args->blocks, a->size, arena) != 0) {
+        CCB_ERROR("Failed to encode radix sort keys");
+        return -1;
+    }
+
+    // the encoding counted the digits of the keys in their first order, later passes count again
+    int moved = 0;
+    for (uint64_t p = 0; p < args->width; p++) {
+        uint64_t* counts = args->histograms + p * args->blocks * SORT_RADIX;
+        int single = 0;
+        for (uint64_t d = 0; d < SORT_RADIX && !single; d++) {
+            uint64_t total = 0;
+            for (uint64_t b = 0; b < args->blocks; b++) {
+                total += counts[b * SORT_RADIX + d];
+            }
+            single = (total == a->size);
+        }
+        if (single) {
+            continue;
+        }
+        args->pass = p;
+        if (moved && sc_run_range_task(histogram_kernel, args, args->blocks, a->size, arena) != 0) {
+            CCB_ERROR("Failed to count radix sort digits");
+            return -1;
+        }
+        uint64_t offset = 0;
+        for (uint64_t d = 0; d < SORT_RADIX; d++) {
+            for (uint64_t b = 0; b < args->blocks; b++) {
+                uint64_t count = counts[b * SORT_RADIX + d];
+                counts[b * SORT_RADIX + d] = offset;
+                offset += count;
+            }
+        }
+        if (sc_run_range_task(scatter_kernel, args, args->blocks, a->size, arena) != 0) {
+            CCB_ERROR("Failed to scatter radix sort keys");
+            return -1;
+        }
+        args->current = !args->current;
+        moved = 1;
+    }
+    return 0;
+}
+
+
+int sc_vector_sort(sc_vector* a, int descending, ccb_arena* arena) {
+    struct sort_args args;
+    if (radix_sort(a, descending, 0, NULL, &args, arena) != 0) {
+        return -1;
+    }
+    if (a->size > 0 && sc_run_range_task(decode_kernel, &args, args.blocks, a->size, arena) != 0) {
+        CCB_ERROR("Failed to decode radix sort keys");
+        return -1;
+    }
+    return 0;
+}
+
+
+int sc_vector_argsort(sc_vector* a, int descending, uint64_t* indices, ccb_arena* arena) {
+    CCB_NOTNULL(indices, "indices is NULL");
+    struct sort_args args;
+    if (radix_sort(a, descending, 1, indices, &args, arena) != 0) {
+        return -1;
+    }
+    if (a->size > 0 && args.current == 1) {
+        memcpy(indices, args.ids[1], a->size * sizeof(uint64_t));
+    }
+    return 0;
+}
+
+
+int sc_vector_sort_by_key(sc_vector* keys, sc_vector* values, int descending, ccb_arena* arena) {
+    CCB_NOTNULL(keys, "keys is NULL");
+    CCB_NOTNULL(values, "values is NULL");
+    if (values->size != keys->size) {
+        CCB_ERROR("values has %" PRIu64 " elements for %" PRIu64 " keys", values->size, keys->size);
+        return -1;
+    }
+    struct sort_args args;
+    if (radix_sort(keys, descending, 1, NULL, &args, arena) != 0) {
+        return -1;
+    }
+    if (keys->size == 0) {
+        return 0;
+    }
+    args.gather_size = sc_type_size(values->type);
+    args.gather_to = (uint8_t*)values->data;
+    uint8_t* copy = (uint8_t*)ccb_arena_malloc(arena, values->size * args.gather_size);
+    CCB_NOTNULL(copy, "Failed to allocate the copy of the values");
+    memcpy(copy, values->data, values->size * args.gather_size);
+    args.gather_from = copy;
+    if (sc_run_range_task(decode_kernel, &args, args.blocks, keys->size, arena) != 0 ||
+        sc_run_range_task(gather_kernel, &args, args.blocks, keys->size, arena) != 0) {
+        CCB_ERROR("Failed to write the sorted keys and values");
+        return -1;
+    }
+    return 0;
+}
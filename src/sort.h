@@ -0,0 +1,41 @@
+#ifndef __SORT_H__
+#define __SORT_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    LSD radix sorts of vectors of every type, 8 bits per pass
+    the values are first mapped to unsigned keys that keep their order (the sign bit of the floats flips the
+    other bits, the sign bit of the integers is flipped), the passes where every key has the same digit are
+    skipped, each pass counts the digits of fixed blocks of the keys in parallel then every block scatters its
+    keys to the offsets of its digits, so the sorts are stable and do not depend on the thread count
+    NaN sort after every other value in both orders (and are written back as quiet NaN), -0 sorts before +0
+    bfloat16 and half keys take 2 passes, float32 and int32 4, float64 and int64 8
+    the scratch (two copies of the keys and of the indices) is taken from the arena
+*/
+
+
+/* Sorts a vector in place
+   - sc_vector* a: vector of any type
+   - int descending: 1 for the largest values first
+   - ccb_arena* arena: arena where the scratch and the tasks will be allocated
+   - return: 0 on success
+*/
+int sc_vector_sort(sc_vector* a, int descending, ccb_arena* arena);
+/* Stable sorting permutation: a[indices[0]], a[indices[1]], ... is sorted, equal values keep their order, a is
+   not modified
+   - uint64_t* indices: [a->size] indices
+   - return: 0 on success
+*/
+int sc_vector_argsort(sc_vector* a, int descending, uint64_t* indices, ccb_arena* arena);
+/* Sorts the keys in place and applies the same (stable) permutation to the values
+   - sc_vector* keys: vector of any type
+   - sc_vector* values: vector of the same size, of any type
+   - return: 0 on success
+*/
+int sc_vector_sort_by_key(sc_vector* keys, sc_vector* values, int descending, ccb_arena* arena);
+
+
+#endif // __SORT_H__
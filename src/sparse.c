@@ -0,0 +1,905 @@
+#include "data.h"
+#include "sparse.h"
+#include "sc_engine.h"
+#include "sc_simd.h"
+#include "const.h"
+#include "ccbase/logs/log.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// the AVX2 gathers read the indices as signed 32 bits integers
+#define SPARSE_MAX_DIM ((uint64_t)INT32_MAX)
+
+
+struct sparse_args {
+    sc_TYPES type;
+    sc_sparse_matrix* a;
+    sc_sparse_matrix* out;
+
+    // unit u covers the rows (CSR) or columns (CSC) [splits[u], splits[u + 1])
+    uint64_t* splits;
+
+    // dense operands, n is the number of columns of the SpMM
+    const void* x;
+    void* y;
+    uint64_t n;
+
+    // per thread float32 rows of the bfloat16 SpMM
+    float* acc;
+    uint64_t acc_stride;
+
+    // per thread bytes of the COO sort
+    uint8_t* scratch;
+    uint64_t scratch_stride;
+};
+
+
+// minor index and position in its major, the position keeps the sort stable
+struct sort_pair {
+    uint32_t index;
+    uint32_t position;
+};
+
+
+// #######
+// helpers
+// #######
+
+static uint64_t type_size(sc_TYPES type) {
+    return (type == sc_float64) ? sizeof(double) : (type == sc_float32) ? sizeof(float) : sizeof(uint16_t);
+}
+
+static double load_value(const void* base, uint64_t index, sc_TYPES type) {
+    if (type == sc_float64) {
+        return ((const double*)base)[index];
+    }
+    return sc_load_f32(base, index, type);
+}
+
+static void store_value(void* base, uint64_t index, double value, sc_TYPES type) {
+    if (type == sc_float64) {
+        ((double*)base)[index] = value;
+        return;
+    }
+    sc_store_f32(base, index, (float)value, type);
+}
+
+// element copy with a constant size, memcpy with a runtime size is a call per element
+static inline void copy_value(void* dst, uint64_t dst_index, const void* src, uint64_t src_index, uint64_t size) {
+    switch (size) {
+        case 2: ((uint16_t*)dst)[dst_index] = ((const uint16_t*)src)[src_index]; break;
+        case 4: ((uint32_t*)dst)[dst_index] = ((const uint32_t*)src)[src_index]; break;
+        default: ((uint64_t*)dst)[dst_index] = ((const uint64_t*)src)[src_index]; break;
+    }
+}
+
+static int check_type(sc_TYPES type) {
+    if (type != sc_float16 && type != sc_float32 && type != sc_float64) {
+        CCB_ERROR("Unsupported sc_TYPES value %d", type);
+        return -1;
+    }
+    return 0;
+}
+
+static uint64_t major_count(sc_sparse_matrix* a) {
+    return (a->format == sc_sparse_csr) ? a->rows : a->cols;
+}
+
+static uint64_t minor_count(sc_sparse_matrix* a) {
+    return (a->format == sc_sparse_csr) ? a->cols : a->rows;
+}
+
+// row major index of the dense element at (major, minor)
+static uint64_t dense_index(sc_sparse_matrix* a, uint64_t major, uint64_t minor) {
+    return (a->format == sc_sparse_csr) ? major * a->cols + minor : minor * a->cols + major;
+}
+
+
+// splits [0, count) in parts ranges holding about the same number of nonzeros,
+// a row twice as dense as the others costs twice as much so the row count alone is not a good balance
+static uint64_t* balance_by_nnz(const uint64_t* offsets, uint64_t count, uint64_t parts, ccb_arena* arena) {
+    uint64_t* splits = (uint64_t*)ccb_arena_malloc(arena, (parts + 1) * sizeof(uint64_t));
+    CCB_NOTNULL(splits, "Failed to allocate the splits");
+
+    uint64_t nnz = offsets[count];
+    splits[0] = 0;
+    for (uint64_t p = 1; p < parts; p++) {
+        // first row whose end passes the target, the empty rows count as one nonzero so that they are spread too
+        uint64_t target = nnz * p / parts + (count * p / parts);
+        uint64_t lo = splits[p - 1], hi = count;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (offsets[mid + 1] + mid + 1 <= target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        splits[p] = lo;
+    }
+    splits[parts] = count;
+    return splits;
+}
+
+static uint64_t part_count(uint64_t count) {
+    uint64_t parts = sc_get_engine_thread_count();
+    return (parts > count) ? ((count == 0) ? 1 : count) : parts;
+}
+
+
+// ###########
+// row kernels
+// ###########
+
+SC_TARGET_AVX2 static float row_dot_f32_gather(const float* values, const uint32_t* indices, uint64_t count, const float* x) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    uint64_t k = 0;
+    for (; k + 16 <= count; k += 16) {
+        __m256 g0 = _mm256_i32gather_ps(x, _mm256_loadu_si256((const __m256i*)(indices + k)), 4);
+        __m256 g1 = _mm256_i32gather_ps(x, _mm256_loadu_si256((const __m256i*)(indices + k + 8)), 4);
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + k), g0, acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(values + k + 8), g1, acc1);
+    }
+    if (k + 8 <= count) {
+        __m256 g0 = _mm256_i32gather_ps(x, _mm256_loadu_si256((const __m256i*)(indices + k)), 4);
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(values + k), g0, acc0);
+        k += 8;
+    }
+
+    float sum = sc_hsum_f32x8(_mm256_add_ps(acc0, acc1));
+    for (; k < count; k++) {
+        sum += values[k] * x[indices[k]];
+    }
+    return sum;
+}
+
+SC_TARGET_AVX2 static double row_dot_f64_gather(const double* values, const uint32_t* indices, uint64_t count, const double* x) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    uint64_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        __m256d g0 = _mm256_i32gather_pd(x, _mm_loadu_si128((const __m128i*)(indices + k)), 8);
+        __m256d g1 = _mm256_i32gather_pd(x, _mm_loadu_si128((const __m128i*)(indices + k + 4)), 8);
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(values + k), g0, acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(values + k + 4), g1, acc1);
+    }
+
+    double sum = sc_hsum_f64x4(_mm256_add_pd(acc0, acc1));
+    for (; k < count; k++) {
+        sum += values[k] * x[indices[k]];
+    }
+    return sum;
+}
+
+// dot product of count stored values with the dense x, float32 accumulation for float32 / bfloat16
+static double row_dot(const void* values, const uint32_t* indices, uint64_t count, const void* x, sc_TYPES type) {
+    if (type == sc_float64) {
+        if (sc_has_avx2_fma()) {
+            return row_dot_f64_gather((const double*)values, indices, count, (const double*)x);
+        }
+        double sum = 0.0;
+        for (uint64_t k = 0; k < count; k++) {
+            sum += ((const double*)values)[k] * ((const double*)x)[indices[k]];
+        }
+        return sum;
+    }
+
+    if (type == sc_float32 && sc_has_avx2_fma()) {
+        return row_dot_f32_gather((const float*)values, indices, count, (const float*)x);
+    }
+    float sum = 0.0f;
+    for (uint64_t k = 0; k < count; k++) {
+        sum += sc_load_f32(values, k, type) * sc_load_f32(x, indices[k], type);
+    }
+    return sum;
+}
+
+
+// acc[0, n) += a0 * b[row0 * n + j] + a1 * b[row1 * n + j], two nonzeros per pass halve the accumulator traffic
+static void row_axpy2_f32(float* acc, float a0, float a1, const void* b, uint64_t row0, uint64_t row1, uint64_t n, sc_TYPES type) {
+    __m256 va0 = _mm256_set1_ps(a0);
+    __m256 va1 = _mm256_set1_ps(a1);
+    uint64_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256 sum = _mm256_add_ps(_mm256_mul_ps(va0, sc_load_f32x8(b, row0 * n + j, type)), _mm256_mul_ps(va1, sc_load_f32x8(b, row1 * n + j, type)));
+        _mm256_storeu_ps(acc + j, _mm256_add_ps(_mm256_loadu_ps(acc + j), sum));
+    }
+    for (; j < n; j++) {
+        acc[j] += a0 * sc_load_f32(b, row0 * n + j, type) + a1 * sc_load_f32(b, row1 * n + j, type);
+    }
+}
+
+static void row_axpy2_f64(double* acc, double a0, double a1, const double* b, uint64_t row0, uint64_t row1, uint64_t n) {
+    __m256d va0 = _mm256_set1_pd(a0);
+    __m256d va1 = _mm256_set1_pd(a1);
+    const double* b0 = b + row0 * n;
+    const double* b1 = b + row1 * n;
+    uint64_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m256d sum = _mm256_add_pd(_mm256_mul_pd(va0, _mm256_loadu_pd(b0 + j)), _mm256_mul_pd(va1, _mm256_loadu_pd(b1 + j)));
+        _mm256_storeu_pd(acc + j, _mm256_add_pd(_mm256_loadu_pd(acc + j), sum));
+    }
+    for (; j < n; j++) {
+        acc[j] += a0 * b0[j] + a1 * b1[j];
+    }
+}
+
+
+// #######
+// kernels
+// #######
+
+static int spmv_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sparse_args* args = (struct sparse_args*)raw;
+    sc_sparse_matrix* a = args->a;
+    uint64_t size = type_size(a->type);
+
+    for (uint64_t u = start; u < end; u++) {
+        for (uint64_t r = args->splits[u]; r < args->splits[u + 1]; r++) {
+            uint64_t o = a->offsets[r];
+            double value = row_dot((const uint8_t*)a->values + o * size, a->indices + o, a->offsets[r + 1] - o, args->x, a->type);
+            store_value(args->y, r, value, a->type);
+        }
+    }
+    return 0;
+}
+
+
+static int spmm_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct sparse_args* args = (struct sparse_args*)raw;
+    sc_sparse_matrix* a = args->a;
+    uint64_t n = args->n;
+
+    for (uint64_t u = start; u < end; u++) {
+        for (uint64_t r = args->splits[u]; r < args->splits[u + 1]; r++) {
+            uint64_t k = a->offsets[r];
+            uint64_t k_end = a->offsets[r + 1];
+
+            if (a->type == sc_float64) {
+                const double* values = (const double*)a->values;
+                double* acc = (double*)args->y + r * n;
+                memset(acc, 0, n * sizeof(double));
+                for (; k + 2 <= k_end; k += 2) {
+                    row_axpy2_f64(acc, values[k], values[k + 1], (const double*)args->x, a->indices[k], a->indices[k + 1], n);
+                }
+                if (k < k_end) {
+                    row_axpy2_f64(acc, values[k], 0.0, (const double*)args->x, a->indices[k], a->indices[k], n);
+                }
+                continue;
+            }
+
+            // float32 rows accumulate in place, bfloat16 rows in the thread row
+            float* acc = (a->type == sc_float32) ? (float*)args->y + r * n : args->acc + thread_id * args->acc_stride;
+            memset(acc, 0, n * sizeof(float));
+            for (; k + 2 <= k_end; k += 2) {
+                row_axpy2_f32(acc, sc_load_f32(a->values, k, a->type), sc_load_f32(a->values, k + 1, a->type), args->x, a->indices[k], a->indices[k + 1], n, a->type);
+            }
+            if (k < k_end) {
+                row_axpy2_f32(acc, sc_load_f32(a->values, k, a->type), 0.0f, args->x, a->indices[k], a->indices[k], n, a->type);
+            }
+
+            if (a->type == sc_float16) {
+                uint64_t j = 0;
+                for (; j + 8 <= n; j += 8) {
+                    sc_store_f32x8(args->y, r * n + j, _mm256_loadu_ps(acc + j), a->type);
+                }
+                for (; j < n; j++) {
+                    sc_store_f32(args->y, r * n + j, acc[j], a->type);
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+
+// y[major, minor] += a (y already holds the dense operand or zeros)
+static int scatter_add_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sparse_args* args = (struct sparse_args*)raw;
+    sc_sparse_matrix* a = args->a;
+
+    for (uint64_t u = start; u < end; u++) {
+        for (uint64_t m = args->splits[u]; m < args->splits[u + 1]; m++) {
+            for (uint64_t k = a->offsets[m]; k < a->offsets[m + 1]; k++) {
+                uint64_t index = dense_index(a, m, a->indices[k]);
+                store_value(args->y, index, load_value(args->y, index, a->type) + load_value(a->values, k, a->type), a->type);
+            }
+        }
+    }
+    return 0;
+}
+
+
+// out values = a values * x[major, minor], same pattern as a
+static int gather_mul_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sparse_args* args = (struct sparse_args*)raw;
+    sc_sparse_matrix* a = args->a;
+
+    for (uint64_t u = start; u < end; u++) {
+        for (uint64_t m = args->splits[u]; m < args->splits[u + 1]; m++) {
+            for (uint64_t k = a->offsets[m]; k < a->offsets[m + 1]; k++) {
+                double value = load_value(a->values, k, a->type) * load_value(args->x, dense_index(a, m, a->indices[k]), a->type);
+                store_value(args->out->values, k, value, a->type);
+            }
+        }
+    }
+    return 0;
+}
+
+
+// dense to CSR, first pass counts the nonzeros of each row in out->offsets[r + 1]
+static int count_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sparse_args* args = (struct sparse_args*)raw;
+    sc_sparse_matrix* out = args->out;
+
+    for (uint64_t r = start; r < end; r++) {
+        uint64_t count = 0;
+        for (uint64_t c = 0; c < out->cols; c++) {
+            count += (load_value(args->x, r * out->cols + c, out->type) != 0.0);
+        }
+        out->offsets[r + 1] = count;
+    }
+    return 0;
+}
+
+static int fill_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    (void)thread_id;
+    struct sparse_args* args = (struct sparse_args*)raw;
+    sc_sparse_matrix* out = args->out;
+    uint64_t size = type_size(out->type);
+
+    for (uint64_t r = start; r < end; r++) {
+        uint64_t k = out->offsets[r];
+        const uint8_t* row = (const uint8_t*)args->x + r * out->cols * size;
+        for (uint64_t c = 0; c < out->cols; c++) {
+            if (load_value(row, c, out->type) != 0.0) {
+                out->indices[k] = (uint32_t)c;
+                copy_value(out->values, k, row, c, size);
+                k++;
+            }
+        }
+    }
+    return 0;
+}
+
+
+// ##########
+// conversion
+// ##########
+
+// regroups the values by their minor index (counting sort), the new minor indices come out sorted
+static void transpose_compressed(sc_sparse_matrix* a, sc_sparse_matrix* out, uint64_t* next) {
+    uint64_t majors = major_count(a);
+    uint64_t minors = minor_count(a);
+    uint64_t size = type_size(a->type);
+
+    memset(out->offsets, 0, (minors + 1) * sizeof(uint64_t));
+    for (uint64_t k = 0; k < a->nnz; k++) {
+        out->offsets[a->indices[k] + 1]++;
+    }
+    for (uint64_t m = 0; m < minors; m++) {
+        out->offsets[m + 1] += out->offsets[m];
+    }
+    memcpy(next, out->offsets, minors * sizeof(uint64_t));
+
+    for (uint64_t m = 0; m < majors; m++) {
+        for (uint64_t k = a->offsets[m]; k < a->offsets[m + 1]; k++) {
+            uint64_t position = next[a->indices[k]]++;
+            out->indices[position] = (uint32_t)m;
+            copy_value(out->values, position, a->values, k, size);
+        }
+    }
+}
+
+
+// the short majors use an insertion sort, the long ones a qsort of (index, position) pairs
+#define SPARSE_INSERTION_SORT_MAX 32
+
+static int compare_sort_pairs(const void* a, const void* b) {
+    const struct sort_pair* pa = (const struct sort_pair*)a;
+    const struct sort_pair* pb = (const struct sort_pair*)b;
+    if (pa->index != pb->index) {
+        return (pa->index < pb->index) ? -1 : 1;
+    }
+    return (pa->position < pb->position) ? -1 : (pa->position > pb->position);
+}
+
+static int sort_kernel(void* raw, uint64_t start, uint64_t end, uint64_t thread_id) {
+    struct sparse_args* args = (struct sparse_args*)raw;
+    sc_sparse_matrix* a = args->a;
+    uint64_t size = type_size(a->type);
+
+    struct sort_pair* pairs = (struct sort_pair*)(args->scratch + thread_id * args->scratch_stride);
+    uint8_t* values = args->scratch + thread_id * args->scratch_stride + (args->scratch_stride / (sizeof(struct sort_pair) + sizeof(uint64_t))) * sizeof(struct sort_pair);
+
+    for (uint64_t u = start; u < end; u++) {
+        for (uint64_t m = args->splits[u]; m < args->splits[u + 1]; m++) {
+            uint64_t lo = a->offsets[m];
+            uint64_t count = a->offsets[m + 1] - lo;
+            uint32_t* indices = a->indices + lo;
+            uint8_t* row = (uint8_t*)a->values + lo * size;
+
+            if (count <= SPARSE_INSERTION_SORT_MAX) {
+                for (uint64_t i = 1; i < count; i++) {
+                    uint32_t index = indices[i];
+                    uint64_t value = 0;
+                    copy_value(&value, 0, row, i, size);
+
+                    uint64_t j = i;
+                    for (; j > 0 && indices[j - 1] > index; j--) {
+                        indices[j] = indices[j - 1];
+                        copy_value(row, j, row, j - 1, size);
+                    }
+                    indices[j] = index;
+                    copy_value(row, j, &value, 0, size);
+                }
+                continue;
+            }
+
+            for (uint64_t i = 0; i < count; i++) {
+                pairs[i] = (struct sort_pair){indices[i], (uint32_t)i};
+            }
+            qsort(pairs, count, sizeof(struct sort_pair), compare_sort_pairs);
+
+            for (uint64_t i = 0; i < count; i++) {
+                copy_value(values, i, row, pairs[i].position, size);
+            }
+            for (uint64_t i = 0; i < count; i++) {
+                indices[i] = pairs[i].index;
+                copy_value(row, i, values, i, size);
+            }
+        }
+    }
+    return 0;
+}
+
+
+// sums the consecutive duplicated indices of each major in place
+static void merge_duplicates(sc_sparse_matrix* a) {
+    uint64_t size = type_size(a->type);
+    uint64_t read = 0;
+    uint64_t write = 0;
+
+    for (uint64_t m = 0; m < major_count(a); m++) {
+        uint64_t end = a->offsets[m + 1];
+        uint64_t first = write;
+        a->offsets[m] = write;
+
+        for (; read < end; read++) {
+            if (write > first && a->indices[write - 1] == a->indices[read]) {
+                store_value(a->values, write - 1, load_value(a->values, write - 1, a->type) + load_value(a->values, read, a->type), a->type);
+                continue;
+            }
+            a->indices[write] = a->indices[read];
+            copy_value(a->values, write, a->values, read, size);
+            write++;
+        }
+    }
+
+    a->offsets[major_count(a)] = write;
+    a->nnz = write;
+}
+
+
+// ################
+// creation and api
+// ################
+
+sc_sparse_vector* sc_create_sparse_vector(uint64_t size, uint64_t nnz, sc_TYPES type, ccb_arena* arena) {
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (check_type(type) != 0) {
+        return NULL;
+    }
+    if (size > SPARSE_MAX_DIM || nnz > size) {
+        CCB_ERROR("Invalid sparse vector: size %" PRIu64 ", nnz %" PRIu64, size, nnz);
+        return NULL;
+    }
+
+    sc_sparse_vector* vector = (sc_sparse_vector*)ccb_arena_malloc(arena, sizeof(sc_sparse_vector));
+    CCB_NOTNULL(vector, "Failed to allocate the sparse vector");
+    vector->values = ccb_arena_malloc(arena, nnz * type_size(type) + 1);
+    vector->indices = (uint32_t*)ccb_arena_malloc(arena, nnz * sizeof(uint32_t) + 1);
+    CCB_NOTNULL(vector->values, "Failed to allocate the sparse values");
+    CCB_NOTNULL(vector->indices, "Failed to allocate the sparse indices");
+
+    vector->nnz = nnz;
+    vector->size = size;
+    vector->type = type;
+    return vector;
+}
+
+
+sc_sparse_vector* sc_dense_to_sparse_vector(sc_vector* a, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    if (check_type(a->type) != 0) {
+        return NULL;
+    }
+
+    uint64_t nnz = 0;
+    for (uint64_t i = 0; i < a->size; i++) {
+        nnz += (load_value(a->data, i, a->type) != 0.0);
+    }
+
+    sc_sparse_vector* out = sc_create_sparse_vector(a->size, nnz, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create the sparse vector");
+
+    uint64_t size = type_size(a->type);
+    uint64_t k = 0;
+    for (uint64_t i = 0; i < a->size; i++) {
+        if (load_value(a->data, i, a->type) != 0.0) {
+            out->indices[k] = (uint32_t)i;
+            copy_value(out->values, k, a->data, i, size);
+            k++;
+        }
+    }
+    return out;
+}
+
+
+sc_vector* sc_sparse_to_dense_vector(sc_sparse_vector* a, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+
+    sc_vector* out = sc_create_vector(a->size, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create the dense vector");
+
+    uint64_t size = type_size(a->type);
+    memset(out->data, 0, a->size * size);
+    for (uint64_t k = 0; k < a->nnz; k++) {
+        copy_value(out->data, a->indices[k], a->values, k, size);
+    }
+    return out;
+}
+
+
+sc_sparse_matrix* sc_create_sparse_matrix(uint64_t rows, uint64_t cols, uint64_t nnz, sc_sparse_format format, sc_TYPES type, ccb_arena* arena) {
+    CCB_NOTNULL(arena, "arena is NULL");
+    if (check_type(type) != 0) {
+        return NULL;
+    }
+    if (rows > SPARSE_MAX_DIM || cols > SPARSE_MAX_DIM) {
+        CCB_ERROR("Invalid sparse matrix: %" PRIu64 " x %" PRIu64 ", indices are limited to %" PRIu64, rows, cols, SPARSE_MAX_DIM);
+        return NULL;
+    }
+    if (format != sc_sparse_csr && format != sc_sparse_csc) {
+        CCB_ERROR("Unsupported sparse format %d", format);
+        return NULL;
+    }
+
+    sc_sparse_matrix* matrix = (sc_sparse_matrix*)ccb_arena_malloc(arena, sizeof(sc_sparse_matrix));
+    CCB_NOTNULL(matrix, "Failed to allocate the sparse matrix");
+    matrix->rows = rows;
+    matrix->cols = cols;
+    matrix->nnz = nnz;
+    matrix->format = format;
+    matrix->type = type;
+
+    matrix->values = ccb_arena_malloc(arena, nnz * type_size(type) + 1);
+    matrix->indices = (uint32_t*)ccb_arena_malloc(arena, nnz * sizeof(uint32_t) + 1);
+    matrix->offsets = (uint64_t*)ccb_arena_malloc(arena, (major_count(matrix) + 1) * sizeof(uint64_t));
+    CCB_NOTNULL(matrix->values, "Failed to allocate the sparse values");
+    CCB_NOTNULL(matrix->indices, "Failed to allocate the sparse indices");
+    CCB_NOTNULL(matrix->offsets, "Failed to allocate the sparse offsets");
+    matrix->offsets[0] = 0;
+    return matrix;
+}
+
+
+sc_sparse_matrix* sc_sparse_matrix_from_coo(uint64_t rows, uint64_t cols, uint32_t* row_indices, uint32_t* col_indices, sc_vector* values, sc_sparse_format format, ccb_arena* arena) {
+    CCB_NOTNULL(values, "values is NULL");
+    CCB_NOTNULL(row_indices, "row_indices is NULL");
+    CCB_NOTNULL(col_indices, "col_indices is NULL");
+
+    uint64_t nnz = values->size;
+    for (uint64_t e = 0; e < nnz; e++) {
+        if (row_indices[e] >= rows || col_indices[e] >= cols) {
+            CCB_ERROR("Coordinate %" PRIu64 " (%u, %u) is out of a %" PRIu64 " x %" PRIu64 " matrix", e, row_indices[e], col_indices[e], rows, cols);
+            return NULL;
+        }
+    }
+
+    // bucket by major index (stable, sequential when the input is already sorted), then sort each major locally
+    uint32_t* major = (format == sc_sparse_csr) ? row_indices : col_indices;
+    uint32_t* minor = (format == sc_sparse_csr) ? col_indices : row_indices;
+
+    sc_sparse_matrix* out = sc_create_sparse_matrix(rows, cols, nnz, format, values->type, arena);
+    CCB_NOTNULL(out, "Failed to create the sparse matrix");
+
+    uint64_t majors = major_count(out);
+    uint64_t* next = (uint64_t*)ccb_arena_malloc(arena, (majors + 1) * sizeof(uint64_t));
+    CCB_NOTNULL(next, "Failed to allocate the counters");
+
+    memset(out->offsets, 0, (majors + 1) * sizeof(uint64_t));
+    for (uint64_t e = 0; e < nnz; e++) {
+        out->offsets[major[e] + 1]++;
+    }
+    uint64_t longest = 0;
+    for (uint64_t m = 0; m < majors; m++) {
+        longest = (out->offsets[m + 1] > longest) ? out->offsets[m + 1] : longest;
+        out->offsets[m + 1] += out->offsets[m];
+    }
+    memcpy(next, out->offsets, majors * sizeof(uint64_t));
+
+    uint64_t size = type_size(values->type);
+    for (uint64_t e = 0; e < nnz; e++) {
+        uint64_t position = next[major[e]]++;
+        out->indices[position] = minor[e];
+        copy_value(out->values, position, values->data, e, size);
+    }
+
+    uint64_t parts = part_count(majors);
+    struct sparse_args args = {0};
+    args.a = out;
+    args.splits = balance_by_nnz(out->offsets, majors, parts, arena);
+    args.scratch_stride = longest * (sizeof(struct sort_pair) + sizeof(uint64_t));
+    args.scratch = (uint8_t*)ccb_arena_malloc(arena, sc_get_engine_thread_count() * args.scratch_stride + 1);
+    CCB_NOTNULL(args.scratch, "Failed to allocate the sort scratch");
+
+    if (sc_run_range_task(sort_kernel, &args, parts, nnz, arena) != 0) {
+        CCB_ERROR("Failed to sort the coordinates");
+        return NULL;
+    }
+    merge_duplicates(out);
+    return out;
+}
+
+
+sc_sparse_matrix* sc_dense_to_sparse_matrix(sc_tensor* a, sc_sparse_format format, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    if (a->dims->dims_count != 2) {
+        CCB_ERROR("Expected a 2D tensor, got %" PRIu64 " dimensions", a->dims->dims_count);
+        return NULL;
+    }
+
+    uint64_t rows = a->dims->dims[0];
+    uint64_t cols = a->dims->dims[1];
+
+    // the counts are stored in the offsets of a CSR header, the values are allocated once they are known
+    sc_sparse_matrix* out = sc_create_sparse_matrix(rows, cols, 0, sc_sparse_csr, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create the sparse matrix");
+
+    struct sparse_args args = {0};
+    args.out = out;
+    args.x = a->data;
+
+    if (sc_run_range_task(count_kernel, &args, rows, a->size, arena) != 0) {
+        CCB_ERROR("Failed to count the nonzeros");
+        return NULL;
+    }
+    for (uint64_t r = 0; r < rows; r++) {
+        out->offsets[r + 1] += out->offsets[r];
+    }
+
+    out->nnz = out->offsets[rows];
+    out->values = ccb_arena_malloc(arena, out->nnz * type_size(a->type) + 1);
+    out->indices = (uint32_t*)ccb_arena_malloc(arena, out->nnz * sizeof(uint32_t) + 1);
+    CCB_NOTNULL(out->values, "Failed to allocate the sparse values");
+    CCB_NOTNULL(out->indices, "Failed to allocate the sparse indices");
+
+    if (sc_run_range_task(fill_kernel, &args, rows, a->size, arena) != 0) {
+        CCB_ERROR("Failed to fill the sparse matrix");
+        return NULL;
+    }
+
+    return (format == sc_sparse_csr) ? out : sc_sparse_matrix_convert(out, format, arena);
+}
+
+
+sc_tensor* sc_sparse_to_dense_matrix(sc_sparse_matrix* a, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+
+    sc_tensor* out = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){a->rows, a->cols}), a->type, arena);
+    CCB_NOTNULL(out, "Failed to create the dense tensor");
+    memset(out->data, 0, out->size * type_size(a->type));
+
+    uint64_t parts = part_count(major_count(a));
+    struct sparse_args args = {0};
+    args.a = a;
+    args.y = out->data;
+    args.splits = balance_by_nnz(a->offsets, major_count(a), parts, arena);
+
+    if (sc_run_range_task(scatter_add_kernel, &args, parts, a->nnz, arena) != 0) {
+        CCB_ERROR("Failed to scatter the sparse matrix");
+        return NULL;
+    }
+    return out;
+}
+
+
+sc_sparse_matrix* sc_sparse_matrix_convert(sc_sparse_matrix* a, sc_sparse_format format, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+
+    sc_sparse_matrix* out = sc_create_sparse_matrix(a->rows, a->cols, a->nnz, format, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create the sparse matrix");
+
+    if (format == a->format) {
+        memcpy(out->values, a->values, a->nnz * type_size(a->type));
+        memcpy(out->indices, a->indices, a->nnz * sizeof(uint32_t));
+        memcpy(out->offsets, a->offsets, (major_count(a) + 1) * sizeof(uint64_t));
+        return out;
+    }
+
+    uint64_t* next = (uint64_t*)ccb_arena_malloc(arena, (minor_count(a) + 1) * sizeof(uint64_t));
+    CCB_NOTNULL(next, "Failed to allocate the counters");
+    transpose_compressed(a, out, next);
+    return out;
+}
+
+
+sc_value_t sc_sparse_vector_dot(sc_sparse_vector* a, sc_vector* b) {
+    if (!a || !b || a->size != b->size || a->type != b->type) {
+        CCB_ERROR("Invalid sparse dot operands");
+        return to_sc_value(0.0, b ? b->type : sc_float32);
+    }
+    return to_sc_value(row_dot(a->values, a->indices, a->nnz, b->data, a->type), a->type);
+}
+
+
+sc_vector* sc_sparse_vector_add_dense(sc_sparse_vector* a, sc_vector* b, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(b, "b is NULL");
+    if (a->size != b->size || a->type != b->type) {
+        CCB_ERROR("Sparse / dense mismatch: size %" PRIu64 " vs %" PRIu64 ", type %d vs %d", a->size, b->size, a->type, b->type);
+        return NULL;
+    }
+
+    sc_vector* out = sc_create_vector(b->size, b->type, arena);
+    CCB_NOTNULL(out, "Failed to create result vector");
+
+    memcpy(out->data, b->data, b->size * type_size(b->type));
+    for (uint64_t k = 0; k < a->nnz; k++) {
+        uint64_t i = a->indices[k];
+        store_value(out->data, i, load_value(out->data, i, a->type) + load_value(a->values, k, a->type), a->type);
+    }
+    return out;
+}
+
+
+sc_sparse_vector* sc_sparse_vector_mul_dense(sc_sparse_vector* a, sc_vector* b, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(b, "b is NULL");
+    if (a->size != b->size || a->type != b->type) {
+        CCB_ERROR("Sparse / dense mismatch: size %" PRIu64 " vs %" PRIu64 ", type %d vs %d", a->size, b->size, a->type, b->type);
+        return NULL;
+    }
+
+    sc_sparse_vector* out = sc_create_sparse_vector(a->size, a->nnz, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create the sparse vector");
+
+    memcpy(out->indices, a->indices, a->nnz * sizeof(uint32_t));
+    for (uint64_t k = 0; k < a->nnz; k++) {
+        store_value(out->values, k, load_value(a->values, k, a->type) * load_value(b->data, a->indices[k], a->type), a->type);
+    }
+    return out;
+}
+
+
+sc_vector* sc_spmv(sc_sparse_matrix* a, sc_vector* x, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(x, "x is NULL");
+    if (a->cols != x->size || a->type != x->type) {
+        CCB_ERROR("SpMV mismatch: %" PRIu64 " columns vs size %" PRIu64 ", type %d vs %d", a->cols, x->size, a->type, x->type);
+        return NULL;
+    }
+
+    if (a->format == sc_sparse_csc) {
+        a = sc_sparse_matrix_convert(a, sc_sparse_csr, arena);
+        CCB_NOTNULL(a, "Failed to convert the matrix to CSR");
+    }
+
+    sc_vector* out = sc_create_vector(a->rows, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create result vector");
+
+    uint64_t parts = part_count(a->rows);
+    struct sparse_args args = {0};
+    args.a = a;
+    args.x = x->data;
+    args.y = out->data;
+    args.splits = balance_by_nnz(a->offsets, a->rows, parts, arena);
+
+    if (sc_run_range_task(spmv_kernel, &args, parts, a->nnz + a->rows, arena) != 0) {
+        CCB_ERROR("Failed to run the SpMV");
+        return NULL;
+    }
+    return out;
+}
+
+
+sc_tensor* sc_spmm(sc_sparse_matrix* a, sc_tensor* b, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(b, "b is NULL");
+    if (b->dims->dims_count != 2 || b->dims->dims[0] != a->cols || a->type != b->type) {
+        CCB_ERROR("SpMM mismatch: %" PRIu64 " columns vs a %" PRIu64 " dimensions tensor, type %d vs %d", a->cols, b->dims->dims_count, a->type, b->type);
+        return NULL;
+    }
+
+    if (a->format == sc_sparse_csc) {
+        a = sc_sparse_matrix_convert(a, sc_sparse_csr, arena);
+        CCB_NOTNULL(a, "Failed to convert the matrix to CSR");
+    }
+
+    uint64_t n = b->dims->dims[1];
+    sc_tensor* out = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){a->rows, n}), a->type, arena);
+    CCB_NOTNULL(out, "Failed to create result tensor");
+
+    uint64_t parts = part_count(a->rows);
+    struct sparse_args args = {0};
+    args.a = a;
+    args.x = b->data;
+    args.y = out->data;
+    args.n = n;
+    args.splits = balance_by_nnz(a->offsets, a->rows, parts, arena);
+
+    if (a->type == sc_float16) {
+        args.acc_stride = (n + 15) / 16 * 16;
+        args.acc = (float*)ccb_arena_malloc(arena, sc_get_engine_thread_count() * args.acc_stride * sizeof(float));
+        CCB_NOTNULL(args.acc, "Failed to allocate the accumulators");
+    }
+
+    if (sc_run_range_task(spmm_kernel, &args, parts, (a->nnz + a->rows) * n, arena) != 0) {
+        CCB_ERROR("Failed to run the SpMM");
+        return NULL;
+    }
+    return out;
+}
+
+
+sc_tensor* sc_sparse_matrix_add_dense(sc_sparse_matrix* a, sc_tensor* b, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(b, "b is NULL");
+    if (b->dims->dims_count != 2 || b->dims->dims[0] != a->rows || b->dims->dims[1] != a->cols || a->type != b->type) {
+        CCB_ERROR("Sparse / dense mismatch: %" PRIu64 " x %" PRIu64 ", type %d vs %d", a->rows, a->cols, a->type, b->type);
+        return NULL;
+    }
+
+    sc_tensor* out = sc_create_tensor(sc_create_dimensions(2, arena, (uint64_t[]){a->rows, a->cols}), a->type, arena);
+    CCB_NOTNULL(out, "Failed to create result tensor");
+    memcpy(out->data, b->data, b->size * type_size(b->type));
+
+    uint64_t parts = part_count(major_count(a));
+    struct sparse_args args = {0};
+    args.a = a;
+    args.y = out->data;
+    args.splits = balance_by_nnz(a->offsets, major_count(a), parts, arena);
+
+    if (sc_run_range_task(scatter_add_kernel, &args, parts, a->nnz, arena) != 0) {
+        CCB_ERROR("Failed to add the sparse matrix");
+        return NULL;
+    }
+    return out;
+}
+
+
+sc_sparse_matrix* sc_sparse_matrix_mul_dense(sc_sparse_matrix* a, sc_tensor* b, ccb_arena* arena) {
+    CCB_NOTNULL(a, "a is NULL");
+    CCB_NOTNULL(b, "b is NULL");
+    if (b->dims->dims_count != 2 || b->dims->dims[0] != a->rows || b->dims->dims[1] != a->cols || a->type != b->type) {
+        CCB_ERROR("Sparse / dense mismatch: %" PRIu64 " x %" PRIu64 ", type %d vs %d", a->rows, a->cols, a->type, b->type);
+        return NULL;
+    }
+
+    sc_sparse_matrix* out = sc_create_sparse_matrix(a->rows, a->cols, a->nnz, a->format, a->type, arena);
+    CCB_NOTNULL(out, "Failed to create the sparse matrix");
+    memcpy(out->indices, a->indices, a->nnz * sizeof(uint32_t));
+    memcpy(out->offsets, a->offsets, (major_count(a) + 1) * sizeof(uint64_t));
+
+    uint64_t parts = part_count(major_count(a));
+    struct sparse_args args = {0};
+    args.a = a;
+    args.out = out;
+    args.x = b->data;
+    args.splits = balance_by_nnz(a->offsets, major_count(a), parts, arena);
+
+    if (sc_run_range_task(gather_mul_kernel, &args, parts, a->nnz, arena) != 0) {
+        CCB_ERROR("Failed to multiply the sparse matrix");
+        return NULL;
+    }
+    return out;
+}
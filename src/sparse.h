@@ -0,0 +1,160 @@
+#ifndef __SPARSE_H__
+#define __SPARSE_H__
+
+#include <stdint.h>
+#include "ccbase/utils/mem.h"
+#include "data.h"
+
+/*
+    compressed sparse vectors and matrices (CSR / CSC) allocated from an arena
+    indices are 32 bits (dimensions up to INT32_MAX) so that they can feed the AVX2 gathers directly,
+    the indices of a vector, a row (CSR) or a column (CSC) are sorted and unique
+    float32 and bfloat16 values are accumulated in float32, float64 values in float64
+    matrix kernels run on the engine thread pool, rows (or columns) are split by nonzero count
+*/
+
+typedef enum {
+    sc_sparse_csr,  // compressed rows: offsets has rows + 1 entries, indices are columns
+    sc_sparse_csc,  // compressed columns: offsets has cols + 1 entries, indices are rows
+} sc_sparse_format;
+
+typedef struct {
+    void* values;
+    uint32_t* indices;
+    uint64_t nnz;
+    uint64_t size;
+    sc_TYPES type;
+} sc_sparse_vector;
+
+typedef struct {
+    void* values;
+    uint32_t* indices;
+    uint64_t* offsets;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t nnz;
+    sc_sparse_format format;
+    sc_TYPES type;
+} sc_sparse_matrix;
+
+
+// creation and conversion
+
+/* Creates an uninitialised sparse vector with room for nnz values
+   - uint64_t size: dense size of the vector
+   - uint64_t nnz: number of stored values
+   - sc_TYPES type: type of the values
+   - ccb_arena* arena: arena where the vector will be allocated
+   - return: a pointer to the sparse vector
+*/
+sc_sparse_vector* sc_create_sparse_vector(uint64_t size, uint64_t nnz, sc_TYPES type, ccb_arena* arena);
+/* Converts a dense vector to a sparse vector, the zeros are dropped
+   - sc_vector* a: dense vector
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the sparse vector
+*/
+sc_sparse_vector* sc_dense_to_sparse_vector(sc_vector* a, ccb_arena* arena);
+/* Converts a sparse vector to a dense vector
+   - sc_sparse_vector* a: sparse vector
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the dense vector
+*/
+sc_vector* sc_sparse_to_dense_vector(sc_sparse_vector* a, ccb_arena* arena);
+
+/* Creates an uninitialised sparse matrix with room for nnz values
+   - uint64_t rows, uint64_t cols: dense dimensions of the matrix
+   - uint64_t nnz: number of stored values
+   - sc_sparse_format format: CSR or CSC
+   - sc_TYPES type: type of the values
+   - ccb_arena* arena: arena where the matrix will be allocated
+   - return: a pointer to the sparse matrix
+*/
+sc_sparse_matrix* sc_create_sparse_matrix(uint64_t rows, uint64_t cols, uint64_t nnz, sc_sparse_format format, sc_TYPES type, ccb_arena* arena);
+/* Builds a sparse matrix from coordinates (COO), duplicated coordinates are summed
+   - uint64_t rows, uint64_t cols: dense dimensions of the matrix
+   - uint32_t* row_indices, uint32_t* col_indices: coordinates of the values, in any order
+   - sc_vector* values: values, one per coordinate
+   - sc_sparse_format format: CSR or CSC
+   - ccb_arena* arena: arena where the result and the scratch will be allocated
+   - return: a pointer to the sparse matrix
+*/
+sc_sparse_matrix* sc_sparse_matrix_from_coo(uint64_t rows, uint64_t cols, uint32_t* row_indices, uint32_t* col_indices, sc_vector* values, sc_sparse_format format, ccb_arena* arena);
+/* Converts a dense 2D tensor to a sparse matrix, the zeros are dropped
+   - sc_tensor* a: dense tensor [rows, cols]
+   - sc_sparse_format format: CSR or CSC
+   - ccb_arena* arena: arena where the result and the scratch will be allocated
+   - return: a pointer to the sparse matrix
+*/
+sc_sparse_matrix* sc_dense_to_sparse_matrix(sc_tensor* a, sc_sparse_format format, ccb_arena* arena);
+/* Converts a sparse matrix to a dense 2D tensor
+   - sc_sparse_matrix* a: sparse matrix
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the dense tensor [rows, cols]
+*/
+sc_tensor* sc_sparse_to_dense_matrix(sc_sparse_matrix* a, ccb_arena* arena);
+/* Converts a sparse matrix between CSR and CSC (copies the matrix when the format is the same)
+   - sc_sparse_matrix* a: sparse matrix
+   - sc_sparse_format format: format of the result
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the converted matrix
+*/
+sc_sparse_matrix* sc_sparse_matrix_convert(sc_sparse_matrix* a, sc_sparse_format format, ccb_arena* arena);
+
+
+// vector operations
+
+/* Dot product of a sparse vector and a dense vector (same type)
+   - sc_sparse_vector* a: sparse vector
+   - sc_vector* b: dense vector of the same size
+   - return: the dot product
+*/
+sc_value_t sc_sparse_vector_dot(sc_sparse_vector* a, sc_vector* b);
+/* Adds a sparse vector to a dense vector
+   - sc_sparse_vector* a: sparse vector
+   - sc_vector* b: dense vector of the same size and type
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the dense result a + b
+*/
+sc_vector* sc_sparse_vector_add_dense(sc_sparse_vector* a, sc_vector* b, ccb_arena* arena);
+/* Multiplies a sparse vector by a dense vector element wise, the result keeps the pattern of a
+   - sc_sparse_vector* a: sparse vector
+   - sc_vector* b: dense vector of the same size and type
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the sparse result a * b
+*/
+sc_sparse_vector* sc_sparse_vector_mul_dense(sc_sparse_vector* a, sc_vector* b, ccb_arena* arena);
+
+
+// matrix operations
+
+/* Sparse matrix - dense vector product (SpMV), CSC matrices are converted to CSR first
+   - sc_sparse_matrix* a: sparse matrix [rows, cols]
+   - sc_vector* x: dense vector of size cols, same type as a
+   - ccb_arena* arena: arena where the result and the scratch will be allocated
+   - return: a pointer to the dense result of size rows
+*/
+sc_vector* sc_spmv(sc_sparse_matrix* a, sc_vector* x, ccb_arena* arena);
+/* Sparse matrix - dense matrix product (SpMM), CSC matrices are converted to CSR first
+   - sc_sparse_matrix* a: sparse matrix [rows, k]
+   - sc_tensor* b: dense tensor [k, n], same type as a
+   - ccb_arena* arena: arena where the result and the scratch will be allocated
+   - return: a pointer to the dense result [rows, n]
+*/
+sc_tensor* sc_spmm(sc_sparse_matrix* a, sc_tensor* b, ccb_arena* arena);
+/* Adds a sparse matrix to a dense matrix
+   - sc_sparse_matrix* a: sparse matrix [rows, cols]
+   - sc_tensor* b: dense tensor [rows, cols], same type as a
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the dense result a + b
+*/
+sc_tensor* sc_sparse_matrix_add_dense(sc_sparse_matrix* a, sc_tensor* b, ccb_arena* arena);
+/* Multiplies a sparse matrix by a dense matrix element wise, the result keeps the pattern of a
+   - sc_sparse_matrix* a: sparse matrix [rows, cols]
+   - sc_tensor* b: dense tensor [rows, cols], same type as a
+   - ccb_arena* arena: arena where the result will be allocated
+   - return: a pointer to the sparse result a * b
+*/
+sc_sparse_matrix* sc_sparse_matrix_mul_dense(sc_sparse_matrix* a, sc_tensor* b, ccb_arena* arena);
+
+
+#endif // __SPARSE_H__